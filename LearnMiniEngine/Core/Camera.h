@@ -31,6 +31,7 @@ namespace DSM {
         float GetFarZ() const noexcept { return m_FarZ; }
         float GetFovY() const noexcept { return m_FovY; }
         float GetAspectRatio() const noexcept { return m_Aspect; }
+        bool IsReversedZ() const noexcept { return m_ReversedZ; }
 
         void SetPosition(float x, float y, float z) noexcept { m_Transform.SetPosition(x, y, z); }
         void SetPosition(Math::Vector3 position) noexcept { m_Transform.SetPosition(position); }
@@ -1,127 +1,143 @@
-﻿//***************************************************************************************
-// CpuTimer.cpp by Frank Luna (C) 2011 All Rights Reserved.
-//***************************************************************************************
-
-#include <windows.h>
 #include "CpuTimer.h"
-
-CpuTimer::CpuTimer()
-	: mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0),
-	mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
-{
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / (double)countsPerSec;
-}
-
-// Returns the total time elapsed since Reset() was called, NOT counting any
-// time when the clock is stopped.
-float CpuTimer::TotalTime()const
-{
-	// If we are stopped, do not count the time that has passed since we stopped.
-	// Moreover, if we previously already had a pause, the distance 
-	// mStopTime - mBaseTime includes paused time, which we do not want to count.
-	// To correct this, we can subtract the paused time from mStopTime:  
-	//
-	//                     |<--paused time-->|
-	// ----*---------------*-----------------*------------*------------*------> time
-	//  mBaseTime       mStopTime        startTime     mStopTime    mCurrTime
-
-	if (mStopped)
-	{
-		return (float)(((mStopTime - mPausedTime) - mBaseTime) * mSecondsPerCount);
-	}
-
-	// The distance mCurrTime - mBaseTime includes paused time,
-	// which we do not want to count.  To correct this, we can subtract 
-	// the paused time from mCurrTime:  
-	//
-	//  (mCurrTime - mPausedTime) - mBaseTime 
-	//
-	//                     |<--paused time-->|
-	// ----*---------------*-----------------*------------*------> time
-	//  mBaseTime       mStopTime        startTime     mCurrTime
-
-	else
-	{
-		return (float)(((mCurrTime - mPausedTime) - mBaseTime) * mSecondsPerCount);
-	}
-}
-
-float CpuTimer::DeltaTime()const
-{
-	return (float)mDeltaTime;
+#include <algorithm>
+#include <cmath>
+
+namespace DSM {
+    //
+    // CpuTimer Implementation
+    //
+    float CpuTimer::TotalTime() const
+    {
+        return static_cast<float>(TotalTimeInSeconds());
+    }
+
+    double CpuTimer::TotalTimeInSeconds() const
+    {
+        // 暂停时不计算暂停之后经过的时间
+        auto endTime = m_Stopped ? m_StopTime : m_CurrTime;
+        return std::chrono::duration<double>(endTime - m_PausedTime - m_BaseTime).count();
+    }
+
+    void CpuTimer::Reset()
+    {
+        auto currTime = Clock::now();
+        m_BaseTime = currTime;
+        m_PrevTime = currTime;
+        m_CurrTime = currTime;
+        m_StopTime = {};
+        m_PausedTime = {};
+        m_DeltaTime = 0;
+        m_Stopped = false;
+    }
+
+    void CpuTimer::Start()
+    {
+        if (m_Stopped) {
+            auto startTime = Clock::now();
+            // 累加暂停的时间
+            m_PausedTime += startTime - m_StopTime;
+            m_PrevTime = startTime;
+            m_StopTime = {};
+            m_Stopped = false;
+        }
+    }
+
+    void CpuTimer::Stop()
+    {
+        if (!m_Stopped) {
+            m_StopTime = Clock::now();
+            m_Stopped = true;
+        }
+    }
+
+    void CpuTimer::Tick()
+    {
+        if (m_Stopped) {
+            m_DeltaTime = 0;
+            return;
+        }
+
+        m_CurrTime = Clock::now();
+        m_DeltaTime = std::chrono::duration<double>(m_CurrTime - m_PrevTime).count();
+        m_PrevTime = m_CurrTime;
+    }
+
+
+    //
+    // FrameTimeStats Implementation
+    //
+    FrameTimeStats::FrameTimeStats(std::uint32_t windowSize)
+        :m_WindowSize((std::max)(windowSize, 1u))
+    {
+        m_Samples.reserve(m_WindowSize);
+        m_SortedSamples.reserve(m_WindowSize);
+    }
+
+    void FrameTimeStats::AddFrameTime(double frameTime)
+    {
+        if (m_Samples.size() < m_WindowSize) {
+            m_Samples.push_back(frameTime);
+        }
+        else {
+            m_Samples[m_NextSample] = frameTime;
+        }
+        m_NextSample = (m_NextSample + 1) % m_WindowSize;
+
+        UpdateStats();
+    }
+
+    void FrameTimeStats::Clear()
+    {
+        m_Samples.clear();
+        m_NextSample = 0;
+        m_Min = m_Max = m_Average = m_P95 = m_P99 = 0;
+    }
+
+    double FrameTimeStats::ComputePercentile(double percentile) const
+    {
+        if (m_Samples.empty()) return 0;
+
+        // 最近秩法
+        m_SortedSamples.assign(m_Samples.begin(), m_Samples.end());
+        auto rank = static_cast<std::size_t>(std::ceil(std::clamp(percentile, 0.0, 1.0) * m_SortedSamples.size()));
+        auto index = rank == 0 ? 0 : rank - 1;
+        std::nth_element(m_SortedSamples.begin(), m_SortedSamples.begin() + index, m_SortedSamples.end());
+        return m_SortedSamples[index];
+    }
+
+    void FrameTimeStats::UpdateStats()
+    {
+        auto [minIt, maxIt] = std::minmax_element(m_Samples.begin(), m_Samples.end());
+        m_Min = *minIt;
+        m_Max = *maxIt;
+
+        double sum = 0;
+        for (auto sample : m_Samples) {
+            sum += sample;
+        }
+        m_Average = sum / m_Samples.size();
+
+        m_P95 = ComputePercentile(0.95);
+        m_P99 = ComputePercentile(0.99);
+    }
+
+
+    //
+    // FixedTimestep Implementation
+    //
+    std::uint32_t FixedTimestep::Advance(double deltaTime) noexcept
+    {
+        m_Accumulator += (std::max)(deltaTime, 0.0);
+
+        std::uint32_t numSteps = 0;
+        while (m_Accumulator >= m_Step && numSteps < m_MaxSteps) {
+            m_Accumulator -= m_Step;
+            ++numSteps;
+        }
+        // 超出上限的时间直接丢弃
+        if (numSteps == m_MaxSteps) {
+            m_Accumulator = std::fmod(m_Accumulator, m_Step);
+        }
+        return numSteps;
+    }
 }
-
-void CpuTimer::Reset()
-{
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
-	mBaseTime = currTime;
-	mPrevTime = currTime;
-	mStopTime = 0;
-	mStopped = false;
-}
-
-void CpuTimer::Start()
-{
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
-
-
-	// Accumulate the time elapsed between stop and start pairs.
-	//
-	//                     |<-------d------->|
-	// ----*---------------*-----------------*------------> time
-	//  mBaseTime       mStopTime        startTime     
-
-	if (mStopped)
-	{
-		mPausedTime += (startTime - mStopTime);
-
-		mPrevTime = startTime;
-		mStopTime = 0;
-		mStopped = false;
-	}
-}
-
-void CpuTimer::Stop()
-{
-	if (!mStopped)
-	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
-		mStopTime = currTime;
-		mStopped = true;
-	}
-}
-
-void CpuTimer::Tick()
-{
-	if (mStopped)
-	{
-		mDeltaTime = 0.0;
-		return;
-	}
-
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-	mCurrTime = currTime;
-
-	// Time difference between this frame and the previous.
-	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
-
-	// Prepare for next frame.
-	mPrevTime = mCurrTime;
-
-	// Force nonnegative.  The DXSDK's CDXUTTimer mentions that if the 
-	// processor goes into a power save mode or we get shuffled to another
-	// processor, then mDeltaTime can be negative.
-	if (mDeltaTime < 0.0)
-	{
-		mDeltaTime = 0.0;
-	}
-}
-
@@ -1,34 +1,102 @@
-﻿//***************************************************************************************
-// GameTimer.h by Frank Luna (C) 2011 All Rights Reserved.
-//***************************************************************************************
-
+#pragma once
 #ifndef __CPUTIMER__H__
 #define __CPUTIMER__H__
 
-class CpuTimer
-{
-public:
-	CpuTimer();
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace DSM {
+    // 基于 steady_clock 的计时器，暂停期间的时间不计入总时间
+    class CpuTimer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        CpuTimer() { Reset(); }
+
+        float TotalTime() const;    // 秒
+        float DeltaTime() const { return static_cast<float>(m_DeltaTime); }
+        double TotalTimeInSeconds() const;
+        double DeltaTimeInSeconds() const noexcept { return m_DeltaTime; }
+        bool IsStopped() const noexcept { return m_Stopped; }
+
+        void Reset();   // 进入消息循环前调用
+        void Start();   // 取消暂停时调用
+        void Stop();    // 暂停时调用
+        void Tick();    // 每帧调用
+
+    private:
+        Clock::time_point m_BaseTime{};
+        Clock::time_point m_StopTime{};
+        Clock::time_point m_PrevTime{};
+        Clock::time_point m_CurrTime{};
+        Clock::duration m_PausedTime{};
+        double m_DeltaTime{};
+        bool m_Stopped = false;
+    };
+
+
+    // 最近若干帧的帧时间统计，单位为毫秒
+    class FrameTimeStats
+    {
+    public:
+        explicit FrameTimeStats(std::uint32_t windowSize = 256);
+
+        void AddFrameTime(double frameTime);
+        void Clear();
+
+        std::uint32_t GetNumSamples() const noexcept { return static_cast<std::uint32_t>(m_Samples.size()); }
+        double GetMin() const noexcept { return m_Min; }
+        double GetMax() const noexcept { return m_Max; }
+        double GetAverage() const noexcept { return m_Average; }
+        double GetP95() const noexcept { return m_P95; }
+        double GetP99() const noexcept { return m_P99; }
+        double GetFPS() const noexcept { return m_Average > 0 ? 1000.0 / m_Average : 0; }
+
+        // 计算窗口内的百分位数，percentile 位于 [0, 1]
+        double ComputePercentile(double percentile) const;
+
+    private:
+        void UpdateStats();
+
+    private:
+        std::uint32_t m_WindowSize{};
+        // 环形存储
+        std::vector<double> m_Samples{};
+        std::uint32_t m_NextSample{};
+        mutable std::vector<double> m_SortedSamples{};
+
+        double m_Min{};
+        double m_Max{};
+        double m_Average{};
+        double m_P95{};
+        double m_P99{};
+    };
 
-	float TotalTime()const; // in seconds
-	float DeltaTime()const; // in seconds
 
-	void Reset(); // Call before message loop.
-	void Start(); // Call when unpaused.
-	void Stop();  // Call when paused.
-	void Tick();  // Call every frame.
+    // 固定时间步长的累加器，用于与帧率无关的模拟
+    class FixedTimestep
+    {
+    public:
+        // maxSteps 限制单帧最多的步数，防止卡顿后追赶导致的螺旋下降
+        explicit FixedTimestep(double step = 1.0 / 60, std::uint32_t maxSteps = 8)
+            :m_Step(step), m_MaxSteps(maxSteps) {}
 
-private:
-	double mSecondsPerCount;
-	double mDeltaTime;
+        // 累加帧时间(秒)，返回本帧需要执行的步数
+        std::uint32_t Advance(double deltaTime) noexcept;
+        void Reset() noexcept { m_Accumulator = 0; }
 
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+        double GetStep() const noexcept { return m_Step; }
+        void SetStep(double step) noexcept { m_Step = step; }
+        // 剩余时间占一个步长的比例，用于插值渲染
+        double GetAlpha() const noexcept { return m_Accumulator / m_Step; }
 
-	bool mStopped;
-};
+    private:
+        double m_Step{};
+        std::uint32_t m_MaxSteps{};
+        double m_Accumulator{};
+    };
+}
 
-#endif // __CPUTIMER__H__
\ No newline at end of file
+#endif // __CPUTIMER__H__
@@ -3,10 +3,14 @@
 #include "Window.h"
 #include "../Utilities/Macros.h"
 #include "../Graphics/RenderContext.h"
+#include "Profiler.h"
 #include <iostream>
 
 namespace DSM::GameCore{
     IGameApp* g_CurrGameApp = nullptr;
+    CpuTimer g_Timer{};
+    FrameTimeStats g_FrameTimeStats{};
+    FixedTimestep g_FixedTimestep{};
     
     bool IGameApp::IsDown()
     {
@@ -17,16 +21,44 @@ namespace DSM::GameCore{
     // 初始化引擎
     void InitializeApplication(IGameApp& app, const Window& window)
     {
+        g_Profiler.SetThreadName("Main Thread");
         g_RenderContext.Create(app.RequiresRaytracingSupport(), window);
         
         app.Startup();
+
+        // 避免把初始化的耗时算入第一帧
+        g_Timer.Reset();
     }
 
     // 更新引擎
     bool UpdateApplication(IGameApp& app)
     {
-        app.Update(0);
-        app.RenderScene(g_RenderContext);
+        g_Timer.Tick();
+        auto deltaTime = g_Timer.DeltaTimeInSeconds();
+        g_FrameTimeStats.AddFrameTime(deltaTime * 1000);
+
+        g_Profiler.BeginFrame();
+        {
+            PROFILE_SCOPE("Frame");
+            {
+                PROFILE_SCOPE("WaitForFrame");
+                g_RenderContext.BeginFrame();
+            }
+            {
+                PROFILE_SCOPE("Update");
+                auto numSteps = g_FixedTimestep.Advance(deltaTime);
+                for (std::uint32_t i = 0; i < numSteps; ++i) {
+                    app.FixedUpdate(static_cast<float>(g_FixedTimestep.GetStep()));
+                }
+                app.Update(static_cast<float>(deltaTime));
+            }
+            {
+                PROFILE_SCOPE("RenderScene");
+                app.RenderScene(g_RenderContext);
+            }
+            g_RenderContext.EndFrame();
+        }
+        g_Profiler.EndFrame();
         
         return !app.IsDown();
     }
@@ -39,6 +71,21 @@ namespace DSM::GameCore{
     }
 
 
+    const CpuTimer& GetTimer() noexcept
+    {
+        return g_Timer;
+    }
+
+    const FrameTimeStats& GetFrameTimeStats() noexcept
+    {
+        return g_FrameTimeStats;
+    }
+
+    FixedTimestep& GetFixedTimestep() noexcept
+    {
+        return g_FixedTimestep;
+    }
+
     void OnResize(std::uint32_t width, std::uint32_t height)
     {
 		width = (std::max)(width, 1u);
@@ -3,6 +3,7 @@
 #define __GAMECORE_H__
 
 #include "../pch.h"
+#include "CpuTimer.h"
 
 namespace DSM {
     class RenderContext;
@@ -14,8 +15,10 @@ namespace DSM::GameCore {
     {
         // 初始化程序
         virtual void Startup() = 0;
-        // 每帧调用一次更新函数
+        // 每帧调用一次更新函数，deltaTime 为上一帧的真实耗时(秒)
         virtual void Update(float deltaTime) = 0;
+        // 以固定步长调用零次或多次，用于与帧率无关的模拟
+        virtual void FixedUpdate(float /*timeStep*/) {}
         virtual void OnResize(std::uint32_t width, std::uint32_t height){};
         // 自定义渲染场景
         virtual void RenderScene(RenderContext& renderContext) = 0;
@@ -28,6 +31,10 @@ namespace DSM::GameCore {
     };
 
     void OnResize(std::uint32_t width, std::uint32_t height);
+
+    const CpuTimer& GetTimer() noexcept;
+    const FrameTimeStats& GetFrameTimeStats() noexcept;
+    FixedTimestep& GetFixedTimestep() noexcept;
     
     int RunApplication(
         IGameApp& app,
@@ -0,0 +1,283 @@
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace DSM {
+    namespace {
+        void WriteJsonString(std::ostream& out, const std::string& str)
+        {
+            out << '"';
+            for (auto c : str) {
+                switch (c) {
+                    case '"': out << "\\\""; break;
+                    case '\\': out << "\\\\"; break;
+                    default: out << (static_cast<unsigned char>(c) < 0x20 ? ' ' : c); break;
+                }
+            }
+            out << '"';
+        }
+
+        void WriteCsvString(std::ostream& out, const std::string& str)
+        {
+            out << '"';
+            for (auto c : str) {
+                if (c == '"') out << '"';
+                out << c;
+            }
+            out << '"';
+        }
+
+        std::uint64_t MinBudget(std::uint64_t a, std::uint64_t b) noexcept
+        {
+            if (a == 0) return b;
+            if (b == 0) return a;
+            return (std::min)(a, b);
+        }
+    }
+
+    std::uint64_t MemoryTracker::RecordAllocation(MemoryCategory category, std::uint64_t size, std::string name)
+    {
+        if (size == 0) return sm_InvalidAllocation;
+
+        std::lock_guard lock{m_Mutex};
+        auto id = m_NextId++;
+        m_Allocations.emplace(id, Allocation{category, size, std::move(name)});
+
+        auto& stats = m_Stats[static_cast<std::size_t>(category)];
+        stats.m_CurrentBytes += size;
+        stats.m_PeakBytes = (std::max)(stats.m_PeakBytes, stats.m_CurrentBytes);
+        ++stats.m_NumAllocations;
+        ++stats.m_TotalAllocations;
+
+        m_TotalBytes += size;
+        m_PeakTotalBytes = (std::max)(m_PeakTotalBytes, m_TotalBytes);
+        return id;
+    }
+
+    void MemoryTracker::RecordFree(std::uint64_t allocation)
+    {
+        if (allocation == sm_InvalidAllocation) return;
+
+        std::lock_guard lock{m_Mutex};
+        auto it = m_Allocations.find(allocation);
+        if (it == m_Allocations.end()) return;
+
+        auto& stats = m_Stats[static_cast<std::size_t>(it->second.m_Category)];
+        stats.m_CurrentBytes -= it->second.m_Size;
+        --stats.m_NumAllocations;
+        m_TotalBytes -= it->second.m_Size;
+        m_Allocations.erase(it);
+    }
+
+    MemoryCategoryStats MemoryTracker::GetCategoryStats(MemoryCategory category) const
+    {
+        std::lock_guard lock{m_Mutex};
+        return m_Stats[static_cast<std::size_t>(category)];
+    }
+
+    std::uint64_t MemoryTracker::GetTotalBytes() const
+    {
+        std::lock_guard lock{m_Mutex};
+        return m_TotalBytes;
+    }
+
+    std::uint64_t MemoryTracker::GetPeakTotalBytes() const
+    {
+        std::lock_guard lock{m_Mutex};
+        return m_PeakTotalBytes;
+    }
+
+    std::vector<MemoryAllocationInfo> MemoryTracker::GetAllocations() const
+    {
+        std::vector<MemoryAllocationInfo> allocations{};
+        {
+            std::lock_guard lock{m_Mutex};
+            allocations.reserve(m_Allocations.size());
+            for (const auto& [id, allocation] : m_Allocations) {
+                allocations.push_back({id, allocation.m_Category, allocation.m_Size, allocation.m_Name});
+            }
+        }
+        std::sort(allocations.begin(), allocations.end(), [](const auto& a, const auto& b) {
+            return a.m_Size != b.m_Size ? a.m_Size > b.m_Size : a.m_Id < b.m_Id;
+        });
+        return allocations;
+    }
+
+    void MemoryTracker::SetBudget(std::uint64_t budget)
+    {
+        std::lock_guard lock{m_Mutex};
+        m_Budget = budget;
+    }
+
+    void MemoryTracker::SetDeviceBudget(std::uint64_t budget)
+    {
+        std::lock_guard lock{m_Mutex};
+        m_DeviceBudget = budget;
+    }
+
+    void MemoryTracker::SetCategoryBudget(MemoryCategory category, std::uint64_t budget)
+    {
+        std::lock_guard lock{m_Mutex};
+        m_CategoryBudgets[static_cast<std::size_t>(category)] = budget;
+    }
+
+    std::uint64_t MemoryTracker::GetBudget() const
+    {
+        std::lock_guard lock{m_Mutex};
+        return MinBudget(m_Budget, m_DeviceBudget);
+    }
+
+    std::uint64_t MemoryTracker::GetCategoryBudget(MemoryCategory category) const
+    {
+        std::lock_guard lock{m_Mutex};
+        return m_CategoryBudgets[static_cast<std::size_t>(category)];
+    }
+
+    void MemoryTracker::SetWarningRatio(float ratio)
+    {
+        std::lock_guard lock{m_Mutex};
+        m_WarningRatio = std::clamp(ratio, 0.0f, 1.0f);
+    }
+
+    std::uint32_t MemoryTracker::AddPressureCallback(PressureCallback callback)
+    {
+        std::lock_guard lock{m_CallbackMutex};
+        auto handle = m_NextCallback++;
+        m_Callbacks.emplace_back(handle, std::move(callback));
+        return handle;
+    }
+
+    void MemoryTracker::RemovePressureCallback(std::uint32_t handle)
+    {
+        std::lock_guard lock{m_CallbackMutex};
+        std::erase_if(m_Callbacks, [handle](const auto& callback) { return callback.first == handle; });
+    }
+
+    MemoryBudgetStatus MemoryTracker::Update()
+    {
+        std::vector<MemoryBudgetStatus> notifications{};
+        MemoryBudgetStatus totalStatus{};
+        {
+            std::lock_guard lock{m_Mutex};
+            for (std::size_t i = 0; i <= sm_NumCategories; ++i) {
+                MemoryBudgetStatus status{};
+                if (i == sm_NumCategories) {
+                    status = EvaluateBudget(m_TotalBytes, MinBudget(m_Budget, m_DeviceBudget), m_WarningRatio);
+                    totalStatus = status;
+                }
+                else if (m_CategoryBudgets[i] != 0) {
+                    status = EvaluateBudget(m_Stats[i].m_CurrentBytes, m_CategoryBudgets[i], m_WarningRatio);
+                }
+                status.m_Category = static_cast<MemoryCategory>(i);
+
+                // 压力解除时也通知一次，便于恢复之前的限制
+                if (status.m_Pressure != MemoryPressure::kNone || m_LastPressure[i] != MemoryPressure::kNone) {
+                    notifications.push_back(status);
+                }
+                m_LastPressure[i] = status.m_Pressure;
+            }
+            m_LastStatus = totalStatus;
+        }
+
+        // 回调中可能释放资源或注册回调，调用时不持有锁
+        if (!notifications.empty()) {
+            std::vector<std::pair<std::uint32_t, PressureCallback>> callbacks{};
+            {
+                std::lock_guard lock{m_CallbackMutex};
+                callbacks = m_Callbacks;
+            }
+            for (const auto& status : notifications) {
+                for (const auto& [handle, callback] : callbacks) {
+                    callback(status);
+                }
+            }
+        }
+        return totalStatus;
+    }
+
+    void MemoryTracker::ExportJson(std::ostream& out) const
+    {
+        auto allocations = GetAllocations();
+
+        std::lock_guard lock{m_Mutex};
+        out << "{\"totalBytes\":" << m_TotalBytes
+            << ",\"peakTotalBytes\":" << m_PeakTotalBytes
+            << ",\"budget\":" << MinBudget(m_Budget, m_DeviceBudget)
+            << ",\"categories\":[";
+        for (std::size_t i = 0; i < sm_NumCategories; ++i) {
+            const auto& stats = m_Stats[i];
+            out << (i == 0 ? "" : ",") << "{\"name\":\"" << GetCategoryName(static_cast<MemoryCategory>(i))
+                << "\",\"currentBytes\":" << stats.m_CurrentBytes
+                << ",\"peakBytes\":" << stats.m_PeakBytes
+                << ",\"numAllocations\":" << stats.m_NumAllocations
+                << ",\"totalAllocations\":" << stats.m_TotalAllocations
+                << ",\"budget\":" << m_CategoryBudgets[i] << "}";
+        }
+        out << "],\"allocations\":[";
+        for (std::size_t i = 0; i < allocations.size(); ++i) {
+            const auto& allocation = allocations[i];
+            out << (i == 0 ? "" : ",") << "{\"name\":";
+            WriteJsonString(out, allocation.m_Name);
+            out << ",\"category\":\"" << GetCategoryName(allocation.m_Category)
+                << "\",\"size\":" << allocation.m_Size << "}";
+        }
+        out << "]}\n";
+    }
+
+    void MemoryTracker::ExportCsv(std::ostream& out) const
+    {
+        out << "Name,Category,Size\n";
+        for (const auto& allocation : GetAllocations()) {
+            WriteCsvString(out, allocation.m_Name);
+            out << ',' << GetCategoryName(allocation.m_Category) << ',' << allocation.m_Size << '\n';
+        }
+    }
+
+    bool MemoryTracker::SaveReport(const std::string& filename) const
+    {
+        std::ofstream file{filename, std::ios::binary};
+        if (!file) return false;
+
+        if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0) {
+            ExportCsv(file);
+        }
+        else {
+            ExportJson(file);
+        }
+        return file.good();
+    }
+
+    const char* MemoryTracker::GetCategoryName(MemoryCategory category) noexcept
+    {
+        switch (category) {
+            case MemoryCategory::kTexture: return "Texture";
+            case MemoryCategory::kRenderTarget: return "RenderTarget";
+            case MemoryCategory::kBuffer: return "Buffer";
+            case MemoryCategory::kMesh: return "Mesh";
+            case MemoryCategory::kUploadPage: return "UploadPage";
+            case MemoryCategory::kDescriptor: return "Descriptor";
+            case MemoryCategory::kRayTracing: return "RayTracing";
+            case MemoryCategory::kOther: return "Other";
+            default: return "Total";
+        }
+    }
+
+    MemoryBudgetStatus MemoryTracker::EvaluateBudget(std::uint64_t usedBytes, std::uint64_t budget, float warningRatio) noexcept
+    {
+        MemoryBudgetStatus status{};
+        status.m_UsedBytes = usedBytes;
+        status.m_Budget = budget;
+        if (budget == 0) return status;
+
+        auto warningBytes = static_cast<std::uint64_t>(std::llround(static_cast<double>(budget) * warningRatio));
+        if (usedBytes > budget) {
+            status.m_Pressure = MemoryPressure::kCritical;
+        }
+        else if (usedBytes > warningBytes) {
+            status.m_Pressure = MemoryPressure::kWarning;
+        }
+        status.m_ExcessBytes = usedBytes > warningBytes ? usedBytes - warningBytes : 0;
+        return status;
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+#ifndef __MEMORYTRACKER_H__
+#define __MEMORYTRACKER_H__
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../Utilities/Singleton.h"
+
+namespace DSM {
+    enum class MemoryCategory : std::uint8_t
+    {
+        kTexture,
+        kRenderTarget,
+        kBuffer,
+        kMesh,
+        // 上传堆与动态分配器的页
+        kUploadPage,
+        kDescriptor,
+        // 加速结构与其构建用的暂存空间
+        kRayTracing,
+        kOther,
+        kNumCategories
+    };
+
+    enum class MemoryPressure : std::uint8_t
+    {
+        kNone,
+        // 超过预算的警告线
+        kWarning,
+        // 超过预算
+        kCritical
+    };
+
+    struct MemoryCategoryStats
+    {
+        std::uint64_t m_CurrentBytes = 0;
+        std::uint64_t m_PeakBytes = 0;
+        // 当前存活的分配数
+        std::uint32_t m_NumAllocations = 0;
+        std::uint64_t m_TotalAllocations = 0;
+    };
+
+    struct MemoryAllocationInfo
+    {
+        std::uint64_t m_Id{};
+        MemoryCategory m_Category = MemoryCategory::kOther;
+        std::uint64_t m_Size{};
+        std::string m_Name{};
+    };
+
+    struct MemoryBudgetStatus
+    {
+        // kNumCategories 表示所有类别的总和
+        MemoryCategory m_Category = MemoryCategory::kNumCategories;
+        MemoryPressure m_Pressure = MemoryPressure::kNone;
+        std::uint64_t m_UsedBytes = 0;
+        std::uint64_t m_Budget = 0;
+        // 需要释放多少字节才能回到警告线以下
+        std::uint64_t m_ExcessBytes = 0;
+    };
+
+    // 记录所有显存分配，不访问设备，由分配者在创建与释放时调用
+    class MemoryTracker : public Singleton<MemoryTracker>
+    {
+        friend class Singleton<MemoryTracker>;
+    public:
+        using PressureCallback = std::function<void(const MemoryBudgetStatus&)>;
+
+        inline static constexpr std::uint64_t sm_InvalidAllocation = 0;
+
+        // 返回的 id 用于释放，size 为 0 时不记录
+        std::uint64_t RecordAllocation(MemoryCategory category, std::uint64_t size, std::string name = {});
+        void RecordFree(std::uint64_t allocation);
+
+        MemoryCategoryStats GetCategoryStats(MemoryCategory category) const;
+        std::uint64_t GetTotalBytes() const;
+        std::uint64_t GetPeakTotalBytes() const;
+        // 按大小降序排列
+        std::vector<MemoryAllocationInfo> GetAllocations() const;
+
+        // 为 0 时不限制，生效的预算取设置的预算与设备报告的预算中较小的一个
+        void SetBudget(std::uint64_t budget);
+        void SetDeviceBudget(std::uint64_t budget);
+        void SetCategoryBudget(MemoryCategory category, std::uint64_t budget);
+        std::uint64_t GetBudget() const;
+        std::uint64_t GetCategoryBudget(MemoryCategory category) const;
+        // 使用量超过预算的该比例时进入警告
+        void SetWarningRatio(float ratio);
+
+        // 回调中可以释放或分配内存
+        std::uint32_t AddPressureCallback(PressureCallback callback);
+        void RemovePressureCallback(std::uint32_t handle);
+        // 每帧调用一次，压力变化或仍处于压力下时调用回调，返回总预算的状态
+        MemoryBudgetStatus Update();
+        const MemoryBudgetStatus& GetLastStatus() const noexcept { return m_LastStatus; }
+
+        // 各类别的统计与所有分配
+        void ExportJson(std::ostream& out) const;
+        void ExportCsv(std::ostream& out) const;
+        bool SaveReport(const std::string& filename) const;
+
+        static const char* GetCategoryName(MemoryCategory category) noexcept;
+        static MemoryBudgetStatus EvaluateBudget(std::uint64_t usedBytes, std::uint64_t budget, float warningRatio) noexcept;
+
+    protected:
+        MemoryTracker() = default;
+        virtual ~MemoryTracker() = default;
+
+    private:
+        static constexpr std::size_t sm_NumCategories = static_cast<std::size_t>(MemoryCategory::kNumCategories);
+
+        struct Allocation
+        {
+            MemoryCategory m_Category{};
+            std::uint64_t m_Size{};
+            std::string m_Name{};
+        };
+
+    private:
+        mutable std::mutex m_Mutex{};
+        std::unordered_map<std::uint64_t, Allocation> m_Allocations{};
+        std::uint64_t m_NextId = 1;
+        std::array<MemoryCategoryStats, sm_NumCategories> m_Stats{};
+        std::uint64_t m_TotalBytes = 0;
+        std::uint64_t m_PeakTotalBytes = 0;
+
+        std::uint64_t m_Budget = 0;
+        std::uint64_t m_DeviceBudget = 0;
+        std::array<std::uint64_t, sm_NumCategories> m_CategoryBudgets{};
+        float m_WarningRatio = 0.9f;
+
+        std::mutex m_CallbackMutex{};
+        std::vector<std::pair<std::uint32_t, PressureCallback>> m_Callbacks{};
+        std::uint32_t m_NextCallback = 0;
+        // 上一次 Update 时各类别与总和的压力
+        std::array<MemoryPressure, sm_NumCategories + 1> m_LastPressure{};
+        MemoryBudgetStatus m_LastStatus{};
+    };
+
+#define g_MemoryTracker (MemoryTracker::GetInstance())
+}
+
+#endif
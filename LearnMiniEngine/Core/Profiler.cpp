@@ -0,0 +1,309 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace DSM {
+    namespace {
+        thread_local ProfileEventBuffer* t_EventBuffer = nullptr;
+        thread_local std::uint32_t t_Depth = 0;
+
+        void WriteJsonString(std::ostream& out, const char* str)
+        {
+            out << '"';
+            for (; str != nullptr && *str != '\0'; ++str) {
+                switch (*str) {
+                    case '"': out << "\\\""; break;
+                    case '\\': out << "\\\\"; break;
+                    case '\n': out << "\\n"; break;
+                    case '\t': out << "\\t"; break;
+                    default: {
+                        if (static_cast<unsigned char>(*str) < 0x20) {
+                            out << ' ';
+                        }
+                        else {
+                            out << *str;
+                        }
+                    }
+                }
+            }
+            out << '"';
+        }
+    }
+
+    //
+    // ProfileEventBuffer Implementation
+    //
+    ProfileEventBuffer::ProfileEventBuffer(std::uint32_t threadIndex, std::uint32_t capacity)
+        :m_ThreadIndex(threadIndex)
+    {
+        // 容量需为 2 的幂以便用掩码取模
+        std::uint64_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_Events.resize(size);
+        m_Mask = size - 1;
+    }
+
+    bool ProfileEventBuffer::Push(const ProfileEvent& event) noexcept
+    {
+        auto writeIndex = m_WriteIndex.load(std::memory_order_relaxed);
+        auto readIndex = m_ReadIndex.load(std::memory_order_acquire);
+        if (writeIndex - readIndex >= m_Events.size()) {
+            m_NumDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_Events[writeIndex & m_Mask] = event;
+        m_WriteIndex.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    //
+    // Profiler Implementation
+    //
+    void Profiler::SetThreadName(const std::string& name)
+    {
+        auto& buffer = GetThreadBuffer();
+        std::lock_guard lock{m_BufferMutex};
+        buffer.SetThreadName(name);
+    }
+
+    std::string Profiler::GetThreadName(std::uint32_t threadIndex) const
+    {
+        std::lock_guard lock{m_BufferMutex};
+        if (threadIndex < m_Buffers.size() && !m_Buffers[threadIndex]->GetThreadName().empty()) {
+            return m_Buffers[threadIndex]->GetThreadName();
+        }
+        return "Thread " + std::to_string(threadIndex);
+    }
+
+    std::uint32_t Profiler::RegisterTimeline(const std::string& name)
+    {
+        std::lock_guard lock{m_BufferMutex};
+        auto timelineIndex = static_cast<std::uint32_t>(m_Buffers.size());
+        auto& buffer = m_Buffers.emplace_back(std::make_shared<ProfileEventBuffer>(timelineIndex, sm_EventBufferCapacity));
+        buffer->SetThreadName(name);
+        return timelineIndex;
+    }
+
+    void Profiler::RecordTimelineEvent(std::uint32_t timelineIndex, const ProfileEvent& event) noexcept
+    {
+        ProfileEventBuffer* buffer{};
+        {
+            std::lock_guard lock{m_BufferMutex};
+            if (timelineIndex >= m_Buffers.size()) return;
+            buffer = m_Buffers[timelineIndex].get();
+        }
+        auto timelineEvent = event;
+        timelineEvent.m_ThreadIndex = timelineIndex;
+        buffer->Push(timelineEvent);
+    }
+
+    void Profiler::BeginFrame()
+    {
+        m_FrameBeginTime = GetTimestamp();
+    }
+
+    void Profiler::EndFrame()
+    {
+        auto frameEndTime = GetTimestamp();
+
+        m_FrameEvents.clear();
+        DrainEvents(m_FrameEvents);
+
+        if (m_Capturing) {
+            m_CapturedEvents.insert(m_CapturedEvents.end(), m_FrameEvents.begin(), m_FrameEvents.end());
+        }
+
+        BuildFrameTree(m_FrameEvents, m_LastFrame);
+        m_LastFrame.m_FrameIndex = m_FrameIndex++;
+        m_LastFrame.m_FrameTime = (frameEndTime - m_FrameBeginTime) * 1e-6;
+    }
+
+    void Profiler::BeginCapture()
+    {
+        // 丢弃捕获前残留的事件
+        std::vector<ProfileEvent> staleEvents{};
+        DrainEvents(staleEvents);
+
+        m_CapturedEvents.clear();
+        m_Capturing = true;
+    }
+
+    void Profiler::EndCapture()
+    {
+        DrainEvents(m_CapturedEvents);
+        m_Capturing = false;
+    }
+
+    void Profiler::ExportChromeTrace(std::ostream& out) const
+    {
+        out << "{\"traceEvents\":[";
+
+        bool first = true;
+        std::uint32_t numThreads{};
+        {
+            std::lock_guard lock{m_BufferMutex};
+            numThreads = static_cast<std::uint32_t>(m_Buffers.size());
+        }
+        for (std::uint32_t i = 0; i < numThreads; ++i) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+            WriteJsonString(out, GetThreadName(i).c_str());
+            out << "}}";
+        }
+
+        // 时间单位为微秒
+        auto flags = out.flags();
+        auto precision = out.precision();
+        out.setf(std::ios::fixed);
+        out.precision(3);
+        for (const auto& event : m_CapturedEvents) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":";
+            WriteJsonString(out, event.m_Name);
+            out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.m_ThreadIndex
+                << ",\"ts\":" << event.m_BeginTime * 1e-3
+                << ",\"dur\":" << (event.m_EndTime - event.m_BeginTime) * 1e-3 << "}";
+        }
+        out.flags(flags);
+        out.precision(precision);
+
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    bool Profiler::SaveChromeTrace(const std::string& filename) const
+    {
+        std::ofstream file{filename, std::ios::out | std::ios::trunc};
+        if (!file.is_open()) {
+            return false;
+        }
+        ExportChromeTrace(file);
+        return file.good();
+    }
+
+    std::uint64_t Profiler::GetNumDroppedEvents() const
+    {
+        std::lock_guard lock{m_BufferMutex};
+        std::uint64_t numDropped = 0;
+        for (const auto& buffer : m_Buffers) {
+            numDropped += buffer->GetNumDropped();
+        }
+        return numDropped;
+    }
+
+    std::uint64_t Profiler::GetTimestamp() noexcept
+    {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void Profiler::RecordEvent(const char* name, std::uint64_t beginTime, std::uint64_t endTime, std::uint32_t depth) noexcept
+    {
+        auto& buffer = GetThreadBuffer();
+
+        ProfileEvent event{};
+        event.m_Name = name;
+        event.m_BeginTime = beginTime;
+        event.m_EndTime = endTime;
+        event.m_ThreadIndex = buffer.GetThreadIndex();
+        event.m_Depth = depth;
+        buffer.Push(event);
+    }
+
+    void Profiler::BuildFrameTree(std::vector<ProfileEvent> events, ProfileFrame& frame)
+    {
+        frame.m_Nodes.clear();
+        frame.m_Nodes.emplace_back();
+
+        // 事件按结束顺序提交，重新按开始时间排序使父节点先于子节点
+        std::sort(events.begin(), events.end(), [](const ProfileEvent& lhs, const ProfileEvent& rhs) {
+            if (lhs.m_ThreadIndex != rhs.m_ThreadIndex) return lhs.m_ThreadIndex < rhs.m_ThreadIndex;
+            if (lhs.m_BeginTime != rhs.m_BeginTime) return lhs.m_BeginTime < rhs.m_BeginTime;
+            return lhs.m_Depth < rhs.m_Depth;
+        });
+
+        auto findOrAddChild = [&frame](std::uint32_t parent, const char* name, std::uint32_t threadIndex) {
+            for (auto child : frame.m_Nodes[parent].m_Children) {
+                const auto& node = frame.m_Nodes[child];
+                bool sameName = name == nullptr ?
+                    node.m_Name == nullptr && node.m_ThreadIndex == threadIndex :
+                    node.m_Name != nullptr && (node.m_Name == name || std::strcmp(node.m_Name, name) == 0);
+                if (sameName) {
+                    return child;
+                }
+            }
+            auto index = static_cast<std::uint32_t>(frame.m_Nodes.size());
+            auto& node = frame.m_Nodes.emplace_back();
+            node.m_Name = name;
+            node.m_ThreadIndex = threadIndex;
+            node.m_Parent = parent;
+            frame.m_Nodes[parent].m_Children.push_back(index);
+            return index;
+        };
+
+        // 栈中保存节点索引及其深度
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack{};
+        std::uint32_t threadNode = 0;
+        std::uint32_t currThread = ~0u;
+        for (const auto& event : events) {
+            if (event.m_ThreadIndex != currThread) {
+                currThread = event.m_ThreadIndex;
+                threadNode = findOrAddChild(0, nullptr, currThread);
+                stack.clear();
+            }
+
+            while (!stack.empty() && stack.back().second >= event.m_Depth) {
+                stack.pop_back();
+            }
+            auto parent = stack.empty() ? threadNode : stack.back().first;
+            auto nodeIndex = findOrAddChild(parent, event.m_Name, currThread);
+
+            auto time = (event.m_EndTime - event.m_BeginTime) * 1e-6;
+            auto& node = frame.m_Nodes[nodeIndex];
+            node.m_TotalTime += time;
+            node.m_MaxTime = (std::max)(node.m_MaxTime, time);
+            ++node.m_CallCount;
+
+            // 线程节点的时间为其顶层区间之和
+            if (stack.empty()) {
+                frame.m_Nodes[threadNode].m_TotalTime += time;
+            }
+            stack.emplace_back(nodeIndex, event.m_Depth);
+        }
+    }
+
+    std::uint32_t& Profiler::GetThreadDepth() noexcept
+    {
+        return t_Depth;
+    }
+
+    ProfileEventBuffer& Profiler::GetThreadBuffer()
+    {
+        if (t_EventBuffer == nullptr) {
+            std::lock_guard lock{m_BufferMutex};
+            auto threadIndex = static_cast<std::uint32_t>(m_Buffers.size());
+            // 缓冲区由分析器持有，线程退出后仍可收集其事件
+            m_Buffers.push_back(std::make_shared<ProfileEventBuffer>(threadIndex, sm_EventBufferCapacity));
+            t_EventBuffer = m_Buffers.back().get();
+        }
+        return *t_EventBuffer;
+    }
+
+    void Profiler::DrainEvents(std::vector<ProfileEvent>& events)
+    {
+        std::vector<std::shared_ptr<ProfileEventBuffer>> buffers{};
+        {
+            std::lock_guard lock{m_BufferMutex};
+            buffers = m_Buffers;
+        }
+        for (auto& buffer : buffers) {
+            buffer->Drain([&events](const ProfileEvent& event) { events.push_back(event); });
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#pragma once
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../Utilities/Singleton.h"
+
+// 定义 DSM_DISABLE_PROFILER 后所有的标记都不会产生代码
+#ifndef DSM_DISABLE_PROFILER
+#define DSM_PROFILER_CONCAT_IMPL(a, b) a##b
+#define DSM_PROFILER_CONCAT(a, b) DSM_PROFILER_CONCAT_IMPL(a, b)
+// name 需为字符串字面量或生命周期足够长的字符串
+#define PROFILE_SCOPE(name) DSM::ProfileScope DSM_PROFILER_CONCAT(_ProfileScope, __LINE__){name}
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
+
+namespace DSM {
+    // 一个已完成的计时区间，时间为相对于分析器启动的纳秒
+    struct ProfileEvent
+    {
+        const char* m_Name{};
+        std::uint64_t m_BeginTime{};
+        std::uint64_t m_EndTime{};
+        std::uint32_t m_ThreadIndex{};
+        std::uint32_t m_Depth{};
+    };
+
+    // 单生产者单消费者的无锁环形缓冲区，生产者为记录事件的线程，消费者为调用 EndFrame 的线程
+    class ProfileEventBuffer
+    {
+    public:
+        ProfileEventBuffer(std::uint32_t threadIndex, std::uint32_t capacity);
+
+        bool Push(const ProfileEvent& event) noexcept;
+        // 取出所有已提交的事件
+        template <typename Func>
+        void Drain(Func&& func)
+        {
+            auto readIndex = m_ReadIndex.load(std::memory_order_relaxed);
+            auto writeIndex = m_WriteIndex.load(std::memory_order_acquire);
+            for (; readIndex != writeIndex; ++readIndex) {
+                func(m_Events[readIndex & m_Mask]);
+            }
+            m_ReadIndex.store(readIndex, std::memory_order_release);
+        }
+
+        std::uint32_t GetThreadIndex() const noexcept { return m_ThreadIndex; }
+        std::uint64_t GetNumDropped() const noexcept { return m_NumDropped.load(std::memory_order_relaxed); }
+
+        const std::string& GetThreadName() const noexcept { return m_ThreadName; }
+        void SetThreadName(std::string name) { m_ThreadName = std::move(name); }
+
+    private:
+        std::vector<ProfileEvent> m_Events{};
+        std::uint64_t m_Mask{};
+        std::atomic<std::uint64_t> m_WriteIndex{};
+        std::atomic<std::uint64_t> m_ReadIndex{};
+        std::atomic<std::uint64_t> m_NumDropped{};
+        std::uint32_t m_ThreadIndex{};
+        std::string m_ThreadName{};
+    };
+
+    // 每帧聚合后的层级节点，同一父节点下同名的区间会被合并，线程节点的名字为空
+    struct ProfileNode
+    {
+        const char* m_Name{};
+        double m_TotalTime{};       // 毫秒
+        double m_MaxTime{};
+        std::uint32_t m_CallCount{};
+        std::uint32_t m_ThreadIndex{};
+        std::uint32_t m_Parent{};
+        std::vector<std::uint32_t> m_Children{};
+    };
+
+    // 单帧的层级树，0 号节点为根，其子节点为各个线程
+    struct ProfileFrame
+    {
+        std::uint64_t m_FrameIndex{};
+        double m_FrameTime{};
+        std::vector<ProfileNode> m_Nodes{};
+
+        const ProfileNode& GetRoot() const noexcept { return m_Nodes[0]; }
+    };
+
+    class Profiler : public Singleton<Profiler>
+    {
+        friend class Singleton<Profiler>;
+    public:
+        inline static constexpr std::uint32_t sm_EventBufferCapacity = 1 << 14;
+
+        void SetEnabled(bool enabled) noexcept { m_Enabled.store(enabled, std::memory_order_relaxed); }
+        bool IsEnabled() const noexcept { return m_Enabled.load(std::memory_order_relaxed); }
+
+        // 当前线程的名字，在 Trace 与层级树中显示
+        void SetThreadName(const std::string& name);
+        std::string GetThreadName(std::uint32_t threadIndex) const;
+        // 注册一条不属于任何线程的时间线(如 GPU)，只允许一个线程向其写入
+        std::uint32_t RegisterTimeline(const std::string& name);
+        void RecordTimelineEvent(std::uint32_t timelineIndex, const ProfileEvent& event) noexcept;
+
+        void BeginFrame();
+        // 收集所有线程的事件并构建该帧的层级树
+        void EndFrame();
+        const ProfileFrame& GetLastFrame() const noexcept { return m_LastFrame; }
+
+        // 捕获期间的所有事件会被保留用于导出
+        void BeginCapture();
+        void EndCapture();
+        bool IsCapturing() const noexcept { return m_Capturing; }
+        const std::vector<ProfileEvent>& GetCapturedEvents() const noexcept { return m_CapturedEvents; }
+        // 导出为 Chrome 的 trace_event 格式，可在 chrome://tracing 或 Perfetto 中查看
+        void ExportChromeTrace(std::ostream& out) const;
+        bool SaveChromeTrace(const std::string& filename) const;
+
+        std::uint64_t GetNumDroppedEvents() const;
+
+        // 相对于分析器启动的纳秒数
+        static std::uint64_t GetTimestamp() noexcept;
+        void RecordEvent(const char* name, std::uint64_t beginTime, std::uint64_t endTime, std::uint32_t depth) noexcept;
+
+        // 由多组事件构建层级树，每个线程的事件需来自 ProfileScope 的嵌套
+        static void BuildFrameTree(std::vector<ProfileEvent> events, ProfileFrame& frame);
+
+        static std::uint32_t& GetThreadDepth() noexcept;
+
+    protected:
+        Profiler() = default;
+        virtual ~Profiler() = default;
+
+    private:
+        ProfileEventBuffer& GetThreadBuffer();
+        void DrainEvents(std::vector<ProfileEvent>& events);
+
+    private:
+        std::atomic<bool> m_Enabled{true};
+
+        mutable std::mutex m_BufferMutex{};
+        std::vector<std::shared_ptr<ProfileEventBuffer>> m_Buffers{};
+
+        std::uint64_t m_FrameIndex{};
+        std::uint64_t m_FrameBeginTime{};
+        std::vector<ProfileEvent> m_FrameEvents{};
+        ProfileFrame m_LastFrame{};
+
+        bool m_Capturing = false;
+        std::vector<ProfileEvent> m_CapturedEvents{};
+    };
+
+    // 作用域计时，析构时提交事件
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const char* name) noexcept
+        {
+            auto& profiler = Profiler::GetInstance();
+            if (profiler.IsEnabled()) {
+                m_Name = name;
+                m_Depth = Profiler::GetThreadDepth()++;
+                m_BeginTime = Profiler::GetTimestamp();
+            }
+        }
+        ~ProfileScope()
+        {
+            if (m_Name != nullptr) {
+                auto endTime = Profiler::GetTimestamp();
+                --Profiler::GetThreadDepth();
+                Profiler::GetInstance().RecordEvent(m_Name, m_BeginTime, endTime, m_Depth);
+            }
+        }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        const char* m_Name{};
+        std::uint64_t m_BeginTime{};
+        std::uint32_t m_Depth{};
+    };
+
+#define g_Profiler (Profiler::GetInstance())
+}
+
+#endif
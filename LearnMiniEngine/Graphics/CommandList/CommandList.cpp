@@ -2,8 +2,17 @@
 #include "../DynamicDescriptorHeap.h"
 #include "../RenderContext.h"
 #include "../PipelineState.h"
+#include "../../Utilities/DDSFile.h"
 
 namespace DSM {
+    namespace {
+        constexpr std::uint32_t kComputeQueueStates =
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+            D3D12_RESOURCE_STATE_COPY_DEST |
+            D3D12_RESOURCE_STATE_COPY_SOURCE;
+    }
+
     CommandList::CommandList(const std::wstring& id, D3D12_COMMAND_LIST_TYPE type)
         :m_CmdListType(type){
         auto listName = id + L" CommandList";
@@ -11,6 +20,9 @@ namespace DSM {
         m_CmdList->SetName(listName.c_str());
         m_CmdList->QueryInterface(IID_PPV_ARGS(m_CmdList4.GetAddressOf()));
         m_ResourceBarriers.reserve(16);
+        if (m_CmdListType == D3D12_COMMAND_LIST_TYPE_COMPUTE) {
+            m_StateTracker.SetAllowedStates(kComputeQueueStates);
+        }
         
         m_ViewDescriptorHeap = DynamicDescriptorHeap::AllocateDynamicDescriptorHeap(this, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
         m_SampleDescriptorHeap = DynamicDescriptorHeap::AllocateDynamicDescriptorHeap(this, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
@@ -46,10 +58,42 @@ namespace DSM {
 
     void CommandList::FlushResourceBarriers()
     {
-        if (!m_ResourceBarriers.empty()) {
-            m_CmdList->ResourceBarrier(m_ResourceBarriers.size(), m_ResourceBarriers.data());
+        if (m_StateTracker.Empty()) return;
+
+        auto barriers = m_StateTracker.GetBarriers();
+#if defined(DEBUG) || defined(_DEBUG)
+        std::string error{};
+        ASSERT(ResourceStateTracker::Validate(barriers, &error), "{}", error);
+#endif
+
+        m_ResourceBarriers.resize(barriers.size());
+        for (std::size_t i = 0; i < barriers.size(); ++i) {
+            const auto& barrier = barriers[i];
+            auto& resourceBarrier = m_ResourceBarriers[i];
+            resourceBarrier = {};
+            resourceBarrier.Flags = static_cast<D3D12_RESOURCE_BARRIER_FLAGS>(barrier.m_Flag);
+            auto resource = reinterpret_cast<ID3D12Resource*>(barrier.m_Resource);
+            switch (barrier.m_Type) {
+                case TrackedBarrierType::kTransition:
+                    resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                    resourceBarrier.Transition.pResource = resource;
+                    resourceBarrier.Transition.Subresource = barrier.m_Subresource;
+                    resourceBarrier.Transition.StateBefore = static_cast<D3D12_RESOURCE_STATES>(barrier.m_StateBefore);
+                    resourceBarrier.Transition.StateAfter = static_cast<D3D12_RESOURCE_STATES>(barrier.m_StateAfter);
+                    break;
+                case TrackedBarrierType::kAliasing:
+                    resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+                    resourceBarrier.Aliasing.pResourceBefore = reinterpret_cast<ID3D12Resource*>(barrier.m_ResourceBefore);
+                    resourceBarrier.Aliasing.pResourceAfter = resource;
+                    break;
+                case TrackedBarrierType::kUAV:
+                    resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                    resourceBarrier.UAV.pResource = resource;
+                    break;
+            }
         }
-        m_ResourceBarriers.clear();
+        m_CmdList->ResourceBarrier(static_cast<UINT>(m_ResourceBarriers.size()), m_ResourceBarriers.data());
+        m_StateTracker.Clear();
     }
     
     void CommandList::ClearUAV(GpuResource& resource, D3D12_CPU_DESCRIPTOR_HANDLE uav, const float* clearColor)
@@ -97,8 +141,8 @@ namespace DSM {
 
     void CommandList::CopySubresource(GpuResource& dest, std::uint32_t destIndex, GpuResource& src, std::uint32_t srcIndex)
     {
-        TransitionResource(dest, D3D12_RESOURCE_STATE_COPY_DEST);
-        TransitionResource(src, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        TransitionSubresource(dest, destIndex, D3D12_RESOURCE_STATE_COPY_DEST);
+        TransitionSubresource(src, srcIndex, D3D12_RESOURCE_STATE_COPY_SOURCE);
         FlushResourceBarriers();
         
         D3D12_TEXTURE_COPY_LOCATION destLocation{};
@@ -165,53 +209,77 @@ namespace DSM {
 
     void CommandList::InsertUAVBarrier(GpuResource& resource, bool flush)
     {
-        D3D12_RESOURCE_BARRIER resourceBarrier = {};
-        resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-        resourceBarrier.UAV.pResource = resource.GetResource();
-        resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-        m_ResourceBarriers.push_back(std::move(resourceBarrier));
+        m_StateTracker.UAVBarrier(reinterpret_cast<std::uint64_t>(resource.GetResource()));
         
         if (flush) {
             FlushResourceBarriers();
         }
     }
 
-    void CommandList::TransitionResource(GpuResource& resource, D3D12_RESOURCE_STATES newState, bool flush)
+    void CommandList::InsertGlobalUAVBarrier(bool flush)
     {
-        auto preState = resource.GetUsageState();
-        if (m_CmdListType == D3D12_COMMAND_LIST_TYPE_COMPUTE) {
-            auto valieComputeQueueResourceState =
-                D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
-                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
-                D3D12_RESOURCE_STATE_COPY_DEST |
-                D3D12_RESOURCE_STATE_COPY_SOURCE;
-            ASSERT(preState & valieComputeQueueResourceState == preState);
-            ASSERT(newState & valieComputeQueueResourceState == newState);
+        // 资源为空的 UAV 屏障作用于所有资源
+        m_StateTracker.UAVBarrier(0);
+
+        if (flush) {
+            FlushResourceBarriers();
         }
+    }
+
+    void CommandList::InsertAliasBarrier(GpuResource* before, GpuResource& after, bool flush)
+    {
+        m_StateTracker.AliasBarrier(
+            before == nullptr ? 0 : reinterpret_cast<std::uint64_t>(before->GetResource()),
+            reinterpret_cast<std::uint64_t>(after.GetResource()));
 
-        if (preState != newState) {
-            D3D12_RESOURCE_BARRIER resourceBarrier = {};
-            resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            resourceBarrier.Transition.pResource = resource.GetResource();
-            resourceBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            resourceBarrier.Transition.StateBefore = resource.GetUsageState();
-            resourceBarrier.Transition.StateAfter = newState;
-            m_ResourceBarriers.push_back(std::move(resourceBarrier));
-
-            resource.SetUsageState(newState);
+        if (flush) {
+            FlushResourceBarriers();
         }
-        else if (newState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS) {
-            InsertUAVBarrier(resource, flush);
+    }
+
+    void CommandList::DiscardResource(GpuResource& resource)
+    {
+        FlushResourceBarriers();
+        m_CmdList->DiscardResource(resource.GetResource(), nullptr);
+    }
+
+    void CommandList::TransitionResource(GpuResource& resource, D3D12_RESOURCE_STATES newState, bool flush)
+    {
+        TransitionSubresource(resource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, newState, flush);
+    }
+
+    void CommandList::TransitionSubresource(GpuResource& resource, std::uint32_t subresource, D3D12_RESOURCE_STATES newState, bool flush)
+    {
+        if (m_CmdListType == D3D12_COMMAND_LIST_TYPE_COMPUTE) {
+            auto preState = resource.GetUsageState(subresource);
+            ASSERT((preState & kComputeQueueStates) == preState);
+            ASSERT((newState & kComputeQueueStates) == newState);
         }
 
-        if (m_ResourceBarriers.size() >= 16 || flush) {
+        m_StateTracker.Transition(reinterpret_cast<std::uint64_t>(resource.GetResource()),
+            resource.GetSubresourceStates(), subresource, newState);
+
+        if (flush) {
             FlushResourceBarriers();
         }
     }
 
+    void CommandList::BeginResourceTransition(GpuResource& resource, D3D12_RESOURCE_STATES newState, std::uint32_t subresource)
+    {
+        if (m_CmdListType == D3D12_COMMAND_LIST_TYPE_COMPUTE) {
+            ASSERT((newState & kComputeQueueStates) == newState);
+        }
+        m_StateTracker.BeginTransition(reinterpret_cast<std::uint64_t>(resource.GetResource()),
+            resource.GetSubresourceStates(), subresource, newState);
+    }
+
     GpuResourceLocation CommandList::GetUploadBuffer(std::uint64_t bufferSize, std::uint32_t alignment)
     {
+        // 帧内优先从当前帧的上传缓冲区分配，不足时再使用动态分配器
+        if (g_RenderContext.GetFrameScheduler().IsInFrame()) {
+            auto location = g_RenderContext.AllocateFrameUpload(bufferSize, alignment);
+            if (location.m_Resource != nullptr) return location;
+        }
         return g_RenderContext.GetCpuBufferAllocator().Allocate(bufferSize, alignment);
     }
 
@@ -244,7 +312,7 @@ namespace DSM {
         }
     }
 
-    void CommandList::ExecuteCommandList(bool waitForCompletion)
+    std::uint64_t CommandList::ExecuteCommandList(bool waitForCompletion)
     {
         ASSERT(m_CmdList != nullptr);
         ASSERT(m_CmdListType == D3D12_COMMAND_LIST_TYPE_DIRECT ||
@@ -265,6 +333,35 @@ namespace DSM {
         }
 
         Reset();
+        return fenceValue;
+    }
+
+
+    void CommandList::BeginGpuRange(const char* name)
+    {
+        ASSERT(m_CmdListType != D3D12_COMMAND_LIST_TYPE_COPY, "Copy lists do not support timestamp queries");
+
+        // 记录区间所在的队列，解析时使用该队列的时钟校准
+        auto& queryHeap = g_RenderContext.GetTimestampQueryHeap();
+        auto queue = queryHeap.GetQueueIndex(m_CmdListType);
+        auto beginQuery = queue == GpuProfiler::sm_InvalidQuery ? GpuProfiler::sm_InvalidQuery :
+            g_RenderContext.GetGpuProfiler().BeginRange(name, static_cast<std::uint32_t>(m_OpenGpuRanges.size()), queue);
+        if (beginQuery != GpuProfiler::sm_InvalidQuery) {
+            queryHeap.EndQuery(m_CmdList.Get(), beginQuery);
+        }
+        m_OpenGpuRanges.push_back(beginQuery);
+    }
+
+    void CommandList::EndGpuRange()
+    {
+        ASSERT(!m_OpenGpuRanges.empty(), "EndGpuRange called without BeginGpuRange");
+
+        auto beginQuery = m_OpenGpuRanges.back();
+        m_OpenGpuRanges.pop_back();
+        auto endQuery = g_RenderContext.GetGpuProfiler().EndRange(beginQuery);
+        if (endQuery != GpuProfiler::sm_InvalidQuery) {
+            g_RenderContext.GetTimestampQueryHeap().EndQuery(m_CmdList.Get(), endQuery);
+        }
     }
 
 
@@ -332,6 +429,125 @@ namespace DSM {
         cmdList.ExecuteCommandList(true);
     }
 
+    void CommandList::InitTexture(GpuResource& dest, const DDSFile& ddsFile, std::uint64_t maxBatchSize)
+    {
+        auto numSubresources = ddsFile.GetNumSubresources();
+        std::vector<DDSUploadFootprint> footprints(numSubresources);
+        auto totalSize = ddsFile.ComputeUploadFootprints(0, footprints);
+        auto getEndOffset = [&](std::uint32_t index) {
+            return index + 1 < numSubresources ? footprints[index + 1].m_Offset : totalSize;
+        };
+
+        // 分批上传，避免大型数组或立方体数组一次占用过多的上传缓冲
+        std::uint32_t firstSubresource = 0;
+        while (firstSubresource < numSubresources) {
+            auto batchOffset = footprints[firstSubresource].m_Offset;
+            std::uint32_t numBatch = 1;
+            while (firstSubresource + numBatch < numSubresources &&
+                getEndOffset(firstSubresource + numBatch) - batchOffset <= maxBatchSize) {
+                ++numBatch;
+            }
+            auto batchSize = getEndOffset(firstSubresource + numBatch - 1) - batchOffset;
+
+            CommandList cmdList{L"InitTextureFromDDS"};
+            auto uploadBuffer = cmdList.GetUploadBuffer(batchSize, DDSFile::sm_PlacementAlignment);
+            auto mappedData = reinterpret_cast<std::uint8_t*>(uploadBuffer.m_MappedAddress);
+
+            cmdList.TransitionResource(dest, D3D12_RESOURCE_STATE_COPY_DEST, true);
+
+            for (std::uint32_t i = firstSubresource; i < firstSubresource + numBatch; ++i) {
+                // 偏移均按 512 对齐，减去批次的起始偏移后仍满足对齐要求
+                auto footprint = footprints[i];
+                footprint.m_Offset -= batchOffset;
+                ddsFile.WriteSubresource(i, footprint, mappedData);
+
+                D3D12_TEXTURE_COPY_LOCATION destLocation{};
+                destLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                destLocation.SubresourceIndex = i;
+                destLocation.pResource = dest.GetResource();
+
+                D3D12_TEXTURE_COPY_LOCATION src{};
+                src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                src.pResource = uploadBuffer.m_Resource->GetResource();
+                src.PlacedFootprint.Offset = uploadBuffer.m_Offset + footprint.m_Offset;
+                src.PlacedFootprint.Footprint.Format = static_cast<DXGI_FORMAT>(ddsFile.GetInfo().m_Format);
+                src.PlacedFootprint.Footprint.Width = footprint.m_Width;
+                src.PlacedFootprint.Footprint.Height = footprint.m_Height;
+                src.PlacedFootprint.Footprint.Depth = footprint.m_Depth;
+                src.PlacedFootprint.Footprint.RowPitch = footprint.m_RowPitch;
+                cmdList.m_CmdList->CopyTextureRegion(&destLocation, 0, 0, 0, &src, nullptr);
+            }
+
+            firstSubresource += numBatch;
+            if (firstSubresource == numSubresources) {
+                cmdList.TransitionResource(dest, D3D12_RESOURCE_STATE_GENERIC_READ);
+            }
+
+            // 等待该批完成后上传缓冲才能被复用
+            cmdList.ExecuteCommandList(true);
+        }
+    }
+
+    void CommandList::StreamTextureMips(
+        GpuResource& dest,
+        std::uint32_t destFirstMip,
+        GpuResource* src,
+        std::uint32_t srcFirstMip,
+        const DDSFile& ddsFile)
+    {
+        const auto& info = ddsFile.GetInfo();
+        ASSERT(info.m_Dimension == DDSDimension::kTexture2D && info.m_ArraySize == 1);
+        ASSERT(destFirstMip < info.m_MipLevels);
+        if (src == nullptr) {
+            srcFirstMip = info.m_MipLevels;
+        }
+
+        CommandList cmdList{L"StreamTextureMips"};
+        cmdList.TransitionResource(dest, D3D12_RESOURCE_STATE_COPY_DEST);
+        if (src != nullptr) {
+            cmdList.TransitionResource(*src, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        }
+        cmdList.FlushResourceBarriers();
+
+        // 两者共有的 mip 不需要重新上传
+        for (auto mip = (std::max)(destFirstMip, srcFirstMip); mip < info.m_MipLevels; ++mip) {
+            cmdList.CopySubresource(dest, mip - destFirstMip, *src, mip - srcFirstMip);
+        }
+
+        if (destFirstMip < srcFirstMip) {
+            std::vector<DDSUploadFootprint> footprints(srcFirstMip - destFirstMip);
+            auto uploadSize = ddsFile.ComputeUploadFootprints(destFirstMip, footprints);
+            auto uploadBuffer = cmdList.GetUploadBuffer(uploadSize, DDSFile::sm_PlacementAlignment);
+            auto mappedData = reinterpret_cast<std::uint8_t*>(uploadBuffer.m_MappedAddress);
+
+            for (std::uint32_t i = 0; i < footprints.size(); ++i) {
+                const auto& footprint = footprints[i];
+                ddsFile.WriteSubresource(destFirstMip + i, footprint, mappedData);
+
+                D3D12_TEXTURE_COPY_LOCATION destLocation{};
+                destLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                destLocation.SubresourceIndex = i;
+                destLocation.pResource = dest.GetResource();
+
+                D3D12_TEXTURE_COPY_LOCATION srcLocation{};
+                srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                srcLocation.pResource = uploadBuffer.m_Resource->GetResource();
+                srcLocation.PlacedFootprint.Offset = uploadBuffer.m_Offset + footprint.m_Offset;
+                srcLocation.PlacedFootprint.Footprint.Format = static_cast<DXGI_FORMAT>(info.m_Format);
+                srcLocation.PlacedFootprint.Footprint.Width = footprint.m_Width;
+                srcLocation.PlacedFootprint.Footprint.Height = footprint.m_Height;
+                srcLocation.PlacedFootprint.Footprint.Depth = footprint.m_Depth;
+                srcLocation.PlacedFootprint.Footprint.RowPitch = footprint.m_RowPitch;
+                cmdList.m_CmdList->CopyTextureRegion(&destLocation, 0, 0, 0, &srcLocation, nullptr);
+            }
+        }
+
+        cmdList.TransitionResource(dest, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+        // 与之后的帧在同一队列上按顺序执行，不需要等待
+        cmdList.ExecuteCommandList();
+    }
+
     void CommandList::InitBuffer(GpuResource& dest, const void* data, std::size_t byteSize, std::size_t destOffset)
     {
         CommandList cmdList{L"InitBuffer"};
@@ -347,16 +563,19 @@ namespace DSM {
         const auto& destDesc = dest->GetDesc();
         const auto& srcDesc = src->GetDesc();
 
-        ASSERT(sliceIndex < srcDesc.DepthOrArraySize && srcDesc.DepthOrArraySize == 1 &&
+        ASSERT(sliceIndex < destDesc.DepthOrArraySize && srcDesc.DepthOrArraySize == 1 &&
             destDesc.Width == srcDesc.Width && destDesc.Height == srcDesc.Height &&
             destDesc.MipLevels <= srcDesc.MipLevels);
 
-        cmdList.TransitionResource(dest, D3D12_RESOURCE_STATE_COPY_DEST);
+        // 只转换该切片的子资源，其余切片可以继续使用
+        auto subResourceIndex = sliceIndex * destDesc.MipLevels;
+        for (std::uint32_t i = 0; i < destDesc.MipLevels; i++) {
+            cmdList.TransitionSubresource(dest, subResourceIndex + i, D3D12_RESOURCE_STATE_COPY_DEST);
+        }
         cmdList.TransitionResource(src, D3D12_RESOURCE_STATE_COPY_SOURCE);
         cmdList.FlushResourceBarriers();
 
         // 将所有的mipmap拷贝到纹理中
-        auto subResourceIndex = sliceIndex + destDesc.MipLevels;
         for (std::uint32_t i = 0; i < destDesc.MipLevels; i++) {
             cmdList.CopySubresource(dest, subResourceIndex + i, src, i);
         }
@@ -9,6 +9,7 @@
 #include <span>
 #include "../../Utilities/Macros.h"
 #include "Graphics/RenderContext.h"
+#include "Graphics/ResourceStateTracker.h"
 
 
 namespace DSM {
@@ -18,6 +19,7 @@ namespace DSM {
     class PSO;
     class DynamicDescriptorHeap;
     class GpuResource;
+    class DDSFile;
     struct GpuResourceLocation;
 
     struct DWParam
@@ -84,7 +86,19 @@ namespace DSM {
         void FillBuffer(GpuResource& dest, std::size_t destOffset, DWParam value, std::size_t byteSize);
 
         void InsertUAVBarrier(GpuResource& resource, bool flush = false);
+        // 等待之前所有的 UAV 写入，例如批量构建的加速结构
+        void InsertGlobalUAVBarrier(bool flush = false);
+        // 共享同一块内存的资源切换时使用，before 为空时表示任意之前的资源
+        void InsertAliasBarrier(GpuResource* before, GpuResource& after, bool flush = false);
+        // 复用内存的渲染目标与深度缓冲第一次使用前需要初始化
+        void DiscardResource(GpuResource& resource);
+        // 屏障在下一次绘制、分派、拷贝或 flush 时批量提交，同一批中的转换会被合并
         void TransitionResource(GpuResource& resource, D3D12_RESOURCE_STATES newState, bool flush = false);
+        void TransitionSubresource(GpuResource& resource, std::uint32_t subresource, D3D12_RESOURCE_STATES newState, bool flush = false);
+        // 拆分屏障，提前开始转换，之后第一次转换该子资源时结束，需在同一命令列表中结束，期间不能使用该子资源
+        void BeginResourceTransition(GpuResource& resource, D3D12_RESOURCE_STATES newState,
+            std::uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+        const ResourceStateTrackerStats& GetBarrierStats() const noexcept { return m_StateTracker.GetStats(); }
 
         GpuResourceLocation GetUploadBuffer(std::uint64_t bufferSize, std::uint32_t alignment = 0);
 
@@ -92,9 +106,24 @@ namespace DSM {
         void SetDescriptorHeaps(std::uint32_t count , ID3D12DescriptorHeap** descriptorHeaps);
         void SetPipelineState(PSO& pso);
 
-        void ExecuteCommandList(bool waitForCompletion = false);
+        // 提交后可以继续录制，返回提交的命令完成时的栅栏值
+        std::uint64_t ExecuteCommandList(bool waitForCompletion = false);
+
+        // 记录 GPU 区间的时间戳，可以嵌套，name 需为字符串字面量
+        void BeginGpuRange(const char* name);
+        void EndGpuRange();
 
         static void InitTexture(GpuResource& dest, std::span<D3D12_SUBRESOURCE_DATA> subResources);
+        // 直接从映射的 DDS 文件写入上传缓冲，每批上传的数据不超过 maxBatchSize(至少包含一个子资源)
+        static void InitTexture(GpuResource& dest, const DDSFile& ddsFile, std::uint64_t maxBatchSize);
+        // 流式纹理改变驻留的 mip 时使用，dest 与 src 分别包含 DDS 中从 destFirstMip 与 srcFirstMip 开始的 mip
+        // 两者共有的 mip 在 GPU 上拷贝，其余从 DDS 上传，src 为空时全部上传，只支持非数组的 2D 纹理
+        static void StreamTextureMips(
+            GpuResource& dest,
+            std::uint32_t destFirstMip,
+            GpuResource* src,
+            std::uint32_t srcFirstMip,
+            const DDSFile& ddsFile);
         static void InitBuffer(GpuResource& dest, const void* data, std::size_t byteSize, std::size_t destOffset = 0);
         static void InitTextureArraySlice(GpuResource& dest, std::uint32_t sliceIndex, GpuResource& src);
 
@@ -115,10 +144,34 @@ namespace DSM {
         DynamicDescriptorHeap* m_ViewDescriptorHeap{};
         DynamicDescriptorHeap* m_SampleDescriptorHeap{};
 
+        ResourceStateTracker m_StateTracker{};
         std::vector<D3D12_RESOURCE_BARRIER> m_ResourceBarriers{};
         std::array<ID3D12DescriptorHeap*, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> m_CurrDescriptorHeaps{};
+
+        // 尚未结束的 GPU 区间的起始查询
+        std::vector<std::uint32_t> m_OpenGpuRanges{};
+    };
+
+    // 作用域内的 GPU 计时
+    class ScopedGpuRange
+    {
+    public:
+        ScopedGpuRange(CommandList& cmdList, const char* name)
+            :m_CmdList(cmdList) { m_CmdList.BeginGpuRange(name); }
+        ~ScopedGpuRange() { m_CmdList.EndGpuRange(); }
+        DSM_NONCOPYABLE(ScopedGpuRange);
+
+    private:
+        CommandList& m_CmdList;
     };
 
+#ifndef DSM_DISABLE_PROFILER
+#define PROFILE_GPU_SCOPE(cmdList, name) \
+    DSM::ScopedGpuRange DSM_PROFILER_CONCAT(_GpuRange, __LINE__){cmdList, name}
+#else
+#define PROFILE_GPU_SCOPE(cmdList, name)
+#endif
+
 }
 
 #endif
\ No newline at end of file
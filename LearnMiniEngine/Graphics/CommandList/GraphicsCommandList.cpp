@@ -56,13 +56,13 @@ namespace DSM {
     void GraphicsCommandList::SetShaderResource(std::uint32_t rootIndex, const GpuResource& resource, std::uint64_t offset)
     {
         auto state = (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        ASSERT(resource.GetUsageState() & state != 0);
+        ASSERT((resource.GetUsageState() & state) != 0);
         m_CmdList->SetGraphicsRootShaderResourceView(rootIndex, resource.GetGpuVirtualAddress() + offset);
     }
 
     void GraphicsCommandList::SetUnorderedAccess(std::uint32_t rootIndex, const GpuResource& resource,std::uint64_t offset)
     {
-        ASSERT(resource.GetUsageState() & D3D12_RESOURCE_STATE_UNORDERED_ACCESS != 0);
+        ASSERT((resource.GetUsageState() & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
         m_CmdList->SetGraphicsRootUnorderedAccessView(rootIndex, resource.GetGpuVirtualAddress() + offset);
     }
 
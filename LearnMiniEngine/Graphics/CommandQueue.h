@@ -3,9 +3,10 @@
 #define __COMMANDQUEUE_H__
 
 #include "CommandAllocatorPool.h"
+#include "FrameScheduler.h"
 
 namespace DSM {
-    class CommandQueue
+    class CommandQueue : public IFence
     {
         friend class RenderContext;
         friend class CommandList;
@@ -24,15 +25,16 @@ namespace DSM {
 
         // 增加栅栏值
         std::uint64_t IncrementFence(void);
-        bool IsFenceComplete(std::uint64_t fenceValue);
+        virtual bool IsFenceComplete(std::uint64_t fenceValue) override;
         // GPU 进行等待
         void StallForFence(std::uint64_t fenceValue);
         void StallForProducer(CommandQueue& producer);
         // CPU 进行等待
-        void WaitForFence(std::uint64_t fenceValue);
+        virtual void WaitForFence(std::uint64_t fenceValue) override;
         void WaitForIdle(void) { WaitForFence(IncrementFence()); }
 
         ID3D12CommandQueue* GetCommandQueue() const {return m_pCommandQueue.Get();}
+        D3D12_COMMAND_LIST_TYPE GetType() const noexcept { return m_CommandListType; }
         std::uint64_t GetNextFenceValue() {return m_NextFenceValue;}
 
     protected:
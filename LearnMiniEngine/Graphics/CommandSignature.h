@@ -88,38 +88,43 @@ namespace DSM {
             return m_IndirectParameters[index];
         }
 
-        void Finalize(const RootSignature* rootSig = nullptr)
+        // byteStride 为 0 时参数紧密排列，否则不能小于参数的总大小，用于填充对齐的记录
+        void Finalize(const RootSignature* rootSig = nullptr, UINT byteStride = 0)
         {
             if (m_Finalized) return;
 
-            UINT byteStride = 0;
+            UINT argumentSize = 0;
             bool requiresRootSig = false;
 
             for (const auto& param : m_IndirectParameters) {
                 D3D12_INDIRECT_ARGUMENT_DESC paramDsec = param; 
                 switch (paramDsec.Type) {
                     case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
-                        byteStride += sizeof(D3D12_DRAW_ARGUMENTS); break;
+                        argumentSize += sizeof(D3D12_DRAW_ARGUMENTS); break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
-                        byteStride += sizeof(D3D12_DRAW_INDEXED_ARGUMENTS); break;
+                        argumentSize += sizeof(D3D12_DRAW_INDEXED_ARGUMENTS); break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
-                        byteStride += sizeof(D3D12_DISPATCH_ARGUMENTS); break;
+                        argumentSize += sizeof(D3D12_DISPATCH_ARGUMENTS); break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH:
-                        byteStride += sizeof(D3D12_DISPATCH_MESH_ARGUMENTS); break;
+                        argumentSize += sizeof(D3D12_DISPATCH_MESH_ARGUMENTS); break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW:
-                        byteStride += sizeof(D3D12_VERTEX_BUFFER_VIEW); break;
+                        argumentSize += sizeof(D3D12_VERTEX_BUFFER_VIEW); break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW:
-                        byteStride += sizeof(D3D12_INDEX_BUFFER_VIEW); break;
+                        argumentSize += sizeof(D3D12_INDEX_BUFFER_VIEW); break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
-                        byteStride += paramDsec.Constant.Num32BitValuesToSet * 4;
+                        argumentSize += paramDsec.Constant.Num32BitValuesToSet * 4;
                         requiresRootSig = true; break;
                     case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
                     case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW:
                     case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW:
-                        byteStride += 8;
+                        argumentSize += 8;
                         requiresRootSig = true; break;
                 }
             }
+            if (byteStride == 0) {
+                byteStride = argumentSize;
+            }
+            ASSERT(byteStride >= argumentSize, "Byte stride is smaller than the arguments!");
 
             D3D12_COMMAND_SIGNATURE_DESC cmdSignatureDesc = {};
             cmdSignatureDesc.ByteStride = byteStride;
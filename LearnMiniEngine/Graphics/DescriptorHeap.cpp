@@ -79,6 +79,29 @@ namespace DSM {
 		Create(name, heapType, heapSize, flags);
 	}
 
+	DescriptorHeap::~DescriptorHeap()
+	{
+		// 移动后的对象不再拥有该记录
+		if (m_DescriptorHeap != nullptr) {
+			g_MemoryTracker.RecordFree(m_MemoryAllocation);
+		}
+	}
+
+	DescriptorHeap& DescriptorHeap::operator=(DescriptorHeap&& other) noexcept
+	{
+		if (this != &other) {
+			if (m_DescriptorHeap != nullptr) {
+				g_MemoryTracker.RecordFree(m_MemoryAllocation);
+			}
+			m_DescriptorHeap = std::move(other.m_DescriptorHeap);
+			m_DescriptorSize = other.m_DescriptorSize;
+			m_FirstHandle = other.m_FirstHandle;
+			m_Allocator = std::move(other.m_Allocator);
+			m_MemoryAllocation = other.m_MemoryAllocation;
+		}
+		return *this;
+	}
+
 	void DescriptorHeap::Clear()
 	{
 		m_Allocator.Clear();
@@ -157,6 +180,11 @@ namespace DSM {
 			D3D12_GPU_DESCRIPTOR_HANDLE{ D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN };
 		m_FirstHandle = { m_DescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
 			gpuHandle };
+
+		m_MemoryAllocation = g_MemoryTracker.RecordAllocation(
+			MemoryCategory::kDescriptor,
+			static_cast<std::uint64_t>(heapSize) * m_DescriptorSize,
+			Utility::WStringToUTF8(name));
 	}
 
 
@@ -11,6 +11,7 @@
 #include <set>
 #include "../Utilities/LinearAllocator.h"
 #include "../Utilities/Macros.h"
+#include "../Core/MemoryTracker.h"
 
 namespace DSM {
     // 描述符的句柄
@@ -55,9 +56,9 @@ namespace DSM {
             :m_Allocator(heapSize) {
             Create(name, heapType, heapSize, flags);
         }
-        ~DescriptorHeap() = default;
+        ~DescriptorHeap();
         DescriptorHeap(DescriptorHeap&&) = default;
-        DescriptorHeap& operator=(DescriptorHeap&&) = default;
+        DescriptorHeap& operator=(DescriptorHeap&& other) noexcept;
         DSM_NONCOPYABLE(DescriptorHeap);
 
         void Clear();
@@ -87,6 +88,8 @@ namespace DSM {
         
         DescriptorHandle m_FirstHandle{};
         LinearAllocator m_Allocator;
+
+        std::uint64_t m_MemoryAllocation = MemoryTracker::sm_InvalidAllocation;
     };
 
 
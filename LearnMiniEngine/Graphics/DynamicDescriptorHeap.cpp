@@ -3,6 +3,7 @@
 #include "RenderContext.h"
 #include "RootSignature.h"
 #include "CommandList/CommandList.h"
+#include "../Core/Profiler.h"
 
 namespace DSM {
     class DynamicDescriptorHeapAllocator
@@ -265,6 +266,7 @@ namespace DSM {
     void DynamicDescriptorHeap::CommitGraphicsRootDescriptorTables()
     {
         if (m_GraphicsHandleCache.m_StaleRootParamsBitMap != 0) {
+            PROFILE_SCOPE("CommitGraphicsRootDescriptorTables");
             auto func = [&](UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
                 m_OwningCmdList->GetCommandList()->SetGraphicsRootDescriptorTable(rootIndex, handle);
             };
@@ -274,24 +276,27 @@ namespace DSM {
 
     void DynamicDescriptorHeap::CommitComputeRootDescriptorTables()
     {
-        if (m_GraphicsHandleCache.m_StaleRootParamsBitMap != 0) {
+        if (m_ComputeHandleCache.m_StaleRootParamsBitMap != 0) {
+            PROFILE_SCOPE("CommitComputeRootDescriptorTables");
             auto func = [&](UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
-                m_OwningCmdList->GetCommandList()->SetGraphicsRootDescriptorTable(rootIndex, handle);
+                m_OwningCmdList->GetCommandList()->SetComputeRootDescriptorTable(rootIndex, handle);
             };
-            CopyAndBindStaleTables(m_GraphicsHandleCache, func);
+            CopyAndBindStaleTables(m_ComputeHandleCache, func);
         }
     }
 
     D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::UploadDirect(D3D12_CPU_DESCRIPTOR_HANDLE handle)
     {
-        if (m_pCurrentHeap == nullptr || !m_pCurrentHeap->HasValidSpace(1)){
-            RequestDescriptorHeap();
+        DescriptorHandle gpuHanlde{};
+        // 当前帧的描述符用尽时会再切换一次
+        for (int attempt = 0; !TryAllocate(1, gpuHanlde); ++attempt) {
+            ASSERT(attempt < 2);
+            SwitchDescriptorHeap();
             m_GraphicsHandleCache.UnbindAllValid();
             m_ComputeHandleCache.UnbindAllValid();
         }
 
-        m_OwningCmdList->SetDescriptorHeap(m_pCurrentHeap->GetHeap());
-        auto gpuHanlde = m_pCurrentHeap->Allocate();
+        m_OwningCmdList->SetDescriptorHeap(GetCurrentHeap());
         g_RenderContext.GetDevice()->CopyDescriptorsSimple(1, gpuHanlde, handle, m_HeapType);
 
         return gpuHanlde;
@@ -303,6 +308,7 @@ namespace DSM {
             m_FullDescriptorHeaps.push_back(m_pCurrentHeap);
             m_pCurrentHeap = nullptr;
         }
+        m_UseFrameDescriptors = false;
         s_DynamicDescriptorHeapManager.DiscardDescriptorHeap(m_HeapType, fenceValue, m_FullDescriptorHeaps);
         m_FullDescriptorHeaps.clear();
         m_GraphicsHandleCache.Cleanup();
@@ -355,14 +361,49 @@ namespace DSM {
         std::function<void(UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc)
     {
         auto usedSize = handleCache.ComputeStaledSize();
-        if (m_pCurrentHeap == nullptr || !m_pCurrentHeap->HasValidSpace(usedSize)) {
-            RequestDescriptorHeap();
+        DescriptorHandle handleStart{};
+        for (int attempt = 0; !TryAllocate(usedSize, handleStart); ++attempt) {
+            ASSERT(attempt < 2, "Descriptor tables exceed the size of a descriptor heap");
+            SwitchDescriptorHeap();
             m_GraphicsHandleCache.UnbindAllValid();
             m_ComputeHandleCache.UnbindAllValid();
+            // 换堆后所有绑定过的描述符表都需要重新拷贝
+            usedSize = handleCache.ComputeStaledSize();
+        }
+
+        m_OwningCmdList->SetDescriptorHeap(GetCurrentHeap());
+        handleCache.CopyAndBindStaleTables(m_HeapType, usedSize, handleStart, setFunc);
+    }
+
+    bool DynamicDescriptorHeap::TryAllocate(std::uint32_t count, DescriptorHandle& handle)
+    {
+        if (m_UseFrameDescriptors) {
+            handle = g_RenderContext.AllocateFrameDescriptors(count);
+            return handle.IsValid();
         }
+        if (m_pCurrentHeap == nullptr || !m_pCurrentHeap->HasValidSpace(count)) return false;
 
-        m_OwningCmdList->SetDescriptorHeap(m_pCurrentHeap->GetHeap());
-        handleCache.CopyAndBindStaleTables(m_HeapType, usedSize, m_pCurrentHeap->Allocate(usedSize), setFunc);
+        handle = m_pCurrentHeap->Allocate(count);
+        return true;
+    }
+
+    void DynamicDescriptorHeap::SwitchDescriptorHeap()
+    {
+        // 帧内的视图描述符先从当前帧的描述符中分配，该帧完成后整体回收，用尽后再使用独立的描述符堆
+        if (m_HeapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV &&
+            m_pCurrentHeap == nullptr && !m_UseFrameDescriptors &&
+            g_RenderContext.GetFrameScheduler().IsInFrame()) {
+            m_UseFrameDescriptors = true;
+            return;
+        }
+
+        m_UseFrameDescriptors = false;
+        RequestDescriptorHeap();
+    }
+
+    ID3D12DescriptorHeap* DynamicDescriptorHeap::GetCurrentHeap() const
+    {
+        return m_UseFrameDescriptors ? g_RenderContext.GetFrameDescriptorHeap().GetHeap() : m_pCurrentHeap->GetHeap();
     }
 
     void DynamicDescriptorHeap::RequestDescriptorHeap()
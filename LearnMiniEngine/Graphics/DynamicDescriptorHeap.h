@@ -103,6 +103,11 @@ namespace DSM {
         void CopyAndBindStaleTables(
             DescriptorHandleCache& handleCache,
             std::function<void(UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc);
+        // 在当前的描述符堆中分配，空间不足时返回 false
+        bool TryAllocate(std::uint32_t count, DescriptorHandle& handle);
+        // 切换描述符堆后之前绑定的描述符表全部失效
+        void SwitchDescriptorHeap();
+        ID3D12DescriptorHeap* GetCurrentHeap() const;
         void RequestDescriptorHeap();
         
     private:
@@ -115,6 +120,8 @@ namespace DSM {
         const D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType{};
         DescriptorHeap* m_pCurrentHeap{};
         std::vector<DescriptorHeap*> m_FullDescriptorHeaps{};
+        // 是否正在从当前帧的描述符中分配
+        bool m_UseFrameDescriptors = false;
 
         DescriptorHandleCache m_GraphicsHandleCache{};
         DescriptorHandleCache m_ComputeHandleCache{};
@@ -0,0 +1,124 @@
+#include "FrameScheduler.h"
+#include <chrono>
+#include <algorithm>
+#include <cassert>
+
+namespace DSM {
+    void FrameScheduler::Create(const FrameSchedulerDesc& desc, IFence* fence)
+    {
+        assert(fence != nullptr && desc.m_NumFramesInFlight > 0);
+        assert(!IsCreated());
+
+        m_Desc = desc;
+        m_Fence = fence;
+        m_FrameIndex = 0;
+        m_FrameCount = 0;
+        m_InFrame = false;
+        m_WaitStats = {};
+
+        // 每帧占用整块缓冲区与描述符堆中互不重叠的一段
+        m_Frames.resize(desc.m_NumFramesInFlight);
+        for (std::uint32_t i = 0; i < desc.m_NumFramesInFlight; ++i) {
+            auto& frame = m_Frames[i];
+            frame.m_Buffer.m_Start = i * desc.m_TransientBufferSize;
+            frame.m_Buffer.m_End = frame.m_Buffer.m_Start + desc.m_TransientBufferSize;
+            frame.m_Buffer.Clear();
+            frame.m_Descriptors.m_Start = std::uint64_t{i} * desc.m_NumTransientDescriptors;
+            frame.m_Descriptors.m_End = frame.m_Descriptors.m_Start + desc.m_NumTransientDescriptors;
+            frame.m_Descriptors.Clear();
+        }
+    }
+
+    void FrameScheduler::Shutdown()
+    {
+        if (!IsCreated()) return;
+
+        // 从最早提交的帧开始回收，保持延迟释放的先后顺序
+        for (std::size_t i = 0; i < m_Frames.size(); ++i) {
+            RetireFrame(m_Frames[(m_FrameCount + i) % m_Frames.size()]);
+        }
+        m_Frames.clear();
+        m_Fence = nullptr;
+        m_InFrame = false;
+    }
+
+    std::uint32_t FrameScheduler::BeginFrame()
+    {
+        assert(IsCreated());
+        assert(!m_InFrame && "BeginFrame called twice without EndFrame");
+
+        m_FrameIndex = static_cast<std::uint32_t>(m_FrameCount % m_Frames.size());
+        auto& frame = m_Frames[m_FrameIndex];
+
+        // 等待使用同一槽位的帧完成
+        auto startTime = std::chrono::steady_clock::now();
+        bool stalled = frame.m_FenceValue != 0 && !m_Fence->IsFenceComplete(frame.m_FenceValue);
+        RetireFrame(frame);
+        std::chrono::duration<double, std::milli> waitTime = std::chrono::steady_clock::now() - startTime;
+
+        m_WaitStats.m_LastWaitTime = stalled ? waitTime.count() : 0;
+        m_WaitStats.m_MaxWaitTime = (std::max)(m_WaitStats.m_MaxWaitTime, m_WaitStats.m_LastWaitTime);
+        m_WaitStats.m_TotalWaitTime += m_WaitStats.m_LastWaitTime;
+        m_WaitStats.m_NumStalls += stalled ? 1 : 0;
+        ++m_WaitStats.m_NumFrames;
+
+        m_InFrame = true;
+        return m_FrameIndex;
+    }
+
+    void FrameScheduler::EndFrame(std::uint64_t fenceValue)
+    {
+        assert(m_InFrame && "EndFrame called without BeginFrame");
+
+        m_Frames[m_FrameIndex].m_FenceValue = fenceValue;
+        ++m_FrameCount;
+        m_InFrame = false;
+    }
+
+    std::uint64_t FrameScheduler::AllocateTransient(std::uint64_t size, std::uint32_t alignment)
+    {
+        assert(m_InFrame);
+        std::lock_guard lock{m_FrameMutex};
+        return m_Frames[m_FrameIndex].m_Buffer.Allocate(size, alignment);
+    }
+
+    std::uint32_t FrameScheduler::AllocateTransientDescriptors(std::uint32_t count)
+    {
+        assert(m_InFrame);
+        std::lock_guard lock{m_FrameMutex};
+        auto offset = m_Frames[m_FrameIndex].m_Descriptors.Allocate(count, 0);
+        return offset == sm_InvalidTransientOffset ?
+            sm_InvalidTransientDescriptor : static_cast<std::uint32_t>(offset);
+    }
+
+    void FrameScheduler::DeferRelease(std::function<void()> release)
+    {
+        assert(m_InFrame);
+        std::lock_guard lock{m_FrameMutex};
+        m_Frames[m_FrameIndex].m_DeferredReleases.push_back(std::move(release));
+    }
+
+    void FrameScheduler::RetireFrame(FrameContext& frame)
+    {
+        if (frame.m_FenceValue != 0) {
+            m_Fence->WaitForFence(frame.m_FenceValue);
+        }
+
+        for (auto& release : frame.m_DeferredReleases) {
+            release();
+        }
+        frame.m_DeferredReleases.clear();
+        frame.m_Buffer.Clear();
+        frame.m_Descriptors.Clear();
+    }
+
+    std::uint64_t FrameScheduler::TransientRange::Allocate(std::uint64_t size, std::uint64_t alignment) noexcept
+    {
+        auto offset = alignment == 0 ? m_Offset : (m_Offset + alignment - 1) / alignment * alignment;
+        if (offset > m_End || size > m_End - offset) {
+            return sm_InvalidTransientOffset;
+        }
+        m_Offset = offset + size;
+        return offset;
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+#ifndef __FRAMESCHEDULER_H__
+#define __FRAMESCHEDULER_H__
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <limits>
+#include <mutex>
+
+namespace DSM {
+    // 栅栏的抽象，由 CommandQueue 实现，测试时可替换为模拟的栅栏时钟
+    class IFence
+    {
+    public:
+        virtual ~IFence() = default;
+        virtual bool IsFenceComplete(std::uint64_t fenceValue) = 0;
+        // CPU 等待直到栅栏值完成
+        virtual void WaitForFence(std::uint64_t fenceValue) = 0;
+    };
+
+    struct FrameSchedulerDesc
+    {
+        // 同时允许在 GPU 上执行的帧数
+        std::uint32_t m_NumFramesInFlight = 2;
+        // 每帧临时上传内存的大小
+        std::uint64_t m_TransientBufferSize = 0;
+        // 每帧临时描述符的数量
+        std::uint32_t m_NumTransientDescriptors = 0;
+    };
+
+    // CPU 等待 GPU 的时间统计，单位为毫秒
+    struct FrameWaitStats
+    {
+        double m_LastWaitTime = 0;
+        double m_MaxWaitTime = 0;
+        double m_TotalWaitTime = 0;
+        // CPU 实际被阻塞的帧数
+        std::uint64_t m_NumStalls = 0;
+        std::uint64_t m_NumFrames = 0;
+
+        double GetAverageWaitTime() const noexcept
+        {
+            return m_NumFrames == 0 ? 0 : m_TotalWaitTime / m_NumFrames;
+        }
+    };
+
+    // 控制同时执行的帧数，并按帧索引回收每帧的临时资源
+    // BeginFrame/EndFrame 只能在主线程中调用，帧内的分配与延迟释放可在工作线程中调用
+    class FrameScheduler
+    {
+    public:
+        FrameScheduler() = default;
+        ~FrameScheduler() { Shutdown(); }
+        FrameScheduler(const FrameScheduler&) = delete;
+        FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+        void Create(const FrameSchedulerDesc& desc, IFence* fence);
+        // 等待所有帧完成并释放延迟的资源
+        void Shutdown();
+
+        // 开始新的一帧，若该帧槽位的资源仍被 GPU 使用则进行等待，返回帧索引
+        std::uint32_t BeginFrame();
+        // 记录该帧最后提交的栅栏值
+        void EndFrame(std::uint64_t fenceValue);
+
+        // 从当前帧的临时内存中分配，返回在整块缓冲区中的偏移，空间不足时返回 sm_InvalidTransientOffset
+        std::uint64_t AllocateTransient(std::uint64_t size, std::uint32_t alignment = 0);
+        // 从当前帧的临时描述符中分配，返回在整个描述符堆中的索引，不足时返回 sm_InvalidTransientDescriptor
+        std::uint32_t AllocateTransientDescriptors(std::uint32_t count);
+        // 在该帧的 GPU 工作完成后执行
+        void DeferRelease(std::function<void()> release);
+
+        bool IsCreated() const noexcept { return m_Fence != nullptr; }
+        bool IsInFrame() const noexcept { return m_InFrame; }
+        std::uint32_t GetFrameIndex() const noexcept { return m_FrameIndex; }
+        std::uint32_t GetNumFramesInFlight() const noexcept { return static_cast<std::uint32_t>(m_Frames.size()); }
+        std::uint64_t GetFrameCount() const noexcept { return m_FrameCount; }
+        std::uint64_t GetFrameFenceValue(std::uint32_t frameIndex) const noexcept { return m_Frames[frameIndex].m_FenceValue; }
+        std::uint64_t GetTransientBufferSize() const noexcept { return m_Desc.m_TransientBufferSize; }
+        std::uint32_t GetNumTransientDescriptors() const noexcept { return m_Desc.m_NumTransientDescriptors; }
+        const FrameWaitStats& GetWaitStats() const noexcept { return m_WaitStats; }
+        void ResetWaitStats() noexcept { m_WaitStats = {}; }
+
+    public:
+        inline static constexpr std::uint64_t sm_InvalidTransientOffset = (std::numeric_limits<std::uint64_t>::max)();
+        inline static constexpr std::uint32_t sm_InvalidTransientDescriptor = (std::numeric_limits<std::uint32_t>::max)();
+
+    private:
+        // 在 [m_Start, m_End) 中线性分配，失败时不移动当前偏移
+        struct TransientRange
+        {
+            std::uint64_t m_Start = 0;
+            std::uint64_t m_End = 0;
+            std::uint64_t m_Offset = 0;
+
+            std::uint64_t Allocate(std::uint64_t size, std::uint64_t alignment) noexcept;
+            void Clear() noexcept { m_Offset = m_Start; }
+        };
+
+        struct FrameContext
+        {
+            // 该帧最后提交的栅栏值, 0 表示尚未提交
+            std::uint64_t m_FenceValue = 0;
+            TransientRange m_Buffer{};
+            TransientRange m_Descriptors{};
+            std::vector<std::function<void()>> m_DeferredReleases{};
+        };
+
+        // 等待帧完成并回收其资源
+        void RetireFrame(FrameContext& frame);
+
+    private:
+        FrameSchedulerDesc m_Desc{};
+        IFence* m_Fence{};
+        std::vector<FrameContext> m_Frames{};
+
+        std::uint32_t m_FrameIndex = 0;
+        std::uint64_t m_FrameCount = 0;
+        bool m_InFrame = false;
+        // 保护当前帧的临时分配与延迟释放列表
+        std::mutex m_FrameMutex{};
+
+        FrameWaitStats m_WaitStats{};
+    };
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "GpuProfiler.h"
+#include <algorithm>
+#include <cassert>
+
+namespace DSM {
+    void GpuProfiler::Create(IGpuTimestampSource* source, std::uint32_t numFrames, std::uint32_t maxQueriesPerFrame)
+    {
+        assert(source != nullptr && numFrames > 0 && maxQueriesPerFrame >= 2);
+
+        m_Source = source;
+        m_MaxQueriesPerFrame = maxQueriesPerFrame;
+        m_Frames.clear();
+        m_Frames.resize(numFrames);
+        m_CurrFrame = 0;
+        m_FrameCount = 0;
+        m_InFrame = false;
+        m_Timestamps.resize(maxQueriesPerFrame);
+
+        m_TimelineIndex = g_Profiler.RegisterTimeline("GPU");
+    }
+
+    void GpuProfiler::Shutdown()
+    {
+        m_Source = nullptr;
+        m_Frames.clear();
+        m_InFrame = false;
+    }
+
+    void GpuProfiler::BeginFrame(std::uint32_t frameIndex)
+    {
+        if (!IsCreated()) return;
+        assert(frameIndex < m_Frames.size());
+
+        ResolveFrame(frameIndex);
+
+        std::lock_guard lock{m_Mutex};
+        auto& frame = m_Frames[frameIndex];
+        frame.m_Ranges.clear();
+        frame.m_NumQueries = 0;
+        frame.m_FrameIndex = m_FrameCount++;
+        frame.m_CpuBeginTime = Profiler::GetTimestamp();
+        frame.m_Pending = false;
+        m_CurrFrame = frameIndex;
+        m_InFrame = true;
+    }
+
+    std::span<const GpuQueryBatch> GpuProfiler::EndFrame()
+    {
+        m_Batches.clear();
+        if (!IsCreated()) return m_Batches;
+
+        std::lock_guard lock{m_Mutex};
+        if (!m_InFrame) return m_Batches;
+
+        auto& frame = m_Frames[m_CurrFrame];
+        frame.m_CpuEndTime = Profiler::GetTimestamp();
+        frame.m_Pending = frame.m_NumQueries > 0;
+        m_InFrame = false;
+
+        // 起始查询总会写入，结束查询只在区间结束后写入，解析未写入的查询是无效的
+        for (const auto& range : frame.m_Ranges) {
+            auto numQueries = range.m_EndQuery == sm_InvalidQuery ? 1u : 2u;
+            if (!m_Batches.empty() && m_Batches.back().m_FirstQuery + m_Batches.back().m_NumQueries == range.m_BeginQuery) {
+                m_Batches.back().m_NumQueries += numQueries;
+            }
+            else {
+                m_Batches.push_back({range.m_BeginQuery, numQueries});
+            }
+        }
+        return m_Batches;
+    }
+
+    std::uint32_t GpuProfiler::BeginRange(const char* name, std::uint32_t depth, std::uint32_t queue)
+    {
+        std::lock_guard lock{m_Mutex};
+        if (!m_InFrame || !g_Profiler.IsEnabled()) return sm_InvalidQuery;
+
+        auto& frame = m_Frames[m_CurrFrame];
+        // 需同时为结束查询预留空间
+        if (frame.m_NumQueries + 2 > m_MaxQueriesPerFrame) return sm_InvalidQuery;
+
+        GpuTimestampRange range{};
+        range.m_Name = name;
+        range.m_BeginQuery = GetFrameFirstQuery(m_CurrFrame) + frame.m_NumQueries;
+        range.m_EndQuery = sm_InvalidQuery;
+        range.m_Depth = depth;
+        range.m_Queue = queue;
+        frame.m_Ranges.push_back(range);
+        frame.m_NumQueries += 2;
+        return range.m_BeginQuery;
+    }
+
+    std::uint32_t GpuProfiler::EndRange(std::uint32_t beginQuery)
+    {
+        if (beginQuery == sm_InvalidQuery) return sm_InvalidQuery;
+
+        std::lock_guard lock{m_Mutex};
+        if (!m_InFrame) return sm_InvalidQuery;
+
+        // 结束查询紧跟在起始查询之后，保证两者在同一帧的范围内
+        auto& frame = m_Frames[m_CurrFrame];
+        for (auto it = frame.m_Ranges.rbegin(); it != frame.m_Ranges.rend(); ++it) {
+            if (it->m_BeginQuery == beginQuery) {
+                it->m_EndQuery = beginQuery + 1;
+                return it->m_EndQuery;
+            }
+        }
+        return sm_InvalidQuery;
+    }
+
+    void GpuProfiler::ResolveRanges(
+        std::span<const std::uint64_t> timestamps,
+        std::span<const GpuTimestampRange> ranges,
+        std::uint32_t firstQuery,
+        std::span<const GpuClockCalibration> calibrations,
+        std::uint32_t timelineIndex,
+        std::vector<ProfileEvent>& events)
+    {
+        for (const auto& range : ranges) {
+            if (range.m_BeginQuery < firstQuery || range.m_EndQuery < firstQuery ||
+                range.m_EndQuery == sm_InvalidQuery) continue;
+            if (range.m_Queue >= calibrations.size() || calibrations[range.m_Queue].m_Frequency == 0) continue;
+            const auto& calibration = calibrations[range.m_Queue];
+
+            auto beginIndex = range.m_BeginQuery - firstQuery;
+            auto endIndex = range.m_EndQuery - firstQuery;
+            if (beginIndex >= timestamps.size() || endIndex >= timestamps.size()) continue;
+
+            auto beginTimestamp = timestamps[beginIndex];
+            auto endTimestamp = timestamps[endIndex];
+            // 未写入或乱序的时间戳
+            if (beginTimestamp == 0 || endTimestamp < beginTimestamp) continue;
+
+            ProfileEvent event{};
+            event.m_Name = range.m_Name;
+            event.m_BeginTime = GpuToCpuTime(beginTimestamp, calibration);
+            event.m_EndTime = GpuToCpuTime(endTimestamp, calibration);
+            event.m_ThreadIndex = timelineIndex;
+            event.m_Depth = range.m_Depth;
+            events.push_back(event);
+        }
+    }
+
+    std::uint64_t GpuProfiler::GpuToCpuTime(std::uint64_t gpuTimestamp, const GpuClockCalibration& calibration) noexcept
+    {
+        // 拆分整数与余数部分以避免乘法溢出
+        auto toNanoseconds = [&calibration](std::uint64_t ticks) {
+            auto seconds = ticks / calibration.m_Frequency;
+            auto remainder = ticks % calibration.m_Frequency;
+            return seconds * 1000000000ull + remainder * 1000000000ull / calibration.m_Frequency;
+        };
+
+        if (gpuTimestamp >= calibration.m_GpuTimestamp) {
+            return calibration.m_CpuTimestamp + toNanoseconds(gpuTimestamp - calibration.m_GpuTimestamp);
+        }
+        auto offset = toNanoseconds(calibration.m_GpuTimestamp - gpuTimestamp);
+        return offset > calibration.m_CpuTimestamp ? 0 : calibration.m_CpuTimestamp - offset;
+    }
+
+    void GpuProfiler::ResolveFrame(std::uint32_t frameIndex)
+    {
+        auto& frame = m_Frames[frameIndex];
+        if (!frame.m_Pending) return;
+        frame.m_Pending = false;
+
+        auto firstQuery = GetFrameFirstQuery(frameIndex);
+        if (!m_Source->ReadTimestamps(firstQuery, frame.m_NumQueries, m_Timestamps.data())) return;
+
+        // 每个用到的队列各自校准一次
+        std::uint32_t numQueues = 0;
+        for (const auto& range : frame.m_Ranges) {
+            numQueues = (std::max)(numQueues, range.m_Queue + 1);
+        }
+        m_Calibrations.resize(numQueues);
+        for (std::uint32_t i = 0; i < numQueues; ++i) {
+            m_Calibrations[i] = m_Source->GetClockCalibration(i);
+        }
+
+        m_Events.clear();
+        ResolveRanges(
+            std::span<const std::uint64_t>{m_Timestamps.data(), frame.m_NumQueries},
+            frame.m_Ranges, firstQuery, m_Calibrations, m_TimelineIndex, m_Events);
+
+        GpuFrameStats stats{};
+        stats.m_FrameIndex = frame.m_FrameIndex;
+        stats.m_CpuTime = (frame.m_CpuEndTime - frame.m_CpuBeginTime) * 1e-6;
+        stats.m_NumRanges = static_cast<std::uint32_t>(m_Events.size());
+        if (!m_Events.empty()) {
+            std::uint64_t gpuBegin = ~0ull;
+            std::uint64_t gpuEnd = 0;
+            for (const auto& event : m_Events) {
+                gpuBegin = (std::min)(gpuBegin, event.m_BeginTime);
+                gpuEnd = (std::max)(gpuEnd, event.m_EndTime);
+                g_Profiler.RecordTimelineEvent(m_TimelineIndex, event);
+            }
+            stats.m_GpuTime = (gpuEnd - gpuBegin) * 1e-6;
+            stats.m_Latency = gpuEnd > frame.m_CpuEndTime ? (gpuEnd - frame.m_CpuEndTime) * 1e-6 : 0;
+        }
+        m_LastFrameStats = stats;
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef __GPUPROFILER_H__
+#define __GPUPROFILER_H__
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "../Core/Profiler.h"
+
+namespace DSM {
+    // GPU 时间戳与 CPU 时间(分析器的纳秒)在同一时刻的对应关系
+    struct GpuClockCalibration
+    {
+        std::uint64_t m_GpuTimestamp{};
+        std::uint64_t m_CpuTimestamp{};
+        // GPU 时间戳每秒的计数
+        std::uint64_t m_Frequency{};
+    };
+
+    // 时间戳数据的来源，D3D12 下由 GpuTimestampQueryHeap 实现，测试时可提供合成的时间戳
+    class IGpuTimestampSource
+    {
+    public:
+        virtual ~IGpuTimestampSource() = default;
+        // 各队列的时间戳频率与校准可能不同，不支持的队列返回频率为 0 的校准
+        virtual GpuClockCalibration GetClockCalibration(std::uint32_t queue) = 0;
+        // 读取已解析到 CPU 可见内存的时间戳
+        virtual bool ReadTimestamps(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* timestamps) = 0;
+    };
+
+    // 一个 GPU 区间对应的两个查询
+    struct GpuTimestampRange
+    {
+        const char* m_Name{};
+        std::uint32_t m_BeginQuery{};
+        std::uint32_t m_EndQuery{};
+        std::uint32_t m_Depth{};
+        // 写入时间戳的队列，解析时使用该队列的时钟校准
+        std::uint32_t m_Queue{};
+    };
+
+    // 一段连续写入的查询
+    struct GpuQueryBatch
+    {
+        std::uint32_t m_FirstQuery{};
+        std::uint32_t m_NumQueries{};
+    };
+
+    // 单帧 GPU 与 CPU 时间的对比，单位为毫秒
+    struct GpuFrameStats
+    {
+        std::uint64_t m_FrameIndex{};
+        double m_GpuTime{};
+        double m_CpuTime{};
+        // CPU 结束提交到 GPU 完成该帧的延迟
+        double m_Latency{};
+        std::uint32_t m_NumRanges{};
+    };
+
+    // 管理每帧的 GPU 区间，并将解析得到的时间以 "GPU" 时间线写入 CPU 分析器
+    class GpuProfiler
+    {
+    public:
+        inline static constexpr std::uint32_t sm_InvalidQuery = ~0u;
+
+        GpuProfiler() = default;
+        ~GpuProfiler() = default;
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        // 每帧占用 maxQueriesPerFrame 个连续的查询
+        void Create(IGpuTimestampSource* source, std::uint32_t numFrames, std::uint32_t maxQueriesPerFrame);
+        void Shutdown();
+
+        // 开始新的一帧，该槽位之前的帧需已在 GPU 上完成，其结果会在此时解析
+        void BeginFrame(std::uint32_t frameIndex);
+        // 结束当前帧，返回需要解析的查询段，只包含实际写入过的查询
+        std::span<const GpuQueryBatch> EndFrame();
+
+        // 返回起始查询的索引，不在帧内或查询用尽时返回 sm_InvalidQuery
+        std::uint32_t BeginRange(const char* name, std::uint32_t depth, std::uint32_t queue = 0);
+        // 返回结束查询的索引
+        std::uint32_t EndRange(std::uint32_t beginQuery);
+
+        std::uint32_t GetFrameFirstQuery(std::uint32_t frameIndex) const noexcept { return frameIndex * m_MaxQueriesPerFrame; }
+        std::uint32_t GetMaxQueriesPerFrame() const noexcept { return m_MaxQueriesPerFrame; }
+        const GpuFrameStats& GetLastFrameStats() const noexcept { return m_LastFrameStats; }
+        bool IsCreated() const noexcept { return m_Source != nullptr; }
+
+        // 将一组时间戳按区间转换为分析器的事件，区间使用 calibrations[m_Queue] 换算，无效的区间会被跳过
+        static void ResolveRanges(
+            std::span<const std::uint64_t> timestamps,
+            std::span<const GpuTimestampRange> ranges,
+            std::uint32_t firstQuery,
+            std::span<const GpuClockCalibration> calibrations,
+            std::uint32_t timelineIndex,
+            std::vector<ProfileEvent>& events);
+        // GPU 时间戳转换为分析器的 CPU 时间
+        static std::uint64_t GpuToCpuTime(std::uint64_t gpuTimestamp, const GpuClockCalibration& calibration) noexcept;
+
+    private:
+        struct FrameData
+        {
+            std::vector<GpuTimestampRange> m_Ranges{};
+            std::uint32_t m_NumQueries{};
+            std::uint64_t m_FrameIndex{};
+            std::uint64_t m_CpuBeginTime{};
+            std::uint64_t m_CpuEndTime{};
+            bool m_Pending = false;
+        };
+
+        void ResolveFrame(std::uint32_t frameIndex);
+
+    private:
+        IGpuTimestampSource* m_Source{};
+        std::uint32_t m_MaxQueriesPerFrame{};
+        std::uint32_t m_TimelineIndex{};
+
+        std::mutex m_Mutex{};
+        std::vector<FrameData> m_Frames{};
+        std::uint32_t m_CurrFrame{};
+        std::uint64_t m_FrameCount{};
+        bool m_InFrame = false;
+
+        std::vector<GpuQueryBatch> m_Batches{};
+        std::vector<std::uint64_t> m_Timestamps{};
+        std::vector<GpuClockCalibration> m_Calibrations{};
+        std::vector<ProfileEvent> m_Events{};
+        GpuFrameStats m_LastFrameStats{};
+    };
+}
+
+#endif
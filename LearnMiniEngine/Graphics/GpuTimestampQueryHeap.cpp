@@ -0,0 +1,96 @@
+#include "GpuTimestampQueryHeap.h"
+#include "CommandQueue.h"
+#include <cstring>
+
+namespace DSM {
+    void GpuTimestampQueryHeap::Create(ID3D12Device* device, std::span<CommandQueue* const> queues, std::uint32_t numQueries)
+    {
+        ASSERT(device != nullptr && numQueries > 0 && !queues.empty());
+        ASSERT(!IsCreated());
+
+        D3D12_QUERY_HEAP_DESC heapDesc{};
+        heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        heapDesc.Count = numQueries;
+        heapDesc.NodeMask = 1;
+        ASSERT_SUCCEEDED(device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(m_QueryHeap.GetAddressOf())));
+        m_QueryHeap->SetName(L"GpuTimestampQueryHeap");
+
+        m_ReadbackBuffer.Create(L"Timestamp Readback Buffer",
+            GetReadBackBufferDesc(numQueries * sizeof(std::uint64_t), sizeof(std::uint64_t)));
+
+        m_NumQueries = numQueries;
+        m_Queues.assign(queues.begin(), queues.end());
+        m_Frequencies.resize(queues.size());
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            ASSERT(queues[i]->GetType() != D3D12_COMMAND_LIST_TYPE_COPY, "Copy queues need a COPY_QUEUE_TIMESTAMP heap");
+            ASSERT_SUCCEEDED(queues[i]->GetCommandQueue()->GetTimestampFrequency(&m_Frequencies[i]));
+        }
+    }
+
+    void GpuTimestampQueryHeap::Shutdown()
+    {
+        m_ReadbackBuffer.Destroy();
+        m_QueryHeap = nullptr;
+        m_Queues.clear();
+        m_Frequencies.clear();
+        m_NumQueries = 0;
+    }
+
+    std::uint32_t GpuTimestampQueryHeap::GetQueueIndex(D3D12_COMMAND_LIST_TYPE type) const noexcept
+    {
+        for (std::size_t i = 0; i < m_Queues.size(); ++i) {
+            if (m_Queues[i]->GetType() == type) return static_cast<std::uint32_t>(i);
+        }
+        return GpuProfiler::sm_InvalidQuery;
+    }
+
+    void GpuTimestampQueryHeap::EndQuery(ID3D12GraphicsCommandList* cmdList, std::uint32_t queryIndex)
+    {
+        ASSERT(queryIndex < m_NumQueries);
+        cmdList->EndQuery(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, queryIndex);
+    }
+
+    void GpuTimestampQueryHeap::ResolveQueries(ID3D12GraphicsCommandList* cmdList, std::uint32_t firstQuery, std::uint32_t numQueries)
+    {
+        ASSERT(firstQuery + numQueries <= m_NumQueries);
+        cmdList->ResolveQueryData(
+            m_QueryHeap.Get(),
+            D3D12_QUERY_TYPE_TIMESTAMP,
+            firstQuery, numQueries,
+            m_ReadbackBuffer.GetResource(),
+            firstQuery * sizeof(std::uint64_t));
+    }
+
+    GpuClockCalibration GpuTimestampQueryHeap::GetClockCalibration(std::uint32_t queue)
+    {
+        GpuClockCalibration calibration{};
+        if (queue >= m_Queues.size()) return calibration;
+        calibration.m_Frequency = m_Frequencies[queue];
+
+        std::uint64_t cpuCounter{};
+        ASSERT_SUCCEEDED(m_Queues[queue]->GetCommandQueue()->GetClockCalibration(&calibration.m_GpuTimestamp, &cpuCounter));
+
+        // 校准得到的 CPU 时间为 QPC 计数，以当前时刻为参照换算到分析器的时间
+        LARGE_INTEGER counterNow{};
+        LARGE_INTEGER counterFrequency{};
+        QueryPerformanceCounter(&counterNow);
+        QueryPerformanceFrequency(&counterFrequency);
+        auto profilerNow = Profiler::GetTimestamp();
+        auto elapsed = static_cast<std::uint64_t>(counterNow.QuadPart) - cpuCounter;
+        auto elapsedNs = static_cast<std::uint64_t>(elapsed * 1e9 / counterFrequency.QuadPart);
+        calibration.m_CpuTimestamp = profilerNow > elapsedNs ? profilerNow - elapsedNs : 0;
+
+        return calibration;
+    }
+
+    bool GpuTimestampQueryHeap::ReadTimestamps(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* timestamps)
+    {
+        if (!IsCreated() || firstQuery + numQueries > m_NumQueries) return false;
+
+        auto data = m_ReadbackBuffer.GetMappedData<std::uint64_t>();
+        if (data == nullptr) return false;
+
+        std::memcpy(timestamps, data + firstQuery, numQueries * sizeof(std::uint64_t));
+        return true;
+    }
+}
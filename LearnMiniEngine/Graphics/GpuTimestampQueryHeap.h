@@ -0,0 +1,46 @@
+#pragma once
+#ifndef __GPUTIMESTAMPQUERYHEAP_H__
+#define __GPUTIMESTAMPQUERYHEAP_H__
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "GpuProfiler.h"
+#include "Resource/GpuBuffer.h"
+
+namespace DSM {
+    class CommandQueue;
+
+    // 时间戳查询堆及其回读缓冲区
+    class GpuTimestampQueryHeap : public IGpuTimestampSource
+    {
+    public:
+        GpuTimestampQueryHeap() = default;
+        ~GpuTimestampQueryHeap() { Shutdown(); }
+        DSM_NONCOPYABLE(GpuTimestampQueryHeap);
+
+        // queues 为会写入时间戳的队列，其下标即 GpuTimestampRange::m_Queue，频率与校准按队列分别获取
+        void Create(ID3D12Device* device, std::span<CommandQueue* const> queues, std::uint32_t numQueries);
+        void Shutdown();
+
+        void EndQuery(ID3D12GraphicsCommandList* cmdList, std::uint32_t queryIndex);
+        // 把查询结果写入回读缓冲区
+        void ResolveQueries(ID3D12GraphicsCommandList* cmdList, std::uint32_t firstQuery, std::uint32_t numQueries);
+
+        virtual GpuClockCalibration GetClockCalibration(std::uint32_t queue) override;
+        virtual bool ReadTimestamps(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* timestamps) override;
+
+        bool IsCreated() const noexcept { return m_QueryHeap != nullptr; }
+        // 返回该类型命令列表所在队列的下标，没有对应的队列时返回 GpuProfiler::sm_InvalidQuery
+        std::uint32_t GetQueueIndex(D3D12_COMMAND_LIST_TYPE type) const noexcept;
+        std::uint32_t GetNumQueries() const noexcept { return m_NumQueries; }
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_QueryHeap{};
+        GpuBuffer m_ReadbackBuffer{};
+        std::vector<CommandQueue*> m_Queues{};
+        std::vector<std::uint64_t> m_Frequencies{};
+        std::uint32_t m_NumQueries{};
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include "RenderContext.h"
 #include "RootSignature.h"
 #include "../Utilities/Hash.h"
+#include "../Core/Profiler.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -107,6 +108,7 @@ namespace DSM {
 
     void GraphicsPSO::Finalize()
     {
+        PROFILE_SCOPE("GraphicsPSO::Finalize");
         m_PSODesc.pRootSignature = m_pRootSignature->GetRootSignature();
         ASSERT(m_PSODesc.pRootSignature != nullptr);
 
@@ -150,6 +152,7 @@ namespace DSM {
 
     void ComputePSO::Finalize()
     {
+        PROFILE_SCOPE("ComputePSO::Finalize");
         m_PSODesc.pRootSignature = m_pRootSignature->GetRootSignature();
         ASSERT(m_PSODesc.pRootSignature != nullptr);
 
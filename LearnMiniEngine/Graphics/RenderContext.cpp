@@ -82,6 +82,7 @@ namespace DSM {
             }
             maxSize = dxgiDesc.DedicatedVideoMemory;
             m_pDevice = device;
+            dxgiAdapter.As(&m_pAdapter);
 
             Utility::Print(L"Selected GPU:  {} ({} MB)\n", dxgiDesc.Description, dxgiDesc.DedicatedVideoMemory >> 20);
         }
@@ -96,6 +97,7 @@ namespace DSM {
             Utility::Print("Failed to find a hardware adapter.  Falling back to WARP.\n");
             ASSERT_SUCCEEDED(m_pFactory->EnumWarpAdapter(IID_PPV_ARGS(dxgiAdapter.GetAddressOf())));
             ASSERT_SUCCEEDED(D3D12CreateDevice(dxgiAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(m_pDevice.GetAddressOf())));
+            dxgiAdapter.As(&m_pAdapter);
         }
 
         D3D12_FEATURE_DATA_D3D12_OPTIONS featureData = {};
@@ -128,6 +130,27 @@ namespace DSM {
             m_DescriptorAllocator[i] = std::make_unique<DescriptorAllocator>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
         }
         
+        FrameSchedulerDesc frameDesc{};
+        frameDesc.m_NumFramesInFlight = sm_NumFramesInFlight;
+        frameDesc.m_TransientBufferSize = sm_FrameUploadBufferSize;
+        frameDesc.m_NumTransientDescriptors = sm_NumFrameDescriptors;
+        m_FrameScheduler.Create(frameDesc, &m_GraphicsQueue);
+
+        GpuBufferDesc uploadDesc{};
+        uploadDesc.m_Size = sm_FrameUploadBufferSize * sm_NumFramesInFlight;
+        uploadDesc.m_HeapType = D3D12_HEAP_TYPE_UPLOAD;
+        m_FrameUploadBuffer = std::make_unique<GpuBuffer>(L"Frame Upload Buffer", uploadDesc);
+        m_FrameUploadBuffer->Map();
+        m_FrameDescriptorHeap = std::make_unique<DescriptorHeap>(
+            L"Frame Descriptor Heap",
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+            sm_NumFrameDescriptors * sm_NumFramesInFlight);
+
+        // 查询堆中的时间戳来自图形与计算队列，下标即 GpuTimestampRange::m_Queue
+        CommandQueue* timestampQueues[] = {&m_GraphicsQueue, &m_ComputeQueue};
+        m_TimestampQueryHeap.Create(m_pDevice.Get(), timestampQueues, sm_MaxGpuTimestampsPerFrame * sm_NumFramesInFlight);
+        m_GpuProfiler.Create(&m_TimestampQueryHeap, sm_NumFramesInFlight, sm_MaxGpuTimestampsPerFrame);
+        
         SwapChainDesc swapChainDesc = {};
         swapChainDesc.m_Width = window.GetWidth();
         swapChainDesc.m_Height = window.GetHeight();
@@ -137,13 +160,30 @@ namespace DSM {
         m_SwapChain = std::make_unique<SwapChain>(swapChainDesc);
 
         Graphics::InitializeCommon();
+
+        // 接近预算时先释放分配器中空闲的页
+        m_MemoryPressureCallback = g_MemoryTracker.AddPressureCallback([this](const MemoryBudgetStatus& status) {
+            if (status.m_Category == MemoryCategory::kNumCategories && status.m_Pressure != MemoryPressure::kNone) {
+                TrimAllocators();
+            }
+        });
     }
 
     void RenderContext::Shutdown()
     {
+        g_MemoryTracker.RemovePressureCallback(m_MemoryPressureCallback);
+
+        // 需在命令队列销毁前等待所有帧完成
+        m_FrameScheduler.Shutdown();
+        m_FrameUploadBuffer = nullptr;
+        m_FrameDescriptorHeap = nullptr;
+        m_GpuProfiler.Shutdown();
+        m_TimestampQueryHeap.Shutdown();
+
         Graphics::DestroyCommon();
         
         m_pFactory = nullptr;
+        m_pAdapter = nullptr;
         m_pDevice = nullptr;
 
         m_CpuBufferAllocator.Shutdown();
@@ -197,7 +237,7 @@ namespace DSM {
                 *ppAllocator = GetGraphicsQueue().RequestCommandAllocator(); break;
             }
             case D3D12_COMMAND_LIST_TYPE_COMPUTE: {
-                *ppAllocator = GetCommandQueue().RequestCommandAllocator(); break;
+                *ppAllocator = GetComputeQueue().RequestCommandAllocator(); break;
             }
             case D3D12_COMMAND_LIST_TYPE_COPY: {
                 *ppAllocator = GetCopyQueue().RequestCommandAllocator(); break;
@@ -209,6 +249,62 @@ namespace DSM {
             1, listType, *ppAllocator, nullptr, IID_PPV_ARGS(ppList)));
     }
 
+    void RenderContext::BeginFrame()
+    {
+        // 该槽位的帧已完成，GpuProfiler 可以读取其时间戳
+        m_GpuProfiler.BeginFrame(m_FrameScheduler.BeginFrame());
+    }
+
+    void RenderContext::EndFrame()
+    {
+        // 帧栅栏需覆盖计算队列上的工作，该帧的临时资源才能在栅栏完成后回收
+        m_GraphicsQueue.StallForProducer(m_ComputeQueue);
+        if (auto batches = m_GpuProfiler.EndFrame(); !batches.empty()) {
+            CommandList cmdList{L"Resolve Timestamps"};
+            for (const auto& batch : batches) {
+                m_TimestampQueryHeap.ResolveQueries(cmdList.GetCommandList(), batch.m_FirstQuery, batch.m_NumQueries);
+            }
+            cmdList.ExecuteCommandList();
+        }
+        m_FrameScheduler.EndFrame(m_GraphicsQueue.IncrementFence());
+
+        if (m_pAdapter != nullptr) {
+            DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo{};
+            if (SUCCEEDED(m_pAdapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo))) {
+                g_MemoryTracker.SetDeviceBudget(memoryInfo.Budget);
+            }
+        }
+        g_MemoryTracker.Update();
+    }
+
+    void RenderContext::TrimAllocators()
+    {
+        m_CpuBufferAllocator.Trim();
+        m_GpuBufferAllocator.Trim();
+        GpuResource::TrimAllocators();
+    }
+
+    GpuResourceLocation RenderContext::AllocateFrameUpload(std::uint64_t size, std::uint32_t alignment)
+    {
+        auto offset = m_FrameScheduler.AllocateTransient(size, alignment);
+        if (offset == FrameScheduler::sm_InvalidTransientOffset) return {};
+
+        GpuResourceLocation location{};
+        location.m_Resource = m_FrameUploadBuffer.get();
+        location.m_GpuAddress = m_FrameUploadBuffer->GetGpuVirtualAddress() + offset;
+        location.m_MappedAddress = m_FrameUploadBuffer->GetMappedData<std::uint8_t>() + offset;
+        location.m_Offset = offset;
+        location.m_Size = size;
+        return location;
+    }
+
+    DescriptorHandle RenderContext::AllocateFrameDescriptors(std::uint32_t count)
+    {
+        auto index = m_FrameScheduler.AllocateTransientDescriptors(count);
+        if (index == FrameScheduler::sm_InvalidTransientDescriptor) return {};
+        return (*m_FrameDescriptorHeap)[index];
+    }
+
     void RenderContext::IdleGPU()
     {
         m_GraphicsQueue.WaitForIdle();
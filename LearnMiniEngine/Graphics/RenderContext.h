@@ -7,6 +7,10 @@
 #include "CommandQueue.h"
 #include "Resource/DynamicBufferAllocator.h"
 #include "SwapChain.h"
+#include "FrameScheduler.h"
+#include "GpuTimestampQueryHeap.h"
+#include "DescriptorHeap.h"
+#include "Resource/GpuBuffer.h"
 
 namespace DSM {
     class Window;
@@ -54,11 +58,29 @@ namespace DSM {
             return GetCommandQueue(D3D12_COMMAND_LIST_TYPE(fenceValue >> QUEUE_TYPE_MOVEBITS)).IsFenceComplete(fenceValue);
         }
 
+        // 等待帧槽位可用并回收该帧的临时资源
+        void BeginFrame();
+        // 在图形队列上发出该帧的栅栏
+        void EndFrame();
+        FrameScheduler& GetFrameScheduler() noexcept { return m_FrameScheduler; }
+        std::uint32_t GetFrameIndex() const noexcept { return m_FrameScheduler.GetFrameIndex(); }
+        // 从当前帧的上传缓冲区中分配，该帧的 GPU 工作完成后自动回收，空间不足时 m_Resource 为空
+        // 只能在 BeginFrame 与 EndFrame 之间由主线程调用，使用它的命令列表需在 EndFrame 前提交
+        GpuResourceLocation AllocateFrameUpload(std::uint64_t size, std::uint32_t alignment = 0);
+        // 从当前帧的着色器可见描述符中分配，不足时返回无效的句柄，限制同上
+        DescriptorHandle AllocateFrameDescriptors(std::uint32_t count = 1);
+        DescriptorHeap& GetFrameDescriptorHeap() noexcept { return *m_FrameDescriptorHeap; }
+
+        GpuProfiler& GetGpuProfiler() noexcept { return m_GpuProfiler; }
+        GpuTimestampQueryHeap& GetTimestampQueryHeap() noexcept { return m_TimestampQueryHeap; }
+
         void CleanupDynamicBuffer(std::uint64_t fenceValue)
         {
             m_CpuBufferAllocator.Cleanup(fenceValue);
             m_GpuBufferAllocator.Cleanup(fenceValue);
         }
+        // 释放各个分配器中空闲的页
+        void TrimAllocators();
 
     public:
         inline static bool sm_bTypedUAVLoadSupport_R11G11B10_FLOAT = false;
@@ -66,10 +88,19 @@ namespace DSM {
 
         inline static constexpr std::uint64_t sm_GpuAllocatorPageSize = DEFAULT_BUFFER_PAGE_SIZE / 2;
         inline static constexpr std::uint64_t sm_CpuBufferPageSize = 0x200000;
+
+        // 需在 Create 前设置
+        inline static std::uint32_t sm_NumFramesInFlight = 2;
+        inline static std::uint64_t sm_FrameUploadBufferSize = 0x200000;
+        inline static std::uint32_t sm_NumFrameDescriptors = 1024;
+        // 每帧可用的时间戳查询数，每个 GPU 区间占用两个
+        inline static std::uint32_t sm_MaxGpuTimestampsPerFrame = 512;
         
     private:
         Microsoft::WRL::ComPtr<ID3D12Device5> m_pDevice{};
         Microsoft::WRL::ComPtr<IDXGIFactory7> m_pFactory{};
+        // 用于查询驱动给出的显存预算
+        Microsoft::WRL::ComPtr<IDXGIAdapter3> m_pAdapter{};
 
         CommandQueue m_GraphicsQueue;
         CommandQueue m_ComputeQueue;
@@ -84,6 +115,16 @@ namespace DSM {
 
         std::array<std::unique_ptr<DescriptorAllocator>, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> m_DescriptorAllocator;
 
+        // 控制同时执行的帧数，每帧的临时资源按帧索引划分
+        FrameScheduler m_FrameScheduler;
+        std::unique_ptr<GpuBuffer> m_FrameUploadBuffer{};
+        std::unique_ptr<DescriptorHeap> m_FrameDescriptorHeap{};
+
+        // GPU 计时
+        GpuTimestampQueryHeap m_TimestampQueryHeap;
+        GpuProfiler m_GpuProfiler;
+
+        std::uint32_t m_MemoryPressureCallback{};
     };
 
     
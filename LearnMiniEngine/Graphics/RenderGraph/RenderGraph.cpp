@@ -0,0 +1,463 @@
+#include "RenderGraph.h"
+#include "../RenderContext.h"
+#include "../CommandList/GraphicsCommandList.h"
+#include "../CommandList/ComputeCommandList.h"
+#include "../Resource/GpuResourceAllocator.h"
+#include "../../Utilities/Utility.h"
+#include "../../Core/Profiler.h"
+
+namespace DSM {
+    namespace {
+        bool IsRenderTargetOrDepth(const D3D12_RESOURCE_DESC& desc) noexcept
+        {
+            return desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+        }
+
+        // 结构体中有填充，逐个成员比较
+        bool IsSameDesc(const D3D12_RESOURCE_DESC& a, const D3D12_RESOURCE_DESC& b) noexcept
+        {
+            return a.Dimension == b.Dimension && a.Alignment == b.Alignment &&
+                a.Width == b.Width && a.Height == b.Height &&
+                a.DepthOrArraySize == b.DepthOrArraySize && a.MipLevels == b.MipLevels &&
+                a.Format == b.Format && a.SampleDesc.Count == b.SampleDesc.Count &&
+                a.SampleDesc.Quality == b.SampleDesc.Quality && a.Layout == b.Layout && a.Flags == b.Flags;
+        }
+
+        bool IsSameClearValue(const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE& a, const D3D12_CLEAR_VALUE& b) noexcept
+        {
+            if (a.Format != b.Format) return false;
+            if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) {
+                return a.DepthStencil.Depth == b.DepthStencil.Depth && a.DepthStencil.Stencil == b.DepthStencil.Stencil;
+            }
+            return std::equal(std::begin(a.Color), std::end(a.Color), std::begin(b.Color));
+        }
+    }
+
+    //
+    // RenderGraphBuilder Implementation
+    //
+    RGTextureHandle RenderGraphBuilder::CreateTexture(const std::wstring& name, const TextureDesc& desc, const D3D12_CLEAR_VALUE* clearValue)
+    {
+        RenderGraph::ResourceNode node{};
+        node.m_Name = name;
+        node.m_Desc.Dimension = desc.m_Dimension;
+        node.m_Desc.Flags = desc.m_Flags;
+        node.m_Desc.Format = desc.m_Format;
+        node.m_Desc.Width = desc.m_Width;
+        node.m_Desc.Height = desc.m_Height;
+        node.m_Desc.DepthOrArraySize = desc.m_DepthOrArraySize;
+        node.m_Desc.MipLevels = desc.m_MipLevels;
+        node.m_Desc.SampleDesc = desc.m_SampleDesc;
+        node.m_Desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        if (clearValue != nullptr) {
+            node.m_HasClearValue = true;
+            node.m_ClearValue = *clearValue;
+        }
+
+        auto allocInfo = g_RenderContext.GetDevice()->GetResourceAllocationInfo(0, 1, &node.m_Desc);
+        RGResourceDesc resourceDesc{};
+        resourceDesc.m_Name = Utility::WStringToUTF8(name);
+        resourceDesc.m_Size = allocInfo.SizeInBytes;
+        resourceDesc.m_Alignment = allocInfo.Alignment;
+        // 不支持资源堆第二层级的设备上，渲染目标与其他纹理不能放在同一个堆中
+        resourceDesc.m_HeapGroup = IsRenderTargetOrDepth(node.m_Desc) ? RenderGraph::kRenderTargetHeap : RenderGraph::kTextureHeap;
+
+        auto& graph = m_Graph;
+        graph.m_ResourceDescs.push_back(std::move(resourceDesc));
+        graph.m_Resources.push_back(std::move(node));
+        return RGTextureHandle{static_cast<std::uint32_t>(graph.m_Resources.size() - 1)};
+    }
+
+    RGTextureHandle RenderGraphBuilder::Read(RGTextureHandle texture, D3D12_RESOURCE_STATES state)
+    {
+        ASSERT(texture.IsValid());
+        ASSERT(m_Graph.m_PassDescs[m_Pass].m_Queue != RGQueue::kCompute || RenderGraphCompiler::IsComputeQueueState(state),
+            "Async compute pass cannot use graphics states");
+        m_Graph.m_PassDescs[m_Pass].m_Accesses.push_back({texture.m_Index, static_cast<std::uint32_t>(state), false});
+        return texture;
+    }
+
+    RGTextureHandle RenderGraphBuilder::Write(RGTextureHandle texture, D3D12_RESOURCE_STATES state)
+    {
+        ASSERT(texture.IsValid());
+        ASSERT(m_Graph.m_PassDescs[m_Pass].m_Queue != RGQueue::kCompute || RenderGraphCompiler::IsComputeQueueState(state),
+            "Async compute pass cannot use graphics states");
+        m_Graph.m_PassDescs[m_Pass].m_Accesses.push_back({texture.m_Index, static_cast<std::uint32_t>(state), true});
+        return texture;
+    }
+
+    void RenderGraphBuilder::SetSideEffects()
+    {
+        m_Graph.m_PassDescs[m_Pass].m_HasSideEffects = true;
+    }
+
+
+    //
+    // RenderGraph Implementation
+    //
+    RGTextureHandle RenderGraph::ImportTexture(
+        const std::wstring& name,
+        Texture& texture,
+        const RGTextureViews& views,
+        std::optional<D3D12_RESOURCE_STATES> finalState)
+    {
+        RGResourceDesc resourceDesc{};
+        resourceDesc.m_Name = Utility::WStringToUTF8(name);
+        resourceDesc.m_Imported = true;
+        resourceDesc.m_InitialState = texture.GetUsageState();
+        resourceDesc.m_HasFinalState = finalState.has_value();
+        resourceDesc.m_FinalState = finalState.value_or(D3D12_RESOURCE_STATE_COMMON);
+
+        ResourceNode node{};
+        node.m_Name = name;
+        node.m_Texture = &texture;
+        node.m_Views = views;
+
+        m_ResourceDescs.push_back(std::move(resourceDesc));
+        m_Resources.push_back(std::move(node));
+        return RGTextureHandle{static_cast<std::uint32_t>(m_Resources.size() - 1)};
+    }
+
+    void RenderGraph::AddPass(const std::string& name, const SetupFunc& setup, ExecuteFunc execute)
+    {
+        ASSERT(!m_Compiled, "Cannot add pass after compile!");
+
+        auto& passDesc = m_PassDescs.emplace_back();
+        passDesc.m_Name = name;
+        m_PassExecutes.push_back(std::move(execute));
+        m_ComputeExecutes.emplace_back();
+
+        RenderGraphBuilder builder{*this, static_cast<std::uint32_t>(m_PassDescs.size() - 1)};
+        setup(builder);
+    }
+
+    void RenderGraph::AddAsyncComputePass(const std::string& name, const SetupFunc& setup, ComputeExecuteFunc execute)
+    {
+        ASSERT(!m_Compiled, "Cannot add pass after compile!");
+
+        auto& passDesc = m_PassDescs.emplace_back();
+        passDesc.m_Name = name;
+        passDesc.m_Queue = sm_EnableAsyncCompute ? RGQueue::kCompute : RGQueue::kGraphics;
+        m_PassExecutes.emplace_back();
+        m_ComputeExecutes.push_back(std::move(execute));
+
+        RenderGraphBuilder builder{*this, static_cast<std::uint32_t>(m_PassDescs.size() - 1)};
+        setup(builder);
+    }
+
+    void RenderGraph::Compile()
+    {
+        PROFILE_SCOPE("RenderGraph::Compile");
+
+        m_Compiler.Compile(m_ResourceDescs, m_PassDescs, m_Plan);
+        AllocateTransientTextures();
+        m_Compiled = true;
+    }
+
+    void RenderGraph::Execute(GraphicsCommandList& cmdList)
+    {
+        if (!m_Compiled) {
+            Compile();
+        }
+
+        auto hasAsyncCompute = std::any_of(m_Plan.m_Schedules.begin(), m_Plan.m_Schedules.end(),
+            [](const RGPassSchedule& schedule) { return schedule.m_Queue == RGQueue::kCompute; });
+        if (hasAsyncCompute && m_AsyncComputeList == nullptr) {
+            m_AsyncComputeList = std::make_unique<ComputeCommandList>(L"RenderGraph AsyncCompute", true);
+        }
+        m_PassFences.assign(m_Plan.m_PassOrder.size(), 0);
+
+        // 第一次在计算队列上使用的资源由图形队列转换
+        ApplyBarriers(cmdList, m_Plan.m_InitialBarriers);
+        std::uint64_t initialFence = 0;
+        if (m_Plan.m_SignalInitial) {
+            initialFence = cmdList.ExecuteCommandList();
+        }
+
+        for (std::size_t i = 0; i < m_Plan.m_PassOrder.size(); ++i) {
+            const auto& schedule = m_Plan.m_Schedules[i];
+            auto async = schedule.m_Queue == RGQueue::kCompute;
+            CommandList& passList = async ? static_cast<CommandList&>(*m_AsyncComputeList) : cmdList;
+
+            if (schedule.m_WaitPass != RenderGraphCompiler::sm_InvalidIndex || schedule.m_WaitInitial) {
+                // 之前录制的命令先提交，不需要跟着等待
+                passList.ExecuteCommandList();
+                auto& queue = g_RenderContext.GetCommandQueue(async ? D3D12_COMMAND_LIST_TYPE_COMPUTE : D3D12_COMMAND_LIST_TYPE_DIRECT);
+                queue.StallForFence(schedule.m_WaitInitial ? initialFence : m_PassFences[schedule.m_WaitPass]);
+            }
+
+            // 该 Pass 需要的屏障一次性提交
+            const auto& barriers = m_Plan.m_PassBarriers[i];
+            ApplyBarriers(passList, barriers);
+
+            // 复用内存的渲染目标第一次被写入时内容未定义，需要先丢弃
+            for (const auto& barrier : barriers) {
+                if (async || barrier.m_Type != RGBarrierType::kAliasing) continue;
+                const auto& node = m_Resources[barrier.m_Resource];
+                if (m_Plan.m_Placements[barrier.m_Resource].m_FirstAccessIsWrite && IsRenderTargetOrDepth(node.m_Desc)) {
+                    cmdList.DiscardResource(*node.m_Texture);
+                }
+            }
+
+            auto pass = m_Plan.m_PassOrder[i];
+            if (m_ComputeExecutes[pass]) {
+                m_ComputeExecutes[pass](passList.GetComputeCommandList(), *this);
+            }
+            else {
+                m_PassExecutes[pass](cmdList, *this);
+            }
+
+            // 交给计算队列的资源在发出信号前转换
+            ApplyBarriers(cmdList, schedule.m_EndBarriers);
+            if (schedule.m_Signal) {
+                m_PassFences[i] = passList.ExecuteCommandList();
+            }
+        }
+
+        if (m_Plan.m_FinalWaitPass != RenderGraphCompiler::sm_InvalidIndex) {
+            cmdList.ExecuteCommandList();
+            g_RenderContext.GetGraphicsQueue().StallForFence(m_PassFences[m_Plan.m_FinalWaitPass]);
+        }
+        ApplyBarriers(cmdList, m_Plan.m_FinalBarriers);
+
+        Reset();
+    }
+
+    void RenderGraph::Reset()
+    {
+        m_ResourceDescs.clear();
+        m_Resources.clear();
+        m_PassDescs.clear();
+        m_PassExecutes.clear();
+        m_ComputeExecutes.clear();
+        m_Compiled = false;
+    }
+
+    void RenderGraph::Shutdown()
+    {
+        Reset();
+        m_AsyncComputeList = nullptr;
+        for (auto& texture : m_TransientTextures) {
+            ReleaseTransientTexture(texture, true);
+        }
+        m_TransientTextures.clear();
+        for (auto& heap : m_Heaps) {
+            ReleaseHeap(heap, true);
+        }
+    }
+
+    Texture& RenderGraph::GetTexture(RGTextureHandle texture)
+    {
+        ASSERT(texture.IsValid() && m_Resources[texture.m_Index].m_Texture != nullptr);
+        return *m_Resources[texture.m_Index].m_Texture;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE RenderGraph::GetRTV(RGTextureHandle texture) const
+    {
+        ASSERT(texture.IsValid() && m_Resources[texture.m_Index].m_Views.m_RTV.ptr != 0);
+        return m_Resources[texture.m_Index].m_Views.m_RTV;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE RenderGraph::GetDSV(RGTextureHandle texture) const
+    {
+        ASSERT(texture.IsValid() && m_Resources[texture.m_Index].m_Views.m_DSV.ptr != 0);
+        return m_Resources[texture.m_Index].m_Views.m_DSV;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE RenderGraph::GetSRV(RGTextureHandle texture) const
+    {
+        ASSERT(texture.IsValid() && m_Resources[texture.m_Index].m_Views.m_SRV.ptr != 0);
+        return m_Resources[texture.m_Index].m_Views.m_SRV;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE RenderGraph::GetUAV(RGTextureHandle texture) const
+    {
+        ASSERT(texture.IsValid() && m_Resources[texture.m_Index].m_Views.m_UAV.ptr != 0);
+        return m_Resources[texture.m_Index].m_Views.m_UAV;
+    }
+
+    void RenderGraph::AllocateTransientTextures()
+    {
+        auto frame = g_RenderContext.GetFrameScheduler().GetFrameCount();
+
+        // 长时间未使用的纹理不再保留
+        for (auto& texture : m_TransientTextures) {
+            if (frame - texture.m_LastUsedFrame > sm_UnusedFrames) {
+                ReleaseTransientTexture(texture, false);
+            }
+            texture.m_Used = false;
+        }
+
+        for (std::uint32_t group = 0; group < m_Plan.m_Heaps.size(); ++group) {
+            const auto& heapPlan = m_Plan.m_Heaps[group];
+            auto& heap = m_Heaps[group];
+            if (heapPlan.m_Size <= heap.m_Size && heapPlan.m_Alignment <= heap.m_Alignment) continue;
+
+            // 堆中的纹理随旧的堆一起释放
+            for (auto& texture : m_TransientTextures) {
+                if (texture.m_HeapGroup == group) {
+                    ReleaseTransientTexture(texture, false);
+                }
+            }
+            auto heapSize = (std::max)(heapPlan.m_Size, heap.m_Size);
+            auto heapAlignment = (std::max)(heapPlan.m_Alignment, heap.m_Alignment);
+            ReleaseHeap(heap, false);
+
+            DSMHeapDesc heapDesc{};
+            heapDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+            heapDesc.m_HeapFlags = group == kRenderTargetHeap ?
+                D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+            auto name = L"RenderGraph Heap" + std::to_wstring(group);
+            heap.m_Heap.Attach(GpuResourceAllocator::CreateHeap(heapDesc, heapSize, name,
+                heapAlignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : 0));
+            heap.m_Size = heapSize;
+            heap.m_Alignment = heapAlignment;
+            heap.m_MemoryAllocation = g_MemoryTracker.RecordAllocation(
+                MemoryCategory::kRenderTarget, heapSize, Utility::WStringToUTF8(name));
+        }
+        std::erase_if(m_TransientTextures, [](const TransientTexture& texture) { return texture.m_Texture == nullptr; });
+
+        std::array<bool, kNumHeapGroups> heapChanged{};
+        for (std::size_t i = 0; i < m_Resources.size(); ++i) {
+            const auto& placement = m_Plan.m_Placements[i];
+            if (m_ResourceDescs[i].m_Imported || placement.m_HeapGroup == RenderGraphCompiler::sm_InvalidIndex) continue;
+
+            auto& node = m_Resources[i];
+            auto numTextures = m_TransientTextures.size();
+            auto& texture = FindOrCreateTransientTexture(node, placement);
+            heapChanged[placement.m_HeapGroup] |= m_TransientTextures.size() != numTextures;
+            texture.m_Used = true;
+            texture.m_LastUsedFrame = frame;
+            node.m_Texture = texture.m_Texture.get();
+            node.m_Views.m_RTV = texture.m_RTV;
+            node.m_Views.m_DSV = texture.m_DSV;
+            node.m_Views.m_SRV = texture.m_SRV;
+            node.m_Views.m_UAV = texture.m_UAV;
+        }
+
+        // 新创建的纹理可能覆盖了之前帧中其他纹理的内存，同一个堆中的纹理都需要重新初始化
+        for (std::uint32_t i = 0; i < m_Resources.size(); ++i) {
+            auto& placement = m_Plan.m_Placements[i];
+            if (m_ResourceDescs[i].m_Imported || placement.m_HeapGroup == RenderGraphCompiler::sm_InvalidIndex ||
+                placement.m_Aliased || !heapChanged[placement.m_HeapGroup]) continue;
+
+            auto& barriers = m_Plan.m_PassBarriers[placement.m_FirstPass];
+            barriers.insert(barriers.begin(), RGBarrier{RGBarrierType::kAliasing, i,
+                RenderGraphCompiler::sm_UnknownState, RenderGraphCompiler::sm_UnknownState});
+            placement.m_Aliased = true;
+            ++m_Plan.m_NumBarriers;
+        }
+    }
+
+    RenderGraph::TransientTexture& RenderGraph::FindOrCreateTransientTexture(const ResourceNode& node, const RGResourcePlacement& placement)
+    {
+        // 相同位置与描述的纹理可以直接复用，不需要重新创建资源与视图
+        for (auto& texture : m_TransientTextures) {
+            if (!texture.m_Used &&
+                texture.m_HeapGroup == placement.m_HeapGroup &&
+                texture.m_Offset == placement.m_Offset &&
+                texture.m_HasClearValue == node.m_HasClearValue &&
+                IsSameDesc(texture.m_Desc, node.m_Desc) &&
+                (!node.m_HasClearValue || IsSameClearValue(node.m_Desc, texture.m_ClearValue, node.m_ClearValue))) {
+                return texture;
+            }
+        }
+
+        auto& texture = m_TransientTextures.emplace_back();
+        texture.m_HeapGroup = placement.m_HeapGroup;
+        texture.m_Offset = placement.m_Offset;
+        texture.m_Desc = node.m_Desc;
+        texture.m_HasClearValue = node.m_HasClearValue;
+        texture.m_ClearValue = node.m_ClearValue;
+
+        ID3D12Resource* resource = nullptr;
+        ASSERT_SUCCEEDED(g_RenderContext.GetDevice()->CreatePlacedResource(
+            m_Heaps[placement.m_HeapGroup].m_Heap.Get(),
+            placement.m_Offset,
+            &node.m_Desc,
+            D3D12_RESOURCE_STATE_COMMON,
+            node.m_HasClearValue ? &node.m_ClearValue : nullptr,
+            IID_PPV_ARGS(&resource)));
+        // 显存已经由堆统计
+        texture.m_Texture = std::make_unique<Texture>();
+        texture.m_Texture->Create(node.m_Name, resource, false, false);
+
+        auto flags = node.m_Desc.Flags;
+        if (flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) {
+            texture.m_RTV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+            texture.m_Texture->CreateRenderTargetView(texture.m_RTV);
+        }
+        if (flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) {
+            texture.m_DSV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+            texture.m_Texture->CreateDepthStencilView(texture.m_DSV);
+        }
+        if (!(flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE)) {
+            texture.m_SRV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            texture.m_Texture->CreateShaderResourceView(texture.m_SRV);
+        }
+        if (flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) {
+            texture.m_UAV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            texture.m_Texture->CreateUnorderedAccessView(texture.m_UAV);
+        }
+
+        return texture;
+    }
+
+    void RenderGraph::ReleaseTransientTexture(TransientTexture& texture, bool immediate)
+    {
+        if (texture.m_Texture == nullptr) return;
+
+        std::shared_ptr<Texture> oldTexture = std::move(texture.m_Texture);
+        auto release = [oldTexture, rtv = texture.m_RTV, dsv = texture.m_DSV, srv = texture.m_SRV, uav = texture.m_UAV]() {
+            oldTexture->Destroy();
+            if (rtv.IsValid()) g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, rtv);
+            if (dsv.IsValid()) g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, dsv);
+            if (srv.IsValid()) g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, srv);
+            if (uav.IsValid()) g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, uav);
+        };
+        if (immediate) {
+            release();
+        }
+        else {
+            g_RenderContext.GetFrameScheduler().DeferRelease(std::move(release));
+        }
+    }
+
+    void RenderGraph::ApplyBarriers(CommandList& cmdList, std::span<const RGBarrier> barriers)
+    {
+        if (barriers.empty()) return;
+
+        for (const auto& barrier : barriers) {
+            auto& texture = *m_Resources[barrier.m_Resource].m_Texture;
+            switch (barrier.m_Type) {
+                case RGBarrierType::kAliasing:
+                    cmdList.InsertAliasBarrier(nullptr, texture);
+                    break;
+                case RGBarrierType::kTransition:
+                    cmdList.TransitionResource(texture, static_cast<D3D12_RESOURCE_STATES>(barrier.m_StateAfter));
+                    break;
+                case RGBarrierType::kUAV:
+                    cmdList.InsertUAVBarrier(texture);
+                    break;
+            }
+        }
+        cmdList.FlushResourceBarriers();
+    }
+
+    void RenderGraph::ReleaseHeap(TransientHeap& heap, bool immediate)
+    {
+        if (heap.m_Heap == nullptr) return;
+
+        auto release = [oldHeap = std::move(heap.m_Heap), allocation = heap.m_MemoryAllocation]() mutable {
+            oldHeap = nullptr;
+            g_MemoryTracker.RecordFree(allocation);
+        };
+        if (immediate) {
+            release();
+        }
+        else {
+            g_RenderContext.GetFrameScheduler().DeferRelease(std::move(release));
+        }
+        heap = {};
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+#ifndef __RENDERGRAPH_H__
+#define __RENDERGRAPH_H__
+
+#include "RenderGraphCompiler.h"
+#include "../DescriptorHeap.h"
+#include "../Resource/Texture.h"
+
+namespace DSM {
+    class CommandList;
+    class GraphicsCommandList;
+    class ComputeCommandList;
+    class RenderGraph;
+
+    struct RGTextureHandle
+    {
+        std::uint32_t m_Index = RenderGraphCompiler::sm_InvalidIndex;
+        bool IsValid() const noexcept { return m_Index != RenderGraphCompiler::sm_InvalidIndex; }
+    };
+
+    // 导入的纹理已有的视图，不使用的视图可以为空
+    struct RGTextureViews
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE m_RTV{};
+        D3D12_CPU_DESCRIPTOR_HANDLE m_DSV{};
+        D3D12_CPU_DESCRIPTOR_HANDLE m_SRV{};
+        D3D12_CPU_DESCRIPTOR_HANDLE m_UAV{};
+    };
+
+    // 在 Pass 的 setup 中声明该 Pass 使用的资源
+    class RenderGraphBuilder
+    {
+        friend class RenderGraph;
+    public:
+        DSM_NONCOPYABLE_NONMOVABLE(RenderGraphBuilder);
+
+        // 临时纹理只在本帧有效，生命周期不重叠的纹理共享同一块内存
+        RGTextureHandle CreateTexture(const std::wstring& name, const TextureDesc& desc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+        RGTextureHandle Read(RGTextureHandle texture, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        RGTextureHandle Write(RGTextureHandle texture, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_RENDER_TARGET);
+        // 没有写入其他 Pass 使用的资源时也不会被剔除
+        void SetSideEffects();
+
+    private:
+        RenderGraphBuilder(RenderGraph& graph, std::uint32_t pass)
+            :m_Graph(graph), m_Pass(pass) {}
+
+    private:
+        RenderGraph& m_Graph;
+        std::uint32_t m_Pass{};
+    };
+
+    // 每帧重新声明 Pass 与资源，编译后自动插入屏障并为临时纹理分配复用的内存
+    class RenderGraph
+    {
+        friend class RenderGraphBuilder;
+    public:
+        using SetupFunc = std::function<void(RenderGraphBuilder&)>;
+        using ExecuteFunc = std::function<void(GraphicsCommandList&, RenderGraph&)>;
+        using ComputeExecuteFunc = std::function<void(ComputeCommandList&, RenderGraph&)>;
+
+        RenderGraph() = default;
+        ~RenderGraph() { Shutdown(); }
+        DSM_NONCOPYABLE_NONMOVABLE(RenderGraph);
+
+        // finalState 为空时执行完毕后保持最后使用的状态
+        RGTextureHandle ImportTexture(
+            const std::wstring& name,
+            Texture& texture,
+            const RGTextureViews& views = {},
+            std::optional<D3D12_RESOURCE_STATES> finalState = std::nullopt);
+        void AddPass(const std::string& name, const SetupFunc& setup, ExecuteFunc execute);
+        // 在计算队列上与图形 Pass 重叠执行，资源只能使用计算队列支持的状态
+        // 跨队列的等待与计算队列无法执行的状态转换在编译时自动插入
+        void AddAsyncComputePass(const std::string& name, const SetupFunc& setup, ComputeExecuteFunc execute);
+
+        // 剔除无用的 Pass，分配临时纹理，需要在帧内调用
+        void Compile();
+        // 按顺序执行 Pass，执行后清除本帧声明的 Pass 与资源
+        void Execute(GraphicsCommandList& cmdList);
+        // 缓存的临时纹理与堆保留到之后的帧
+        void Reset();
+        // 立即释放所有的堆与临时纹理，调用前 GPU 需要执行完毕
+        void Shutdown();
+
+        Texture& GetTexture(RGTextureHandle texture);
+        D3D12_CPU_DESCRIPTOR_HANDLE GetRTV(RGTextureHandle texture) const;
+        D3D12_CPU_DESCRIPTOR_HANDLE GetDSV(RGTextureHandle texture) const;
+        D3D12_CPU_DESCRIPTOR_HANDLE GetSRV(RGTextureHandle texture) const;
+        D3D12_CPU_DESCRIPTOR_HANDLE GetUAV(RGTextureHandle texture) const;
+
+        const RenderGraphPlan& GetPlan() const noexcept { return m_Plan; }
+
+        // 超过该帧数未使用的临时纹理会被释放
+        inline static std::uint32_t sm_UnusedFrames = 8;
+        // 关闭时异步计算 Pass 在图形队列上按顺序执行
+        inline static bool sm_EnableAsyncCompute = true;
+
+    private:
+        enum HeapGroup : std::uint32_t
+        {
+            kRenderTargetHeap,
+            kTextureHeap,
+            kNumHeapGroups
+        };
+
+        struct ResourceNode
+        {
+            std::wstring m_Name{};
+            D3D12_RESOURCE_DESC m_Desc{};
+            bool m_HasClearValue = false;
+            D3D12_CLEAR_VALUE m_ClearValue{};
+            Texture* m_Texture{};
+            RGTextureViews m_Views{};
+        };
+
+        struct TransientTexture
+        {
+            std::uint32_t m_HeapGroup{};
+            std::uint64_t m_Offset{};
+            D3D12_RESOURCE_DESC m_Desc{};
+            bool m_HasClearValue = false;
+            D3D12_CLEAR_VALUE m_ClearValue{};
+            std::unique_ptr<Texture> m_Texture{};
+            DescriptorHandle m_RTV{};
+            DescriptorHandle m_DSV{};
+            DescriptorHandle m_SRV{};
+            DescriptorHandle m_UAV{};
+            std::uint64_t m_LastUsedFrame{};
+            // 本次编译中已经分配给了某个资源
+            bool m_Used = false;
+        };
+
+        struct TransientHeap
+        {
+            Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap{};
+            std::uint64_t m_Size{};
+            std::uint64_t m_Alignment{};
+            std::uint64_t m_MemoryAllocation = MemoryTracker::sm_InvalidAllocation;
+        };
+
+        // 创建或扩大堆，并为所有临时纹理找到放置在相同位置的缓存纹理
+        void AllocateTransientTextures();
+        TransientTexture& FindOrCreateTransientTexture(const ResourceNode& node, const RGResourcePlacement& placement);
+        void ReleaseTransientTexture(TransientTexture& texture, bool immediate);
+        void ReleaseHeap(TransientHeap& heap, bool immediate);
+        void ApplyBarriers(CommandList& cmdList, std::span<const RGBarrier> barriers);
+
+    private:
+        std::vector<RGResourceDesc> m_ResourceDescs{};
+        std::vector<ResourceNode> m_Resources{};
+        std::vector<RGPassDesc> m_PassDescs{};
+        // 与 m_PassDescs 对应，只有与 Pass 类型对应的一个有效
+        std::vector<ExecuteFunc> m_PassExecutes{};
+        std::vector<ComputeExecuteFunc> m_ComputeExecutes{};
+
+        RenderGraphCompiler m_Compiler{};
+        RenderGraphPlan m_Plan{};
+        bool m_Compiled = false;
+
+        std::array<TransientHeap, kNumHeapGroups> m_Heaps{};
+        std::vector<TransientTexture> m_TransientTextures{};
+
+        std::unique_ptr<ComputeCommandList> m_AsyncComputeList{};
+        // 与 m_PassOrder 对应，发出信号的 Pass 提交后的栅栏值
+        std::vector<std::uint64_t> m_PassFences{};
+    };
+}
+
+#endif
@@ -0,0 +1,347 @@
+#include "RenderGraphCompiler.h"
+#include <algorithm>
+#include <array>
+
+namespace DSM {
+    namespace {
+        std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment) noexcept
+        {
+            return alignment <= 1 ? value : (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    void RenderGraphCompiler::Compile(
+        std::span<const RGResourceDesc> resources,
+        std::span<const RGPassDesc> passes,
+        RenderGraphPlan& plan)
+    {
+        plan.m_PassOrder.clear();
+        plan.m_PassBarriers.clear();
+        plan.m_FinalBarriers.clear();
+        plan.m_Placements.assign(resources.size(), RGResourcePlacement{sm_InvalidIndex});
+        plan.m_Heaps.clear();
+        plan.m_Schedules.clear();
+        plan.m_InitialBarriers.clear();
+        plan.m_SignalInitial = false;
+        plan.m_FinalWaitPass = sm_InvalidIndex;
+        plan.m_NumQueueWaits = 0;
+        plan.m_NumBarriers = 0;
+        plan.m_UnaliasedSize = 0;
+
+        CullPasses(resources, passes, plan);
+        ComputeLifetimes(resources, passes, plan);
+        AllocateMemory(resources, plan);
+        BuildBarriers(resources, plan);
+        ScheduleQueues(resources, plan);
+    }
+
+    void RenderGraphCompiler::CullPasses(
+        std::span<const RGResourceDesc> resources,
+        std::span<const RGPassDesc> passes,
+        RenderGraphPlan& plan)
+    {
+        m_PassAlive.assign(passes.size(), false);
+        m_ResourceNeeded.assign(resources.size(), false);
+
+        // 从后向前，写入之后会被读取的资源或导入的资源的 Pass 才需要执行
+        for (auto i = static_cast<std::int64_t>(passes.size()) - 1; i >= 0; --i) {
+            const auto& pass = passes[i];
+            bool alive = pass.m_HasSideEffects;
+            for (const auto& access : pass.m_Accesses) {
+                if (alive) break;
+                alive = access.m_Write && (m_ResourceNeeded[access.m_Resource] || resources[access.m_Resource].m_Imported);
+            }
+            if (!alive) continue;
+
+            // 写入可能只覆盖部分内容，之前写入该资源的 Pass 同样需要保留
+            m_PassAlive[i] = true;
+            for (const auto& access : pass.m_Accesses) {
+                m_ResourceNeeded[access.m_Resource] = true;
+            }
+        }
+
+        for (std::uint32_t i = 0; i < passes.size(); ++i) {
+            if (m_PassAlive[i]) {
+                plan.m_PassOrder.push_back(i);
+                plan.m_Schedules.push_back({passes[i].m_Queue});
+            }
+        }
+        plan.m_PassBarriers.resize(plan.m_PassOrder.size());
+    }
+
+    void RenderGraphCompiler::ComputeLifetimes(
+        std::span<const RGResourceDesc> resources,
+        std::span<const RGPassDesc> passes,
+        RenderGraphPlan& plan)
+    {
+        if (m_ResourceAccesses.size() < resources.size()) {
+            m_ResourceAccesses.resize(resources.size());
+        }
+        for (std::size_t i = 0; i < resources.size(); ++i) {
+            m_ResourceAccesses[i].clear();
+        }
+
+        for (std::uint32_t order = 0; order < plan.m_PassOrder.size(); ++order) {
+            for (const auto& access : passes[plan.m_PassOrder[order]].m_Accesses) {
+                auto& accesses = m_ResourceAccesses[access.m_Resource];
+                // 同一 Pass 中的多次访问合并，读取的状态可以合并，写入时使用写入的状态
+                if (!accesses.empty() && accesses.back().m_Pass == order) {
+                    auto& last = accesses.back();
+                    if (access.m_Write) {
+                        last.m_State = access.m_State;
+                        last.m_Write = true;
+                    }
+                    else if (!last.m_Write) {
+                        last.m_State |= access.m_State;
+                    }
+                }
+                else {
+                    accesses.push_back({order, access.m_State, access.m_Write});
+                }
+            }
+        }
+
+        for (std::uint32_t i = 0; i < resources.size(); ++i) {
+            const auto& accesses = m_ResourceAccesses[i];
+            if (resources[i].m_Imported || accesses.empty()) continue;
+
+            auto& placement = plan.m_Placements[i];
+            placement.m_HeapGroup = resources[i].m_HeapGroup;
+            placement.m_FirstPass = accesses.front().m_Pass;
+            placement.m_LastPass = accesses.back().m_Pass;
+            placement.m_FirstAccessIsWrite = accesses.front().m_Write;
+            placement.m_UsedByAsyncCompute = std::any_of(accesses.begin(), accesses.end(), [&plan](const ResourceAccess& access) {
+                return plan.m_Schedules[access.m_Pass].m_Queue == RGQueue::kCompute;
+            });
+        }
+    }
+
+    void RenderGraphCompiler::AllocateMemory(std::span<const RGResourceDesc> resources, RenderGraphPlan& plan)
+    {
+        m_SortedResources.clear();
+        std::uint32_t numHeaps = 0;
+        for (std::uint32_t i = 0; i < resources.size(); ++i) {
+            if (plan.m_Placements[i].m_HeapGroup == sm_InvalidIndex) continue;
+            m_SortedResources.push_back(i);
+            numHeaps = (std::max)(numHeaps, resources[i].m_HeapGroup + 1);
+            plan.m_UnaliasedSize += AlignUp(resources[i].m_Size, resources[i].m_Alignment);
+        }
+        plan.m_Heaps.resize(numHeaps);
+
+        // 先放置大的资源，空隙更容易被小的资源填满
+        std::sort(m_SortedResources.begin(), m_SortedResources.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+            const auto& l = resources[lhs];
+            const auto& r = resources[rhs];
+            if (l.m_HeapGroup != r.m_HeapGroup) return l.m_HeapGroup < r.m_HeapGroup;
+            if (l.m_Size != r.m_Size) return l.m_Size > r.m_Size;
+            return plan.m_Placements[lhs].m_FirstPass < plan.m_Placements[rhs].m_FirstPass;
+        });
+
+        for (std::size_t begin = 0; begin < m_SortedResources.size();) {
+            auto group = resources[m_SortedResources[begin]].m_HeapGroup;
+            auto end = begin;
+            while (end < m_SortedResources.size() && resources[m_SortedResources[end]].m_HeapGroup == group) {
+                ++end;
+            }
+
+            auto& heap = plan.m_Heaps[group];
+            m_PlacedResources.clear();
+            for (auto index = begin; index < end; ++index) {
+                auto handle = m_SortedResources[index];
+                const auto& desc = resources[handle];
+                auto& placement = plan.m_Placements[handle];
+                auto alignment = (std::max<std::uint64_t>)(desc.m_Alignment, 1);
+
+                // 生命周期重叠的资源占用的内存
+                m_OccupiedRanges.clear();
+                for (auto other : m_PlacedResources) {
+                    const auto& otherPlacement = plan.m_Placements[other];
+                    bool overlapped = otherPlacement.m_FirstPass <= placement.m_LastPass && placement.m_FirstPass <= otherPlacement.m_LastPass;
+                    if (overlapped || otherPlacement.m_UsedByAsyncCompute || placement.m_UsedByAsyncCompute) {
+                        m_OccupiedRanges.emplace_back(otherPlacement.m_Offset, otherPlacement.m_Offset + resources[other].m_Size);
+                    }
+                }
+                std::sort(m_OccupiedRanges.begin(), m_OccupiedRanges.end());
+
+                // 找到第一个能放下的空隙
+                std::uint64_t offset = 0;
+                for (const auto& [rangeBegin, rangeEnd] : m_OccupiedRanges) {
+                    if (offset + desc.m_Size <= rangeBegin) break;
+                    offset = (std::max)(offset, AlignUp(rangeEnd, alignment));
+                }
+                placement.m_Offset = offset;
+
+                // 与之前放置的资源共享内存的两者都需要初始化，跨帧时之前的资源也可能被覆盖
+                for (auto other : m_PlacedResources) {
+                    auto& otherPlacement = plan.m_Placements[other];
+                    if (otherPlacement.m_Offset < offset + desc.m_Size &&
+                        offset < otherPlacement.m_Offset + resources[other].m_Size) {
+                        otherPlacement.m_Aliased = true;
+                        placement.m_Aliased = true;
+                    }
+                }
+
+                heap.m_Size = (std::max)(heap.m_Size, offset + desc.m_Size);
+                heap.m_Alignment = (std::max)(heap.m_Alignment, alignment);
+                m_PlacedResources.push_back(handle);
+            }
+            heap.m_Size = AlignUp(heap.m_Size, heap.m_Alignment);
+
+            begin = end;
+        }
+    }
+
+    void RenderGraphCompiler::BuildBarriers(std::span<const RGResourceDesc> resources, RenderGraphPlan& plan)
+    {
+        auto addBarrier = [&plan](std::vector<RGBarrier>& barriers, const RGBarrier& barrier) {
+            barriers.push_back(barrier);
+            ++plan.m_NumBarriers;
+        };
+
+        for (std::uint32_t i = 0; i < resources.size(); ++i) {
+            const auto& desc = resources[i];
+            const auto& accesses = m_ResourceAccesses[i];
+
+            auto currState = desc.m_Imported ? desc.m_InitialState : sm_UnknownState;
+            bool currIsRead = false;
+            auto currQueue = RGQueue::kGraphics;
+            if (!accesses.empty() && plan.m_Placements[i].m_Aliased) {
+                addBarrier(plan.m_PassBarriers[accesses.front().m_Pass], {RGBarrierType::kAliasing, i, sm_UnknownState, sm_UnknownState});
+            }
+
+            for (std::size_t index = 0; index < accesses.size();) {
+                const auto& access = accesses[index];
+                auto& barriers = plan.m_PassBarriers[access.m_Pass];
+
+                if (access.m_Write) {
+                    if (currState != access.m_State) {
+                        addBarrier(barriers, {RGBarrierType::kTransition, i, currState, access.m_State});
+                    }
+                    else if (access.m_State == sm_UnorderedAccessState && index > 0) {
+                        addBarrier(barriers, {RGBarrierType::kUAV, i, currState, currState});
+                    }
+                    currState = access.m_State;
+                    currIsRead = false;
+                    currQueue = plan.m_Schedules[access.m_Pass].m_Queue;
+                    ++index;
+                    continue;
+                }
+
+                // 同一队列上连续的读取合并为一次转换，避免在只读状态之间来回切换
+                // 计算队列不能使用包含图形状态的组合，读取不跨队列合并
+                auto queue = plan.m_Schedules[access.m_Pass].m_Queue;
+                std::uint32_t readState = 0;
+                auto end = index;
+                while (end < accesses.size() && !accesses[end].m_Write && plan.m_Schedules[accesses[end].m_Pass].m_Queue == queue) {
+                    readState |= accesses[end].m_State;
+                    ++end;
+                }
+                bool covered = currIsRead && currQueue == queue && (currState & readState) == readState;
+                if (currState != readState && !covered) {
+                    addBarrier(barriers, {RGBarrierType::kTransition, i, currState, readState});
+                    currState = readState;
+                }
+                currIsRead = true;
+                currQueue = queue;
+                index = end;
+            }
+
+            if (desc.m_Imported && desc.m_HasFinalState && currState != desc.m_FinalState) {
+                addBarrier(plan.m_FinalBarriers, {RGBarrierType::kTransition, i, currState, desc.m_FinalState});
+            }
+        }
+
+        // 同一 Pass 前的屏障中别名屏障需要先于转换
+        for (auto& barriers : plan.m_PassBarriers) {
+            std::stable_partition(barriers.begin(), barriers.end(), [](const RGBarrier& barrier) {
+                return barrier.m_Type == RGBarrierType::kAliasing;
+            });
+        }
+    }
+
+    void RenderGraphCompiler::ScheduleQueues(std::span<const RGResourceDesc> resources, RenderGraphPlan& plan)
+    {
+        auto numPasses = static_cast<std::uint32_t>(plan.m_PassOrder.size());
+        auto isCompute = [&plan](std::uint32_t pass) { return plan.m_Schedules[pass].m_Queue == RGQueue::kCompute; };
+        if (std::none_of(plan.m_Schedules.begin(), plan.m_Schedules.end(),
+            [](const RGPassSchedule& schedule) { return schedule.m_Queue == RGQueue::kCompute; })) return;
+
+        m_WaitPasses.assign(numPasses, sm_InvalidIndex);
+
+        // 计算队列无法转换的状态交给之前使用该资源的图形 Pass，之前没有使用时在帧开始时转换
+        for (std::uint32_t pass = 0; pass < numPasses; ++pass) {
+            if (!isCompute(pass)) continue;
+
+            std::erase_if(plan.m_PassBarriers[pass], [&](const RGBarrier& barrier) {
+                if (barrier.m_Type != RGBarrierType::kTransition ||
+                    (IsComputeQueueState(barrier.m_StateBefore) && IsComputeQueueState(barrier.m_StateAfter))) return false;
+
+                auto prevPass = FindPreviousAccess(barrier.m_Resource, pass);
+                if (prevPass != sm_InvalidIndex && !isCompute(prevPass)) {
+                    plan.m_Schedules[prevPass].m_EndBarriers.push_back(barrier);
+                }
+                else {
+                    plan.m_InitialBarriers.push_back(barrier);
+                }
+                return true;
+            });
+        }
+
+        // 同一资源在不同队列上相邻的两次访问之间需要同步
+        for (std::uint32_t i = 0; i < resources.size(); ++i) {
+            const auto& accesses = m_ResourceAccesses[i];
+            for (std::size_t index = 1; index < accesses.size(); ++index) {
+                auto prevPass = accesses[index - 1].m_Pass;
+                auto pass = accesses[index].m_Pass;
+                if (isCompute(prevPass) == isCompute(pass)) continue;
+
+                auto& waitPass = m_WaitPasses[pass];
+                waitPass = waitPass == sm_InvalidIndex ? prevPass : (std::max)(waitPass, prevPass);
+            }
+        }
+
+        // 队列按提交顺序执行，已经等待过的位置之前的依赖不需要再次等待
+        // 第一个计算 Pass 至少等待本帧的初始屏障，之后的计算 Pass 都在初始屏障之后，也不会与之前帧的图形 Pass 重叠
+        std::array<std::uint32_t, 2> lastWaitPass{sm_InvalidIndex, sm_InvalidIndex};
+        bool computeWaited = false;
+        std::uint32_t lastComputePass = sm_InvalidIndex;
+        for (std::uint32_t pass = 0; pass < numPasses; ++pass) {
+            auto& schedule = plan.m_Schedules[pass];
+            auto& lastWait = lastWaitPass[static_cast<std::size_t>(schedule.m_Queue)];
+
+            auto waitPass = m_WaitPasses[pass];
+            if (waitPass != sm_InvalidIndex && (lastWait == sm_InvalidIndex || lastWait < waitPass)) {
+                schedule.m_WaitPass = waitPass;
+                plan.m_Schedules[waitPass].m_Signal = true;
+                lastWait = waitPass;
+                ++plan.m_NumQueueWaits;
+            }
+
+            if (!isCompute(pass)) continue;
+            lastComputePass = pass;
+            if (!computeWaited && lastWait == sm_InvalidIndex) {
+                schedule.m_WaitInitial = true;
+                plan.m_SignalInitial = true;
+                ++plan.m_NumQueueWaits;
+            }
+            computeWaited = true;
+        }
+
+        // 帧结束前图形队列需要等待所有的计算 Pass
+        auto& graphicsWait = lastWaitPass[static_cast<std::size_t>(RGQueue::kGraphics)];
+        if (lastComputePass != sm_InvalidIndex && (graphicsWait == sm_InvalidIndex || graphicsWait < lastComputePass)) {
+            plan.m_FinalWaitPass = lastComputePass;
+            plan.m_Schedules[lastComputePass].m_Signal = true;
+            ++plan.m_NumQueueWaits;
+        }
+    }
+
+    std::uint32_t RenderGraphCompiler::FindPreviousAccess(std::uint32_t resource, std::uint32_t pass) const
+    {
+        const auto& accesses = m_ResourceAccesses[resource];
+        auto it = std::lower_bound(accesses.begin(), accesses.end(), pass, [](const ResourceAccess& access, std::uint32_t pass) {
+            return access.m_Pass < pass;
+        });
+        return it == accesses.begin() ? sm_InvalidIndex : std::prev(it)->m_Pass;
+    }
+}
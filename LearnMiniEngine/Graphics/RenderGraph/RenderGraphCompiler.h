@@ -0,0 +1,180 @@
+#pragma once
+#ifndef __RENDERGRAPHCOMPILER_H__
+#define __RENDERGRAPHCOMPILER_H__
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace DSM {
+    // 渲染图中的资源，状态的数值与 D3D12_RESOURCE_STATES 相同
+    struct RGResourceDesc
+    {
+        std::string m_Name{};
+        // 外部导入的资源不参与内存复用
+        bool m_Imported = false;
+        std::uint32_t m_InitialState = 0;
+        // 执行完毕后导入的资源需要处于的状态
+        bool m_HasFinalState = false;
+        std::uint32_t m_FinalState = 0;
+
+        // 临时资源的大小与对齐，同一组的资源可以放在同一个堆中
+        std::uint64_t m_Size = 0;
+        std::uint64_t m_Alignment = 0;
+        std::uint32_t m_HeapGroup = 0;
+    };
+
+    // 读取需要 UAV 状态时应声明为写入
+    struct RGAccess
+    {
+        std::uint32_t m_Resource{};
+        std::uint32_t m_State{};
+        bool m_Write = false;
+    };
+
+    enum class RGQueue : std::uint8_t
+    {
+        kGraphics,
+        // 异步计算队列，只能使用计算队列支持的状态
+        kCompute
+    };
+
+    struct RGPassDesc
+    {
+        std::string m_Name{};
+        RGQueue m_Queue = RGQueue::kGraphics;
+        std::vector<RGAccess> m_Accesses{};
+        // 有副作用的 Pass 不会被剔除，如写入交换链
+        bool m_HasSideEffects = false;
+    };
+
+    enum class RGBarrierType : std::uint8_t
+    {
+        kTransition,
+        // 资源的内存之前被其他资源使用过
+        kAliasing,
+        kUAV
+    };
+
+    struct RGBarrier
+    {
+        RGBarrierType m_Type = RGBarrierType::kTransition;
+        std::uint32_t m_Resource{};
+        // 临时资源第一次使用时之前的状态未知
+        std::uint32_t m_StateBefore{};
+        std::uint32_t m_StateAfter{};
+    };
+
+    struct RGResourcePlacement
+    {
+        std::uint32_t m_HeapGroup{};
+        std::uint64_t m_Offset{};
+        // 在 m_PassOrder 中第一次与最后一次使用的位置
+        std::uint32_t m_FirstPass{};
+        std::uint32_t m_LastPass{};
+        // 与其他资源共享了内存，第一次使用前需要初始化
+        bool m_Aliased = false;
+        bool m_FirstAccessIsWrite = false;
+        // 异步计算与图形 Pass 的执行时间重叠，使用的资源在整帧内都不与其他资源共享内存
+        bool m_UsedByAsyncCompute = false;
+    };
+
+    // 与 m_PassOrder 对应，Pass 执行的队列与跨队列的同步
+    struct RGPassSchedule
+    {
+        RGQueue m_Queue = RGQueue::kGraphics;
+        // 执行前等待另一个队列执行完 m_PassOrder 中该位置的 Pass，~0u 表示不需要等待
+        std::uint32_t m_WaitPass = ~0u;
+        // 执行前等待图形队列提交的初始屏障
+        bool m_WaitInitial = false;
+        // 执行后提交命令列表并发出信号，之后其他队列上的 Pass 会等待该信号
+        bool m_Signal = false;
+        // 图形 Pass 执行后、发出信号前提交的屏障，计算队列无法转换的状态由之前使用该资源的图形 Pass 转换
+        std::vector<RGBarrier> m_EndBarriers{};
+    };
+
+    struct RGHeapPlan
+    {
+        std::uint64_t m_Size{};
+        std::uint64_t m_Alignment{};
+    };
+
+    struct RenderGraphPlan
+    {
+        // 未被剔除的 Pass 按执行顺序排列
+        std::vector<std::uint32_t> m_PassOrder{};
+        // 与 m_PassOrder 对应，每个 Pass 执行前一次性提交的屏障
+        std::vector<std::vector<RGBarrier>> m_PassBarriers{};
+        // 所有 Pass 执行后将导入的资源转换到最终状态
+        std::vector<RGBarrier> m_FinalBarriers{};
+        // 与资源一一对应，导入或未被使用的资源的 m_HeapGroup 为 sm_InvalidIndex
+        std::vector<RGResourcePlacement> m_Placements{};
+        // 按堆的分组索引
+        std::vector<RGHeapPlan> m_Heaps{};
+
+        std::vector<RGPassSchedule> m_Schedules{};
+        // 第一个 Pass 执行前在图形队列上提交的屏障，用于第一次在计算队列上使用的资源
+        std::vector<RGBarrier> m_InitialBarriers{};
+        // 提交初始屏障后发出信号
+        bool m_SignalInitial = false;
+        // 最终屏障之前图形队列等待计算队列执行完该 Pass，~0u 表示不需要等待
+        std::uint32_t m_FinalWaitPass = ~0u;
+        std::uint32_t m_NumQueueWaits = 0;
+
+        std::uint32_t m_NumBarriers = 0;
+        // 不复用内存时临时资源需要的总大小
+        std::uint64_t m_UnaliasedSize = 0;
+    };
+
+    // 渲染图的编译，只处理 Pass 与资源之间的关系，不访问设备
+    class RenderGraphCompiler
+    {
+    public:
+        inline static constexpr std::uint32_t sm_InvalidIndex = ~0u;
+        // 与 D3D12_RESOURCE_STATE_UNORDERED_ACCESS 相同，连续写入该状态时需要 UAV 屏障
+        inline static constexpr std::uint32_t sm_UnorderedAccessState = 0x8;
+        inline static constexpr std::uint32_t sm_UnknownState = ~0u;
+        // UNORDERED_ACCESS | NON_PIXEL_SHADER_RESOURCE | COPY_DEST | COPY_SOURCE，计算队列上可以使用与转换的状态
+        inline static constexpr std::uint32_t sm_ComputeQueueStates = 0x8 | 0x40 | 0x400 | 0x800;
+
+        static bool IsComputeQueueState(std::uint32_t state) noexcept
+        {
+            return state != sm_UnknownState && (state & ~sm_ComputeQueueStates) == 0;
+        }
+
+        // 剔除无用的 Pass，计算资源的生命周期、内存复用方案、屏障与跨队列的同步
+        void Compile(std::span<const RGResourceDesc> resources, std::span<const RGPassDesc> passes, RenderGraphPlan& plan);
+
+    private:
+        void CullPasses(std::span<const RGResourceDesc> resources, std::span<const RGPassDesc> passes, RenderGraphPlan& plan);
+        void ComputeLifetimes(std::span<const RGResourceDesc> resources, std::span<const RGPassDesc> passes, RenderGraphPlan& plan);
+        void AllocateMemory(std::span<const RGResourceDesc> resources, RenderGraphPlan& plan);
+        void BuildBarriers(std::span<const RGResourceDesc> resources, RenderGraphPlan& plan);
+        // 将计算队列无法执行的转换移到图形队列，并为跨队列的依赖插入最少的等待
+        void ScheduleQueues(std::span<const RGResourceDesc> resources, RenderGraphPlan& plan);
+        // 该 Pass 之前最后一次访问该资源的 Pass，没有时返回 sm_InvalidIndex
+        std::uint32_t FindPreviousAccess(std::uint32_t resource, std::uint32_t pass) const;
+
+    private:
+        struct ResourceAccess
+        {
+            std::uint32_t m_Pass{};
+            std::uint32_t m_State{};
+            bool m_Write = false;
+        };
+
+        // 编译过程中的临时数据，在多次编译之间复用内存
+        std::vector<bool> m_PassAlive{};
+        std::vector<bool> m_ResourceNeeded{};
+        std::vector<std::vector<ResourceAccess>> m_ResourceAccesses{};
+        std::vector<std::uint32_t> m_SortedResources{};
+        std::vector<std::uint32_t> m_PlacedResources{};
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> m_OccupiedRanges{};
+        // 每个 Pass 依赖的另一个队列上最后的 Pass
+        std::vector<std::uint32_t> m_WaitPasses{};
+    };
+}
+
+#endif
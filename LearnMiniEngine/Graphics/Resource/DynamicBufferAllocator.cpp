@@ -43,7 +43,10 @@ namespace DSM {
         m_PagePool.clear();
     }
 
-    GpuResourceLocation DynamicBufferAllocator::Allocate(std::uint64_t bufferSize, std::uint32_t alignment)
+    GpuResourceLocation DynamicBufferAllocator::Allocate(
+        std::uint64_t bufferSize,
+        std::uint32_t alignment,
+        MemoryCategory category)
     {
         GpuResourceLocation ret{};
 
@@ -51,7 +54,7 @@ namespace DSM {
 
         // 过大的资源额外管理
         if (auto alignSize = Math::AlignUp(bufferSize, alignment); alignSize > m_PageSize) {
-            ret.m_Resource = CreateNewBuffer(alignSize);
+            ret.m_Resource = CreateNewBuffer(alignSize, category);
             ret.m_Size = alignSize;
             ret.m_GpuAddress = ret.m_Resource->GetGpuVirtualAddress();
             if (m_AllocateMode == AllocateMode::CpuExclusive) {
@@ -93,6 +96,29 @@ namespace DSM {
         m_LargePages.clear();
     }
 
+    std::uint64_t DynamicBufferAllocator::Trim()
+    {
+        std::lock_guard lock{m_Mutex};
+
+        while (!m_RetiredPages.empty() &&
+            g_RenderContext.IsFenceComplete(m_RetiredPages.front().first)) {
+            m_AvailablePages.push(m_RetiredPages.front().second);
+            m_RetiredPages.pop();
+        }
+
+        std::uint64_t trimmedSize = 0;
+        while (!m_AvailablePages.empty()) {
+            auto page = m_AvailablePages.front();
+            m_AvailablePages.pop();
+            if (page->m_MappedAddress != nullptr) {
+                page->m_Resource->GetResource()->Unmap(0, nullptr);
+            }
+            trimmedSize += page->m_Resource->GetResource()->GetDesc().Width;
+            std::erase_if(m_PagePool, [page](const auto& p) { return p.get() == page; });
+        }
+        return trimmedSize;
+    }
+
     DynamicBufferPage* DynamicBufferAllocator::RequestPage()
     {
         // 清除已经完成的资源
@@ -117,7 +143,7 @@ namespace DSM {
         return ret;
     }
 
-    GpuResource* DynamicBufferAllocator::CreateNewBuffer(std::uint64_t bufferSize)
+    GpuResource* DynamicBufferAllocator::CreateNewBuffer(std::uint64_t bufferSize, MemoryCategory category)
     {
         D3D12_RESOURCE_DESC resourceDesc{};
         resourceDesc.Alignment = 0;
@@ -137,6 +163,7 @@ namespace DSM {
         bufferDesc.m_Desc = resourceDesc;
         bufferDesc.m_State = resourceState;
         bufferDesc.m_HeapType = D3D12_HEAP_TYPE_UPLOAD;
+        bufferDesc.m_Category = category;
 
         if (m_AllocateMode == AllocateMode::CpuExclusive) {
             bufferDesc.m_HeapType = D3D12_HEAP_TYPE_UPLOAD;
@@ -73,13 +73,19 @@ namespace DSM {
         void Create(AllocateMode mode, std::uint64_t pageSize = DEFAULT_BUFFER_PAGE_SIZE);
         void Shutdown();
 
-        GpuResourceLocation Allocate(std::uint64_t bufferSize, std::uint32_t alignment = 0);
+        // 超过页大小的分配单独创建缓冲区，并按 category 统计
+        GpuResourceLocation Allocate(
+            std::uint64_t bufferSize,
+            std::uint32_t alignment = 0,
+            MemoryCategory category = MemoryCategory::kUploadPage);
         // 清理所有的缓冲区
         void Cleanup(std::uint64_t fenceValue);
+        // 释放 GPU 已经使用完毕的空闲页，返回释放的字节数
+        std::uint64_t Trim();
 
     private:
         DynamicBufferPage* RequestPage();
-        GpuResource* CreateNewBuffer(std::uint64_t bufferSize = 0);
+        GpuResource* CreateNewBuffer(std::uint64_t bufferSize = 0, MemoryCategory category = MemoryCategory::kUploadPage);
 
     private:
         AllocateMode m_AllocateMode = AllocateMode::CpuExclusive;
@@ -24,6 +24,7 @@ namespace DSM{
         gpuResourceDesc.m_State = D3D12_RESOURCE_STATE_COMMON;
         gpuResourceDesc.m_HeapType = bufferDesc.m_HeapType;
         gpuResourceDesc.m_HeapFlags = D3D12_HEAP_FLAG_NONE;
+        gpuResourceDesc.m_Category = bufferDesc.m_Category;
 
         GpuResource::Create(name, gpuResourceDesc);
         
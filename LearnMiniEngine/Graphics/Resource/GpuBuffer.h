@@ -14,6 +14,8 @@ namespace DSM {
         std::uint32_t m_Stride = 0;
         D3D12_HEAP_TYPE m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
         D3D12_RESOURCE_FLAGS m_Flags = D3D12_RESOURCE_FLAG_NONE;
+        // 为空时按堆类型统计
+        std::optional<MemoryCategory> m_Category{};
     };
 
     
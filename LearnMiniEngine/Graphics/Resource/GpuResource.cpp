@@ -1,5 +1,6 @@
 #include "GpuResource.h"
 #include "GpuResourceAllocator.h"
+#include "../RenderContext.h"
 
 namespace DSM {
 
@@ -28,12 +29,13 @@ namespace DSM {
            m_Allocator = &allocator;
         }
         m_Resource = resource;
-        m_UsageState = resourceDesc.m_State;
+        m_UsageStates.Reset(resourceDesc.m_State, ComputeNumSubresources());
 
         m_Resource->SetName(name.c_str());
+        TrackMemory(name, resourceDesc.m_Category);
     }
 
-    void GpuResource::Create(const std::wstring& name, ID3D12Resource* resource)
+    void GpuResource::Create(const std::wstring& name, ID3D12Resource* resource, bool trackMemory)
     {
         ASSERT(resource != nullptr);
         if (m_Resource != nullptr) {
@@ -42,16 +44,70 @@ namespace DSM {
         
         m_Resource.Attach(resource);
         m_Resource->SetName(name.c_str());
-        m_UsageState = D3D12_RESOURCE_STATE_COMMON;
+        m_UsageStates.Reset(D3D12_RESOURCE_STATE_COMMON, ComputeNumSubresources());
         m_Allocator = nullptr;
+        if (trackMemory) {
+            TrackMemory(name, std::nullopt);
+        }
     }
 
     void GpuResource::Destroy()
     {
+        // 移动后的对象不再拥有该记录
+        if (m_Resource != nullptr) {
+            g_MemoryTracker.RecordFree(m_MemoryAllocation);
+        }
         if (m_Resource != nullptr && m_Allocator != nullptr) {
             m_Allocator->ReleaseResource(m_Resource.Get());
         }
         m_Resource = nullptr;
         m_Allocator = nullptr;
+        m_MemoryAllocation = MemoryTracker::sm_InvalidAllocation;
+    }
+
+    void GpuResource::TrimAllocators()
+    {
+        for (auto& [heapDesc, allocator] : s_GpuResourceAllocators) {
+            allocator.Trim();
+        }
+    }
+
+    std::uint32_t GpuResource::ComputeNumSubresources() const
+    {
+        auto desc = m_Resource->GetDesc();
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) return 1;
+
+        // 深度模板等格式有多个平面，每个平面是独立的子资源
+        D3D12_FEATURE_DATA_FORMAT_INFO formatInfo{};
+        formatInfo.Format = desc.Format;
+        std::uint32_t planeCount = 1;
+        if (SUCCEEDED(g_RenderContext.GetDevice()->CheckFeatureSupport(D3D12_FEATURE_FORMAT_INFO, &formatInfo, sizeof(formatInfo)))) {
+            planeCount = (std::max<std::uint32_t>)(formatInfo.PlaneCount, 1);
+        }
+        std::uint32_t arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+        return desc.MipLevels * arraySize * planeCount;
+    }
+
+    void GpuResource::TrackMemory(const std::wstring& name, std::optional<MemoryCategory> category)
+    {
+        auto desc = m_Resource->GetDesc();
+        if (!category) {
+            D3D12_HEAP_PROPERTIES heapProp{};
+            D3D12_HEAP_FLAGS heapFlags{};
+            bool cpuVisible = SUCCEEDED(m_Resource->GetHeapProperties(&heapProp, &heapFlags)) &&
+                (heapProp.Type == D3D12_HEAP_TYPE_UPLOAD || heapProp.Type == D3D12_HEAP_TYPE_READBACK);
+            if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+                category = cpuVisible ? MemoryCategory::kUploadPage : MemoryCategory::kBuffer;
+            }
+            else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+                category = MemoryCategory::kRenderTarget;
+            }
+            else {
+                category = MemoryCategory::kTexture;
+            }
+        }
+
+        auto allocInfo = g_RenderContext.GetDevice()->GetResourceAllocationInfo(0, 1, &desc);
+        m_MemoryAllocation = g_MemoryTracker.RecordAllocation(*category, allocInfo.SizeInBytes, Utility::WStringToUTF8(name));
     }
 }
@@ -3,6 +3,8 @@
 #define __GPURESOURCE_H__
 
 #include "../../pch.h"
+#include "../../Core/MemoryTracker.h"
+#include "../ResourceStateTracker.h"
 
 namespace DSM {
     class GpuResourceAllocator;
@@ -13,6 +15,8 @@ namespace DSM {
         D3D12_HEAP_FLAGS m_HeapFlags = D3D12_HEAP_FLAG_NONE;
         D3D12_RESOURCE_DESC m_Desc{};
         D3D12_RESOURCE_STATES m_State = D3D12_RESOURCE_STATE_COMMON;
+        // 为空时按资源的类型与堆类型统计
+        std::optional<MemoryCategory> m_Category{};
     };
     
     // GPU 资源的封装
@@ -34,7 +38,8 @@ namespace DSM {
         DSM_NONCOPYABLE(GpuResource);
 
         void Create(const std::wstring& name, const GpuResourceDesc& resourceDesc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
-        void Create(const std::wstring& name, ID3D12Resource* resource);
+        // 放置在共享堆中的资源由堆统计显存，trackMemory 为 false
+        void Create(const std::wstring& name, ID3D12Resource* resource, bool trackMemory = true);
         virtual void Destroy();
 
         ID3D12Resource* operator->() { return m_Resource.Get(); }
@@ -45,19 +50,37 @@ namespace DSM {
         ID3D12Resource** GetAddressOf() { return m_Resource.GetAddressOf(); }
         ID3D12Resource* const * GetAddressOf() const { return m_Resource.GetAddressOf(); }
 
-        D3D12_RESOURCE_STATES GetUsageState() const noexcept { return m_UsageState; }
+        // 子资源状态不同时，不指定子资源返回第一个子资源的状态
+        D3D12_RESOURCE_STATES GetUsageState(std::uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) const noexcept
+        {
+            return static_cast<D3D12_RESOURCE_STATES>(m_UsageStates.GetState(subresource));
+        }
+        SubresourceStates& GetSubresourceStates() noexcept { return m_UsageStates; }
+        std::uint32_t GetNumSubresources() const noexcept { return m_UsageStates.GetNumSubresources(); }
 
         D3D12_GPU_VIRTUAL_ADDRESS GetGpuVirtualAddress() const noexcept { return m_Resource->GetGPUVirtualAddress(); }
 
-        void SetUsageState(D3D12_RESOURCE_STATES usageState) noexcept { m_UsageState = usageState; }
+        // 设置所有子资源的状态
+        void SetUsageState(D3D12_RESOURCE_STATES usageState) noexcept { m_UsageStates.SetState(D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, usageState); }
+
+        // 释放所有分配器中空闲的堆
+        static void TrimAllocators();
         
+    protected:
+        // 在 MemoryTracker 中记录该资源占用的显存
+        void TrackMemory(const std::wstring& name, std::optional<MemoryCategory> category);
+        // 所有 mip、数组切片与平面的数量
+        std::uint32_t ComputeNumSubresources() const;
+
     protected:
         Microsoft::WRL::ComPtr<ID3D12Resource> m_Resource{};
-        // 资源当前的状态
-        D3D12_RESOURCE_STATES m_UsageState{};
+        // 资源每个子资源当前的状态
+        SubresourceStates m_UsageStates{};
 
         // 该资源的创建者
         GpuResourceAllocator* m_Allocator{};
+
+        std::uint64_t m_MemoryAllocation = MemoryTracker::sm_InvalidAllocation;
     };
 
 
@@ -143,6 +143,17 @@ namespace DSM {
         }
     }
 
+    void GpuResourceAllocator::Trim()
+    {
+        std::lock_guard lock{m_Mutex};
+
+        while (!m_AvailablePages.empty()) {
+            auto page = m_AvailablePages.front();
+            m_AvailablePages.pop();
+            std::erase_if(m_PagePool, [page](const auto& p) { return p.get() == page; });
+        }
+    }
+
     GpuResourcePage* GpuResourceAllocator::RequestPage()
     {
         GpuResourcePage* page = nullptr;
@@ -161,21 +172,27 @@ namespace DSM {
     }
 
     ID3D12Heap* GpuResourceAllocator::CreateNewHeap(std::uint64_t heapSize)
+    {
+        auto heapName = L"PlacedResourceAllocator Heap" + std::to_wstring(m_PagePool.size());
+        return CreateHeap(m_HeapDesc, heapSize == 0 ? m_HeapSize : heapSize, heapName);
+    }
+
+    ID3D12Heap* GpuResourceAllocator::CreateHeap(DSMHeapDesc heapDesc, std::uint64_t heapSize, const std::wstring& name, std::uint64_t alignment)
     {
         D3D12_HEAP_PROPERTIES heapProperties{};
-        heapProperties.Type = m_HeapDesc.m_HeapType;
+        heapProperties.Type = heapDesc.m_HeapType;
         heapProperties.CreationNodeMask = 1;
         heapProperties.VisibleNodeMask = 1;
         
-        D3D12_HEAP_DESC heapDesc{};
-        heapDesc.Flags = m_HeapDesc.m_HeapFlags;
-        heapDesc.Properties = heapProperties;
-        heapDesc.SizeInBytes = heapSize == 0 ? m_HeapSize : heapSize;
+        D3D12_HEAP_DESC d3dHeapDesc{};
+        d3dHeapDesc.Flags = heapDesc.m_HeapFlags;
+        d3dHeapDesc.Properties = heapProperties;
+        d3dHeapDesc.SizeInBytes = heapSize;
+        d3dHeapDesc.Alignment = alignment;
 
         ID3D12Heap* heap = nullptr;
-        ASSERT_SUCCEEDED(g_RenderContext.GetDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)));
-        auto heapName = L"PlacedResourceAllocator Heap" + std::to_wstring(m_PagePool.size());
-        heap->SetName(heapName.c_str());
+        ASSERT_SUCCEEDED(g_RenderContext.GetDevice()->CreateHeap(&d3dHeapDesc, IID_PPV_ARGS(&heap)));
+        heap->SetName(name.c_str());
         
         return heap;
     }
@@ -21,8 +21,13 @@ namespace DSM {
         friend class GpuResourceAllocator;
     public:
         GpuResourcePage(ID3D12Heap* agentHeap)
-            :m_Heap(agentHeap), m_Allocator(agentHeap->GetDesc().SizeInBytes){}
-        ~GpuResourcePage() = default;
+            :m_Heap(agentHeap), m_Allocator(agentHeap->GetDesc().SizeInBytes)
+        {
+            // 放置资源的堆尚未被子资源使用的部分同样占用显存
+            m_MemoryAllocation = g_MemoryTracker.RecordAllocation(
+                MemoryCategory::kOther, agentHeap->GetDesc().SizeInBytes, "PlacedResourceAllocator Heap");
+        }
+        ~GpuResourcePage() { g_MemoryTracker.RecordFree(m_MemoryAllocation); }
         DSM_NONCOPYABLE_NONMOVABLE(GpuResourcePage);
 
         ID3D12Resource* Allocate(
@@ -46,6 +51,7 @@ namespace DSM {
         Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap{};
         std::set<ID3D12Resource*> m_SubResources{};
         LinearAllocator m_Allocator;
+        std::uint64_t m_MemoryAllocation = MemoryTracker::sm_InvalidAllocation;
     };
 
     // 用于管理所有的资源分配
@@ -64,8 +70,12 @@ namespace DSM {
             D3D12_RESOURCE_STATES resourceState,
             const D3D12_CLEAR_VALUE* clearValue = nullptr);
         void ReleaseResource(ID3D12Resource* resource);
+        // 释放所有空闲的页
+        void Trim();
         
         ID3D12Heap* CreateNewHeap(std::uint64_t heapSize = 0);
+        // 创建堆，返回的堆由调用者释放，alignment 为 0 时使用默认的 64KB 对齐
+        static ID3D12Heap* CreateHeap(DSMHeapDesc heapDesc, std::uint64_t heapSize, const std::wstring& name, std::uint64_t alignment = 0);
         
 
     private:
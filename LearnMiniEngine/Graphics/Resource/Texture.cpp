@@ -4,8 +4,13 @@
 #include "../RenderContext.h"
 #include "../CommandList/CommandList.h"
 #include "../../Utilities/DDSTextureLoader12.h"
+#include "../../Utilities/DDSFile.h"
+#include "../../Utilities/MipGenerator.h"
+#include "../../Utilities/BCEncoder.h"
 #include "../../Utilities/FormatUtil.h"
 #include "../../Utilities/stb_image.h"
+#include "../../Core/Profiler.h"
+#include <filesystem>
 
 using namespace DirectX;
 
@@ -44,9 +49,9 @@ namespace DSM{
         }
     }
 
-    void Texture::Create(const std::wstring& name, ID3D12Resource* resource, bool isCubeMap)
+    void Texture::Create(const std::wstring& name, ID3D12Resource* resource, bool isCubeMap, bool trackMemory)
     {
-        GpuResource::Create(name, resource);
+        GpuResource::Create(name, resource, trackMemory);
 
         const D3D12_RESOURCE_DESC& resourceDesc = resource->GetDesc();
         m_IsCubeMap = isCubeMap;
@@ -255,14 +260,36 @@ namespace DSM{
         Texture& texture,
         const std::string& texName,
         const std::string& filename,
-        bool forceSRGB)
+        bool forceSRGB,
+        TextureUsage usage)
     {
+        PROFILE_SCOPE("Texture::CreateTextureFromFile");
+        std::wstring wFilename = Utility::UTF8ToWString(filename);
+        std::wstring wTexName = Utility::UTF8ToWString(texName);
+
+        // 优先使用内存映射的 DDS 路径，失败时回退到 DDSTextureLoader 与 stb
+        if (CreateTextureFromMappedDDS(texture, wFilename, filename, forceSRGB)) {
+            texture->SetName(wTexName.c_str());
+            return true;
+        }
+
+        // 已经压缩过的纹理直接读取缓存，缓存比源文件旧时重新压缩
+        std::string cacheFilename{};
+        if (usage != TextureUsage::kDefault && !sm_TextureCacheDirectory.empty()) {
+            if (auto validCache = FindTextureCache(filename, forceSRGB, usage);
+                !validCache.empty() && CreateTextureFromMappedDDS(texture, wFilename, validCache, false)) {
+                texture->SetName(wTexName.c_str());
+                return true;
+            }
+            cacheFilename = GetTextureCacheFilename(filename, forceSRGB, usage);
+        }
+
 		stbi_uc* imgData = nullptr;
         D3D12_RESOURCE_DESC texDesc{};
         std::unique_ptr<std::uint8_t[]> ddsData{};
         std::vector<D3D12_SUBRESOURCE_DATA> subResources{};
+        MipChain mipChain{};
         DDS_LOADER_FLAGS loadFlags = forceSRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT;
-        std::wstring wFilename = Utility::UTF8ToWString(filename);
         
         if (FAILED(LoadDDSTextureFromFileEx(
             g_RenderContext.GetDevice(),
@@ -276,26 +303,50 @@ namespace DSM{
             nullptr,
             &texture.m_IsCubeMap))) {
             int width, height, components;
-            imgData = stbi_load(filename.c_str(), &width, &height, &components, 4);
+            bool isHDR = stbi_is_hdr(filename.c_str());
+            // HDR 图片需以浮点数读取才能与 R32G32B32A32_FLOAT 匹配
+            imgData = isHDR ?
+                reinterpret_cast<stbi_uc*>(stbi_loadf(filename.c_str(), &width, &height, &components, 4)) :
+                stbi_load(filename.c_str(), &width, &height, &components, 4);
             if (imgData == nullptr) return false;
+
+            // 块压缩格式要求最高一级的宽高是 4 的倍数
+            if (usage != TextureUsage::kDefault && !isHDR && width % 4 == 0 && height % 4 == 0) {
+                bool succeeded = CreateCompressedTexture(texture, wFilename, imgData,
+                    static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), forceSRGB, usage, cacheFilename);
+                stbi_image_free(imgData);
+                if (succeeded) {
+                    texture->SetName(wTexName.c_str());
+                }
+                return succeeded;
+            }
             
-            bool isHDR = stbi_is_hdr(filename.c_str());
-            texDesc.Format = isHDR ? DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+            texDesc.Format = isHDR ? DXGI_FORMAT_R32G32B32A32_FLOAT :
+                forceSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
             texDesc.Width = static_cast<std::uint64_t>(width);
             texDesc.Height = static_cast<std::uint32_t>(height);
             texDesc.DepthOrArraySize = 1;
             texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-            texDesc.MipLevels = 1;
             texDesc.SampleDesc = {1,0};
             texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
             texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-            D3D12_SUBRESOURCE_DATA subResourceData{};
-            subResourceData.pData = imgData;
-            subResourceData.RowPitch = Utility::GetRowPitch(texDesc.Format, texDesc.Width);
-            subResourceData.SlicePitch = Utility::GetSlicePitch(texDesc.Format, texDesc.Width, texDesc.Height);
+            // 在 CPU 上生成完整的 mip 链
+            auto mipFormat = isHDR ? MipPixelFormat::kRGBA32Float :
+                forceSRGB ? MipPixelFormat::kRGBA8UnormSRGB : MipPixelFormat::kRGBA8Unorm;
+            mipChain.Generate(imgData, width, height, 0, mipFormat, sm_MipFilter);
+            texDesc.MipLevels = static_cast<std::uint16_t>(mipChain.GetNumLevels());
+
             subResources.clear();
-            subResources.emplace_back(std::move(subResourceData));
+            for (std::uint32_t i = 0; i < mipChain.GetNumLevels(); ++i) {
+                const auto& level = mipChain.GetLevel(i);
+                D3D12_SUBRESOURCE_DATA subResourceData{};
+                subResourceData.pData = mipChain.GetLevelData(i);
+                subResourceData.RowPitch = static_cast<LONG_PTR>(level.m_RowPitch);
+                subResourceData.SlicePitch = static_cast<LONG_PTR>(level.m_RowPitch * level.m_Height);
+                subResources.emplace_back(std::move(subResourceData));
+            }
+            stbi_image_free(imgData);
         }
 
         TextureDesc textureDesc{};
@@ -309,16 +360,160 @@ namespace DSM{
         textureDesc.m_DepthOrArraySize = texDesc.DepthOrArraySize;
         texture.Create(wFilename, textureDesc, subResources);
 
-        std::wstring wTexName = Utility::UTF8ToWString(texName);
         texture->SetName(wTexName.c_str());
 
-        if (imgData != nullptr) {
-            stbi_image_free(imgData);
+        return true;
+    }
+
+    bool Texture::CreateTextureFromMappedDDS(
+        Texture& texture,
+        const std::wstring& name,
+        const std::string& filename,
+        bool forceSRGB)
+    {
+        PROFILE_SCOPE("Texture::CreateTextureFromMappedDDS");
+        if (filename.size() < 4 || _stricmp(filename.c_str() + filename.size() - 4, ".dds") != 0) return false;
+
+        DDSFile ddsFile{};
+        if (!ddsFile.Open(filename, forceSRGB)) return false;
+
+        const auto& info = ddsFile.GetInfo();
+        TextureDesc textureDesc{};
+        textureDesc.m_Dimension = static_cast<D3D12_RESOURCE_DIMENSION>(info.m_Dimension);
+        textureDesc.m_Width = info.m_Width;
+        textureDesc.m_Height = info.m_Height;
+        textureDesc.m_DepthOrArraySize = static_cast<std::uint16_t>(
+            info.m_Dimension == DDSDimension::kTexture3D ? info.m_Depth : info.m_ArraySize);
+        textureDesc.m_MipLevels = static_cast<std::uint16_t>(info.m_MipLevels);
+        textureDesc.m_Format = static_cast<DXGI_FORMAT>(info.m_Format);
+
+        // 深度模板格式在 D3D12 中有多个平面，交给 DDSTextureLoader 处理
+        D3D12_FEATURE_DATA_FORMAT_INFO formatInfo = { textureDesc.m_Format, 0 };
+        if (FAILED(g_RenderContext.GetDevice()->CheckFeatureSupport(D3D12_FEATURE_FORMAT_INFO, &formatInfo, sizeof(formatInfo))) ||
+            formatInfo.PlaneCount != 1) {
+            return false;
         }
 
+        texture.Create(name, textureDesc, {}, D3D12_RESOURCE_STATE_COMMON, nullptr, info.m_IsCubeMap);
+        CommandList::InitTexture(texture, ddsFile, sm_DDSUploadBatchSize);
+
         return true;
     }
 
+    bool Texture::CreateCompressedTexture(
+        Texture& texture,
+        const std::wstring& name,
+        const std::uint8_t* rgba,
+        std::uint32_t width,
+        std::uint32_t height,
+        bool forceSRGB,
+        TextureUsage usage,
+        const std::string& cacheFilename)
+    {
+        PROFILE_SCOPE("Texture::CreateCompressedTexture");
+
+        BCFormat bcFormat{};
+        switch (usage) {
+            case TextureUsage::kColor: {
+                // 只有存在半透明像素时才需要 BC7
+                bool hasAlpha = false;
+                for (std::uint64_t i = 0, count = std::uint64_t(width) * height; i < count && !hasAlpha; ++i) {
+                    hasAlpha = rgba[i * 4 + 3] != 255;
+                }
+                bcFormat = hasAlpha ? BCFormat::kBC7 : BCFormat::kBC1;
+                break;
+            }
+            case TextureUsage::kNormalMap: bcFormat = BCFormat::kBC5; forceSRGB = false; break;
+            case TextureUsage::kGrayscale: bcFormat = BCFormat::kBC4; forceSRGB = false; break;
+            default: return false;
+        }
+
+        MipChain mipChain{};
+        auto mipFormat = forceSRGB ? MipPixelFormat::kRGBA8UnormSRGB : MipPixelFormat::kRGBA8Unorm;
+        if (!mipChain.Generate(rgba, width, height, 0, mipFormat, sm_MipFilter)) return false;
+
+        std::uint32_t numLevels = mipChain.GetNumLevels();
+        std::vector<std::vector<std::uint8_t>> compressed(numLevels);
+        std::vector<std::span<const std::uint8_t>> levelData(numLevels);
+        std::vector<D3D12_SUBRESOURCE_DATA> subResources(numLevels);
+        std::uint32_t blockSize = BCEncoder::GetBlockSize(bcFormat);
+        for (std::uint32_t i = 0; i < numLevels; ++i) {
+            const auto& level = mipChain.GetLevel(i);
+            compressed[i].resize(BCEncoder::GetCompressedSize(level.m_Width, level.m_Height, bcFormat));
+            BCEncoder::CompressImage(mipChain.GetLevelData(i), level.m_Width, level.m_Height, level.m_RowPitch,
+                bcFormat, compressed[i].data());
+
+            levelData[i] = compressed[i];
+            subResources[i].pData = compressed[i].data();
+            subResources[i].RowPitch = static_cast<LONG_PTR>((level.m_Width + 3) / 4 * blockSize);
+            subResources[i].SlicePitch = static_cast<LONG_PTR>(compressed[i].size());
+        }
+
+        DDSTextureInfo info{};
+        info.m_Width = width;
+        info.m_Height = height;
+        info.m_Depth = 1;
+        info.m_ArraySize = 1;
+        info.m_MipLevels = numLevels;
+        info.m_Format = BCEncoder::GetDXGIFormat(bcFormat, forceSRGB);
+        info.m_Dimension = DDSDimension::kTexture2D;
+
+        // 写入缓存失败不影响本次加载
+        if (!cacheFilename.empty()) {
+            std::error_code ec{};
+            std::filesystem::create_directories(Utility::UTF8ToWString(sm_TextureCacheDirectory), ec);
+            bool saved = !ec && DDSFile::Save(cacheFilename, info, levelData);
+            WARN_ONCE_IF_NOT(saved, "Failed to write texture cache {}", cacheFilename);
+        }
+
+        TextureDesc textureDesc{};
+        textureDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        textureDesc.m_Width = width;
+        textureDesc.m_Height = height;
+        textureDesc.m_DepthOrArraySize = 1;
+        textureDesc.m_MipLevels = static_cast<std::uint16_t>(numLevels);
+        textureDesc.m_Format = static_cast<DXGI_FORMAT>(info.m_Format);
+        texture.Create(name, textureDesc, subResources);
+
+        return true;
+    }
+
+    std::string Texture::FindTextureCache(const std::string& filename, bool forceSRGB, TextureUsage usage)
+    {
+        if (usage == TextureUsage::kDefault || sm_TextureCacheDirectory.empty()) return {};
+
+        auto cacheFilename = GetTextureCacheFilename(filename, forceSRGB, usage);
+        std::error_code ec{};
+        auto sourceTime = std::filesystem::last_write_time(Utility::UTF8ToWString(filename), ec);
+        if (ec) return {};
+        auto cacheTime = std::filesystem::last_write_time(Utility::UTF8ToWString(cacheFilename), ec);
+        return !ec && cacheTime >= sourceTime ? cacheFilename : std::string{};
+    }
+
+    std::string Texture::GetTextureCacheFilename(const std::string& filename, bool forceSRGB, TextureUsage usage)
+    {
+        // 使用绝对路径的 FNV-1a 哈希，不同目录下的同名文件不会冲突
+        std::error_code ec{};
+        auto absolutePath = std::filesystem::absolute(Utility::UTF8ToWString(filename), ec).lexically_normal();
+        std::string key = ec ? filename : Utility::WStringToUTF8(absolutePath.wstring());
+
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : key) {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+
+        static constexpr const char* usageNames[] = { "", "color", "normal", "gray" };
+        char suffix[64]{};
+        std::snprintf(suffix, sizeof(suffix), "%016llx_%s%s.dds",
+            static_cast<unsigned long long>(hash), usageNames[static_cast<int>(usage)], forceSRGB ? "_srgb" : "");
+
+        auto stem = std::filesystem::path(Utility::UTF8ToWString(filename)).stem();
+        auto cachePath = std::filesystem::path(Utility::UTF8ToWString(sm_TextureCacheDirectory)) /
+            (stem.wstring() + L"_" + Utility::UTF8ToWString(suffix));
+        return Utility::WStringToUTF8(cachePath.wstring());
+    }
+
     DXGI_FORMAT Texture::GetDSVFormat(DXGI_FORMAT defaultFormat) const noexcept
     {
         switch (defaultFormat)
@@ -4,8 +4,21 @@
 
 #include <span>
 #include "GpuResource.h"
+#include "../../Utilities/MipGenerator.h"
 
 namespace DSM {
+    // 纹理的用途，决定导入时压缩成哪种块压缩格式
+    enum class TextureUsage
+    {
+        // 不压缩
+        kDefault,
+        // 无 alpha 时使用 BC1，否则使用 BC7
+        kColor,
+        // 使用 BC5 保存 RG 通道，z 需要在着色器中重建
+        kNormalMap,
+        // 使用 BC4 保存 R 通道
+        kGrayscale
+    };
     
     struct TextureDesc
     {
@@ -36,7 +49,7 @@ namespace DSM {
             D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON,
             const D3D12_CLEAR_VALUE* clearValue = nullptr,
             bool isCubeMap = false);
-        void Create(const std::wstring& name, ID3D12Resource* resource, bool isCubeMap = false);
+        void Create(const std::wstring& name, ID3D12Resource* resource, bool isCubeMap = false, bool trackMemory = true);
 
         const TextureDesc& GetDesc() const { return m_Desc; }
         D3D12_RESOURCE_DIMENSION GetDimension() const { return m_Desc.m_Dimension; }
@@ -55,9 +68,39 @@ namespace DSM {
             Texture& texture,
             const std::string& texName,
             const std::string& filename,
-            bool forceSRGB = false);
+            bool forceSRGB = false,
+            TextureUsage usage = TextureUsage::kDefault);
+
+        // 映射 DDS 文件的上传路径每批使用的上传缓冲大小
+        inline static std::uint64_t sm_DDSUploadBatchSize = 0x4000000;
+        // 非 DDS 图片导入时生成 mip 链使用的滤波器
+        inline static MipFilter sm_MipFilter = MipFilter::kBox;
+        // 压缩后的纹理以 DDS 格式缓存的目录，为空时不写入缓存
+        inline static std::string sm_TextureCacheDirectory = "TextureCache";
+
+        // 缓存文件的路径，由源文件路径的哈希与用途组成
+        static std::string GetTextureCacheFilename(const std::string& filename, bool forceSRGB, TextureUsage usage);
+        // 返回比源文件新的缓存文件，不存在时返回空字符串
+        static std::string FindTextureCache(const std::string& filename, bool forceSRGB, TextureUsage usage);
 
     protected:
+        // 映射 DDS 文件并直接写入上传缓冲，不支持的格式返回 false
+        static bool CreateTextureFromMappedDDS(
+            Texture& texture,
+            const std::wstring& name,
+            const std::string& filename,
+            bool forceSRGB);
+        // 生成 mip 链后逐级压缩，并写入纹理缓存
+        static bool CreateCompressedTexture(
+            Texture& texture,
+            const std::wstring& name,
+            const std::uint8_t* rgba,
+            std::uint32_t width,
+            std::uint32_t height,
+            bool forceSRGB,
+            TextureUsage usage,
+            const std::string& cacheFilename);
+
         DXGI_FORMAT GetDSVFormat(DXGI_FORMAT defaultFormat) const noexcept;
 		DXGI_FORMAT GetSRVFormat(DXGI_FORMAT defaultFormat) const noexcept;
         
@@ -0,0 +1,262 @@
+#include "ResourceStateTracker.h"
+#include <algorithm>
+
+namespace DSM {
+    namespace {
+        // RENDER_TARGET | UNORDERED_ACCESS | DEPTH_WRITE | STREAM_OUT | COPY_DEST | RESOLVE_DEST |
+        // VIDEO_DECODE_WRITE | VIDEO_PROCESS_WRITE | RAYTRACING_ACCELERATION_STRUCTURE | VIDEO_ENCODE_WRITE
+        constexpr std::uint32_t kExclusiveStates = 0x4 | 0x8 | 0x10 | 0x100 | 0x400 | 0x1000 |
+            0x20000 | 0x80000 | 0x400000 | 0x800000;
+
+        bool Overlaps(std::uint32_t lhs, std::uint32_t rhs) noexcept
+        {
+            return lhs == rhs || lhs == SubresourceStates::sm_AllSubresources || rhs == SubresourceStates::sm_AllSubresources;
+        }
+    }
+
+    //
+    // SubresourceStates Implementation
+    //
+    void SubresourceStates::Reset(std::uint32_t state, std::uint32_t numSubresources)
+    {
+        m_State = state;
+        m_NumSubresources = (std::max)(numSubresources, 1u);
+        m_States.clear();
+        m_PendingSplits.clear();
+    }
+
+    std::uint32_t SubresourceStates::GetState(std::uint32_t subresource) const noexcept
+    {
+        if (IsUniform()) return m_State;
+        return m_States[subresource == sm_AllSubresources ? 0 : subresource];
+    }
+
+    void SubresourceStates::SetState(std::uint32_t subresource, std::uint32_t state)
+    {
+        if (subresource == sm_AllSubresources || m_NumSubresources == 1) {
+            m_State = state;
+            m_States.clear();
+            return;
+        }
+        if (IsUniform()) {
+            if (m_State == state) return;
+            m_States.assign(m_NumSubresources, m_State);
+        }
+        m_States[subresource] = state;
+
+        // 所有子资源再次一致时恢复为单个状态
+        if (std::all_of(m_States.begin(), m_States.end(), [state](std::uint32_t s) { return s == state; })) {
+            m_State = state;
+            m_States.clear();
+        }
+    }
+
+
+    //
+    // ResourceStateTracker Implementation
+    //
+    void ResourceStateTracker::Transition(std::uint64_t resource, SubresourceStates& states, std::uint32_t subresource, std::uint32_t newState)
+    {
+        ++m_Stats.m_NumRequests;
+        if (states.m_NumSubresources == 1) {
+            subresource = SubresourceStates::sm_AllSubresources;
+        }
+        EndPendingSplits(resource, states, subresource);
+
+        if (subresource == SubresourceStates::sm_AllSubresources && !states.IsUniform()) {
+            for (std::uint32_t i = 0; i < states.m_NumSubresources; ++i) {
+                if (states.m_States[i] != newState) {
+                    AddTransition(resource, i, states.m_States[i], newState);
+                }
+            }
+            states.SetState(subresource, newState);
+            return;
+        }
+
+        auto currState = states.GetState(subresource);
+        if (currState == newState || IsCompatibleRead(currState, newState)) {
+            // 连续的 UAV 写入之间需要等待之前的写入完成
+            if (newState == sm_UnorderedAccessState) {
+                UAVBarrier(resource);
+            }
+            else {
+                ++m_Stats.m_NumSkipped;
+            }
+            return;
+        }
+        AddTransition(resource, subresource, currState, newState);
+        states.SetState(subresource, newState);
+    }
+
+    void ResourceStateTracker::BeginTransition(std::uint64_t resource, SubresourceStates& states, std::uint32_t subresource, std::uint32_t newState)
+    {
+        ++m_Stats.m_NumRequests;
+        if (states.m_NumSubresources == 1) {
+            subresource = SubresourceStates::sm_AllSubresources;
+        }
+        EndPendingSplits(resource, states, subresource);
+
+        auto beginSplit = [&](std::uint32_t index, std::uint32_t currState) {
+            if (currState == newState) return;
+            m_Barriers.push_back({TrackedBarrierType::kTransition, TrackedBarrierFlag::kBeginOnly,
+                resource, 0, index, currState, newState});
+            states.m_PendingSplits.emplace_back(index, newState);
+        };
+
+        if (subresource == SubresourceStates::sm_AllSubresources && !states.IsUniform()) {
+            for (std::uint32_t i = 0; i < states.m_NumSubresources; ++i) {
+                beginSplit(i, states.m_States[i]);
+            }
+        }
+        else {
+            beginSplit(subresource, states.GetState(subresource));
+        }
+    }
+
+    void ResourceStateTracker::UAVBarrier(std::uint64_t resource)
+    {
+        // 尚未提交的同一资源的 UAV 屏障已经足够
+        for (auto it = m_Barriers.rbegin(); it != m_Barriers.rend(); ++it) {
+            if (it->m_Resource != resource) continue;
+            if (it->m_Type == TrackedBarrierType::kUAV) {
+                ++m_Stats.m_NumMerged;
+                return;
+            }
+            break;
+        }
+        m_Barriers.push_back({TrackedBarrierType::kUAV, TrackedBarrierFlag::kNone, resource});
+    }
+
+    void ResourceStateTracker::AliasBarrier(std::uint64_t before, std::uint64_t after)
+    {
+        m_Barriers.push_back({TrackedBarrierType::kAliasing, TrackedBarrierFlag::kNone, after, before});
+    }
+
+    bool ResourceStateTracker::IsWriteState(std::uint32_t state) noexcept
+    {
+        return (state & kExclusiveStates) != 0;
+    }
+
+    bool ResourceStateTracker::IsValidState(std::uint32_t state) noexcept
+    {
+        auto exclusive = state & kExclusiveStates;
+        // 只能有一个独占的状态，且不能与其他状态组合
+        return exclusive == 0 || (exclusive == state && (exclusive & (exclusive - 1)) == 0);
+    }
+
+    bool ResourceStateTracker::Validate(std::span<const TrackedBarrier> barriers, std::string* error)
+    {
+        struct Entry
+        {
+            std::uint64_t m_Resource{};
+            std::uint32_t m_Subresource{};
+            std::uint32_t m_State{};
+        };
+        std::vector<Entry> states{};
+        std::vector<Entry> splits{};
+
+        auto fail = [error](std::size_t index, const char* message) {
+            if (error != nullptr) {
+                *error = "Barrier " + std::to_string(index) + ": " + message;
+            }
+            return false;
+        };
+
+        for (std::size_t i = 0; i < barriers.size(); ++i) {
+            const auto& barrier = barriers[i];
+            if (barrier.m_Type != TrackedBarrierType::kTransition) continue;
+
+            if (!IsValidState(barrier.m_StateBefore) || !IsValidState(barrier.m_StateAfter)) {
+                return fail(i, "write state combined with other states");
+            }
+            if (barrier.m_StateBefore == barrier.m_StateAfter) {
+                return fail(i, "transition to the same state");
+            }
+
+            // 同一批中对同一子资源的转换需要前后衔接
+            for (const auto& entry : states) {
+                if (entry.m_Resource == barrier.m_Resource && Overlaps(entry.m_Subresource, barrier.m_Subresource) &&
+                    entry.m_State != barrier.m_StateBefore) {
+                    return fail(i, "state before does not match the previous transition in the batch");
+                }
+            }
+
+            auto sameSplit = [&barrier](const Entry& entry) {
+                return entry.m_Resource == barrier.m_Resource && Overlaps(entry.m_Subresource, barrier.m_Subresource);
+            };
+            if (barrier.m_Flag == TrackedBarrierFlag::kBeginOnly) {
+                if (std::any_of(splits.begin(), splits.end(), sameSplit)) {
+                    return fail(i, "split barrier begins twice in the batch");
+                }
+                splits.push_back({barrier.m_Resource, barrier.m_Subresource, barrier.m_StateAfter});
+                continue;
+            }
+            if (barrier.m_Flag == TrackedBarrierFlag::kEndOnly && std::any_of(splits.begin(), splits.end(), sameSplit)) {
+                return fail(i, "split barrier begins and ends in the same batch");
+            }
+
+            if (barrier.m_Subresource == SubresourceStates::sm_AllSubresources) {
+                std::erase_if(states, [&barrier](const Entry& entry) { return entry.m_Resource == barrier.m_Resource; });
+            }
+            else {
+                std::erase_if(states, [&barrier](const Entry& entry) {
+                    return entry.m_Resource == barrier.m_Resource && entry.m_Subresource == barrier.m_Subresource;
+                });
+            }
+            states.push_back({barrier.m_Resource, barrier.m_Subresource, barrier.m_StateAfter});
+        }
+        return true;
+    }
+
+    void ResourceStateTracker::EndPendingSplits(std::uint64_t resource, SubresourceStates& states, std::uint32_t subresource)
+    {
+        if (states.m_PendingSplits.empty()) return;
+
+        std::erase_if(states.m_PendingSplits, [&](const std::pair<std::uint32_t, std::uint32_t>& split) {
+            auto [index, state] = split;
+            if (!Overlaps(index, subresource)) return false;
+
+            // 开始的屏障尚未提交时，两者之间没有 GPU 工作，直接改为完整的转换
+            auto begin = std::find_if(m_Barriers.rbegin(), m_Barriers.rend(), [&](const TrackedBarrier& barrier) {
+                return barrier.m_Type == TrackedBarrierType::kTransition && barrier.m_Flag == TrackedBarrierFlag::kBeginOnly &&
+                    barrier.m_Resource == resource && barrier.m_Subresource == index;
+            });
+            if (begin != m_Barriers.rend()) {
+                begin->m_Flag = TrackedBarrierFlag::kNone;
+                ++m_Stats.m_NumMerged;
+            }
+            else {
+                m_Barriers.push_back({TrackedBarrierType::kTransition, TrackedBarrierFlag::kEndOnly,
+                    resource, 0, index, states.GetState(index), state});
+            }
+            states.SetState(index, state);
+            return true;
+        });
+    }
+
+    void ResourceStateTracker::AddTransition(std::uint64_t resource, std::uint32_t subresource, std::uint32_t before, std::uint32_t after)
+    {
+        // 与同一子资源尚未提交的转换合并，遇到该资源的其他屏障时停止
+        for (auto it = m_Barriers.rbegin(); it != m_Barriers.rend(); ++it) {
+            if (it->m_Resource != resource) continue;
+            if (it->m_Type == TrackedBarrierType::kTransition && it->m_Flag == TrackedBarrierFlag::kNone &&
+                it->m_Subresource == subresource && it->m_StateAfter == before) {
+                ++m_Stats.m_NumMerged;
+                it->m_StateAfter = after;
+                if (it->m_StateBefore == it->m_StateAfter) {
+                    m_Barriers.erase(std::next(it).base());
+                }
+                return;
+            }
+            break;
+        }
+        m_Barriers.push_back({TrackedBarrierType::kTransition, TrackedBarrierFlag::kNone, resource, 0, subresource, before, after});
+    }
+
+    bool ResourceStateTracker::IsCompatibleRead(std::uint32_t currState, std::uint32_t newState) const noexcept
+    {
+        // COMMON 与写入状态不能作为只读状态的超集
+        return newState != 0 && !IsWriteState(currState) && !IsWriteState(newState) &&
+            (currState & newState) == newState && (currState & ~m_AllowedStates) == 0;
+    }
+}
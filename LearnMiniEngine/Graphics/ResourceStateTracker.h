@@ -0,0 +1,126 @@
+#pragma once
+#ifndef __RESOURCESTATETRACKER_H__
+#define __RESOURCESTATETRACKER_H__
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace DSM {
+    // 资源每个子资源的状态，状态的数值与 D3D12_RESOURCE_STATES 相同
+    // 所有子资源状态相同时只保存一个状态
+    class SubresourceStates
+    {
+        friend class ResourceStateTracker;
+    public:
+        // 与 D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 相同
+        inline static constexpr std::uint32_t sm_AllSubresources = 0xffffffff;
+
+        SubresourceStates() = default;
+        SubresourceStates(std::uint32_t state, std::uint32_t numSubresources) { Reset(state, numSubresources); }
+
+        void Reset(std::uint32_t state, std::uint32_t numSubresources);
+        // 子资源状态不同时，sm_AllSubresources 返回第一个子资源的状态
+        std::uint32_t GetState(std::uint32_t subresource = sm_AllSubresources) const noexcept;
+        void SetState(std::uint32_t subresource, std::uint32_t state);
+
+        bool IsUniform() const noexcept { return m_States.empty(); }
+        std::uint32_t GetNumSubresources() const noexcept { return m_NumSubresources; }
+        // 已经开始但尚未结束的拆分屏障
+        bool HasPendingSplit() const noexcept { return !m_PendingSplits.empty(); }
+
+    private:
+        std::uint32_t m_State = 0;
+        std::uint32_t m_NumSubresources = 1;
+        std::vector<std::uint32_t> m_States{};
+        // 子资源与拆分屏障的目标状态
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> m_PendingSplits{};
+    };
+
+    enum class TrackedBarrierType : std::uint8_t
+    {
+        kTransition,
+        kAliasing,
+        kUAV
+    };
+
+    // 数值与 D3D12_RESOURCE_BARRIER_FLAGS 相同
+    enum class TrackedBarrierFlag : std::uint8_t
+    {
+        kNone = 0,
+        kBeginOnly = 1,
+        kEndOnly = 2
+    };
+
+    struct TrackedBarrier
+    {
+        TrackedBarrierType m_Type = TrackedBarrierType::kTransition;
+        TrackedBarrierFlag m_Flag = TrackedBarrierFlag::kNone;
+        // 资源的标识，由调用者决定，通常为资源的地址
+        std::uint64_t m_Resource{};
+        // 别名屏障之前使用该内存的资源，可以为 0
+        std::uint64_t m_ResourceBefore{};
+        std::uint32_t m_Subresource = SubresourceStates::sm_AllSubresources;
+        std::uint32_t m_StateBefore{};
+        std::uint32_t m_StateAfter{};
+    };
+
+    struct ResourceStateTrackerStats
+    {
+        // 请求的转换数
+        std::uint64_t m_NumRequests = 0;
+        // 已处于兼容的只读状态而跳过的转换
+        std::uint64_t m_NumSkipped = 0;
+        // 与尚未提交的转换合并的转换
+        std::uint64_t m_NumMerged = 0;
+    };
+
+    // 记录一批尚未提交的屏障，资源的状态保存在各自的 SubresourceStates 中
+    // 同一批内的屏障之间没有 GPU 工作，A->B 与 B->C 可以合并为 A->C
+    class ResourceStateTracker
+    {
+    public:
+        // 与 D3D12_RESOURCE_STATE_UNORDERED_ACCESS 相同
+        inline static constexpr std::uint32_t sm_UnorderedAccessState = 0x8;
+
+        // 转换子资源的状态，sm_AllSubresources 转换所有子资源
+        void Transition(std::uint64_t resource, SubresourceStates& states, std::uint32_t subresource, std::uint32_t newState);
+        // 拆分屏障的开始，之后对该子资源的转换会先结束该屏障，结束前不能使用该子资源
+        // 开始的屏障还未提交就结束时合并为完整的转换
+        void BeginTransition(std::uint64_t resource, SubresourceStates& states, std::uint32_t subresource, std::uint32_t newState);
+        void UAVBarrier(std::uint64_t resource);
+        void AliasBarrier(std::uint64_t before, std::uint64_t after);
+
+        // 只读状态包含请求的状态时跳过转换，状态需在该掩码内，计算队列上不能使用图形相关的状态
+        void SetAllowedStates(std::uint32_t allowedStates) noexcept { m_AllowedStates = allowedStates; }
+
+        std::span<const TrackedBarrier> GetBarriers() const noexcept { return m_Barriers; }
+        bool Empty() const noexcept { return m_Barriers.empty(); }
+        // 提交后调用
+        void Clear() noexcept { m_Barriers.clear(); }
+
+        const ResourceStateTrackerStats& GetStats() const noexcept { return m_Stats; }
+        void ResetStats() noexcept { m_Stats = {}; }
+
+        static bool IsWriteState(std::uint32_t state) noexcept;
+        // 写入状态不能与其他状态组合
+        static bool IsValidState(std::uint32_t state) noexcept;
+        // 检查一批屏障：状态合法、同一子资源的转换前后衔接、拆分屏障不在同一批中开始与结束
+        static bool Validate(std::span<const TrackedBarrier> barriers, std::string* error = nullptr);
+
+    private:
+        // 结束与该子资源重叠的拆分屏障
+        void EndPendingSplits(std::uint64_t resource, SubresourceStates& states, std::uint32_t subresource);
+        void AddTransition(std::uint64_t resource, std::uint32_t subresource, std::uint32_t before, std::uint32_t after);
+        bool IsCompatibleRead(std::uint32_t currState, std::uint32_t newState) const noexcept;
+
+    private:
+        std::vector<TrackedBarrier> m_Barriers{};
+        std::uint32_t m_AllowedStates = ~0u;
+        ResourceStateTrackerStats m_Stats{};
+    };
+}
+
+#endif
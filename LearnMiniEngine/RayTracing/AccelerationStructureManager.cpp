@@ -0,0 +1,401 @@
+#include "AccelerationStructureManager.h"
+#include <algorithm>
+
+namespace DSM {
+    namespace {
+        // D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT
+        constexpr std::uint64_t kScratchAlignment = 256;
+        // TLAS 的缓冲按实例数量的该倍数分配，避免实例逐渐增加时每帧重新分配
+        constexpr float kTLASGrowthFactor = 1.5f;
+
+        std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment) noexcept
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    void AccelerationStructureManager::Create(IAccelerationStructureBackend* backend, const AccelerationStructureManagerDesc& desc)
+    {
+        m_Backend = backend;
+        m_Desc = desc;
+        m_Desc.m_NumFramesInFlight = (std::max)(m_Desc.m_NumFramesInFlight, 1u);
+        m_Instances.Reset(sizeof(ASInstanceDesc));
+        m_Compactions.assign(m_Desc.m_NumFramesInFlight, {});
+        m_CompactedSizes.resize(m_Desc.m_MaxCompactionsPerFrame);
+        m_Stats = {};
+    }
+
+    void AccelerationStructureManager::Shutdown()
+    {
+        if (m_Backend == nullptr) return;
+
+        for (auto& blas : m_BLAS) {
+            ReleaseBuffer(blas.m_Buffer);
+        }
+        ReleaseBuffer(m_TLAS);
+        ReleaseBuffer(m_ScratchPool);
+
+        m_BLAS.clear();
+        m_FreeBLAS.clear();
+        m_BuildQueue.clear();
+        m_NextBuild = 0;
+        m_BLASInstances.clear();
+        m_InstanceStates.clear();
+        m_Instances.Reset(sizeof(ASInstanceDesc));
+        m_NumInstances = 0;
+        m_NumTLASInstances = 0;
+        m_TLASDirty = false;
+        m_Compactions.clear();
+        m_InFrame = false;
+        m_Backend = nullptr;
+    }
+
+    std::uint32_t AccelerationStructureManager::CreateBLAS(std::span<const ASTriangleGeometry> geometries, bool dynamic)
+    {
+        std::uint32_t handle{};
+        if (!m_FreeBLAS.empty()) {
+            handle = m_FreeBLAS.back();
+            m_FreeBLAS.pop_back();
+        }
+        else {
+            handle = static_cast<std::uint32_t>(m_BLAS.size());
+            m_BLAS.emplace_back();
+            m_BLASInstances.emplace_back();
+        }
+
+        auto& blas = m_BLAS[handle];
+        blas.m_Geometries.assign(geometries.begin(), geometries.end());
+        blas.m_Dynamic = dynamic;
+        blas.m_Active = true;
+        QueueOperation(handle, BLASOperation::kBuild);
+        ++m_Stats.m_NumBLAS;
+        return handle;
+    }
+
+    void AccelerationStructureManager::UpdateBLAS(std::uint32_t blas)
+    {
+        auto& state = m_BLAS[blas];
+        // 还没有构建过的 BLAS 没有可以拟合的结果
+        bool canRefit = state.m_Dynamic && state.m_Buffer.m_Handle != ASBuffer::sm_InvalidHandle &&
+            (m_Desc.m_MaxRefits == 0 || state.m_NumRefits < m_Desc.m_MaxRefits);
+        QueueOperation(blas, canRefit ? BLASOperation::kRefit : BLASOperation::kBuild);
+    }
+
+    void AccelerationStructureManager::SetBLASGeometry(std::uint32_t blas, std::span<const ASTriangleGeometry> geometries)
+    {
+        m_BLAS[blas].m_Geometries.assign(geometries.begin(), geometries.end());
+        QueueOperation(blas, BLASOperation::kBuild);
+    }
+
+    void AccelerationStructureManager::DestroyBLAS(std::uint32_t blas)
+    {
+        auto& state = m_BLAS[blas];
+        if (state.m_Buffer.m_Handle != ASBuffer::sm_InvalidHandle) {
+            m_Stats.m_BLASMemory -= state.m_Buffer.m_Size;
+        }
+        ReleaseBuffer(state.m_Buffer);
+        // 句柄会被复用，引用它的实例改为不参与求交
+        for (auto instance : m_BLASInstances[blas]) {
+            m_InstanceStates[instance].m_BLAS = sm_InvalidHandle;
+            WriteInstance(instance);
+        }
+        m_BLASInstances[blas].clear();
+
+        // 构建队列中的项在处理时跳过
+        state.m_Geometries.clear();
+        state.m_Pending = BLASOperation::kNone;
+        state.m_NumRefits = 0;
+        state.m_Compacted = false;
+        state.m_Active = false;
+        ++state.m_Generation;
+        m_FreeBLAS.push_back(blas);
+        --m_Stats.m_NumBLAS;
+    }
+
+    std::uint32_t AccelerationStructureManager::AddInstance(const ASInstanceDesc& desc, std::uint32_t blas)
+    {
+        auto instance = m_Instances.Allocate();
+        if (instance >= m_InstanceStates.size()) {
+            m_InstanceStates.resize(std::size_t(instance) + 1);
+        }
+        m_InstanceStates[instance].m_Active = true;
+        m_InstanceStates[instance].m_BLAS = sm_InvalidHandle;
+        ++m_NumInstances;
+        // 新行在 CPU 上为零，与写入的数据相同时也需要上传
+        m_Instances.MarkDirty(instance);
+        SetInstance(instance, desc, blas);
+        return instance;
+    }
+
+    void AccelerationStructureManager::SetInstance(std::uint32_t instance, const ASInstanceDesc& desc, std::uint32_t blas)
+    {
+        auto& state = m_InstanceStates[instance];
+        if (state.m_BLAS != blas) {
+            if (state.m_BLAS != sm_InvalidHandle) {
+                auto& instances = m_BLASInstances[state.m_BLAS];
+                auto it = std::find(instances.begin(), instances.end(), instance);
+                *it = instances.back();
+                instances.pop_back();
+            }
+            if (blas != sm_InvalidHandle) {
+                m_BLASInstances[blas].push_back(instance);
+            }
+            state.m_BLAS = blas;
+        }
+        state.m_Desc = desc;
+        WriteInstance(instance);
+    }
+
+    void AccelerationStructureManager::SetInstanceTransform(std::uint32_t instance, const float (&transform)[3][4])
+    {
+        auto& desc = m_InstanceStates[instance].m_Desc;
+        std::copy_n(&transform[0][0], 12, &desc.m_Transform[0][0]);
+        WriteInstance(instance);
+    }
+
+    void AccelerationStructureManager::RemoveInstance(std::uint32_t instance)
+    {
+        SetInstance(instance, {}, sm_InvalidHandle);
+        m_InstanceStates[instance].m_Active = false;
+        m_Instances.Free(instance);
+        --m_NumInstances;
+    }
+
+    void AccelerationStructureManager::BeginFrame(std::uint32_t frameIndex)
+    {
+        m_FrameIndex = frameIndex % m_Desc.m_NumFramesInFlight;
+        m_InFrame = true;
+    }
+
+    void AccelerationStructureManager::Update()
+    {
+        if (!m_InFrame) return;
+        m_InFrame = false;
+
+        m_Stats.m_NumBuilds = 0;
+        m_Stats.m_NumRefits = 0;
+        m_Stats.m_NumCompactions = 0;
+        m_Stats.m_NumDeferred = 0;
+        m_Stats.m_NumUploadedInstances = 0;
+        m_Stats.m_ScratchUsed = 0;
+        m_Stats.m_TLASRebuilt = false;
+        m_ScratchOffset = 0;
+
+        CompactBLAS();
+        bool recorded = BuildBLAS();
+        BuildTLAS(!recorded);
+
+        m_Stats.m_NumInstances = m_NumInstances;
+        m_Stats.m_ScratchPoolSize = m_ScratchPool.m_Size;
+    }
+
+    void AccelerationStructureManager::QueueOperation(std::uint32_t blas, BLASOperation operation)
+    {
+        auto& state = m_BLAS[blas];
+        if (state.m_Pending == BLASOperation::kNone) {
+            m_BuildQueue.push_back(blas);
+        }
+        // 已经在等待重建时不需要再重新拟合
+        if (state.m_Pending != BLASOperation::kBuild) {
+            state.m_Pending = operation;
+        }
+    }
+
+    void AccelerationStructureManager::CompactBLAS()
+    {
+        auto& compactions = m_Compactions[m_FrameIndex];
+        if (compactions.empty()) return;
+
+        auto firstQuery = m_FrameIndex * m_Desc.m_MaxCompactionsPerFrame;
+        auto numQueries = static_cast<std::uint32_t>(compactions.size());
+        if (m_Backend->ReadCompactedSizes(firstQuery, numQueries, m_CompactedSizes.data())) {
+            for (std::uint32_t i = 0; i < numQueries; ++i) {
+                auto& state = m_BLAS[compactions[i].m_BLAS];
+                auto compactedSize = m_CompactedSizes[i];
+                // 查询之后被销毁、重建或正在等待重建的 BLAS 不再压缩
+                if (!state.m_Active || state.m_Generation != compactions[i].m_Generation ||
+                    state.m_Pending == BLASOperation::kBuild ||
+                    compactedSize == 0 || compactedSize >= state.m_Buffer.m_Size) {
+                    continue;
+                }
+
+                auto compacted = m_Backend->CreateBuffer(compactedSize, false);
+                m_Backend->CopyCompacted(compacted, state.m_Buffer);
+                m_Stats.m_BLASMemory += compacted.m_Size;
+                m_Stats.m_BLASMemory -= state.m_Buffer.m_Size;
+                m_Stats.m_CompactionSavings += state.m_Buffer.m_Size - compacted.m_Size;
+                ReleaseBuffer(state.m_Buffer);
+                state.m_Buffer = compacted;
+                state.m_Compacted = true;
+                OnBLASAddressChanged(compactions[i].m_BLAS);
+                ++m_Stats.m_NumCompactions;
+            }
+        }
+        compactions.clear();
+    }
+
+    bool AccelerationStructureManager::BuildBLAS()
+    {
+        auto& compactions = m_Compactions[m_FrameIndex];
+        bool recorded = m_Stats.m_NumCompactions > 0;
+        bool barrierBeforeBuild = false;
+
+        for (; m_NextBuild < m_BuildQueue.size(); ++m_NextBuild) {
+            auto handle = m_BuildQueue[m_NextBuild];
+            auto& state = m_BLAS[handle];
+            if (!state.m_Active || state.m_Pending == BLASOperation::kNone) continue;
+
+            bool refit = state.m_Pending == BLASOperation::kRefit;
+            ASBuildFlags flags{};
+            flags.m_AllowUpdate = state.m_Dynamic;
+            flags.m_PreferFastBuild = state.m_Dynamic;
+            flags.m_AllowCompaction = !state.m_Dynamic;
+            flags.m_PerformUpdate = refit;
+            bool compact = flags.m_AllowCompaction && compactions.size() < m_Desc.m_MaxCompactionsPerFrame;
+            flags.m_AllowCompaction = compact;
+
+            if (!refit) {
+                state.m_PrebuildInfo = m_Backend->GetBLASPrebuildInfo(state.m_Geometries, flags);
+            }
+            auto scratchSize = AlignUp(refit ? state.m_PrebuildInfo.m_UpdateScratchSize : state.m_PrebuildInfo.m_ScratchSize, kScratchAlignment);
+            // 第一个构建总是执行，保证超出预算的 BLAS 也能完成
+            if (m_Stats.m_ScratchUsed > 0 && m_Stats.m_ScratchUsed + scratchSize > m_Desc.m_ScratchBudget) {
+                m_Stats.m_NumDeferred = static_cast<std::uint32_t>(m_BuildQueue.size() - m_NextBuild);
+                break;
+            }
+
+            if (!barrierBeforeBuild) {
+                // 上一帧的构建可能仍在使用暂存内存
+                m_Backend->Barrier();
+                barrierBeforeBuild = true;
+            }
+
+            ASBLASBuild build{};
+            build.m_Geometries = state.m_Geometries;
+            build.m_Flags = flags;
+            build.m_ScratchAddress = AllocateScratch(scratchSize);
+            build.m_CompactionQuery = sm_InvalidQuery;
+            if (refit) {
+                ++state.m_NumRefits;
+                ++m_Stats.m_NumRefits;
+            }
+            else {
+                if (state.m_Buffer.m_Handle != ASBuffer::sm_InvalidHandle) {
+                    m_Stats.m_BLASMemory -= state.m_Buffer.m_Size;
+                    ReleaseBuffer(state.m_Buffer);
+                }
+                state.m_Buffer = m_Backend->CreateBuffer(state.m_PrebuildInfo.m_ResultSize, false);
+                m_Stats.m_BLASMemory += state.m_Buffer.m_Size;
+                state.m_NumRefits = 0;
+                state.m_Compacted = false;
+                ++state.m_Generation;
+                if (compact) {
+                    build.m_CompactionQuery = m_FrameIndex * m_Desc.m_MaxCompactionsPerFrame + static_cast<std::uint32_t>(compactions.size());
+                    compactions.push_back({handle, state.m_Generation});
+                }
+                OnBLASAddressChanged(handle);
+                ++m_Stats.m_NumBuilds;
+            }
+            build.m_Dest = state.m_Buffer;
+            m_Backend->BuildBLAS(build);
+
+            state.m_Pending = BLASOperation::kNone;
+            m_Stats.m_ScratchUsed += scratchSize;
+            recorded = true;
+        }
+
+        // 全部处理完时清空队列，推迟的构建保持原有顺序
+        if (m_NextBuild == m_BuildQueue.size()) {
+            m_BuildQueue.clear();
+            m_NextBuild = 0;
+        }
+        else if (m_NextBuild > m_BuildQueue.size() / 2) {
+            m_BuildQueue.erase(m_BuildQueue.begin(), m_BuildQueue.begin() + m_NextBuild);
+            m_NextBuild = 0;
+        }
+
+        if (!compactions.empty()) {
+            m_Backend->ResolveCompactedSizes(m_FrameIndex * m_Desc.m_MaxCompactionsPerFrame, static_cast<std::uint32_t>(compactions.size()));
+        }
+        if (recorded) {
+            // 新的 BLAS 内容改变了实例的包围盒
+            m_TLASDirty = true;
+            m_Backend->Barrier();
+        }
+        return recorded;
+    }
+
+    void AccelerationStructureManager::BuildTLAS(bool needBarrier)
+    {
+        if (m_Instances.GetNumDirty() > 0) {
+            m_Stats.m_NumUploadedInstances = m_Instances.GetNumDirty();
+            m_Instances.BuildScatterList();
+            m_Backend->UploadInstances(m_Instances);
+            m_TLASDirty = true;
+        }
+        if (!m_TLASDirty) return;
+        m_TLASDirty = false;
+
+        // 行数只增不减，删除的实例为空行
+        auto numInstances = m_Instances.GetNumRows();
+        m_NumTLASInstances = m_NumInstances == 0 ? 0 : numInstances;
+        if (m_NumTLASInstances == 0) return;
+
+        auto prebuildInfo = m_Backend->GetTLASPrebuildInfo(numInstances);
+        if (m_TLAS.m_Size < prebuildInfo.m_ResultSize) {
+            auto reserved = m_Backend->GetTLASPrebuildInfo(static_cast<std::uint32_t>(numInstances * kTLASGrowthFactor) + 1);
+            ReleaseBuffer(m_TLAS);
+            m_TLAS = m_Backend->CreateBuffer(reserved.m_ResultSize, false);
+        }
+
+        if (needBarrier) {
+            // 上一帧的光线追踪可能仍在读取 TLAS
+            m_Backend->Barrier();
+        }
+        ASTLASBuild build{};
+        build.m_NumInstances = numInstances;
+        build.m_Dest = m_TLAS;
+        build.m_ScratchAddress = AllocateScratch(AlignUp(prebuildInfo.m_ScratchSize, kScratchAlignment));
+        m_Backend->BuildTLAS(build);
+        // 之后的光线追踪读取 TLAS
+        m_Backend->Barrier();
+        m_Stats.m_TLASRebuilt = true;
+    }
+
+    void AccelerationStructureManager::WriteInstance(std::uint32_t instance)
+    {
+        const auto& state = m_InstanceStates[instance];
+        auto desc = state.m_Desc;
+        desc.m_AccelerationStructure = state.m_BLAS == sm_InvalidHandle ? 0 : m_BLAS[state.m_BLAS].m_Buffer.m_GpuAddress;
+        m_Instances.Write(instance, desc);
+    }
+
+    void AccelerationStructureManager::OnBLASAddressChanged(std::uint32_t blas)
+    {
+        for (auto instance : m_BLASInstances[blas]) {
+            WriteInstance(instance);
+        }
+    }
+
+    void AccelerationStructureManager::ReleaseBuffer(ASBuffer& buffer)
+    {
+        if (buffer.m_Handle != ASBuffer::sm_InvalidHandle) {
+            m_Backend->ReleaseBuffer(buffer);
+        }
+        buffer = {};
+    }
+
+    std::uint64_t AccelerationStructureManager::AllocateScratch(std::uint64_t size)
+    {
+        auto end = m_ScratchOffset + size;
+        if (end > m_ScratchPool.m_Size) {
+            // 本帧之前的分配仍在旧的池中，释放会延迟到 GPU 完成后，新池保持相同的偏移以免重叠
+            auto poolSize = (std::max)(m_Desc.m_ScratchBudget, end);
+            ReleaseBuffer(m_ScratchPool);
+            m_ScratchPool = m_Backend->CreateBuffer(poolSize, true);
+        }
+        auto address = m_ScratchPool.m_GpuAddress + m_ScratchOffset;
+        m_ScratchOffset = end;
+        return address;
+    }
+}
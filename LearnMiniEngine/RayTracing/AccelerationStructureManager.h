@@ -0,0 +1,264 @@
+#pragma once
+#ifndef __ACCELERATIONSTRUCTUREMANAGER_H__
+#define __ACCELERATIONSTRUCTUREMANAGER_H__
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Renderer/GpuSceneTable.h"
+
+namespace DSM {
+    // 三角形几何在 GPU 上的位置，顶点为 R32G32B32_FLOAT，索引为 R32_UINT，没有索引时 m_IndexAddress 为 0
+    struct ASTriangleGeometry
+    {
+        std::uint64_t m_VertexAddress{};
+        std::uint32_t m_VertexCount{};
+        std::uint32_t m_VertexStride = sizeof(float) * 3;
+        std::uint64_t m_IndexAddress{};
+        std::uint32_t m_IndexCount{};
+        bool m_Opaque = true;
+    };
+
+    struct ASPrebuildInfo
+    {
+        std::uint64_t m_ResultSize{};
+        std::uint64_t m_ScratchSize{};
+        std::uint64_t m_UpdateScratchSize{};
+    };
+
+    struct ASBuildFlags
+    {
+        bool m_AllowUpdate = false;
+        bool m_AllowCompaction = false;
+        bool m_PreferFastBuild = false;
+        // 在原有结果上重新拟合，源与目标相同
+        bool m_PerformUpdate = false;
+    };
+
+    struct ASBuffer
+    {
+        inline static constexpr std::uint32_t sm_InvalidHandle = ~0u;
+
+        std::uint32_t m_Handle = sm_InvalidHandle;
+        std::uint64_t m_GpuAddress{};
+        std::uint64_t m_Size{};
+    };
+
+    struct ASBLASBuild
+    {
+        std::span<const ASTriangleGeometry> m_Geometries{};
+        ASBuildFlags m_Flags{};
+        ASBuffer m_Dest{};
+        std::uint64_t m_ScratchAddress{};
+        // 构建后写入压缩后大小的查询，不需要压缩时为 sm_InvalidQuery
+        std::uint32_t m_CompactionQuery{};
+    };
+
+    struct ASTLASBuild
+    {
+        std::uint32_t m_NumInstances{};
+        ASBuffer m_Dest{};
+        std::uint64_t m_ScratchAddress{};
+    };
+
+    // 与 D3D12_RAYTRACING_INSTANCE_DESC 的布局相同
+    struct ASInstanceDesc
+    {
+        float m_Transform[3][4]{};
+        std::uint32_t m_InstanceID : 24 = 0;
+        std::uint32_t m_InstanceMask : 8 = 0;
+        std::uint32_t m_HitGroupOffset : 24 = 0;
+        std::uint32_t m_Flags : 8 = 0;
+        // 为 0 时实例不参与求交
+        std::uint64_t m_AccelerationStructure{};
+    };
+    static_assert(sizeof(ASInstanceDesc) == 64);
+
+    // 加速结构的命令与内存，D3D12 下由 D3D12AccelerationStructureBackend 实现，测试时可替换为模拟的后端
+    // 命令按调用顺序录制到同一个队列
+    class IAccelerationStructureBackend
+    {
+    public:
+        virtual ~IAccelerationStructureBackend() = default;
+
+        virtual ASPrebuildInfo GetBLASPrebuildInfo(std::span<const ASTriangleGeometry> geometries, const ASBuildFlags& flags) = 0;
+        virtual ASPrebuildInfo GetTLASPrebuildInfo(std::uint32_t numInstances) = 0;
+
+        // 加速结构与暂存内存，释放需延迟到当前录制的命令在 GPU 上完成之后
+        virtual ASBuffer CreateBuffer(std::uint64_t size, bool scratch) = 0;
+        virtual void ReleaseBuffer(const ASBuffer& buffer) = 0;
+
+        virtual void BuildBLAS(const ASBLASBuild& build) = 0;
+        virtual void CopyCompacted(const ASBuffer& dest, const ASBuffer& src) = 0;
+        // 之后的命令等待之前所有加速结构的构建与拷贝完成
+        virtual void Barrier() = 0;
+
+        // 上传实例表中改变的行，实例缓冲至少为 numRows 行，增长时需保留原有的内容
+        virtual void UploadInstances(const GpuSceneTable& instances) = 0;
+        virtual void BuildTLAS(const ASTLASBuild& build) = 0;
+
+        // 把查询结果写入 CPU 可见的内存，之后该帧在 GPU 上完成时可以读取
+        virtual void ResolveCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries) = 0;
+        virtual bool ReadCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* sizes) = 0;
+    };
+
+    struct AccelerationStructureManagerDesc
+    {
+        // 与 FrameScheduler 相同，压缩后的大小在同一槽位的下一帧读取
+        std::uint32_t m_NumFramesInFlight = 2;
+        // 每帧 BLAS 构建可以使用的暂存内存，超出的构建推迟到之后的帧，单个超出预算的构建会独占一帧
+        std::uint64_t m_ScratchBudget = 32ull << 20;
+        // 每帧最多压缩的 BLAS 数量
+        std::uint32_t m_MaxCompactionsPerFrame = 64;
+        // 动态 BLAS 连续重新拟合的次数达到该值时完整重建一次，0 表示只重新拟合
+        std::uint32_t m_MaxRefits = 64;
+    };
+
+    struct AccelerationStructureStats
+    {
+        // 上一次 Update 的结果
+        std::uint32_t m_NumBuilds = 0;
+        std::uint32_t m_NumRefits = 0;
+        std::uint32_t m_NumCompactions = 0;
+        // 因暂存内存不足推迟到之后的帧
+        std::uint32_t m_NumDeferred = 0;
+        std::uint32_t m_NumUploadedInstances = 0;
+        std::uint64_t m_ScratchUsed = 0;
+        bool m_TLASRebuilt = false;
+
+        std::uint32_t m_NumBLAS = 0;
+        std::uint32_t m_NumInstances = 0;
+        std::uint64_t m_BLASMemory = 0;
+        // 压缩累计节省的内存
+        std::uint64_t m_CompactionSavings = 0;
+        std::uint64_t m_ScratchPoolSize = 0;
+    };
+
+    // 管理 BLAS 与 TLAS 的生命周期，只做调度，所有设备操作通过 IAccelerationStructureBackend 完成
+    // - 新建与重建的 BLAS 按提交顺序在每帧的暂存预算内批量构建，同一批之间没有屏障
+    // - 静态 BLAS 构建后查询压缩后的大小，结果可读时拷贝到紧凑的缓冲并释放原缓冲
+    // - 动态 BLAS 在顶点改变时重新拟合而不是重建
+    // - 实例按行存放在 GpuSceneTable 中，只上传改变的行，删除的实例留下不参与求交的空行供之后复用
+    class AccelerationStructureManager
+    {
+    public:
+        inline static constexpr std::uint32_t sm_InvalidHandle = ~0u;
+        inline static constexpr std::uint32_t sm_InvalidQuery = ~0u;
+
+        AccelerationStructureManager() = default;
+        ~AccelerationStructureManager() { Shutdown(); }
+        AccelerationStructureManager(const AccelerationStructureManager&) = delete;
+        AccelerationStructureManager& operator=(const AccelerationStructureManager&) = delete;
+
+        void Create(IAccelerationStructureBackend* backend, const AccelerationStructureManagerDesc& desc = {});
+        // 释放所有缓冲，之后需重新 Create
+        void Shutdown();
+
+        // 动态 BLAS 允许重新拟合，不压缩；几何数据在构建完成前需保持有效
+        std::uint32_t CreateBLAS(std::span<const ASTriangleGeometry> geometries, bool dynamic = false);
+        // 顶点数据改变后调用，动态 BLAS 重新拟合，静态 BLAS 重建
+        void UpdateBLAS(std::uint32_t blas);
+        // 几何的数量或地址改变，总是重建
+        void SetBLASGeometry(std::uint32_t blas, std::span<const ASTriangleGeometry> geometries);
+        // 引用它的实例之后不参与求交
+        void DestroyBLAS(std::uint32_t blas);
+
+        // 实例描述中的 m_AccelerationStructure 由 blas 决定，BLAS 尚未构建时实例不参与求交
+        std::uint32_t AddInstance(const ASInstanceDesc& desc, std::uint32_t blas);
+        void SetInstance(std::uint32_t instance, const ASInstanceDesc& desc, std::uint32_t blas);
+        void SetInstanceTransform(std::uint32_t instance, const float (&transform)[3][4]);
+        void RemoveInstance(std::uint32_t instance);
+
+        // 开始新的一帧，该槽位之前的帧需已在 GPU 上完成，其压缩查询的结果会在此时读取
+        void BeginFrame(std::uint32_t frameIndex);
+        // 录制本帧的压缩拷贝、BLAS 构建、实例上传与 TLAS 构建，在 BeginFrame 之后调用一次
+        void Update();
+
+        bool IsBLASBuilt(std::uint32_t blas) const { return m_BLAS[blas].m_Buffer.m_Handle != ASBuffer::sm_InvalidHandle; }
+        std::uint64_t GetBLASAddress(std::uint32_t blas) const { return m_BLAS[blas].m_Buffer.m_GpuAddress; }
+        std::uint64_t GetBLASSize(std::uint32_t blas) const { return m_BLAS[blas].m_Buffer.m_Size; }
+        // 没有实例时为 0
+        std::uint64_t GetTLASAddress() const noexcept { return m_NumTLASInstances == 0 ? 0 : m_TLAS.m_GpuAddress; }
+        std::uint32_t GetNumPendingBuilds() const noexcept { return static_cast<std::uint32_t>(m_BuildQueue.size() - m_NextBuild); }
+        const GpuSceneTable& GetInstanceTable() const noexcept { return m_Instances; }
+        const AccelerationStructureStats& GetStats() const noexcept { return m_Stats; }
+
+    private:
+        enum class BLASOperation : std::uint8_t
+        {
+            kNone,
+            kBuild,
+            kRefit
+        };
+
+        struct BLASState
+        {
+            std::vector<ASTriangleGeometry> m_Geometries{};
+            ASBuffer m_Buffer{};
+            ASPrebuildInfo m_PrebuildInfo{};
+            // 每次重建加一，用于丢弃过期的压缩查询
+            std::uint32_t m_Generation = 0;
+            std::uint32_t m_NumRefits = 0;
+            BLASOperation m_Pending = BLASOperation::kNone;
+            bool m_Dynamic = false;
+            bool m_Compacted = false;
+            bool m_Active = false;
+        };
+
+        struct InstanceState
+        {
+            ASInstanceDesc m_Desc{};
+            std::uint32_t m_BLAS = sm_InvalidHandle;
+            bool m_Active = false;
+        };
+
+        struct PendingCompaction
+        {
+            std::uint32_t m_BLAS{};
+            std::uint32_t m_Generation{};
+        };
+
+        void QueueOperation(std::uint32_t blas, BLASOperation operation);
+        void CompactBLAS();
+        // 返回是否录制了构建或拷贝
+        bool BuildBLAS();
+        void BuildTLAS(bool needBarrier);
+        void WriteInstance(std::uint32_t instance);
+        // BLAS 的地址改变后重写引用它的实例
+        void OnBLASAddressChanged(std::uint32_t blas);
+        void ReleaseBuffer(ASBuffer& buffer);
+        // 每帧从池的开头分配，需要时扩大暂存内存池，上一帧的构建在本帧的第一个屏障之前完成
+        std::uint64_t AllocateScratch(std::uint64_t size);
+
+    private:
+        IAccelerationStructureBackend* m_Backend{};
+        AccelerationStructureManagerDesc m_Desc{};
+
+        std::vector<BLASState> m_BLAS{};
+        std::vector<std::uint32_t> m_FreeBLAS{};
+        // 按提交顺序等待构建或重新拟合的 BLAS，m_NextBuild 之前的已处理完
+        std::vector<std::uint32_t> m_BuildQueue{};
+        std::size_t m_NextBuild = 0;
+        // 每个 BLAS 被引用的实例，地址改变时只需重写这些实例
+        std::vector<std::vector<std::uint32_t>> m_BLASInstances{};
+
+        std::vector<InstanceState> m_InstanceStates{};
+        GpuSceneTable m_Instances{};
+        std::uint32_t m_NumInstances = 0;
+        bool m_TLASDirty = false;
+        ASBuffer m_TLAS{};
+        std::uint32_t m_NumTLASInstances = 0;
+
+        ASBuffer m_ScratchPool{};
+        std::uint64_t m_ScratchOffset = 0;
+        // 每个槽位最近一帧发出的压缩查询
+        std::vector<std::vector<PendingCompaction>> m_Compactions{};
+        std::vector<std::uint64_t> m_CompactedSizes{};
+        std::uint32_t m_FrameIndex = 0;
+        bool m_InFrame = false;
+
+        AccelerationStructureStats m_Stats{};
+    };
+}
+
+#endif
@@ -0,0 +1,600 @@
+#include "BVH.h"
+#include "Utilities/ParallelFor.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace DSM {
+    namespace {
+        // 图元数超过该值时并行分箱
+        constexpr std::uint32_t kParallelBinThreshold = 64 * 1024;
+        // 图元数超过该值时在新线程中构建子树
+        constexpr std::uint32_t kParallelTaskThreshold = 4 * 1024;
+        constexpr std::uint32_t kMaxBins = 64;
+        constexpr std::uint32_t kMaxLeafSize = 16;
+        // 每个轴的 Morton 码位数
+        constexpr std::uint32_t kMortonBits = 21;
+
+        float GetAxis(const BVHFloat3& v, std::uint32_t axis) noexcept
+        {
+            return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+        }
+
+        BVHFloat3 GetCentroid(const BVHBounds& bounds) noexcept
+        {
+            return {
+                (bounds.m_Min.x + bounds.m_Max.x) * 0.5f,
+                (bounds.m_Min.y + bounds.m_Max.y) * 0.5f,
+                (bounds.m_Min.z + bounds.m_Max.z) * 0.5f};
+        }
+
+        BVHFloat3 ReadPosition(const BVHGeometry& geometry, std::uint32_t index) noexcept
+        {
+            BVHFloat3 position{};
+            memcpy(&position, static_cast<const std::uint8_t*>(geometry.m_Positions) + std::size_t(index) * geometry.m_PositionStride, sizeof(position));
+            return position;
+        }
+
+        // 在每一位之间插入两个 0
+        std::uint64_t ExpandBits(std::uint64_t v) noexcept
+        {
+            v &= 0x1fffff;
+            v = (v | v << 32) & 0x1f00000000ffffull;
+            v = (v | v << 16) & 0x1f0000ff0000ffull;
+            v = (v | v << 8) & 0x100f00f00f00f00full;
+            v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+            v = (v | v << 2) & 0x1249249249249249ull;
+            return v;
+        }
+
+        // 不使用默认初始化，每个节点只重置用到的箱子
+        struct SAHBin
+        {
+            BVHBounds m_Bounds;
+            std::uint32_t m_Count;
+
+            void Reset() noexcept
+            {
+                m_Bounds = {};
+                m_Count = 0;
+            }
+
+            void Grow(const SAHBin& other) noexcept
+            {
+                m_Bounds.Grow(other.m_Bounds);
+                m_Count += other.m_Count;
+            }
+        };
+
+        struct SAHBins
+        {
+            SAHBin m_Bins[3][kMaxBins];
+
+            void Reset(std::uint32_t numBins) noexcept
+            {
+                for (auto& axisBins : m_Bins) {
+                    for (std::uint32_t i = 0; i < numBins; ++i) axisBins[i].Reset();
+                }
+            }
+        };
+    }
+
+    void BVHBounds::Grow(const BVHFloat3& point) noexcept
+    {
+        m_Min = {(std::min)(m_Min.x, point.x), (std::min)(m_Min.y, point.y), (std::min)(m_Min.z, point.z)};
+        m_Max = {(std::max)(m_Max.x, point.x), (std::max)(m_Max.y, point.y), (std::max)(m_Max.z, point.z)};
+    }
+
+    void BVHBounds::Grow(const BVHBounds& bounds) noexcept
+    {
+        m_Min = {(std::min)(m_Min.x, bounds.m_Min.x), (std::min)(m_Min.y, bounds.m_Min.y), (std::min)(m_Min.z, bounds.m_Min.z)};
+        m_Max = {(std::max)(m_Max.x, bounds.m_Max.x), (std::max)(m_Max.y, bounds.m_Max.y), (std::max)(m_Max.z, bounds.m_Max.z)};
+    }
+
+    float BVHBounds::SurfaceArea() const noexcept
+    {
+        if (!IsValid()) return 0;
+        float x = m_Max.x - m_Min.x;
+        float y = m_Max.y - m_Min.y;
+        float z = m_Max.z - m_Min.z;
+        return 2 * (x * y + y * z + z * x);
+    }
+
+    struct BVH::SAHBuildContext
+    {
+        std::atomic<std::uint32_t> m_NumNodes{};
+        // 小于该深度的大节点在新线程中构建左子树
+        std::uint32_t m_MaxTaskDepth = 0;
+    };
+
+    void BVH::Build(std::span<const BVHGeometry> geometries, const BVHBuildDesc& desc)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        Clear();
+
+        m_Desc = desc;
+        m_Desc.m_Width = m_Desc.m_Width > 4 ? 8 : 4;
+        m_Desc.m_MaxLeafSize = std::clamp(m_Desc.m_MaxLeafSize, 1u, kMaxLeafSize);
+        m_Desc.m_NumBins = std::clamp(m_Desc.m_NumBins, 2u, kMaxBins);
+        m_NumThreads = m_Desc.m_NumThreads == 0 ? (std::max)(std::thread::hardware_concurrency(), 1u) : m_Desc.m_NumThreads;
+
+        GatherTriangles(geometries);
+        if (!m_Triangles.empty()) {
+            auto root = m_Desc.m_Method == BVHBuildMethod::kLBVH ? BuildLBVH() : BuildBinnedSAH();
+            m_Bounds = m_BinaryNodes[root].m_Bounds;
+            if (m_Desc.m_Width == 8) {
+                Collapse<8>(root);
+            }
+            else {
+                Collapse<4>(root);
+            }
+        }
+
+        // 释放构建过程中的临时数据
+        m_Triangles = {};
+        m_PrimRefs = {};
+        m_BinaryNodes = {};
+
+        m_Stats.m_BuildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    void BVH::Clear()
+    {
+        m_Bounds = {};
+        m_Stats = {};
+        m_Nodes4.clear();
+        m_Nodes8.clear();
+        m_Blocks.clear();
+        m_Root = sm_InvalidNode;
+    }
+
+    void BVH::GatherTriangles(std::span<const BVHGeometry> geometries)
+    {
+        // 每个几何体的第一个三角形在所有三角形中的索引
+        std::vector<std::uint32_t> offsets(geometries.size() + 1);
+        for (std::size_t i = 0; i < geometries.size(); ++i) {
+            const auto& geometry = geometries[i];
+            auto numIndices = geometry.m_Indices != nullptr ? geometry.m_NumIndices : geometry.m_NumVertices;
+            offsets[i + 1] = offsets[i] + (geometry.m_Positions != nullptr ? numIndices / 3 : 0);
+        }
+
+        auto numTriangles = offsets.back();
+        m_Triangles.resize(numTriangles);
+        m_PrimRefs.resize(numTriangles);
+        Utility::ParallelFor(numTriangles, m_NumThreads, [&](std::uint32_t begin, std::uint32_t end) {
+            auto geometryIndex = static_cast<std::uint32_t>(std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1);
+            for (auto i = begin; i < end; ++i) {
+                while (i >= offsets[geometryIndex + 1]) ++geometryIndex;
+                const auto& geometry = geometries[geometryIndex];
+                auto primitive = i - offsets[geometryIndex];
+
+                auto& triangle = m_Triangles[i];
+                triangle.m_Geometry = geometryIndex;
+                triangle.m_Primitive = primitive;
+                BVHBounds bounds{};
+                for (std::uint32_t v = 0; v < 3; ++v) {
+                    auto index = geometry.m_Indices != nullptr ? geometry.m_Indices[primitive * 3 + v] : primitive * 3 + v;
+                    triangle.m_Vertices[v] = ReadPosition(geometry, index + geometry.m_BaseVertex);
+                    bounds.Grow(triangle.m_Vertices[v]);
+                }
+                m_PrimRefs[i] = {bounds, i};
+            }
+        });
+    }
+
+    std::uint32_t BVH::BuildBinnedSAH()
+    {
+        auto numPrims = static_cast<std::uint32_t>(m_Triangles.size());
+        m_BinaryNodes.resize(std::size_t(numPrims) * 2 - 1);
+
+        auto& root = m_BinaryNodes[0];
+        root.m_First = 0;
+        root.m_Count = numPrims;
+        BVHBounds centroidBounds{};
+        for (const auto& ref : m_PrimRefs) {
+            root.m_Bounds.Grow(ref.m_Bounds);
+            centroidBounds.Grow(GetCentroid(ref.m_Bounds));
+        }
+
+        SAHBuildContext context{};
+        context.m_NumNodes = 1;
+        context.m_MaxTaskDepth = std::bit_width(m_NumThreads - 1);
+        BuildSAHNode(context, 0, centroidBounds, 0);
+        m_BinaryNodes.resize(context.m_NumNodes);
+
+        return 0;
+    }
+
+    void BVH::BuildSAHNode(SAHBuildContext& context, std::uint32_t nodeIndex, const BVHBounds& centroidBounds, std::uint32_t depth)
+    {
+        // 节点数组已按最大数量分配，引用不会失效
+        auto& node = m_BinaryNodes[nodeIndex];
+        node.m_Left = node.m_Right = sm_InvalidNode;
+        if (node.m_Count <= m_Desc.m_MaxLeafSize) return;
+
+        auto first = node.m_First;
+        auto count = node.m_Count;
+        auto numBins = m_Desc.m_NumBins;
+
+        // 每个轴上质心到箱子的映射，质心范围为 0 的轴不参与划分
+        float binScale[3]{};
+        float binMin[3]{};
+        for (std::uint32_t axis = 0; axis < 3; ++axis) {
+            binMin[axis] = GetAxis(centroidBounds.m_Min, axis);
+            auto extent = GetAxis(centroidBounds.m_Max, axis) - binMin[axis];
+            binScale[axis] = extent > 0 ? numBins * (1 - 1e-6f) / extent : 0;
+        }
+        auto getBin = [&](const BVHFloat3& centroid, std::uint32_t axis) {
+            auto bin = static_cast<std::uint32_t>((GetAxis(centroid, axis) - binMin[axis]) * binScale[axis]);
+            return (std::min)(bin, numBins - 1);
+        };
+
+        auto binRange = [&](SAHBins& bins, std::uint32_t begin, std::uint32_t end) {
+            for (auto i = begin; i < end; ++i) {
+                const auto& bounds = m_PrimRefs[first + i].m_Bounds;
+                auto centroid = GetCentroid(bounds);
+                for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                    auto& bin = bins.m_Bins[axis][getBin(centroid, axis)];
+                    bin.m_Bounds.Grow(bounds);
+                    ++bin.m_Count;
+                }
+            }
+        };
+
+        SAHBins bins;
+        bins.Reset(numBins);
+        auto numBinThreads = depth < 32 ? (std::max)(m_NumThreads >> depth, 1u) : 1u;
+        if (count > kParallelBinThreshold && numBinThreads > 1) {
+            // 每个线程分箱一段图元后再合并
+            std::uint32_t chunk = (count + numBinThreads - 1) / numBinThreads;
+            std::vector<SAHBins> threadBins(numBinThreads);
+            Utility::ParallelFor(numBinThreads, numBinThreads, [&](std::uint32_t begin, std::uint32_t end) {
+                for (auto t = begin; t < end; ++t) {
+                    threadBins[t].Reset(numBins);
+                    binRange(threadBins[t], (std::min)(t * chunk, count), (std::min)((t + 1) * chunk, count));
+                }
+            });
+            for (const auto& threadBin : threadBins) {
+                for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                    for (std::uint32_t i = 0; i < numBins; ++i) {
+                        bins.m_Bins[axis][i].Grow(threadBin.m_Bins[axis][i]);
+                    }
+                }
+            }
+        }
+        else {
+            binRange(bins, 0, count);
+        }
+
+        // 从右向左累积后再从左向右扫描所有划分位置
+        auto parentArea = node.m_Bounds.SurfaceArea();
+        auto bestCost = std::numeric_limits<float>::infinity();
+        std::uint32_t bestAxis = 0;
+        std::uint32_t bestSplit = 0;
+        for (std::uint32_t axis = 0; axis < 3; ++axis) {
+            if (binScale[axis] == 0) continue;
+
+            float rightCost[kMaxBins];
+            SAHBin right;
+            right.Reset();
+            for (auto i = numBins - 1; i > 0; --i) {
+                right.Grow(bins.m_Bins[axis][i]);
+                rightCost[i] = right.m_Bounds.SurfaceArea() * right.m_Count;
+            }
+            SAHBin left;
+            left.Reset();
+            for (std::uint32_t i = 0; i + 1 < numBins; ++i) {
+                left.Grow(bins.m_Bins[axis][i]);
+                auto cost = left.m_Bounds.SurfaceArea() * left.m_Count + rightCost[i + 1];
+                if (left.m_Count > 0 && left.m_Count < count && cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i + 1;
+                }
+            }
+        }
+
+        std::uint32_t numLeft = 0;
+        BVHBounds leftBounds{}, rightBounds{}, leftCentroids{}, rightCentroids{};
+        if (bestSplit != 0 && parentArea > 0) {
+            // 划分的同时计算两侧的质心范围
+            auto i = first;
+            auto j = first + count;
+            while (i < j) {
+                auto centroid = GetCentroid(m_PrimRefs[i].m_Bounds);
+                if (getBin(centroid, bestAxis) < bestSplit) {
+                    leftCentroids.Grow(centroid);
+                    ++i;
+                }
+                else {
+                    rightCentroids.Grow(centroid);
+                    std::swap(m_PrimRefs[i], m_PrimRefs[--j]);
+                }
+            }
+            numLeft = i - first;
+            for (std::uint32_t b = 0; b < numBins; ++b) {
+                (b < bestSplit ? leftBounds : rightBounds).Grow(bins.m_Bins[bestAxis][b].m_Bounds);
+            }
+        }
+        else {
+            // 质心重合时无法分箱，按顺序对半划分
+            numLeft = count / 2;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const auto& bounds = m_PrimRefs[first + i].m_Bounds;
+                (i < numLeft ? leftBounds : rightBounds).Grow(bounds);
+                (i < numLeft ? leftCentroids : rightCentroids).Grow(GetCentroid(bounds));
+            }
+        }
+
+        auto leftIndex = context.m_NumNodes.fetch_add(2, std::memory_order_relaxed);
+        auto rightIndex = leftIndex + 1;
+        node.m_Left = leftIndex;
+        node.m_Right = rightIndex;
+        m_BinaryNodes[leftIndex] = {leftBounds, sm_InvalidNode, sm_InvalidNode, first, numLeft};
+        m_BinaryNodes[rightIndex] = {rightBounds, sm_InvalidNode, sm_InvalidNode, first + numLeft, count - numLeft};
+
+        if (count > kParallelTaskThreshold && depth < context.m_MaxTaskDepth) {
+            std::thread leftTask([&, leftIndex]() { BuildSAHNode(context, leftIndex, leftCentroids, depth + 1); });
+            BuildSAHNode(context, rightIndex, rightCentroids, depth + 1);
+            leftTask.join();
+        }
+        else {
+            BuildSAHNode(context, leftIndex, leftCentroids, depth + 1);
+            BuildSAHNode(context, rightIndex, rightCentroids, depth + 1);
+        }
+    }
+
+    std::uint32_t BVH::BuildLBVH()
+    {
+        auto numPrims = static_cast<std::uint32_t>(m_Triangles.size());
+        BVHBounds centroidBounds{};
+        for (const auto& ref : m_PrimRefs) {
+            centroidBounds.Grow(GetCentroid(ref.m_Bounds));
+        }
+
+        // 按质心在场景中的位置计算 63 位 Morton 码
+        float scale[3]{};
+        for (std::uint32_t axis = 0; axis < 3; ++axis) {
+            auto extent = GetAxis(centroidBounds.m_Max, axis) - GetAxis(centroidBounds.m_Min, axis);
+            scale[axis] = extent > 0 ? ((1u << kMortonBits) - 1) / extent : 0;
+        }
+        std::vector<std::uint64_t> keys(numPrims);
+        Utility::ParallelFor(numPrims, m_NumThreads, [&](std::uint32_t begin, std::uint32_t end) {
+            for (auto i = begin; i < end; ++i) {
+                auto centroid = GetCentroid(m_PrimRefs[i].m_Bounds);
+                std::uint64_t key = 0;
+                for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                    auto cell = (GetAxis(centroid, axis) - GetAxis(centroidBounds.m_Min, axis)) * scale[axis];
+                    key |= ExpandBits(static_cast<std::uint64_t>(cell)) << (2 - axis);
+                }
+                keys[i] = key;
+            }
+        });
+
+        // 每次 8 位的基数排序，所有键在该字节上相同时跳过
+        std::vector<std::uint32_t> order(numPrims);
+        for (std::uint32_t i = 0; i < numPrims; ++i) order[i] = i;
+        std::vector<std::uint64_t> tempKeys(numPrims);
+        std::vector<std::uint32_t> tempOrder(numPrims);
+        for (std::uint32_t shift = 0; shift < kMortonBits * 3; shift += 8) {
+            std::array<std::uint32_t, 256> offsets{};
+            for (auto key : keys) ++offsets[(key >> shift) & 0xff];
+            if (offsets[(keys[0] >> shift) & 0xff] == numPrims) continue;
+
+            std::uint32_t sum = 0;
+            for (auto& offset : offsets) {
+                auto bucket = offset;
+                offset = sum;
+                sum += bucket;
+            }
+            for (std::uint32_t i = 0; i < numPrims; ++i) {
+                auto dest = offsets[(keys[i] >> shift) & 0xff]++;
+                tempKeys[dest] = keys[i];
+                tempOrder[dest] = order[i];
+            }
+            keys.swap(tempKeys);
+            order.swap(tempOrder);
+        }
+        std::vector<PrimRef> sortedRefs(numPrims);
+        for (std::uint32_t i = 0; i < numPrims; ++i) sortedRefs[i] = m_PrimRefs[order[i]];
+        m_PrimRefs.swap(sortedRefs);
+
+        // 内部节点为 [0, numPrims - 1)，之后为按排序顺序的叶节点
+        auto numInternal = numPrims - 1;
+        m_BinaryNodes.resize(std::size_t(numPrims) * 2 - 1);
+        std::vector<std::uint32_t> parents(m_BinaryNodes.size(), sm_InvalidNode);
+        for (std::uint32_t i = 0; i < numPrims; ++i) {
+            m_BinaryNodes[numInternal + i] = {m_PrimRefs[i].m_Bounds, sm_InvalidNode, sm_InvalidNode, i, 1};
+        }
+        if (numPrims == 1) return 0;
+
+        // 相邻键的公共前缀长度，键相同时用索引区分
+        auto delta = [&](std::int64_t i, std::int64_t j) -> int {
+            if (j < 0 || j >= numPrims) return -1;
+            auto a = keys[i];
+            auto b = keys[j];
+            if (a == b) return 64 + std::countl_zero(static_cast<std::uint32_t>(i ^ j));
+            return std::countl_zero(a ^ b);
+        };
+
+        // Karras 2012，每个内部节点独立地找到自己的范围与划分位置
+        Utility::ParallelFor(numInternal, m_NumThreads, [&](std::uint32_t begin, std::uint32_t end) {
+            for (std::int64_t i = begin; i < end; ++i) {
+                std::int64_t d = delta(i, i + 1) - delta(i, i - 1) >= 0 ? 1 : -1;
+                auto deltaMin = delta(i, i - d);
+                std::int64_t maxLength = 2;
+                while (delta(i, i + maxLength * d) > deltaMin) maxLength *= 2;
+                std::int64_t length = 0;
+                for (auto t = maxLength / 2; t >= 1; t /= 2) {
+                    if (delta(i, i + (length + t) * d) > deltaMin) length += t;
+                }
+                auto j = i + length * d;
+
+                auto deltaNode = delta(i, j);
+                std::int64_t split = 0;
+                for (std::int64_t divisor = 2, t = 0; t != 1; divisor *= 2) {
+                    t = (length + divisor - 1) / divisor;
+                    if (delta(i, i + (split + t) * d) > deltaNode) split += t;
+                }
+                auto gamma = static_cast<std::uint32_t>(i + split * d + (std::min)(d, std::int64_t(0)));
+
+                auto first = static_cast<std::uint32_t>((std::min)(i, j));
+                auto last = static_cast<std::uint32_t>((std::max)(i, j));
+                auto& node = m_BinaryNodes[i];
+                node.m_Left = first == gamma ? numInternal + gamma : gamma;
+                node.m_Right = last == gamma + 1 ? numInternal + gamma + 1 : gamma + 1;
+                node.m_First = first;
+                node.m_Count = last - first + 1;
+                parents[node.m_Left] = static_cast<std::uint32_t>(i);
+                parents[node.m_Right] = static_cast<std::uint32_t>(i);
+            }
+        });
+
+        // 从叶节点向上合并包围盒，第二个到达父节点的线程负责父节点
+        std::vector<std::atomic<std::uint32_t>> visits(numInternal);
+        Utility::ParallelFor(numPrims, m_NumThreads, [&](std::uint32_t begin, std::uint32_t end) {
+            for (auto i = begin; i < end; ++i) {
+                auto parent = parents[numInternal + i];
+                while (parent != sm_InvalidNode) {
+                    if (visits[parent].fetch_add(1, std::memory_order_acq_rel) == 0) break;
+                    auto& node = m_BinaryNodes[parent];
+                    node.m_Bounds = m_BinaryNodes[node.m_Left].m_Bounds;
+                    node.m_Bounds.Grow(m_BinaryNodes[node.m_Right].m_Bounds);
+                    parent = parents[parent];
+                }
+            }
+        });
+
+        return 0;
+    }
+
+    template <std::uint32_t N>
+    void BVH::Collapse(std::uint32_t binaryRoot)
+    {
+        auto& nodes = [this]() -> std::vector<WideNode<N>>& {
+            if constexpr (N == 8) return m_Nodes8;
+            else return m_Nodes4;
+        }();
+        auto numPrims = static_cast<std::uint32_t>(m_Triangles.size());
+        nodes.reserve(numPrims / m_Desc.m_MaxLeafSize / (N - 1) + 1);
+        m_Blocks.reserve(numPrims / 2);
+
+        const auto& root = m_BinaryNodes[binaryRoot];
+        float cost = 0;
+        if (root.m_Left == sm_InvalidNode || root.m_Count <= m_Desc.m_MaxLeafSize) {
+            m_Root = EmitLeaf(root);
+            cost = m_Desc.m_IntersectionCost * root.m_Bounds.SurfaceArea() * root.m_Count;
+        }
+        else {
+            m_Root = CollapseNode(nodes, binaryRoot, 1, cost);
+        }
+
+        auto rootArea = root.m_Bounds.SurfaceArea();
+        m_Stats.m_NumNodes = static_cast<std::uint32_t>(nodes.size());
+        m_Stats.m_NumTriangles = numPrims;
+        m_Stats.m_SAHCost = rootArea > 0 ? cost / rootArea : 0;
+    }
+
+    template <std::uint32_t N>
+    std::uint32_t BVH::CollapseNode(std::vector<WideNode<N>>& nodes, std::uint32_t binaryNode, std::uint32_t depth, float& cost)
+    {
+        auto isLeaf = [this](std::uint32_t index) {
+            const auto& node = m_BinaryNodes[index];
+            return node.m_Left == sm_InvalidNode || node.m_Count <= m_Desc.m_MaxLeafSize;
+        };
+
+        // 不断展开表面积最大的内部子节点，直到填满 N 个子节点
+        const auto& node = m_BinaryNodes[binaryNode];
+        std::uint32_t children[N]{node.m_Left, node.m_Right};
+        std::uint32_t numChildren = 2;
+        while (numChildren < N) {
+            std::uint32_t best = N;
+            float bestArea = -1;
+            for (std::uint32_t i = 0; i < numChildren; ++i) {
+                auto area = m_BinaryNodes[children[i]].m_Bounds.SurfaceArea();
+                if (!isLeaf(children[i]) && area > bestArea) {
+                    best = i;
+                    bestArea = area;
+                }
+            }
+            if (best == N) break;
+
+            const auto& expand = m_BinaryNodes[children[best]];
+            children[best] = expand.m_Left;
+            children[numChildren++] = expand.m_Right;
+        }
+
+        auto index = static_cast<std::uint32_t>(nodes.size());
+        auto& wideNode = nodes.emplace_back();
+        for (std::uint32_t i = 0; i < N; ++i) {
+            // 空的子节点使用反向的包围盒，射线永远不会与其相交
+            for (std::uint32_t c = 0; c < 3; ++c) {
+                wideNode.m_Bounds[c][i] = std::numeric_limits<float>::infinity();
+                wideNode.m_Bounds[c + 3][i] = -std::numeric_limits<float>::infinity();
+            }
+            wideNode.m_Children[i] = sm_InvalidNode;
+        }
+        cost += m_Desc.m_TraversalCost * node.m_Bounds.SurfaceArea();
+        m_Stats.m_MaxDepth = (std::max)(m_Stats.m_MaxDepth, depth);
+
+        for (std::uint32_t i = 0; i < numChildren; ++i) {
+            const auto& child = m_BinaryNodes[children[i]];
+            std::uint32_t code = 0;
+            if (isLeaf(children[i])) {
+                code = EmitLeaf(child);
+                cost += m_Desc.m_IntersectionCost * child.m_Bounds.SurfaceArea() * child.m_Count;
+            }
+            else {
+                code = CollapseNode(nodes, children[i], depth + 1, cost);
+            }
+
+            // 递归时数组可能已经扩容
+            auto& dest = nodes[index];
+            const float bounds[6]{child.m_Bounds.m_Min.x, child.m_Bounds.m_Min.y, child.m_Bounds.m_Min.z,
+                child.m_Bounds.m_Max.x, child.m_Bounds.m_Max.y, child.m_Bounds.m_Max.z};
+            for (std::uint32_t c = 0; c < 6; ++c) {
+                dest.m_Bounds[c][i] = bounds[c];
+            }
+            dest.m_Children[i] = code;
+        }
+
+        return index;
+    }
+
+    std::uint32_t BVH::EmitLeaf(const BinaryNode& node)
+    {
+        auto firstBlock = static_cast<std::uint32_t>(m_Blocks.size());
+        auto numBlocks = (node.m_Count + 3) / 4;
+        for (std::uint32_t b = 0; b < numBlocks; ++b) {
+            auto& block = m_Blocks.emplace_back();
+            for (std::uint32_t lane = 0; lane < 4; ++lane) {
+                auto prim = b * 4 + lane;
+                if (prim >= node.m_Count) {
+                    // 退化的三角形，求交时行列式为 0
+                    for (std::uint32_t c = 0; c < 3; ++c) {
+                        block.m_V0[c][lane] = block.m_E1[c][lane] = block.m_E2[c][lane] = 0;
+                    }
+                    block.m_Geometry[lane] = block.m_Primitive[lane] = BVHHit::sm_InvalidIndex;
+                    continue;
+                }
+
+                const auto& triangle = m_Triangles[m_PrimRefs[node.m_First + prim].m_Triangle];
+                for (std::uint32_t c = 0; c < 3; ++c) {
+                    auto v0 = GetAxis(triangle.m_Vertices[0], c);
+                    block.m_V0[c][lane] = v0;
+                    block.m_E1[c][lane] = GetAxis(triangle.m_Vertices[1], c) - v0;
+                    block.m_E2[c][lane] = GetAxis(triangle.m_Vertices[2], c) - v0;
+                }
+                block.m_Geometry[lane] = triangle.m_Geometry;
+                block.m_Primitive[lane] = triangle.m_Primitive;
+            }
+        }
+        ++m_Stats.m_NumLeaves;
+
+        return sm_LeafFlag | ((numBlocks - 1) << sm_LeafBlockShift) | firstBlock;
+    }
+}
@@ -0,0 +1,220 @@
+#pragma once
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace DSM {
+    struct BVHFloat3
+    {
+        float x = 0;
+        float y = 0;
+        float z = 0;
+    };
+
+    struct BVHBounds
+    {
+        BVHFloat3 m_Min{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
+        BVHFloat3 m_Max{-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+
+        void Grow(const BVHFloat3& point) noexcept;
+        void Grow(const BVHBounds& bounds) noexcept;
+        float SurfaceArea() const noexcept;
+        bool IsValid() const noexcept { return m_Min.x <= m_Max.x && m_Min.y <= m_Max.y && m_Min.z <= m_Max.z; }
+    };
+
+    // 三角形网格，位置按字节步长读取，可以直接使用 XMFLOAT3 数组或交错排列的顶点
+    // 索引为空时每三个顶点组成一个三角形
+    struct BVHGeometry
+    {
+        const void* m_Positions{};
+        std::uint32_t m_PositionStride = sizeof(float) * 3;
+        std::uint32_t m_NumVertices{};
+        const std::uint32_t* m_Indices{};
+        std::uint32_t m_NumIndices{};
+        // 加到每个索引上，与 SubMesh::m_VertexOffset 相同
+        std::uint32_t m_BaseVertex{};
+    };
+
+    enum class BVHBuildMethod : std::uint8_t
+    {
+        // 分箱的表面积启发式，遍历最快，用于静态几何
+        kBinnedSAH,
+        // 按 Morton 码排序的线性 BVH，构建最快，用于每帧重建的动态几何
+        kLBVH
+    };
+
+    struct BVHBuildDesc
+    {
+        BVHBuildMethod m_Method = BVHBuildMethod::kBinnedSAH;
+        // 每个节点的子节点数，4 或 8
+        std::uint32_t m_Width = 4;
+        // 0 表示使用所有硬件线程
+        std::uint32_t m_NumThreads = 0;
+        // 不超过 16
+        std::uint32_t m_MaxLeafSize = 4;
+        std::uint32_t m_NumBins = 16;
+        // SAH 中遍历一个节点与求交一个三角形的相对代价
+        float m_TraversalCost = 1.0f;
+        float m_IntersectionCost = 1.0f;
+    };
+
+    // 与 DXR 的 RAY_FLAG_CULL_*_FACING_TRIANGLES 相同，从射线起点看去顶点为顺时针的三角形为正面
+    enum class BVHCullMode : std::uint8_t
+    {
+        kNone,
+        kBackFacing,
+        kFrontFacing
+    };
+
+    struct BVHRay
+    {
+        BVHFloat3 m_Origin{};
+        float m_TMin = 0;
+        BVHFloat3 m_Direction{};
+        float m_TMax = std::numeric_limits<float>::infinity();
+        BVHCullMode m_CullMode = BVHCullMode::kNone;
+    };
+
+    struct BVHHit
+    {
+        inline static constexpr std::uint32_t sm_InvalidIndex = ~0u;
+
+        float m_T = std::numeric_limits<float>::infinity();
+        // 重心坐标，交点为 (1 - u - v) * v0 + u * v1 + v * v2
+        float m_U = 0;
+        float m_V = 0;
+        std::uint32_t m_Geometry = sm_InvalidIndex;
+        // 三角形在几何体中的索引
+        std::uint32_t m_Primitive = sm_InvalidIndex;
+
+        bool IsHit() const noexcept { return m_Primitive != sm_InvalidIndex; }
+    };
+
+    struct BVHStats
+    {
+        std::uint32_t m_NumNodes = 0;
+        std::uint32_t m_NumLeaves = 0;
+        std::uint32_t m_NumTriangles = 0;
+        std::uint32_t m_MaxDepth = 0;
+        // 相对于根节点表面积的期望遍历代价
+        float m_SAHCost = 0;
+        // 毫秒
+        double m_BuildTime = 0;
+    };
+
+    // 三角形的 CPU 加速结构，用于拾取、可见性、烘焙与验证 GPU 的结果
+    // 先构建二叉 BVH 再合并为 4 或 8 叉，遍历时用 SIMD 同时测试一个节点的所有子节点与叶节点中的 4 个三角形
+    class BVH
+    {
+    public:
+        // 射线包内同时测试的射线数，更大的包按该大小分批遍历
+        inline static constexpr std::uint32_t sm_PacketWidth = 8;
+
+        void Build(std::span<const BVHGeometry> geometries, const BVHBuildDesc& desc = {});
+        void Clear();
+
+        // 只接受比 hit 中更近的交点，没有时 hit 不变，多个 BVH 可以依次求交同一个 hit
+        bool Intersect(const BVHRay& ray, BVHHit& hit) const;
+        // 任意交点，用于阴影与可见性
+        bool Occluded(const BVHRay& ray) const;
+        // 方向相近的射线一起遍历以共享节点的读取与测试，rays 与输出的数量相同
+        void IntersectPacket(std::span<const BVHRay> rays, std::span<BVHHit> hits) const;
+        void OccludedPacket(std::span<const BVHRay> rays, std::span<bool> occluded) const;
+
+        bool Empty() const noexcept { return m_Blocks.empty(); }
+        const BVHBounds& GetBounds() const noexcept { return m_Bounds; }
+        const BVHStats& GetStats() const noexcept { return m_Stats; }
+
+    private:
+        struct BinaryNode
+        {
+            BVHBounds m_Bounds{};
+            // 叶节点的子节点为 sm_InvalidNode
+            std::uint32_t m_Left{};
+            std::uint32_t m_Right{};
+            // 子树中的图元在 m_PrimRefs 中的范围
+            std::uint32_t m_First{};
+            std::uint32_t m_Count{};
+        };
+
+        // 子节点的包围盒按分量分开排列，依次为 min xyz 与 max xyz
+        template <std::uint32_t N>
+        struct WideNode
+        {
+            alignas(32) float m_Bounds[6][N];
+            std::uint32_t m_Children[N];
+        };
+
+        // 4 个三角形一组，按分量分开排列以便同时求交，不足 4 个时用退化的三角形填充
+        struct TriangleBlock
+        {
+            alignas(16) float m_V0[3][4];
+            float m_E1[3][4];
+            float m_E2[3][4];
+            std::uint32_t m_Geometry[4];
+            std::uint32_t m_Primitive[4];
+        };
+
+        // 构建时按包围盒划分的图元，连续存放以减少缓存未命中
+        struct PrimRef
+        {
+            BVHBounds m_Bounds{};
+            std::uint32_t m_Triangle{};
+        };
+
+        struct BuildTriangle
+        {
+            BVHFloat3 m_Vertices[3]{};
+            std::uint32_t m_Geometry{};
+            std::uint32_t m_Primitive{};
+        };
+
+        inline static constexpr std::uint32_t sm_InvalidNode = ~0u;
+        // 子节点的最高位表示叶节点，之后 3 位为三角形组数减一，其余为第一个三角形组
+        inline static constexpr std::uint32_t sm_LeafFlag = 0x80000000u;
+        inline static constexpr std::uint32_t sm_LeafBlockShift = 28;
+        inline static constexpr std::uint32_t sm_LeafFirstMask = (1u << sm_LeafBlockShift) - 1;
+
+        struct SAHBuildContext;
+
+        void GatherTriangles(std::span<const BVHGeometry> geometries);
+        std::uint32_t BuildBinnedSAH();
+        void BuildSAHNode(SAHBuildContext& context, std::uint32_t node, const BVHBounds& centroidBounds, std::uint32_t depth);
+        std::uint32_t BuildLBVH();
+
+        template <std::uint32_t N>
+        void Collapse(std::uint32_t binaryRoot);
+        template <std::uint32_t N>
+        std::uint32_t CollapseNode(std::vector<WideNode<N>>& nodes, std::uint32_t binaryNode, std::uint32_t depth, float& cost);
+        std::uint32_t EmitLeaf(const BinaryNode& node);
+
+        template <std::uint32_t N>
+        bool IntersectWide(const std::vector<WideNode<N>>& nodes, const BVHRay& ray, BVHHit* hit) const;
+        template <std::uint32_t N>
+        void IntersectPacketWide(const std::vector<WideNode<N>>& nodes, const BVHRay* rays, std::uint32_t numRays,
+            BVHHit* hits, bool* occluded) const;
+
+    private:
+        BVHBuildDesc m_Desc{};
+        BVHBounds m_Bounds{};
+        BVHStats m_Stats{};
+
+        std::vector<WideNode<4>> m_Nodes4{};
+        std::vector<WideNode<8>> m_Nodes8{};
+        std::vector<TriangleBlock> m_Blocks{};
+        // 根节点，只有一个叶节点时为叶节点的编码
+        std::uint32_t m_Root = sm_InvalidNode;
+
+        // 构建过程中的临时数据
+        std::vector<BuildTriangle> m_Triangles{};
+        std::vector<PrimRef> m_PrimRefs{};
+        std::vector<BinaryNode> m_BinaryNodes{};
+        std::uint32_t m_NumThreads = 1;
+    };
+}
+
+#endif
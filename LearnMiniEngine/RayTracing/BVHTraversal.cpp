@@ -0,0 +1,514 @@
+#include "BVH.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define DSM_BVH_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define DSM_BVH_AVX 1
+#include <immintrin.h>
+#endif
+
+namespace DSM {
+    namespace {
+        // 遍历栈的容量，足够深度约 128 的 8 叉树
+        constexpr std::uint32_t kStackSize = 1024;
+        // 方向分量的最小绝对值，避免倒数为无穷时 0 * inf 产生 NaN
+        constexpr float kMinDirection = 1e-20f;
+
+        // 4 个与 8 个浮点数的 SIMD 封装，比较的结果为每个通道一位的掩码
+        struct Float4
+        {
+#ifdef DSM_BVH_SSE
+            __m128 m_V;
+
+            static Float4 Load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+            static Float4 Set1(float v) noexcept { return {_mm_set1_ps(v)}; }
+            void Store(float* p) const noexcept { _mm_storeu_ps(p, m_V); }
+#else
+            float m_V[4];
+
+            static Float4 Load(const float* p) noexcept { return {{p[0], p[1], p[2], p[3]}}; }
+            static Float4 Set1(float v) noexcept { return {{v, v, v, v}}; }
+            void Store(float* p) const noexcept { std::copy_n(m_V, 4, p); }
+#endif
+        };
+
+#ifdef DSM_BVH_SSE
+        inline Float4 operator+(Float4 a, Float4 b) noexcept { return {_mm_add_ps(a.m_V, b.m_V)}; }
+        inline Float4 operator-(Float4 a, Float4 b) noexcept { return {_mm_sub_ps(a.m_V, b.m_V)}; }
+        inline Float4 operator*(Float4 a, Float4 b) noexcept { return {_mm_mul_ps(a.m_V, b.m_V)}; }
+        inline Float4 operator/(Float4 a, Float4 b) noexcept { return {_mm_div_ps(a.m_V, b.m_V)}; }
+        inline Float4 Min(Float4 a, Float4 b) noexcept { return {_mm_min_ps(a.m_V, b.m_V)}; }
+        inline Float4 Max(Float4 a, Float4 b) noexcept { return {_mm_max_ps(a.m_V, b.m_V)}; }
+        inline std::uint32_t Less(Float4 a, Float4 b) noexcept { return _mm_movemask_ps(_mm_cmplt_ps(a.m_V, b.m_V)); }
+        inline std::uint32_t LessEqual(Float4 a, Float4 b) noexcept { return _mm_movemask_ps(_mm_cmple_ps(a.m_V, b.m_V)); }
+        inline std::uint32_t NotEqual(Float4 a, Float4 b) noexcept { return _mm_movemask_ps(_mm_cmpneq_ps(a.m_V, b.m_V)); }
+#else
+        template <typename Op>
+        inline Float4 Map(Float4 a, Float4 b, Op op) noexcept
+        {
+            Float4 result{};
+            for (int i = 0; i < 4; ++i) result.m_V[i] = op(a.m_V[i], b.m_V[i]);
+            return result;
+        }
+        template <typename Op>
+        inline std::uint32_t Compare(Float4 a, Float4 b, Op op) noexcept
+        {
+            std::uint32_t mask = 0;
+            for (int i = 0; i < 4; ++i) mask |= op(a.m_V[i], b.m_V[i]) ? 1u << i : 0;
+            return mask;
+        }
+        inline Float4 operator+(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x + y; }); }
+        inline Float4 operator-(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x - y; }); }
+        inline Float4 operator*(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x * y; }); }
+        inline Float4 operator/(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x / y; }); }
+        inline Float4 Min(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+        inline Float4 Max(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+        inline std::uint32_t Less(Float4 a, Float4 b) noexcept { return Compare(a, b, [](float x, float y) { return x < y; }); }
+        inline std::uint32_t LessEqual(Float4 a, Float4 b) noexcept { return Compare(a, b, [](float x, float y) { return x <= y; }); }
+        inline std::uint32_t NotEqual(Float4 a, Float4 b) noexcept { return Compare(a, b, [](float x, float y) { return x != y; }); }
+#endif
+
+        struct Float8
+        {
+#ifdef DSM_BVH_AVX
+            __m256 m_V;
+
+            static Float8 Load(const float* p) noexcept { return {_mm256_loadu_ps(p)}; }
+            static Float8 Set1(float v) noexcept { return {_mm256_set1_ps(v)}; }
+            void Store(float* p) const noexcept { _mm256_storeu_ps(p, m_V); }
+#else
+            Float4 m_Lo;
+            Float4 m_Hi;
+
+            static Float8 Load(const float* p) noexcept { return {Float4::Load(p), Float4::Load(p + 4)}; }
+            static Float8 Set1(float v) noexcept { return {Float4::Set1(v), Float4::Set1(v)}; }
+            void Store(float* p) const noexcept { m_Lo.Store(p); m_Hi.Store(p + 4); }
+#endif
+        };
+
+#ifdef DSM_BVH_AVX
+        inline Float8 operator+(Float8 a, Float8 b) noexcept { return {_mm256_add_ps(a.m_V, b.m_V)}; }
+        inline Float8 operator-(Float8 a, Float8 b) noexcept { return {_mm256_sub_ps(a.m_V, b.m_V)}; }
+        inline Float8 operator*(Float8 a, Float8 b) noexcept { return {_mm256_mul_ps(a.m_V, b.m_V)}; }
+        inline Float8 operator/(Float8 a, Float8 b) noexcept { return {_mm256_div_ps(a.m_V, b.m_V)}; }
+        inline Float8 Min(Float8 a, Float8 b) noexcept { return {_mm256_min_ps(a.m_V, b.m_V)}; }
+        inline Float8 Max(Float8 a, Float8 b) noexcept { return {_mm256_max_ps(a.m_V, b.m_V)}; }
+        inline std::uint32_t Less(Float8 a, Float8 b) noexcept { return _mm256_movemask_ps(_mm256_cmp_ps(a.m_V, b.m_V, _CMP_LT_OQ)); }
+        inline std::uint32_t LessEqual(Float8 a, Float8 b) noexcept { return _mm256_movemask_ps(_mm256_cmp_ps(a.m_V, b.m_V, _CMP_LE_OQ)); }
+        inline std::uint32_t NotEqual(Float8 a, Float8 b) noexcept { return _mm256_movemask_ps(_mm256_cmp_ps(a.m_V, b.m_V, _CMP_NEQ_OQ)); }
+#else
+        inline Float8 operator+(Float8 a, Float8 b) noexcept { return {a.m_Lo + b.m_Lo, a.m_Hi + b.m_Hi}; }
+        inline Float8 operator-(Float8 a, Float8 b) noexcept { return {a.m_Lo - b.m_Lo, a.m_Hi - b.m_Hi}; }
+        inline Float8 operator*(Float8 a, Float8 b) noexcept { return {a.m_Lo * b.m_Lo, a.m_Hi * b.m_Hi}; }
+        inline Float8 operator/(Float8 a, Float8 b) noexcept { return {a.m_Lo / b.m_Lo, a.m_Hi / b.m_Hi}; }
+        inline Float8 Min(Float8 a, Float8 b) noexcept { return {Min(a.m_Lo, b.m_Lo), Min(a.m_Hi, b.m_Hi)}; }
+        inline Float8 Max(Float8 a, Float8 b) noexcept { return {Max(a.m_Lo, b.m_Lo), Max(a.m_Hi, b.m_Hi)}; }
+        inline std::uint32_t Less(Float8 a, Float8 b) noexcept { return Less(a.m_Lo, b.m_Lo) | Less(a.m_Hi, b.m_Hi) << 4; }
+        inline std::uint32_t LessEqual(Float8 a, Float8 b) noexcept { return LessEqual(a.m_Lo, b.m_Lo) | LessEqual(a.m_Hi, b.m_Hi) << 4; }
+        inline std::uint32_t NotEqual(Float8 a, Float8 b) noexcept { return NotEqual(a.m_Lo, b.m_Lo) | NotEqual(a.m_Hi, b.m_Hi) << 4; }
+#endif
+
+        template <std::uint32_t N>
+        using FloatN = std::conditional_t<N == 8, Float8, Float4>;
+
+        float SafeInverse(float d) noexcept
+        {
+            if (std::abs(d) < kMinDirection) d = std::copysign(kMinDirection, d);
+            return 1 / d;
+        }
+
+        // 正面的行列式为正，det * sign < 0 的三角形被剔除
+        float FaceSign(BVHCullMode cullMode) noexcept
+        {
+            switch (cullMode) {
+                case BVHCullMode::kBackFacing: return 1;
+                case BVHCullMode::kFrontFacing: return -1;
+                default: return 0;
+            }
+        }
+
+        // 单条射线的预计算数据
+        struct RayData
+        {
+            float m_Origin[3];
+            float m_Direction[3];
+            float m_InvDirection[3];
+            float m_TMin;
+            float m_FaceSign;
+            // 方向为负的轴使用包围盒的最大值作为近平面
+            std::uint32_t m_Near[3];
+            std::uint32_t m_Far[3];
+
+            explicit RayData(const BVHRay& ray) noexcept
+                : m_Origin{ray.m_Origin.x, ray.m_Origin.y, ray.m_Origin.z},
+                m_Direction{ray.m_Direction.x, ray.m_Direction.y, ray.m_Direction.z},
+                m_TMin(ray.m_TMin),
+                m_FaceSign(FaceSign(ray.m_CullMode))
+            {
+                for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                    m_InvDirection[axis] = SafeInverse(m_Direction[axis]);
+                    bool negative = m_InvDirection[axis] < 0;
+                    m_Near[axis] = axis + (negative ? 3 : 0);
+                    m_Far[axis] = axis + (negative ? 0 : 3);
+                }
+            }
+        };
+
+        struct StackEntry
+        {
+            std::uint32_t m_Node;
+            // 单射线遍历时为进入节点的距离，射线包遍历时为与节点相交的射线掩码
+            union
+            {
+                float m_TNear;
+                std::uint32_t m_RayMask;
+            };
+        };
+
+        // 同时测试 N 个子节点的包围盒，返回相交的子节点掩码
+        template <std::uint32_t N>
+        std::uint32_t IntersectChildren(const float (&bounds)[6][N], const RayData& ray, float tMax, float* tNear) noexcept
+        {
+            using V = FloatN<N>;
+            V t0[3], t1[3];
+            for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                auto origin = V::Set1(ray.m_Origin[axis]);
+                auto invDirection = V::Set1(ray.m_InvDirection[axis]);
+                t0[axis] = (V::Load(bounds[ray.m_Near[axis]]) - origin) * invDirection;
+                t1[axis] = (V::Load(bounds[ray.m_Far[axis]]) - origin) * invDirection;
+            }
+            auto entry = Max(Max(t0[0], t0[1]), Max(t0[2], V::Set1(ray.m_TMin)));
+            auto exit = Min(Min(t1[0], t1[1]), Min(t1[2], V::Set1(tMax)));
+            entry.Store(tNear);
+            return LessEqual(entry, exit);
+        }
+
+        struct TriangleHit
+        {
+            float m_T;
+            float m_U;
+            float m_V;
+            std::uint32_t m_Lane;
+        };
+
+        // Möller–Trumbore，同时与 4 个三角形求交，返回 (tMin, tMax) 内最近的交点
+        template <typename Block>
+        bool IntersectBlock(const Block& block, const RayData& ray, float tMax, TriangleHit& hit) noexcept
+        {
+            auto e1x = Float4::Load(block.m_E1[0]), e1y = Float4::Load(block.m_E1[1]), e1z = Float4::Load(block.m_E1[2]);
+            auto e2x = Float4::Load(block.m_E2[0]), e2y = Float4::Load(block.m_E2[1]), e2z = Float4::Load(block.m_E2[2]);
+            auto dx = Float4::Set1(ray.m_Direction[0]), dy = Float4::Set1(ray.m_Direction[1]), dz = Float4::Set1(ray.m_Direction[2]);
+
+            auto px = dy * e2z - dz * e2y;
+            auto py = dz * e2x - dx * e2z;
+            auto pz = dx * e2y - dy * e2x;
+            auto det = e1x * px + e1y * py + e1z * pz;
+
+            auto tx = Float4::Set1(ray.m_Origin[0]) - Float4::Load(block.m_V0[0]);
+            auto ty = Float4::Set1(ray.m_Origin[1]) - Float4::Load(block.m_V0[1]);
+            auto tz = Float4::Set1(ray.m_Origin[2]) - Float4::Load(block.m_V0[2]);
+            auto qx = ty * e1z - tz * e1y;
+            auto qy = tz * e1x - tx * e1z;
+            auto qz = tx * e1y - ty * e1x;
+
+            auto zero = Float4::Set1(0);
+            auto invDet = Float4::Set1(1) / det;
+            auto u = (tx * px + ty * py + tz * pz) * invDet;
+            auto v = (dx * qx + dy * qy + dz * qz) * invDet;
+            auto t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+            auto mask = NotEqual(det, zero) & LessEqual(zero, det * Float4::Set1(ray.m_FaceSign)) &
+                LessEqual(zero, u) & LessEqual(zero, v) & LessEqual(u + v, Float4::Set1(1)) &
+                Less(Float4::Set1(ray.m_TMin), t) & Less(t, Float4::Set1(tMax));
+            if (mask == 0) return false;
+
+            alignas(16) float ts[4], us[4], vs[4];
+            t.Store(ts);
+            u.Store(us);
+            v.Store(vs);
+            hit.m_T = tMax;
+            for (; mask != 0; mask &= mask - 1) {
+                auto lane = static_cast<std::uint32_t>(std::countr_zero(mask));
+                if (ts[lane] < hit.m_T) {
+                    hit = {ts[lane], us[lane], vs[lane], lane};
+                }
+            }
+            return true;
+        }
+
+        // 射线包的数据，每个分量按射线分开排列
+        struct PacketData
+        {
+            float m_Origin[3][8];
+            float m_Direction[3][8];
+            float m_InvDirection[3][8];
+            float m_TMin[8];
+            float m_TMax[8];
+            float m_FaceSign[8];
+        };
+
+        // 一个子节点的包围盒与包内所有射线求交，射线方向不同，两个平面都需要比较
+        std::uint32_t IntersectPacketBounds(const PacketData& packet, const float (&bounds)[6], float* tNear) noexcept
+        {
+            auto entry = Float8::Load(packet.m_TMin);
+            auto exit = Float8::Load(packet.m_TMax);
+            for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                auto origin = Float8::Load(packet.m_Origin[axis]);
+                auto invDirection = Float8::Load(packet.m_InvDirection[axis]);
+                auto t0 = (Float8::Set1(bounds[axis]) - origin) * invDirection;
+                auto t1 = (Float8::Set1(bounds[axis + 3]) - origin) * invDirection;
+                entry = Max(entry, Min(t0, t1));
+                exit = Min(exit, Max(t0, t1));
+            }
+            entry.Store(tNear);
+            return LessEqual(entry, exit);
+        }
+
+        // 一个三角形与包内所有射线求交，返回命中的射线掩码
+        std::uint32_t IntersectPacketTriangle(const PacketData& packet, const float (&v0)[3], const float (&e1)[3], const float (&e2)[3],
+            float* ts, float* us, float* vs) noexcept
+        {
+            auto e1x = Float8::Set1(e1[0]), e1y = Float8::Set1(e1[1]), e1z = Float8::Set1(e1[2]);
+            auto e2x = Float8::Set1(e2[0]), e2y = Float8::Set1(e2[1]), e2z = Float8::Set1(e2[2]);
+            auto dx = Float8::Load(packet.m_Direction[0]), dy = Float8::Load(packet.m_Direction[1]), dz = Float8::Load(packet.m_Direction[2]);
+
+            auto px = dy * e2z - dz * e2y;
+            auto py = dz * e2x - dx * e2z;
+            auto pz = dx * e2y - dy * e2x;
+            auto det = e1x * px + e1y * py + e1z * pz;
+
+            auto tx = Float8::Load(packet.m_Origin[0]) - Float8::Set1(v0[0]);
+            auto ty = Float8::Load(packet.m_Origin[1]) - Float8::Set1(v0[1]);
+            auto tz = Float8::Load(packet.m_Origin[2]) - Float8::Set1(v0[2]);
+            auto qx = ty * e1z - tz * e1y;
+            auto qy = tz * e1x - tx * e1z;
+            auto qz = tx * e1y - ty * e1x;
+
+            auto zero = Float8::Set1(0);
+            auto invDet = Float8::Set1(1) / det;
+            auto u = (tx * px + ty * py + tz * pz) * invDet;
+            auto v = (dx * qx + dy * qy + dz * qz) * invDet;
+            auto t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+            auto mask = NotEqual(det, zero) & LessEqual(zero, det * Float8::Load(packet.m_FaceSign)) &
+                LessEqual(zero, u) & LessEqual(zero, v) & LessEqual(u + v, Float8::Set1(1)) &
+                Less(Float8::Load(packet.m_TMin), t) & Less(t, Float8::Load(packet.m_TMax));
+            if (mask != 0) {
+                t.Store(ts);
+                u.Store(us);
+                v.Store(vs);
+            }
+            return mask;
+        }
+    }
+
+    bool BVH::Intersect(const BVHRay& ray, BVHHit& hit) const
+    {
+        if (Empty()) return false;
+        return m_Desc.m_Width == 8 ? IntersectWide(m_Nodes8, ray, &hit) : IntersectWide(m_Nodes4, ray, &hit);
+    }
+
+    bool BVH::Occluded(const BVHRay& ray) const
+    {
+        if (Empty()) return false;
+        return m_Desc.m_Width == 8 ? IntersectWide(m_Nodes8, ray, nullptr) : IntersectWide(m_Nodes4, ray, nullptr);
+    }
+
+    void BVH::IntersectPacket(std::span<const BVHRay> rays, std::span<BVHHit> hits) const
+    {
+        if (Empty()) return;
+        auto numRays = static_cast<std::uint32_t>((std::min)(rays.size(), hits.size()));
+        for (std::uint32_t i = 0; i < numRays; i += sm_PacketWidth) {
+            auto count = (std::min)(numRays - i, sm_PacketWidth);
+            if (m_Desc.m_Width == 8) {
+                IntersectPacketWide(m_Nodes8, rays.data() + i, count, hits.data() + i, nullptr);
+            }
+            else {
+                IntersectPacketWide(m_Nodes4, rays.data() + i, count, hits.data() + i, nullptr);
+            }
+        }
+    }
+
+    void BVH::OccludedPacket(std::span<const BVHRay> rays, std::span<bool> occluded) const
+    {
+        auto numRays = static_cast<std::uint32_t>((std::min)(rays.size(), occluded.size()));
+        if (Empty()) {
+            std::fill_n(occluded.begin(), numRays, false);
+            return;
+        }
+        for (std::uint32_t i = 0; i < numRays; i += sm_PacketWidth) {
+            auto count = (std::min)(numRays - i, sm_PacketWidth);
+            if (m_Desc.m_Width == 8) {
+                IntersectPacketWide(m_Nodes8, rays.data() + i, count, nullptr, occluded.data() + i);
+            }
+            else {
+                IntersectPacketWide(m_Nodes4, rays.data() + i, count, nullptr, occluded.data() + i);
+            }
+        }
+    }
+
+    template <std::uint32_t N>
+    bool BVH::IntersectWide(const std::vector<WideNode<N>>& nodes, const BVHRay& ray, BVHHit* hit) const
+    {
+        RayData rayData{ray};
+        // 求最近交点时只接受比已有交点更近的交点
+        auto tMax = hit != nullptr ? (std::min)(ray.m_TMax, hit->m_T) : ray.m_TMax;
+        bool found = false;
+
+        StackEntry stack[kStackSize];
+        std::uint32_t stackSize = 0;
+        stack[stackSize++] = {m_Root, {ray.m_TMin}};
+        while (stackSize > 0) {
+            auto entry = stack[--stackSize];
+            if (entry.m_TNear > tMax) continue;
+
+            auto code = entry.m_Node;
+            if (code & sm_LeafFlag) {
+                auto firstBlock = code & sm_LeafFirstMask;
+                auto numBlocks = ((code & ~sm_LeafFlag) >> sm_LeafBlockShift) + 1;
+                for (auto b = firstBlock; b < firstBlock + numBlocks; ++b) {
+                    TriangleHit triangleHit{};
+                    if (!IntersectBlock(m_Blocks[b], rayData, tMax, triangleHit)) continue;
+                    if (hit == nullptr) return true;
+
+                    const auto& block = m_Blocks[b];
+                    tMax = triangleHit.m_T;
+                    found = true;
+                    *hit = {triangleHit.m_T, triangleHit.m_U, triangleHit.m_V,
+                        block.m_Geometry[triangleHit.m_Lane], block.m_Primitive[triangleHit.m_Lane]};
+                }
+                continue;
+            }
+
+            const auto& node = nodes[code];
+            alignas(32) float tNear[N];
+            auto mask = IntersectChildren<N>(node.m_Bounds, rayData, tMax, tNear);
+            if (mask == 0) continue;
+
+            // 按距离从远到近压栈，先遍历最近的子节点
+            auto first = stackSize;
+            for (; mask != 0; mask &= mask - 1) {
+                auto child = static_cast<std::uint32_t>(std::countr_zero(mask));
+                StackEntry childEntry{node.m_Children[child], {tNear[child]}};
+                auto i = stackSize++;
+                if (hit != nullptr) {
+                    for (; i > first && stack[i - 1].m_TNear < childEntry.m_TNear; --i) {
+                        stack[i] = stack[i - 1];
+                    }
+                }
+                stack[i] = childEntry;
+            }
+        }
+
+        return found;
+    }
+
+    template <std::uint32_t N>
+    void BVH::IntersectPacketWide(const std::vector<WideNode<N>>& nodes, const BVHRay* rays, std::uint32_t numRays,
+        BVHHit* hits, bool* occluded) const
+    {
+        // 不足的通道复制第一条射线并保持非活跃
+        PacketData packet{};
+        for (std::uint32_t i = 0; i < sm_PacketWidth; ++i) {
+            const auto& ray = rays[i < numRays ? i : 0];
+            const float origin[3]{ray.m_Origin.x, ray.m_Origin.y, ray.m_Origin.z};
+            const float direction[3]{ray.m_Direction.x, ray.m_Direction.y, ray.m_Direction.z};
+            for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                packet.m_Origin[axis][i] = origin[axis];
+                packet.m_Direction[axis][i] = direction[axis];
+                packet.m_InvDirection[axis][i] = SafeInverse(direction[axis]);
+            }
+            packet.m_TMin[i] = ray.m_TMin;
+            packet.m_TMax[i] = hits != nullptr ? (std::min)(ray.m_TMax, hits[i < numRays ? i : 0].m_T) : ray.m_TMax;
+            packet.m_FaceSign[i] = FaceSign(ray.m_CullMode);
+        }
+
+        auto activeMask = (1u << numRays) - 1;
+        std::uint32_t hitMask = 0;
+        alignas(32) float ts[8], us[8], vs[8];
+
+        StackEntry stack[kStackSize];
+        std::uint32_t stackSize = 0;
+        StackEntry rootEntry{m_Root, {}};
+        rootEntry.m_RayMask = activeMask;
+        stack[stackSize++] = rootEntry;
+        while (stackSize > 0 && activeMask != 0) {
+            auto entry = stack[--stackSize];
+            auto rayMask = entry.m_RayMask & activeMask;
+            if (rayMask == 0) continue;
+
+            auto code = entry.m_Node;
+            if (code & sm_LeafFlag) {
+                auto firstBlock = code & sm_LeafFirstMask;
+                auto numBlocks = ((code & ~sm_LeafFlag) >> sm_LeafBlockShift) + 1;
+                for (auto b = firstBlock; b < firstBlock + numBlocks && rayMask != 0; ++b) {
+                    const auto& block = m_Blocks[b];
+                    for (std::uint32_t lane = 0; lane < 4 && rayMask != 0; ++lane) {
+                        if (block.m_Primitive[lane] == BVHHit::sm_InvalidIndex) break;
+
+                        const float v0[3]{block.m_V0[0][lane], block.m_V0[1][lane], block.m_V0[2][lane]};
+                        const float e1[3]{block.m_E1[0][lane], block.m_E1[1][lane], block.m_E1[2][lane]};
+                        const float e2[3]{block.m_E2[0][lane], block.m_E2[1][lane], block.m_E2[2][lane]};
+                        auto triangleMask = IntersectPacketTriangle(packet, v0, e1, e2, ts, us, vs) & rayMask;
+                        if (triangleMask == 0) continue;
+
+                        if (hits == nullptr) {
+                            // 被遮挡的射线不再参与遍历
+                            hitMask |= triangleMask;
+                            activeMask &= ~triangleMask;
+                            rayMask &= ~triangleMask;
+                            continue;
+                        }
+                        hitMask |= triangleMask;
+                        for (; triangleMask != 0; triangleMask &= triangleMask - 1) {
+                            auto ray = static_cast<std::uint32_t>(std::countr_zero(triangleMask));
+                            packet.m_TMax[ray] = ts[ray];
+                            hits[ray] = {ts[ray], us[ray], vs[ray], block.m_Geometry[lane], block.m_Primitive[lane]};
+                        }
+                    }
+                }
+                continue;
+            }
+
+            // 按第一条相交射线的进入距离排序子节点
+            const auto& node = nodes[code];
+            StackEntry children[N];
+            float childDistance[N];
+            std::uint32_t numChildren = 0;
+            for (std::uint32_t c = 0; c < N; ++c) {
+                if (node.m_Children[c] == sm_InvalidNode) break;
+
+                const float bounds[6]{node.m_Bounds[0][c], node.m_Bounds[1][c], node.m_Bounds[2][c],
+                    node.m_Bounds[3][c], node.m_Bounds[4][c], node.m_Bounds[5][c]};
+                alignas(32) float tNear[8];
+                auto childMask = IntersectPacketBounds(packet, bounds, tNear) & rayMask;
+                if (childMask == 0) continue;
+
+                auto distance = tNear[std::countr_zero(childMask)];
+                auto i = numChildren++;
+                for (; i > 0 && childDistance[i - 1] < distance; --i) {
+                    children[i] = children[i - 1];
+                    childDistance[i] = childDistance[i - 1];
+                }
+                children[i].m_Node = node.m_Children[c];
+                children[i].m_RayMask = childMask;
+                childDistance[i] = distance;
+            }
+            for (std::uint32_t i = 0; i < numChildren; ++i) {
+                stack[stackSize++] = children[i];
+            }
+        }
+
+        if (occluded != nullptr) {
+            for (std::uint32_t i = 0; i < numRays; ++i) {
+                occluded[i] = (hitMask >> i) & 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,265 @@
+#include "D3D12AccelerationStructureBackend.h"
+#include "Graphics/RenderContext.h"
+#include "Graphics/CommandList/CommandList.h"
+#include <cstring>
+
+namespace DSM {
+    namespace {
+        // 实例缓冲首次创建时的行数
+        constexpr std::uint64_t kMinInstanceRows = 256;
+    }
+
+    void D3D12AccelerationStructureBackend::Create(ID3D12Device5* device, std::uint32_t numQueries)
+    {
+        ASSERT(device != nullptr && numQueries > 0);
+        ASSERT(!IsCreated());
+
+        GpuBufferDesc queryDesc{};
+        queryDesc.m_Size = numQueries * sizeof(std::uint64_t);
+        queryDesc.m_Stride = sizeof(std::uint64_t);
+        queryDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        queryDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        queryDesc.m_Category = MemoryCategory::kRayTracing;
+        m_QueryBuffer.Create(L"AccelerationStructure Compaction Queries", queryDesc);
+        m_ReadbackBuffer.Create(L"AccelerationStructure Compaction Readback",
+            GetReadBackBufferDesc(numQueries * sizeof(std::uint64_t), sizeof(std::uint64_t)));
+
+        m_Device = device;
+        m_NumQueries = numQueries;
+    }
+
+    void D3D12AccelerationStructureBackend::Shutdown()
+    {
+        for (auto& buffer : m_Buffers) {
+            if (buffer != nullptr) buffer->Destroy();
+        }
+        m_Buffers.clear();
+        m_FreeBuffers.clear();
+        if (m_InstanceBuffer != nullptr) {
+            m_InstanceBuffer->Destroy();
+            m_InstanceBuffer = nullptr;
+        }
+        m_QueryBuffer.Destroy();
+        m_ReadbackBuffer.Destroy();
+        m_Device = nullptr;
+        m_CmdList = nullptr;
+        m_NumQueries = 0;
+    }
+
+    ASPrebuildInfo D3D12AccelerationStructureBackend::GetBLASPrebuildInfo(std::span<const ASTriangleGeometry> geometries, const ASBuildFlags& flags)
+    {
+        auto inputs = GetBLASInputs(geometries, flags);
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info{};
+        m_Device->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &info);
+        return {info.ResultDataMaxSizeInBytes, info.ScratchDataSizeInBytes, info.UpdateScratchDataSizeInBytes};
+    }
+
+    ASPrebuildInfo D3D12AccelerationStructureBackend::GetTLASPrebuildInfo(std::uint32_t numInstances)
+    {
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs{};
+        inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+        inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        inputs.NumDescs = numInstances;
+        inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info{};
+        m_Device->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &info);
+        return {info.ResultDataMaxSizeInBytes, info.ScratchDataSizeInBytes, info.UpdateScratchDataSizeInBytes};
+    }
+
+    ASBuffer D3D12AccelerationStructureBackend::CreateBuffer(std::uint64_t size, bool scratch)
+    {
+        ASSERT(m_CmdList != nullptr);
+
+        GpuBufferDesc bufferDesc{};
+        bufferDesc.m_Size = size;
+        bufferDesc.m_Stride = static_cast<std::uint32_t>((std::min)(size, std::uint64_t(UINT32_MAX)));
+        bufferDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        bufferDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        bufferDesc.m_Category = MemoryCategory::kRayTracing;
+        auto buffer = std::make_shared<GpuBuffer>(scratch ? L"AccelerationStructure Scratch" : L"AccelerationStructure", bufferDesc);
+        if (scratch) {
+            m_CmdList->TransitionResource(*buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+
+        std::uint32_t handle{};
+        if (!m_FreeBuffers.empty()) {
+            handle = m_FreeBuffers.back();
+            m_FreeBuffers.pop_back();
+        }
+        else {
+            handle = static_cast<std::uint32_t>(m_Buffers.size());
+            m_Buffers.emplace_back();
+        }
+
+        ASBuffer result{};
+        result.m_Handle = handle;
+        result.m_GpuAddress = buffer->GetGpuVirtualAddress();
+        result.m_Size = size;
+        m_Buffers[handle] = std::move(buffer);
+        return result;
+    }
+
+    void D3D12AccelerationStructureBackend::ReleaseBuffer(const ASBuffer& buffer)
+    {
+        // 句柄可以立即复用，资源在之前的帧完成后释放
+        std::shared_ptr<GpuBuffer> oldBuffer = std::move(m_Buffers[buffer.m_Handle]);
+        g_RenderContext.GetFrameScheduler().DeferRelease([oldBuffer]() { oldBuffer->Destroy(); });
+        m_FreeBuffers.push_back(buffer.m_Handle);
+    }
+
+    void D3D12AccelerationStructureBackend::BuildBLAS(const ASBLASBuild& build)
+    {
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc{};
+        buildDesc.Inputs = GetBLASInputs(build.m_Geometries, build.m_Flags);
+        buildDesc.DestAccelerationStructureData = build.m_Dest.m_GpuAddress;
+        buildDesc.SourceAccelerationStructureData = build.m_Flags.m_PerformUpdate ? build.m_Dest.m_GpuAddress : 0;
+        buildDesc.ScratchAccelerationStructureData = build.m_ScratchAddress;
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildDesc{};
+        std::uint32_t numPostbuildDescs = 0;
+        if (build.m_CompactionQuery != AccelerationStructureManager::sm_InvalidQuery) {
+            ASSERT(build.m_CompactionQuery < m_NumQueries);
+            m_CmdList->TransitionResource(m_QueryBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            postbuildDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+            postbuildDesc.DestBuffer = m_QueryBuffer.GetGpuVirtualAddress() + build.m_CompactionQuery * sizeof(std::uint64_t);
+            numPostbuildDescs = 1;
+        }
+
+        m_CmdList->FlushResourceBarriers();
+        m_CmdList->GetDXRCommandList()->BuildRaytracingAccelerationStructure(&buildDesc, numPostbuildDescs,
+            numPostbuildDescs > 0 ? &postbuildDesc : nullptr);
+    }
+
+    void D3D12AccelerationStructureBackend::CopyCompacted(const ASBuffer& dest, const ASBuffer& src)
+    {
+        m_CmdList->FlushResourceBarriers();
+        m_CmdList->GetDXRCommandList()->CopyRaytracingAccelerationStructure(dest.m_GpuAddress, src.m_GpuAddress,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+    }
+
+    void D3D12AccelerationStructureBackend::Barrier()
+    {
+        m_CmdList->InsertGlobalUAVBarrier();
+    }
+
+    void D3D12AccelerationStructureBackend::UploadInstances(const GpuSceneTable& instances)
+    {
+        auto rowSize = instances.GetRowSize();
+        auto requiredSize = std::uint64_t(instances.GetNumRows()) * rowSize;
+        if (m_InstanceBuffer == nullptr || m_InstanceBuffer->GetSize() < requiredSize) {
+            auto size = (std::max)(requiredSize, kMinInstanceRows * rowSize);
+            if (m_InstanceBuffer != nullptr) {
+                size = (std::max)(size, m_InstanceBuffer->GetSize() * 2);
+            }
+
+            GpuBufferDesc bufferDesc{};
+            bufferDesc.m_Size = size;
+            bufferDesc.m_Stride = rowSize;
+            bufferDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+            bufferDesc.m_Category = MemoryCategory::kRayTracing;
+            auto newBuffer = std::make_shared<GpuBuffer>(L"AccelerationStructure Instances", bufferDesc);
+
+            if (m_InstanceBuffer != nullptr) {
+                m_CmdList->CopyBufferRegion(*newBuffer, 0, *m_InstanceBuffer, 0, m_InstanceBuffer->GetSize());
+
+                // 之前的帧可能仍在使用旧的缓冲
+                std::shared_ptr<GpuBuffer> oldBuffer = std::move(m_InstanceBuffer);
+                g_RenderContext.GetFrameScheduler().DeferRelease([oldBuffer]() { oldBuffer->Destroy(); });
+            }
+            m_InstanceBuffer = std::move(newBuffer);
+        }
+
+        auto ranges = instances.GetScatterRanges();
+        if (!ranges.empty()) {
+            auto uploadBuffer = m_CmdList->GetUploadBuffer(instances.GetScatterDataSize());
+            instances.WriteScatterData(uploadBuffer.m_MappedAddress);
+            for (const auto& range : ranges) {
+                m_CmdList->CopyBufferRegion(*m_InstanceBuffer, std::size_t(range.m_DestRow) * rowSize,
+                    *uploadBuffer.m_Resource, uploadBuffer.m_Offset + std::size_t(range.m_SrcRow) * rowSize,
+                    std::size_t(range.m_NumRows) * rowSize);
+            }
+        }
+        m_CmdList->TransitionResource(*m_InstanceBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+
+    void D3D12AccelerationStructureBackend::BuildTLAS(const ASTLASBuild& build)
+    {
+        ASSERT(m_InstanceBuffer != nullptr);
+
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc{};
+        buildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+        buildDesc.Inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        buildDesc.Inputs.NumDescs = build.m_NumInstances;
+        buildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        buildDesc.Inputs.InstanceDescs = m_InstanceBuffer->GetGpuVirtualAddress();
+        buildDesc.DestAccelerationStructureData = build.m_Dest.m_GpuAddress;
+        buildDesc.ScratchAccelerationStructureData = build.m_ScratchAddress;
+
+        m_CmdList->FlushResourceBarriers();
+        m_CmdList->GetDXRCommandList()->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+    }
+
+    void D3D12AccelerationStructureBackend::ResolveCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries)
+    {
+        ASSERT(firstQuery + numQueries <= m_NumQueries);
+        // 回读缓冲始终处于 COPY_DEST，不经过状态跟踪
+        m_CmdList->TransitionResource(m_QueryBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, true);
+        m_CmdList->GetCommandList()->CopyBufferRegion(
+            m_ReadbackBuffer.GetResource(), firstQuery * sizeof(std::uint64_t),
+            m_QueryBuffer.GetResource(), firstQuery * sizeof(std::uint64_t),
+            numQueries * sizeof(std::uint64_t));
+    }
+
+    bool D3D12AccelerationStructureBackend::ReadCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* sizes)
+    {
+        if (!IsCreated() || firstQuery + numQueries > m_NumQueries) return false;
+
+        auto data = m_ReadbackBuffer.GetMappedData<std::uint64_t>();
+        if (data == nullptr) return false;
+
+        std::memcpy(sizes, data + firstQuery, numQueries * sizeof(std::uint64_t));
+        return true;
+    }
+
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS D3D12AccelerationStructureBackend::GetBuildFlags(const ASBuildFlags& flags) noexcept
+    {
+        auto buildFlags = flags.m_PreferFastBuild ?
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD :
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        if (flags.m_AllowUpdate) buildFlags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+        if (flags.m_AllowCompaction) buildFlags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+        if (flags.m_PerformUpdate) buildFlags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+        return buildFlags;
+    }
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS D3D12AccelerationStructureBackend::GetBLASInputs(
+        std::span<const ASTriangleGeometry> geometries, const ASBuildFlags& flags)
+    {
+        m_GeometryDescs.resize(geometries.size());
+        for (std::size_t i = 0; i < geometries.size(); ++i) {
+            const auto& geometry = geometries[i];
+            auto& geometryDesc = m_GeometryDescs[i];
+            geometryDesc = {};
+            geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+            geometryDesc.Flags = geometry.m_Opaque ? D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE : D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
+            geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+            geometryDesc.Triangles.VertexCount = geometry.m_VertexCount;
+            geometryDesc.Triangles.VertexBuffer.StartAddress = geometry.m_VertexAddress;
+            geometryDesc.Triangles.VertexBuffer.StrideInBytes = geometry.m_VertexStride;
+            if (geometry.m_IndexAddress != 0) {
+                geometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+                geometryDesc.Triangles.IndexCount = geometry.m_IndexCount;
+                geometryDesc.Triangles.IndexBuffer = geometry.m_IndexAddress;
+            }
+        }
+
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs{};
+        inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        inputs.Flags = GetBuildFlags(flags);
+        inputs.NumDescs = static_cast<UINT>(m_GeometryDescs.size());
+        inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        inputs.pGeometryDescs = m_GeometryDescs.data();
+        return inputs;
+    }
+}
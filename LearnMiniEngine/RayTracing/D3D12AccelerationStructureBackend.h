@@ -0,0 +1,68 @@
+#pragma once
+#ifndef __D3D12ACCELERATIONSTRUCTUREBACKEND_H__
+#define __D3D12ACCELERATIONSTRUCTUREBACKEND_H__
+
+#include <memory>
+#include <vector>
+#include "AccelerationStructureManager.h"
+#include "Graphics/Resource/GpuBuffer.h"
+
+namespace DSM {
+    class CommandList;
+
+    // 在 D3D12 命令列表上录制加速结构的构建，缓冲的释放延迟到 FrameScheduler 中该帧完成之后
+    class D3D12AccelerationStructureBackend : public IAccelerationStructureBackend
+    {
+    public:
+        D3D12AccelerationStructureBackend() = default;
+        ~D3D12AccelerationStructureBackend() { Shutdown(); }
+        DSM_NONCOPYABLE(D3D12AccelerationStructureBackend);
+
+        // numQueries 为所有帧槽位的压缩查询总数
+        void Create(ID3D12Device5* device, std::uint32_t numQueries);
+        void Shutdown();
+
+        // 之后的命令录制到 cmdList，每帧调用 AccelerationStructureManager::Update 之前设置
+        void SetCommandList(CommandList* cmdList) noexcept { m_CmdList = cmdList; }
+
+        virtual ASPrebuildInfo GetBLASPrebuildInfo(std::span<const ASTriangleGeometry> geometries, const ASBuildFlags& flags) override;
+        virtual ASPrebuildInfo GetTLASPrebuildInfo(std::uint32_t numInstances) override;
+
+        virtual ASBuffer CreateBuffer(std::uint64_t size, bool scratch) override;
+        virtual void ReleaseBuffer(const ASBuffer& buffer) override;
+
+        virtual void BuildBLAS(const ASBLASBuild& build) override;
+        virtual void CopyCompacted(const ASBuffer& dest, const ASBuffer& src) override;
+        virtual void Barrier() override;
+
+        virtual void UploadInstances(const GpuSceneTable& instances) override;
+        virtual void BuildTLAS(const ASTLASBuild& build) override;
+
+        virtual void ResolveCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries) override;
+        virtual bool ReadCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* sizes) override;
+
+        bool IsCreated() const noexcept { return m_Device != nullptr; }
+
+    private:
+        static D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS GetBuildFlags(const ASBuildFlags& flags) noexcept;
+        // 转换后的几何描述保存在 m_GeometryDescs 中
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS GetBLASInputs(std::span<const ASTriangleGeometry> geometries, const ASBuildFlags& flags);
+
+    private:
+        ID3D12Device5* m_Device{};
+        CommandList* m_CmdList{};
+
+        // 以句柄为索引，释放的句柄之后会被复用
+        std::vector<std::shared_ptr<GpuBuffer>> m_Buffers{};
+        std::vector<std::uint32_t> m_FreeBuffers{};
+        std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> m_GeometryDescs{};
+
+        // D3D12_RAYTRACING_INSTANCE_DESC 数组，只在实例表改变的行上写入
+        std::shared_ptr<GpuBuffer> m_InstanceBuffer{};
+        GpuBuffer m_QueryBuffer{};
+        GpuBuffer m_ReadbackBuffer{};
+        std::uint32_t m_NumQueries{};
+    };
+}
+
+#endif
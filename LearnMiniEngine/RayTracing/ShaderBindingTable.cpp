@@ -0,0 +1,200 @@
+#include "ShaderBindingTable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace DSM {
+    namespace {
+        std::uint32_t AlignUp(std::uint32_t value, std::uint32_t alignment) noexcept
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    ShaderRecordLayout::ShaderRecordLayout(std::span<const ShaderRecordArgument> arguments)
+    {
+        auto offset = ShaderBindingTable::sm_IdentifierSize;
+        m_Offsets.reserve(arguments.size());
+        m_Sizes.reserve(arguments.size());
+        for (const auto& argument : arguments) {
+            // 常量按 4 字节对齐，描述符表与根视图为 8 字节
+            bool constants = argument.m_Type == ShaderRecordArgumentType::kConstants;
+            auto size = constants ? argument.m_Num32BitValues * 4 : 8u;
+            offset = AlignUp(offset, constants ? 4 : 8);
+            m_Offsets.push_back(offset);
+            m_Sizes.push_back(size);
+            offset += size;
+        }
+        m_Size = offset;
+    }
+
+    bool ShaderBindingTable::SetTable(ShaderTableType type, std::uint32_t numRecords, std::uint32_t recordSize)
+    {
+        auto table = static_cast<std::size_t>(type);
+        recordSize = (std::max)(recordSize, sm_IdentifierSize);
+        auto alignment = type == ShaderTableType::kRayGen ? sm_TableAlignment : sm_RecordAlignment;
+        auto stride = AlignUp(recordSize, alignment);
+        if (numRecords > 0 && stride > sm_MaxRecordStride) return false;
+
+        ShaderTableRange oldRanges[kNumTables]{};
+        std::uint32_t oldFirstRecords[kNumTables]{};
+        std::copy_n(m_Ranges, kNumTables, oldRanges);
+        std::copy_n(m_FirstRecords, kNumTables, oldFirstRecords);
+        auto oldData = std::move(m_Data);
+        auto oldDirtyBegin = std::move(m_DirtyBegin);
+        auto oldDirtyEnd = std::move(m_DirtyEnd);
+
+        m_Ranges[table].m_Stride = numRecords > 0 ? stride : 0;
+        m_Ranges[table].m_NumRecords = numRecords;
+        m_Ranges[table].m_RecordSize = numRecords > 0 ? recordSize : 0;
+
+        std::uint32_t offset = 0, numTotalRecords = 0;
+        for (std::size_t i = 0; i < kNumTables; ++i) {
+            auto& range = m_Ranges[i];
+            range.m_Offset = AlignUp(offset, sm_TableAlignment);
+            offset = range.m_Offset + range.GetSize();
+            m_FirstRecords[i] = numTotalRecords;
+            numTotalRecords += range.m_NumRecords;
+        }
+
+        m_Data.assign(AlignUp(offset, sm_TableAlignment), std::byte{});
+        m_DirtyBegin.assign(numTotalRecords, 0);
+        m_DirtyEnd.assign(numTotalRecords, 0);
+        m_DirtyRecords.clear();
+
+        for (std::size_t i = 0; i < kNumTables; ++i) {
+            const auto& oldRange = oldRanges[i];
+            const auto& range = m_Ranges[i];
+            auto numKept = (std::min)(oldRange.m_NumRecords, range.m_NumRecords);
+            auto copySize = (std::min)(oldRange.m_RecordSize, range.m_RecordSize);
+            bool moved = oldRange.m_Offset != range.m_Offset || oldRange.m_Stride != range.m_Stride;
+
+            for (std::uint32_t r = 0; r < range.m_NumRecords; ++r) {
+                auto record = m_FirstRecords[i] + r;
+                if (r >= numKept) {
+                    // 新增的记录在 GPU 上没有内容
+                    MarkDirty(record, 0, range.m_RecordSize);
+                    continue;
+                }
+
+                auto oldRecord = oldFirstRecords[i] + r;
+                memcpy(m_Data.data() + range.m_Offset + r * range.m_Stride,
+                    oldData.data() + oldRange.m_Offset + r * oldRange.m_Stride, copySize);
+                if (moved) {
+                    MarkDirty(record, 0, range.m_RecordSize);
+                    continue;
+                }
+                if (oldDirtyBegin[oldRecord] < oldDirtyEnd[oldRecord]) {
+                    MarkDirty(record, oldDirtyBegin[oldRecord], (std::min)(oldDirtyEnd[oldRecord], range.m_RecordSize));
+                }
+                // 记录变大但步长不变时，新增的部分之前没有上传过
+                if (range.m_RecordSize > oldRange.m_RecordSize) {
+                    MarkDirty(record, oldRange.m_RecordSize, range.m_RecordSize);
+                }
+            }
+        }
+        return true;
+    }
+
+    void ShaderBindingTable::Clear()
+    {
+        *this = {};
+    }
+
+    void ShaderBindingTable::SetIdentifier(ShaderTableType type, std::uint32_t index, const void* identifier)
+    {
+        Write(type, index, 0, identifier, sm_IdentifierSize);
+    }
+
+    bool ShaderBindingTable::Write(ShaderTableType type, std::uint32_t index, std::uint32_t offset, const void* data, std::uint32_t size)
+    {
+        ++m_Stats.m_NumWrites;
+        auto* dest = m_Data.data() + GetRecordOffset(type, index) + offset;
+        auto* src = static_cast<const std::byte*>(data);
+
+        // 只标记实际改变的字节
+        std::uint32_t begin = 0, end = size;
+        while (begin < end && dest[begin] == src[begin]) ++begin;
+        if (begin == end) {
+            ++m_Stats.m_NumUnchanged;
+            return false;
+        }
+        while (dest[end - 1] == src[end - 1]) --end;
+
+        memcpy(dest + begin, src + begin, end - begin);
+        MarkDirty(GetRecordIndex(type, index), offset + begin, offset + end);
+        return true;
+    }
+
+    void ShaderBindingTable::MarkAllDirty()
+    {
+        for (std::size_t i = 0; i < kNumTables; ++i) {
+            const auto& range = m_Ranges[i];
+            for (std::uint32_t r = 0; r < range.m_NumRecords; ++r) {
+                MarkDirty(m_FirstRecords[i] + r, 0, range.m_RecordSize);
+            }
+        }
+    }
+
+    void ShaderBindingTable::MarkDirty(std::uint32_t record, std::uint32_t begin, std::uint32_t end)
+    {
+        if (begin >= end) return;
+
+        auto& dirtyBegin = m_DirtyBegin[record];
+        auto& dirtyEnd = m_DirtyEnd[record];
+        if (dirtyBegin >= dirtyEnd) {
+            m_DirtyRecords.push_back(record);
+            dirtyBegin = begin;
+            dirtyEnd = end;
+        }
+        else {
+            dirtyBegin = (std::min)(dirtyBegin, begin);
+            dirtyEnd = (std::max)(dirtyEnd, end);
+        }
+    }
+
+    void ShaderBindingTable::BuildPatchList(std::uint32_t maxGap)
+    {
+        m_Patches.clear();
+        m_PatchDataSize = 0;
+        if (m_DirtyRecords.empty()) return;
+
+        // 记录的序号与地址的顺序相同
+        std::sort(m_DirtyRecords.begin(), m_DirtyRecords.end());
+        std::size_t table = 0;
+        for (auto record : m_DirtyRecords) {
+            while (table + 1 < kNumTables && record >= m_FirstRecords[table + 1]) ++table;
+            const auto& range = m_Ranges[table];
+            auto recordOffset = range.m_Offset + (record - m_FirstRecords[table]) * range.m_Stride;
+            auto begin = recordOffset + m_DirtyBegin[record];
+            auto end = recordOffset + m_DirtyEnd[record];
+            m_DirtyBegin[record] = m_DirtyEnd[record] = 0;
+
+            // 合并进来的字节没有改变或只是记录间的填充，重复上传没有影响
+            if (!m_Patches.empty()) {
+                auto& last = m_Patches.back();
+                auto lastEnd = last.m_DestOffset + last.m_Size;
+                if (begin - lastEnd <= maxGap) {
+                    last.m_Size = end - last.m_DestOffset;
+                    continue;
+                }
+            }
+            m_Patches.push_back({begin, end - begin, 0});
+        }
+        m_DirtyRecords.clear();
+
+        for (auto& patch : m_Patches) {
+            patch.m_SrcOffset = m_PatchDataSize;
+            m_PatchDataSize += patch.m_Size;
+        }
+        m_Stats.m_NumPatches += m_Patches.size();
+        m_Stats.m_NumPatchedBytes += m_PatchDataSize;
+    }
+
+    void ShaderBindingTable::WritePatchData(void* dest) const
+    {
+        auto* output = static_cast<std::byte*>(dest);
+        for (const auto& patch : m_Patches) {
+            memcpy(output + patch.m_SrcOffset, m_Data.data() + patch.m_DestOffset, patch.m_Size);
+        }
+    }
+}
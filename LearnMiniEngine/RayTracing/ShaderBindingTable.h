@@ -0,0 +1,174 @@
+#pragma once
+#ifndef __SHADERBINDINGTABLE_H__
+#define __SHADERBINDINGTABLE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace DSM {
+    enum class ShaderTableType : std::uint8_t
+    {
+        kRayGen,
+        kMiss,
+        kHitGroup,
+        kCallable,
+        kCount
+    };
+
+    enum class ShaderRecordArgumentType : std::uint8_t
+    {
+        // 32 位常量，4 字节对齐
+        kConstants,
+        // D3D12_GPU_DESCRIPTOR_HANDLE，8 字节对齐
+        kDescriptorTable,
+        // CBV/SRV/UAV 的 GPU 虚拟地址，8 字节对齐
+        kRootView
+    };
+
+    struct ShaderRecordArgument
+    {
+        ShaderRecordArgumentType m_Type = ShaderRecordArgumentType::kConstants;
+        // 只用于 kConstants
+        std::uint32_t m_Num32BitValues = 0;
+    };
+
+    // 局部根签名的参数在着色器记录中的布局，参数顺序需与局部根签名相同
+    class ShaderRecordLayout
+    {
+    public:
+        ShaderRecordLayout() = default;
+        ShaderRecordLayout(std::initializer_list<ShaderRecordArgument> arguments)
+            :ShaderRecordLayout(std::span<const ShaderRecordArgument>{arguments.begin(), arguments.size()}) {}
+        explicit ShaderRecordLayout(std::span<const ShaderRecordArgument> arguments);
+
+        std::uint32_t GetNumArguments() const noexcept { return static_cast<std::uint32_t>(m_Offsets.size()); }
+        // 相对于记录的开头，包含着色器标识符
+        std::uint32_t GetOffset(std::uint32_t argument) const noexcept { return m_Offsets[argument]; }
+        std::uint32_t GetArgumentSize(std::uint32_t argument) const noexcept { return m_Sizes[argument]; }
+        // 标识符与所有参数的大小，没有按记录对齐
+        std::uint32_t GetSize() const noexcept { return m_Size; }
+
+    private:
+        std::vector<std::uint32_t> m_Offsets{};
+        std::vector<std::uint32_t> m_Sizes{};
+        std::uint32_t m_Size = 0;
+    };
+
+    // 一种表在整个缓冲中的位置
+    struct ShaderTableRange
+    {
+        std::uint32_t m_Offset{};
+        std::uint32_t m_Stride{};
+        std::uint32_t m_NumRecords{};
+        // 单个记录需要的大小
+        std::uint32_t m_RecordSize{};
+
+        std::uint32_t GetSize() const noexcept { return m_Stride * m_NumRecords; }
+    };
+
+    // 一段需要上传的连续字节，源数据在打包的上传数据中从 m_SrcOffset 开始
+    struct ShaderTablePatch
+    {
+        std::uint32_t m_DestOffset{};
+        std::uint32_t m_Size{};
+        std::uint32_t m_SrcOffset{};
+    };
+
+    struct ShaderBindingTableStats
+    {
+        std::uint64_t m_NumWrites = 0;
+        // 与已有数据相同而没有标记为脏的写入
+        std::uint64_t m_NumUnchanged = 0;
+        std::uint64_t m_NumPatches = 0;
+        std::uint64_t m_NumPatchedBytes = 0;
+    };
+
+    // 着色器表在 CPU 上的副本，按记录的大小计算各表的布局并记录改变的字节，不访问设备
+    // 四种表依次存放在同一块缓冲中，每个表从 64 字节对齐处开始，记录按 32 字节对齐
+    // 光线生成记录在 DispatchRays 中单独作为起始地址，步长按 64 字节对齐
+    class ShaderBindingTable
+    {
+    public:
+        // D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES
+        inline static constexpr std::uint32_t sm_IdentifierSize = 32;
+        // D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT
+        inline static constexpr std::uint32_t sm_RecordAlignment = 32;
+        // D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT
+        inline static constexpr std::uint32_t sm_TableAlignment = 64;
+        // D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE
+        inline static constexpr std::uint32_t sm_MaxRecordStride = 4096;
+
+        // 改变一种表的记录数量或记录大小，原有记录的内容保留
+        // 位置或步长改变的表整体标记为脏，记录超出最大步长时返回 false 且不做修改
+        bool SetTable(ShaderTableType type, std::uint32_t numRecords, std::uint32_t recordSize);
+        void Clear();
+
+        void SetIdentifier(ShaderTableType type, std::uint32_t index, const void* identifier);
+        // offset 相对于记录的开头，offset + size 不能超过记录的大小
+        // 与已有数据相同时不标记为脏，返回数据是否改变
+        bool Write(ShaderTableType type, std::uint32_t index, std::uint32_t offset, const void* data, std::uint32_t size);
+        // 写入 layout 中的第 argument 个参数，value 不能大于该参数
+        template <typename T>
+        bool WriteArgument(ShaderTableType type, std::uint32_t index, const ShaderRecordLayout& layout, std::uint32_t argument, const T& value);
+        // GPU 上的缓冲重新创建时需要整体上传
+        void MarkAllDirty();
+
+        // 按地址顺序收集改变的字节并清除脏标记，间隔不超过 maxGap 字节的范围合并为一段
+        void BuildPatchList(std::uint32_t maxGap = 0);
+        std::span<const ShaderTablePatch> GetPatches() const noexcept { return m_Patches; }
+        std::uint32_t GetPatchDataSize() const noexcept { return m_PatchDataSize; }
+        // 按顺序写入打包的数据，需在下一次写入之前调用
+        void WritePatchData(void* dest) const;
+
+        const ShaderTableRange& GetRange(ShaderTableType type) const noexcept { return m_Ranges[static_cast<std::size_t>(type)]; }
+        std::uint32_t GetRecordOffset(ShaderTableType type, std::uint32_t index) const noexcept
+        {
+            const auto& range = GetRange(type);
+            return range.m_Offset + index * range.m_Stride;
+        }
+        // 整个缓冲的大小
+        std::uint32_t GetSize() const noexcept { return static_cast<std::uint32_t>(m_Data.size()); }
+        const std::byte* GetData() const noexcept { return m_Data.data(); }
+        std::uint32_t GetNumDirty() const noexcept { return static_cast<std::uint32_t>(m_DirtyRecords.size()); }
+
+        const ShaderBindingTableStats& GetStats() const noexcept { return m_Stats; }
+        void ResetStats() noexcept { m_Stats = {}; }
+
+    private:
+        static constexpr std::size_t kNumTables = static_cast<std::size_t>(ShaderTableType::kCount);
+
+        // 记录在所有表中的序号
+        std::uint32_t GetRecordIndex(ShaderTableType type, std::uint32_t index) const noexcept
+        {
+            return m_FirstRecords[static_cast<std::size_t>(type)] + index;
+        }
+        void MarkDirty(std::uint32_t record, std::uint32_t begin, std::uint32_t end);
+
+    private:
+        ShaderTableRange m_Ranges[kNumTables]{};
+        std::uint32_t m_FirstRecords[kNumTables]{};
+        std::vector<std::byte> m_Data{};
+
+        // 每个记录中改变的字节范围 [begin, end)，begin >= end 表示没有改变
+        std::vector<std::uint32_t> m_DirtyBegin{};
+        std::vector<std::uint32_t> m_DirtyEnd{};
+        std::vector<std::uint32_t> m_DirtyRecords{};
+
+        std::vector<ShaderTablePatch> m_Patches{};
+        std::uint32_t m_PatchDataSize = 0;
+        ShaderBindingTableStats m_Stats{};
+    };
+
+    template <typename T>
+    bool ShaderBindingTable::WriteArgument(ShaderTableType type, std::uint32_t index, const ShaderRecordLayout& layout, std::uint32_t argument, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return Write(type, index, layout.GetOffset(argument), &value, static_cast<std::uint32_t>(sizeof(T)));
+    }
+}
+
+#endif
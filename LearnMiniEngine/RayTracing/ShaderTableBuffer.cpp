@@ -0,0 +1,71 @@
+#include "ShaderTableBuffer.h"
+#include "Graphics/RenderContext.h"
+#include "Graphics/CommandList/CommandList.h"
+
+namespace DSM {
+    void ShaderTableBuffer::Destroy()
+    {
+        if (m_Buffer != nullptr) {
+            m_Buffer->Destroy();
+            m_Buffer = nullptr;
+        }
+    }
+
+    void ShaderTableBuffer::Update(CommandList& cmdList, ShaderBindingTable& table)
+    {
+        if (table.GetSize() == 0) return;
+
+        if (m_Buffer == nullptr || m_Buffer->GetSize() < table.GetSize()) {
+            if (m_Buffer != nullptr) {
+                // 之前的帧可能仍在使用旧的缓冲
+                std::shared_ptr<GpuBuffer> oldBuffer = std::move(m_Buffer);
+                g_RenderContext.GetFrameScheduler().DeferRelease([oldBuffer]() { oldBuffer->Destroy(); });
+            }
+
+            GpuBufferDesc bufferDesc{};
+            bufferDesc.m_Size = table.GetSize();
+            bufferDesc.m_Stride = ShaderBindingTable::sm_RecordAlignment;
+            bufferDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+            bufferDesc.m_Category = MemoryCategory::kRayTracing;
+            m_Buffer = std::make_shared<GpuBuffer>(L"ShaderTable", bufferDesc);
+            table.MarkAllDirty();
+        }
+
+        table.BuildPatchList(sm_MaxMergeGap);
+        auto patches = table.GetPatches();
+        if (!patches.empty()) {
+            auto uploadBuffer = cmdList.GetUploadBuffer(table.GetPatchDataSize());
+            table.WritePatchData(uploadBuffer.m_MappedAddress);
+            for (const auto& patch : patches) {
+                cmdList.CopyBufferRegion(*m_Buffer, patch.m_DestOffset,
+                    *uploadBuffer.m_Resource, uploadBuffer.m_Offset + patch.m_SrcOffset, patch.m_Size);
+            }
+        }
+        // DispatchRays 不经过命令列表的封装，不会提交之前的屏障
+        cmdList.TransitionResource(*m_Buffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+    }
+
+    void ShaderTableBuffer::GetDispatchRaysDesc(const ShaderBindingTable& table, std::uint32_t rayGenIndex, D3D12_DISPATCH_RAYS_DESC& desc) const
+    {
+        ASSERT(m_Buffer != nullptr);
+        auto address = m_Buffer->GetGpuVirtualAddress();
+        auto getTable = [&](ShaderTableType type) {
+            const auto& range = table.GetRange(type);
+            D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE result{};
+            if (range.m_NumRecords > 0) {
+                result.StartAddress = address + range.m_Offset;
+                result.SizeInBytes = range.GetSize();
+                result.StrideInBytes = range.m_Stride;
+            }
+            return result;
+        };
+
+        const auto& rayGen = table.GetRange(ShaderTableType::kRayGen);
+        ASSERT(rayGenIndex < rayGen.m_NumRecords);
+        desc.RayGenerationShaderRecord.StartAddress = address + table.GetRecordOffset(ShaderTableType::kRayGen, rayGenIndex);
+        desc.RayGenerationShaderRecord.SizeInBytes = rayGen.m_RecordSize;
+        desc.MissShaderTable = getTable(ShaderTableType::kMiss);
+        desc.HitGroupTable = getTable(ShaderTableType::kHitGroup);
+        desc.CallableShaderTable = getTable(ShaderTableType::kCallable);
+    }
+}
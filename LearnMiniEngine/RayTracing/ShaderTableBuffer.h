@@ -0,0 +1,37 @@
+#pragma once
+#ifndef __SHADERTABLEBUFFER_H__
+#define __SHADERTABLEBUFFER_H__
+
+#include <memory>
+#include "ShaderBindingTable.h"
+#include "Graphics/Resource/GpuBuffer.h"
+
+namespace DSM {
+    class CommandList;
+
+    // ShaderBindingTable 在 GPU 上的缓冲，每帧只拷贝改变的字节
+    class ShaderTableBuffer
+    {
+    public:
+        // 补丁之间间隔不超过该字节数时合并为一次拷贝
+        inline static constexpr std::uint32_t sm_MaxMergeGap = 64;
+
+        ShaderTableBuffer() = default;
+        ~ShaderTableBuffer() { Destroy(); }
+        DSM_NONCOPYABLE(ShaderTableBuffer);
+
+        void Destroy();
+
+        // 录制改变的记录的拷贝，表的大小超出缓冲时重新创建并整体上传，返回时屏障已经提交
+        void Update(CommandList& cmdList, ShaderBindingTable& table);
+        // 光线生成记录使用第 rayGenIndex 个，其余的表整体使用
+        void GetDispatchRaysDesc(const ShaderBindingTable& table, std::uint32_t rayGenIndex, D3D12_DISPATCH_RAYS_DESC& desc) const;
+
+        GpuBuffer* GetBuffer() const noexcept { return m_Buffer.get(); }
+
+    private:
+        std::shared_ptr<GpuBuffer> m_Buffer{};
+    };
+}
+
+#endif
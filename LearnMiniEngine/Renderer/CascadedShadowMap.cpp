@@ -0,0 +1,273 @@
+#include "CascadedShadowMap.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace DSM {
+    namespace {
+        constexpr float kMinDepthRange = 1e-3f;
+
+        void Normalize(float v[3]) noexcept
+        {
+            float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            float inv = length > 0 ? 1 / length : 0;
+            v[0] *= inv;
+            v[1] *= inv;
+            v[2] *= inv;
+        }
+
+        void Cross(const float a[3], const float b[3], float out[3]) noexcept
+        {
+            out[0] = a[1] * b[2] - a[2] * b[1];
+            out[1] = a[2] * b[0] - a[0] * b[2];
+            out[2] = a[0] * b[1] - a[1] * b[0];
+        }
+    }
+
+    void CascadedShadowMap::Create(const CascadedShadowDesc& desc)
+    {
+        m_NumCascades = std::clamp(desc.m_NumCascades, 1u, sm_MaxCascades);
+        m_Resolution = (std::max)(desc.m_Resolution, 1u);
+        m_MaxDistance = desc.m_MaxDistance;
+        m_SplitLambda = std::clamp(desc.m_SplitLambda, 0.0f, 1.0f);
+
+        for (auto& indices : m_CasterIndices) {
+            indices.clear();
+        }
+        m_CasterDepths.clear();
+        m_Constants = {};
+    }
+
+    void CascadedShadowMap::Update(const ShadowCameraDesc& camera, const float lightDir[3])
+    {
+        // 光源空间与 XMMatrixLookToLH 相同，光线与世界的 y 轴接近平行时改用 x 轴作为上方向
+        float* axisX = m_LightAxes[0];
+        float* axisY = m_LightAxes[1];
+        float* axisZ = m_LightAxes[2];
+        axisZ[0] = lightDir[0];
+        axisZ[1] = lightDir[1];
+        axisZ[2] = lightDir[2];
+        Normalize(axisZ);
+        float up[3] = {0, 1, 0};
+        if (std::abs(axisZ[1]) > 0.99f) {
+            up[0] = 1;
+            up[1] = 0;
+        }
+        Cross(up, axisZ, axisX);
+        Normalize(axisX);
+        Cross(axisZ, axisX, axisY);
+
+        // 观察矩阵的列为相机的轴，位置为 -t * Rᵀ
+        const float* view = camera.m_View;
+        const float right[3] = {view[0], view[4], view[8]};
+        const float upAxis[3] = {view[1], view[5], view[9]};
+        const float forward[3] = {view[2], view[6], view[10]};
+        float position[3]{};
+        for (int i = 0; i < 3; ++i) {
+            position[i] = -(view[12] * view[i * 4] + view[13] * view[i * 4 + 1] + view[14] * view[i * 4 + 2]);
+        }
+
+        float nearZ = camera.m_NearZ;
+        float farZ = (std::max)((std::min)(camera.m_FarZ, m_MaxDistance), nearZ * 1.001f);
+        float tanY = std::tan(camera.m_FovY * 0.5f);
+        float tanX = tanY * camera.m_Aspect;
+        float tanSq = tanX * tanX + tanY * tanY;
+
+        float splitNear = nearZ;
+        for (std::uint32_t i = 0; i < m_NumCascades; ++i) {
+            float t = float(i + 1) / m_NumCascades;
+            float logSplit = nearZ * std::pow(farZ / nearZ, t);
+            float uniformSplit = nearZ + (farZ - nearZ) * t;
+            float splitFar = i + 1 == m_NumCascades ? farZ : m_SplitLambda * logSplit + (1 - m_SplitLambda) * uniformSplit;
+
+            // 包围球的球心在视线上，与切片近远两端的角点等距，球心超出远平面时以远平面的中心为球心
+            // 半径只与投影有关，相机旋转时纹素的大小不变
+            float centerZ = (splitNear + splitFar) * (1 + tanSq) * 0.5f;
+            float radius = 0;
+            if (centerZ >= splitFar) {
+                centerZ = splitFar;
+                radius = splitFar * std::sqrt(tanSq);
+            }
+            else {
+                float dz = centerZ - splitNear;
+                radius = std::sqrt(dz * dz + splitNear * splitNear * tanSq);
+            }
+
+            auto& cascade = m_Cascades[i];
+            cascade.m_SplitNear = splitNear;
+            cascade.m_SplitFar = splitFar;
+            cascade.m_Radius = radius;
+            cascade.m_TexelSize = 2 * radius / m_Resolution;
+
+            // 球心在光源空间的 xy 按纹素对齐，平移时阴影贴图中的物体整数纹素地移动
+            float centerWS[3]{};
+            for (int k = 0; k < 3; ++k) {
+                centerWS[k] = position[k] + forward[k] * centerZ;
+            }
+            ToLightSpace(centerWS, cascade.m_Center);
+            cascade.m_Center[0] = std::floor(cascade.m_Center[0] / cascade.m_TexelSize + 0.5f) * cascade.m_TexelSize;
+            cascade.m_Center[1] = std::floor(cascade.m_Center[1] / cascade.m_TexelSize + 0.5f) * cascade.m_TexelSize;
+
+            // 切片的 8 个角点在光源空间的包围盒，xy 不超出阴影贴图覆盖的范围
+            auto& receiver = m_Receivers[i];
+            for (int k = 0; k < 3; ++k) {
+                receiver.m_Min[k] = std::numeric_limits<float>::max();
+                receiver.m_Max[k] = std::numeric_limits<float>::lowest();
+            }
+            for (int corner = 0; corner < 8; ++corner) {
+                float depth = corner & 4 ? splitFar : splitNear;
+                float sx = corner & 1 ? tanX : -tanX;
+                float sy = corner & 2 ? tanY : -tanY;
+                float p[3]{};
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = position[k] + (forward[k] + right[k] * sx + upAxis[k] * sy) * depth;
+                }
+                float pLS[3]{};
+                ToLightSpace(p, pLS);
+                for (int k = 0; k < 3; ++k) {
+                    receiver.m_Min[k] = (std::min)(receiver.m_Min[k], pLS[k]);
+                    receiver.m_Max[k] = (std::max)(receiver.m_Max[k], pLS[k]);
+                }
+            }
+            for (int k = 0; k < 2; ++k) {
+                receiver.m_Min[k] = (std::max)(receiver.m_Min[k], cascade.m_Center[k] - radius);
+                receiver.m_Max[k] = (std::min)(receiver.m_Max[k], cascade.m_Center[k] + radius);
+            }
+
+            // 没有投射体时只覆盖接收阴影的切片
+            cascade.m_NearZ = receiver.m_Min[2];
+            cascade.m_FarZ = receiver.m_Max[2];
+            BuildMatrices(cascade);
+
+            splitNear = splitFar;
+        }
+        BuildConstants();
+    }
+
+    void CascadedShadowMap::CullCasters(std::span<const ShadowCasterBounds> casters)
+    {
+        float nearZ[sm_MaxCascades]{};
+        for (std::uint32_t i = 0; i < m_NumCascades; ++i) {
+            m_CasterIndices[i].clear();
+            nearZ[i] = m_Receivers[i].m_Min[2];
+        }
+        m_CasterDepths.resize(casters.size());
+
+        for (std::uint32_t casterIndex = 0; casterIndex < casters.size(); ++casterIndex) {
+            const auto& caster = casters[casterIndex];
+
+            // 包围盒在光源空间的包围盒
+            float center[3]{};
+            float extents[3]{};
+            for (int k = 0; k < 3; ++k) {
+                center[k] = (caster.m_Min[k] + caster.m_Max[k]) * 0.5f;
+                extents[k] = (caster.m_Max[k] - caster.m_Min[k]) * 0.5f;
+            }
+            float centerLS[3]{};
+            ToLightSpace(center, centerLS);
+            float boxMin[3]{};
+            float boxMax[3]{};
+            for (int k = 0; k < 3; ++k) {
+                const float* axis = m_LightAxes[k];
+                float e = std::abs(axis[0]) * extents[0] + std::abs(axis[1]) * extents[1] + std::abs(axis[2]) * extents[2];
+                boxMin[k] = centerLS[k] - e;
+                boxMax[k] = centerLS[k] + e;
+            }
+            m_CasterDepths[casterIndex] = boxMin[2];
+
+            // 投射体沿光线方向无限延伸，xy 与切片重叠且不完全在切片之后才可能投下阴影
+            for (std::uint32_t i = 0; i < m_NumCascades; ++i) {
+                const auto& receiver = m_Receivers[i];
+                if (boxMax[0] < receiver.m_Min[0] || boxMin[0] > receiver.m_Max[0] ||
+                    boxMax[1] < receiver.m_Min[1] || boxMin[1] > receiver.m_Max[1] ||
+                    boxMin[2] > receiver.m_Max[2]) {
+                    continue;
+                }
+                m_CasterIndices[i].push_back(casterIndex);
+                nearZ[i] = (std::min)(nearZ[i], boxMin[2]);
+            }
+        }
+
+        for (std::uint32_t i = 0; i < m_NumCascades; ++i) {
+            m_Cascades[i].m_NearZ = nearZ[i];
+            BuildMatrices(m_Cascades[i]);
+        }
+        BuildConstants();
+    }
+
+    void CascadedShadowMap::ToLightSpace(const float p[3], float out[3]) const noexcept
+    {
+        for (int k = 0; k < 3; ++k) {
+            const float* axis = m_LightAxes[k];
+            out[k] = p[0] * axis[0] + p[1] * axis[1] + p[2] * axis[2];
+        }
+    }
+
+    void CascadedShadowMap::BuildMatrices(ShadowCascade& cascade) const noexcept
+    {
+        float invRadius = 1 / cascade.m_Radius;
+        float depthRange = (std::max)(cascade.m_FarZ - cascade.m_NearZ, kMinDepthRange);
+
+        // 正交投影，x 与 y 以对齐后的球心为中心，深度反向
+        float* m = cascade.m_ViewProj;
+        for (int j = 0; j < 3; ++j) {
+            m[j * 4 + 0] = m_LightAxes[0][j] * invRadius;
+            m[j * 4 + 1] = m_LightAxes[1][j] * invRadius;
+            m[j * 4 + 2] = -m_LightAxes[2][j] / depthRange;
+            m[j * 4 + 3] = 0;
+        }
+        m[12] = -cascade.m_Center[0] * invRadius;
+        m[13] = -cascade.m_Center[1] * invRadius;
+        m[14] = (cascade.m_NearZ + depthRange) / depthRange;
+        m[15] = 1;
+
+        // 纹理坐标的 v 向下
+        float* t = cascade.m_ShadowTransform;
+        for (int j = 0; j < 4; ++j) {
+            t[j * 4 + 0] = 0.5f * m[j * 4 + 0];
+            t[j * 4 + 1] = -0.5f * m[j * 4 + 1];
+            t[j * 4 + 2] = m[j * 4 + 2];
+            t[j * 4 + 3] = m[j * 4 + 3];
+        }
+        t[12] += 0.5f;
+        t[13] += 0.5f;
+    }
+
+    void CascadedShadowMap::BuildConstants()
+    {
+        // 每个轴上级联的坐标为光源空间坐标的仿射变换 a * p + b，由级联 0 的坐标换算
+        auto getAxes = [](const ShadowCascade& cascade, float a[3], float b[3]) {
+            a[0] = 0.5f / cascade.m_Radius;
+            b[0] = 0.5f - 0.5f * cascade.m_Center[0] / cascade.m_Radius;
+            a[1] = -0.5f / cascade.m_Radius;
+            b[1] = 0.5f + 0.5f * cascade.m_Center[1] / cascade.m_Radius;
+            float depthRange = (std::max)(cascade.m_FarZ - cascade.m_NearZ, kMinDepthRange);
+            a[2] = -1 / depthRange;
+            b[2] = (cascade.m_NearZ + depthRange) / depthRange;
+        };
+
+        float a0[3]{};
+        float b0[3]{};
+        getAxes(m_Cascades[0], a0, b0);
+        m_Constants = {};
+        for (std::uint32_t i = 0; i < sm_MaxCascades; ++i) {
+            if (i >= m_NumCascades) {
+                m_Constants.m_Scales[i][0] = m_Constants.m_Scales[i][1] = m_Constants.m_Scales[i][2] = 1;
+                m_Constants.m_Splits[i] = m_Cascades[m_NumCascades - 1].m_SplitFar;
+                continue;
+            }
+            float a[3]{};
+            float b[3]{};
+            getAxes(m_Cascades[i], a, b);
+            for (int k = 0; k < 3; ++k) {
+                m_Constants.m_Scales[i][k] = a[k] / a0[k];
+                m_Constants.m_Offsets[i][k] = b[k] * a0[k] / a[k] - b0[k];
+            }
+            m_Constants.m_Splits[i] = m_Cascades[i].m_SplitFar;
+        }
+        m_Constants.m_LightDir[0] = m_LightAxes[2][0];
+        m_Constants.m_LightDir[1] = m_LightAxes[2][1];
+        m_Constants.m_LightDir[2] = m_LightAxes[2][2];
+        m_Constants.m_NumCascades = m_NumCascades;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef __CASCADEDSHADOWMAP_H__
+#define __CASCADEDSHADOWMAP_H__
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace DSM {
+    // 矩阵为 16 个浮点数，行向量约定，与 XMFLOAT4X4 的布局相同，观察矩阵只包含旋转与平移
+    struct ShadowCameraDesc
+    {
+        float m_View[16]{};
+        float m_FovY = 0;
+        float m_Aspect = 1;
+        float m_NearZ = 0.1f;
+        float m_FarZ = 1000.0f;
+    };
+
+    struct CascadedShadowDesc
+    {
+        std::uint32_t m_NumCascades = 4;
+        // 每个级联的分辨率，级联在图集中横向排列
+        std::uint32_t m_Resolution = 2048;
+        // 阴影的最远距离，超过相机远平面时使用远平面
+        float m_MaxDistance = 150.0f;
+        // 划分的对数部分所占的比例，0 为均匀划分，1 为对数划分
+        float m_SplitLambda = 0.8f;
+    };
+
+    // 世界空间的包围盒
+    struct ShadowCasterBounds
+    {
+        float m_Min[3];
+        float m_Max[3];
+    };
+
+    struct ShadowCascade
+    {
+        // 世界空间到裁剪空间，深度反向，靠近光源的一侧为 1
+        float m_ViewProj[16];
+        // 世界空间到阴影贴图的纹理坐标与深度
+        float m_ShadowTransform[16];
+        // 覆盖的观察空间深度范围
+        float m_SplitNear;
+        float m_SplitFar;
+        // 光源空间中按纹素对齐的中心与包围球的半径
+        float m_Center[3];
+        float m_Radius;
+        // 一个纹素在世界空间的大小
+        float m_TexelSize;
+        // 光源空间的深度范围，近处延伸到所有投射体
+        float m_NearZ;
+        float m_FarZ;
+    };
+
+    // 与着色器中的布局相同，第 i 个级联的坐标为 (级联 0 的坐标 + m_Offsets[i]) * m_Scales[i]
+    struct ShadowCascadeConstants
+    {
+        float m_Offsets[4][4];
+        float m_Scales[4][4];
+        // 每个级联覆盖的最远观察空间深度
+        float m_Splits[4];
+        // 光线传播的方向
+        float m_LightDir[3];
+        std::uint32_t m_NumCascades;
+    };
+
+    // 级联阴影的划分、拟合与投射体剔除，不访问设备
+    // 每个级联用视锥切片的包围球拟合，半径只与投影有关，中心在光源空间按纹素对齐，相机移动与旋转时阴影的边缘不会闪烁
+    // 投射体沿光线方向延伸后与接收阴影的切片相交才绘制，视锥之外的投射体也会保留，光源空间的近平面延伸到这些投射体
+    class CascadedShadowMap
+    {
+    public:
+        inline static constexpr std::uint32_t sm_MaxCascades = 4;
+
+        CascadedShadowMap() { Create({}); }
+        explicit CascadedShadowMap(const CascadedShadowDesc& desc) { Create(desc); }
+
+        void Create(const CascadedShadowDesc& desc);
+
+        // 划分视锥并拟合每个级联的范围，lightDir 为光线传播的方向
+        void Update(const ShadowCameraDesc& camera, const float lightDir[3]);
+        // 按级联剔除投射体并确定深度范围，需在 Update 之后调用
+        void CullCasters(std::span<const ShadowCasterBounds> casters);
+
+        std::uint32_t GetNumCascades() const noexcept { return m_NumCascades; }
+        std::uint32_t GetResolution() const noexcept { return m_Resolution; }
+        const ShadowCascade& GetCascade(std::uint32_t cascade) const noexcept { return m_Cascades[cascade]; }
+        // 每个级联需要绘制的投射体，按输入的顺序排列
+        std::span<const std::uint32_t> GetCasterIndices(std::uint32_t cascade) const noexcept { return m_CasterIndices[cascade]; }
+        // 每个投射体在光源空间最靠近光源的深度，可用于由近到远排序
+        std::span<const float> GetCasterDepths() const noexcept { return m_CasterDepths; }
+        const ShadowCascadeConstants& GetConstants() const noexcept { return m_Constants; }
+
+    private:
+        // 接收阴影的切片在光源空间的包围盒
+        struct Receiver
+        {
+            float m_Min[3];
+            float m_Max[3];
+        };
+
+        void ToLightSpace(const float p[3], float out[3]) const noexcept;
+        void BuildMatrices(ShadowCascade& cascade) const noexcept;
+        void BuildConstants();
+
+    private:
+        std::uint32_t m_NumCascades = 0;
+        std::uint32_t m_Resolution = 0;
+        float m_MaxDistance = 0;
+        float m_SplitLambda = 0;
+
+        // 光源空间的三个轴，z 为光线传播的方向
+        float m_LightAxes[3][3]{};
+        ShadowCascade m_Cascades[sm_MaxCascades]{};
+        Receiver m_Receivers[sm_MaxCascades]{};
+
+        std::vector<std::uint32_t> m_CasterIndices[sm_MaxCascades]{};
+        std::vector<float> m_CasterDepths{};
+        ShadowCascadeConstants m_Constants{};
+    };
+}
+
+#endif
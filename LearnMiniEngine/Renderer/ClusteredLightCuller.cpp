@@ -0,0 +1,404 @@
+#include "ClusteredLightCuller.h"
+#include "Utilities/ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define DSM_CLUSTER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace DSM {
+    namespace {
+        // 光源较少时创建线程比变换本身更慢
+        constexpr std::uint32_t kMinLightsPerThread = 1024;
+
+        std::uint32_t AlignUp(std::uint32_t value, std::uint32_t alignment) noexcept
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        void TransformPoint(const float* p, const float* m, float* result) noexcept
+        {
+            for (int i = 0; i < 3; ++i) {
+                result[i] = p[0] * m[i] + p[1] * m[4 + i] + p[2] * m[8 + i] + m[12 + i];
+            }
+        }
+
+        void TransformVector(const float* v, const float* m, float* result) noexcept
+        {
+            for (int i = 0; i < 3; ++i) {
+                result[i] = v[0] * m[i] + v[1] * m[4 + i] + v[2] * m[8 + i];
+            }
+        }
+
+        // 一行中相邻 4 个簇的 SIMD 封装，比较的结果为每个通道一位的掩码
+        struct Float4
+        {
+#ifdef DSM_CLUSTER_SSE
+            __m128 m_V;
+
+            static Float4 Load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+            static Float4 Set1(float v) noexcept { return {_mm_set1_ps(v)}; }
+#else
+            float m_V[4];
+
+            static Float4 Load(const float* p) noexcept { return {{p[0], p[1], p[2], p[3]}}; }
+            static Float4 Set1(float v) noexcept { return {{v, v, v, v}}; }
+#endif
+        };
+
+#ifdef DSM_CLUSTER_SSE
+        inline Float4 operator+(Float4 a, Float4 b) noexcept { return {_mm_add_ps(a.m_V, b.m_V)}; }
+        inline Float4 operator-(Float4 a, Float4 b) noexcept { return {_mm_sub_ps(a.m_V, b.m_V)}; }
+        inline Float4 operator*(Float4 a, Float4 b) noexcept { return {_mm_mul_ps(a.m_V, b.m_V)}; }
+        inline Float4 Max(Float4 a, Float4 b) noexcept { return {_mm_max_ps(a.m_V, b.m_V)}; }
+        inline Float4 Sqrt(Float4 a) noexcept { return {_mm_sqrt_ps(a.m_V)}; }
+        inline std::uint32_t LessEqual(Float4 a, Float4 b) noexcept { return _mm_movemask_ps(_mm_cmple_ps(a.m_V, b.m_V)); }
+#else
+        template <typename Op>
+        inline Float4 Map(Float4 a, Float4 b, Op op) noexcept
+        {
+            Float4 result{};
+            for (int i = 0; i < 4; ++i) result.m_V[i] = op(a.m_V[i], b.m_V[i]);
+            return result;
+        }
+        inline Float4 operator+(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x + y; }); }
+        inline Float4 operator-(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x - y; }); }
+        inline Float4 operator*(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x * y; }); }
+        inline Float4 Max(Float4 a, Float4 b) noexcept { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+        inline Float4 Sqrt(Float4 a) noexcept { return Map(a, a, [](float x, float) { return std::sqrt(x); }); }
+        inline std::uint32_t LessEqual(Float4 a, Float4 b) noexcept
+        {
+            std::uint32_t mask = 0;
+            for (int i = 0; i < 4; ++i) mask |= a.m_V[i] <= b.m_V[i] ? 1u << i : 0;
+            return mask;
+        }
+#endif
+    }
+
+    void ClusteredLightCuller::Create(const ClusteredLightCullerDesc& desc)
+    {
+        m_NumTilesX = std::clamp(desc.m_NumTilesX, 1u, sm_MaxTilesX);
+        m_NumTilesY = (std::max)(desc.m_NumTilesY, 1u);
+        m_NumSlices = (std::max)(desc.m_NumSlices, 1u);
+        m_NumThreads = desc.m_NumThreads != 0 ? desc.m_NumThreads : (std::max)(std::thread::hardware_concurrency(), 1u);
+        m_PaddedTilesX = AlignUp(m_NumTilesX, 4);
+
+        m_SliceZ.resize(m_NumSlices + 1);
+        m_MinX.resize(m_NumSlices * m_PaddedTilesX);
+        m_MaxX.resize(m_NumSlices * m_PaddedTilesX);
+        m_MinY.resize(m_NumSlices * m_NumTilesY);
+        m_MaxY.resize(m_NumSlices * m_NumTilesY);
+        m_PlanesX.resize((m_NumTilesX + 1) * 2);
+        m_PlanesY.resize((m_NumTilesY + 1) * 2);
+        m_Rows.resize(m_NumSlices * m_NumTilesY);
+        for (auto& row : m_Rows) {
+            row.m_Counts.resize(m_NumTilesX);
+        }
+        m_ThreadPairs.resize(m_NumThreads);
+        m_ClusterRanges.assign(GetNumClusters(), {});
+        m_LightIndices.clear();
+        m_HasBounds = false;
+        m_Stats = {};
+    }
+
+    void ClusteredLightCuller::SetCamera(const ClusterCameraDesc& camera)
+    {
+        bool projectionChanged = !m_HasBounds ||
+            camera.m_FovY != m_Camera.m_FovY || camera.m_Aspect != m_Camera.m_Aspect ||
+            camera.m_NearZ != m_Camera.m_NearZ || camera.m_FarZ != m_Camera.m_FarZ;
+        m_Camera = camera;
+        m_Camera.m_NearZ = (std::max)(camera.m_NearZ, 1e-4f);
+        m_Camera.m_FarZ = (std::max)(camera.m_FarZ, m_Camera.m_NearZ * 1.001f);
+        if (projectionChanged) {
+            BuildClusterBounds();
+        }
+
+        float nearZ = m_Camera.m_NearZ, farZ = m_Camera.m_FarZ;
+        float logRatio = std::log(farZ / nearZ);
+        m_Constants.m_SliceScale = m_NumSlices / logRatio;
+        m_Constants.m_SliceBias = -(m_NumSlices * std::log(nearZ)) / logRatio;
+        m_Constants.m_TileScaleX = m_NumTilesX / (std::max)(m_Camera.m_Width, 1.0f);
+        m_Constants.m_TileScaleY = m_NumTilesY / (std::max)(m_Camera.m_Height, 1.0f);
+        m_Constants.m_NumTilesX = m_NumTilesX;
+        m_Constants.m_NumTilesY = m_NumTilesY;
+        m_Constants.m_NumSlices = m_NumSlices;
+
+        // 投影后的深度为 A + B / viewZ，反向深度交换投影使用的近远平面
+        float depthNear = m_Camera.m_ReversedZ ? farZ : nearZ;
+        float depthFar = m_Camera.m_ReversedZ ? nearZ : farZ;
+        m_Constants.m_DepthToViewZA = depthFar / (depthFar - depthNear);
+        m_Constants.m_DepthToViewZB = -depthNear * depthFar / (depthFar - depthNear);
+    }
+
+    void ClusteredLightCuller::BuildClusterBounds()
+    {
+        float nearZ = m_Camera.m_NearZ, farZ = m_Camera.m_FarZ;
+        for (std::uint32_t s = 0; s <= m_NumSlices; ++s) {
+            m_SliceZ[s] = nearZ * std::pow(farZ / nearZ, static_cast<float>(s) / m_NumSlices);
+        }
+        m_SliceZ[m_NumSlices] = farZ;
+
+        // 分块在某一深度上的范围与深度成正比，因此包围盒由层的两端决定
+        float tanY = std::tan(m_Camera.m_FovY * 0.5f);
+        float tanX = tanY * m_Camera.m_Aspect;
+        // 边界 x = ndc * tanX * z 的平面，法线指向 x 增大的一侧
+        for (std::uint32_t x = 0; x <= m_NumTilesX; ++x) {
+            float slope = (-1 + 2.0f * x / m_NumTilesX) * tanX;
+            float length = std::sqrt(1 + slope * slope);
+            m_PlanesX[x * 2] = 1 / length;
+            m_PlanesX[x * 2 + 1] = -slope / length;
+        }
+        // 行从屏幕上方开始，法线指向 y 减小的一侧
+        for (std::uint32_t y = 0; y <= m_NumTilesY; ++y) {
+            float slope = (1 - 2.0f * y / m_NumTilesY) * tanY;
+            float length = std::sqrt(1 + slope * slope);
+            m_PlanesY[y * 2] = -1 / length;
+            m_PlanesY[y * 2 + 1] = slope / length;
+        }
+        for (std::uint32_t s = 0; s < m_NumSlices; ++s) {
+            float z0 = m_SliceZ[s], z1 = m_SliceZ[s + 1];
+            for (std::uint32_t x = 0; x < m_PaddedTilesX; ++x) {
+                auto i = s * m_PaddedTilesX + x;
+                if (x >= m_NumTilesX) {
+                    m_MinX[i] = (std::numeric_limits<float>::max)();
+                    m_MaxX[i] = -(std::numeric_limits<float>::max)();
+                    continue;
+                }
+                float left = -1 + 2.0f * x / m_NumTilesX;
+                float right = -1 + 2.0f * (x + 1) / m_NumTilesX;
+                m_MinX[i] = (std::min)(left * z0, left * z1) * tanX;
+                m_MaxX[i] = (std::max)(right * z0, right * z1) * tanX;
+            }
+            // 分块的行从屏幕上方开始
+            for (std::uint32_t y = 0; y < m_NumTilesY; ++y) {
+                auto i = s * m_NumTilesY + y;
+                float top = 1 - 2.0f * y / m_NumTilesY;
+                float bottom = 1 - 2.0f * (y + 1) / m_NumTilesY;
+                m_MinY[i] = (std::min)(bottom * z0, bottom * z1) * tanY;
+                m_MaxY[i] = (std::max)(top * z0, top * z1) * tanY;
+            }
+        }
+        m_HasBounds = true;
+    }
+
+    void ClusteredLightCuller::AssignLights(std::span<const ClusterLightBounds> lights)
+    {
+        auto numLights = static_cast<std::uint32_t>(lights.size());
+        m_Stats = {};
+        m_Stats.m_NumLights = numLights;
+        m_Constants.m_NumLights = numLights;
+        std::fill(m_ClusterRanges.begin(), m_ClusterRanges.end(), ClusterLightRange{});
+        m_LightIndices.clear();
+        if (numLights == 0 || !m_HasBounds) return;
+
+        m_ViewLights.resize(numLights);
+        auto numTransformThreads = (std::min)(m_NumThreads, (numLights + kMinLightsPerThread - 1) / kMinLightsPerThread);
+        Utility::ParallelFor(numLights, numTransformThreads, [&](std::uint32_t begin, std::uint32_t end) {
+            TransformLights(lights, begin, end);
+        });
+
+        // 按行分组，之后每行只测试与该行可能相交的光源
+        auto numRows = static_cast<std::uint32_t>(m_Rows.size());
+        m_RowOffsets.assign(numRows + 1, 0);
+        for (const auto& light : m_ViewLights) {
+            for (auto s = light.m_FirstSlice; s <= light.m_LastSlice; ++s) {
+                for (auto y = light.m_FirstTileY; y <= light.m_LastTileY; ++y) {
+                    ++m_RowOffsets[s * m_NumTilesY + y + 1];
+                }
+            }
+        }
+        for (std::uint32_t r = 0; r < numRows; ++r) {
+            m_RowOffsets[r + 1] += m_RowOffsets[r];
+        }
+        m_RowLights.resize(m_RowOffsets[numRows]);
+        {
+            std::vector<std::uint32_t> cursor(m_RowOffsets.begin(), m_RowOffsets.end() - 1);
+            for (std::uint32_t i = 0; i < numLights; ++i) {
+                const auto& light = m_ViewLights[i];
+                for (auto s = light.m_FirstSlice; s <= light.m_LastSlice; ++s) {
+                    for (auto y = light.m_FirstTileY; y <= light.m_LastTileY; ++y) {
+                        m_RowLights[cursor[s * m_NumTilesY + y]++] = i;
+                    }
+                }
+            }
+        }
+
+        // 每个线程依次取下一行，每行的结果单独保存
+        auto numThreads = (std::min)(m_NumThreads, numRows);
+        std::atomic<std::uint32_t> nextRow{0};
+        Utility::ParallelFor(numThreads, numThreads, [&](std::uint32_t thread, std::uint32_t) {
+            auto& pairs = m_ThreadPairs[thread];
+            for (auto row = nextRow++; row < numRows; row = nextRow++) {
+                AssignRow(row, pairs);
+            }
+        });
+
+        // 各行的结果依次拼接
+        std::uint32_t numIndices = 0;
+        for (const auto& row : m_Rows) {
+            numIndices += static_cast<std::uint32_t>(row.m_Indices.size());
+        }
+        m_LightIndices.resize(numIndices);
+        std::vector<std::uint8_t> visible(numLights, 0);
+        std::uint32_t offset = 0;
+        for (std::uint32_t r = 0; r < numRows; ++r) {
+            const auto& row = m_Rows[r];
+            if (!row.m_Indices.empty()) {
+                memcpy(m_LightIndices.data() + offset, row.m_Indices.data(), row.m_Indices.size() * sizeof(std::uint32_t));
+            }
+            auto* ranges = &m_ClusterRanges[r * m_NumTilesX];
+            for (std::uint32_t x = 0; x < m_NumTilesX; ++x) {
+                ranges[x] = {offset, row.m_Counts[x]};
+                offset += row.m_Counts[x];
+                m_Stats.m_MaxLightsPerCluster = (std::max)(m_Stats.m_MaxLightsPerCluster, row.m_Counts[x]);
+            }
+            for (auto light : row.m_Indices) {
+                visible[light] = 1;
+            }
+        }
+        m_Stats.m_NumIndices = numIndices;
+        m_Stats.m_NumVisibleLights = static_cast<std::uint32_t>(std::count(visible.begin(), visible.end(), 1));
+    }
+
+    void ClusteredLightCuller::TransformLights(std::span<const ClusterLightBounds> lights, std::uint32_t begin, std::uint32_t end)
+    {
+        for (auto i = begin; i < end; ++i) {
+            const auto& light = lights[i];
+            auto& viewLight = m_ViewLights[i];
+            TransformPoint(light.m_Position, m_Camera.m_View, viewLight.m_Apex);
+            TransformVector(light.m_Direction, m_Camera.m_View, viewLight.m_Direction);
+            viewLight.m_Range = (std::max)(light.m_Range, 0.0f);
+            viewLight.m_IsSpot = light.m_CosAngle > 0;
+            viewLight.m_CosAngle = (std::min)(light.m_CosAngle, 1.0f);
+            viewLight.m_SinAngle = std::sqrt((std::max)(1 - viewLight.m_CosAngle * viewLight.m_CosAngle, 0.0f));
+
+            // 圆锥的包围球，半角不超过 45 度时球面经过顶点与底面的圆周，否则以底面的圆为大圆
+            float offset = 0;
+            viewLight.m_Radius = viewLight.m_Range;
+            if (viewLight.m_IsSpot) {
+                if (viewLight.m_CosAngle >= 0.70710678f) {
+                    viewLight.m_Radius = viewLight.m_Range / (2 * viewLight.m_CosAngle);
+                    offset = viewLight.m_Radius;
+                }
+                else {
+                    viewLight.m_Radius = viewLight.m_Range * viewLight.m_SinAngle;
+                    offset = viewLight.m_Range * viewLight.m_CosAngle;
+                }
+            }
+            for (int j = 0; j < 3; ++j) {
+                viewLight.m_Center[j] = viewLight.m_Apex[j] + viewLight.m_Direction[j] * offset;
+            }
+
+            // 包围球的深度范围
+            float minZ = viewLight.m_Center[2] - viewLight.m_Radius;
+            float maxZ = viewLight.m_Center[2] + viewLight.m_Radius;
+            // 与分块边界的平面比较，得到可能相交的列与行
+            auto tileRange = [&](const std::vector<float>& planes, float axis, std::uint32_t numTiles,
+                std::uint32_t& firstTile, std::uint32_t& lastTile) {
+                firstTile = numTiles;
+                lastTile = 0;
+                float begin = planes[0] * axis + planes[1] * viewLight.m_Center[2];
+                for (std::uint32_t t = 0; t < numTiles; ++t) {
+                    float end = planes[t * 2 + 2] * axis + planes[t * 2 + 3] * viewLight.m_Center[2];
+                    if (begin >= -viewLight.m_Radius && end <= viewLight.m_Radius) {
+                        firstTile = (std::min)(firstTile, t);
+                        lastTile = t;
+                    }
+                    begin = end;
+                }
+                return firstTile <= lastTile;
+            };
+            bool inside = maxZ >= m_SliceZ.front() && minZ <= m_SliceZ.back() &&
+                tileRange(m_PlanesX, viewLight.m_Center[0], m_NumTilesX, viewLight.m_FirstTileX, viewLight.m_LastTileX) &&
+                tileRange(m_PlanesY, viewLight.m_Center[1], m_NumTilesY, viewLight.m_FirstTileY, viewLight.m_LastTileY);
+            if (!inside) {
+                viewLight.m_FirstSlice = viewLight.m_FirstTileY = 1;
+                viewLight.m_LastSlice = viewLight.m_LastTileY = 0;
+                continue;
+            }
+            // 远端不在 minZ 之前且近端不在 maxZ 之后的层
+            auto first = std::lower_bound(m_SliceZ.begin() + 1, m_SliceZ.end() - 1, minZ) - (m_SliceZ.begin() + 1);
+            auto last = std::upper_bound(m_SliceZ.begin() + 1, m_SliceZ.end() - 1, maxZ) - (m_SliceZ.begin() + 1);
+            viewLight.m_FirstSlice = static_cast<std::uint32_t>(first);
+            viewLight.m_LastSlice = static_cast<std::uint32_t>(last);
+        }
+    }
+
+    void ClusteredLightCuller::AssignRow(std::uint32_t row, std::vector<std::uint64_t>& pairs)
+    {
+        auto slice = row / m_NumTilesY;
+        float minZ = m_SliceZ[slice], maxZ = m_SliceZ[slice + 1];
+        float minY = m_MinY[row], maxY = m_MaxY[row];
+        const float* minX = &m_MinX[slice * m_PaddedTilesX];
+        const float* maxX = &m_MaxX[slice * m_PaddedTilesX];
+
+        // 聚光灯使用簇的包围球，y 与 z 在一行中相同
+        float centerY = (minY + maxY) * 0.5f, centerZ = (minZ + maxZ) * 0.5f;
+        float extentYZ = (maxY - minY) * (maxY - minY) * 0.25f + (maxZ - minZ) * (maxZ - minZ) * 0.25f;
+        const Float4 half = Float4::Set1(0.5f);
+        const Float4 zero = Float4::Set1(0);
+
+        pairs.clear();
+        for (auto i = m_RowOffsets[row]; i < m_RowOffsets[row + 1]; ++i) {
+            auto lightIndex = m_RowLights[i];
+            const auto& light = m_ViewLights[lightIndex];
+
+            // 球体到包围盒的距离的平方按轴分开累加
+            float dz = (std::max)({minZ - light.m_Center[2], light.m_Center[2] - maxZ, 0.0f});
+            float dy = (std::max)({minY - light.m_Center[1], light.m_Center[1] - maxY, 0.0f});
+            float remaining = light.m_Radius * light.m_Radius - dz * dz - dy * dy;
+            if (remaining < 0) continue;
+
+            const Float4 centerX = Float4::Set1(light.m_Center[0]);
+            const Float4 remaining4 = Float4::Set1(remaining);
+            for (auto x = light.m_FirstTileX & ~3u; x <= light.m_LastTileX; x += 4) {
+                Float4 boxMin = Float4::Load(minX + x);
+                Float4 boxMax = Float4::Load(maxX + x);
+                Float4 dx = Max(Max(boxMin - centerX, centerX - boxMax), zero);
+                std::uint32_t mask = LessEqual(dx * dx, remaining4);
+                if (mask != 0 && light.m_IsSpot) {
+                    // 簇的包围球与圆锥，v 为从圆锥顶点到球心的向量
+                    Float4 clusterX = (boxMin + boxMax) * half;
+                    Float4 extentX = (boxMax - boxMin) * half;
+                    Float4 radius = Sqrt(extentX * extentX + Float4::Set1(extentYZ));
+                    Float4 vx = clusterX - Float4::Set1(light.m_Apex[0]);
+                    float vy = centerY - light.m_Apex[1], vz = centerZ - light.m_Apex[2];
+                    Float4 vAxis = vx * Float4::Set1(light.m_Direction[0]) +
+                        Float4::Set1(vy * light.m_Direction[1] + vz * light.m_Direction[2]);
+                    Float4 vLengthSq = vx * vx + Float4::Set1(vy * vy + vz * vz);
+                    Float4 vPerp = Sqrt(Max(vLengthSq - vAxis * vAxis, zero));
+                    Float4 distance = vPerp * Float4::Set1(light.m_CosAngle) - vAxis * Float4::Set1(light.m_SinAngle);
+                    mask &= LessEqual(distance, radius);
+                    mask &= LessEqual(vAxis, radius + Float4::Set1(light.m_Range));
+                    mask &= LessEqual(zero - radius, vAxis);
+                }
+                while (mask != 0) {
+                    auto lane = static_cast<std::uint32_t>(std::countr_zero(mask));
+                    mask &= mask - 1;
+                    pairs.push_back(static_cast<std::uint64_t>(x + lane) << 32 | lightIndex);
+                }
+            }
+        }
+
+        // 按簇计数排序，同一个簇中的光源保持输入的顺序
+        auto& output = m_Rows[row];
+        std::fill(output.m_Counts.begin(), output.m_Counts.end(), 0u);
+        for (auto pair : pairs) {
+            ++output.m_Counts[pair >> 32];
+        }
+        std::uint32_t cursor[sm_MaxTilesX]{};
+        for (std::uint32_t x = 1; x < m_NumTilesX; ++x) {
+            cursor[x] = cursor[x - 1] + output.m_Counts[x - 1];
+        }
+        output.m_Indices.resize(pairs.size());
+        for (auto pair : pairs) {
+            output.m_Indices[cursor[pair >> 32]++] = static_cast<std::uint32_t>(pair);
+        }
+    }
+}
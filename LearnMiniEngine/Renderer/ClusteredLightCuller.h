@@ -0,0 +1,176 @@
+#pragma once
+#ifndef __CLUSTEREDLIGHTCULLER_H__
+#define __CLUSTEREDLIGHTCULLER_H__
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace DSM {
+    // 世界空间的光源范围，聚光灯在球体之外再按圆锥测试
+    struct ClusterLightBounds
+    {
+        float m_Position[3]{};
+        float m_Range = 0;
+        // 单位向量，只用于聚光灯
+        float m_Direction[3]{0, 0, 1};
+        // 聚光灯半角的余弦，不大于 0 时按点光源处理
+        float m_CosAngle = -1;
+    };
+
+    // 矩阵为 16 个浮点数，行向量约定，与 XMFLOAT4X4 的布局相同，观察空间为左手系，+z 朝前
+    struct ClusterCameraDesc
+    {
+        float m_View[16]{};
+        float m_FovY = 0;
+        float m_Aspect = 1;
+        float m_NearZ = 0.1f;
+        float m_FarZ = 1000.0f;
+        // 只影响由深度缓冲的值还原观察空间深度的常量，簇总是按观察空间的深度划分
+        bool m_ReversedZ = false;
+        float m_Width = 1;
+        float m_Height = 1;
+    };
+
+    struct ClusteredLightCullerDesc
+    {
+        // 屏幕上的分块数量，x 方向最多 64 块
+        std::uint32_t m_NumTilesX = 16;
+        std::uint32_t m_NumTilesY = 9;
+        // 近平面到远平面之间按深度的对数均匀划分
+        std::uint32_t m_NumSlices = 24;
+        // 0 表示使用所有硬件线程，每次分配都会创建线程
+        std::uint32_t m_NumThreads = 4;
+    };
+
+    // 与着色器中的布局相同，簇的序号为 (slice * NumTilesY + tileY) * NumTilesX + tileX
+    struct ClusterGridConstants
+    {
+        // slice = floor(log(viewZ) * m_SliceScale + m_SliceBias)
+        float m_SliceScale;
+        float m_SliceBias;
+        // 像素坐标乘以该值得到分块的坐标
+        float m_TileScaleX;
+        float m_TileScaleY;
+        std::uint32_t m_NumTilesX;
+        std::uint32_t m_NumTilesY;
+        std::uint32_t m_NumSlices;
+        std::uint32_t m_NumLights;
+        // viewZ = m_DepthToViewZB / (depth - m_DepthToViewZA)，已经考虑了反向深度
+        float m_DepthToViewZA;
+        float m_DepthToViewZB;
+        float m_Pad[2];
+    };
+
+    // 每个簇的光源在 GetLightIndices 中的范围
+    struct ClusterLightRange
+    {
+        std::uint32_t m_Offset;
+        std::uint32_t m_Count;
+    };
+
+    struct ClusteredLightStats
+    {
+        std::uint32_t m_NumLights = 0;
+        // 至少与一个簇相交的光源
+        std::uint32_t m_NumVisibleLights = 0;
+        std::uint32_t m_NumIndices = 0;
+        std::uint32_t m_MaxLightsPerCluster = 0;
+    };
+
+    // CPU 上的分簇光源剔除，不访问设备
+    // 视锥按屏幕分块与对数深度划分为簇，每个簇用观察空间的包围盒近似，结果偏保守
+    // 球体与包围盒的距离在三个轴上可以分开计算，因此按行用 SIMD 同时测试 4 个簇，聚光灯再用簇的包围球与圆锥测试
+    // 每个簇的光源序号连续存放且按输入的顺序排列，可以直接上传给着色器
+    class ClusteredLightCuller
+    {
+    public:
+        inline static constexpr std::uint32_t sm_MaxTilesX = 64;
+
+        ClusteredLightCuller() { Create({}); }
+        explicit ClusteredLightCuller(const ClusteredLightCullerDesc& desc) { Create(desc); }
+
+        void Create(const ClusteredLightCullerDesc& desc);
+
+        // 投影与视口没有改变时不会重新计算簇的包围盒
+        void SetCamera(const ClusterCameraDesc& camera);
+        // 多线程变换光源并求出可能相交的层与分块，之后按行并行测试
+        void AssignLights(std::span<const ClusterLightBounds> lights);
+
+        std::uint32_t GetNumClusters() const noexcept { return m_NumTilesX * m_NumTilesY * m_NumSlices; }
+        std::uint32_t GetClusterIndex(std::uint32_t tileX, std::uint32_t tileY, std::uint32_t slice) const noexcept
+        {
+            return (slice * m_NumTilesY + tileY) * m_NumTilesX + tileX;
+        }
+
+        const ClusterGridConstants& GetConstants() const noexcept { return m_Constants; }
+        std::span<const ClusterLightRange> GetClusterRanges() const noexcept { return m_ClusterRanges; }
+        std::span<const std::uint32_t> GetLightIndices() const noexcept { return m_LightIndices; }
+        const ClusteredLightStats& GetStats() const noexcept { return m_Stats; }
+
+    private:
+        // 观察空间的光源，聚光灯的球体为圆锥的包围球
+        struct ViewLight
+        {
+            float m_Center[3];
+            float m_Radius;
+            float m_Apex[3];
+            float m_Range;
+            float m_Direction[3];
+            float m_CosAngle;
+            float m_SinAngle;
+            std::uint32_t m_FirstSlice;
+            std::uint32_t m_LastSlice;
+            std::uint32_t m_FirstTileX;
+            std::uint32_t m_LastTileX;
+            std::uint32_t m_FirstTileY;
+            std::uint32_t m_LastTileY;
+            bool m_IsSpot;
+        };
+
+        // 一行簇的结果，按簇的顺序排列
+        struct RowOutput
+        {
+            std::vector<std::uint32_t> m_Counts{};
+            std::vector<std::uint32_t> m_Indices{};
+        };
+
+        void BuildClusterBounds();
+        void TransformLights(std::span<const ClusterLightBounds> lights, std::uint32_t begin, std::uint32_t end);
+        void AssignRow(std::uint32_t row, std::vector<std::uint64_t>& pairs);
+
+    private:
+        std::uint32_t m_NumTilesX = 0;
+        std::uint32_t m_NumTilesY = 0;
+        std::uint32_t m_NumSlices = 0;
+        std::uint32_t m_NumThreads = 0;
+        // 每行的分块数量向上对齐到 4，多出的通道不与任何光源相交
+        std::uint32_t m_PaddedTilesX = 0;
+
+        ClusterCameraDesc m_Camera{};
+        bool m_HasBounds = false;
+        // 每层的深度范围，以及按层保存的每列与每行的包围盒范围
+        std::vector<float> m_SliceZ{};
+        std::vector<float> m_MinX{};
+        std::vector<float> m_MaxX{};
+        std::vector<float> m_MinY{};
+        std::vector<float> m_MaxY{};
+        // 分块边界经过视点的平面，只保存单位法线的 x 或 y 与 z 分量
+        std::vector<float> m_PlanesX{};
+        std::vector<float> m_PlanesY{};
+
+        std::vector<ViewLight> m_ViewLights{};
+        // 按行分组的光源，每行的光源按输入的顺序排列
+        std::vector<std::uint32_t> m_RowOffsets{};
+        std::vector<std::uint32_t> m_RowLights{};
+        std::vector<RowOutput> m_Rows{};
+        std::vector<std::vector<std::uint64_t>> m_ThreadPairs{};
+
+        ClusterGridConstants m_Constants{};
+        std::vector<ClusterLightRange> m_ClusterRanges{};
+        std::vector<std::uint32_t> m_LightIndices{};
+        ClusteredLightStats m_Stats{};
+    };
+}
+
+#endif
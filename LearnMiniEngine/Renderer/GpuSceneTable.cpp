@@ -0,0 +1,104 @@
+#include "GpuSceneTable.h"
+#include <bit>
+#include <cstring>
+
+namespace DSM {
+    void GpuSceneTable::Reset(std::uint32_t rowSize)
+    {
+        m_RowSize = rowSize;
+        m_NumRows = 0;
+        m_Data.clear();
+        m_FreeRows.clear();
+        m_DirtyMask.clear();
+        m_NumDirty = 0;
+        m_Ranges.clear();
+        m_ScatterRows.clear();
+        m_Stats = {};
+    }
+
+    std::uint32_t GpuSceneTable::Allocate()
+    {
+        if (!m_FreeRows.empty()) {
+            auto row = m_FreeRows.back();
+            m_FreeRows.pop_back();
+            return row;
+        }
+
+        auto row = m_NumRows++;
+        m_Data.resize(std::size_t(m_NumRows) * m_RowSize);
+        m_DirtyMask.resize((m_NumRows + 63) / 64);
+        return row;
+    }
+
+    void GpuSceneTable::Free(std::uint32_t row)
+    {
+        m_FreeRows.push_back(row);
+    }
+
+    bool GpuSceneTable::Write(std::uint32_t row, const void* data)
+    {
+        ++m_Stats.m_NumWrites;
+        auto dest = m_Data.data() + std::size_t(row) * m_RowSize;
+        if (std::memcmp(dest, data, m_RowSize) == 0) {
+            ++m_Stats.m_NumUnchanged;
+            return false;
+        }
+        std::memcpy(dest, data, m_RowSize);
+        MarkDirty(row);
+        return true;
+    }
+
+    void GpuSceneTable::MarkDirty(std::uint32_t row)
+    {
+        auto& word = m_DirtyMask[row / 64];
+        auto bit = std::uint64_t(1) << (row % 64);
+        if ((word & bit) == 0) {
+            word |= bit;
+            ++m_NumDirty;
+        }
+    }
+
+    void GpuSceneTable::BuildScatterList(std::uint32_t maxGap)
+    {
+        m_Ranges.clear();
+        m_ScatterRows.clear();
+        if (m_NumDirty == 0) return;
+
+        for (std::size_t i = 0; i < m_DirtyMask.size(); ++i) {
+            auto word = m_DirtyMask[i];
+            if (word == 0) continue;
+            m_DirtyMask[i] = 0;
+
+            while (word != 0) {
+                auto row = static_cast<std::uint32_t>(i * 64 + std::countr_zero(word));
+                word &= word - 1;
+
+                if (!m_Ranges.empty()) {
+                    auto& last = m_Ranges.back();
+                    auto end = last.m_DestRow + last.m_NumRows;
+                    if (row - end <= maxGap) {
+                        for (auto r = end; r <= row; ++r) {
+                            m_ScatterRows.push_back(r);
+                        }
+                        last.m_NumRows = row + 1 - last.m_DestRow;
+                        continue;
+                    }
+                }
+                m_Ranges.push_back({row, 1, static_cast<std::uint32_t>(m_ScatterRows.size())});
+                m_ScatterRows.push_back(row);
+            }
+        }
+        m_NumDirty = 0;
+        m_Stats.m_NumUploadedRows += m_ScatterRows.size();
+    }
+
+    void GpuSceneTable::WriteScatterData(void* dest) const
+    {
+        auto output = static_cast<std::byte*>(dest);
+        for (const auto& range : m_Ranges) {
+            std::memcpy(output + std::size_t(range.m_SrcRow) * m_RowSize,
+                m_Data.data() + std::size_t(range.m_DestRow) * m_RowSize,
+                std::size_t(range.m_NumRows) * m_RowSize);
+        }
+    }
+}
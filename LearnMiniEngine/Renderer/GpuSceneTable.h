@@ -0,0 +1,89 @@
+#pragma once
+#ifndef __GPUSCENETABLE_H__
+#define __GPUSCENETABLE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace DSM {
+    // 一段连续的目标行，源数据在打包的上传数据中从 m_SrcRow 开始
+    struct SceneScatterRange
+    {
+        std::uint32_t m_DestRow{};
+        std::uint32_t m_NumRows{};
+        std::uint32_t m_SrcRow{};
+    };
+
+    struct GpuSceneTableStats
+    {
+        std::uint64_t m_NumWrites = 0;
+        // 与已有数据相同而没有标记为脏的写入
+        std::uint64_t m_NumUnchanged = 0;
+        std::uint64_t m_NumUploadedRows = 0;
+    };
+
+    // GPU 上持久的定长行表在 CPU 上的副本，记录改变的行并生成分散上传的列表，不访问设备
+    // 行数只增不减，释放的行之后会被复用
+    class GpuSceneTable
+    {
+    public:
+        GpuSceneTable() = default;
+        explicit GpuSceneTable(std::uint32_t rowSize) { Reset(rowSize); }
+
+        void Reset(std::uint32_t rowSize);
+        // 优先复用释放的行
+        std::uint32_t Allocate();
+        void Free(std::uint32_t row);
+        // 与已有数据相同时不标记为脏，返回数据是否改变
+        bool Write(std::uint32_t row, const void* data);
+        // 数据没有改变也需要上传，例如 GPU 上新分配的行
+        void MarkDirty(std::uint32_t row);
+        template <typename T>
+        bool Write(std::uint32_t row, const T& data);
+        const std::byte* GetRow(std::uint32_t row) const noexcept { return m_Data.data() + std::size_t(row) * m_RowSize; }
+
+        // 按行号顺序收集脏行并清除脏标记，间隔不超过 maxGap 的范围合并为一段以减少拷贝次数
+        // 合并进来的干净行与 GPU 上的数据相同，重复上传没有影响
+        void BuildScatterList(std::uint32_t maxGap = 0);
+        std::span<const SceneScatterRange> GetScatterRanges() const noexcept { return m_Ranges; }
+        // 与打包的行一一对应的目标行，供计算着色器分散写入
+        std::span<const std::uint32_t> GetScatterRows() const noexcept { return m_ScatterRows; }
+        std::uint64_t GetScatterDataSize() const noexcept { return std::uint64_t(m_ScatterRows.size()) * m_RowSize; }
+        // 按范围顺序写入打包的行数据，需在下一次 Write 之前调用
+        void WriteScatterData(void* dest) const;
+
+        std::uint32_t GetRowSize() const noexcept { return m_RowSize; }
+        // 已经分配过的最大行数，GPU 缓冲至少需要该大小
+        std::uint32_t GetNumRows() const noexcept { return m_NumRows; }
+        std::uint32_t GetNumAllocated() const noexcept { return m_NumRows - static_cast<std::uint32_t>(m_FreeRows.size()); }
+        std::uint32_t GetNumDirty() const noexcept { return m_NumDirty; }
+
+        const GpuSceneTableStats& GetStats() const noexcept { return m_Stats; }
+        void ResetStats() noexcept { m_Stats = {}; }
+
+    private:
+        std::uint32_t m_RowSize = 0;
+        std::uint32_t m_NumRows = 0;
+        std::vector<std::byte> m_Data{};
+        std::vector<std::uint32_t> m_FreeRows{};
+        // 每行一位，数量远少于行数时也只需扫描 m_NumRows / 64 个字
+        std::vector<std::uint64_t> m_DirtyMask{};
+        std::uint32_t m_NumDirty = 0;
+
+        std::vector<SceneScatterRange> m_Ranges{};
+        std::vector<std::uint32_t> m_ScatterRows{};
+        GpuSceneTableStats m_Stats{};
+    };
+
+    template <typename T>
+    bool GpuSceneTable::Write(std::uint32_t row, const T& data)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return Write(row, static_cast<const void*>(&data));
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "IndirectDrawPacker.h"
+
+namespace DSM {
+    std::size_t IndirectDrawPacker::KeyHash::operator()(const IndirectBucketKey& key) const noexcept
+    {
+        auto hash = std::hash<std::uint64_t>{}(key.m_Mesh);
+        auto combine = [&hash](std::uint64_t value) {
+            hash ^= std::hash<std::uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        };
+        combine(key.m_Material);
+        combine(key.m_PSOIndex);
+        return hash;
+    }
+
+    void IndirectDrawPacker::Clear()
+    {
+        m_BucketLookup.clear();
+        m_Buckets.clear();
+        m_PendingRecords.clear();
+        m_RecordBuckets.clear();
+        m_Records.clear();
+    }
+
+    void IndirectDrawPacker::Add(std::uint32_t draw, const IndirectBucketKey& key, std::uint64_t rootAddress,
+        const IndirectDrawIndexedArgs& args, bool merge)
+    {
+        auto bucketIndex = static_cast<std::uint32_t>(m_Buckets.size());
+        if (merge) {
+            auto [it, inserted] = m_BucketLookup.try_emplace(key, bucketIndex);
+            if (!inserted) {
+                bucketIndex = it->second;
+            }
+        }
+
+        if (bucketIndex == m_Buckets.size()) {
+            m_Buckets.push_back({0, 0, key.m_PSOIndex, draw});
+        }
+        ++m_Buckets[bucketIndex].m_NumRecords;
+        m_PendingRecords.push_back({rootAddress, args});
+        m_RecordBuckets.push_back(bucketIndex);
+    }
+
+    void IndirectDrawPacker::Build()
+    {
+        // 桶的大小在添加时已经统计，按桶计数排序即可保持桶内的顺序
+        std::uint32_t firstRecord = 0;
+        for (auto& bucket : m_Buckets) {
+            bucket.m_FirstRecord = firstRecord;
+            firstRecord += bucket.m_NumRecords;
+        }
+
+        m_Records.resize(m_PendingRecords.size());
+        for (std::size_t i = 0; i < m_PendingRecords.size(); ++i) {
+            auto& bucket = m_Buckets[m_RecordBuckets[i]];
+            m_Records[bucket.m_FirstRecord++] = m_PendingRecords[i];
+        }
+        for (auto& bucket : m_Buckets) {
+            bucket.m_FirstRecord -= bucket.m_NumRecords;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef __INDIRECTDRAWPACKER_H__
+#define __INDIRECTDRAWPACKER_H__
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace DSM {
+    // 与 D3D12_DRAW_INDEXED_ARGUMENTS 相同
+    struct IndirectDrawIndexedArgs
+    {
+        std::uint32_t m_IndexCountPerInstance{};
+        std::uint32_t m_InstanceCount{};
+        std::uint32_t m_StartIndexLocation{};
+        std::int32_t m_BaseVertexLocation{};
+        std::uint32_t m_StartInstanceLocation{};
+    };
+
+    // 参数缓冲中的一条记录，对应命令签名 {根描述符, DrawIndexed}
+    // 填充到 32 字节，GPU 剔除压缩可见绘制时按相同的布局写入
+    struct IndirectDrawRecord
+    {
+        std::uint64_t m_RootAddress{};
+        IndirectDrawIndexedArgs m_Args{};
+        std::uint32_t m_Padding{};
+    };
+    static_assert(sizeof(IndirectDrawRecord) == 32);
+
+    // 无法通过间接参数修改的状态，相同的记录可以在一次 ExecuteIndirect 中提交
+    // 网格决定顶点与索引缓冲，材质决定常量缓冲与描述符表
+    struct IndirectBucketKey
+    {
+        std::uint32_t m_PSOIndex{};
+        std::uint64_t m_Mesh{};
+        std::uint64_t m_Material{};
+
+        bool operator==(const IndirectBucketKey&) const noexcept = default;
+    };
+
+    struct IndirectBucket
+    {
+        // 桶中的记录在 GetRecords() 中的范围
+        std::uint32_t m_FirstRecord{};
+        std::uint32_t m_NumRecords{};
+        std::uint32_t m_PSOIndex{};
+        // 第一条记录的绘制索引，用于设置桶内共享的状态
+        std::uint32_t m_Draw{};
+    };
+
+    // 将绘制按共享的状态打包为间接绘制的参数，只处理排序与分组，不访问设备
+    // 桶按第一次添加的顺序排列，桶内的记录保持添加的顺序
+    class IndirectDrawPacker
+    {
+    public:
+        inline static constexpr std::uint32_t sm_RecordStride = sizeof(IndirectDrawRecord);
+
+        void Clear();
+        // draw 为调用者的绘制索引，不能合并的绘制(如半透明)单独成为一个桶
+        void Add(std::uint32_t draw, const IndirectBucketKey& key, std::uint64_t rootAddress,
+            const IndirectDrawIndexedArgs& args, bool merge = true);
+        void Build();
+
+        std::span<const IndirectBucket> GetBuckets() const noexcept { return m_Buckets; }
+        // 按桶排列的记录，直接复制到参数缓冲中
+        std::span<const IndirectDrawRecord> GetRecords() const noexcept { return m_Records; }
+        std::size_t GetNumDraws() const noexcept { return m_PendingRecords.size(); }
+
+    private:
+        struct KeyHash
+        {
+            std::size_t operator()(const IndirectBucketKey& key) const noexcept;
+        };
+
+    private:
+        std::unordered_map<IndirectBucketKey, std::uint32_t, KeyHash> m_BucketLookup{};
+        std::vector<IndirectBucket> m_Buckets{};
+        // 与添加的记录对应
+        std::vector<IndirectDrawRecord> m_PendingRecords{};
+        std::vector<std::uint32_t> m_RecordBuckets{};
+        std::vector<IndirectDrawRecord> m_Records{};
+    };
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "InstanceBatcher.h"
+#include <algorithm>
+#include <numeric>
+
+namespace DSM {
+    std::size_t InstanceBatcher::KeyHash::operator()(const InstanceKey& key) const noexcept
+    {
+        auto hash = std::hash<std::uint64_t>{}(key.m_Mesh);
+        auto combine = [&hash](std::uint64_t value) {
+            hash ^= std::hash<std::uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        };
+        combine(key.m_SubMesh);
+        combine(key.m_Material);
+        combine(key.m_PSOIndex);
+        return hash;
+    }
+
+    void InstanceBatcher::Clear()
+    {
+        m_GroupLookup.clear();
+        m_Groups.clear();
+        m_Draws.clear();
+        m_SortedDraws.clear();
+        m_GroupOrder.clear();
+        m_Batches.clear();
+        m_InstanceOrder.clear();
+    }
+
+    void InstanceBatcher::Add(std::uint32_t draw, const InstanceKey& key, float distance, bool instancing)
+    {
+        auto groupIndex = static_cast<std::uint32_t>(m_Groups.size());
+        if (instancing) {
+            auto [it, inserted] = m_GroupLookup.try_emplace(key, groupIndex);
+            if (!inserted) {
+                groupIndex = it->second;
+            }
+        }
+
+        if (groupIndex == m_Groups.size()) {
+            m_Groups.push_back({key.m_PSOIndex, distance});
+        }
+        else {
+            auto& group = m_Groups[groupIndex];
+            group.m_MinDistance = (std::min)(group.m_MinDistance, distance);
+        }
+        m_Draws.push_back({draw, groupIndex, distance});
+    }
+
+    void InstanceBatcher::Build()
+    {
+        // 先按 PSO 减少状态切换，再由近到远减少过度绘制
+        m_GroupOrder.resize(m_Groups.size());
+        std::iota(m_GroupOrder.begin(), m_GroupOrder.end(), 0u);
+        std::sort(m_GroupOrder.begin(), m_GroupOrder.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+            const auto& l = m_Groups[lhs];
+            const auto& r = m_Groups[rhs];
+            if (l.m_PSOIndex != r.m_PSOIndex) return l.m_PSOIndex < r.m_PSOIndex;
+            if (l.m_MinDistance != r.m_MinDistance) return l.m_MinDistance < r.m_MinDistance;
+            return lhs < rhs;
+        });
+
+        // 组的数量远少于绘制，按组计数排序后只需在组内排序
+        m_Batches.resize(m_Groups.size());
+        for (auto& group : m_Groups) {
+            group.m_NumDraws = 0;
+        }
+        for (const auto& draw : m_Draws) {
+            ++m_Groups[draw.m_Group].m_NumDraws;
+        }
+        std::uint32_t firstInstance = 0;
+        for (std::size_t i = 0; i < m_GroupOrder.size(); ++i) {
+            auto& group = m_Groups[m_GroupOrder[i]];
+            m_Batches[i] = {firstInstance, group.m_NumDraws, group.m_PSOIndex};
+            group.m_FirstInstance = firstInstance;
+            firstInstance += group.m_NumDraws;
+        }
+
+        m_SortedDraws.resize(m_Draws.size());
+        for (const auto& draw : m_Draws) {
+            m_SortedDraws[m_Groups[draw.m_Group].m_FirstInstance++] = draw;
+        }
+
+        m_InstanceOrder.resize(m_Draws.size());
+        for (const auto& batch : m_Batches) {
+            auto begin = m_SortedDraws.begin() + batch.m_FirstInstance;
+            auto end = begin + batch.m_NumInstances;
+            if (batch.m_NumInstances > 1) {
+                std::sort(begin, end, [](const Draw& lhs, const Draw& rhs) {
+                    if (lhs.m_Distance != rhs.m_Distance) return lhs.m_Distance < rhs.m_Distance;
+                    return lhs.m_Draw < rhs.m_Draw;
+                });
+            }
+            for (auto it = begin; it != end; ++it) {
+                m_InstanceOrder[it - m_SortedDraws.begin()] = it->m_Draw;
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef __INSTANCEBATCHER_H__
+#define __INSTANCEBATCHER_H__
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace DSM {
+    // 相同的键可以合并为一次实例化绘制，通常为网格、子网格、PSO 与材质的标识
+    struct InstanceKey
+    {
+        std::uint64_t m_Mesh{};
+        std::uint64_t m_SubMesh{};
+        std::uint64_t m_Material{};
+        std::uint32_t m_PSOIndex{};
+
+        bool operator==(const InstanceKey&) const noexcept = default;
+    };
+
+    struct InstanceBatch
+    {
+        // 批次中的实例在 GetInstanceOrder() 中的范围
+        std::uint32_t m_FirstInstance{};
+        std::uint32_t m_NumInstances{};
+        std::uint32_t m_PSOIndex{};
+    };
+
+    // 将相同的绘制合并为实例化绘制，只处理排序与分组，不访问设备
+    // 批次按 PSO 分组，同一 PSO 内按最近的实例由近到远排列，批次内的实例同样由近到远
+    class InstanceBatcher
+    {
+    public:
+        void Clear();
+        // draw 为调用者的绘制索引，不能合并的绘制(如半透明)单独成为一个批次
+        void Add(std::uint32_t draw, const InstanceKey& key, float distance, bool instancing = true);
+        void Build();
+
+        std::span<const InstanceBatch> GetBatches() const noexcept { return m_Batches; }
+        // 按批次排列的绘制索引，实例数据按该顺序写入
+        std::span<const std::uint32_t> GetInstanceOrder() const noexcept { return m_InstanceOrder; }
+        std::size_t GetNumDraws() const noexcept { return m_Draws.size(); }
+
+    private:
+        struct KeyHash
+        {
+            std::size_t operator()(const InstanceKey& key) const noexcept;
+        };
+
+        struct Group
+        {
+            std::uint32_t m_PSOIndex{};
+            float m_MinDistance{};
+            std::uint32_t m_NumDraws{};
+            std::uint32_t m_FirstInstance{};
+        };
+
+        struct Draw
+        {
+            std::uint32_t m_Draw{};
+            std::uint32_t m_Group{};
+            float m_Distance{};
+        };
+
+    private:
+        std::unordered_map<InstanceKey, std::uint32_t, KeyHash> m_GroupLookup{};
+        std::vector<Group> m_Groups{};
+        std::vector<Draw> m_Draws{};
+        std::vector<Draw> m_SortedDraws{};
+        std::vector<std::uint32_t> m_GroupOrder{};
+        std::vector<InstanceBatch> m_Batches{};
+        std::vector<std::uint32_t> m_InstanceOrder{};
+    };
+}
+
+#endif
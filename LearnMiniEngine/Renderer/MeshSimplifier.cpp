@@ -0,0 +1,647 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+namespace DSM {
+    namespace {
+        constexpr std::uint32_t kInvalid = ~0u;
+        constexpr std::uint32_t kCacheMagic = 0x444f4c44;    // "DLOD"
+        constexpr std::uint32_t kCacheVersion = 1;
+        // 折叠后三角形法线的夹角超过约 75 度时认为翻转
+        constexpr float kFlipThreshold = 0.25f;
+
+        const float* GetInputPosition(const MeshSimplifierInput& input, std::uint32_t vertex) noexcept
+        {
+            auto* data = static_cast<const std::byte*>(input.m_Positions) + std::size_t(vertex) * input.m_PositionStride;
+            return reinterpret_cast<const float*>(data);
+        }
+
+        const float* GetInputAttributes(const MeshSimplifierInput& input, std::uint32_t vertex) noexcept
+        {
+            auto* data = reinterpret_cast<const std::byte*>(input.m_Attributes) + std::size_t(vertex) * input.m_AttributeStride;
+            return reinterpret_cast<const float*>(data);
+        }
+
+        std::uint32_t HashFloats(const float* data, std::uint32_t count) noexcept
+        {
+            std::uint32_t hash = 2166136261u;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                std::uint32_t bits;
+                memcpy(&bits, data + i, sizeof(bits));
+                hash = (hash ^ bits) * 16777619u;
+            }
+            return hash ^ (hash >> 15);
+        }
+
+        // 用开放寻址的哈希表合并内容相同的顶点，返回每个顶点第一个相同顶点的序号，不使用的顶点为 kInvalid
+        template <typename HashFunc, typename EqualFunc>
+        std::vector<std::uint32_t> WeldVertices(std::uint32_t numVertices, const std::vector<std::uint8_t>& used,
+            HashFunc&& hash, EqualFunc&& equal)
+        {
+            std::uint32_t capacity = std::bit_ceil((std::max)(numVertices * 2, 16u));
+            std::vector<std::uint32_t> table(capacity, kInvalid);
+            std::vector<std::uint32_t> remap(numVertices, kInvalid);
+            for (std::uint32_t v = 0; v < numVertices; ++v) {
+                if (!used[v]) continue;
+                for (auto slot = hash(v) & (capacity - 1);; slot = (slot + 1) & (capacity - 1)) {
+                    auto entry = table[slot];
+                    if (entry == kInvalid) {
+                        table[slot] = remap[v] = v;
+                        break;
+                    }
+                    if (equal(entry, v)) {
+                        remap[v] = entry;
+                        break;
+                    }
+                }
+            }
+            return remap;
+        }
+
+        void Cross(const float* a, const float* b, const float* c, double* out) noexcept
+        {
+            double e1[3] = {double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2]};
+            double e2[3] = {double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2]};
+            out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        }
+
+        double Dot(const double* a, const double* b) noexcept
+        {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        }
+    }
+
+    void MeshSimplifier::Initialize(const MeshSimplifierInput& input)
+    {
+        *this = {};
+        m_NumVertices = input.m_NumVertices;
+        m_NumAttributes = input.m_Attributes ? (std::min)(input.m_NumAttributes, sm_MaxAttributes) : 0;
+
+        // 归一化之后属性的权重与位置的误差可以直接比较
+        float minPos[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        float maxPos[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+        for (std::uint32_t v = 0; v < m_NumVertices; ++v) {
+            const auto* p = GetInputPosition(input, v);
+            for (int i = 0; i < 3; ++i) {
+                minPos[i] = (std::min)(minPos[i], p[i]);
+                maxPos[i] = (std::max)(maxPos[i], p[i]);
+            }
+        }
+        float extent = (std::max)({maxPos[0] - minPos[0], maxPos[1] - minPos[1], maxPos[2] - minPos[2], 0.0f});
+        m_Scale = extent > 0 ? 1 / extent : 1;
+
+        m_Positions.resize(std::size_t(m_NumVertices) * 3);
+        m_Attributes.resize(std::size_t(m_NumVertices) * m_NumAttributes);
+        for (std::uint32_t v = 0; v < m_NumVertices; ++v) {
+            const auto* p = GetInputPosition(input, v);
+            for (int i = 0; i < 3; ++i) {
+                m_Positions[v * 3 + i] = (p[i] - minPos[i]) * m_Scale;
+            }
+            if (m_NumAttributes == 0) continue;
+            const auto* a = GetInputAttributes(input, v);
+            for (std::uint32_t i = 0; i < m_NumAttributes; ++i) {
+                m_Attributes[v * m_NumAttributes + i] = a[i] * (input.m_AttributeWeights ? input.m_AttributeWeights[i] : 1.0f);
+            }
+        }
+
+        std::uint32_t fullSubMesh[] = {input.m_NumIndices};
+        auto subMeshIndexCounts = input.m_SubMeshIndexCounts.empty() ? std::span<const std::uint32_t>{fullSubMesh} : input.m_SubMeshIndexCounts;
+        m_NumSubMeshes = static_cast<std::uint32_t>(subMeshIndexCounts.size());
+
+        // 位置与属性都相同的顶点合并，未经索引的网格每个角都是单独的顶点
+        // 不同子网格的顶点不合并，各级 LOD 的索引仍在子网格自己的顶点范围内
+        std::vector<std::uint32_t> vertexSubMeshes(m_NumVertices, kInvalid);
+        for (std::uint32_t s = 0, first = 0; s < m_NumSubMeshes; ++s) {
+            auto end = (std::min)(first + subMeshIndexCounts[s], input.m_NumIndices);
+            for (auto i = first; i < end; ++i) {
+                auto index = input.m_Indices[i];
+                if (index < m_NumVertices && vertexSubMeshes[index] == kInvalid) vertexSubMeshes[index] = s;
+            }
+            first = end;
+        }
+        std::vector<std::uint8_t> used(m_NumVertices, 1);
+        auto canonical = WeldVertices(m_NumVertices, used,
+            [&](std::uint32_t v) {
+                return HashFloats(GetPosition(v), 3) ^ HashFloats(GetAttributes(v), m_NumAttributes) * 31 ^ vertexSubMeshes[v];
+            },
+            [&](std::uint32_t a, std::uint32_t b) {
+                return vertexSubMeshes[a] == vertexSubMeshes[b] &&
+                    memcmp(GetPosition(a), GetPosition(b), sizeof(float) * 3) == 0 &&
+                    memcmp(GetAttributes(a), GetAttributes(b), sizeof(float) * m_NumAttributes) == 0;
+            });
+        m_Indices.reserve(input.m_NumIndices);
+        m_TriangleSubMeshes.reserve(input.m_NumIndices / 3);
+        std::fill(used.begin(), used.end(), 0);
+        std::uint32_t first = 0;
+        for (std::uint32_t s = 0; s < m_NumSubMeshes; ++s) {
+            auto end = (std::min)(first + subMeshIndexCounts[s], input.m_NumIndices);
+            for (auto i = first; i + 3 <= end; i += 3) {
+                const auto* tri = input.m_Indices + i;
+                if (tri[0] >= m_NumVertices || tri[1] >= m_NumVertices || tri[2] >= m_NumVertices) continue;
+                std::uint32_t corners[3] = {canonical[tri[0]], canonical[tri[1]], canonical[tri[2]]};
+                for (auto corner : corners) {
+                    m_Indices.push_back(corner);
+                    used[corner] = 1;
+                }
+                m_TriangleSubMeshes.push_back(s);
+            }
+            first = end;
+        }
+
+        // 只在使用的顶点中按位置合并，否则没有被引用的顶点会让所在的位置看起来是接缝
+        m_Remap = WeldVertices(m_NumVertices, used,
+            [&](std::uint32_t v) { return HashFloats(GetPosition(v), 3); },
+            [&](std::uint32_t a, std::uint32_t b) { return memcmp(GetPosition(a), GetPosition(b), sizeof(float) * 3) == 0; });
+        m_Wedges.resize(m_NumVertices);
+        std::iota(m_Wedges.begin(), m_Wedges.end(), 0u);
+        for (std::uint32_t v = 0; v < m_NumVertices; ++v) {
+            auto rep = m_Remap[v];
+            if (rep == kInvalid || rep == v) continue;
+            m_Wedges[v] = m_Wedges[rep];
+            m_Wedges[rep] = v;
+        }
+
+        m_CollapseRemap.resize(m_NumVertices);
+        std::iota(m_CollapseRemap.begin(), m_CollapseRemap.end(), 0u);
+        m_CollapseLocked.resize(m_NumVertices);
+        m_Kinds.resize(m_NumVertices);
+        m_OpenOut.resize(m_NumVertices);
+        m_OpenIn.resize(m_NumVertices);
+        RemoveDegenerateTriangles();
+        ComputeQuadrics();
+    }
+
+    void MeshSimplifier::AddQuadric(Quadric& dest, const Quadric& src) noexcept
+    {
+        dest.m_A00 += src.m_A00;
+        dest.m_A11 += src.m_A11;
+        dest.m_A22 += src.m_A22;
+        dest.m_A01 += src.m_A01;
+        dest.m_A02 += src.m_A02;
+        dest.m_A12 += src.m_A12;
+        dest.m_B0 += src.m_B0;
+        dest.m_B1 += src.m_B1;
+        dest.m_B2 += src.m_B2;
+        dest.m_C += src.m_C;
+        dest.m_Weight += src.m_Weight;
+    }
+
+    double MeshSimplifier::EvaluateQuadric(const Quadric& q, const float* p) noexcept
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double r = q.m_A00 * x * x + q.m_A11 * y * y + q.m_A22 * z * z;
+        r += 2 * (q.m_A01 * x * y + q.m_A02 * x * z + q.m_A12 * y * z);
+        r += 2 * (q.m_B0 * x + q.m_B1 * y + q.m_B2 * z);
+        return r + q.m_C;
+    }
+
+    void MeshSimplifier::ComputeQuadrics()
+    {
+        m_PositionQuadrics.assign(m_NumVertices, {});
+        m_AttributeQuadrics.assign(m_NumVertices, {});
+        m_AttributeGradients.assign(std::size_t(m_NumVertices) * m_NumAttributes * 4, 0);
+
+        for (std::size_t t = 0; t < m_TriangleSubMeshes.size(); ++t) {
+            const auto* tri = &m_Indices[t * 3];
+            const float* p[3] = {GetPosition(tri[0]), GetPosition(tri[1]), GetPosition(tri[2])};
+            double normal[3];
+            Cross(p[0], p[1], p[2], normal);
+            double length = std::sqrt(Dot(normal, normal));
+            if (length <= 0) continue;
+
+            // 按面积加权的平面，误差为到三角形所在平面距离的平方
+            double area = length * 0.5;
+            double n[3] = {normal[0] / length, normal[1] / length, normal[2] / length};
+            double d = -(n[0] * p[0][0] + n[1] * p[0][1] + n[2] * p[0][2]);
+            Quadric plane{
+                area * n[0] * n[0], area * n[1] * n[1], area * n[2] * n[2],
+                area * n[0] * n[1], area * n[0] * n[2], area * n[1] * n[2],
+                area * d * n[0], area * d * n[1], area * d * n[2],
+                area * d * d, area};
+            for (int i = 0; i < 3; ++i) {
+                AddQuadric(m_PositionQuadrics[m_Remap[tri[i]]], plane);
+            }
+            if (m_NumAttributes == 0) continue;
+
+            // 每个属性分量在三角形上线性插值 a(p) = g·p + d，g 在三角形所在的平面内
+            // 误差为 (a - a(p))² 在三角形上按面积加权，展开后 a(p)² 的部分合并为一个二次型
+            double e1[3] = {double(p[1][0]) - p[0][0], double(p[1][1]) - p[0][1], double(p[1][2]) - p[0][2]};
+            double e2[3] = {double(p[2][0]) - p[0][0], double(p[2][1]) - p[0][1], double(p[2][2]) - p[0][2]};
+            double g11 = Dot(e1, e1), g12 = Dot(e1, e2), g22 = Dot(e2, e2);
+            double det = g11 * g22 - g12 * g12;
+            if (det <= 0) continue;
+
+            Quadric attribute{};
+            attribute.m_Weight = area;
+            double gradients[sm_MaxAttributes][4];
+            const float* a[3] = {GetAttributes(tri[0]), GetAttributes(tri[1]), GetAttributes(tri[2])};
+            for (std::uint32_t k = 0; k < m_NumAttributes; ++k) {
+                double d1 = double(a[1][k]) - a[0][k];
+                double d2 = double(a[2][k]) - a[0][k];
+                double alpha = (g22 * d1 - g12 * d2) / det;
+                double beta = (g11 * d2 - g12 * d1) / det;
+                double g[3] = {alpha * e1[0] + beta * e2[0], alpha * e1[1] + beta * e2[1], alpha * e1[2] + beta * e2[2]};
+                double offset = a[0][k] - (g[0] * p[0][0] + g[1] * p[0][1] + g[2] * p[0][2]);
+
+                attribute.m_A00 += area * g[0] * g[0];
+                attribute.m_A11 += area * g[1] * g[1];
+                attribute.m_A22 += area * g[2] * g[2];
+                attribute.m_A01 += area * g[0] * g[1];
+                attribute.m_A02 += area * g[0] * g[2];
+                attribute.m_A12 += area * g[1] * g[2];
+                attribute.m_B0 += area * offset * g[0];
+                attribute.m_B1 += area * offset * g[1];
+                attribute.m_B2 += area * offset * g[2];
+                attribute.m_C += area * offset * offset;
+                gradients[k][0] = area * g[0];
+                gradients[k][1] = area * g[1];
+                gradients[k][2] = area * g[2];
+                gradients[k][3] = area * offset;
+            }
+            for (int i = 0; i < 3; ++i) {
+                AddQuadric(m_AttributeQuadrics[tri[i]], attribute);
+                auto* dest = &m_AttributeGradients[std::size_t(tri[i]) * m_NumAttributes * 4];
+                for (std::uint32_t k = 0; k < m_NumAttributes; ++k) {
+                    for (int j = 0; j < 4; ++j) {
+                        dest[k * 4 + j] += gradients[k][j];
+                    }
+                }
+            }
+        }
+    }
+
+    void MeshSimplifier::Classify()
+    {
+        // 按起点排列的有向边
+        auto numIndices = static_cast<std::uint32_t>(m_Indices.size());
+        m_EdgeOffsets.assign(m_NumVertices + 1, 0);
+        m_Edges.resize(numIndices);
+        for (std::uint32_t i = 0; i < numIndices; ++i) {
+            ++m_EdgeOffsets[m_Indices[i] + 1];
+        }
+        std::partial_sum(m_EdgeOffsets.begin(), m_EdgeOffsets.end(), m_EdgeOffsets.begin());
+        std::vector<std::uint32_t> cursor(m_EdgeOffsets.begin(), m_EdgeOffsets.end() - 1);
+        for (std::uint32_t i = 0; i < numIndices; i += 3) {
+            for (std::uint32_t j = 0; j < 3; ++j) {
+                m_Edges[cursor[m_Indices[i + j]]++] = m_Indices[i + (j + 1) % 3];
+            }
+        }
+
+        // 没有反向边的边为开放边，在位置空间中可能是接缝的一侧
+        std::vector<std::uint8_t> numOpenOut(m_NumVertices, 0), numOpenIn(m_NumVertices, 0);
+        std::fill(m_OpenOut.begin(), m_OpenOut.end(), kInvalid);
+        std::fill(m_OpenIn.begin(), m_OpenIn.end(), kInvalid);
+        for (std::uint32_t a = 0; a < m_NumVertices; ++a) {
+            for (auto e = m_EdgeOffsets[a]; e < m_EdgeOffsets[a + 1]; ++e) {
+                auto b = m_Edges[e];
+                if (HasEdge(b, a)) continue;
+                numOpenOut[a] = std::uint8_t((std::min)(numOpenOut[a] + 1, 2));
+                numOpenIn[b] = std::uint8_t((std::min)(numOpenIn[b] + 1, 2));
+                m_OpenOut[a] = b;
+                m_OpenIn[b] = a;
+            }
+        }
+
+        for (std::uint32_t v = 0; v < m_NumVertices; ++v) {
+            auto wedge = m_Wedges[v];
+            if (m_EdgeOffsets[v] == m_EdgeOffsets[v + 1]) {
+                m_Kinds[v] = kLocked;
+            }
+            else if (wedge == v) {
+                // 开放边界上的顶点不移动
+                m_Kinds[v] = numOpenOut[v] == 0 && numOpenIn[v] == 0 ? kManifold : kLocked;
+            }
+            else if (m_Wedges[wedge] == v) {
+                // 两侧各有一条开放边，且在位置空间中互为反向边，即接缝两侧的三角形相接
+                bool seam = numOpenOut[v] == 1 && numOpenIn[v] == 1 && numOpenOut[wedge] == 1 && numOpenIn[wedge] == 1 &&
+                    m_Remap[m_OpenOut[v]] == m_Remap[m_OpenIn[wedge]] &&
+                    m_Remap[m_OpenIn[v]] == m_Remap[m_OpenOut[wedge]];
+                m_Kinds[v] = seam ? kSeam : kLocked;
+            }
+            else {
+                m_Kinds[v] = kLocked;
+            }
+        }
+    }
+
+    bool MeshSimplifier::HasEdge(std::uint32_t from, std::uint32_t to) const noexcept
+    {
+        for (auto e = m_EdgeOffsets[from]; e < m_EdgeOffsets[from + 1]; ++e) {
+            if (m_Edges[e] == to) return true;
+        }
+        return false;
+    }
+
+    bool MeshSimplifier::CanCollapse(std::uint32_t from, std::uint32_t to) const noexcept
+    {
+        switch (m_Kinds[from]) {
+            case kManifold: return true;
+            case kSeam: return to == m_OpenOut[from] || to == m_OpenIn[from];
+            default: return false;
+        }
+    }
+
+    void MeshSimplifier::BuildVertexTriangles()
+    {
+        auto numIndices = static_cast<std::uint32_t>(m_Indices.size());
+        m_TriangleOffsets.assign(m_NumVertices + 1, 0);
+        m_VertexTriangles.resize(numIndices);
+        for (std::uint32_t i = 0; i < numIndices; ++i) {
+            ++m_TriangleOffsets[m_Indices[i] + 1];
+        }
+        std::partial_sum(m_TriangleOffsets.begin(), m_TriangleOffsets.end(), m_TriangleOffsets.begin());
+        std::vector<std::uint32_t> cursor(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+        for (std::uint32_t i = 0; i < numIndices; ++i) {
+            m_VertexTriangles[cursor[m_Indices[i]]++] = i / 3;
+        }
+    }
+
+    void MeshSimplifier::GetSeamPair(std::uint32_t from, std::uint32_t to, std::uint32_t& pairFrom, std::uint32_t& pairTo) const noexcept
+    {
+        // 接缝另一侧的边方向相反
+        pairFrom = m_Wedges[from];
+        pairTo = to == m_OpenOut[from] ? m_OpenIn[pairFrom] : m_OpenOut[pairFrom];
+    }
+
+    double MeshSimplifier::GetAttributeError(std::uint32_t from, std::uint32_t to) const noexcept
+    {
+        if (m_NumAttributes == 0) return 0;
+
+        const auto& q = m_AttributeQuadrics[from];
+        const auto* p = GetPosition(to);
+        const auto* attributes = GetAttributes(to);
+        const auto* gradients = &m_AttributeGradients[std::size_t(from) * m_NumAttributes * 4];
+        double error = EvaluateQuadric(q, p);
+        for (std::uint32_t k = 0; k < m_NumAttributes; ++k) {
+            double a = attributes[k];
+            const auto* g = gradients + k * 4;
+            error += q.m_Weight * a * a - 2 * a * (g[0] * p[0] + g[1] * p[1] + g[2] * p[2] + g[3]);
+        }
+        return (std::max)(error, 0.0);
+    }
+
+    float MeshSimplifier::GetCollapseCost(std::uint32_t from, std::uint32_t to, float& geometryError) const noexcept
+    {
+        const auto& q = m_PositionQuadrics[m_Remap[from]];
+        double geometry = (std::max)(EvaluateQuadric(q, GetPosition(to)), 0.0);
+        double attribute = GetAttributeError(from, to);
+        if (m_Kinds[from] == kSeam) {
+            std::uint32_t pairFrom, pairTo;
+            GetSeamPair(from, to, pairFrom, pairTo);
+            attribute += GetAttributeError(pairFrom, pairTo);
+        }
+
+        // 按面积归一化为平均的平方距离
+        double weight = q.m_Weight > 0 ? q.m_Weight : 1;
+        geometryError = static_cast<float>(geometry / weight);
+        return static_cast<float>((geometry + attribute) / weight);
+    }
+
+    bool MeshSimplifier::IsFlipped(std::uint32_t from, std::uint32_t to) const noexcept
+    {
+        const auto* target = GetPosition(to);
+        for (auto i = m_TriangleOffsets[from]; i < m_TriangleOffsets[from + 1]; ++i) {
+            const auto* tri = &m_Indices[m_VertexTriangles[i] * 3];
+            // 同一遍中已经折叠的顶点按折叠之后的位置计算
+            std::uint32_t corners[3] = {Resolve(tri[0]), Resolve(tri[1]), Resolve(tri[2])};
+            int j = corners[0] == from ? 0 : corners[1] == from ? 1 : corners[2] == from ? 2 : -1;
+            if (j < 0) continue;
+
+            auto b = corners[(j + 1) % 3], c = corners[(j + 2) % 3];
+            // 包含目标位置的三角形折叠后退化并被移除
+            if (m_Remap[b] == m_Remap[to] || m_Remap[c] == m_Remap[to]) continue;
+
+            double before[3], after[3];
+            Cross(GetPosition(from), GetPosition(b), GetPosition(c), before);
+            Cross(target, GetPosition(b), GetPosition(c), after);
+            // 原本就退化的三角形无法判断
+            if (Dot(before, before) <= 0) continue;
+            if (Dot(before, after) <= kFlipThreshold * std::sqrt(Dot(before, before) * Dot(after, after))) return true;
+        }
+        return false;
+    }
+
+    void MeshSimplifier::RemoveDegenerateTriangles()
+    {
+        std::size_t numTriangles = 0;
+        for (std::size_t t = 0; t < m_TriangleSubMeshes.size(); ++t) {
+            std::uint32_t corners[3] = {Resolve(m_Indices[t * 3]), Resolve(m_Indices[t * 3 + 1]), Resolve(m_Indices[t * 3 + 2])};
+            auto p0 = m_Remap[corners[0]], p1 = m_Remap[corners[1]], p2 = m_Remap[corners[2]];
+            if (p0 == p1 || p1 == p2 || p0 == p2) continue;
+            std::copy_n(corners, 3, &m_Indices[numTriangles * 3]);
+            m_TriangleSubMeshes[numTriangles++] = m_TriangleSubMeshes[t];
+        }
+        m_Indices.resize(numTriangles * 3);
+        m_TriangleSubMeshes.resize(numTriangles);
+    }
+
+    std::uint32_t MeshSimplifier::Simplify(std::uint32_t targetTriangles, float maxError)
+    {
+        float errorLimit = maxError * maxError;
+        while (GetNumTriangles() > targetTriangles) {
+            Classify();
+            BuildVertexTriangles();
+
+            // 每条边只取代价较小的方向
+            m_Collapses.clear();
+            for (std::size_t i = 0; i < m_Indices.size(); i += 3) {
+                for (std::size_t j = 0; j < 3; ++j) {
+                    auto a = m_Indices[i + j], b = m_Indices[i + (j + 1) % 3];
+                    // 两侧都有三角形的边只在一侧处理
+                    if (a > b && HasEdge(b, a)) continue;
+
+                    Collapse collapse{std::numeric_limits<float>::max(), kInvalid, kInvalid};
+                    float geometryError;
+                    if (CanCollapse(a, b)) {
+                        collapse = {GetCollapseCost(a, b, geometryError), a, b};
+                    }
+                    if (CanCollapse(b, a)) {
+                        auto cost = GetCollapseCost(b, a, geometryError);
+                        if (cost < collapse.m_Cost) collapse = {cost, b, a};
+                    }
+                    if (collapse.m_From != kInvalid) m_Collapses.push_back(collapse);
+                }
+            }
+            if (m_Collapses.empty()) break;
+
+            // 每个位置一遍中只参与一次折叠，因此折叠的代价在这一遍中不变
+            // 每次折叠大约去掉两个三角形，一遍最多去掉八分之一，剩下的在下一遍重新计算代价
+            auto numTriangles = GetNumTriangles();
+            auto maxCollapses = (std::min)((numTriangles - targetTriangles + 1) / 2, (std::max)(numTriangles / 16, 1u));
+            // 被锁定的候选会跳过，只排序最便宜的一部分
+            auto numSorted = (std::min)(m_Collapses.size(), std::size_t(maxCollapses) * 4);
+            auto byCost = [](const Collapse& a, const Collapse& b) { return a.m_Cost < b.m_Cost; };
+            std::nth_element(m_Collapses.begin(), m_Collapses.begin() + numSorted, m_Collapses.end(), byCost);
+            std::sort(m_Collapses.begin(), m_Collapses.begin() + numSorted, byCost);
+            m_Collapses.resize(numSorted);
+
+            std::uint32_t numCollapses = 0;
+            for (const auto& collapse : m_Collapses) {
+                if (numCollapses >= maxCollapses || collapse.m_Cost > errorLimit) break;
+
+                auto from = collapse.m_From, to = collapse.m_To;
+                if (m_CollapseLocked[m_Remap[from]] || m_CollapseLocked[m_Remap[to]]) continue;
+                bool seam = m_Kinds[from] == kSeam;
+                std::uint32_t pairFrom = kInvalid, pairTo = kInvalid;
+                if (seam) {
+                    GetSeamPair(from, to, pairFrom, pairTo);
+                    if (pairTo == kInvalid) continue;
+                }
+                if (IsFlipped(from, to) || (seam && IsFlipped(pairFrom, pairTo))) continue;
+
+                float geometryError;
+                GetCollapseCost(from, to, geometryError);
+                m_ErrorSquared = (std::max)(m_ErrorSquared, geometryError);
+
+                AddQuadric(m_PositionQuadrics[m_Remap[to]], m_PositionQuadrics[m_Remap[from]]);
+                auto mergeAttributes = [&](std::uint32_t src, std::uint32_t dest) {
+                    m_CollapseRemap[src] = dest;
+                    if (m_NumAttributes == 0) return;
+                    AddQuadric(m_AttributeQuadrics[dest], m_AttributeQuadrics[src]);
+                    auto stride = std::size_t(m_NumAttributes) * 4;
+                    for (std::size_t i = 0; i < stride; ++i) {
+                        m_AttributeGradients[dest * stride + i] += m_AttributeGradients[src * stride + i];
+                    }
+                };
+                mergeAttributes(from, to);
+                if (seam) {
+                    mergeAttributes(pairFrom, pairTo);
+                }
+                // 周围的顶点在这一遍中也不再折叠，否则相邻的两次折叠可能一起移除边界上的三角形而产生裂缝
+                auto lockNeighbors = [&](std::uint32_t vertex) {
+                    for (auto i = m_TriangleOffsets[vertex]; i < m_TriangleOffsets[vertex + 1]; ++i) {
+                        const auto* tri = &m_Indices[m_VertexTriangles[i] * 3];
+                        for (int j = 0; j < 3; ++j) {
+                            m_CollapseLocked[m_Remap[Resolve(tri[j])]] = 1;
+                        }
+                    }
+                };
+                lockNeighbors(from);
+                if (seam) {
+                    lockNeighbors(pairFrom);
+                }
+                m_CollapseLocked[m_Remap[to]] = 1;
+                ++numCollapses;
+            }
+            if (numCollapses == 0) break;
+
+            RemoveDegenerateTriangles();
+            std::iota(m_CollapseRemap.begin(), m_CollapseRemap.end(), 0u);
+            std::fill(m_CollapseLocked.begin(), m_CollapseLocked.end(), 0);
+        }
+        return GetNumTriangles();
+    }
+
+    float MeshSimplifier::GetError() const noexcept
+    {
+        return std::sqrt(m_ErrorSquared) / m_Scale;
+    }
+
+    void MeshSimplifier::GetLevel(MeshLODLevel& level) const
+    {
+        // 按子网格稳定排序
+        level.m_SubMeshIndexCounts.assign(m_NumSubMeshes, 0);
+        for (auto subMesh : m_TriangleSubMeshes) {
+            level.m_SubMeshIndexCounts[subMesh] += 3;
+        }
+        std::vector<std::uint32_t> offsets(m_NumSubMeshes, 0);
+        std::exclusive_scan(level.m_SubMeshIndexCounts.begin(), level.m_SubMeshIndexCounts.end(), offsets.begin(), 0u);
+        level.m_Indices.resize(m_Indices.size());
+        for (std::size_t t = 0; t < m_TriangleSubMeshes.size(); ++t) {
+            auto& offset = offsets[m_TriangleSubMeshes[t]];
+            std::copy_n(&m_Indices[t * 3], 3, &level.m_Indices[offset]);
+            offset += 3;
+        }
+        level.m_Error = GetError();
+    }
+
+    MeshLODChain GenerateMeshLODs(const MeshSimplifierInput& input, const MeshLODDesc& desc)
+    {
+        MeshLODChain chain{};
+        chain.m_NumSourceVertices = input.m_NumVertices;
+        chain.m_NumSourceIndices = input.m_NumIndices;
+
+        MeshSimplifier simplifier{input};
+        auto numTriangles = simplifier.GetNumTriangles();
+        while (chain.m_Levels.size() < desc.m_MaxLevels && numTriangles > desc.m_MinTriangles) {
+            auto target = (std::max)(static_cast<std::uint32_t>(numTriangles * desc.m_Ratio), desc.m_MinTriangles);
+            auto result = simplifier.Simplify(target, desc.m_MaxError);
+            if (result > numTriangles * desc.m_MinReduction) break;
+
+            simplifier.GetLevel(chain.m_Levels.emplace_back());
+            numTriangles = result;
+        }
+        return chain;
+    }
+
+    bool SaveMeshLODCache(const std::filesystem::path& filename, std::uint64_t key, std::span<const MeshLODChain> chains)
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        auto write = [&](const void* data, std::size_t size) { file.write(static_cast<const char*>(data), size); };
+        auto writeU32 = [&](std::uint32_t value) { write(&value, sizeof(value)); };
+        writeU32(kCacheMagic);
+        writeU32(kCacheVersion);
+        write(&key, sizeof(key));
+        writeU32(static_cast<std::uint32_t>(chains.size()));
+        for (const auto& chain : chains) {
+            writeU32(chain.m_NumSourceVertices);
+            writeU32(chain.m_NumSourceIndices);
+            writeU32(static_cast<std::uint32_t>(chain.m_Levels.size()));
+            for (const auto& level : chain.m_Levels) {
+                write(&level.m_Error, sizeof(level.m_Error));
+                writeU32(static_cast<std::uint32_t>(level.m_SubMeshIndexCounts.size()));
+                write(level.m_SubMeshIndexCounts.data(), level.m_SubMeshIndexCounts.size() * sizeof(std::uint32_t));
+                writeU32(static_cast<std::uint32_t>(level.m_Indices.size()));
+                write(level.m_Indices.data(), level.m_Indices.size() * sizeof(std::uint32_t));
+            }
+        }
+        return file.good();
+    }
+
+    bool LoadMeshLODCache(const std::filesystem::path& filename, std::uint64_t key, std::vector<MeshLODChain>& chains)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file) return false;
+
+        auto read = [&](void* data, std::size_t size) { return static_cast<bool>(file.read(static_cast<char*>(data), size)); };
+        auto readU32 = [&](std::uint32_t& value) { return read(&value, sizeof(value)); };
+        std::uint32_t magic, version, numChains;
+        std::uint64_t fileKey;
+        if (!readU32(magic) || !readU32(version) || !read(&fileKey, sizeof(fileKey)) || !readU32(numChains)) return false;
+        if (magic != kCacheMagic || version != kCacheVersion || fileKey != key) return false;
+
+        std::vector<MeshLODChain> result(numChains);
+        for (auto& chain : result) {
+            std::uint32_t numLevels;
+            if (!readU32(chain.m_NumSourceVertices) || !readU32(chain.m_NumSourceIndices) || !readU32(numLevels)) return false;
+            for (std::uint32_t i = 0; i < numLevels; ++i) {
+                auto& level = chain.m_Levels.emplace_back();
+                std::uint32_t numSubMeshes, numIndices;
+                if (!read(&level.m_Error, sizeof(level.m_Error)) || !readU32(numSubMeshes)) return false;
+                // 每个子网格至少有一个三角形，损坏的数量不会分配过多的内存
+                if (numSubMeshes > chain.m_NumSourceIndices / 3) return false;
+                level.m_SubMeshIndexCounts.resize(numSubMeshes);
+                if (!read(level.m_SubMeshIndexCounts.data(), numSubMeshes * sizeof(std::uint32_t)) || !readU32(numIndices)) return false;
+                auto total = std::accumulate(level.m_SubMeshIndexCounts.begin(), level.m_SubMeshIndexCounts.end(), std::uint64_t{0});
+                if (numIndices > chain.m_NumSourceIndices || total != numIndices) return false;
+                level.m_Indices.resize(numIndices);
+                if (!read(level.m_Indices.data(), numIndices * sizeof(std::uint32_t))) return false;
+                for (auto index : level.m_Indices) {
+                    if (index >= chain.m_NumSourceVertices) return false;
+                }
+            }
+        }
+        chains = std::move(result);
+        return true;
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+#ifndef __MESHSIMPLIFIER_H__
+#define __MESHSIMPLIFIER_H__
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace DSM {
+    // 需要简化的三角形网格，位置按字节步长读取，与 BVHGeometry 相同
+    // 属性为每个顶点连续的若干个浮点数，例如法线与纹理坐标，属性不同的顶点在简化时作为接缝
+    struct MeshSimplifierInput
+    {
+        const void* m_Positions{};
+        std::uint32_t m_PositionStride = sizeof(float) * 3;
+        std::uint32_t m_NumVertices{};
+        const float* m_Attributes{};
+        std::uint32_t m_AttributeStride{};
+        std::uint32_t m_NumAttributes{};
+        // 每个属性分量的权重，为空时都为 1，误差按包围盒最长边归一化之后计算
+        const float* m_AttributeWeights{};
+        // 索引已经加上顶点偏移，所有子网格共用顶点
+        const std::uint32_t* m_Indices{};
+        std::uint32_t m_NumIndices{};
+        // 每个子网格的索引数量，依次覆盖 m_Indices，为空时整个网格为一个子网格
+        std::span<const std::uint32_t> m_SubMeshIndexCounts{};
+    };
+
+    struct MeshLODLevel
+    {
+        // 按子网格依次存放，引用输入的顶点，子网格可能被完全简化掉
+        std::vector<std::uint32_t> m_Indices{};
+        std::vector<std::uint32_t> m_SubMeshIndexCounts{};
+        // 到原始表面的几何误差，与输入位置的单位相同
+        float m_Error = 0;
+    };
+
+    // 一个网格由细到粗的各级 LOD，不包含原始网格
+    struct MeshLODChain
+    {
+        // 用于检查缓存是否对应同一个网格
+        std::uint32_t m_NumSourceVertices = 0;
+        std::uint32_t m_NumSourceIndices = 0;
+        std::vector<MeshLODLevel> m_Levels{};
+    };
+
+    struct MeshLODDesc
+    {
+        // 每一级相对上一级的目标三角形比例
+        float m_Ratio = 0.5f;
+        std::uint32_t m_MaxLevels = 6;
+        std::uint32_t m_MinTriangles = 64;
+        // 相对于包围盒最长边的误差上限，包含属性的误差
+        float m_MaxError = 0.05f;
+        // 三角形数量大于上一级的该比例时认为无法继续简化
+        float m_MinReduction = 0.85f;
+    };
+
+    // 基于二次误差度量的边折叠简化，顶点只移动到已有的顶点上，因此各级 LOD 共用原始的顶点缓冲
+    // 位置与属性都相同的顶点先合并，位置相同而属性不同的顶点为 UV 接缝、法线硬边或材质边界
+    // 两侧各一个顶点的接缝只能沿接缝折叠且两侧同时折叠，开放边界与更复杂的接缝上的顶点不移动
+    // 简化是渐进的，可以多次调用 Simplify 得到越来越粗的结果，不访问设备
+    class MeshSimplifier
+    {
+    public:
+        inline static constexpr std::uint32_t sm_MaxAttributes = 8;
+
+        MeshSimplifier() = default;
+        explicit MeshSimplifier(const MeshSimplifierInput& input) { Initialize(input); }
+
+        void Initialize(const MeshSimplifierInput& input);
+
+        // 继续简化到不多于 targetTriangles 个三角形，下一次折叠的误差超过 maxError 时提前停止
+        // maxError 相对于包围盒的最长边，返回当前的三角形数量
+        std::uint32_t Simplify(std::uint32_t targetTriangles, float maxError);
+
+        std::uint32_t GetNumTriangles() const noexcept { return static_cast<std::uint32_t>(m_TriangleSubMeshes.size()); }
+        // 到目前为止的几何误差，与输入位置的单位相同
+        float GetError() const noexcept;
+        void GetLevel(MeshLODLevel& level) const;
+
+    private:
+        // 按 Garland-Heckbert 的形式保存 pᵀAp + 2bᵀp + c，m_Weight 为累计的面积
+        struct Quadric
+        {
+            double m_A00, m_A11, m_A22, m_A01, m_A02, m_A12;
+            double m_B0, m_B1, m_B2;
+            double m_C;
+            double m_Weight;
+        };
+
+        enum VertexKind : std::uint8_t
+        {
+            kManifold,
+            kSeam,
+            kLocked,
+        };
+
+        struct Collapse
+        {
+            float m_Cost;
+            std::uint32_t m_From;
+            std::uint32_t m_To;
+        };
+
+        static void AddQuadric(Quadric& dest, const Quadric& src) noexcept;
+        static double EvaluateQuadric(const Quadric& q, const float* p) noexcept;
+
+        void ComputeQuadrics();
+        void Classify();
+        bool HasEdge(std::uint32_t from, std::uint32_t to) const noexcept;
+        bool CanCollapse(std::uint32_t from, std::uint32_t to) const noexcept;
+        void BuildVertexTriangles();
+        // 接缝折叠时另一侧对应的两个顶点
+        void GetSeamPair(std::uint32_t from, std::uint32_t to, std::uint32_t& pairFrom, std::uint32_t& pairTo) const noexcept;
+        // 返回归一化之后的平方误差，geometryError 只包含位置的部分
+        float GetCollapseCost(std::uint32_t from, std::uint32_t to, float& geometryError) const noexcept;
+        double GetAttributeError(std::uint32_t from, std::uint32_t to) const noexcept;
+        // from 移动到 to 之后周围的三角形是否翻转
+        bool IsFlipped(std::uint32_t from, std::uint32_t to) const noexcept;
+        std::uint32_t Resolve(std::uint32_t vertex) const noexcept { return m_CollapseRemap[vertex]; }
+        const float* GetPosition(std::uint32_t vertex) const noexcept { return &m_Positions[vertex * 3]; }
+        const float* GetAttributes(std::uint32_t vertex) const noexcept { return &m_Attributes[vertex * m_NumAttributes]; }
+        void RemoveDegenerateTriangles();
+
+    private:
+        std::uint32_t m_NumVertices = 0;
+        std::uint32_t m_NumAttributes = 0;
+        std::uint32_t m_NumSubMeshes = 0;
+        // 位置平移缩放到包围盒最长边为 1
+        float m_Scale = 1;
+        std::vector<float> m_Positions{};
+        // 已经乘上权重
+        std::vector<float> m_Attributes{};
+
+        // 当前的三角形，以及每个三角形所在的子网格
+        std::vector<std::uint32_t> m_Indices{};
+        std::vector<std::uint32_t> m_TriangleSubMeshes{};
+
+        // 按起点排列的有向边
+        std::vector<std::uint32_t> m_EdgeOffsets{};
+        std::vector<std::uint32_t> m_Edges{};
+        // 位置相同的顶点中的代表，以及同一位置上下一个顶点组成的环
+        std::vector<std::uint32_t> m_Remap{};
+        std::vector<std::uint32_t> m_Wedges{};
+        std::vector<VertexKind> m_Kinds{};
+        // 每个顶点唯一的开放出边的终点与开放入边的起点，接缝顶点沿这两条边折叠
+        std::vector<std::uint32_t> m_OpenOut{};
+        std::vector<std::uint32_t> m_OpenIn{};
+
+        // 位置的误差按代表顶点保存，属性的误差按顶点保存
+        std::vector<Quadric> m_PositionQuadrics{};
+        std::vector<Quadric> m_AttributeQuadrics{};
+        // 每个属性分量的面积加权梯度与偏移
+        std::vector<double> m_AttributeGradients{};
+
+        // 一遍折叠中使用的临时数据
+        std::vector<std::uint32_t> m_TriangleOffsets{};
+        std::vector<std::uint32_t> m_VertexTriangles{};
+        std::vector<std::uint32_t> m_CollapseRemap{};
+        std::vector<std::uint8_t> m_CollapseLocked{};
+        std::vector<Collapse> m_Collapses{};
+
+        float m_ErrorSquared = 0;
+    };
+
+    // 由原始网格依次生成各级 LOD
+    MeshLODChain GenerateMeshLODs(const MeshSimplifierInput& input, const MeshLODDesc& desc);
+
+    // 一个模型中所有网格的 LOD 缓存，key 用于区分生成的参数，不一致或文件损坏时读取失败
+    bool SaveMeshLODCache(const std::filesystem::path& filename, std::uint64_t key, std::span<const MeshLODChain> chains);
+    bool LoadMeshLODCache(const std::filesystem::path& filename, std::uint64_t key, std::vector<MeshLODChain>& chains);
+}
+
+#endif
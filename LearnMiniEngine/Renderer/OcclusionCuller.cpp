@@ -0,0 +1,437 @@
+#include "OcclusionCuller.h"
+#include "Utilities/ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define DSM_OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace DSM {
+    namespace {
+        // 每个线程一次取得的三角形数量
+        constexpr std::uint32_t kSetupBatchSize = 256;
+
+        std::uint32_t AlignUp(std::uint32_t value, std::uint32_t alignment) noexcept
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        void TransformPoint(const float* p, const float* m, float* clip) noexcept
+        {
+            for (int i = 0; i < 4; ++i) {
+                clip[i] = p[0] * m[i] + p[1] * m[4 + i] + p[2] * m[8 + i] + m[12 + i];
+            }
+        }
+    }
+
+    void OcclusionCuller::Create(const OcclusionCullerDesc& desc)
+    {
+        m_Width = AlignUp((std::max)(desc.m_Width, 1u), sm_TileWidth);
+        m_Height = AlignUp((std::max)(desc.m_Height, 1u), sm_TileHeight);
+        m_NumTilesX = m_Width / sm_TileWidth;
+        m_NumTilesY = m_Height / sm_TileHeight;
+        m_NumThreads = desc.m_NumThreads == 0 ? (std::max)(std::thread::hardware_concurrency(), 1u) : desc.m_NumThreads;
+
+        auto numTiles = m_NumTilesX * m_NumTilesY;
+        m_ThreadBins.assign(m_NumThreads, {});
+        for (auto& bins : m_ThreadBins) {
+            bins.m_Bins.resize(numTiles);
+        }
+        m_Depth.assign(std::size_t(m_Width) * m_Height, 1.0f);
+        m_TileMaxDepth.assign(numTiles, 1.0f);
+        m_Occluders.clear();
+        m_FirstTriangles.assign(1, 0);
+        m_HasDepth = false;
+        m_Stats = {};
+    }
+
+    void OcclusionCuller::BeginFrame()
+    {
+        // 深度在光栅化每个块时才清除
+        m_Occluders.clear();
+        m_FirstTriangles.assign(1, 0);
+        m_HasDepth = false;
+        m_Stats = {};
+    }
+
+    void OcclusionCuller::AddOccluder(const OccluderGeometry& geometry, const float* localToClip)
+    {
+        auto numTriangles = (geometry.m_Indices != nullptr ? geometry.m_NumIndices : geometry.m_NumVertices) / 3;
+        if (numTriangles == 0) return;
+
+        auto& occluder = m_Occluders.emplace_back();
+        occluder.m_Geometry = geometry;
+        memcpy(occluder.m_LocalToClip, localToClip, sizeof(occluder.m_LocalToClip));
+        m_FirstTriangles.push_back(m_FirstTriangles.back() + numTriangles);
+    }
+
+    void OcclusionCuller::Rasterize()
+    {
+        auto numTriangles = m_FirstTriangles.back();
+        m_Stats.m_NumOccluders = static_cast<std::uint32_t>(m_Occluders.size());
+        m_Stats.m_NumTriangles = numTriangles;
+        if (numTriangles == 0) return;
+
+        for (auto& bins : m_ThreadBins) {
+            bins.m_Triangles.clear();
+            for (auto& bin : bins.m_Bins) bin.clear();
+        }
+
+        // 每个线程把三角形分到自己的列表中，不需要同步
+        auto numBatches = (numTriangles + kSetupBatchSize - 1) / kSetupBatchSize;
+        auto numSetupThreads = (std::min)(m_NumThreads, numBatches);
+        std::atomic<std::uint32_t> nextBatch{0};
+        Utility::ParallelFor(numSetupThreads, numSetupThreads, [&](std::uint32_t thread, std::uint32_t) {
+            auto& bins = m_ThreadBins[thread];
+            for (auto batch = nextBatch++; batch < numBatches; batch = nextBatch++) {
+                auto begin = batch * kSetupBatchSize;
+                auto end = (std::min)(begin + kSetupBatchSize, numTriangles);
+                auto occluder = static_cast<std::uint32_t>(
+                    std::upper_bound(m_FirstTriangles.begin(), m_FirstTriangles.end(), begin) - m_FirstTriangles.begin()) - 1;
+                for (; begin < end; ++occluder) {
+                    auto occluderEnd = (std::min)(end, m_FirstTriangles[occluder + 1]);
+                    auto first = m_FirstTriangles[occluder];
+                    SetupTriangles(bins, occluder, begin - first, occluderEnd - first);
+                    begin = occluderEnd;
+                }
+            }
+        });
+
+        for (const auto& bins : m_ThreadBins) {
+            m_Stats.m_NumRasterized += static_cast<std::uint32_t>(bins.m_Triangles.size());
+        }
+        if (m_Stats.m_NumRasterized == 0) return;
+        m_HasDepth = true;
+
+        // 每个块只由一个线程写入，最小深度与三角形的顺序无关
+        auto numTiles = m_NumTilesX * m_NumTilesY;
+        auto numRasterThreads = (std::min)(m_NumThreads, numTiles);
+        std::atomic<std::uint32_t> nextTile{0};
+        Utility::ParallelFor(numRasterThreads, numRasterThreads, [&](std::uint32_t, std::uint32_t) {
+            for (auto tile = nextTile++; tile < numTiles; tile = nextTile++) {
+                RasterizeTile(tile);
+            }
+        });
+    }
+
+    void OcclusionCuller::SetupTriangles(ThreadBins& bins, std::uint32_t occluder, std::uint32_t begin, std::uint32_t end)
+    {
+        const auto& geometry = m_Occluders[occluder].m_Geometry;
+        const auto* localToClip = m_Occluders[occluder].m_LocalToClip;
+        const auto* positions = static_cast<const std::byte*>(geometry.m_Positions);
+
+        for (auto triangle = begin; triangle < end; ++triangle) {
+            float clip[3][4];
+            for (std::uint32_t i = 0; i < 3; ++i) {
+                auto index = geometry.m_Indices != nullptr ? geometry.m_Indices[triangle * 3 + i] : triangle * 3 + i;
+                float position[3];
+                memcpy(position, positions + std::size_t(index + geometry.m_BaseVertex) * geometry.m_PositionStride, sizeof(position));
+                TransformPoint(position, localToClip, clip[i]);
+            }
+
+            // 三个顶点都在同一个裁剪面之外
+            auto outside = [&clip](auto&& pred) { return pred(clip[0]) && pred(clip[1]) && pred(clip[2]); };
+            if (outside([](const float* v) { return v[0] > v[3]; }) ||
+                outside([](const float* v) { return v[0] < -v[3]; }) ||
+                outside([](const float* v) { return v[1] > v[3]; }) ||
+                outside([](const float* v) { return v[1] < -v[3]; }) ||
+                outside([](const float* v) { return v[2] > v[3]; }) ||
+                outside([](const float* v) { return v[2] < 0; })) {
+                continue;
+            }
+
+            if (clip[0][2] >= 0 && clip[1][2] >= 0 && clip[2][2] >= 0) {
+                AddTriangle(bins, clip[0], clip[1], clip[2], geometry.m_BothSides);
+                continue;
+            }
+
+            // 按近平面 z = 0 裁剪，最多得到四个顶点
+            float polygon[4][4];
+            std::uint32_t numVertices = 0;
+            for (std::uint32_t i = 0; i < 3; ++i) {
+                const auto* a = clip[i];
+                const auto* b = clip[(i + 1) % 3];
+                if (a[2] >= 0) {
+                    memcpy(polygon[numVertices++], a, sizeof(float) * 4);
+                }
+                if ((a[2] >= 0) != (b[2] >= 0)) {
+                    float t = a[2] / (a[2] - b[2]);
+                    auto* v = polygon[numVertices++];
+                    for (int c = 0; c < 4; ++c) v[c] = a[c] + t * (b[c] - a[c]);
+                    v[2] = 0;
+                }
+            }
+            for (std::uint32_t i = 1; i + 1 < numVertices; ++i) {
+                AddTriangle(bins, polygon[0], polygon[i], polygon[i + 1], geometry.m_BothSides);
+            }
+        }
+    }
+
+    void OcclusionCuller::AddTriangle(ThreadBins& bins, const float* v0, const float* v1, const float* v2, bool bothSides)
+    {
+        float x[3], y[3], z[3];
+        const float* vertices[3] = {v0, v1, v2};
+        for (int i = 0; i < 3; ++i) {
+            const auto* v = vertices[i];
+            if (!(v[3] > 0)) return;
+            float invW = 1 / v[3];
+            x[i] = (v[0] * invW * 0.5f + 0.5f) * m_Width;
+            y[i] = (0.5f - v[1] * invW * 0.5f) * m_Height;
+            z[i] = v[2] * invW;
+        }
+
+        // y 轴向下时顺时针的三角形面积为正，与 D3D 默认的正面相同
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (!(area > 0)) {
+            if (!(area < 0) || !bothSides) return;
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(z[1], z[2]);
+            area = -area;
+        }
+
+        // 只写入被三角形完全覆盖的像素，边缘上部分覆盖的像素保持原来的深度，相邻三角形之间可能留下缝隙
+        float minX = (std::max)(std::ceil((std::min)({x[0], x[1], x[2]}) - 0.5f), 0.0f);
+        float minY = (std::max)(std::ceil((std::min)({y[0], y[1], y[2]}) - 0.5f), 0.0f);
+        float maxX = (std::min)(std::floor((std::max)({x[0], x[1], x[2]}) - 0.5f), m_Width - 1.0f);
+        float maxY = (std::min)(std::floor((std::max)({y[0], y[1], y[2]}) - 0.5f), m_Height - 1.0f);
+        if (!(minX <= maxX) || !(minY <= maxY)) return;
+
+        Triangle triangle{};
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3;
+            float a = y[i] - y[j];
+            float b = x[j] - x[i];
+            triangle.m_EdgeA[i] = a;
+            triangle.m_EdgeB[i] = b;
+            // 在像素中心求值后再减去像素范围内的最大变化，只有整个像素都在三角形内时才不小于 0
+            triangle.m_EdgeC[i] = -(a * x[i] + b * y[i]) + 0.5f * (a + b) - 0.5f * (std::abs(a) + std::abs(b));
+        }
+
+        // 边函数为 0 处的 x 随行线性变化，a > 0 的边给出每行的左端，a < 0 的边给出右端
+        std::uint32_t numLeft = 0, numRight = 0;
+        for (int i = 0; i < 2; ++i) {
+            triangle.m_LeftSlope[i] = triangle.m_RightSlope[i] = 0;
+            triangle.m_LeftOffset[i] = -std::numeric_limits<float>::infinity();
+            triangle.m_RightOffset[i] = std::numeric_limits<float>::infinity();
+        }
+        for (int i = 0; i < 3; ++i) {
+            float a = triangle.m_EdgeA[i];
+            if (a > 0) {
+                triangle.m_LeftSlope[numLeft] = -triangle.m_EdgeB[i] / a;
+                triangle.m_LeftOffset[numLeft++] = -triangle.m_EdgeC[i] / a;
+            }
+            else if (a < 0) {
+                triangle.m_RightSlope[numRight] = -triangle.m_EdgeB[i] / a;
+                triangle.m_RightOffset[numRight++] = -triangle.m_EdgeC[i] / a;
+            }
+        }
+
+        // 深度在屏幕空间线性变化，取像素范围内最远的深度，使遮挡的判断偏保守
+        float invArea = 1 / area;
+        float dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * invArea;
+        float dzdy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) * invArea;
+        triangle.m_DepthA = dzdx;
+        triangle.m_DepthB = dzdy;
+        triangle.m_DepthC = z[0] - dzdx * x[0] - dzdy * y[0] + 0.5f * (dzdx + dzdy) + 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+
+        triangle.m_MinX = static_cast<std::int32_t>(minX);
+        triangle.m_MinY = static_cast<std::int32_t>(minY);
+        triangle.m_MaxX = static_cast<std::int32_t>(maxX);
+        triangle.m_MaxY = static_cast<std::int32_t>(maxY);
+
+        auto index = static_cast<std::uint32_t>(bins.m_Triangles.size());
+        bins.m_Triangles.push_back(triangle);
+        for (auto ty = triangle.m_MinY / sm_TileHeight; ty <= triangle.m_MaxY / sm_TileHeight; ++ty) {
+            for (auto tx = triangle.m_MinX / sm_TileWidth; tx <= triangle.m_MaxX / sm_TileWidth; ++tx) {
+                bins.m_Bins[ty * m_NumTilesX + tx].push_back(index);
+            }
+        }
+    }
+
+    bool OcclusionCuller::GetSpan(const Triangle& triangle, float y, std::int32_t minX, std::int32_t maxX,
+        std::int32_t& spanMinX, std::int32_t& spanMaxX) noexcept
+    {
+        // 多留一个像素避免舍入误差，范围内仍由边函数判断
+        float left = (std::max)({static_cast<float>(minX),
+            triangle.m_LeftSlope[0] * y + triangle.m_LeftOffset[0] - 1,
+            triangle.m_LeftSlope[1] * y + triangle.m_LeftOffset[1] - 1});
+        float right = (std::min)({static_cast<float>(maxX),
+            triangle.m_RightSlope[0] * y + triangle.m_RightOffset[0] + 1,
+            triangle.m_RightSlope[1] * y + triangle.m_RightOffset[1] + 1});
+        if (!(left <= right)) return false;
+        spanMinX = static_cast<std::int32_t>(left);
+        spanMaxX = static_cast<std::int32_t>(right);
+        return true;
+    }
+
+    void OcclusionCuller::RasterizeTile(std::uint32_t tile)
+    {
+        std::int32_t tileX = tile % m_NumTilesX * sm_TileWidth;
+        std::int32_t tileY = tile / m_NumTilesX * sm_TileHeight;
+        float* depth = m_Depth.data() + std::size_t(tile) * sm_TileWidth * sm_TileHeight;
+        std::fill_n(depth, sm_TileWidth * sm_TileHeight, 1.0f);
+
+        for (const auto& bins : m_ThreadBins) {
+            for (auto index : bins.m_Bins[tile]) {
+                const auto& triangle = bins.m_Triangles[index];
+                auto minX = (std::max)(triangle.m_MinX, tileX);
+                auto maxX = (std::min)(triangle.m_MaxX, tileX + std::int32_t(sm_TileWidth) - 1);
+                auto minY = (std::max)(triangle.m_MinY, tileY);
+                auto maxY = (std::min)(triangle.m_MaxY, tileY + std::int32_t(sm_TileHeight) - 1);
+#ifdef DSM_OCCLUSION_SSE
+                const __m128 offsets = _mm_setr_ps(0, 1, 2, 3);
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 a0 = _mm_set1_ps(triangle.m_EdgeA[0]);
+                const __m128 a1 = _mm_set1_ps(triangle.m_EdgeA[1]);
+                const __m128 a2 = _mm_set1_ps(triangle.m_EdgeA[2]);
+                const __m128 da = _mm_set1_ps(triangle.m_DepthA);
+                for (auto py = minY; py <= maxY; ++py) {
+                    float fy = static_cast<float>(py);
+                    std::int32_t spanMinX, spanMaxX;
+                    if (!GetSpan(triangle, fy, minX, maxX, spanMinX, spanMaxX)) continue;
+
+                    __m128 e0Row = _mm_set1_ps(triangle.m_EdgeB[0] * fy + triangle.m_EdgeC[0]);
+                    __m128 e1Row = _mm_set1_ps(triangle.m_EdgeB[1] * fy + triangle.m_EdgeC[1]);
+                    __m128 e2Row = _mm_set1_ps(triangle.m_EdgeB[2] * fy + triangle.m_EdgeC[2]);
+                    __m128 zRow = _mm_set1_ps(triangle.m_DepthB * fy + triangle.m_DepthC);
+                    float* row = depth + (py - tileY) * sm_TileWidth - tileX;
+                    for (auto px = spanMinX & ~3; px <= spanMaxX; px += 4) {
+                        __m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), offsets);
+                        __m128 inside = _mm_and_ps(
+                            _mm_and_ps(
+                                _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, fx), e0Row), zero),
+                                _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, fx), e1Row), zero)),
+                            _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, fx), e2Row), zero));
+                        if (_mm_movemask_ps(inside) == 0) continue;
+
+                        __m128 z = _mm_add_ps(_mm_mul_ps(da, fx), zRow);
+                        __m128 d = _mm_loadu_ps(row + px);
+                        d = _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(d, z)), _mm_andnot_ps(inside, d));
+                        _mm_storeu_ps(row + px, d);
+                    }
+                }
+#else
+                for (auto py = minY; py <= maxY; ++py) {
+                    float fy = static_cast<float>(py);
+                    std::int32_t spanMinX, spanMaxX;
+                    if (!GetSpan(triangle, fy, minX, maxX, spanMinX, spanMaxX)) continue;
+
+                    float* row = depth + (py - tileY) * sm_TileWidth - tileX;
+                    for (auto px = spanMinX; px <= spanMaxX; ++px) {
+                        float fx = static_cast<float>(px);
+                        bool inside = true;
+                        for (int i = 0; i < 3; ++i) {
+                            inside &= triangle.m_EdgeA[i] * fx + triangle.m_EdgeB[i] * fy + triangle.m_EdgeC[i] >= 0;
+                        }
+                        if (!inside) continue;
+                        float z = triangle.m_DepthA * fx + triangle.m_DepthB * fy + triangle.m_DepthC;
+                        row[px] = (std::min)(row[px], z);
+                    }
+                }
+#endif
+            }
+        }
+
+#ifdef DSM_OCCLUSION_SSE
+        __m128 maxDepth = _mm_loadu_ps(depth);
+        for (std::uint32_t i = 4; i < sm_TileWidth * sm_TileHeight; i += 4) {
+            maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(depth + i));
+        }
+        maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+        maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+        m_TileMaxDepth[tile] = _mm_cvtss_f32(maxDepth);
+#else
+        m_TileMaxDepth[tile] = *std::max_element(depth, depth + sm_TileWidth * sm_TileHeight);
+#endif
+    }
+
+    bool OcclusionCuller::IsVisible(const float* boxMin, const float* boxMax, const float* localToClip)
+    {
+        ++m_Stats.m_NumTests;
+        if (!m_HasDepth) return true;
+
+        // 透视投影下包围盒投影的范围由八个角点决定，最近的深度也在角点上
+        float minX = std::numeric_limits<float>::infinity(), maxX = -minX;
+        float minY = minX, maxY = -minX;
+        float minZ = minX;
+        for (std::uint32_t i = 0; i < 8; ++i) {
+            float corner[3] = {
+                (i & 1) ? boxMax[0] : boxMin[0],
+                (i & 2) ? boxMax[1] : boxMin[1],
+                (i & 4) ? boxMax[2] : boxMin[2]};
+            float clip[4];
+            TransformPoint(corner, localToClip, clip);
+            if (!(clip[3] > 0) || clip[2] < 0) return true;
+
+            float invW = 1 / clip[3];
+            float x = (clip[0] * invW * 0.5f + 0.5f) * m_Width;
+            float y = (0.5f - clip[1] * invW * 0.5f) * m_Height;
+            minX = (std::min)(minX, x);
+            maxX = (std::max)(maxX, x);
+            minY = (std::min)(minY, y);
+            maxY = (std::max)(maxY, y);
+            minZ = (std::min)(minZ, clip[2] * invW);
+        }
+
+        // 包含包围盒覆盖到的所有像素
+        minX = (std::max)(std::floor(minX), 0.0f);
+        minY = (std::max)(std::floor(minY), 0.0f);
+        maxX = (std::min)(std::floor(maxX), m_Width - 1.0f);
+        maxY = (std::min)(std::floor(maxY), m_Height - 1.0f);
+        if (!(minX <= maxX) || !(minY <= maxY)) {
+            ++m_Stats.m_NumOccluded;
+            return false;
+        }
+
+        auto x0 = static_cast<std::int32_t>(minX), x1 = static_cast<std::int32_t>(maxX);
+        auto y0 = static_cast<std::int32_t>(minY), y1 = static_cast<std::int32_t>(maxY);
+        for (auto ty = y0 / std::int32_t(sm_TileHeight); ty <= y1 / std::int32_t(sm_TileHeight); ++ty) {
+            for (auto tx = x0 / std::int32_t(sm_TileWidth); tx <= x1 / std::int32_t(sm_TileWidth); ++tx) {
+                auto tile = ty * m_NumTilesX + tx;
+                if (minZ > m_TileMaxDepth[tile]) continue;
+
+                std::int32_t tileX = tx * sm_TileWidth;
+                std::int32_t tileY = ty * sm_TileHeight;
+                auto startX = (std::max)(x0, tileX);
+                auto endX = (std::min)(x1, tileX + std::int32_t(sm_TileWidth) - 1);
+                auto startY = (std::max)(y0, tileY);
+                auto endY = (std::min)(y1, tileY + std::int32_t(sm_TileHeight) - 1);
+                const float* depth = m_Depth.data() + std::size_t(tile) * sm_TileWidth * sm_TileHeight;
+
+                for (auto py = startY; py <= endY; ++py) {
+                    const float* row = depth + (py - tileY) * sm_TileWidth - tileX;
+#ifdef DSM_OCCLUSION_SSE
+                    const __m128 z = _mm_set1_ps(minZ);
+                    for (auto px = startX & ~3; px <= endX; px += 4) {
+                        // 只比较范围内的通道
+                        std::uint32_t lanes = 0xf;
+                        if (px < startX) lanes &= 0xfu << (startX - px);
+                        if (px + 3 > endX) lanes &= 0xfu >> (px + 3 - endX);
+                        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + px), z)) & lanes) return true;
+                    }
+#else
+                    for (auto px = startX; px <= endX; ++px) {
+                        if (row[px] >= minZ) return true;
+                    }
+#endif
+                }
+            }
+        }
+
+        ++m_Stats.m_NumOccluded;
+        return false;
+    }
+
+    float OcclusionCuller::GetDepth(std::uint32_t x, std::uint32_t y) const noexcept
+    {
+        auto tile = y / sm_TileHeight * m_NumTilesX + x / sm_TileWidth;
+        return m_Depth[std::size_t(tile) * sm_TileWidth * sm_TileHeight + y % sm_TileHeight * sm_TileWidth + x % sm_TileWidth];
+    }
+}
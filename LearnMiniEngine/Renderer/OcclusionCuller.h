@@ -0,0 +1,131 @@
+#pragma once
+#ifndef __OCCLUSIONCULLER_H__
+#define __OCCLUSIONCULLER_H__
+
+#include <cstdint>
+#include <vector>
+
+namespace DSM {
+    // 遮挡体的三角形，位置按字节步长读取，与 BVHGeometry 相同
+    struct OccluderGeometry
+    {
+        const void* m_Positions{};
+        std::uint32_t m_PositionStride = sizeof(float) * 3;
+        std::uint32_t m_NumVertices{};
+        const std::uint32_t* m_Indices{};
+        std::uint32_t m_NumIndices{};
+        std::uint32_t m_BaseVertex{};
+        // 为 false 时剔除背面，需与绘制时的剔除模式相同，否则从背面看去会遮挡身后的物体
+        bool m_BothSides = false;
+    };
+
+    struct OcclusionCullerDesc
+    {
+        // 宽高会向上对齐到块的大小
+        std::uint32_t m_Width = 256;
+        std::uint32_t m_Height = 192;
+        // 0 表示使用所有硬件线程，每帧会创建线程，过多反而更慢
+        std::uint32_t m_NumThreads = 4;
+    };
+
+    struct OcclusionCullerStats
+    {
+        std::uint32_t m_NumOccluders = 0;
+        std::uint32_t m_NumTriangles = 0;
+        // 裁剪与背面剔除之后分到块中的三角形
+        std::uint32_t m_NumRasterized = 0;
+        std::uint32_t m_NumTests = 0;
+        std::uint32_t m_NumOccluded = 0;
+    };
+
+    // CPU 上的低分辨率软件光栅化遮挡剔除，不访问设备
+    // 每帧先添加遮挡体并光栅化到分块的深度缓冲，之后用包围盒与深度缓冲比较
+    // 遮挡体只写入完全覆盖的像素并取像素内最远的深度，判断为被遮挡的包围盒一定不可见
+    // 矩阵为 16 个浮点数，行向量约定，与 XMFLOAT4X4 的布局相同，深度与 D3D 相同为近 0 远 1
+    class OcclusionCuller
+    {
+    public:
+        inline static constexpr std::uint32_t sm_TileWidth = 64;
+        inline static constexpr std::uint32_t sm_TileHeight = 16;
+
+        OcclusionCuller() { Create({}); }
+        explicit OcclusionCuller(const OcclusionCullerDesc& desc) { Create(desc); }
+
+        void Create(const OcclusionCullerDesc& desc);
+
+        // 清除上一帧的遮挡体与深度
+        void BeginFrame();
+        // 几何数据在 Rasterize 之前需保持有效，localToClip 会被复制
+        void AddOccluder(const OccluderGeometry& geometry, const float* localToClip);
+        // 多线程变换并分块，之后按块并行光栅化，保存每个像素最近的遮挡体深度
+        void Rasterize();
+
+        // 包围盒与近平面相交时总是可见，返回 false 表示一定被遮挡或在屏幕之外
+        bool IsVisible(const float* boxMin, const float* boxMax, const float* localToClip);
+
+        std::uint32_t GetWidth() const noexcept { return m_Width; }
+        std::uint32_t GetHeight() const noexcept { return m_Height; }
+        // 按行读取深度，只用于调试显示，本帧没有遮挡体时内容无效
+        bool HasDepth() const noexcept { return m_HasDepth; }
+        float GetDepth(std::uint32_t x, std::uint32_t y) const noexcept;
+
+        const OcclusionCullerStats& GetStats() const noexcept { return m_Stats; }
+
+    private:
+        // 屏幕空间的三角形，边函数与深度在像素的整数坐标上求值，即已经偏移到像素中心
+        struct Triangle
+        {
+            float m_EdgeA[3];
+            float m_EdgeB[3];
+            float m_EdgeC[3];
+            float m_DepthA, m_DepthB, m_DepthC;
+            // 每行覆盖范围的左右端 x = slope * y + offset，顺时针的三角形每侧最多两条边
+            float m_LeftSlope[2], m_LeftOffset[2];
+            float m_RightSlope[2], m_RightOffset[2];
+            std::int32_t m_MinX, m_MinY, m_MaxX, m_MaxY;
+        };
+
+        struct Occluder
+        {
+            OccluderGeometry m_Geometry;
+            float m_LocalToClip[16];
+        };
+
+        // 每个线程的三角形与分块列表，光栅化时按线程顺序读取
+        struct ThreadBins
+        {
+            std::vector<Triangle> m_Triangles{};
+            std::vector<std::vector<std::uint32_t>> m_Bins{};
+        };
+
+        void SetupTriangles(ThreadBins& bins, std::uint32_t occluder, std::uint32_t begin, std::uint32_t end);
+        void AddTriangle(ThreadBins& bins, const float* v0, const float* v1, const float* v2, bool bothSides);
+        // 三角形在一行中可能覆盖的像素范围，没有时返回 false
+        static bool GetSpan(const Triangle& triangle, float y, std::int32_t minX, std::int32_t maxX,
+            std::int32_t& spanMinX, std::int32_t& spanMaxX) noexcept;
+        void RasterizeTile(std::uint32_t tile);
+
+    private:
+        std::uint32_t m_Width = 0;
+        std::uint32_t m_Height = 0;
+        std::uint32_t m_NumTilesX = 0;
+        std::uint32_t m_NumTilesY = 0;
+        std::uint32_t m_NumThreads = 0;
+
+        std::vector<Occluder> m_Occluders{};
+        // 每个遮挡体第一个三角形的序号，最后一项为三角形总数
+        std::vector<std::uint32_t> m_FirstTriangles{};
+        std::vector<ThreadBins> m_ThreadBins{};
+
+        // 每个块的像素连续存放
+        std::vector<float> m_Depth{};
+        // 每个块中最远的深度，包围盒比它更远时整个块都被遮挡
+        std::vector<float> m_TileMaxDepth{};
+        // 本帧没有光栅化任何三角形时深度缓冲中是之前的内容
+        bool m_HasDepth = false;
+
+        OcclusionCullerStats m_Stats{};
+    };
+}
+
+#endif
@@ -3,15 +3,22 @@
 #include "Graphics/GraphicsCommon.h"
 #include "Utilities/FormatUtil.h"
 #include "Graphics/RenderContext.h"
+#include "Graphics/CommandList/CommandList.h"
+#include "Core/Profiler.h"
 
 
 namespace DSM {
 	
-	void TextureManager::ManagedTexture::Create(const std::string& filename, bool forceSRGB)
+	void TextureManager::ManagedTexture::Create(const std::string& filename, bool forceSRGB, TextureUsage usage)
 	{
-		m_IsValid = CreateTextureFromFile(*this, filename, filename, forceSRGB);
+		m_Name = GetTextureKey(filename, forceSRGB, usage);
 
-		m_Name = filename + (forceSRGB ? "_SRGB" : "");
+		if (g_TexManager.IsStreamingEnabled()) {
+			m_IsValid = CreateStreaming(filename, forceSRGB, usage);
+		}
+		if (!m_IsValid) {
+			m_IsValid = CreateTextureFromFile(*this, filename, filename, forceSRGB, usage);
+		}
 
 		if (m_IsValid) {
 			m_Descriptor = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
@@ -53,23 +60,122 @@ namespace DSM {
 
 	void TextureManager::ManagedTexture::Destroy()
 	{
+		if (m_ResidencyHandle != TextureResidency::sm_InvalidHandle) {
+			g_TexManager.UnregisterStreamingTexture(m_ResidencyHandle);
+			m_ResidencyHandle = TextureResidency::sm_InvalidHandle;
+		}
+		m_StreamingFile = nullptr;
+
 		if (m_Resource != nullptr) {
 			g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_Descriptor);
 		}
 		Texture::Destroy();
 	}
 
+	void TextureManager::ManagedTexture::RequestScreenSize(float screenPixels, float priority)
+	{
+		if (!IsStreaming()) return;
+
+		const auto& info = m_StreamingFile->GetInfo();
+		auto mip = TextureResidency::ComputeMipFromFootprint(info.m_Width, info.m_Height, screenPixels);
+		g_TexManager.RequestStreamingMip(m_ResidencyHandle, mip, priority);
+	}
+
+	void TextureManager::ManagedTexture::SetResidentMip(std::uint32_t mip)
+	{
+		if (!IsStreaming() || mip == m_ResidentMip) return;
+
+		const auto& info = m_StreamingFile->GetInfo();
+		auto textureDesc = m_Desc;
+		textureDesc.m_Width = (std::max)(info.m_Width >> mip, 1u);
+		textureDesc.m_Height = (std::max)(info.m_Height >> mip, 1u);
+		textureDesc.m_MipLevels = static_cast<std::uint16_t>(info.m_MipLevels - mip);
+
+		// 新建只包含所需 mip 的资源，已有的 mip 直接在 GPU 上拷贝
+		Texture newTexture{};
+		newTexture.Create(Utility::UTF8ToWString(m_Name), textureDesc);
+		CommandList::StreamTextureMips(newTexture, mip, this, m_ResidentMip, *m_StreamingFile);
+
+		// 当前帧及之前的帧可能仍在使用旧资源
+		auto oldResource = std::make_shared<GpuResource>(std::move(static_cast<GpuResource&>(*this)));
+		static_cast<GpuResource&>(*this) = std::move(static_cast<GpuResource&>(newTexture));
+		g_RenderContext.GetFrameScheduler().DeferRelease([oldResource]() { oldResource->Destroy(); });
+
+		m_Desc = textureDesc;
+		m_ResidentMip = mip;
+		CreateShaderResourceView(m_Descriptor);
+	}
+
+	bool TextureManager::ManagedTexture::CreateStreaming(const std::string& filename, bool forceSRGB, TextureUsage usage)
+	{
+		PROFILE_SCOPE("ManagedTexture::CreateStreaming");
+
+		// 非 DDS 图片从压缩缓存中读取，缓存不存在时先完整导入一次以生成缓存
+		std::string ddsFilename = filename;
+		if (filename.size() < 4 || _stricmp(filename.c_str() + filename.size() - 4, ".dds") != 0) {
+			ddsFilename = FindTextureCache(filename, forceSRGB, usage);
+			if (ddsFilename.empty() && usage != TextureUsage::kDefault && !sm_TextureCacheDirectory.empty()) {
+				Texture importTexture{};
+				if (!CreateTextureFromFile(importTexture, filename, filename, forceSRGB, usage)) return false;
+				ddsFilename = FindTextureCache(filename, forceSRGB, usage);
+			}
+			if (ddsFilename.empty()) return false;
+			// 缓存中已经是最终的格式
+			forceSRGB = false;
+		}
+
+		auto ddsFile = std::make_unique<DDSFile>();
+		if (!ddsFile->Open(ddsFilename, forceSRGB)) return false;
+		const auto& info = ddsFile->GetInfo();
+		if (info.m_Dimension != DDSDimension::kTexture2D || info.m_IsCubeMap || info.m_ArraySize != 1 || info.m_MipLevels < 2) {
+			return false;
+		}
+
+		// 小 mip 始终驻留，块压缩格式资源最精细的一级的宽高需为 4 的倍数
+		std::uint32_t pinnedMip = 0;
+		while (pinnedMip + 1 < info.m_MipLevels &&
+			(std::max)(info.m_Width >> pinnedMip, info.m_Height >> pinnedMip) > sm_MinStreamingSize) {
+			++pinnedMip;
+		}
+		if (DDSFile::IsBlockCompressed(info.m_Format)) {
+			while (pinnedMip > 0 && ((info.m_Width >> pinnedMip) % 4 != 0 || (info.m_Height >> pinnedMip) % 4 != 0)) {
+				--pinnedMip;
+			}
+		}
+		if (pinnedMip == 0) return false;
+
+		std::vector<std::uint64_t> mipSizes(info.m_MipLevels);
+		for (std::uint32_t i = 0; i < info.m_MipLevels; ++i) {
+			const auto& layout = ddsFile->GetSubresourceLayout(i);
+			mipSizes[i] = layout.m_SliceSize * layout.m_Depth;
+		}
+
+		TextureDesc textureDesc{};
+		textureDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		textureDesc.m_Width = info.m_Width >> pinnedMip;
+		textureDesc.m_Height = info.m_Height >> pinnedMip;
+		textureDesc.m_MipLevels = static_cast<std::uint16_t>(info.m_MipLevels - pinnedMip);
+		textureDesc.m_Format = static_cast<DXGI_FORMAT>(info.m_Format);
+		Texture::Create(Utility::UTF8ToWString(filename), textureDesc);
+		CommandList::StreamTextureMips(*this, pinnedMip, nullptr, 0, *ddsFile);
+
+		m_StreamingFile = std::move(ddsFile);
+		m_ResidentMip = pinnedMip;
+		m_ResidencyHandle = g_TexManager.RegisterStreamingTexture(this, mipSizes, pinnedMip, pinnedMip);
+		return true;
+	}
+
 	void TextureManager::ManagedTexture::Unload()
 	{
 		g_TexManager.DestroyTexture(m_Name);
 	}
 
 
-	TextureRef TextureManager::LoadTextureFromFile(const std::string& fileName, bool forceSRGB)
+	TextureRef TextureManager::LoadTextureFromFile(const std::string& fileName, bool forceSRGB, TextureUsage usage)
 	{
 		std::shared_ptr<ManagedTexture> tex = nullptr;
 
-		std::string key = forceSRGB ? (fileName + "_SRGB") : fileName;
+		std::string key = GetTextureKey(fileName, forceSRGB, usage);
 
 		{
 			std::lock_guard lock{m_Mutex}; 
@@ -86,7 +192,7 @@ namespace DSM {
 			}
 		}
 
-		tex->Create(fileName, forceSRGB);
+		tex->Create(fileName, forceSRGB, usage);
 		return TextureRef{ tex };
 	}
 	
@@ -123,6 +229,105 @@ namespace DSM {
 		}
 	}
 
+	std::string TextureManager::GetTextureKey(const std::string& fileName, bool forceSRGB, TextureUsage usage)
+	{
+		std::string key = forceSRGB ? (fileName + "_SRGB") : fileName;
+		switch (usage) {
+			case TextureUsage::kColor: key += "_Color"; break;
+			case TextureUsage::kNormalMap: key += "_Normal"; break;
+			case TextureUsage::kGrayscale: key += "_Gray"; break;
+			default: break;
+		}
+		return key;
+	}
+
+	void TextureManager::EnableStreaming(const TextureResidencyDesc& desc)
+	{
+		std::lock_guard lock{m_StreamingMutex};
+		m_StreamingDesc = desc;
+		m_Residency.SetDesc(desc);
+		if (!m_StreamingEnabled) {
+			m_MemoryPressureCallback = g_MemoryTracker.AddPressureCallback([this](const MemoryBudgetStatus& status) {
+				OnMemoryPressure(status);
+			});
+		}
+		m_StreamingEnabled = true;
+	}
+
+	void TextureManager::DisableStreaming()
+	{
+		std::lock_guard lock{m_StreamingMutex};
+		if (m_StreamingEnabled) {
+			g_MemoryTracker.RemovePressureCallback(m_MemoryPressureCallback);
+		}
+		// 已经流式加载的纹理保持当前的状态
+		m_StreamingEnabled = false;
+	}
+
+	void TextureManager::OnMemoryPressure(const MemoryBudgetStatus& status)
+	{
+		if (status.m_Category != MemoryCategory::kNumCategories && status.m_Category != MemoryCategory::kTexture) return;
+
+		std::lock_guard lock{m_StreamingMutex};
+		auto desc = m_StreamingDesc;
+		if (status.m_Pressure != MemoryPressure::kNone) {
+			auto residentBytes = m_Residency.GetStats().m_ResidentBytes;
+			auto budget = residentBytes > status.m_ExcessBytes ? residentBytes - status.m_ExcessBytes : 0;
+			desc.m_Budget = (std::min)(desc.m_Budget, (std::min)(budget, m_Residency.GetDesc().m_Budget));
+		}
+		m_Residency.SetDesc(desc);
+	}
+
+	void TextureManager::UpdateStreaming()
+	{
+		if (!m_StreamingEnabled) return;
+		PROFILE_SCOPE("TextureManager::UpdateStreaming");
+
+		std::lock_guard lock{m_StreamingMutex};
+		const auto& requests = m_Residency.Update(g_RenderContext.GetFrameScheduler().GetFrameCount());
+		for (const auto& request : requests) {
+			m_StreamingTextures[request.m_Texture]->SetResidentMip(request.m_Mip);
+			// 拷贝与之后的帧在同一队列上按顺序执行，提交后即可视为完成
+			if (request.m_Action == ResidencyAction::kLoad) {
+				m_Residency.CompleteLoad(request.m_Texture, request.m_Mip);
+			}
+		}
+	}
+
+	TextureResidencyStats TextureManager::GetStreamingStats()
+	{
+		std::lock_guard lock{m_StreamingMutex};
+		return m_Residency.GetStats();
+	}
+
+	std::uint32_t TextureManager::RegisterStreamingTexture(
+		ManagedTexture* texture,
+		std::span<const std::uint64_t> mipSizes,
+		std::uint32_t pinnedMip,
+		std::uint32_t residentMip)
+	{
+		std::lock_guard lock{m_StreamingMutex};
+		auto handle = m_Residency.RegisterTexture(mipSizes, pinnedMip, residentMip);
+		if (handle >= m_StreamingTextures.size()) {
+			m_StreamingTextures.resize(handle + 1);
+		}
+		m_StreamingTextures[handle] = texture;
+		return handle;
+	}
+
+	void TextureManager::UnregisterStreamingTexture(std::uint32_t handle)
+	{
+		std::lock_guard lock{m_StreamingMutex};
+		m_Residency.UnregisterTexture(handle);
+		m_StreamingTextures[handle] = nullptr;
+	}
+
+	void TextureManager::RequestStreamingMip(std::uint32_t handle, float mip, float priority)
+	{
+		std::lock_guard lock{m_StreamingMutex};
+		m_Residency.RequestMip(handle, mip, priority);
+	}
+
 	size_t TextureManager::GetTextureCount() const noexcept
 	{
 		return m_Textures.size();
@@ -139,6 +344,13 @@ namespace DSM {
 		}
 	}
 
+	void TextureRef::RequestScreenSize(float screenPixels, float priority) const
+	{
+		if (m_Texture != nullptr) {
+			m_Texture->RequestScreenSize(screenPixels, priority);
+		}
+	}
+
 	D3D12_CPU_DESCRIPTOR_HANDLE TextureRef::GetSRV() const noexcept
 	{
 		return (m_Texture != nullptr) ? m_Texture->GetSRV() : Graphics::GetDefaultTexture(Graphics::kMagenta2D);
@@ -5,6 +5,8 @@
 #include "Utilities/Singleton.h"
 #include "Graphics/Resource/Texture.h"
 #include "Graphics/DescriptorHeap.h"
+#include "Utilities/DDSFile.h"
+#include "TextureResidency.h"
 
 namespace DSM {
 
@@ -19,7 +21,7 @@ namespace DSM {
 			ManagedTexture() : m_IsLoaded(true) {};
 			virtual ~ManagedTexture() { Destroy(); };
 
-			void Create(const std::string& filename, bool forceSRGB);
+			void Create(const std::string& filename, bool forceSRGB, TextureUsage usage);
 			void Create(const std::string& name, const TextureDesc& texDesc, const void* data);
 			
 			void WaitForLoad() const noexcept;
@@ -28,24 +30,67 @@ namespace DSM {
 			void Unload();
 
 			bool IsValid() const noexcept { return m_IsValid; };
+			bool IsStreaming() const noexcept { return m_ResidencyHandle != TextureResidency::sm_InvalidHandle; }
 
 			D3D12_CPU_DESCRIPTOR_HANDLE GetSRV() const noexcept { return m_Descriptor; };
 
+			// 纹理在屏幕上覆盖的像素数，用于决定流式纹理需要的 mip
+			void RequestScreenSize(float screenPixels, float priority);
+			// 改变驻留的最精细的 mip，旧资源在当前帧完成后释放
+			void SetResidentMip(std::uint32_t mip);
+
+		private:
+			// 从 DDS 或压缩缓存中只加载低精度的 mip，不支持流式加载时返回 false
+			bool CreateStreaming(const std::string& filename, bool forceSRGB, TextureUsage usage);
+
 		private:
 			std::string m_Name{};
 			DescriptorHandle m_Descriptor{};
 			std::atomic<bool> m_IsLoaded{false};
 			bool m_IsValid = false;
+
+			// 流式加载时保持映射，高精度的 mip 从中读取
+			std::unique_ptr<DDSFile> m_StreamingFile{};
+			std::uint32_t m_ResidencyHandle = TextureResidency::sm_InvalidHandle;
+			std::uint32_t m_ResidentMip = 0;
 		};
 	
 	public:
-		TextureRef LoadTextureFromFile(const std::string& fileName, bool forceSRGB = false);
+		TextureRef LoadTextureFromFile(
+			const std::string& fileName,
+			bool forceSRGB = false,
+			TextureUsage usage = TextureUsage::kDefault);
 		TextureRef LoadTextureFromMemory(const std::string& name, const TextureDesc& texDesc, const void* data);
 
 		void DestroyTexture(const std::string& name);
 
 		size_t GetTextureCount() const noexcept;
 
+		// 开启后从 DDS 或压缩缓存加载的纹理先只加载低精度的 mip，之后按需要在预算内流式加载
+		void EnableStreaming(const TextureResidencyDesc& desc);
+		void DisableStreaming();
+		bool IsStreamingEnabled() const noexcept { return m_StreamingEnabled; }
+		// 每帧调用一次，需在 RenderContext 的 BeginFrame 与 EndFrame 之间
+		void UpdateStreaming();
+		TextureResidencyStats GetStreamingStats();
+
+		// 不超过该尺寸的 mip 始终驻留
+		inline static std::uint32_t sm_MinStreamingSize = 64;
+
+	protected:
+		// 同一文件以不同格式加载时需要区分
+		static std::string GetTextureKey(const std::string& fileName, bool forceSRGB, TextureUsage usage);
+
+		std::uint32_t RegisterStreamingTexture(
+			ManagedTexture* texture,
+			std::span<const std::uint64_t> mipSizes,
+			std::uint32_t pinnedMip,
+			std::uint32_t residentMip);
+		void UnregisterStreamingTexture(std::uint32_t handle);
+		void RequestStreamingMip(std::uint32_t handle, float mip, float priority);
+		// 显存不足时降低流式加载的预算，压力解除后恢复
+		void OnMemoryPressure(const MemoryBudgetStatus& status);
+
 	protected:
 		friend class Singleton<TextureManager>;
 		TextureManager() = default;
@@ -54,6 +99,15 @@ namespace DSM {
 	protected:
 		std::mutex m_Mutex;
 		std::unordered_map<std::string, std::shared_ptr<ManagedTexture>> m_Textures;
+
+		// 流式加载的状态，纹理可能在其他线程中注册
+		std::mutex m_StreamingMutex;
+		bool m_StreamingEnabled = false;
+		TextureResidency m_Residency{};
+		std::vector<ManagedTexture*> m_StreamingTextures{};
+		// 显存不足时临时降低流式加载的预算
+		TextureResidencyDesc m_StreamingDesc{};
+		std::uint32_t m_MemoryPressureCallback{};
 	};
 
 #define g_TexManager (TextureManager::GetInstance())
@@ -69,6 +123,8 @@ namespace DSM {
 
 		D3D12_CPU_DESCRIPTOR_HANDLE GetSRV() const noexcept;
 		const Texture* Get() const noexcept { return m_Texture.get(); }
+		// 流式纹理的 mip 提示，非流式纹理忽略
+		void RequestScreenSize(float screenPixels, float priority = 1) const;
 		const Texture* operator->() const { ASSERT(m_Texture != nullptr); return m_Texture.get(); }
 		
 	private:
@@ -0,0 +1,276 @@
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace DSM {
+    namespace {
+        std::uint64_t SumMipSizes(const std::vector<std::uint64_t>& mipSizes, std::uint32_t first, std::uint32_t last) noexcept
+        {
+            std::uint64_t size = 0;
+            for (std::uint32_t i = first; i < last; ++i) size += mipSizes[i];
+            return size;
+        }
+    }
+
+    std::uint32_t TextureResidency::RegisterTexture(
+        std::span<const std::uint64_t> mipSizes,
+        std::uint32_t pinnedMip,
+        std::uint32_t residentMip)
+    {
+        if (mipSizes.empty()) return sm_InvalidHandle;
+
+        std::uint32_t handle{};
+        if (m_FreeHandles.empty()) {
+            handle = static_cast<std::uint32_t>(m_Textures.size());
+            m_Textures.emplace_back();
+        }
+        else {
+            handle = m_FreeHandles.back();
+            m_FreeHandles.pop_back();
+        }
+
+        auto& texture = m_Textures[handle];
+        texture = {};
+        texture.m_MipSizes.assign(mipSizes.begin(), mipSizes.end());
+        texture.m_PinnedMip = (std::min)(pinnedMip, static_cast<std::uint32_t>(mipSizes.size() - 1));
+        texture.m_ResidentMip = (std::min)(residentMip, texture.m_PinnedMip);
+        texture.m_PendingMip = texture.m_ResidentMip;
+        texture.m_RequestedMip = texture.m_PinnedMip;
+        texture.m_Active = true;
+
+        m_Stats.m_ResidentBytes += SumMipSizes(texture.m_MipSizes, texture.m_ResidentMip, static_cast<std::uint32_t>(mipSizes.size()));
+        ++m_Stats.m_NumTextures;
+        return handle;
+    }
+
+    void TextureResidency::UnregisterTexture(std::uint32_t handle)
+    {
+        if (handle >= m_Textures.size() || !m_Textures[handle].m_Active) return;
+
+        auto& texture = m_Textures[handle];
+        auto numMips = static_cast<std::uint32_t>(texture.m_MipSizes.size());
+        m_Stats.m_ResidentBytes -= SumMipSizes(texture.m_MipSizes, texture.m_ResidentMip, numMips);
+        m_Stats.m_PendingBytes -= SumMipSizes(texture.m_MipSizes, texture.m_PendingMip, texture.m_ResidentMip);
+        --m_Stats.m_NumTextures;
+
+        texture = {};
+        m_FreeHandles.push_back(handle);
+    }
+
+    void TextureResidency::RequestMip(std::uint32_t handle, float mip, float priority)
+    {
+        auto& texture = m_Textures[handle];
+        auto requestedMip = std::clamp(static_cast<std::int32_t>(std::floor(mip)), 0, static_cast<std::int32_t>(texture.m_PinnedMip));
+        if (!texture.m_Requested) {
+            texture.m_FrameRequestedMip = static_cast<std::uint32_t>(requestedMip);
+            texture.m_FramePriority = priority;
+            texture.m_Requested = true;
+        }
+        else {
+            texture.m_FrameRequestedMip = (std::min)(texture.m_FrameRequestedMip, static_cast<std::uint32_t>(requestedMip));
+            texture.m_FramePriority = (std::max)(texture.m_FramePriority, priority);
+        }
+    }
+
+    const std::vector<ResidencyRequest>& TextureResidency::Update(std::uint64_t frame)
+    {
+        m_Requests.clear();
+        m_LoadCandidates.clear();
+        m_EvictionCandidates.clear();
+        m_NextEviction = 0;
+        m_FirstNeededEviction = 0;
+        m_EvictionCandidatesBuilt = false;
+        m_FailedEvictionPriority = -std::numeric_limits<float>::infinity();
+        m_FailedEvictionSize = 0;
+        m_Stats.m_NumLoads = 0;
+        m_Stats.m_NumEvictions = 0;
+        m_Stats.m_NumDeferred = 0;
+
+        // 应用本帧的请求并找出需要加载的纹理，同时统计常驻 mip 之外可以释放的字节
+        std::uint64_t evictable = 0;
+        for (std::uint32_t i = 0; i < m_Textures.size(); ++i) {
+            auto& texture = m_Textures[i];
+            if (!texture.m_Active) continue;
+            if (texture.m_PendingMip == texture.m_ResidentMip) {
+                evictable += SumMipSizes(texture.m_MipSizes, texture.m_ResidentMip, texture.m_PinnedMip);
+            }
+
+            texture.m_Evicted = false;
+            if (texture.m_Requested) {
+                texture.m_RequestedMip = texture.m_FrameRequestedMip;
+                texture.m_Priority = texture.m_FramePriority;
+                texture.m_LastUsedFrame = frame;
+                texture.m_Requested = false;
+            }
+            if (texture.m_PendingMip == texture.m_ResidentMip && GetWantedMip(texture, frame) < texture.m_ResidentMip) {
+                m_LoadCandidates.push_back(i);
+            }
+        }
+
+        // 预算被降低时先释放超出的部分，仍被需要的纹理也可以释放
+        // 预算小于常驻的 mip 时无法完全满足，尽量释放
+        if (auto used = m_Stats.m_ResidentBytes + m_Stats.m_PendingBytes; used > m_Desc.m_Budget) {
+            EvictFor((std::min)(used - m_Desc.m_Budget, evictable), std::numeric_limits<float>::max(), frame);
+        }
+
+        // 优先级高且离目标越远的先加载，句柄作为最后的比较保证结果确定
+        auto getScore = [this, frame](std::uint32_t handle) {
+            const auto& texture = m_Textures[handle];
+            return texture.m_Priority * static_cast<float>(texture.m_ResidentMip - GetWantedMip(texture, frame));
+        };
+        std::sort(m_LoadCandidates.begin(), m_LoadCandidates.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+            auto lhsScore = getScore(lhs);
+            auto rhsScore = getScore(rhs);
+            return lhsScore != rhsScore ? lhsScore > rhsScore : lhs < rhs;
+        });
+
+        std::vector<ResidencyRequest> loads{};
+        std::uint64_t loadBytes = 0;
+        for (auto handle : m_LoadCandidates) {
+            auto& texture = m_Textures[handle];
+            if (texture.m_Evicted) continue;
+
+            // 每次只加载下一级，低精度的 mip 总是先于高精度的 mip 可用
+            auto nextMip = texture.m_ResidentMip - 1;
+            auto size = texture.m_MipSizes[nextMip];
+            if (loadBytes > 0 && loadBytes + size > m_Desc.m_MaxLoadBytesPerUpdate) {
+                ++m_Stats.m_NumDeferred;
+                continue;
+            }
+
+            auto required = m_Stats.m_ResidentBytes + m_Stats.m_PendingBytes + size;
+            if (required > m_Desc.m_Budget && !EvictFor(required - m_Desc.m_Budget, texture.m_Priority, frame)) {
+                ++m_Stats.m_NumDeferred;
+                continue;
+            }
+
+            texture.m_PendingMip = nextMip;
+            m_Stats.m_PendingBytes += size;
+            loadBytes += size;
+            loads.push_back({handle, nextMip, ResidencyAction::kLoad});
+        }
+
+        // 同一纹理的多次释放合并为一次
+        for (auto handle : m_EvictionCandidates) {
+            if (m_Textures[handle].m_Evicted) {
+                m_Requests.push_back({handle, m_Textures[handle].m_ResidentMip, ResidencyAction::kEvict});
+            }
+        }
+        m_Stats.m_NumEvictions = static_cast<std::uint32_t>(m_Requests.size());
+        m_Stats.m_NumLoads = static_cast<std::uint32_t>(loads.size());
+        m_Requests.insert(m_Requests.end(), loads.begin(), loads.end());
+
+        return m_Requests;
+    }
+
+    void TextureResidency::CompleteLoad(std::uint32_t handle, std::uint32_t mip)
+    {
+        auto& texture = m_Textures[handle];
+        if (!texture.m_Active || texture.m_PendingMip == texture.m_ResidentMip) return;
+
+        mip = std::clamp(mip, texture.m_PendingMip, texture.m_ResidentMip);
+        m_Stats.m_PendingBytes -= SumMipSizes(texture.m_MipSizes, texture.m_PendingMip, texture.m_ResidentMip);
+        m_Stats.m_ResidentBytes += SumMipSizes(texture.m_MipSizes, mip, texture.m_ResidentMip);
+        texture.m_ResidentMip = mip;
+        texture.m_PendingMip = mip;
+    }
+
+    float TextureResidency::ComputeMipFromFootprint(std::uint32_t width, std::uint32_t height, float screenPixels) noexcept
+    {
+        auto texels = static_cast<float>((std::max)((std::max)(width, height), 1u));
+        return (std::max)(std::log2(texels / (std::max)(screenPixels, 1.0f)), 0.0f);
+    }
+
+    std::uint32_t TextureResidency::GetWantedMip(const TextureState& texture, std::uint64_t frame) const noexcept
+    {
+        if (frame > texture.m_LastUsedFrame + m_Desc.m_UnusedFrames) return texture.m_PinnedMip;
+        return (std::min)(texture.m_RequestedMip, texture.m_PinnedMip);
+    }
+
+    void TextureResidency::BuildEvictionCandidates(std::uint64_t frame)
+    {
+        for (std::uint32_t i = 0; i < m_Textures.size(); ++i) {
+            const auto& texture = m_Textures[i];
+            if (texture.m_Active && texture.m_PendingMip == texture.m_ResidentMip && texture.m_ResidentMip < texture.m_PinnedMip) {
+                m_EvictionCandidates.push_back(i);
+            }
+        }
+
+        // 先释放超出需要的 mip(按 LRU)，再按优先级释放仍需要的 mip
+        auto firstNeeded = std::partition(m_EvictionCandidates.begin(), m_EvictionCandidates.end(), [&](std::uint32_t handle) {
+            return m_Textures[handle].m_ResidentMip < GetWantedMip(m_Textures[handle], frame);
+        });
+        std::sort(m_EvictionCandidates.begin(), firstNeeded, [&](std::uint32_t lhs, std::uint32_t rhs) {
+            const auto& lhsTex = m_Textures[lhs];
+            const auto& rhsTex = m_Textures[rhs];
+            if (lhsTex.m_LastUsedFrame != rhsTex.m_LastUsedFrame) return lhsTex.m_LastUsedFrame < rhsTex.m_LastUsedFrame;
+            if (lhsTex.m_Priority != rhsTex.m_Priority) return lhsTex.m_Priority < rhsTex.m_Priority;
+            return lhs < rhs;
+        });
+        std::sort(firstNeeded, m_EvictionCandidates.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+            const auto& lhsTex = m_Textures[lhs];
+            const auto& rhsTex = m_Textures[rhs];
+            if (lhsTex.m_Priority != rhsTex.m_Priority) return lhsTex.m_Priority < rhsTex.m_Priority;
+            if (lhsTex.m_LastUsedFrame != rhsTex.m_LastUsedFrame) return lhsTex.m_LastUsedFrame < rhsTex.m_LastUsedFrame;
+            return lhs < rhs;
+        });
+        m_FirstNeededEviction = static_cast<std::size_t>(firstNeeded - m_EvictionCandidates.begin());
+        m_EvictionCandidatesBuilt = true;
+    }
+
+    bool TextureResidency::EvictFor(std::uint64_t size, float priority, std::uint64_t frame)
+    {
+        if (!m_EvictionCandidatesBuilt) BuildEvictionCandidates(frame);
+        // 可释放的空间只会随优先级降低而减少，更低优先级的更大请求必然失败
+        if (priority <= m_FailedEvictionPriority && size >= m_FailedEvictionSize) return false;
+
+        // 仍需要的 mip 只能为优先级更高的加载让路
+        auto getEvictLimit = [&](const TextureState& texture) {
+            auto wantedMip = GetWantedMip(texture, frame);
+            if (texture.m_ResidentMip < wantedMip) return wantedMip;
+            return texture.m_Priority < priority ? texture.m_PinnedMip : texture.m_ResidentMip;
+        };
+
+        // 先确认能释放足够的空间，避免释放了一部分却仍无法加载
+        std::uint64_t freeable = 0;
+        for (auto i = m_NextEviction; i < m_EvictionCandidates.size() && freeable < size; ++i) {
+            const auto& texture = m_Textures[m_EvictionCandidates[i]];
+            // 本次 Update 中开始加载的纹理
+            if (texture.m_PendingMip != texture.m_ResidentMip) continue;
+            auto limit = getEvictLimit(texture);
+            if (limit == texture.m_ResidentMip) {
+                // 仍需要的纹理按优先级排列，之后的优先级只会更高
+                if (i >= m_FirstNeededEviction) break;
+                continue;
+            }
+            freeable += SumMipSizes(texture.m_MipSizes, texture.m_ResidentMip, limit);
+        }
+        if (freeable < size) {
+            m_FailedEvictionPriority = priority;
+            m_FailedEvictionSize = size;
+            return false;
+        }
+
+        std::uint64_t freed = 0;
+        while (freed < size && m_NextEviction < m_EvictionCandidates.size()) {
+            auto& texture = m_Textures[m_EvictionCandidates[m_NextEviction]];
+            if (texture.m_PendingMip != texture.m_ResidentMip) {
+                ++m_NextEviction;
+                continue;
+            }
+            auto limit = getEvictLimit(texture);
+            while (freed < size && texture.m_ResidentMip < limit) {
+                freed += texture.m_MipSizes[texture.m_ResidentMip];
+                m_Stats.m_ResidentBytes -= texture.m_MipSizes[texture.m_ResidentMip];
+                ++texture.m_ResidentMip;
+                texture.m_PendingMip = texture.m_ResidentMip;
+                texture.m_Evicted = true;
+            }
+            if (texture.m_ResidentMip == limit && freed < size) {
+                ++m_NextEviction;
+            }
+        }
+        return true;
+    }
+}
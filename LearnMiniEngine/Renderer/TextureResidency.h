@@ -0,0 +1,129 @@
+#pragma once
+#ifndef __TEXTURERESIDENCY_H__
+#define __TEXTURERESIDENCY_H__
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace DSM {
+    struct TextureResidencyDesc
+    {
+        // 所有流式纹理可以占用的显存
+        std::uint64_t m_Budget = 512ull << 20;
+        // 每次 Update 最多开始加载的字节数
+        std::uint64_t m_MaxLoadBytesPerUpdate = 32ull << 20;
+        // 超过该帧数未被使用的纹理只保留常驻的 mip
+        std::uint32_t m_UnusedFrames = 120;
+    };
+
+    enum class ResidencyAction : std::uint8_t
+    {
+        // 加载更精细的 mip，完成后需调用 CompleteLoad
+        kLoad,
+        // 立即释放最精细的若干级 mip
+        kEvict
+    };
+
+    struct ResidencyRequest
+    {
+        std::uint32_t m_Texture{};
+        // 操作完成后驻留的最精细的 mip
+        std::uint32_t m_Mip{};
+        ResidencyAction m_Action = ResidencyAction::kLoad;
+    };
+
+    struct TextureResidencyStats
+    {
+        std::uint64_t m_ResidentBytes = 0;
+        // 已经发出但尚未完成的加载
+        std::uint64_t m_PendingBytes = 0;
+        std::uint32_t m_NumTextures = 0;
+        // 上一次 Update 的结果
+        std::uint32_t m_NumLoads = 0;
+        std::uint32_t m_NumEvictions = 0;
+        // 因预算不足而推迟的加载
+        std::uint32_t m_NumDeferred = 0;
+    };
+
+    // 决定每张纹理驻留哪些 mip，只做决策不访问设备，由调用者执行加载与释放
+    // mip 0 为最精细的一级，驻留 mip 为 r 时 [r, mipLevels) 均在显存中
+    class TextureResidency
+    {
+    public:
+        inline static constexpr std::uint32_t sm_InvalidHandle = ~0u;
+
+        TextureResidency() = default;
+        explicit TextureResidency(const TextureResidencyDesc& desc) : m_Desc(desc) {}
+
+        void SetDesc(const TextureResidencyDesc& desc) noexcept { m_Desc = desc; }
+        const TextureResidencyDesc& GetDesc() const noexcept { return m_Desc; }
+
+        // mipSizes 为每级 mip 的字节数，[pinnedMip, mipLevels) 始终驻留，residentMip 为初始驻留的 mip
+        std::uint32_t RegisterTexture(std::span<const std::uint64_t> mipSizes, std::uint32_t pinnedMip, std::uint32_t residentMip);
+        // 纹理的显存由调用者释放
+        void UnregisterTexture(std::uint32_t handle);
+
+        // 本帧需要的最精细的 mip，同一纹理的多次请求取最精细的 mip 与最高的优先级
+        void RequestMip(std::uint32_t handle, float mip, float priority = 1);
+        // 产生本次需要执行的操作，释放的操作先于加载
+        const std::vector<ResidencyRequest>& Update(std::uint64_t frame);
+        // 加载完成后调用，失败时 mip 传入原来的驻留 mip
+        void CompleteLoad(std::uint32_t handle, std::uint32_t mip);
+
+        std::uint32_t GetResidentMip(std::uint32_t handle) const { return m_Textures[handle].m_ResidentMip; }
+        std::uint32_t GetRequestedMip(std::uint32_t handle) const { return m_Textures[handle].m_RequestedMip; }
+        bool IsLoading(std::uint32_t handle) const { return m_Textures[handle].m_PendingMip != m_Textures[handle].m_ResidentMip; }
+        const TextureResidencyStats& GetStats() const noexcept { return m_Stats; }
+
+        // 由纹理大小与其在屏幕上覆盖的像素数估计需要的 mip
+        static float ComputeMipFromFootprint(std::uint32_t width, std::uint32_t height, float screenPixels) noexcept;
+
+    private:
+        struct TextureState
+        {
+            std::vector<std::uint64_t> m_MipSizes{};
+            std::uint32_t m_PinnedMip = 0;
+            std::uint32_t m_ResidentMip = 0;
+            std::uint32_t m_PendingMip = 0;
+            // 最近一次请求的 mip
+            std::uint32_t m_RequestedMip = 0;
+            // 两次 Update 之间收到的请求
+            std::uint32_t m_FrameRequestedMip = 0;
+            float m_Priority = 0;
+            float m_FramePriority = 0;
+            std::uint64_t m_LastUsedFrame = 0;
+            bool m_Requested = false;
+            bool m_Active = false;
+            // 本次 Update 中被释放过，避免同一次 Update 中又被加载
+            bool m_Evicted = false;
+        };
+
+        // 期望驻留的 mip，长时间未使用的纹理只保留常驻的 mip
+        std::uint32_t GetWantedMip(const TextureState& texture, std::uint64_t frame) const noexcept;
+        // 为优先级为 priority 的加载释放至少 size 字节，返回是否成功
+        bool EvictFor(std::uint64_t size, float priority, std::uint64_t frame);
+        void BuildEvictionCandidates(std::uint64_t frame);
+
+    private:
+        TextureResidencyDesc m_Desc{};
+        std::vector<TextureState> m_Textures{};
+        std::vector<std::uint32_t> m_FreeHandles{};
+
+        std::vector<ResidencyRequest> m_Requests{};
+        std::vector<std::uint32_t> m_LoadCandidates{};
+        // 按释放的先后排列，m_NextEviction 之前的已处理完
+        std::vector<std::uint32_t> m_EvictionCandidates{};
+        std::size_t m_NextEviction = 0;
+        // 之后的纹理仍被需要
+        std::size_t m_FirstNeededEviction = 0;
+        bool m_EvictionCandidatesBuilt = false;
+        // 最近一次释放失败的请求
+        float m_FailedEvictionPriority = 0;
+        std::uint64_t m_FailedEvictionSize = 0;
+
+        TextureResidencyStats m_Stats{};
+    };
+}
+
+#endif
@@ -0,0 +1,503 @@
+#include "BCEncoder.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace DSM {
+    namespace {
+        // BC7 4 位索引的插值权重
+        constexpr std::uint32_t kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        // 最小二乘求解端点的迭代次数
+        constexpr int kRefineIterations = 2;
+
+        // 数值与 DXGI_FORMAT 一致
+        constexpr std::uint32_t kFormatBC1Unorm = 71;
+        constexpr std::uint32_t kFormatBC1UnormSRGB = 72;
+        constexpr std::uint32_t kFormatBC3Unorm = 77;
+        constexpr std::uint32_t kFormatBC3UnormSRGB = 78;
+        constexpr std::uint32_t kFormatBC4Unorm = 80;
+        constexpr std::uint32_t kFormatBC5Unorm = 83;
+        constexpr std::uint32_t kFormatBC7Unorm = 98;
+        constexpr std::uint32_t kFormatBC7UnormSRGB = 99;
+
+        // 按最低位优先写入 128 位的块
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(std::uint8_t* dst) : m_Dst(dst) { std::memset(dst, 0, 16); }
+
+            void Write(std::uint32_t value, std::uint32_t numBits) noexcept
+            {
+                for (std::uint32_t i = 0; i < numBits; ++i, ++m_Bit) {
+                    if (value & (1u << i)) m_Dst[m_Bit >> 3] |= static_cast<std::uint8_t>(1u << (m_Bit & 7));
+                }
+            }
+
+        private:
+            std::uint8_t* m_Dst{};
+            std::uint32_t m_Bit{};
+        };
+
+        // 求协方差矩阵的主方向，使用幂迭代
+        template <int N>
+        void ComputePrincipalAxis(const float (*points)[N], float* mean, float* axis) noexcept
+        {
+            for (int c = 0; c < N; ++c) {
+                mean[c] = 0;
+                for (int i = 0; i < 16; ++i) mean[c] += points[i][c];
+                mean[c] /= 16;
+            }
+
+            float cov[N][N]{};
+            for (int i = 0; i < 16; ++i) {
+                float d[N];
+                for (int c = 0; c < N; ++c) d[c] = points[i][c] - mean[c];
+                for (int r = 0; r < N; ++r) {
+                    for (int c = 0; c < N; ++c) cov[r][c] += d[r] * d[c];
+                }
+            }
+
+            // 以方差最大的通道作为初始方向
+            int maxChannel = 0;
+            for (int c = 1; c < N; ++c) {
+                if (cov[c][c] > cov[maxChannel][maxChannel]) maxChannel = c;
+            }
+            for (int c = 0; c < N; ++c) axis[c] = cov[maxChannel][c];
+
+            for (int iter = 0; iter < 8; ++iter) {
+                float next[N]{};
+                for (int r = 0; r < N; ++r) {
+                    for (int c = 0; c < N; ++c) next[r] += cov[r][c] * axis[c];
+                }
+                float length = 0;
+                for (int c = 0; c < N; ++c) length += next[c] * next[c];
+                if (length < 1e-12f) break;
+                length = 1.0f / std::sqrt(length);
+                for (int c = 0; c < N; ++c) axis[c] = next[c] * length;
+            }
+
+            float length = 0;
+            for (int c = 0; c < N; ++c) length += axis[c] * axis[c];
+            if (length < 1e-12f) {
+                for (int c = 0; c < N; ++c) axis[c] = 0;
+                axis[0] = 1;
+            }
+            else {
+                length = 1.0f / std::sqrt(length);
+                for (int c = 0; c < N; ++c) axis[c] *= length;
+            }
+        }
+
+        // 沿主方向投影得到包围盒端点
+        template <int N>
+        void ComputeAxisEndpoints(const float (*points)[N], float* endpoint0, float* endpoint1) noexcept
+        {
+            float mean[N];
+            float axis[N];
+            ComputePrincipalAxis<N>(points, mean, axis);
+
+            float minT = 0;
+            float maxT = 0;
+            for (int i = 0; i < 16; ++i) {
+                float t = 0;
+                for (int c = 0; c < N; ++c) t += (points[i][c] - mean[c]) * axis[c];
+                minT = (std::min)(minT, t);
+                maxT = (std::max)(maxT, t);
+            }
+            for (int c = 0; c < N; ++c) {
+                endpoint0[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+                endpoint1[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            }
+        }
+
+        // 给定每个像素在两个端点间的插值系数，求误差最小的端点
+        template <int N>
+        bool SolveEndpoints(const float (*points)[N], const float* weights, float* endpoint0, float* endpoint1) noexcept
+        {
+            float aa = 0, ab = 0, bb = 0;
+            float ap[N]{}, bp[N]{};
+            for (int i = 0; i < 16; ++i) {
+                float b = weights[i];
+                float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (int c = 0; c < N; ++c) {
+                    ap[c] += a * points[i][c];
+                    bp[c] += b * points[i][c];
+                }
+            }
+
+            float det = aa * bb - ab * ab;
+            if (std::abs(det) < 1e-6f) return false;
+            float invDet = 1.0f / det;
+            for (int c = 0; c < N; ++c) {
+                endpoint0[c] = std::clamp((ap[c] * bb - bp[c] * ab) * invDet, 0.0f, 255.0f);
+                endpoint1[c] = std::clamp((bp[c] * aa - ap[c] * ab) * invDet, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        //
+        // BC1
+        //
+        std::uint16_t PackRGB565(const float* color) noexcept
+        {
+            auto r = static_cast<std::uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+            auto g = static_cast<std::uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+            auto b = static_cast<std::uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+            return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void UnpackRGB565(std::uint16_t color, std::int32_t* rgb) noexcept
+        {
+            std::int32_t r = (color >> 11) & 31;
+            std::int32_t g = (color >> 5) & 63;
+            std::int32_t b = color & 31;
+            rgb[0] = (r << 3) | (r >> 2);
+            rgb[1] = (g << 2) | (g >> 4);
+            rgb[2] = (b << 3) | (b >> 2);
+        }
+
+        // 四色模式下为每个像素选取索引，返回总误差
+        std::uint32_t FindColorIndices(const std::uint8_t* block, std::uint16_t color0, std::uint16_t color1, std::uint8_t* indices) noexcept
+        {
+            std::int32_t palette[4][3];
+            UnpackRGB565(color0, palette[0]);
+            UnpackRGB565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            std::uint32_t totalError = 0;
+            for (int i = 0; i < 16; ++i) {
+                std::uint32_t bestError = ~0u;
+                for (std::uint8_t j = 0; j < 4; ++j) {
+                    std::int32_t dr = block[i * 4 + 0] - palette[j][0];
+                    std::int32_t dg = block[i * 4 + 1] - palette[j][1];
+                    std::int32_t db = block[i * 4 + 2] - palette[j][2];
+                    auto error = static_cast<std::uint32_t>(dr * dr + dg * dg + db * db);
+                    if (error < bestError) {
+                        bestError = error;
+                        indices[i] = j;
+                    }
+                }
+                totalError += bestError;
+            }
+            return totalError;
+        }
+
+        void EncodeColorBlock(const std::uint8_t* block, std::uint8_t* dst) noexcept
+        {
+            float points[16][3];
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < 3; ++c) points[i][c] = block[i * 4 + c];
+            }
+
+            float endpoint0[3], endpoint1[3];
+            ComputeAxisEndpoints<3>(points, endpoint0, endpoint1);
+
+            // 端点 0 为较大的一端
+            std::uint16_t bestColor0 = PackRGB565(endpoint1);
+            std::uint16_t bestColor1 = PackRGB565(endpoint0);
+            std::uint8_t bestIndices[16];
+            std::uint32_t bestError = FindColorIndices(block, bestColor0, bestColor1, bestIndices);
+
+            constexpr float kIndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            for (int iter = 0; iter < kRefineIterations && bestError > 0; ++iter) {
+                float weights[16];
+                for (int i = 0; i < 16; ++i) weights[i] = kIndexWeights[bestIndices[i]];
+                if (!SolveEndpoints<3>(points, weights, endpoint0, endpoint1)) break;
+
+                std::uint16_t color0 = PackRGB565(endpoint0);
+                std::uint16_t color1 = PackRGB565(endpoint1);
+                std::uint8_t indices[16];
+                auto error = FindColorIndices(block, color0, color1, indices);
+                if (error >= bestError) break;
+                bestError = error;
+                bestColor0 = color0;
+                bestColor1 = color1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+
+            // 四色模式要求 color0 > color1，相等时全部使用索引 0
+            if (bestColor0 < bestColor1) {
+                std::swap(bestColor0, bestColor1);
+                for (auto& index : bestIndices) index ^= 1;
+            }
+            else if (bestColor0 == bestColor1) {
+                std::memset(bestIndices, 0, sizeof(bestIndices));
+            }
+
+            std::uint32_t packedIndices = 0;
+            for (int i = 0; i < 16; ++i) packedIndices |= std::uint32_t(bestIndices[i]) << (i * 2);
+            dst[0] = static_cast<std::uint8_t>(bestColor0);
+            dst[1] = static_cast<std::uint8_t>(bestColor0 >> 8);
+            dst[2] = static_cast<std::uint8_t>(bestColor1);
+            dst[3] = static_cast<std::uint8_t>(bestColor1 >> 8);
+            std::memcpy(dst + 4, &packedIndices, sizeof(packedIndices));
+        }
+
+        //
+        // BC7 模式 6
+        //
+        struct BC7Endpoints
+        {
+            std::uint32_t m_Quantized[2][4]{};
+            std::uint32_t m_PBits[2]{};
+        };
+
+        std::uint32_t FindBC7Indices(const std::uint8_t* block, const BC7Endpoints& endpoints, std::uint8_t* indices) noexcept
+        {
+            std::int32_t palette[16][4];
+            for (int c = 0; c < 4; ++c) {
+                std::int32_t e0 = endpoints.m_Quantized[0][c] << 1 | endpoints.m_PBits[0];
+                std::int32_t e1 = endpoints.m_Quantized[1][c] << 1 | endpoints.m_PBits[1];
+                for (int j = 0; j < 16; ++j) {
+                    palette[j][c] = ((64 - kBC7Weights[j]) * e0 + kBC7Weights[j] * e1 + 32) >> 6;
+                }
+            }
+
+            // 先沿端点方向投影估计索引，再检查相邻的两个索引
+            std::int32_t axis[4];
+            std::int32_t axisLength = 0;
+            for (int c = 0; c < 4; ++c) {
+                axis[c] = palette[15][c] - palette[0][c];
+                axisLength += axis[c] * axis[c];
+            }
+
+            std::uint32_t totalError = 0;
+            for (int i = 0; i < 16; ++i) {
+                int estimate = 0;
+                if (axisLength > 0) {
+                    std::int32_t dot = 0;
+                    for (int c = 0; c < 4; ++c) dot += (block[i * 4 + c] - palette[0][c]) * axis[c];
+                    auto t = std::clamp(static_cast<std::int32_t>((dot * 64ll + axisLength / 2) / axisLength), 0, 64);
+                    estimate = static_cast<int>(std::upper_bound(std::begin(kBC7Weights), std::end(kBC7Weights), std::uint32_t(t)) - std::begin(kBC7Weights)) - 1;
+                }
+
+                std::uint32_t bestError = ~0u;
+                for (int j = (std::max)(estimate - 1, 0); j <= (std::min)(estimate + 1, 15); ++j) {
+                    std::uint32_t error = 0;
+                    for (int c = 0; c < 4; ++c) {
+                        std::int32_t d = block[i * 4 + c] - palette[j][c];
+                        error += static_cast<std::uint32_t>(d * d);
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        indices[i] = static_cast<std::uint8_t>(j);
+                    }
+                }
+                totalError += bestError;
+            }
+            return totalError;
+        }
+
+        // 尝试四种 p 位的组合，返回误差最小的量化结果
+        std::uint32_t QuantizeBC7Endpoints(
+            const std::uint8_t* block,
+            const float* endpoint0,
+            const float* endpoint1,
+            BC7Endpoints& bestEndpoints,
+            std::uint8_t* bestIndices) noexcept
+        {
+            std::uint32_t bestError = ~0u;
+            for (std::uint32_t pbits = 0; pbits < 4; ++pbits) {
+                BC7Endpoints endpoints{};
+                endpoints.m_PBits[0] = pbits & 1;
+                endpoints.m_PBits[1] = pbits >> 1;
+                for (int c = 0; c < 4; ++c) {
+                    auto quantize = [](float value, std::uint32_t pbit) {
+                        return static_cast<std::uint32_t>(std::clamp((value - pbit) * 0.5f + 0.5f, 0.0f, 127.0f));
+                    };
+                    endpoints.m_Quantized[0][c] = quantize(endpoint0[c], endpoints.m_PBits[0]);
+                    endpoints.m_Quantized[1][c] = quantize(endpoint1[c], endpoints.m_PBits[1]);
+                }
+
+                std::uint8_t indices[16];
+                auto error = FindBC7Indices(block, endpoints, indices);
+                if (error < bestError) {
+                    bestError = error;
+                    bestEndpoints = endpoints;
+                    std::memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+            return bestError;
+        }
+    }
+
+    std::uint32_t BCEncoder::GetBlockSize(BCFormat format) noexcept
+    {
+        return format == BCFormat::kBC1 || format == BCFormat::kBC4 ? 8 : 16;
+    }
+
+    std::uint32_t BCEncoder::GetDXGIFormat(BCFormat format, bool sRGB) noexcept
+    {
+        switch (format) {
+            case BCFormat::kBC1: return sRGB ? kFormatBC1UnormSRGB : kFormatBC1Unorm;
+            case BCFormat::kBC3: return sRGB ? kFormatBC3UnormSRGB : kFormatBC3Unorm;
+            case BCFormat::kBC4: return kFormatBC4Unorm;
+            case BCFormat::kBC5: return kFormatBC5Unorm;
+            case BCFormat::kBC7: return sRGB ? kFormatBC7UnormSRGB : kFormatBC7Unorm;
+        }
+        return 0;
+    }
+
+    std::uint64_t BCEncoder::GetCompressedSize(std::uint32_t width, std::uint32_t height, BCFormat format) noexcept
+    {
+        std::uint64_t blocksX = (std::max)((width + 3) / 4, 1u);
+        std::uint64_t blocksY = (std::max)((height + 3) / 4, 1u);
+        return blocksX * blocksY * GetBlockSize(format);
+    }
+
+    void BCEncoder::EncodeBlockBC1(const std::uint8_t* block, std::uint8_t* dst) noexcept
+    {
+        EncodeColorBlock(block, dst);
+    }
+
+    void BCEncoder::EncodeBlockBC3(const std::uint8_t* block, std::uint8_t* dst) noexcept
+    {
+        // BC3 的颜色块总是使用四色模式
+        EncodeBlockBC4(block, dst, 3);
+        EncodeColorBlock(block, dst + 8);
+    }
+
+    void BCEncoder::EncodeBlockBC4(const std::uint8_t* block, std::uint8_t* dst, std::uint32_t channel) noexcept
+    {
+        std::uint8_t minValue = 255;
+        std::uint8_t maxValue = 0;
+        for (int i = 0; i < 16; ++i) {
+            minValue = (std::min)(minValue, block[i * 4 + channel]);
+            maxValue = (std::max)(maxValue, block[i * 4 + channel]);
+        }
+
+        dst[0] = maxValue;
+        dst[1] = minValue;
+        std::uint64_t packedIndices = 0;
+        if (maxValue > minValue) {
+            // endpoint0 > endpoint1 时为八值模式
+            std::int32_t palette[8];
+            palette[0] = maxValue;
+            palette[1] = minValue;
+            for (int i = 2; i < 8; ++i) {
+                palette[i] = ((8 - i) * maxValue + (i - 1) * minValue + 3) / 7;
+            }
+
+            for (int i = 0; i < 16; ++i) {
+                std::int32_t value = block[i * 4 + channel];
+                std::uint64_t bestIndex = 0;
+                std::int32_t bestError = 256;
+                for (int j = 0; j < 8; ++j) {
+                    auto error = std::abs(value - palette[j]);
+                    if (error < bestError) {
+                        bestError = error;
+                        bestIndex = j;
+                    }
+                }
+                packedIndices |= bestIndex << (i * 3);
+            }
+        }
+        for (int i = 0; i < 6; ++i) {
+            dst[2 + i] = static_cast<std::uint8_t>(packedIndices >> (i * 8));
+        }
+    }
+
+    void BCEncoder::EncodeBlockBC5(const std::uint8_t* block, std::uint8_t* dst) noexcept
+    {
+        EncodeBlockBC4(block, dst, 0);
+        EncodeBlockBC4(block, dst + 8, 1);
+    }
+
+    void BCEncoder::EncodeBlockBC7(const std::uint8_t* block, std::uint8_t* dst) noexcept
+    {
+        float points[16][4];
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 4; ++c) points[i][c] = block[i * 4 + c];
+        }
+
+        float endpoint0[4], endpoint1[4];
+        ComputeAxisEndpoints<4>(points, endpoint0, endpoint1);
+
+        BC7Endpoints bestEndpoints{};
+        std::uint8_t bestIndices[16];
+        auto bestError = QuantizeBC7Endpoints(block, endpoint0, endpoint1, bestEndpoints, bestIndices);
+
+        for (int iter = 0; iter < kRefineIterations && bestError > 0; ++iter) {
+            float weights[16];
+            for (int i = 0; i < 16; ++i) weights[i] = kBC7Weights[bestIndices[i]] / 64.0f;
+            if (!SolveEndpoints<4>(points, weights, endpoint0, endpoint1)) break;
+
+            BC7Endpoints endpoints{};
+            std::uint8_t indices[16];
+            auto error = QuantizeBC7Endpoints(block, endpoint0, endpoint1, endpoints, indices);
+            if (error >= bestError) break;
+            bestError = error;
+            bestEndpoints = endpoints;
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        // 第一个像素的索引最高位隐含为 0
+        if (bestIndices[0] >= 8) {
+            for (int c = 0; c < 4; ++c) {
+                std::swap(bestEndpoints.m_Quantized[0][c], bestEndpoints.m_Quantized[1][c]);
+            }
+            std::swap(bestEndpoints.m_PBits[0], bestEndpoints.m_PBits[1]);
+            for (auto& index : bestIndices) index = static_cast<std::uint8_t>(15 - index);
+        }
+
+        BitWriter writer{dst};
+        writer.Write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c) {
+            writer.Write(bestEndpoints.m_Quantized[0][c], 7);
+            writer.Write(bestEndpoints.m_Quantized[1][c], 7);
+        }
+        writer.Write(bestEndpoints.m_PBits[0], 1);
+        writer.Write(bestEndpoints.m_PBits[1], 1);
+        writer.Write(bestIndices[0], 3);
+        for (int i = 1; i < 16; ++i) {
+            writer.Write(bestIndices[i], 4);
+        }
+    }
+
+    void BCEncoder::CompressImage(
+        const std::uint8_t* rgba,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint64_t rowPitch,
+        BCFormat format,
+        std::uint8_t* dst,
+        std::uint32_t numThreads)
+    {
+        if (rowPitch == 0) rowPitch = std::uint64_t(width) * 4;
+        const std::uint32_t blocksX = (std::max)((width + 3) / 4, 1u);
+        const std::uint32_t blocksY = (std::max)((height + 3) / 4, 1u);
+        const std::uint32_t blockSize = GetBlockSize(format);
+
+        Utility::ParallelFor(blocksY, numThreads, [&](std::uint32_t beginRow, std::uint32_t endRow) {
+            std::uint8_t block[64];
+            for (std::uint32_t by = beginRow; by < endRow; ++by) {
+                auto dstRow = dst + std::uint64_t(by) * blocksX * blockSize;
+                for (std::uint32_t bx = 0; bx < blocksX; ++bx) {
+                    for (std::uint32_t y = 0; y < 4; ++y) {
+                        auto srcY = (std::min)(by * 4 + y, height - 1);
+                        for (std::uint32_t x = 0; x < 4; ++x) {
+                            auto srcX = (std::min)(bx * 4 + x, width - 1);
+                            std::memcpy(block + (y * 4 + x) * 4, rgba + rowPitch * srcY + srcX * 4, 4);
+                        }
+                    }
+
+                    auto dstBlock = dstRow + std::uint64_t(bx) * blockSize;
+                    switch (format) {
+                        case BCFormat::kBC1: EncodeBlockBC1(block, dstBlock); break;
+                        case BCFormat::kBC3: EncodeBlockBC3(block, dstBlock); break;
+                        case BCFormat::kBC4: EncodeBlockBC4(block, dstBlock); break;
+                        case BCFormat::kBC5: EncodeBlockBC5(block, dstBlock); break;
+                        case BCFormat::kBC7: EncodeBlockBC7(block, dstBlock); break;
+                    }
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef __BCENCODER_H__
+#define __BCENCODER_H__
+
+#include <cstdint>
+
+namespace DSM {
+    enum class BCFormat
+    {
+        // RGB，不含 alpha
+        kBC1,
+        // RGB + 插值的 alpha
+        kBC3,
+        // 单通道，取 R 通道
+        kBC4,
+        // 双通道，取 RG 通道，用于法线贴图
+        kBC5,
+        // RGBA，使用模式 6
+        kBC7
+    };
+
+    // 将 RGBA8 数据压缩为 BC 格式，不依赖 D3D12
+    class BCEncoder
+    {
+    public:
+        // 每个 4x4 块的字节数
+        static std::uint32_t GetBlockSize(BCFormat format) noexcept;
+        // 返回 DXGI_FORMAT 的数值
+        static std::uint32_t GetDXGIFormat(BCFormat format, bool sRGB) noexcept;
+        static std::uint64_t GetCompressedSize(std::uint32_t width, std::uint32_t height, BCFormat format) noexcept;
+
+        // block 为按行排列的 16 个 RGBA8 像素
+        static void EncodeBlockBC1(const std::uint8_t* block, std::uint8_t* dst) noexcept;
+        static void EncodeBlockBC3(const std::uint8_t* block, std::uint8_t* dst) noexcept;
+        static void EncodeBlockBC4(const std::uint8_t* block, std::uint8_t* dst, std::uint32_t channel = 0) noexcept;
+        static void EncodeBlockBC5(const std::uint8_t* block, std::uint8_t* dst) noexcept;
+        static void EncodeBlockBC7(const std::uint8_t* block, std::uint8_t* dst) noexcept;
+
+        // 压缩整张图片，宽高不足 4 的块用边缘像素补齐，rowPitch 为 0 时视为紧密排列
+        static void CompressImage(
+            const std::uint8_t* rgba,
+            std::uint32_t width,
+            std::uint32_t height,
+            std::uint64_t rowPitch,
+            BCFormat format,
+            std::uint8_t* dst,
+            std::uint32_t numThreads = 0);
+    };
+}
+
+#endif
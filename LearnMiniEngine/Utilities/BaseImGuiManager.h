@@ -9,7 +9,9 @@
 #include "imgui_impl_dx12.h"
 #include "imgui_impl_win32.h"
 #include "Singleton.h"
-#include "Core/CpuTimer.h"
+#include "Core/GameCore.h"
+#include "Core/Profiler.h"
+#include "Graphics/RenderContext.h"
 
 
 namespace DSM {
@@ -23,6 +25,8 @@ namespace DSM {
 		void ImGuiNewFrame();
 		void Update(float time);
 		virtual void RenderImGui(ID3D12GraphicsCommandList* cmdList);
+		// 显示 CPU 分析器上一帧的层级耗时
+		void ShowProfilerWindow(bool* open = nullptr);
 
 	protected:
 		BaseImGuiManager() = default;
@@ -91,6 +95,76 @@ namespace DSM {
 		ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), cmdList);
 	}
 
+	template<typename Driver>
+	void BaseImGuiManager<Driver>::ShowProfilerWindow(bool* open)
+	{
+		auto& profiler = Profiler::GetInstance();
+		if (ImGui::Begin("Profiler", open)) {
+			const auto& frame = profiler.GetLastFrame();
+			ImGui::Text("Frame %llu: %.3f ms", frame.m_FrameIndex, frame.m_FrameTime);
+			const auto& frameStats = GameCore::GetFrameTimeStats();
+			ImGui::Text("FPS %.1f  Min %.2f  Avg %.2f  P95 %.2f  P99 %.2f ms",
+				frameStats.GetFPS(), frameStats.GetMin(), frameStats.GetAverage(), frameStats.GetP95(), frameStats.GetP99());
+			const auto& gpuStats = g_RenderContext.GetGpuProfiler().GetLastFrameStats();
+			ImGui::Text("GPU Frame %llu: %.3f ms (CPU %.3f ms, Latency %.3f ms)",
+				gpuStats.m_FrameIndex, gpuStats.m_GpuTime, gpuStats.m_CpuTime, gpuStats.m_Latency);
+
+			bool enabled = profiler.IsEnabled();
+			if (ImGui::Checkbox("Enabled", &enabled)) {
+				profiler.SetEnabled(enabled);
+			}
+			ImGui::SameLine();
+			if (!profiler.IsCapturing()) {
+				if (ImGui::Button("Begin Capture")) {
+					profiler.BeginCapture();
+				}
+			}
+			else if (ImGui::Button("End Capture")) {
+				profiler.EndCapture();
+				profiler.SaveChromeTrace("ProfilerTrace.json");
+			}
+
+			if (!frame.m_Nodes.empty() && ImGui::BeginTable("##ProfileTree", 3,
+				ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable)) {
+				ImGui::TableSetupColumn("Scope");
+				ImGui::TableSetupColumn("Time (ms)", ImGuiTableColumnFlags_WidthFixed);
+				ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed);
+				ImGui::TableHeadersRow();
+
+				auto drawNode = [&](auto&& self, std::uint32_t nodeIndex) -> void {
+					const auto& node = frame.m_Nodes[nodeIndex];
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+
+					std::string name = node.m_Name != nullptr ? node.m_Name : profiler.GetThreadName(node.m_ThreadIndex);
+					ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen;
+					if (node.m_Children.empty()) {
+						flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+					}
+					ImGui::PushID(static_cast<int>(nodeIndex));
+					bool opened = ImGui::TreeNodeEx(name.c_str(), flags);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", node.m_TotalTime);
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", node.m_CallCount);
+
+					if (opened && !node.m_Children.empty()) {
+						for (auto child : node.m_Children) {
+							self(self, child);
+						}
+						ImGui::TreePop();
+					}
+					ImGui::PopID();
+				};
+				for (auto threadNode : frame.GetRoot().m_Children) {
+					drawNode(drawNode, threadNode);
+				}
+				ImGui::EndTable();
+			}
+		}
+		ImGui::End();
+	}
+
 	template<typename Driver>
 	BaseImGuiManager<Driver> ::~BaseImGuiManager()
 	{
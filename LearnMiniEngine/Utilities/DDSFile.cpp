@@ -0,0 +1,627 @@
+#include "DDSFile.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace DSM {
+    namespace {
+        #pragma pack(push, 1)
+        struct DDSPixelFormat
+        {
+            std::uint32_t m_Size;
+            std::uint32_t m_Flags;
+            std::uint32_t m_FourCC;
+            std::uint32_t m_RGBBitCount;
+            std::uint32_t m_RBitMask;
+            std::uint32_t m_GBitMask;
+            std::uint32_t m_BBitMask;
+            std::uint32_t m_ABitMask;
+        };
+
+        struct DDSHeader
+        {
+            std::uint32_t m_Size;
+            std::uint32_t m_Flags;
+            std::uint32_t m_Height;
+            std::uint32_t m_Width;
+            std::uint32_t m_PitchOrLinearSize;
+            std::uint32_t m_Depth;
+            std::uint32_t m_MipMapCount;
+            std::uint32_t m_Reserved1[11];
+            DDSPixelFormat m_PixelFormat;
+            std::uint32_t m_Caps;
+            std::uint32_t m_Caps2;
+            std::uint32_t m_Caps3;
+            std::uint32_t m_Caps4;
+            std::uint32_t m_Reserved2;
+        };
+
+        struct DDSHeaderDXT10
+        {
+            std::uint32_t m_Format;
+            std::uint32_t m_ResourceDimension;
+            std::uint32_t m_MiscFlag;
+            std::uint32_t m_ArraySize;
+            std::uint32_t m_MiscFlags2;
+        };
+        #pragma pack(pop)
+
+        static_assert(sizeof(DDSPixelFormat) == 32);
+        static_assert(sizeof(DDSHeader) == 124);
+        static_assert(sizeof(DDSHeaderDXT10) == 20);
+
+        constexpr std::uint32_t kDDSMagic = 0x20534444;     // "DDS "
+        constexpr std::uint32_t kDDSFourCC = 0x00000004;
+        constexpr std::uint32_t kDDSRGB = 0x00000040;
+        constexpr std::uint32_t kDDSLuminance = 0x00020000;
+        constexpr std::uint32_t kDDSAlpha = 0x00000002;
+        constexpr std::uint32_t kDDSBumpDUDV = 0x00080000;
+        constexpr std::uint32_t kDDSHeight = 0x00000002;
+        constexpr std::uint32_t kDDSVolume = 0x00800000;
+        constexpr std::uint32_t kDDSCubeMap = 0x00000200;
+        constexpr std::uint32_t kDDSCubeMapAllFaces = 0x0000fe00;
+        constexpr std::uint32_t kMiscTextureCube = 0x4;
+        constexpr std::uint32_t kDDSHeaderFlagsTexture = 0x00001007;  // CAPS | HEIGHT | WIDTH | PIXELFORMAT
+        constexpr std::uint32_t kDDSHeaderFlagsMipMap = 0x00020000;
+        constexpr std::uint32_t kDDSHeaderFlagsVolume = 0x00800000;
+        constexpr std::uint32_t kDDSHeaderFlagsLinearSize = 0x00080000;
+        constexpr std::uint32_t kDDSSurfaceFlagsTexture = 0x00001000;
+        constexpr std::uint32_t kDDSSurfaceFlagsMipMap = 0x00400008;
+        constexpr std::uint32_t kDDSSurfaceFlagsCubeMap = 0x00000008;
+
+        // 用到的 DXGI_FORMAT 数值
+        enum DXGIFormat : std::uint32_t
+        {
+            kFormatUnknown = 0,
+            kFormatR32G32B32A32Float = 2,
+            kFormatR16G16B16A16Float = 10,
+            kFormatR16G16B16A16Unorm = 11,
+            kFormatR16G16B16A16Snorm = 13,
+            kFormatR32G32Float = 16,
+            kFormatR10G10B10A2Unorm = 24,
+            kFormatR8G8B8A8Unorm = 28,
+            kFormatR8G8B8A8UnormSRGB = 29,
+            kFormatR8G8B8A8Snorm = 31,
+            kFormatR16G16Float = 34,
+            kFormatR16G16Unorm = 35,
+            kFormatR16G16Snorm = 37,
+            kFormatR32Float = 41,
+            kFormatR8G8Unorm = 49,
+            kFormatR8G8Snorm = 51,
+            kFormatR16Float = 54,
+            kFormatR16Unorm = 56,
+            kFormatR8Unorm = 61,
+            kFormatA8Unorm = 65,
+            kFormatR1Unorm = 66,
+            kFormatR8G8B8G8Unorm = 68,
+            kFormatG8R8G8B8Unorm = 69,
+            kFormatBC1Typeless = 70,
+            kFormatBC1Unorm = 71,
+            kFormatBC1UnormSRGB = 72,
+            kFormatBC2Unorm = 74,
+            kFormatBC2UnormSRGB = 75,
+            kFormatBC3Unorm = 77,
+            kFormatBC3UnormSRGB = 78,
+            kFormatBC4Typeless = 79,
+            kFormatBC4Unorm = 80,
+            kFormatBC4Snorm = 81,
+            kFormatBC5Unorm = 83,
+            kFormatBC5Snorm = 84,
+            kFormatB5G6R5Unorm = 85,
+            kFormatB5G5R5A1Unorm = 86,
+            kFormatB8G8R8A8Unorm = 87,
+            kFormatB8G8R8X8Unorm = 88,
+            kFormatB8G8R8A8UnormSRGB = 91,
+            kFormatB8G8R8X8UnormSRGB = 93,
+            kFormatBC6HTypeless = 94,
+            kFormatBC7Unorm = 98,
+            kFormatBC7UnormSRGB = 99,
+            kFormatAYUV = 100,
+            kFormatY410 = 101,
+            kFormatY416 = 102,
+            kFormatYUY2 = 107,
+            kFormatY210 = 108,
+            kFormatY216 = 109,
+            kFormatB4G4R4A4Unorm = 115,
+        };
+
+        constexpr std::uint32_t MakeFourCC(char c0, char c1, char c2, char c3) noexcept
+        {
+            return static_cast<std::uint32_t>(static_cast<std::uint8_t>(c0)) |
+                (static_cast<std::uint32_t>(static_cast<std::uint8_t>(c1)) << 8) |
+                (static_cast<std::uint32_t>(static_cast<std::uint8_t>(c2)) << 16) |
+                (static_cast<std::uint32_t>(static_cast<std::uint8_t>(c3)) << 24);
+        }
+
+        constexpr std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment) noexcept
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        bool IsPacked(std::uint32_t format) noexcept
+        {
+            switch (format) {
+                case kFormatR8G8B8G8Unorm:
+                case kFormatG8R8G8B8Unorm:
+                case kFormatYUY2:
+                case kFormatY210:
+                case kFormatY216:
+                    return true;
+                default: return false;
+            }
+        }
+
+        // 旧式头部的像素格式转换为 DXGI 格式
+        std::uint32_t GetDXGIFormat(const DDSPixelFormat& pf) noexcept
+        {
+            auto isBitMask = [&pf](std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t a) {
+                return pf.m_RBitMask == r && pf.m_GBitMask == g && pf.m_BBitMask == b && pf.m_ABitMask == a;
+            };
+
+            if (pf.m_Flags & kDDSRGB) {
+                switch (pf.m_RGBBitCount) {
+                    case 32:
+                        if (isBitMask(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)) return kFormatR8G8B8A8Unorm;
+                        if (isBitMask(0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000)) return kFormatB8G8R8A8Unorm;
+                        if (isBitMask(0x00ff0000, 0x0000ff00, 0x000000ff, 0)) return kFormatB8G8R8X8Unorm;
+                        // D3DX 写入的 10:10:10:2 格式红蓝通道是反的
+                        if (isBitMask(0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000)) return kFormatR10G10B10A2Unorm;
+                        if (isBitMask(0x0000ffff, 0xffff0000, 0, 0)) return kFormatR16G16Unorm;
+                        if (isBitMask(0xffffffff, 0, 0, 0)) return kFormatR32Float;
+                        break;
+                    case 16:
+                        if (isBitMask(0x7c00, 0x03e0, 0x001f, 0x8000)) return kFormatB5G5R5A1Unorm;
+                        if (isBitMask(0xf800, 0x07e0, 0x001f, 0)) return kFormatB5G6R5Unorm;
+                        if (isBitMask(0x0f00, 0x00f0, 0x000f, 0xf000)) return kFormatB4G4R4A4Unorm;
+                        if (isBitMask(0x00ff, 0, 0, 0xff00)) return kFormatR8G8Unorm;
+                        if (isBitMask(0xffff, 0, 0, 0)) return kFormatR16Unorm;
+                        break;
+                    case 8:
+                        if (isBitMask(0xff, 0, 0, 0)) return kFormatR8Unorm;
+                        break;
+                    default: break;
+                }
+            }
+            else if (pf.m_Flags & kDDSLuminance) {
+                if (pf.m_RGBBitCount == 16 && isBitMask(0xffff, 0, 0, 0)) return kFormatR16Unorm;
+                if ((pf.m_RGBBitCount == 16 || pf.m_RGBBitCount == 8) && isBitMask(0x00ff, 0, 0, 0xff00)) return kFormatR8G8Unorm;
+                if (pf.m_RGBBitCount == 8 && isBitMask(0xff, 0, 0, 0)) return kFormatR8Unorm;
+            }
+            else if (pf.m_Flags & kDDSAlpha) {
+                if (pf.m_RGBBitCount == 8) return kFormatA8Unorm;
+            }
+            else if (pf.m_Flags & kDDSBumpDUDV) {
+                if (pf.m_RGBBitCount == 32 && isBitMask(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)) return kFormatR8G8B8A8Snorm;
+                if (pf.m_RGBBitCount == 32 && isBitMask(0x0000ffff, 0xffff0000, 0, 0)) return kFormatR16G16Snorm;
+                if (pf.m_RGBBitCount == 16 && isBitMask(0x00ff, 0xff00, 0, 0)) return kFormatR8G8Snorm;
+            }
+            else if (pf.m_Flags & kDDSFourCC) {
+                switch (pf.m_FourCC) {
+                    case MakeFourCC('D', 'X', 'T', '1'): return kFormatBC1Unorm;
+                    case MakeFourCC('D', 'X', 'T', '2'):
+                    case MakeFourCC('D', 'X', 'T', '3'): return kFormatBC2Unorm;
+                    case MakeFourCC('D', 'X', 'T', '4'):
+                    case MakeFourCC('D', 'X', 'T', '5'): return kFormatBC3Unorm;
+                    case MakeFourCC('A', 'T', 'I', '1'):
+                    case MakeFourCC('B', 'C', '4', 'U'): return kFormatBC4Unorm;
+                    case MakeFourCC('B', 'C', '4', 'S'): return kFormatBC4Snorm;
+                    case MakeFourCC('A', 'T', 'I', '2'):
+                    case MakeFourCC('B', 'C', '5', 'U'): return kFormatBC5Unorm;
+                    case MakeFourCC('B', 'C', '5', 'S'): return kFormatBC5Snorm;
+                    case MakeFourCC('R', 'G', 'B', 'G'): return kFormatR8G8B8G8Unorm;
+                    case MakeFourCC('G', 'R', 'G', 'B'): return kFormatG8R8G8B8Unorm;
+                    case MakeFourCC('Y', 'U', 'Y', '2'): return kFormatYUY2;
+                    // D3DFORMAT 的枚举值
+                    case 36: return kFormatR16G16B16A16Unorm;
+                    case 110: return kFormatR16G16B16A16Snorm;
+                    case 111: return kFormatR16Float;
+                    case 112: return kFormatR16G16Float;
+                    case 113: return kFormatR16G16B16A16Float;
+                    case 114: return kFormatR32Float;
+                    case 115: return kFormatR32G32Float;
+                    case 116: return kFormatR32G32B32A32Float;
+                    default: break;
+                }
+            }
+            return kFormatUnknown;
+        }
+    }
+
+    bool DDSFile::Open(const std::string& filename, bool forceSRGB)
+    {
+        if (!m_File.Open(filename)) return false;
+        if (!Parse(m_File.GetSpan(), forceSRGB)) {
+            m_File.Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool DDSFile::Parse(std::span<const std::uint8_t> data, bool forceSRGB)
+    {
+        m_Data = {};
+        m_Info = {};
+        m_Subresources.clear();
+
+        if (data.size() < sizeof(std::uint32_t) + sizeof(DDSHeader)) return false;
+
+        std::uint32_t magic{};
+        std::memcpy(&magic, data.data(), sizeof(magic));
+        if (magic != kDDSMagic) return false;
+
+        // 映射的内存不保证对齐，拷贝头部后再读取
+        DDSHeader header{};
+        std::memcpy(&header, data.data() + sizeof(magic), sizeof(header));
+        if (header.m_Size != sizeof(DDSHeader) || header.m_PixelFormat.m_Size != sizeof(DDSPixelFormat)) return false;
+
+        auto& info = m_Info;
+        info.m_Width = header.m_Width;
+        info.m_Height = header.m_Height;
+        info.m_Depth = header.m_Depth;
+        info.m_ArraySize = 1;
+        info.m_MipLevels = (std::max)(header.m_MipMapCount, 1u);
+
+        std::uint64_t dataOffset = sizeof(magic) + sizeof(DDSHeader);
+        if ((header.m_PixelFormat.m_Flags & kDDSFourCC) &&
+            header.m_PixelFormat.m_FourCC == MakeFourCC('D', 'X', '1', '0')) {
+            if (data.size() < dataOffset + sizeof(DDSHeaderDXT10)) return false;
+
+            DDSHeaderDXT10 dx10Header{};
+            std::memcpy(&dx10Header, data.data() + dataOffset, sizeof(dx10Header));
+            dataOffset += sizeof(DDSHeaderDXT10);
+
+            info.m_ArraySize = dx10Header.m_ArraySize;
+            if (info.m_ArraySize == 0) return false;
+            // 平面与调色板格式交给 DDSTextureLoader 处理
+            info.m_Format = dx10Header.m_Format;
+            if (BitsPerPixel(info.m_Format) == 0) return false;
+
+            switch (static_cast<DDSDimension>(dx10Header.m_ResourceDimension)) {
+                case DDSDimension::kTexture1D: {
+                    if ((header.m_Flags & kDDSHeight) && info.m_Height != 1) return false;
+                    info.m_Height = info.m_Depth = 1;
+                    break;
+                }
+                case DDSDimension::kTexture2D: {
+                    if (dx10Header.m_MiscFlag & kMiscTextureCube) {
+                        info.m_ArraySize *= 6;
+                        info.m_IsCubeMap = true;
+                    }
+                    info.m_Depth = 1;
+                    break;
+                }
+                case DDSDimension::kTexture3D: {
+                    if (!(header.m_Flags & kDDSVolume) || info.m_ArraySize > 1) return false;
+                    break;
+                }
+                default: return false;
+            }
+            info.m_Dimension = static_cast<DDSDimension>(dx10Header.m_ResourceDimension);
+        }
+        else {
+            info.m_Format = GetDXGIFormat(header.m_PixelFormat);
+            if (info.m_Format == kFormatUnknown) return false;
+
+            if (header.m_Flags & kDDSVolume) {
+                info.m_Dimension = DDSDimension::kTexture3D;
+            }
+            else {
+                if (header.m_Caps2 & kDDSCubeMap) {
+                    // 需要包含全部六个面
+                    if ((header.m_Caps2 & kDDSCubeMapAllFaces) != kDDSCubeMapAllFaces) return false;
+                    info.m_ArraySize = 6;
+                    info.m_IsCubeMap = true;
+                }
+                info.m_Depth = 1;
+                info.m_Dimension = DDSDimension::kTexture2D;
+            }
+        }
+
+        // 不信任超出硬件限制的头部数据
+        if (info.m_Width == 0 || info.m_Height == 0 || info.m_Depth == 0) return false;
+        if (info.m_MipLevels > sm_MaxMipLevels) return false;
+        // 不能超过完整 mip 链的长度 floor(log2(max(w, h, d))) + 1
+        if (info.m_MipLevels > static_cast<std::uint32_t>(std::bit_width((std::max)({info.m_Width, info.m_Height, info.m_Depth})))) {
+            return false;
+        }
+        if (info.m_Dimension == DDSDimension::kTexture3D) {
+            if (info.m_Width > sm_MaxVolumeDimension || info.m_Height > sm_MaxVolumeDimension ||
+                info.m_Depth > sm_MaxVolumeDimension) return false;
+        }
+        else if (info.m_ArraySize > sm_MaxArraySize || info.m_Width > sm_MaxDimension || info.m_Height > sm_MaxDimension) {
+            return false;
+        }
+
+        if (forceSRGB) {
+            info.m_Format = MakeSRGB(info.m_Format);
+        }
+
+        m_Data = data;
+        if (!BuildSubresourceLayouts(dataOffset)) {
+            m_Data = {};
+            m_Info = {};
+            m_Subresources.clear();
+            return false;
+        }
+        return true;
+    }
+
+    std::span<const std::uint8_t> DDSFile::GetSubresourceData(std::uint32_t index) const
+    {
+        const auto& layout = m_Subresources[index];
+        return m_Data.subspan(layout.m_Offset, layout.m_SliceSize * layout.m_Depth);
+    }
+
+    std::uint64_t DDSFile::ComputeUploadFootprints(
+        std::uint32_t firstSubresource,
+        std::span<DDSUploadFootprint> footprints,
+        std::uint64_t baseOffset) const
+    {
+        bool isBC = IsBlockCompressed(m_Info.m_Format);
+        std::uint64_t offset = AlignUp(baseOffset, sm_PlacementAlignment);
+        std::uint64_t totalSize = 0;
+        for (std::uint32_t i = 0; i < footprints.size(); ++i) {
+            const auto& layout = m_Subresources[firstSubresource + i];
+            auto& footprint = footprints[i];
+
+            footprint.m_Offset = offset;
+            // 块压缩格式的宽高需对齐到块的大小
+            footprint.m_Width = isBC ? static_cast<std::uint32_t>(AlignUp(layout.m_Width, 4)) : layout.m_Width;
+            footprint.m_Height = isBC ? static_cast<std::uint32_t>(AlignUp(layout.m_Height, 4)) : layout.m_Height;
+            footprint.m_Depth = layout.m_Depth;
+            footprint.m_RowPitch = static_cast<std::uint32_t>(AlignUp(layout.m_RowSize, sm_RowPitchAlignment));
+            footprint.m_NumRows = layout.m_NumRows;
+            footprint.m_RowSize = layout.m_RowSize;
+
+            // 最后一行不需要填充到 RowPitch
+            std::uint64_t numRows = std::uint64_t(footprint.m_NumRows) * footprint.m_Depth;
+            std::uint64_t size = footprint.m_RowPitch * (numRows - 1) + footprint.m_RowSize;
+            totalSize = offset + size - baseOffset;
+            offset = AlignUp(offset + size, sm_PlacementAlignment);
+        }
+        return totalSize;
+    }
+
+    void DDSFile::WriteSubresource(std::uint32_t index, const DDSUploadFootprint& footprint, std::uint8_t* dest) const
+    {
+        const auto& layout = m_Subresources[index];
+        const std::uint8_t* src = m_Data.data() + layout.m_Offset;
+        std::uint8_t* dst = dest + footprint.m_Offset;
+
+        // 行宽正好对齐时整块拷贝
+        if (footprint.m_RowPitch == layout.m_RowSize) {
+            std::memcpy(dst, src, layout.m_SliceSize * layout.m_Depth);
+            return;
+        }
+        for (std::uint32_t z = 0; z < layout.m_Depth; ++z) {
+            auto srcSlice = src + layout.m_SliceSize * z;
+            auto dstSlice = dst + std::uint64_t(footprint.m_RowPitch) * footprint.m_NumRows * z;
+            for (std::uint32_t y = 0; y < layout.m_NumRows; ++y) {
+                std::memcpy(dstSlice + std::uint64_t(footprint.m_RowPitch) * y, srcSlice + layout.m_RowSize * y, layout.m_RowSize);
+            }
+        }
+    }
+
+    bool DDSFile::Save(
+        const std::string& filename,
+        const DDSTextureInfo& info,
+        std::span<const std::span<const std::uint8_t>> subresources)
+    {
+        if (info.m_Width == 0 || info.m_Height == 0 || info.m_MipLevels == 0 || info.m_ArraySize == 0) return false;
+        if (info.m_IsCubeMap && info.m_ArraySize % 6 != 0) return false;
+
+        std::uint32_t depth = info.m_Dimension == DDSDimension::kTexture3D ? (std::max)(info.m_Depth, 1u) : 1;
+        std::uint32_t numSubresources = info.m_MipLevels * info.m_ArraySize;
+        if (subresources.size() != numSubresources) return false;
+
+        // 校验每个子资源的大小，避免写出无法读取的文件
+        std::uint64_t topRowSize{};
+        std::uint32_t topNumRows{};
+        for (std::uint32_t i = 0; i < numSubresources; ++i) {
+            std::uint32_t mip = i % info.m_MipLevels;
+            std::uint64_t rowSize{};
+            std::uint32_t numRows{};
+            if (!GetSurfaceInfo((std::max)(info.m_Width >> mip, 1u), (std::max)(info.m_Height >> mip, 1u), info.m_Format, rowSize, numRows)) {
+                return false;
+            }
+            if (subresources[i].size() != rowSize * numRows * (std::max)(depth >> mip, 1u)) return false;
+            if (i == 0) {
+                topRowSize = rowSize;
+                topNumRows = numRows;
+            }
+        }
+
+        DDSHeader header{};
+        header.m_Size = sizeof(DDSHeader);
+        header.m_Flags = kDDSHeaderFlagsTexture | (info.m_MipLevels > 1 ? kDDSHeaderFlagsMipMap : 0);
+        header.m_Width = info.m_Width;
+        header.m_Height = info.m_Height;
+        header.m_Depth = depth;
+        header.m_MipMapCount = info.m_MipLevels;
+        header.m_Caps = kDDSSurfaceFlagsTexture | (info.m_MipLevels > 1 ? kDDSSurfaceFlagsMipMap : 0);
+        if (IsBlockCompressed(info.m_Format)) {
+            header.m_Flags |= kDDSHeaderFlagsLinearSize;
+            header.m_PitchOrLinearSize = static_cast<std::uint32_t>(topRowSize * topNumRows);
+        }
+        else {
+            header.m_PitchOrLinearSize = static_cast<std::uint32_t>(topRowSize);
+        }
+        if (info.m_Dimension == DDSDimension::kTexture3D) {
+            header.m_Flags |= kDDSHeaderFlagsVolume;
+        }
+        if (info.m_IsCubeMap) {
+            header.m_Caps |= kDDSSurfaceFlagsCubeMap;
+            header.m_Caps2 = kDDSCubeMap | kDDSCubeMapAllFaces;
+        }
+        header.m_PixelFormat.m_Size = sizeof(DDSPixelFormat);
+        header.m_PixelFormat.m_Flags = kDDSFourCC;
+        header.m_PixelFormat.m_FourCC = MakeFourCC('D', 'X', '1', '0');
+
+        DDSHeaderDXT10 dx10Header{};
+        dx10Header.m_Format = info.m_Format;
+        dx10Header.m_ResourceDimension = static_cast<std::uint32_t>(
+            info.m_Dimension == DDSDimension::kUnknown ? DDSDimension::kTexture2D : info.m_Dimension);
+        dx10Header.m_MiscFlag = info.m_IsCubeMap ? kMiscTextureCube : 0;
+        dx10Header.m_ArraySize = info.m_IsCubeMap ? info.m_ArraySize / 6 : info.m_ArraySize;
+
+        std::filesystem::path path(reinterpret_cast<const char8_t*>(filename.c_str()));
+        auto tempPath = path;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            file.write(reinterpret_cast<const char*>(&kDDSMagic), sizeof(kDDSMagic));
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(&dx10Header), sizeof(dx10Header));
+            for (const auto& data : subresources) {
+                file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            }
+            if (!file) {
+                file.close();
+                std::error_code ec{};
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec{};
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec) {
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+        return true;
+    }
+
+    std::uint32_t DDSFile::BitsPerPixel(std::uint32_t format) noexcept
+    {
+        switch (format) {
+            case 1: case 2: case 3: case 4:
+                return 128;
+            case 5: case 6: case 7: case 8:
+                return 96;
+            case 9: case 10: case 11: case 12: case 13: case 14: case 15: case 16:
+            case 17: case 18: case 19: case 20: case 21: case 22: case kFormatY416:
+            case kFormatY210: case kFormatY216:
+                return 64;
+            case 23: case 24: case 25: case 26: case 27: case 28: case 29: case 30:
+            case 31: case 32: case 33: case 34: case 35: case 36: case 37: case 38:
+            case 39: case 40: case 41: case 42: case 43: case 44: case 45: case 46:
+            case 47: case 67: case kFormatR8G8B8G8Unorm: case kFormatG8R8G8B8Unorm:
+            case 87: case 88: case 89: case 90: case 91: case 92: case 93:
+            case kFormatAYUV: case kFormatY410: case kFormatYUY2:
+                return 32;
+            case 48: case 49: case 50: case 51: case 52: case 53: case 54: case 55:
+            case 56: case 57: case 58: case 59: case 85: case 86: case kFormatB4G4R4A4Unorm:
+                return 16;
+            case 60: case 61: case 62: case 63: case 64: case 65:
+            case 73: case 74: case 75: case 76: case 77: case 78: case 82: case 83:
+            case 84: case 94: case 95: case 96: case 97: case 98: case 99:
+                return 8;
+            case kFormatR1Unorm:
+                return 1;
+            case 70: case 71: case 72: case 79: case 80: case 81:
+                return 4;
+            // 平面、调色板等格式不支持
+            default:
+                return 0;
+        }
+    }
+
+    bool DDSFile::IsBlockCompressed(std::uint32_t format) noexcept
+    {
+        return (format >= kFormatBC1Typeless && format <= kFormatBC5Snorm) ||
+            (format >= kFormatBC6HTypeless && format <= kFormatBC7UnormSRGB);
+    }
+
+    std::uint32_t DDSFile::MakeSRGB(std::uint32_t format) noexcept
+    {
+        switch (format) {
+            case kFormatR8G8B8A8Unorm: return kFormatR8G8B8A8UnormSRGB;
+            case kFormatBC1Unorm: return kFormatBC1UnormSRGB;
+            case kFormatBC2Unorm: return kFormatBC2UnormSRGB;
+            case kFormatBC3Unorm: return kFormatBC3UnormSRGB;
+            case kFormatB8G8R8A8Unorm: return kFormatB8G8R8A8UnormSRGB;
+            case kFormatB8G8R8X8Unorm: return kFormatB8G8R8X8UnormSRGB;
+            case kFormatBC7Unorm: return kFormatBC7UnormSRGB;
+            default: return format;
+        }
+    }
+
+    bool DDSFile::GetSurfaceInfo(
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t format,
+        std::uint64_t& rowSize,
+        std::uint32_t& numRows) noexcept
+    {
+        auto bpp = BitsPerPixel(format);
+        if (bpp == 0) return false;
+
+        if (IsBlockCompressed(format)) {
+            // BC1 与 BC4 每块 8 字节，其余 16 字节
+            std::uint64_t blockSize = bpp == 4 ? 8 : 16;
+            rowSize = (std::max)(1u, (width + 3) / 4) * blockSize;
+            numRows = (std::max)(1u, (height + 3) / 4);
+        }
+        else if (IsPacked(format)) {
+            // 每两个像素共用一个 bpp 大小的元素
+            rowSize = ((std::uint64_t(width) + 1) >> 1) * (bpp / 8);
+            numRows = height;
+        }
+        else {
+            rowSize = (std::uint64_t(width) * bpp + 7) / 8;
+            numRows = height;
+        }
+        return true;
+    }
+
+    bool DDSFile::BuildSubresourceLayouts(std::uint64_t dataOffset)
+    {
+        const auto& info = m_Info;
+
+        // 像素数据的大小需正好是数组大小个 mip 链，在按头部的数量分配之前检查
+        std::uint64_t chainSize = 0;
+        for (std::uint32_t mip = 0; mip < info.m_MipLevels; ++mip) {
+            std::uint64_t rowSize{};
+            std::uint32_t numRows{};
+            if (!GetSurfaceInfo((std::max)(info.m_Width >> mip, 1u), (std::max)(info.m_Height >> mip, 1u),
+                info.m_Format, rowSize, numRows)) return false;
+            chainSize += rowSize * numRows * (std::max)(info.m_Depth >> mip, 1u);
+        }
+        if (dataOffset > m_Data.size() || chainSize == 0) return false;
+        auto dataSize = m_Data.size() - dataOffset;
+        if (dataSize % chainSize != 0 || dataSize / chainSize != info.m_ArraySize) return false;
+
+        m_Subresources.reserve(std::size_t(info.m_ArraySize) * info.m_MipLevels);
+
+        // 文件中按数组元素依次存放其所有的 mip
+        std::uint64_t offset = dataOffset;
+        for (std::uint32_t slice = 0; slice < info.m_ArraySize; ++slice) {
+            std::uint32_t width = info.m_Width;
+            std::uint32_t height = info.m_Height;
+            std::uint32_t depth = info.m_Depth;
+            for (std::uint32_t mip = 0; mip < info.m_MipLevels; ++mip) {
+                DDSSubresourceLayout layout{};
+                if (!GetSurfaceInfo(width, height, info.m_Format, layout.m_RowSize, layout.m_NumRows)) return false;
+                layout.m_Offset = offset;
+                layout.m_SliceSize = layout.m_RowSize * layout.m_NumRows;
+                layout.m_Width = width;
+                layout.m_Height = height;
+                layout.m_Depth = depth;
+
+                offset += layout.m_SliceSize * depth;
+                if (offset > m_Data.size()) return false;
+                m_Subresources.push_back(layout);
+
+                width = (std::max)(width >> 1, 1u);
+                height = (std::max)(height >> 1, 1u);
+                depth = (std::max)(depth >> 1, 1u);
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#ifndef __DDSFILE_H__
+#define __DDSFILE_H__
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+namespace DSM {
+    // 数值与 D3D12_RESOURCE_DIMENSION 一致
+    enum class DDSDimension : std::uint32_t
+    {
+        kUnknown = 0,
+        kTexture1D = 2,
+        kTexture2D = 3,
+        kTexture3D = 4
+    };
+
+    struct DDSTextureInfo
+    {
+        std::uint32_t m_Width{};
+        std::uint32_t m_Height{};
+        std::uint32_t m_Depth{};
+        // 立方体贴图已乘上 6 个面
+        std::uint32_t m_ArraySize{};
+        std::uint32_t m_MipLevels{};
+        // DXGI_FORMAT 的数值
+        std::uint32_t m_Format{};
+        DDSDimension m_Dimension = DDSDimension::kUnknown;
+        bool m_IsCubeMap = false;
+    };
+
+    // 子资源在文件中的布局，行之间紧密排列
+    struct DDSSubresourceLayout
+    {
+        std::uint64_t m_Offset{};
+        std::uint64_t m_RowSize{};
+        std::uint64_t m_SliceSize{};
+        std::uint32_t m_NumRows{};
+        std::uint32_t m_Width{};
+        std::uint32_t m_Height{};
+        std::uint32_t m_Depth{};
+    };
+
+    // 子资源在上传缓冲中的布局，与 GetCopyableFootprints 的结果一致
+    struct DDSUploadFootprint
+    {
+        std::uint64_t m_Offset{};
+        std::uint32_t m_Width{};
+        std::uint32_t m_Height{};
+        std::uint32_t m_Depth{};
+        std::uint32_t m_RowPitch{};
+        std::uint32_t m_NumRows{};
+        std::uint64_t m_RowSize{};
+    };
+
+    // 就地解析 DDS 文件的头部，像素数据直接从映射的内存中读取，不依赖 D3D12
+    class DDSFile
+    {
+    public:
+        // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+        inline static constexpr std::uint32_t sm_RowPitchAlignment = 256;
+        // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+        inline static constexpr std::uint32_t sm_PlacementAlignment = 512;
+        // D3D12_REQ_MIP_LEVELS
+        inline static constexpr std::uint32_t sm_MaxMipLevels = 15;
+        // D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+        inline static constexpr std::uint32_t sm_MaxArraySize = 2048;
+        // D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION
+        inline static constexpr std::uint32_t sm_MaxDimension = 16384;
+        // D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION
+        inline static constexpr std::uint32_t sm_MaxVolumeDimension = 2048;
+
+        DDSFile() = default;
+        DDSFile(const DDSFile&) = delete;
+        DDSFile& operator=(const DDSFile&) = delete;
+
+        // 映射文件并解析，文件在 DDSFile 销毁前保持映射
+        bool Open(const std::string& filename, bool forceSRGB = false);
+        // 解析外部的数据，data 需在使用期间保持有效
+        // 头部的 mip 数超过完整 mip 链，或像素数据大小与头部描述的子资源总和不一致时解析失败
+        bool Parse(std::span<const std::uint8_t> data, bool forceSRGB = false);
+
+        const DDSTextureInfo& GetInfo() const noexcept { return m_Info; }
+        std::uint32_t GetNumSubresources() const noexcept { return static_cast<std::uint32_t>(m_Subresources.size()); }
+        // 子资源索引为 mip + arraySlice * mipLevels
+        const DDSSubresourceLayout& GetSubresourceLayout(std::uint32_t index) const { return m_Subresources[index]; }
+        std::span<const std::uint8_t> GetSubresourceData(std::uint32_t index) const;
+
+        // 计算 [first, first + num) 的子资源在上传缓冲中的布局，返回所需的缓冲大小
+        std::uint64_t ComputeUploadFootprints(
+            std::uint32_t firstSubresource,
+            std::span<DDSUploadFootprint> footprints,
+            std::uint64_t baseOffset = 0) const;
+        // 将子资源逐行写入上传缓冲，dest 为上传缓冲的起始地址
+        void WriteSubresource(std::uint32_t index, const DDSUploadFootprint& footprint, std::uint8_t* dest) const;
+
+        // 以 DX10 头部写出 DDS 文件，subresources 按 mip + arraySlice * mipLevels 排列且行之间紧密排列
+        // 先写入临时文件再重命名，避免读到写了一半的文件
+        static bool Save(
+            const std::string& filename,
+            const DDSTextureInfo& info,
+            std::span<const std::span<const std::uint8_t>> subresources);
+
+        static std::uint32_t BitsPerPixel(std::uint32_t format) noexcept;
+        static bool IsBlockCompressed(std::uint32_t format) noexcept;
+        static std::uint32_t MakeSRGB(std::uint32_t format) noexcept;
+        // 计算一个 mip 的行字节数与行数，块压缩格式按 4x4 的块计算
+        static bool GetSurfaceInfo(
+            std::uint32_t width,
+            std::uint32_t height,
+            std::uint32_t format,
+            std::uint64_t& rowSize,
+            std::uint32_t& numRows) noexcept;
+
+    private:
+        bool BuildSubresourceLayouts(std::uint64_t dataOffset);
+
+    private:
+        MappedFile m_File{};
+        std::span<const std::uint8_t> m_Data{};
+        DDSTextureInfo m_Info{};
+        std::vector<DDSSubresourceLayout> m_Subresources{};
+    };
+}
+
+#endif
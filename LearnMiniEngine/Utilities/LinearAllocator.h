@@ -11,7 +11,7 @@ namespace DSM {
     {
     public:
         LinearAllocator(std::uint64_t maxSize, std::uint64_t startOffset = 0)
-            :m_MaxSize(maxSize), m_StartOffset(startOffset){}
+            :m_MaxSize(maxSize), m_StartOffset(startOffset), m_CurrOffset(startOffset){}
         ~LinearAllocator() = default;
 
         // 返回分配的资源所处的偏移量
@@ -29,7 +29,7 @@ namespace DSM {
         bool Full() const noexcept { return m_CurrOffset >= m_MaxSize; }
         bool Empty() const noexcept { return m_CurrOffset == m_StartOffset; }
         std::uint64_t MaxSize() const noexcept { return m_MaxSize; }
-        std::uint64_t UsedSize() const noexcept { return m_CurrOffset; }
+        std::uint64_t UsedSize() const noexcept { return m_CurrOffset - m_StartOffset; }
         
     private:
         const std::uint64_t m_MaxSize{};      // 最大容量
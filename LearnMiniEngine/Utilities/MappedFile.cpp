@@ -0,0 +1,124 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DSM {
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            Close();
+            m_Data = std::exchange(other.m_Data, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+#ifdef _WIN32
+            m_FileHandle = std::exchange(other.m_FileHandle, nullptr);
+            m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+#else
+            m_FileDescriptor = std::exchange(other.m_FileDescriptor, -1);
+#endif
+        }
+        return *this;
+    }
+
+    bool MappedFile::Open(const std::string& filename)
+    {
+        Close();
+
+#ifdef _WIN32
+        int wideLength = MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, nullptr, 0);
+        if (wideLength <= 0) return false;
+        std::wstring wFilename(wideLength, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, wFilename.data(), wideLength);
+
+        HANDLE file = CreateFileW(wFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        m_FileHandle = file;
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            Close();
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            Close();
+            return false;
+        }
+        m_MappingHandle = mapping;
+
+        auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr) {
+            Close();
+            return false;
+        }
+        m_Data = static_cast<const std::uint8_t*>(data);
+        m_Size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        m_FileDescriptor = fd;
+
+        struct stat fileStat{};
+        if (::fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+            Close();
+            return false;
+        }
+
+        auto size = static_cast<std::size_t>(fileStat.st_size);
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            Close();
+            return false;
+        }
+        // 数据按顺序读取一次
+        ::madvise(data, size, MADV_SEQUENTIAL);
+        m_Data = static_cast<const std::uint8_t*>(data);
+        m_Size = size;
+#endif
+        return true;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+#ifdef _WIN32
+        if (m_Data != nullptr) {
+            UnmapViewOfFile(m_Data);
+        }
+        if (m_MappingHandle != nullptr) {
+            CloseHandle(m_MappingHandle);
+        }
+        if (m_FileHandle != nullptr) {
+            CloseHandle(m_FileHandle);
+        }
+        m_MappingHandle = nullptr;
+        m_FileHandle = nullptr;
+#else
+        if (m_Data != nullptr) {
+            ::munmap(const_cast<std::uint8_t*>(m_Data), m_Size);
+        }
+        if (m_FileDescriptor >= 0) {
+            ::close(m_FileDescriptor);
+        }
+        m_FileDescriptor = -1;
+#endif
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+}
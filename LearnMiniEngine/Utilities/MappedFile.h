@@ -0,0 +1,44 @@
+#pragma once
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace DSM {
+    // 只读的内存映射文件，Windows 下使用 CreateFileMapping，其余平台使用 mmap
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& filename) { Open(filename); }
+        ~MappedFile() { Close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // filename 为 UTF-8 编码
+        bool Open(const std::string& filename);
+        void Close() noexcept;
+
+        bool IsOpen() const noexcept { return m_Data != nullptr; }
+        const std::uint8_t* GetData() const noexcept { return m_Data; }
+        std::size_t GetSize() const noexcept { return m_Size; }
+        std::span<const std::uint8_t> GetSpan() const noexcept { return {m_Data, m_Size}; }
+
+    private:
+        const std::uint8_t* m_Data{};
+        std::size_t m_Size{};
+#ifdef _WIN32
+        void* m_FileHandle{};
+        void* m_MappingHandle{};
+#else
+        int m_FileDescriptor = -1;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,327 @@
+#include "MipGenerator.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define DSM_MIP_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace DSM {
+    namespace {
+        constexpr float kPi = 3.14159265358979f;
+        // Kaiser 滤波器的半宽(以目标像素为单位)与形状参数
+        constexpr float kKaiserWidth = 1.5f;
+        constexpr float kKaiserAlpha = 4.0f;
+        // 小于该像素数的级别不再多线程处理
+        constexpr std::uint64_t kMinPixelsPerThread = 0x4000;
+        constexpr std::uint32_t kLinearToSRGBTableSize = 0x4000;
+
+        // 每个目标像素在一个轴上的采样位置与权重，边缘的采样位置已被钳制
+        struct FilterTaps
+        {
+            std::uint32_t m_NumTaps{};
+            std::vector<std::uint32_t> m_Indices{};
+            std::vector<float> m_Weights{};
+        };
+
+        float BesselI0(float x) noexcept
+        {
+            // 级数展开
+            float sum = 1.0f;
+            float term = 1.0f;
+            float halfX = x * 0.5f;
+            for (int k = 1; k < 32; ++k) {
+                term *= (halfX / k) * (halfX / k);
+                sum += term;
+                if (term < sum * 1e-8f) break;
+            }
+            return sum;
+        }
+
+        float KaiserSinc(float t) noexcept
+        {
+            if (std::abs(t) >= kKaiserWidth) return 0.0f;
+            float sinc = std::abs(t) < 1e-6f ? 1.0f : std::sin(kPi * t) / (kPi * t);
+            float ratio = t / kKaiserWidth;
+            return sinc * BesselI0(kKaiserAlpha * std::sqrt(1.0f - ratio * ratio)) / BesselI0(kKaiserAlpha);
+        }
+
+        FilterTaps BuildFilterTaps(std::uint32_t srcSize, std::uint32_t dstSize, MipFilter filter)
+        {
+            FilterTaps taps{};
+            double scale = static_cast<double>(srcSize) / dstSize;
+            std::vector<std::vector<std::pair<std::int64_t, float>>> pixelTaps(dstSize);
+
+            for (std::uint32_t x = 0; x < dstSize; ++x) {
+                auto& pixel = pixelTaps[x];
+                if (filter == MipFilter::kBox) {
+                    // 源像素与目标像素覆盖范围的重叠面积
+                    double begin = x * scale;
+                    double end = (x + 1) * scale;
+                    for (auto i = static_cast<std::int64_t>(std::floor(begin)); i < static_cast<std::int64_t>(std::ceil(end)); ++i) {
+                        double overlap = (std::min)(end, double(i + 1)) - (std::max)(begin, double(i));
+                        if (overlap > 0) pixel.emplace_back(i, static_cast<float>(overlap));
+                    }
+                }
+                else {
+                    double center = (x + 0.5) * scale;
+                    double radius = kKaiserWidth * scale;
+                    for (auto i = static_cast<std::int64_t>(std::floor(center - radius)); i <= static_cast<std::int64_t>(std::ceil(center + radius)); ++i) {
+                        float weight = KaiserSinc(static_cast<float>((i + 0.5 - center) / scale));
+                        if (weight != 0.0f) pixel.emplace_back(i, weight);
+                    }
+                }
+
+                float sum = 0;
+                for (const auto& [index, weight] : pixel) sum += weight;
+                for (auto& [index, weight] : pixel) weight /= sum;
+                taps.m_NumTaps = (std::max)(taps.m_NumTaps, static_cast<std::uint32_t>(pixel.size()));
+            }
+
+            // 统一的步长，不足的部分权重为 0
+            taps.m_Indices.assign(std::size_t(dstSize) * taps.m_NumTaps, 0);
+            taps.m_Weights.assign(std::size_t(dstSize) * taps.m_NumTaps, 0.0f);
+            for (std::uint32_t x = 0; x < dstSize; ++x) {
+                for (std::size_t k = 0; k < pixelTaps[x].size(); ++k) {
+                    auto [index, weight] = pixelTaps[x][k];
+                    taps.m_Indices[x * taps.m_NumTaps + k] = static_cast<std::uint32_t>(std::clamp<std::int64_t>(index, 0, srcSize - 1));
+                    taps.m_Weights[x * taps.m_NumTaps + k] = weight;
+                }
+            }
+            return taps;
+        }
+
+        const std::array<float, 256>& GetSRGBToLinearTable()
+        {
+            static const auto table = [] {
+                std::array<float, 256> table{};
+                for (int i = 0; i < 256; ++i) {
+                    float c = i / 255.0f;
+                    table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return table;
+            }();
+            return table;
+        }
+
+        const std::vector<std::uint8_t>& GetLinearToSRGBTable()
+        {
+            static const auto table = [] {
+                std::vector<std::uint8_t> table(kLinearToSRGBTableSize);
+                for (std::uint32_t i = 0; i < kLinearToSRGBTableSize; ++i) {
+                    float c = (i + 0.5f) / kLinearToSRGBTableSize;
+                    float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                    table[i] = static_cast<std::uint8_t>(std::clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+                }
+                return table;
+            }();
+            return table;
+        }
+
+        // 将一行像素解码为线性空间的 RGBA 浮点数
+        void DecodeRow(const std::uint8_t* src, std::uint32_t width, MipPixelFormat format, float* dst)
+        {
+            switch (format) {
+                case MipPixelFormat::kRGBA8Unorm: {
+                    for (std::uint32_t i = 0; i < width * 4; ++i) {
+                        dst[i] = src[i] * (1.0f / 255.0f);
+                    }
+                    break;
+                }
+                case MipPixelFormat::kRGBA8UnormSRGB: {
+                    const auto& table = GetSRGBToLinearTable();
+                    for (std::uint32_t i = 0; i < width; ++i) {
+                        dst[i * 4 + 0] = table[src[i * 4 + 0]];
+                        dst[i * 4 + 1] = table[src[i * 4 + 1]];
+                        dst[i * 4 + 2] = table[src[i * 4 + 2]];
+                        dst[i * 4 + 3] = src[i * 4 + 3] * (1.0f / 255.0f);
+                    }
+                    break;
+                }
+                case MipPixelFormat::kRGBA32Float: {
+                    std::memcpy(dst, src, std::size_t(width) * 4 * sizeof(float));
+                    break;
+                }
+            }
+        }
+
+        void EncodeRow(const float* src, std::uint32_t width, MipPixelFormat format, std::uint8_t* dst)
+        {
+            switch (format) {
+                case MipPixelFormat::kRGBA8Unorm: {
+                    for (std::uint32_t i = 0; i < width * 4; ++i) {
+                        dst[i] = static_cast<std::uint8_t>(std::clamp(src[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+                    }
+                    break;
+                }
+                case MipPixelFormat::kRGBA8UnormSRGB: {
+                    const auto& table = GetLinearToSRGBTable();
+                    auto toSRGB = [&table](float c) {
+                        auto index = static_cast<std::uint32_t>(std::clamp(c, 0.0f, 1.0f) * (kLinearToSRGBTableSize - 1) + 0.5f);
+                        return table[index];
+                    };
+                    for (std::uint32_t i = 0; i < width; ++i) {
+                        dst[i * 4 + 0] = toSRGB(src[i * 4 + 0]);
+                        dst[i * 4 + 1] = toSRGB(src[i * 4 + 1]);
+                        dst[i * 4 + 2] = toSRGB(src[i * 4 + 2]);
+                        dst[i * 4 + 3] = static_cast<std::uint8_t>(std::clamp(src[i * 4 + 3], 0.0f, 1.0f) * 255.0f + 0.5f);
+                    }
+                    break;
+                }
+                case MipPixelFormat::kRGBA32Float: {
+                    std::memcpy(dst, src, std::size_t(width) * 4 * sizeof(float));
+                    break;
+                }
+            }
+        }
+
+        // 水平方向滤波，每个像素的四个通道作为一个向量处理
+        void FilterRow(const float* src, const FilterTaps& taps, std::uint32_t dstWidth, float* dst)
+        {
+            const auto numTaps = taps.m_NumTaps;
+            const auto* indices = taps.m_Indices.data();
+            const auto* weights = taps.m_Weights.data();
+            for (std::uint32_t x = 0; x < dstWidth; ++x) {
+#ifdef DSM_MIP_SSE
+                __m128 sum = _mm_setzero_ps();
+                for (std::uint32_t k = 0; k < numTaps; ++k) {
+                    __m128 pixel = _mm_loadu_ps(src + std::size_t(indices[k]) * 4);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(pixel, _mm_set1_ps(weights[k])));
+                }
+                _mm_storeu_ps(dst + std::size_t(x) * 4, sum);
+#else
+                float sum[4]{};
+                for (std::uint32_t k = 0; k < numTaps; ++k) {
+                    const float* pixel = src + std::size_t(indices[k]) * 4;
+                    for (int c = 0; c < 4; ++c) sum[c] += pixel[c] * weights[k];
+                }
+                std::memcpy(dst + std::size_t(x) * 4, sum, sizeof(sum));
+#endif
+                indices += numTaps;
+                weights += numTaps;
+            }
+        }
+    }
+
+    bool MipChain::Generate(
+        const void* data,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint64_t rowPitch,
+        MipPixelFormat format,
+        MipFilter filter,
+        std::uint32_t maxLevels,
+        std::uint32_t numThreads)
+    {
+        m_Levels.clear();
+        m_Data.clear();
+        if (data == nullptr || width == 0 || height == 0) return false;
+
+        m_Format = format;
+        auto bytesPerPixel = GetBytesPerPixel(format);
+        auto numLevels = CountMipLevels(width, height);
+        if (maxLevels != 0) numLevels = (std::min)(numLevels, maxLevels);
+        if (numThreads == 0) numThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+        // 所有级别紧密排列在同一块内存中
+        std::uint64_t dataSize = 0;
+        m_Levels.resize(numLevels);
+        for (std::uint32_t i = 0; i < numLevels; ++i) {
+            auto& level = m_Levels[i];
+            level.m_Width = (std::max)(width >> i, 1u);
+            level.m_Height = (std::max)(height >> i, 1u);
+            level.m_RowPitch = std::uint64_t(level.m_Width) * bytesPerPixel;
+            level.m_Offset = dataSize;
+            dataSize += level.m_RowPitch * level.m_Height;
+        }
+        m_Data.resize(dataSize);
+
+        if (rowPitch == 0) rowPitch = m_Levels[0].m_RowPitch;
+        auto srcData = static_cast<const std::uint8_t*>(data);
+        for (std::uint32_t y = 0; y < height; ++y) {
+            std::memcpy(GetLevelData(0) + m_Levels[0].m_RowPitch * y, srcData + rowPitch * y, m_Levels[0].m_RowPitch);
+        }
+
+        for (std::uint32_t i = 1; i < numLevels; ++i) {
+            const auto& src = m_Levels[i - 1];
+            const auto& dst = m_Levels[i];
+            Downsample(
+                GetLevelData(i - 1), src.m_Width, src.m_Height, src.m_RowPitch,
+                GetLevelData(i), dst.m_Width, dst.m_Height, dst.m_RowPitch,
+                format, filter, numThreads);
+        }
+        return true;
+    }
+
+    std::uint32_t MipChain::CountMipLevels(std::uint32_t width, std::uint32_t height) noexcept
+    {
+        std::uint32_t count = 1;
+        while (width > 1 || height > 1) {
+            width >>= 1;
+            height >>= 1;
+            ++count;
+        }
+        return count;
+    }
+
+    std::uint32_t MipChain::GetBytesPerPixel(MipPixelFormat format) noexcept
+    {
+        return format == MipPixelFormat::kRGBA32Float ? 16 : 4;
+    }
+
+    void MipChain::Downsample(
+        const std::uint8_t* src, std::uint32_t srcWidth, std::uint32_t srcHeight, std::uint64_t srcRowPitch,
+        std::uint8_t* dst, std::uint32_t dstWidth, std::uint32_t dstHeight, std::uint64_t dstRowPitch,
+        MipPixelFormat format,
+        MipFilter filter,
+        std::uint32_t numThreads)
+    {
+        auto horizontalTaps = BuildFilterTaps(srcWidth, dstWidth, filter);
+        auto verticalTaps = BuildFilterTaps(srcHeight, dstHeight, filter);
+
+        auto numPixels = std::uint64_t(dstWidth) * dstHeight;
+        auto maxThreads = static_cast<std::uint32_t>((std::max<std::uint64_t>)(numPixels / kMinPixelsPerThread, 1));
+        numThreads = (std::min)(numThreads, maxThreads);
+
+        Utility::ParallelFor(dstHeight, numThreads, [&](std::uint32_t beginRow, std::uint32_t endRow) {
+            // 缓存水平滤波后的源行，相邻目标行的垂直采样会重叠
+            const auto numCacheRows = (std::max)(verticalTaps.m_NumTaps, 1u);
+            const auto filteredSize = std::size_t(dstWidth) * 4;
+            std::vector<float> srcRow(std::size_t(srcWidth) * 4);
+            std::vector<float> filteredRows(filteredSize * numCacheRows);
+            std::vector<std::uint32_t> cachedRows(numCacheRows, ~0u);
+            std::uint32_t nextCacheRow = 0;
+            auto getFilteredRow = [&](std::uint32_t srcY) {
+                for (std::uint32_t i = 0; i < numCacheRows; ++i) {
+                    if (cachedRows[i] == srcY) return filteredRows.data() + filteredSize * i;
+                }
+                auto slot = nextCacheRow;
+                nextCacheRow = (nextCacheRow + 1) % numCacheRows;
+                cachedRows[slot] = srcY;
+                auto filtered = filteredRows.data() + filteredSize * slot;
+                DecodeRow(src + srcRowPitch * srcY, srcWidth, format, srcRow.data());
+                FilterRow(srcRow.data(), horizontalTaps, dstWidth, filtered);
+                return filtered;
+            };
+
+            std::vector<float> dstRow(filteredSize);
+            for (std::uint32_t y = beginRow; y < endRow; ++y) {
+                std::fill(dstRow.begin(), dstRow.end(), 0.0f);
+                for (std::uint32_t k = 0; k < verticalTaps.m_NumTaps; ++k) {
+                    float weight = verticalTaps.m_Weights[y * verticalTaps.m_NumTaps + k];
+                    if (weight == 0.0f) continue;
+                    const float* filtered = getFilteredRow(verticalTaps.m_Indices[y * verticalTaps.m_NumTaps + k]);
+                    for (std::size_t i = 0; i < filteredSize; ++i) {
+                        dstRow[i] += filtered[i] * weight;
+                    }
+                }
+                EncodeRow(dstRow.data(), dstWidth, format, dst + dstRowPitch * y);
+            }
+        });
+    }
+}
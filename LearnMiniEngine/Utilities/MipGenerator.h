@@ -0,0 +1,75 @@
+#pragma once
+#ifndef __MIPGENERATOR_H__
+#define __MIPGENERATOR_H__
+
+#include <cstdint>
+#include <vector>
+
+namespace DSM {
+    enum class MipPixelFormat
+    {
+        kRGBA8Unorm,
+        // 在线性空间中滤波，alpha 保持线性
+        kRGBA8UnormSRGB,
+        kRGBA32Float
+    };
+
+    enum class MipFilter
+    {
+        // 按面积平均，奇数尺寸时也能保证每个像素的权重正确
+        kBox,
+        // Kaiser 窗口的 sinc 滤波，更锐利
+        kKaiser
+    };
+
+    struct MipLevel
+    {
+        std::uint32_t m_Width{};
+        std::uint32_t m_Height{};
+        std::uint64_t m_RowPitch{};
+        std::uint64_t m_Offset{};
+    };
+
+    // 在 CPU 上生成完整的 mip 链，每一级由上一级滤波得到
+    class MipChain
+    {
+    public:
+        MipChain() = default;
+
+        // rowPitch 为 0 时视为紧密排列，maxLevels 为 0 时生成到 1x1，numThreads 为 0 时使用全部硬件线程
+        bool Generate(
+            const void* data,
+            std::uint32_t width,
+            std::uint32_t height,
+            std::uint64_t rowPitch,
+            MipPixelFormat format,
+            MipFilter filter = MipFilter::kBox,
+            std::uint32_t maxLevels = 0,
+            std::uint32_t numThreads = 0);
+
+        std::uint32_t GetNumLevels() const noexcept { return static_cast<std::uint32_t>(m_Levels.size()); }
+        const MipLevel& GetLevel(std::uint32_t level) const { return m_Levels[level]; }
+        const std::uint8_t* GetLevelData(std::uint32_t level) const { return m_Data.data() + m_Levels[level].m_Offset; }
+        std::uint8_t* GetLevelData(std::uint32_t level) { return m_Data.data() + m_Levels[level].m_Offset; }
+        MipPixelFormat GetFormat() const noexcept { return m_Format; }
+        std::uint64_t GetDataSize() const noexcept { return m_Data.size(); }
+
+        static std::uint32_t CountMipLevels(std::uint32_t width, std::uint32_t height) noexcept;
+        static std::uint32_t GetBytesPerPixel(MipPixelFormat format) noexcept;
+
+        // 由上一级生成下一级，dst 的尺寸决定缩放比例
+        static void Downsample(
+            const std::uint8_t* src, std::uint32_t srcWidth, std::uint32_t srcHeight, std::uint64_t srcRowPitch,
+            std::uint8_t* dst, std::uint32_t dstWidth, std::uint32_t dstHeight, std::uint64_t dstRowPitch,
+            MipPixelFormat format,
+            MipFilter filter,
+            std::uint32_t numThreads);
+
+    private:
+        MipPixelFormat m_Format = MipPixelFormat::kRGBA8Unorm;
+        std::vector<MipLevel> m_Levels{};
+        std::vector<std::uint8_t> m_Data{};
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+#ifndef __PARALLELFOR_H__
+#define __PARALLELFOR_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace DSM::Utility {
+    // 将 [0, count) 平均分配给若干线程，func 的参数为 (begin, end)，调用线程处理第一段
+    template <typename Func>
+    void ParallelFor(std::uint32_t count, std::uint32_t numThreads, Func&& func)
+    {
+        if (numThreads == 0) numThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+        numThreads = std::clamp(numThreads, 1u, (std::max)(count, 1u));
+        if (numThreads == 1) {
+            func(0u, count);
+            return;
+        }
+
+        std::vector<std::thread> threads{};
+        threads.reserve(numThreads - 1);
+        std::uint32_t chunk = (count + numThreads - 1) / numThreads;
+        for (std::uint32_t i = 1; i < numThreads; ++i) {
+            std::uint32_t begin = (std::min)(i * chunk, count);
+            std::uint32_t end = (std::min)(begin + chunk, count);
+            if (begin < end) threads.emplace_back(func, begin, end);
+        }
+        func(0u, (std::min)(chunk, count));
+        for (auto& thread : threads) thread.join();
+    }
+}
+
+#endif
@@ -3,10 +3,13 @@
 #define  __CONSTANTDATA_H__
 
 #include "Math/Matrix.h"
+#include "Renderer/ClusteredLightCuller.h"
+#include "Renderer/CascadedShadowMap.h"
 
 
 namespace DSM {
-    __declspec(align(256)) struct MeshConstants
+    // 每个实例的变换，保存在 GPU 场景的实例表中，着色器按 SV_InstanceID 读取实例的行
+    struct MeshInstanceData
     {
         Math::Matrix4 m_World{};
         Math::Matrix4 m_WorldIT{};
@@ -28,10 +31,15 @@ namespace DSM {
         Math::Matrix4 m_ViewInv{};
         Math::Matrix4 m_Proj{};
         Math::Matrix4 m_ProjInv{};
+        // 世界空间到级联 0 的阴影贴图，其他级联由 m_Shadows 中的偏移与缩放换算
         Math::Matrix4 m_ShadowTrans{};
         float m_CameraPos[3] = { 0,0,0 };
         float m_TotalTime;
         float m_DeltaTime;
+        // 着色器中的结构体从 16 字节边界开始
+        float m_Pad0[3];
+        ClusterGridConstants m_Clusters{};
+        ShadowCascadeConstants m_Shadows{};
     };
 }
 
@@ -1,4 +1,5 @@
 #include "Geometry.h"
+#include "Utilities/ParallelFor.h"
 #include <array>
 #include <cmath>
 #include <algorithm>
@@ -7,6 +8,65 @@ using namespace DirectX;
 
 namespace DSM {
 	namespace Geometry {
+		namespace {
+			// 顶点共享之后 8 级的 Geosphere 约有 65 万个顶点，超过 65536 个顶点时只能使用 32 位索引
+			constexpr std::uint32_t kMaxSubdivision = 8;
+			// 顶点较少时创建线程的开销大于生成的时间
+			constexpr std::size_t kMinParallelVertices = 1 << 16;
+
+			template <typename Func>
+			void ParallelRows(std::uint32_t numRows, std::size_t numVertices, Func&& func)
+			{
+				Utility::ParallelFor(numRows, numVertices >= kMinParallelVertices ? 0u : 1u, func);
+			}
+
+			// 开放寻址的边表，键为排序后的两个端点，值为中点的顶点序号
+			// 容量大于边数的上限 3T，封闭网格的边约为 1.5T，负载不超过一半
+			class EdgeMidpointMap
+			{
+			public:
+				explicit EdgeMidpointMap(std::size_t maxEdges)
+				{
+					std::size_t capacity = 16;
+					m_Shift = 60;
+					while (capacity <= maxEdges) {
+						capacity <<= 1;
+						--m_Shift;
+					}
+					m_Keys.assign(capacity, kEmptyKey);
+					m_Values.resize(capacity);
+				}
+
+				// 边不存在时以 newValue 插入，返回边的值
+				std::uint32_t FindOrAdd(std::uint32_t v0, std::uint32_t v1, std::uint32_t newValue, bool& added) noexcept
+				{
+					std::uint64_t key = v0 < v1 ? (std::uint64_t(v0) << 32 | v1) : (std::uint64_t(v1) << 32 | v0);
+					std::size_t mask = m_Keys.size() - 1;
+					std::size_t slot = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> m_Shift);
+					while (true) {
+						if (m_Keys[slot] == key) {
+							added = false;
+							return m_Values[slot];
+						}
+						if (m_Keys[slot] == kEmptyKey) {
+							m_Keys[slot] = key;
+							m_Values[slot] = newValue;
+							added = true;
+							return newValue;
+						}
+						slot = (slot + 1) & mask;
+					}
+				}
+
+			private:
+				static constexpr std::uint64_t kEmptyKey = ~0ull;
+
+				std::vector<std::uint64_t> m_Keys{};
+				std::vector<std::uint32_t> m_Values{};
+				int m_Shift = 0;
+			};
+		}
+
 		GeometryMesh GeometryGenerator::CreateBox(
 			float width,
 			float height,
@@ -14,8 +74,7 @@ namespace DSM {
 			std::uint32_t subdivision) noexcept
 		{
 			GeometryMesh mesh{};
-			// 这里细分到第六次会网格出现问题
-			subdivision = std::min<std::uint32_t>(subdivision, 5u);
+			subdivision = std::min<std::uint32_t>(subdivision, kMaxSubdivision);
 
 			std::array<Vertex, 24> v;
 
@@ -120,51 +179,59 @@ namespace DSM {
 			// 每一层的半径差
 			float dr = topRadius - buttonRadius;
 			float radiusStep = dr / stackCount;
-			float ringCount = (float)stackCount + 1;
+			std::uint32_t ringCount = stackCount + 1;
 			std::uint32_t ringVertexCount = sliceCount + 1;
 
-			// 创建顶点
-			for (std::uint32_t i = 0; i < ringCount; ++i) {
-				// 当前环的数据
-				float y = .5f * -height + i * stackHeight;
-				float r = buttonRadius + i * radiusStep;
-				float thetaStep = XM_2PI / sliceCount;
-
-				for (std::uint32_t j = 0; j <= sliceCount; ++j) {
-					Vertex vertex{};
-					float theta = j * thetaStep;
-					float c = std::cosf(theta);
-					float s = std::sinf(theta);
-
-					XMFLOAT3 tangent = { -s,0,c };
-					XMVECTOR T = XMLoadFloat3(&tangent);
-					XMVECTOR B{ -dr * c,-height,-dr * s };
-					XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-					vertex.m_Position = { c * r,y,s * r };
-					vertex.m_TexCoord = { (float)j / sliceCount,(float)i / sliceCount };
-					vertex.m_Tangent = { tangent.x,tangent.y,tangent.z,1 };
-					XMStoreFloat3(&vertex.m_Normal, N);
-
-					mesh.m_Vertices.push_back(std::move(vertex));
-
-					//	i+1	*-----------*
-					//		|           |
-					//		|           |
-					//		*-----------*
-					//	i	 j           j+1
-
-					// 一层中的一个面片
-					if (i != stackCount && j != sliceCount) {
-						mesh.m_Indices32.push_back(i * ringVertexCount + j);
-						mesh.m_Indices32.push_back((i + 1) * ringVertexCount + j);
-						mesh.m_Indices32.push_back((i + 1) * ringVertexCount + j + 1);
-
-						mesh.m_Indices32.push_back(i * ringVertexCount + j);
-						mesh.m_Indices32.push_back((i + 1) * ringVertexCount + j + 1);
-						mesh.m_Indices32.push_back(i * ringVertexCount + j + 1);
+			// 侧面与两个底面的顶点一次分配，每个环的顶点与索引位置固定，按环并行生成
+			std::size_t numSideVertices = std::size_t(ringCount) * ringVertexCount;
+			std::size_t numCapVertices = 2 * (std::size_t(sliceCount) + 2);
+			mesh.m_Vertices.reserve(numSideVertices + numCapVertices);
+			mesh.m_Indices32.reserve((std::size_t(stackCount) * 6 + 6) * sliceCount);
+			mesh.m_Vertices.resize(numSideVertices);
+			mesh.m_Indices32.resize(std::size_t(stackCount) * sliceCount * 6);
+
+			ParallelRows(ringCount, numSideVertices, [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					// 当前环的数据
+					float y = .5f * -height + i * stackHeight;
+					float r = buttonRadius + i * radiusStep;
+					float thetaStep = XM_2PI / sliceCount;
+
+					for (std::uint32_t j = 0; j <= sliceCount; ++j) {
+						Vertex& vertex = mesh.m_Vertices[std::size_t(i) * ringVertexCount + j];
+						float theta = j * thetaStep;
+						float c = std::cosf(theta);
+						float s = std::sinf(theta);
+
+						XMFLOAT3 tangent = { -s,0,c };
+						XMVECTOR T = XMLoadFloat3(&tangent);
+						XMVECTOR B{ -dr * c,-height,-dr * s };
+						XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
+						vertex.m_Position = { c * r,y,s * r };
+						vertex.m_TexCoord = { (float)j / sliceCount,(float)i / sliceCount };
+						vertex.m_Tangent = { tangent.x,tangent.y,tangent.z,1 };
+						XMStoreFloat3(&vertex.m_Normal, N);
+
+						//	i+1	*-----------*
+						//		|           |
+						//		|           |
+						//		*-----------*
+						//	i	 j           j+1
+
+						// 一层中的一个面片
+						if (i != stackCount && j != sliceCount) {
+							std::uint32_t* indices = &mesh.m_Indices32[(std::size_t(i) * sliceCount + j) * 6];
+							indices[0] = i * ringVertexCount + j;
+							indices[1] = (i + 1) * ringVertexCount + j;
+							indices[2] = (i + 1) * ringVertexCount + j + 1;
+
+							indices[3] = i * ringVertexCount + j;
+							indices[4] = (i + 1) * ringVertexCount + j + 1;
+							indices[5] = i * ringVertexCount + j + 1;
+						}
 					}
 				}
-			}
+			});
 
 			auto vertexFunc = [](Vertex& vertex, float height) {
 				auto& position = vertex.m_Position;
@@ -179,10 +246,10 @@ namespace DSM {
 			auto topMesh = CreatePolygon(topRadius, sliceCount);
 			auto buttonMesh = CreatePolygon(buttonRadius, sliceCount);
 
-			mesh = MergeMesh(mesh, topMesh, topVertexFunc, [](auto& i) {});
+			AppendMesh(mesh, topMesh, topVertexFunc, [](auto& i) {});
 
 			std::reverse(buttonMesh.m_Indices32.begin(), buttonMesh.m_Indices32.end());
-			mesh = MergeMesh(mesh, buttonMesh, buttonVertexFunc, [](auto& i) {});
+			AppendMesh(mesh, buttonMesh, buttonVertexFunc, [](auto& i) {});
 
 			return mesh;
 		}
@@ -225,37 +292,43 @@ namespace DSM {
 			Vertex topVertex{ {0,radius,0},{0,1,0},{1,0,0,1},{},{0,0} };
 			Vertex buttonVertex{ {0,-radius,0},{0,-1,0},{1,0,0,1},{},{0,1} };
 
-			mesh.m_Vertices.push_back(std::move(topVertex));
+			// 每一环的顶点与索引位置固定，按环并行生成
+			std::uint32_t ringVertexCount = sliceCount + 1;
+			std::size_t numVertices = std::size_t(stackCount - 1) * ringVertexCount + 2;
+			mesh.m_Vertices.resize(numVertices);
+			mesh.m_Indices32.resize(std::size_t(stackCount - 1) * sliceCount * 6);
+			mesh.m_Vertices.front() = topVertex;
+			mesh.m_Vertices.back() = buttonVertex;
 
 			float phiStep = XM_PI / stackCount;
 			float thetaStep = XM_2PI / sliceCount;
 			// 生成頂點
-			for (std::uint32_t i = 1; i <= stackCount - 1; ++i) {
-				float phi = i * phiStep;
-				float cphi = std::cosf(phi);
-				float sphi = std::sinf(phi);
-				for (std::uint32_t j = 0; j <= sliceCount; ++j) {
-					float theta = j * thetaStep;
-					float ctheta = std::cosf(theta);
-					float stheta = std::sinf(theta);
-					Vertex vertex{};
-					vertex.m_Position = { radius * sphi * ctheta,radius * cphi,radius * sphi * stheta };
-					vertex.m_TexCoord = { theta / XM_2PI,phi / XM_PI };
-					XMVECTOR T = { radius * sphi * -stheta,radius * cphi,radius * sphi * ctheta,1 };
-					XMVECTOR N = XMLoadFloat3(&vertex.m_Position);
-					XMVector3Normalize(N);
-					XMStoreFloat4(&vertex.m_Tangent, XMVector3Normalize(T));
-					XMStoreFloat3(&vertex.m_Normal, XMVector3Normalize(N));
-					mesh.m_Vertices.push_back(std::move(vertex));
+			ParallelRows(stackCount - 1, numVertices, [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin + 1; i <= end; ++i) {
+					float phi = i * phiStep;
+					float cphi = std::cosf(phi);
+					float sphi = std::sinf(phi);
+					for (std::uint32_t j = 0; j <= sliceCount; ++j) {
+						float theta = j * thetaStep;
+						float ctheta = std::cosf(theta);
+						float stheta = std::sinf(theta);
+						Vertex& vertex = mesh.m_Vertices[1 + std::size_t(i - 1) * ringVertexCount + j];
+						vertex.m_Position = { radius * sphi * ctheta,radius * cphi,radius * sphi * stheta };
+						vertex.m_TexCoord = { theta / XM_2PI,phi / XM_PI };
+						XMVECTOR T = { radius * sphi * -stheta,radius * cphi,radius * sphi * ctheta,1 };
+						XMVECTOR N = XMLoadFloat3(&vertex.m_Position);
+						XMStoreFloat4(&vertex.m_Tangent, XMVector3Normalize(T));
+						XMStoreFloat3(&vertex.m_Normal, XMVector3Normalize(N));
+					}
 				}
-			}
-			mesh.m_Vertices.push_back(std::move(buttonVertex));
+			});
 
 			// 生成頂部索引
+			std::uint32_t* topIndices = mesh.m_Indices32.data();
 			for (std::uint32_t i = 1; i <= sliceCount; ++i) {
-				mesh.m_Indices32.push_back(0);
-				mesh.m_Indices32.push_back(i + 1);
-				mesh.m_Indices32.push_back(i);
+				*topIndices++ = 0;
+				*topIndices++ = i + 1;
+				*topIndices++ = i;
 			}
 
 			//	i	*-----------*
@@ -265,26 +338,29 @@ namespace DSM {
 			//	i+1	 j           j+1
 
 			// 生成中間索引
-			std::uint32_t ringVertexCount = sliceCount + 1;
-			for (std::uint32_t i = 0; i < stackCount - 2; ++i) {
-				for (std::uint32_t j = 1; j <= sliceCount; ++j) {	// 去掉頂點
-					mesh.m_Indices32.push_back(i * ringVertexCount + j);
-					mesh.m_Indices32.push_back((i + 1) * ringVertexCount + j + 1);
-					mesh.m_Indices32.push_back((i + 1) * ringVertexCount + j);
-
-					mesh.m_Indices32.push_back(i * ringVertexCount + j);
-					mesh.m_Indices32.push_back(i * ringVertexCount + j + 1);
-					mesh.m_Indices32.push_back((i + 1) * ringVertexCount + j + 1);
+			ParallelRows(stackCount - 2, numVertices, [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					std::uint32_t* indices = &mesh.m_Indices32[std::size_t(sliceCount) * 3 + std::size_t(i) * sliceCount * 6];
+					for (std::uint32_t j = 1; j <= sliceCount; ++j) {	// 去掉頂點
+						*indices++ = i * ringVertexCount + j;
+						*indices++ = (i + 1) * ringVertexCount + j + 1;
+						*indices++ = (i + 1) * ringVertexCount + j;
+
+						*indices++ = i * ringVertexCount + j;
+						*indices++ = i * ringVertexCount + j + 1;
+						*indices++ = (i + 1) * ringVertexCount + j + 1;
+					}
 				}
-			}
+			});
 
 			// 生成底部索引
 			std::uint32_t lastIndex = (std::uint32_t)mesh.m_Vertices.size() - 1;
 			std::uint32_t baseIndex = lastIndex - ringVertexCount;
+			std::uint32_t* bottomIndices = &mesh.m_Indices32[mesh.m_Indices32.size() - std::size_t(sliceCount) * 3];
 			for (std::uint32_t i = 0; i < sliceCount; ++i) {
-				mesh.m_Indices32.push_back(lastIndex);
-				mesh.m_Indices32.push_back(baseIndex + i);
-				mesh.m_Indices32.push_back(baseIndex + i + 1);
+				*bottomIndices++ = lastIndex;
+				*bottomIndices++ = baseIndex + i;
+				*bottomIndices++ = baseIndex + i + 1;
 			}
 
 
@@ -294,7 +370,7 @@ namespace DSM {
 		GeometryMesh GeometryGenerator::CreateGeosphere(float radius, std::uint32_t subdivision) noexcept
 		{
 			GeometryMesh mesh{};
-			subdivision = std::min(5u, subdivision);
+			subdivision = std::min(kMaxSubdivision, subdivision);
 			// 通过正十二边形近似圆
 			const float X = 0.525731f;
 			const float Z = 0.850651f;
@@ -324,33 +400,36 @@ namespace DSM {
 			for (std::uint32_t i = 0; i < subdivision; ++i) {
 				Subdivide(mesh);
 			}
-			for (std::uint32_t i = 0; i < mesh.m_Vertices.size(); ++i)
-			{
-				// 将正六面体的位置投影到圆上
-				auto& vertex = mesh.m_Vertices[i];
-				XMVECTOR N = XMVector3Normalize(XMLoadFloat3(&vertex.m_Position));
-				XMVECTOR P = radius * N;
-				XMStoreFloat3(&vertex.m_Position, P);
-				XMStoreFloat3(&vertex.m_Normal, N);
-
-				// 还原出角度
-				//	vertex.m_Position = { radius * ctheta,radius * cphi,radius * stheta };
-				float theta = atan2f(vertex.m_Position.z, vertex.m_Position.x);
-				//if (theta < 0.0f)
-				//	theta += XM_2PI;
-				float phi = acosf(vertex.m_Position.y / radius);
-
-				vertex.m_TexCoord = { theta / XM_2PI, phi / XM_PI };
-
-				// 重新计算切线
-				vertex.m_Tangent.x = radius * sinf(phi) * -sinf(theta);
-				vertex.m_Tangent.y = .0f;
-				vertex.m_Tangent.z = radius * sinf(phi) * cosf(theta);
-				vertex.m_Tangent.w = 1.f;
-
-				XMVECTOR T = XMLoadFloat4(&vertex.m_Tangent);
-				XMStoreFloat4(&vertex.m_Tangent, XMVector3Normalize(T));
-			}
+			std::uint32_t numVertices = (std::uint32_t)mesh.m_Vertices.size();
+			ParallelRows(numVertices, numVertices, [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i)
+				{
+					// 将正六面体的位置投影到圆上
+					auto& vertex = mesh.m_Vertices[i];
+					XMVECTOR N = XMVector3Normalize(XMLoadFloat3(&vertex.m_Position));
+					XMVECTOR P = radius * N;
+					XMStoreFloat3(&vertex.m_Position, P);
+					XMStoreFloat3(&vertex.m_Normal, N);
+
+					// 还原出角度
+					//	vertex.m_Position = { radius * ctheta,radius * cphi,radius * stheta };
+					float theta = atan2f(vertex.m_Position.z, vertex.m_Position.x);
+					//if (theta < 0.0f)
+					//	theta += XM_2PI;
+					float phi = acosf(vertex.m_Position.y / radius);
+
+					vertex.m_TexCoord = { theta / XM_2PI, phi / XM_PI };
+
+					// 重新计算切线
+					vertex.m_Tangent.x = radius * sinf(phi) * -sinf(theta);
+					vertex.m_Tangent.y = .0f;
+					vertex.m_Tangent.z = radius * sinf(phi) * cosf(theta);
+					vertex.m_Tangent.w = 1.f;
+
+					XMVECTOR T = XMLoadFloat4(&vertex.m_Tangent);
+					XMStoreFloat4(&vertex.m_Tangent, XMVector3Normalize(T));
+				}
+			});
 
 			return mesh;
 		}
@@ -374,19 +453,21 @@ namespace DSM {
 			float du = 1.f / (m - 1);
 			float dv = 1.f / (n - 1);
 
-			// 生成顶点
+			// 生成顶点，每一行的位置固定，按行并行
 			mesh.m_Vertices.resize(vertexCout);
-			for (std::uint32_t i = 0; i < m; ++i) {
-				float z = -halfDepth + i * dz;
-				for (std::uint32_t j = 0; j < n; ++j) {
-					float x = -halfWidth + j * dx;
-					std::uint32_t index = i * n + j;
-					mesh.m_Vertices[index].m_Position = { x, 0 ,z };
-					mesh.m_Vertices[index].m_Normal = { 0,1,0 };
-					mesh.m_Vertices[index].m_Tangent = { 1,0,0,1 };
-					mesh.m_Vertices[index].m_TexCoord = { du * j, dv * i };
+			ParallelRows(m, vertexCout, [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					float z = -halfDepth + i * dz;
+					for (std::uint32_t j = 0; j < n; ++j) {
+						float x = -halfWidth + j * dx;
+						std::uint32_t index = i * n + j;
+						mesh.m_Vertices[index].m_Position = { x, 0 ,z };
+						mesh.m_Vertices[index].m_Normal = { 0,1,0 };
+						mesh.m_Vertices[index].m_Tangent = { 1,0,0,1 };
+						mesh.m_Vertices[index].m_TexCoord = { du * j, dv * i };
+					}
 				}
-			}
+			});
 
 			/*	j			j+1
 			 i+1-------------
@@ -397,18 +478,21 @@ namespace DSM {
 			 i	-------------
 			*/
 			// 生成索引
-			mesh.m_Indices32.resize(faceCount * 3);
-			for (std::uint32_t i = 0, k = 0; i < m - 1; ++i) {
-				for (std::uint32_t j = 0; j < n - 1; ++j) {
-					std::uint32_t count = i * n + j;
-					mesh.m_Indices32[k++] = count;
-					mesh.m_Indices32[k++] = count + n + 1;
-					mesh.m_Indices32[k++] = count + 1;
-					mesh.m_Indices32[k++] = count;
-					mesh.m_Indices32[k++] = count + n;
-					mesh.m_Indices32[k++] = count + n + 1;
+			mesh.m_Indices32.resize(std::size_t(faceCount) * 3);
+			ParallelRows(m - 1, vertexCout, [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					std::size_t k = std::size_t(i) * (n - 1) * 6;
+					for (std::uint32_t j = 0; j < n - 1; ++j) {
+						std::uint32_t count = i * n + j;
+						mesh.m_Indices32[k++] = count;
+						mesh.m_Indices32[k++] = count + n + 1;
+						mesh.m_Indices32[k++] = count + 1;
+						mesh.m_Indices32[k++] = count;
+						mesh.m_Indices32[k++] = count + n;
+						mesh.m_Indices32[k++] = count + n + 1;
+					}
 				}
-			}
+			});
 
 			return mesh;
 		}
@@ -420,25 +504,34 @@ namespace DSM {
 			VertFunc vertFunc,
 			IndexFunc indexFunc) noexcept
 		{
-			GeometryMesh copyMesh = m0;
-			GeometryMesh mergeMesh = m1;
-
-			auto& mergeIndices = mergeMesh.m_Indices32;
-			auto& mergeVertices = mergeMesh.m_Vertices;
-			// 将m1的所有索引加上基础值,并使用闭包函数处理索引
-			auto mergeIndexFunc = [&copyMesh, indexFunc](std::uint32_t& index) {
-				index += (std::uint32_t)copyMesh.m_Vertices.size();
-				indexFunc(index); };
-
-			std::for_each(mergeIndices.begin(), mergeIndices.end(), mergeIndexFunc);
-			copyMesh.m_Indices32.insert(copyMesh.m_Indices32.end(), mergeIndices.begin(), mergeIndices.end());
-
-			std::for_each(mergeVertices.begin(), mergeVertices.end(), vertFunc);
-			copyMesh.m_Vertices.insert(copyMesh.m_Vertices.end(), mergeVertices.begin(), mergeVertices.end());
+			GeometryMesh copyMesh{};
+			copyMesh.m_Vertices.reserve(m0.m_Vertices.size() + m1.m_Vertices.size());
+			copyMesh.m_Indices32.reserve(m0.m_Indices32.size() + m1.m_Indices32.size());
+			copyMesh.m_Vertices = m0.m_Vertices;
+			copyMesh.m_Indices32 = m0.m_Indices32;
+			AppendMesh(copyMesh, m1, vertFunc, indexFunc);
 
 			return copyMesh;
 		}
 
+		template<typename VertFunc, typename IndexFunc>
+		void GeometryGenerator::AppendMesh(
+			GeometryMesh& mesh,
+			const GeometryMesh& m1,
+			VertFunc vertFunc,
+			IndexFunc indexFunc) noexcept
+		{
+			// 将m1的所有索引加上基础值,并使用闭包函数处理索引
+			auto baseIndex = (std::uint32_t)mesh.m_Vertices.size();
+			auto firstIndex = mesh.m_Indices32.insert(mesh.m_Indices32.end(), m1.m_Indices32.begin(), m1.m_Indices32.end());
+			std::for_each(firstIndex, mesh.m_Indices32.end(), [baseIndex, &indexFunc](std::uint32_t& index) {
+				index += baseIndex;
+				indexFunc(index); });
+
+			auto firstVertex = mesh.m_Vertices.insert(mesh.m_Vertices.end(), m1.m_Vertices.begin(), m1.m_Vertices.end());
+			std::for_each(firstVertex, mesh.m_Vertices.end(), vertFunc);
+		}
+
 		GeometryMesh GeometryGenerator::MergeMesh(const GeometryMesh& m0, const GeometryMesh& m1) noexcept
 		{
 			auto vertFunc = [](Vertex& vertex) {};
@@ -457,38 +550,57 @@ namespace DSM {
 			//  /   \ /   \
 			// *-----*-----*
 			// v0    m2     v2
-			GeometryMesh copyMesh = mesh;
-			mesh.m_Vertices.resize(0);
-			mesh.m_Indices32.resize(0);
-
-			std::uint32_t numTriangles = (std::uint32_t)copyMesh.m_Indices32.size() / 3;
+			// 先为每条边分配中点的序号，共享的边只分配一次，之后并行计算中点与索引
+			auto& vertices = mesh.m_Vertices;
+			auto& indices = mesh.m_Indices32;
+			std::uint32_t numVertices = (std::uint32_t)vertices.size();
+			std::uint32_t numTriangles = (std::uint32_t)indices.size() / 3;
+
+			// 每个三角形三条边 (v0,v1)、(v1,v2)、(v2,v0) 的中点，以及每条边的端点
+			std::vector<std::uint32_t> midIndices(std::size_t(numTriangles) * 3);
+			std::vector<std::uint32_t> edgeVertices{};
+			edgeVertices.reserve(std::size_t(numTriangles) * 3);
+			EdgeMidpointMap edgeMap(std::size_t(numTriangles) * 3);
 			for (std::uint32_t i = 0; i < numTriangles; ++i) {
-				std::array<Vertex, 6> vs{};
-				for (auto j = 0; j < 3; ++j) {
-					vs[j] = copyMesh.m_Vertices[copyMesh.m_Indices32[3 * i + j]];
-				}
-				for (auto j = 3; j < 6; ++j) {
-					vs[j] = MidPoint(vs[j - 3], vs[(j - 2) % 3]);
+				for (std::uint32_t j = 0; j < 3; ++j) {
+					std::uint32_t v0 = indices[3 * i + j];
+					std::uint32_t v1 = indices[3 * i + (j + 1) % 3];
+					std::uint32_t newIndex = numVertices + (std::uint32_t)edgeVertices.size() / 2;
+					bool added = false;
+					midIndices[3 * i + j] = edgeMap.FindOrAdd(v0, v1, newIndex, added);
+					if (added) {
+						edgeVertices.push_back(v0);
+						edgeVertices.push_back(v1);
+					}
 				}
-				mesh.m_Vertices.insert(mesh.m_Vertices.end(), vs.begin(), vs.end());
-
-				mesh.m_Indices32.push_back(i * 6 + 0);
-				mesh.m_Indices32.push_back(i * 6 + 3);
-				mesh.m_Indices32.push_back(i * 6 + 5);
-
-				mesh.m_Indices32.push_back(i * 6 + 3);
-				mesh.m_Indices32.push_back(i * 6 + 4);
-				mesh.m_Indices32.push_back(i * 6 + 5);
-
-				mesh.m_Indices32.push_back(i * 6 + 5);
-				mesh.m_Indices32.push_back(i * 6 + 4);
-				mesh.m_Indices32.push_back(i * 6 + 2);
-
-				mesh.m_Indices32.push_back(i * 6 + 3);
-				mesh.m_Indices32.push_back(i * 6 + 1);
-				mesh.m_Indices32.push_back(i * 6 + 4);
 			}
 
+			std::uint32_t numEdges = (std::uint32_t)edgeVertices.size() / 2;
+			vertices.resize(std::size_t(numVertices) + numEdges);
+			ParallelRows(numEdges, vertices.size(), [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					vertices[numVertices + i] = MidPoint(vertices[edgeVertices[2 * i]], vertices[edgeVertices[2 * i + 1]]);
+				}
+			});
+
+			std::vector<std::uint32_t> newIndices(std::size_t(numTriangles) * 12);
+			ParallelRows(numTriangles, vertices.size(), [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					std::uint32_t v0 = indices[3 * i + 0];
+					std::uint32_t v1 = indices[3 * i + 1];
+					std::uint32_t v2 = indices[3 * i + 2];
+					std::uint32_t m0 = midIndices[3 * i + 0];
+					std::uint32_t m1 = midIndices[3 * i + 1];
+					std::uint32_t m2 = midIndices[3 * i + 2];
+
+					std::uint32_t* triangles = &newIndices[std::size_t(i) * 12];
+					triangles[0] = v0; triangles[1] = m0; triangles[2] = m2;
+					triangles[3] = m0; triangles[4] = m1; triangles[5] = m2;
+					triangles[6] = m2; triangles[7] = m1; triangles[8] = v2;
+					triangles[9] = m0; triangles[10] = v1; triangles[11] = m1;
+				}
+			});
+			indices = std::move(newIndices);
 		}
 
 		Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Vertex& v1) noexcept
@@ -4,6 +4,7 @@
 
 #include <DirectXMath.h>
 #include <vector>
+#include "RayTracing/BVH.h"
 
 namespace DSM {
 	namespace Geometry {
@@ -32,6 +33,17 @@ namespace DSM {
 				return m_Indices16;
 			}
 
+			// 供 BVH 直接读取顶点中的位置，网格需在构建期间保持有效
+			BVHGeometry GetBVHGeometry() const noexcept {
+				BVHGeometry geometry{};
+				geometry.m_Positions = m_Vertices.data();
+				geometry.m_PositionStride = sizeof(Vertex);
+				geometry.m_NumVertices = static_cast<std::uint32_t>(m_Vertices.size());
+				geometry.m_Indices = m_Indices32.data();
+				geometry.m_NumIndices = static_cast<std::uint32_t>(m_Indices32.size());
+				return geometry;
+			}
+
 		private:
 			std::vector<std::uint16_t> m_Indices16;
 		};
@@ -98,7 +110,14 @@ namespace DSM {
 				const GeometryMesh& m1) noexcept;
 
 		private:
-			// 将网格按三角形细分
+			// 将 m1 的顶点与索引追加到 mesh 之后，索引加上 mesh 原有的顶点数量后再交给 indexFunc
+			template<typename VertFunc, typename IndexFunc>
+			static void AppendMesh(
+				GeometryMesh& mesh,
+				const GeometryMesh& m1,
+				VertFunc vertFunc,
+				IndexFunc indexFunc) noexcept;
+			// 每个三角形分为 4 个，共享边的中点只生成一次
 			static void Subdivide(GeometryMesh& mesh) noexcept;
 			static Vertex MidPoint(const Vertex& v0, const Vertex& v1) noexcept;
 		};
@@ -0,0 +1,152 @@
+#include "GpuScene.h"
+#include "Graphics/RenderContext.h"
+#include "Graphics/CommandList/GraphicsCommandList.h"
+#include "Graphics/CommandList/ComputeCommandList.h"
+#include "Core/Profiler.h"
+
+
+namespace DSM {
+    namespace {
+        // 首次创建表时的行数
+        constexpr std::uint64_t kMinTableRows = 256;
+    }
+
+    void GpuScene::Create()
+    {
+        if (m_Initialized) return;
+
+        m_Instances.m_Name = L"GpuScene::Instances";
+        m_Instances.m_Rows.Reset(sizeof(MeshInstanceData));
+        m_Instances.m_ReadState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
+        m_Materials.m_Name = L"GpuScene::Materials";
+        m_Materials.m_Rows.Reset(sizeof(MaterialConstants));
+        m_Materials.m_ReadState = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+
+        m_ScatterRootSig[kScatterConstants].InitAsConstants(0, 2);
+        m_ScatterRootSig[kScatterData].InitAsBufferSRV(0);
+        m_ScatterRootSig[kScatterRows].InitAsBufferSRV(1);
+        m_ScatterRootSig[kSceneTable].InitAsBufferUAV(0);
+        m_ScatterRootSig.Finalize(L"GpuScene::ScatterRootSig");
+
+        ShaderDesc csDesc{};
+        csDesc.m_Type = ShaderType::Compute;
+        csDesc.m_Mode = ShaderMode::SM_6_1;
+        csDesc.m_FileName = "Shaders/SceneScatter.hlsl";
+        csDesc.m_EnterPoint = "ScatterCS";
+        m_ScatterCS = std::make_unique<ShaderByteCode>(csDesc);
+
+        m_ScatterPSO.SetRootSignature(m_ScatterRootSig);
+        m_ScatterPSO.SetComputeShader(*m_ScatterCS);
+        m_ScatterPSO.Finalize();
+
+        m_Initialized = true;
+    }
+
+    void GpuScene::Shutdown()
+    {
+        for (auto* table : {&m_Instances, &m_Materials}) {
+            if (table->m_Buffer != nullptr) {
+                table->m_Buffer->Destroy();
+                table->m_Buffer = nullptr;
+            }
+        }
+        m_Initialized = false;
+    }
+
+    void GpuScene::Update(GraphicsCommandList& cmdList)
+    {
+        PROFILE_SCOPE("GpuScene::Update");
+        ASSERT(m_Initialized, "GpuScene is not created!");
+
+        UpdateTable(cmdList, m_Instances);
+        UpdateTable(cmdList, m_Materials);
+    }
+
+    GpuScene::GpuScene()
+        :m_ScatterRootSig(kNumRootBindings, 0),
+        m_ScatterPSO(L"GpuScene::ScatterPSO") {}
+
+    void GpuScene::UpdateTable(GraphicsCommandList& cmdList, Table& table)
+    {
+        auto& rows = table.m_Rows;
+        auto rowSize = rows.GetRowSize();
+        auto requiredSize = std::uint64_t(rows.GetNumRows()) * rowSize;
+        if (requiredSize == 0) return;
+        if (table.m_Buffer == nullptr || table.m_Buffer->GetSize() < requiredSize) {
+            GrowTable(cmdList, table, requiredSize);
+        }
+
+        rows.BuildScatterList(sm_MaxMergeGap);
+        auto ranges = rows.GetScatterRanges();
+        if (!ranges.empty()) {
+            auto scatterRows = rows.GetScatterRows();
+            auto dataSize = rows.GetScatterDataSize();
+
+            if (ranges.size() <= sm_MaxCopyRanges) {
+                auto uploadBuffer = cmdList.GetUploadBuffer(dataSize);
+                rows.WriteScatterData(uploadBuffer.m_MappedAddress);
+                for (const auto& range : ranges) {
+                    cmdList.CopyBufferRegion(*table.m_Buffer, std::size_t(range.m_DestRow) * rowSize,
+                        *uploadBuffer.m_Resource, uploadBuffer.m_Offset + std::size_t(range.m_SrcRow) * rowSize,
+                        std::size_t(range.m_NumRows) * rowSize);
+                }
+            }
+            else {
+                // 打包的行之后紧跟每行的目标行号，每个线程写入 16 字节
+                auto uploadBuffer = cmdList.GetUploadBuffer(dataSize + scatterRows.size_bytes(), 16);
+                auto mappedAddress = static_cast<std::uint8_t*>(uploadBuffer.m_MappedAddress);
+                rows.WriteScatterData(mappedAddress);
+                memcpy(mappedAddress + dataSize, scatterRows.data(), scatterRows.size_bytes());
+
+                auto rowVectors = rowSize / 16;
+                auto& computeList = cmdList.GetComputeCommandList();
+                computeList.TransitionResource(*table.m_Buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                computeList.SetRootSignature(m_ScatterRootSig);
+                computeList.SetPipelineState(m_ScatterPSO);
+                computeList.SetUnorderedAccess(kSceneTable, *table.m_Buffer);
+
+                // 整表上传时线程组数量可能超过单次 Dispatch 的上限
+                auto maxRows = static_cast<std::uint32_t>(D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION * 64 / rowVectors);
+                for (std::uint32_t firstRow = 0; firstRow < scatterRows.size(); firstRow += maxRows) {
+                    auto numRows = (std::min)(maxRows, static_cast<std::uint32_t>(scatterRows.size()) - firstRow);
+                    computeList.SetConstants(kScatterConstants, numRows, rowVectors);
+                    computeList.SetShaderResource(kScatterData, *uploadBuffer.m_Resource,
+                        uploadBuffer.m_Offset + std::uint64_t(firstRow) * rowSize);
+                    computeList.SetShaderResource(kScatterRows, *uploadBuffer.m_Resource,
+                        uploadBuffer.m_Offset + dataSize + std::uint64_t(firstRow) * sizeof(std::uint32_t));
+                    computeList.Dispatch1D(std::size_t(numRows) * rowVectors, 64);
+                }
+            }
+        }
+        cmdList.TransitionResource(*table.m_Buffer, table.m_ReadState);
+    }
+
+    void GpuScene::GrowTable(GraphicsCommandList& cmdList, Table& table, std::uint64_t requiredSize)
+    {
+        auto rowSize = table.m_Rows.GetRowSize();
+        ASSERT(rowSize % 16 == 0, "Row size must be a multiple of 16 bytes!");
+
+        auto size = (std::max)(requiredSize, kMinTableRows * rowSize);
+        if (table.m_Buffer != nullptr) {
+            size = (std::max)(size, table.m_Buffer->GetSize() * 2);
+        }
+
+        GpuBufferDesc bufferDesc{};
+        bufferDesc.m_Size = size;
+        bufferDesc.m_Stride = rowSize;
+        bufferDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        bufferDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        bufferDesc.m_Category = MemoryCategory::kBuffer;
+        auto newBuffer = std::make_unique<GpuBuffer>(table.m_Name, bufferDesc);
+
+        if (table.m_Buffer != nullptr) {
+            cmdList.CopyBufferRegion(*newBuffer, 0, *table.m_Buffer, 0, table.m_Buffer->GetSize());
+
+            // 之前的帧可能仍在使用旧的缓冲
+            std::shared_ptr<GpuBuffer> oldBuffer = std::move(table.m_Buffer);
+            g_RenderContext.GetFrameScheduler().DeferRelease([oldBuffer]() { oldBuffer->Destroy(); });
+        }
+        table.m_Buffer = std::move(newBuffer);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef __GPUSCENE_H__
+#define __GPUSCENE_H__
+
+#include "Utilities/Singleton.h"
+#include "Graphics/Resource/GpuBuffer.h"
+#include "Graphics/RootSignature.h"
+#include "Graphics/PipelineState.h"
+#include "Graphics/ShaderCompiler.h"
+#include "Renderer/GpuSceneTable.h"
+#include "ConstantData.h"
+
+
+namespace DSM {
+    class GraphicsCommandList;
+
+    // 常驻默认堆的实例与材质表，每帧只上传改变的行
+    class GpuScene : public Singleton<GpuScene>
+    {
+    public:
+        enum RootBindings
+        {
+            kScatterConstants = 0,
+            kScatterData,
+            kScatterRows,
+            kSceneTable,
+            kNumRootBindings
+        };
+
+    public:
+        void Create();
+        void Shutdown();
+
+        std::uint32_t AllocateInstance() { return m_Instances.m_Rows.Allocate(); }
+        void FreeInstance(std::uint32_t row) { m_Instances.m_Rows.Free(row); }
+        bool WriteInstance(std::uint32_t row, const MeshInstanceData& instance) { return m_Instances.m_Rows.Write(row, instance); }
+
+        std::uint32_t AllocateMaterial() { return m_Materials.m_Rows.Allocate(); }
+        void FreeMaterial(std::uint32_t row) { m_Materials.m_Rows.Free(row); }
+        bool WriteMaterial(std::uint32_t row, const MaterialConstants& material) { return m_Materials.m_Rows.Write(row, material); }
+
+        // 表扩容后地址会改变，需在 Update 之后获取
+        GpuBuffer& GetInstanceBuffer() { return *m_Instances.m_Buffer; }
+        D3D12_GPU_VIRTUAL_ADDRESS GetMaterialCBV(std::uint32_t row) const
+        {
+            return m_Materials.m_Buffer->GetGpuVirtualAddress() + std::uint64_t(row) * sizeof(MaterialConstants);
+        }
+
+        // 在使用表之前调用，扩容缓冲并上传改变的行，之后表处于着色器可读的状态
+        void Update(GraphicsCommandList& cmdList);
+
+        // 改变的范围不超过该数量时直接拷贝，否则使用计算着色器分散写入
+        inline static std::uint32_t sm_MaxCopyRanges = 16;
+        // 间隔不超过该行数的改变合并为一次拷贝
+        inline static std::uint32_t sm_MaxMergeGap = 4;
+
+    private:
+        friend class Singleton<GpuScene>;
+        GpuScene();
+        virtual ~GpuScene() { Shutdown(); }
+
+        struct Table
+        {
+            std::wstring m_Name{};
+            GpuSceneTable m_Rows{};
+            std::unique_ptr<GpuBuffer> m_Buffer{};
+            D3D12_RESOURCE_STATES m_ReadState{};
+        };
+
+        void UpdateTable(GraphicsCommandList& cmdList, Table& table);
+        // 新建更大的缓冲并在 GPU 上拷贝已有的行
+        void GrowTable(GraphicsCommandList& cmdList, Table& table, std::uint64_t requiredSize);
+
+    private:
+        bool m_Initialized = false;
+
+        Table m_Instances{};
+        Table m_Materials{};
+
+        RootSignature m_ScatterRootSig;
+        ComputePSO m_ScatterPSO;
+        std::unique_ptr<ShaderByteCode> m_ScatterCS;
+    };
+#define g_GpuScene (GpuScene::GetInstance())
+
+} // namespace DSM
+
+#endif
@@ -1,4 +1,5 @@
 #include "ImguiManager.h"
+#include "Renderer.h"
 
 using namespace DirectX;
 
@@ -31,9 +32,16 @@ namespace DSM {
 
 			ImGui::Text("Blur Count: %", m_BlurCount);
 			ImGui::SliderInt("##9", &m_BlurCount, 0, 10, "");
+
+			ImGui::Checkbox("Occlusion Culling", &MeshRenderer::sm_EnableOcclusionCulling);
+			ImGui::Checkbox("Clustered Lights", &MeshRenderer::sm_EnableClusteredLights);
+			ImGui::Checkbox("Shadows", &ShadowRenderer::sm_EnableShadows);
+			ImGui::Text("LOD Error Pixels: %.2f", Mesh::sm_LODErrorPixels);
+			ImGui::SliderFloat("##10", &Mesh::sm_LODErrorPixels, 0, 16, "");
 		}
 		ImGui::End();
 
+		ShowProfilerWindow();
 		
 		m_LightColor = {lightColor[0], lightColor[1], lightColor[2]};
 		m_LightDir = {lightDir[0], lightDir[1], lightDir[2]};
@@ -4,9 +4,11 @@
 
 #include <DirectXCollision.h>
 #include "Graphics/Resource/GpuBuffer.h"
+#include "Renderer/MeshSimplifier.h"
 
 namespace DSM {
 	struct Material;
+	class BVH;
 
 	enum PSOFlags : std::uint16_t
 	{
@@ -41,12 +43,37 @@ namespace DSM {
 			std::uint32_t m_IndexOffset;
 			std::uint32_t m_VertexOffset;
 			std::uint16_t m_MaterialIndex;
-			// 使用的纹理在描述符堆中的偏移
-			std::uint16_t m_SRVTableOffset;
+			// 物体空间的包围盒，用于逐个子网格的遮挡剔除
+			DirectX::BoundingBox m_BoundingBox;
+			// 由细到粗的各级 LOD，索引追加在原始索引之后并共用顶点，索引数量可能为 0
+			std::vector<SubMesh> m_LODs;
 		};
 		std::map<std::string, SubMesh> m_SubMeshes;
+		// 每级 LOD 到原始表面的几何误差，物体空间的单位，所有子网格相同
+		std::vector<float> m_LODErrors{};
 
 		GpuBuffer m_MeshData{};
+
+		// CPU 上的加速结构，用于拾取与可见性查询，几何体的顺序与 m_SubMeshes 的遍历顺序相同
+		std::shared_ptr<BVH> m_BVH{};
+		// 为 true 时加载网格的同时构建 BVH
+		inline static bool sm_BuildBVH = false;
+
+		// 软件遮挡剔除使用的三角形，索引已经加上子网格的顶点偏移，只保存在大而三角形少的不透明网格上
+		std::vector<DirectX::XMFLOAT3> m_OccluderPositions{};
+		std::vector<std::uint32_t> m_OccluderIndices{};
+		// 为 true 时加载网格的同时保存遮挡体
+		inline static bool sm_BuildOccluder = true;
+		inline static std::uint32_t sm_MaxOccluderTriangles = 4096;
+		// 包围盒的最长边不小于模型最长边的该比例时才作为遮挡体
+		inline static float sm_MinOccluderSize = 0.05f;
+
+		// 为 true 时加载网格的同时生成 LOD，结果缓存在 sm_LODCacheDirectory 中，为空时不缓存
+		inline static bool sm_GenerateLODs = true;
+		inline static MeshLODDesc sm_LODDesc{};
+		inline static std::string sm_LODCacheDirectory = "MeshCache";
+		// 绘制时选择投影到屏幕上的误差不超过该像素数的最粗的 LOD，为 0 时总是使用原始网格
+		inline static float sm_LODErrorPixels = 1.0f;
 	};
 	
 	
@@ -1,31 +1,115 @@
 #include "Model.h"
 #include "Renderer.h"
 #include "ConstantData.h"
+#include "GpuScene.h"
+#include "Core/Profiler.h"
 
 using namespace DirectX;
 
 namespace DSM {
-    void Model::Render(MeshRenderer& meshRenderer, GpuBuffer& meshConstant, const Transform& meshTransforms)
+    void Model::Render(MeshRenderer& meshRenderer, const Transform& meshTransforms)
     {
+        PROFILE_SCOPE("Model::Render");
         BoundingBox modelBoudingVS{};
         Math::Matrix4 MV = meshTransforms.GetLocalToWorld() * meshRenderer.GetViewMatrix();
         m_BoundingBox.Transform(modelBoudingVS, MV);
         if (!meshRenderer.GetViewFrustum().Intersects(modelBoudingVS)) return;
         
+        MeshInstanceData instance{};
+        instance.m_World = Math::Matrix4::Transpose(meshTransforms.GetLocalToWorld());
+        instance.m_WorldIT = Math::Matrix4::InverseTranspose(meshTransforms.GetLocalToWorld());
+        // 变换没有改变时不会重新上传
+        g_GpuScene.WriteInstance(m_InstanceRow, instance);
+
+        Math::Matrix4 MVP = meshTransforms.GetLocalToWorld() * meshRenderer.GetViewProjMatrix();
+
+        const auto& viewport = meshRenderer.GetViewPort();
+        float pixelsPerUnit = viewport.Height / (2 * std::tan(meshRenderer.GetFovY() * 0.5f));
+        // LOD 的误差在物体空间，按最大的缩放转换到世界空间
+        const auto& scale = meshTransforms.GetScale();
+        float worldScale = (std::max)({std::abs(float(scale.GetX())), std::abs(float(scale.GetY())), std::abs(float(scale.GetZ()))});
+        
         for (std::size_t i = 0; i < m_Meshes.size(); ++i) {
             const auto& mesh = m_Meshes[i];
 
             BoundingBox boxVS{};
             mesh->m_BoundingBox.Transform(boxVS, MV);
+
+            // 由包围盒投影到屏幕上的大小估计纹理需要的 mip，越大越优先加载
+            float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&boxVS.Extents)));
+            float depth = (std::max)(boxVS.Center.z - radius, 0.1f);
+            float screenSize = 2 * radius * pixelsPerUnit / depth;
+            float priority = (std::min)(screenSize / viewport.Height, 1.0f);
             
+            // 选择投影到屏幕上的误差不超过阈值的最粗的 LOD，包围盒最近处的深度使估计偏保守
+            std::size_t lod = 0;
+            float errorToPixels = worldScale * pixelsPerUnit / depth;
+            while (lod < mesh->m_LODErrors.size() && mesh->m_LODErrors[lod] * errorToPixels <= Mesh::sm_LODErrorPixels) {
+                ++lod;
+            }
+            
+            // 被遮挡的网格仍然请求纹理，出现时不会从低精度的 mip 开始加载
+            bool meshOccluded = meshRenderer.IsOccluded(mesh->m_BoundingBox, MVP);
             for (const auto& [name, submesh] : mesh->m_SubMeshes) {
+                for (const auto& texture : m_MaterialTextures[submesh.m_MaterialIndex]) {
+                    texture.RequestScreenSize(screenSize, priority);
+                }
+
+                if (meshOccluded) continue;
+                // 只有一个子网格时与网格的包围盒相同
+                if (mesh->m_SubMeshes.size() > 1 && meshRenderer.IsOccluded(submesh.m_BoundingBox, MVP)) continue;
+
+                const auto& drawSubMesh = lod == 0 ? submesh : submesh.m_LODs[lod - 1];
+                // 子网格在较粗的 LOD 中可能被完全简化掉
+                if (drawSubMesh.m_IndexCount == 0) continue;
+
                 float distance = boxVS.Center.z - boxVS.Extents.z;
-                meshRenderer.AddMesh(*mesh, distance,
-                    meshConstant.GetGpuVirtualAddress(),
-                    m_MaterialData.GetGpuVirtualAddress() + 
-                        submesh.m_MaterialIndex * sizeof(MaterialConstants));
+                meshRenderer.AddMesh(*mesh, drawSubMesh, distance,
+                    m_InstanceRow,
+                    m_MaterialRows[submesh.m_MaterialIndex],
+                    m_MaterialSRVs[submesh.m_MaterialIndex]);
             }
         }
     }
-}
 
+    void Model::RenderOccluders(MeshRenderer& meshRenderer, const Transform& meshTransforms)
+    {
+        PROFILE_SCOPE("Model::RenderOccluders");
+        Math::Matrix4 MV = meshTransforms.GetLocalToWorld() * meshRenderer.GetViewMatrix();
+        auto frustum = meshRenderer.GetViewFrustum();
+        BoundingBox modelBoudingVS{};
+        m_BoundingBox.Transform(modelBoudingVS, MV);
+        if (!frustum.Intersects(modelBoudingVS)) return;
+
+        for (const auto& mesh : m_Meshes) {
+            if (mesh->m_OccluderIndices.empty()) continue;
+
+            BoundingBox boxVS{};
+            mesh->m_BoundingBox.Transform(boxVS, MV);
+            if (!frustum.Intersects(boxVS)) continue;
+            meshRenderer.AddOccluder(*mesh, meshTransforms.GetLocalToWorld());
+        }
+    }
+
+    void Model::RenderShadowCasters(ShadowRenderer& shadowRenderer, const Transform& meshTransforms)
+    {
+        PROFILE_SCOPE("Model::RenderShadowCasters");
+        // 视锥之外的模型也可能投下阴影，实例总是写入
+        MeshInstanceData instance{};
+        instance.m_World = Math::Matrix4::Transpose(meshTransforms.GetLocalToWorld());
+        instance.m_WorldIT = Math::Matrix4::InverseTranspose(meshTransforms.GetLocalToWorld());
+        g_GpuScene.WriteInstance(m_InstanceRow, instance);
+
+        auto localToWorld = meshTransforms.GetLocalToWorld();
+        for (const auto& mesh : m_Meshes) {
+            for (const auto& [name, submesh] : mesh->m_SubMeshes) {
+                BoundingBox boxWS{};
+                submesh.m_BoundingBox.Transform(boxWS, localToWorld);
+                shadowRenderer.AddCaster(*mesh, submesh, boxWS,
+                    m_InstanceRow,
+                    m_MaterialRows[submesh.m_MaterialIndex],
+                    m_MaterialSRVs[submesh.m_MaterialIndex]);
+            }
+        }
+    }
+}
@@ -3,23 +3,34 @@
 #define __MODEL_H__
 
 #include "Mesh.h"
+#include "Material.h"
 #include "Renderer/TextureManager.h"
 #include "Math/Transform.h"
 
 namespace DSM {
     class MeshRenderer;
+    class ShadowRenderer;
 
     // 模型的数据
     struct Model
     {
-        void Render(MeshRenderer& meshRenderer, GpuBuffer& meshConstant, const Transform& meshTransforms);
+        void Render(MeshRenderer& meshRenderer, const Transform& meshTransforms);
+        // 在 Render 之前把视锥内的遮挡体加入 meshRenderer 的遮挡剔除
+        void RenderOccluders(MeshRenderer& meshRenderer, const Transform& meshTransforms);
+        // 所有子网格都作为投射体，是否绘制到各个级联由 shadowRenderer 剔除
+        void RenderShadowCasters(ShadowRenderer& shadowRenderer, const Transform& meshTransforms);
         
         std::string m_Name{};
         DirectX::BoundingBox m_BoundingBox{};
         std::vector<std::shared_ptr<Mesh>> m_Meshes{};
         std::vector<std::shared_ptr<Material>> m_Materials{};
         std::vector<TextureRef> m_Textures{};
-        GpuBuffer m_MaterialData{};
+        // 每个材质使用的纹理，流式纹理的 SRV 会被重写，因此绘制时使用动态描述符
+        std::vector<std::array<TextureRef, kNumTextures>> m_MaterialTextures{};
+        std::vector<std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures>> m_MaterialSRVs{};
+        // 在 GPU 场景中的行
+        std::uint32_t m_InstanceRow{};
+        std::vector<std::uint32_t> m_MaterialRows{};
     };
 
 }
@@ -5,11 +5,17 @@
 #include "Geometry.h"
 #include "Material.h"
 #include "Renderer.h"
+#include "GpuScene.h"
+#include "RayTracing/BVH.h"
 #include "Graphics/CommandList/CommandList.h"
 #include "Graphics/GraphicsCommon.h"
+#include "Utilities/ParallelFor.h"
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 
 #include "ConstantData.h"
+#include "Core/Profiler.h"
 
 using namespace DirectX;
 
@@ -29,11 +35,50 @@ namespace DSM {
 		std::uint16_t m_PSOFlags;
 	};
 
+	// 节点导入之后先收集起来，网格的转换、LOD 的生成与拼接都按网格并行，最后按节点的顺序上传
+	struct PendingMesh
+	{
+		std::shared_ptr<Mesh> m_Mesh{};
+		// 节点引用的 Assimp 网格，转换的结果按相同的顺序写入 m_MeshDatas
+		std::vector<const aiMesh*> m_SourceMeshes{};
+		std::vector<MeshData> m_MeshDatas{};
+	};
+
+	// 所有子网格拼接之后的顶点流与索引，LOD 的索引追加在原始索引之后
+	struct MeshBuffers
+	{
+		std::vector<XMFLOAT3> m_Positions{};
+		std::vector<XMFLOAT3> m_Normals{};
+		std::vector<XMFLOAT2> m_Texcoords{};
+		std::vector<XMFLOAT4> m_Tangents{};
+		std::vector<std::uint32_t> m_Indices{};
+	};
+
 	
-    void ProcessNode(Model& model, aiNode* node, const aiScene* scene);
-    void ProcessMaterial(Model& model,const std::string& filename,const aiScene* scene);
-    MeshData ProcessMesh(aiMesh* mesh);
-    void CreateMesh(Mesh& mesh, const std::span<MeshData>& meshDatas);
+    void ProcessNode(std::vector<PendingMesh>& pendingMeshes, aiNode* node, const aiScene* scene);
+    void ProcessScene(Model& model, const std::string& filename, const aiScene* scene, std::span<PendingMesh> pendingMeshes);
+    void ProcessMaterial(Model& model, const std::string& filename, const aiScene* scene, UINT materialIndex, std::vector<TextureRef>& textures);
+    void CommitMaterials(Model& model, const aiScene* scene);
+    MeshData ProcessMesh(const aiMesh* mesh);
+    MeshLODChain GenerateLODChain(std::span<const MeshData> meshDatas);
+    std::vector<MeshLODChain> GenerateLODChains(const std::string& filename, std::span<const PendingMesh> pendingMeshes);
+    MeshBuffers AssembleMesh(Mesh& mesh, std::span<const MeshData> meshDatas, const MeshLODChain* lodChain);
+    void UploadMesh(Mesh& mesh, const MeshBuffers& buffers);
+    void CreateMesh(Mesh& mesh, const std::span<MeshData>& meshDatas, const MeshLODChain* lodChain = nullptr);
+	std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures> GetDefaultMaterialSRVs();
+
+	// 每个线程依次取下一项，适合耗时相差很大的任务，func 的参数为项的序号
+	template <typename Func>
+	void ParallelForEachItem(std::uint32_t count, Func&& func)
+	{
+		auto numThreads = (std::min)((std::max)(std::thread::hardware_concurrency(), 1u), count);
+		std::atomic<std::uint32_t> nextItem{0};
+		Utility::ParallelFor(numThreads, numThreads, [&](std::uint32_t, std::uint32_t) {
+			for (auto i = nextItem++; i < count; i = nextItem++) {
+				func(i);
+			}
+		});
+	}
 
 	
 	std::shared_ptr<Model> LoadModelFromeGeometry(const std::string& name, const Geometry::GeometryMesh& geometryMesh)
@@ -45,6 +90,8 @@ namespace DSM {
 		auto model = std::make_shared<Model>();
 		model->m_Name = name;
 		model->m_Materials.emplace_back(std::make_shared<Material>());
+		model->m_MaterialTextures.resize(1);
+		model->m_MaterialSRVs.push_back(GetDefaultMaterialSRVs());
 		auto& mesh = model->m_Meshes.emplace_back(std::make_shared<Mesh>());
 		mesh->m_Name = name;
 
@@ -54,6 +101,11 @@ namespace DSM {
 		meshData.m_MaterialIndex = 0;
 		meshData.m_BoundingBox = BoundingBox{};
 		meshData.m_PSOFlags |= kHasPosition | kHasNormal | kHasTangent | kHasUV;
+		meshData.m_Positions.reserve(geometryMesh.m_Vertices.size());
+		meshData.m_Normals.reserve(geometryMesh.m_Vertices.size());
+		meshData.m_Texcoords.reserve(geometryMesh.m_Vertices.size());
+		meshData.m_Tangents.reserve(geometryMesh.m_Vertices.size());
+		meshData.m_Bitangents.reserve(geometryMesh.m_Vertices.size());
 		for (const auto& vertex : geometryMesh.m_Vertices) {
 			meshData.m_Positions.push_back(vertex.m_Position);
 			meshData.m_Normals.push_back(vertex.m_Normal);
@@ -62,7 +114,8 @@ namespace DSM {
 			meshData.m_Bitangents.push_back(vertex.m_BiTangent);
 		}
 
-		CreateMesh(*mesh, {&meshData, 1});
+		auto lodChain = Mesh::sm_GenerateLODs ? GenerateLODChain({&meshData, 1}) : MeshLODChain{};
+		CreateMesh(*mesh, {&meshData, 1}, &lodChain);
 
 		model->m_BoundingBox = mesh->m_BoundingBox;
 		
@@ -71,6 +124,7 @@ namespace DSM {
 
 	std::shared_ptr<Model> LoadModel(const std::string& filename)
 	{
+		PROFILE_SCOPE("LoadModel");
 		auto model = std::make_shared<Model>();
 		
 		Assimp::Importer importer;
@@ -90,8 +144,25 @@ namespace DSM {
 			return nullptr;
 		}
 
-		ProcessNode(*model, pScene->mRootNode, pScene);
-		ProcessMaterial(*model, filename, pScene);
+		std::vector<PendingMesh> pendingMeshes{};
+		ProcessNode(pendingMeshes, pScene->mRootNode, pScene);
+		ProcessScene(*model, filename, pScene, pendingMeshes);
+		auto lodChains = GenerateLODChains(filename, pendingMeshes);
+
+		// 拼接与 BVH 的构建按网格并行，上传在当前线程按节点的顺序进行
+		std::vector<MeshBuffers> meshBuffers(pendingMeshes.size());
+		ParallelForEachItem(static_cast<std::uint32_t>(pendingMeshes.size()), [&](std::uint32_t i) {
+			auto& pending = pendingMeshes[i];
+			meshBuffers[i] = AssembleMesh(*pending.m_Mesh, pending.m_MeshDatas, lodChains.empty() ? nullptr : &lodChains[i]);
+			pending.m_MeshDatas = {};
+		});
+		model->m_Meshes.reserve(pendingMeshes.size());
+		for (std::size_t i = 0; i < pendingMeshes.size(); ++i) {
+			UploadMesh(*pendingMeshes[i].m_Mesh, meshBuffers[i]);
+			meshBuffers[i] = {};
+			model->m_Meshes.push_back(std::move(pendingMeshes[i].m_Mesh));
+		}
+		CommitMaterials(*model, pScene);
 
 		model->m_BoundingBox = BoundingBox{{0,0,0}, {0,0,0}};
 		model->m_Name = pScene->mRootNode->mName.C_Str();
@@ -99,32 +170,83 @@ namespace DSM {
 			BoundingBox::CreateMerged(model->m_BoundingBox, model->m_BoundingBox, mesh->m_BoundingBox);
 		}
 
+		// 只有相对于模型足够大的不透明网格才作为遮挡体
+		auto maxExtent = [](const BoundingBox& box) { return (std::max)({box.Extents.x, box.Extents.y, box.Extents.z}); };
+		float minOccluderExtent = maxExtent(model->m_BoundingBox) * Mesh::sm_MinOccluderSize;
+		for (const auto& mesh : model->m_Meshes) {
+			if (maxExtent(mesh->m_BoundingBox) < minOccluderExtent || (mesh->m_PSOFlags & (kAlphaBlend | kAlphaTest))) {
+				mesh->m_OccluderPositions = {};
+				mesh->m_OccluderIndices = {};
+			}
+		}
+
 		return model;
 	}
 
-	void ProcessNode(Model& model, aiNode* node, const aiScene* scene)
+	void ProcessNode(std::vector<PendingMesh>& pendingMeshes, aiNode* node, const aiScene* scene)
 	{
-		// 导入当前节点的网格
-		auto mesh = std::make_shared<Mesh>();
-		mesh->m_Name = node->mName.C_Str();
-		std::vector<MeshData> meshDatas{};
-		meshDatas.reserve(node->mNumMeshes);
-		for (UINT i = 0; i < node->mNumMeshes; ++i) {
-			meshDatas.emplace_back(ProcessMesh(scene->mMeshes[node->mMeshes[i]]));
-		}
-
-		if (!meshDatas.empty()) {
-			CreateMesh(*mesh, meshDatas);
-			model.m_Meshes.push_back(std::move(mesh));
+		// 只记录当前节点的网格，转换在 ProcessScene 中并行进行
+		if (node->mNumMeshes > 0) {
+			auto& pending = pendingMeshes.emplace_back();
+			pending.m_Mesh = std::make_shared<Mesh>();
+			pending.m_Mesh->m_Name = node->mName.C_Str();
+			pending.m_SourceMeshes.reserve(node->mNumMeshes);
+			for (UINT i = 0; i < node->mNumMeshes; ++i) {
+				pending.m_SourceMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+			}
+			pending.m_MeshDatas.resize(node->mNumMeshes);
 		}
 
 		// 导入子节点的网格
 		for (UINT i = 0; i < node->mNumChildren; ++i) {
-			ProcessNode(model, node->mChildren[i], scene);
+			ProcessNode(pendingMeshes, node->mChildren[i], scene);
+		}
+	}
+
+	void ProcessScene(Model& model, const std::string& filename, const aiScene* scene, std::span<PendingMesh> pendingMeshes)
+	{
+		PROFILE_SCOPE("ProcessScene");
+
+		// 材质与网格放在同一个任务队列中，材质需要解码纹理，耗时最长，排在最前面
+		// 网格按顶点数量从多到少排列，结果写入预先分配的位置，与任务的顺序无关
+		// 纹理在工作线程中上传，帧内会从当前帧的临时内存分配，FrameScheduler 的分配已加锁
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> meshJobs{};
+		for (std::uint32_t i = 0; i < pendingMeshes.size(); ++i) {
+			for (std::uint32_t j = 0; j < pendingMeshes[i].m_SourceMeshes.size(); ++j) {
+				meshJobs.emplace_back(i, j);
+			}
+		}
+		auto numVertices = [&](const std::pair<std::uint32_t, std::uint32_t>& job) {
+			return pendingMeshes[job.first].m_SourceMeshes[job.second]->mNumVertices;
+		};
+		std::stable_sort(meshJobs.begin(), meshJobs.end(), [&](const auto& a, const auto& b) {
+			return numVertices(a) > numVertices(b);
+		});
+
+		UINT numMaterials = scene->mNumMaterials;
+		model.m_Materials.resize(numMaterials);
+		model.m_MaterialTextures.resize(numMaterials);
+		model.m_MaterialSRVs.resize(numMaterials);
+		std::vector<std::vector<TextureRef>> materialTextures(numMaterials);
+
+		ParallelForEachItem(numMaterials + static_cast<std::uint32_t>(meshJobs.size()), [&](std::uint32_t i) {
+			if (i < numMaterials) {
+				ProcessMaterial(model, filename, scene, i, materialTextures[i]);
+			}
+			else {
+				auto [meshIndex, subMeshIndex] = meshJobs[i - numMaterials];
+				auto& pending = pendingMeshes[meshIndex];
+				pending.m_MeshDatas[subMeshIndex] = ProcessMesh(pending.m_SourceMeshes[subMeshIndex]);
+			}
+		});
+
+		// 纹理按材质的顺序合并
+		for (const auto& textures : materialTextures) {
+			model.m_Textures.insert(model.m_Textures.end(), textures.begin(), textures.end());
 		}
 	}
 
-	MeshData ProcessMesh(aiMesh* mesh)
+	MeshData ProcessMesh(const aiMesh* mesh)
 	{
 		MeshData meshData{};
 		meshData.m_Name = mesh->mName.C_Str();
@@ -156,7 +278,7 @@ namespace DSM {
 			}
 			if (!meshData.m_Tangents.empty()) {
 				meshData.m_Tangents[i] = {mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, 1.0f};
-				meshData.m_Bitangents[i] = {meshData.m_Bitangents[i].x, meshData.m_Bitangents[i].y, meshData.m_Bitangents[i].z};
+				meshData.m_Bitangents[i] = {mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z};
 			}
 		}
 
@@ -178,17 +300,165 @@ namespace DSM {
 		return meshData;
 	}
 
-	void CreateMesh(Mesh& mesh, const std::span<MeshData>& meshDatas)
+	MeshLODChain GenerateLODChain(std::span<const MeshData> meshDatas)
 	{
-		if (meshDatas.empty()) return;
-		
+		// 子网格的顶点与索引依次拼接，与 CreateMesh 中的布局相同，法线与纹理坐标作为属性参与误差
 		std::vector<XMFLOAT3> positions{};
-		std::vector<XMFLOAT3> normals{};
-		std::vector<XMFLOAT2> uvs{};
-		std::vector<XMFLOAT4> tangents{};
+		std::vector<float> attributes{};
 		std::vector<std::uint32_t> indices{};
+		std::vector<std::uint32_t> subMeshIndexCounts{};
+		std::size_t numVertices = 0, numIndices = 0;
+		for (const auto& meshData : meshDatas) {
+			numVertices += meshData.m_Positions.size();
+			numIndices += meshData.m_Indices.size();
+		}
+		positions.reserve(numVertices);
+		attributes.reserve(numVertices * 5);
+		indices.reserve(numIndices);
+		subMeshIndexCounts.reserve(meshDatas.size());
+		for (const auto& meshData : meshDatas) {
+			auto vertexOffset = static_cast<std::uint32_t>(positions.size());
+			positions.insert(positions.end(), meshData.m_Positions.begin(), meshData.m_Positions.end());
+			for (std::size_t i = 0; i < meshData.m_Positions.size(); ++i) {
+				auto normal = i < meshData.m_Normals.size() ? meshData.m_Normals[i] : XMFLOAT3{};
+				auto uv = i < meshData.m_Texcoords.size() ? meshData.m_Texcoords[i] : XMFLOAT2{};
+				attributes.insert(attributes.end(), {normal.x, normal.y, normal.z, uv.x, uv.y});
+			}
+			for (auto index : meshData.m_Indices) {
+				indices.push_back(index + vertexOffset);
+			}
+			subMeshIndexCounts.push_back(static_cast<std::uint32_t>(meshData.m_Indices.size()));
+		}
+
+		// 位置按包围盒最长边归一化，法线的权重过大会保留平滑表面上不必要的细节
+		static constexpr float attributeWeights[] = { 0.01f, 0.01f, 0.01f, 0.5f, 0.5f };
+		MeshSimplifierInput input{};
+		input.m_Positions = positions.data();
+		input.m_NumVertices = static_cast<std::uint32_t>(positions.size());
+		input.m_Attributes = attributes.data();
+		input.m_AttributeStride = sizeof(float) * 5;
+		input.m_NumAttributes = 5;
+		input.m_AttributeWeights = attributeWeights;
+		input.m_Indices = indices.data();
+		input.m_NumIndices = static_cast<std::uint32_t>(indices.size());
+		input.m_SubMeshIndexCounts = subMeshIndexCounts;
+		return GenerateMeshLODs(input, Mesh::sm_LODDesc);
+	}
+
+	std::vector<MeshLODChain> GenerateLODChains(const std::string& filename, std::span<const PendingMesh> pendingMeshes)
+	{
+		if (!Mesh::sm_GenerateLODs || pendingMeshes.empty()) return {};
+		PROFILE_SCOPE("GenerateLODChains");
+
+		// 缓存以源文件的绝对路径区分，生成参数改变时 key 不同
+		static constexpr std::uint32_t lodCacheVersion = 1;
+		std::uint64_t key = 0xcbf29ce484222325ull;
+		auto hashBytes = [&key](const void* data, std::size_t size) {
+			for (std::size_t i = 0; i < size; ++i) {
+				key ^= static_cast<const std::uint8_t*>(data)[i];
+				key *= 0x100000001b3ull;
+			}
+		};
+		const auto& desc = Mesh::sm_LODDesc;
+		hashBytes(&lodCacheVersion, sizeof(lodCacheVersion));
+		hashBytes(&desc.m_Ratio, sizeof(desc.m_Ratio));
+		hashBytes(&desc.m_MaxLevels, sizeof(desc.m_MaxLevels));
+		hashBytes(&desc.m_MinTriangles, sizeof(desc.m_MinTriangles));
+		hashBytes(&desc.m_MaxError, sizeof(desc.m_MaxError));
+		hashBytes(&desc.m_MinReduction, sizeof(desc.m_MinReduction));
+
+		std::filesystem::path cacheFilename{};
+		if (!Mesh::sm_LODCacheDirectory.empty()) {
+			std::error_code ec{};
+			auto absolutePath = std::filesystem::absolute(Utility::UTF8ToWString(filename), ec).lexically_normal();
+			std::string pathKey = ec ? filename : Utility::WStringToUTF8(absolutePath.wstring());
+			std::uint64_t pathHash = 0xcbf29ce484222325ull;
+			for (char c : pathKey) {
+				pathHash ^= static_cast<std::uint8_t>(c);
+				pathHash *= 0x100000001b3ull;
+			}
+			char suffix[32]{};
+			std::snprintf(suffix, sizeof(suffix), "_%016llx.lod", static_cast<unsigned long long>(pathHash));
+			auto stem = std::filesystem::path(Utility::UTF8ToWString(filename)).stem();
+			cacheFilename = std::filesystem::path(Utility::UTF8ToWString(Mesh::sm_LODCacheDirectory)) /
+				(stem.wstring() + Utility::UTF8ToWString(suffix));
+
+			// 缓存不比源文件旧且每个网格的顶点与索引数量一致时直接使用
+			auto sourceTime = std::filesystem::last_write_time(Utility::UTF8ToWString(filename), ec);
+			auto cacheTime = ec ? sourceTime : std::filesystem::last_write_time(cacheFilename, ec);
+			std::vector<MeshLODChain> chains{};
+			if (!ec && cacheTime >= sourceTime && LoadMeshLODCache(cacheFilename, key, chains) &&
+				chains.size() == pendingMeshes.size()) {
+				bool valid = true;
+				for (std::size_t i = 0; i < chains.size() && valid; ++i) {
+					std::uint32_t numVertices = 0, numIndices = 0;
+					for (const auto& meshData : pendingMeshes[i].m_MeshDatas) {
+						numVertices += static_cast<std::uint32_t>(meshData.m_Positions.size());
+						numIndices += static_cast<std::uint32_t>(meshData.m_Indices.size());
+					}
+					valid = chains[i].m_NumSourceVertices == numVertices && chains[i].m_NumSourceIndices == numIndices;
+				}
+				if (valid) return chains;
+			}
+		}
+
+		// 网格之间互不依赖
+		std::vector<MeshLODChain> chains(pendingMeshes.size());
+		ParallelForEachItem(static_cast<std::uint32_t>(pendingMeshes.size()), [&](std::uint32_t i) {
+			chains[i] = GenerateLODChain(pendingMeshes[i].m_MeshDatas);
+		});
+
+		// 写入缓存失败不影响本次加载
+		if (!cacheFilename.empty()) {
+			std::error_code ec{};
+			std::filesystem::create_directories(Utility::UTF8ToWString(Mesh::sm_LODCacheDirectory), ec);
+			bool saved = !ec && SaveMeshLODCache(cacheFilename, key, chains);
+			WARN_ONCE_IF_NOT(saved, "Failed to write mesh LOD cache {}", Utility::WStringToUTF8(cacheFilename.wstring()));
+		}
+
+		return chains;
+	}
+
+	void CreateMesh(Mesh& mesh, const std::span<MeshData>& meshDatas, const MeshLODChain* lodChain)
+	{
+		if (meshDatas.empty()) return;
+
+		UploadMesh(mesh, AssembleMesh(mesh, meshDatas, lodChain));
+	}
+
+	MeshBuffers AssembleMesh(Mesh& mesh, std::span<const MeshData> meshDatas, const MeshLODChain* lodChain)
+	{
+		MeshBuffers buffers{};
+		auto& positions = buffers.m_Positions;
+		auto& normals = buffers.m_Normals;
+		auto& uvs = buffers.m_Texcoords;
+		auto& tangents = buffers.m_Tangents;
+		auto& indices = buffers.m_Indices;
+
+		// 顶点流与索引只分配一次，LOD 的索引之后追加
+		std::size_t numVertices = 0, numNormals = 0, numUVs = 0, numTangents = 0, numIndices = 0;
+		for (const auto& meshData : meshDatas) {
+			numVertices += meshData.m_Positions.size();
+			numNormals += meshData.m_Normals.size();
+			numUVs += meshData.m_Texcoords.size();
+			numTangents += meshData.m_Tangents.size();
+			numIndices += meshData.m_Indices.size();
+		}
+		std::size_t numLODIndices = 0;
+		if (lodChain != nullptr) {
+			for (const auto& level : lodChain->m_Levels) {
+				numLODIndices += level.m_Indices.size();
+			}
+		}
+		positions.reserve(numVertices);
+		normals.reserve(numNormals);
+		uvs.reserve(numUVs);
+		tangents.reserve(numTangents);
+		indices.reserve(numIndices + numLODIndices);
 		
 		mesh.m_BoundingBox = BoundingBox{{0,0,0},{0,0,0}};
+		// 所有子网格共用顶点流，只保留都具有的属性
+		mesh.m_PSOFlags = 0xffff;
 
 		UINT preIndexCount = 0;
 		UINT preVertexCount = 0;
@@ -199,6 +469,7 @@ namespace DSM {
 			submesh.m_IndexCount = indexCount;
 			submesh.m_IndexOffset = preIndexCount;
 			submesh.m_VertexOffset = preVertexCount;
+			submesh.m_BoundingBox = meshData.m_BoundingBox;
 			mesh.m_SubMeshes.insert(std::make_pair(meshData.m_Name, std::move(submesh)));
 			
 			preIndexCount += indexCount;
@@ -206,17 +477,84 @@ namespace DSM {
 
 			std::uint16_t posNormalFlags = kHasPosition;
 			ASSERT((meshData.m_PSOFlags & posNormalFlags) != 0);
-			mesh.m_PSOFlags = 0xffff;
 			mesh.m_PSOFlags &= meshData.m_PSOFlags;
 			positions.insert(positions.end(), meshData.m_Positions.begin(), meshData.m_Positions.end());
 			normals.insert(normals.end(), meshData.m_Normals.begin(), meshData.m_Normals.end());
-			uvs.insert(uvs.begin(), meshData.m_Texcoords.begin(), meshData.m_Texcoords.end());
+			uvs.insert(uvs.end(), meshData.m_Texcoords.begin(), meshData.m_Texcoords.end());
 			tangents.insert(tangents.end(), meshData.m_Tangents.begin(), meshData.m_Tangents.end());
 			indices.insert(indices.end(), meshData.m_Indices.begin(), meshData.m_Indices.end());
 
 			BoundingBox::CreateMerged(mesh.m_BoundingBox, mesh.m_BoundingBox, meshData.m_BoundingBox);
 		}
 
+		// LOD 的索引追加在原始索引之后，减去子网格的顶点偏移后与原始子网格使用相同的 BaseVertexLocation
+		auto numSourceIndices = static_cast<std::uint32_t>(indices.size());
+		if (lodChain != nullptr && lodChain->m_NumSourceVertices == positions.size() && lodChain->m_NumSourceIndices == numSourceIndices) {
+			for (const auto& level : lodChain->m_Levels) {
+				if (level.m_SubMeshIndexCounts.size() != meshDatas.size()) break;
+				std::uint32_t levelOffset = 0;
+				std::uint32_t vertexOffset = 0;
+				for (std::size_t i = 0; i < meshDatas.size(); ++i) {
+					auto indexCount = level.m_SubMeshIndexCounts[i];
+					auto it = mesh.m_SubMeshes.find(meshDatas[i].m_Name);
+					auto dataVertexOffset = vertexOffset;
+					levelOffset += indexCount;
+					vertexOffset += static_cast<std::uint32_t>(meshDatas[i].m_Positions.size());
+					// 同名的子网格只保留了第一个
+					if (it->second.m_VertexOffset != dataVertexOffset) continue;
+
+					auto& submesh = it->second;
+					auto& lod = submesh.m_LODs.emplace_back();
+					lod.m_MaterialIndex = submesh.m_MaterialIndex;
+					lod.m_IndexCount = indexCount;
+					lod.m_IndexOffset = static_cast<std::uint32_t>(indices.size());
+					lod.m_VertexOffset = submesh.m_VertexOffset;
+					lod.m_BoundingBox = submesh.m_BoundingBox;
+					for (std::uint32_t j = levelOffset - indexCount; j < levelOffset; ++j) {
+						indices.push_back(level.m_Indices[j] - submesh.m_VertexOffset);
+					}
+				}
+				mesh.m_LODErrors.push_back(level.m_Error);
+			}
+		}
+
+		if (Mesh::sm_BuildBVH) {
+			std::vector<BVHGeometry> geometries{};
+			geometries.reserve(mesh.m_SubMeshes.size());
+			for (const auto& [name, submesh] : mesh.m_SubMeshes) {
+				auto& geometry = geometries.emplace_back();
+				geometry.m_Positions = positions.data();
+				geometry.m_NumVertices = static_cast<std::uint32_t>(positions.size());
+				geometry.m_Indices = indices.data() + submesh.m_IndexOffset;
+				geometry.m_NumIndices = submesh.m_IndexCount;
+				geometry.m_BaseVertex = submesh.m_VertexOffset;
+			}
+			mesh.m_BVH = std::make_shared<BVH>();
+			mesh.m_BVH->Build(geometries);
+		}
+
+		// 网格的大小在整个模型加载之后才能比较，过小的遮挡体在 LoadModel 中移除
+		if (Mesh::sm_BuildOccluder && numSourceIndices / 3 <= Mesh::sm_MaxOccluderTriangles) {
+			mesh.m_OccluderPositions = positions;
+			mesh.m_OccluderIndices.reserve(numSourceIndices);
+			for (const auto& [name, submesh] : mesh.m_SubMeshes) {
+				for (std::uint32_t i = 0; i < submesh.m_IndexCount; ++i) {
+					mesh.m_OccluderIndices.push_back(indices[submesh.m_IndexOffset + i] + submesh.m_VertexOffset);
+				}
+			}
+		}
+
+		return buffers;
+	}
+
+	void UploadMesh(Mesh& mesh, const MeshBuffers& buffers)
+	{
+		const auto& positions = buffers.m_Positions;
+		const auto& normals = buffers.m_Normals;
+		const auto& uvs = buffers.m_Texcoords;
+		const auto& tangents = buffers.m_Tangents;
+		const auto& indices = buffers.m_Indices;
+
 		std::uint32_t posByteSize = positions.size() * sizeof(XMFLOAT3);
 		std::uint32_t normalByteSize = normals.size() * sizeof(XMFLOAT3);
 		std::uint32_t uvsByteSize = uvs.size() * sizeof(XMFLOAT2);
@@ -226,6 +564,7 @@ namespace DSM {
 		GpuBufferDesc meshBufferDesc{};
 		meshBufferDesc.m_Flags = D3D12_RESOURCE_FLAG_NONE;
 		meshBufferDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
+		meshBufferDesc.m_Category = MemoryCategory::kMesh;
 		meshBufferDesc.m_Stride = 1;
 		meshBufferDesc.m_Size = posByteSize + normalByteSize + uvsByteSize + tangentsByteSize + indexByteSize;
 		mesh.m_MeshData.Create(L"MeshData: " + Utility::UTF8ToWString(mesh.m_Name), meshBufferDesc);
@@ -260,122 +599,111 @@ namespace DSM {
 	void ProcessMaterial(
 		Model& model,
 		const std::string& filename,
-		const aiScene* scene)
+		const aiScene* scene,
+		UINT materialIndex,
+		std::vector<TextureRef>& textures)
 	{
-		std::vector<std::uint32_t> srvOffsets(scene->mNumMaterials);
+		// 只写入该材质的位置，可以与其他材质和网格同时处理
+		auto& modelMaterial = model.m_Materials[materialIndex];
+		auto& material = scene->mMaterials[materialIndex];
+
+		modelMaterial = std::make_shared<Material>();
 		
-		model.m_Materials.resize(scene->mNumMaterials);
-		for (UINT i = 0; i < scene->mNumMaterials; ++i) {
-			auto& modelMaterial = model.m_Materials[i];
-			auto& material = scene->mMaterials[i];
+		XMFLOAT3 vector{};
+		std::uint32_t num = 3;
+		float value{};
+
+		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_BASE_COLOR, (float*)&vector, &num)) {
+			modelMaterial->m_BaseColor[0] = vector.x;
+			modelMaterial->m_BaseColor[1] = vector.y;
+			modelMaterial->m_BaseColor[2] = vector.z;
+			modelMaterial->m_BaseColor[3] = 1.0f;
+		}
+		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_EMISSIVE, (float*)&vector, &num)) {
+			modelMaterial->m_EmissiveColor[0] = vector.x;
+			modelMaterial->m_EmissiveColor[1] = vector.y;
+			modelMaterial->m_EmissiveColor[2] = vector.z;
+		}
+		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_METALLIC_FACTOR, value)) {
+			modelMaterial->m_MetallicFactor = value;
+		}
+		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_ROUGHNESS_FACTOR, value)) {
+			modelMaterial->m_RoughnessFactor = value;
+		}
 
-			modelMaterial = std::make_shared<Material>();
-			
-			XMFLOAT3 vector{};
-			std::uint32_t num = 3;
-			float value{};
-
-			if (aiReturn_SUCCESS == material->Get(AI_MATKEY_BASE_COLOR, (float*)&vector, &num)) {
-				modelMaterial->m_BaseColor[0] = vector.x;
-				modelMaterial->m_BaseColor[1] = vector.y;
-				modelMaterial->m_BaseColor[2] = vector.z;
-				modelMaterial->m_BaseColor[3] = 1.0f;
-			}
-			if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_EMISSIVE, (float*)&vector, &num)) {
-				modelMaterial->m_EmissiveColor[0] = vector.x;
-				modelMaterial->m_EmissiveColor[1] = vector.y;
-				modelMaterial->m_EmissiveColor[2] = vector.z;
-			}
-			if (aiReturn_SUCCESS == material->Get(AI_MATKEY_METALLIC_FACTOR, value)) {
-				modelMaterial->m_MetallicFactor = value;
-			}
-			if (aiReturn_SUCCESS == material->Get(AI_MATKEY_ROUGHNESS_FACTOR, value)) {
-				modelMaterial->m_RoughnessFactor = value;
-			}
+		aiString aiPath;
+		std::filesystem::path texFilename;
+		std::string texName;
 
-			aiString aiPath;
-			std::filesystem::path texFilename;
-			std::string texName;
-
-			D3D12_CPU_DESCRIPTOR_HANDLE defaultTexture[kNumTextures] = {
-				Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
-				Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
-				Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
-				Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
-				Graphics::GetDefaultTexture(Graphics::kBlackTransparent2D),
-				Graphics::GetDefaultTexture(Graphics::kDefaultNormalTex)
-			};
-			
-			D3D12_CPU_DESCRIPTOR_HANDLE srcHandle[kNumTextures];
+		auto& srcHandle = model.m_MaterialSRVs[materialIndex];
+		auto& materialTextures = model.m_MaterialTextures[materialIndex];
+		srcHandle = GetDefaultMaterialSRVs();
+		
+		auto tryCreateTexture = [&](aiTextureType type) {
+			MaterialTex materialTex;
+			switch (type) {
+				case aiTextureType_BASE_COLOR: materialTex = kBaseColor; break;
+				case aiTextureType_DIFFUSE_ROUGHNESS: materialTex = kDiffuseRoughness; break;
+				case aiTextureType_METALNESS: materialTex = kMetalness; break;
+				case aiTextureType_AMBIENT_OCCLUSION : materialTex = kOcclusion; break;
+				case aiTextureType_EMISSIVE: materialTex = kEmissive; break;
+				case aiTextureType_NORMALS: materialTex = kNormal; break;
+				default: materialTex = kBaseColor; break;
+			}
+			if (material->GetTextureCount(type) == 0) return;
 			
-			auto tryCreateTexture = [&](aiTextureType type) {
-				MaterialTex materialTex;
-				switch (type) {
-					case aiTextureType_BASE_COLOR: materialTex = kBaseColor; break;
-					case aiTextureType_DIFFUSE_ROUGHNESS: materialTex = kDiffuseRoughness; break;
-					case aiTextureType_METALNESS: materialTex = kMetalness; break;
-					case aiTextureType_AMBIENT_OCCLUSION : materialTex = kOcclusion; break;
-					case aiTextureType_EMISSIVE: materialTex = kEmissive; break;
-					case aiTextureType_NORMALS: materialTex = kNormal; break;
-					default: materialTex = kBaseColor; break;
-				}
-				if (material->GetTextureCount(type) == 0) {
-					srcHandle[materialTex] = defaultTexture[materialTex];
-					return;
-				}
-				
-				material->GetTexture(type, 0, &aiPath);
-
-				// 纹理已经预先加载进来
-				if (aiPath.data[0] == '*'){
-					texName = filename;
-					texName += aiPath.C_Str();
-					char* pEndStr = nullptr;
-					aiTexture* pTex = scene->mTextures[strtol(aiPath.data + 1, &pEndStr, 10)];
-					TextureDesc texDesc{};
-					texDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-					texDesc.m_Format = DXGI_FORMAT_UNKNOWN;
-					texDesc.m_Width = pTex->mWidth;
-					texDesc.m_Height = pTex->mHeight;
-					texDesc.m_MipLevels = 1;
-					texDesc.m_SampleDesc = {1,0};
-					texDesc.m_DepthOrArraySize = 1;
-					TextureRef& texRef = model.m_Textures.emplace_back(
-						g_TexManager.LoadTextureFromMemory(texName, texDesc, pTex->pcData));
-					srcHandle[materialTex] = texRef.GetSRV();
-				}
-				else {	// 纹理通过文件名索引
-					texFilename = filename;
-					texFilename = texFilename.parent_path() / aiPath.C_Str();
-					auto texRef = g_TexManager.LoadTextureFromFile(texFilename.string());
-					model.m_Textures.push_back(texRef);
-					srcHandle[materialTex] = texRef.GetSRV();
+			material->GetTexture(type, 0, &aiPath);
+
+			// 纹理已经预先加载进来
+			if (aiPath.data[0] == '*'){
+				texName = filename;
+				texName += aiPath.C_Str();
+				char* pEndStr = nullptr;
+				aiTexture* pTex = scene->mTextures[strtol(aiPath.data + 1, &pEndStr, 10)];
+				TextureDesc texDesc{};
+				texDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+				texDesc.m_Format = DXGI_FORMAT_UNKNOWN;
+				texDesc.m_Width = pTex->mWidth;
+				texDesc.m_Height = pTex->mHeight;
+				texDesc.m_MipLevels = 1;
+				texDesc.m_SampleDesc = {1,0};
+				texDesc.m_DepthOrArraySize = 1;
+				TextureRef& texRef = textures.emplace_back(
+					g_TexManager.LoadTextureFromMemory(texName, texDesc, pTex->pcData));
+				srcHandle[materialTex] = texRef.GetSRV();
+			}
+			else {	// 纹理通过文件名索引
+				texFilename = filename;
+				texFilename = texFilename.parent_path() / aiPath.C_Str();
+				// 按材质槽选择块压缩格式
+				TextureUsage usage = TextureUsage::kColor;
+				switch (materialTex) {
+					case kMetalness:
+					case kOcclusion: usage = TextureUsage::kGrayscale; break;
+					case kNormal: usage = TextureUsage::kNormalMap; break;
+					default: break;
 				}
-			};
-			// 加载纹理
-			tryCreateTexture(aiTextureType_BASE_COLOR);
-			tryCreateTexture(aiTextureType_DIFFUSE_ROUGHNESS);
-			tryCreateTexture(aiTextureType_METALNESS);
-			tryCreateTexture(aiTextureType_AMBIENT_OCCLUSION);
-			tryCreateTexture(aiTextureType_EMISSIVE);
-			tryCreateTexture(aiTextureType_NORMALS);
-
-			// 将纹理描述符拷贝到纹理堆中
-			DescriptorHandle texHandle = g_Renderer.m_TextureHeap.Allocate(kNumTextures);
-
-			std::uint32_t destCount = kNumTextures;
-			std::uint32_t srcCount[kNumTextures] = {1,1,1,1,1,1};
-			g_RenderContext.GetDevice()->CopyDescriptors(
-				1, &texHandle, &destCount, destCount, srcHandle, srcCount, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-			srvOffsets[i] = g_Renderer.m_TextureHeap.GetOffsetOfHandle(texHandle);
-		}
+				auto texRef = g_TexManager.LoadTextureFromFile(texFilename.string(), false, usage);
+				textures.push_back(texRef);
+				materialTextures[materialTex] = texRef;
+				srcHandle[materialTex] = texRef.GetSRV();
+			}
+		};
+		// 加载纹理
+		tryCreateTexture(aiTextureType_BASE_COLOR);
+		tryCreateTexture(aiTextureType_DIFFUSE_ROUGHNESS);
+		tryCreateTexture(aiTextureType_METALNESS);
+		tryCreateTexture(aiTextureType_AMBIENT_OCCLUSION);
+		tryCreateTexture(aiTextureType_EMISSIVE);
+		tryCreateTexture(aiTextureType_NORMALS);
+	}
 
+	void CommitMaterials(Model& model, const aiScene* scene)
+	{
 		for (auto& mesh : model.m_Meshes) {
 			int psoFlags = 0;
 			std::uint32_t num = 1;
 			for (auto& [name, submesh] : mesh->m_SubMeshes) {
-				submesh.m_SRVTableOffset = srvOffsets[submesh.m_MaterialIndex];
 				auto& material = scene->mMaterials[submesh.m_MaterialIndex];
 				if (aiReturn_SUCCESS == material->Get(AI_MATKEY_TWOSIDED, &psoFlags, &num)) {
 					mesh->m_PSOFlags |= (psoFlags == 0) ? mesh->m_PSOFlags : kBothSide;
@@ -384,16 +712,28 @@ namespace DSM {
 			mesh->m_PSOIndex = g_Renderer.GetPSO(mesh->m_PSOFlags);
 		}
 
-		std::vector<MaterialConstants> materialConstants(model.m_Materials.size());
+		// 材质与实例写入 GPU 场景，在下一次绘制前上传
+		model.m_MaterialRows.resize(model.m_Materials.size());
 		for (std::size_t i = 0; i < model.m_Materials.size(); i++) {
-			memcpy(&materialConstants[i], model.m_Materials[i].get(), sizeof(MaterialConstants));
-		}
-		GpuBufferDesc bufferDesc = {};
-		bufferDesc.m_Size = sizeof(MaterialConstants) * materialConstants.size();
-		bufferDesc.m_Stride = sizeof(MaterialConstants);
-		bufferDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
-		auto matBufferName = L"Model MaterialData" + Utility::UTF8ToWString(model.m_Name);
-		model.m_MaterialData.Create(matBufferName, bufferDesc, materialConstants.data());
+			MaterialConstants materialConstants{};
+			// Material 只有纹理索引之前的部分与常量的布局相同
+			memcpy(&materialConstants, model.m_Materials[i].get(), offsetof(Material, m_TextureIndices));
+			model.m_MaterialRows[i] = g_GpuScene.AllocateMaterial();
+			g_GpuScene.WriteMaterial(model.m_MaterialRows[i], materialConstants);
+		}
+		model.m_InstanceRow = g_GpuScene.AllocateInstance();
+	}
+	
+	std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures> GetDefaultMaterialSRVs()
+	{
+		return {
+			Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
+			Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
+			Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
+			Graphics::GetDefaultTexture(Graphics::kWhiteOpaque2D),
+			Graphics::GetDefaultTexture(Graphics::kBlackTransparent2D),
+			Graphics::GetDefaultTexture(Graphics::kDefaultNormalTex)
+		};
 	}
 	
 }
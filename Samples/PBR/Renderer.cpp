@@ -1,7 +1,8 @@
 #include "Renderer.h"
 #include "Graphics/RenderContext.h"
 #include "Graphics/CommandList/GraphicsCommandList.h"
-#include "Mesh.h"
+#include "Core/Profiler.h"
+#include "GpuScene.h"
 
 
 namespace DSM {
@@ -10,28 +11,34 @@ namespace DSM {
     {
         if(m_Initialized) return;
 
-        // 分配描述符
-        m_ColorTexRTV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-        m_ColorTexSRV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        m_DepthTexDSV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-        m_DepthTexSRV = g_RenderContext.AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
         auto& swapChain = g_RenderContext.GetSwapChain();
-        CreateResource(swapChain.GetWidth(), swapChain.GetHeight());
 
         // 创建根签名
         m_CommonRootSig.InitStaticSampler(0, Graphics::SamplerAnisoWrap);
-        m_CommonRootSig[kMeshConstants].InitAsConstantBuffer(kMeshConstants);
+        // SamplerShadow 使用的不是比较过滤，阴影需要双线性的比较采样
+        auto shadowSampler = Graphics::SamplerShadow;
+        shadowSampler.Filter = D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+        m_CommonRootSig.InitStaticSampler(1, shadowSampler, D3D12_SHADER_VISIBILITY_PIXEL);
+        m_CommonRootSig[kInstanceIndices].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_VERTEX, 1);
         m_CommonRootSig[kMaterialConstants].InitAsConstantBuffer(kMaterialConstants);
         m_CommonRootSig[kPassConstants].InitAsConstantBuffer(kPassConstants);
         m_CommonRootSig[kMaterialSRVs].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 10);
+        m_CommonRootSig[kSceneInstances].InitAsBufferSRV(1, D3D12_SHADER_VISIBILITY_VERTEX, 1);
+        m_CommonRootSig[kLights].InitAsBufferSRV(2, D3D12_SHADER_VISIBILITY_PIXEL, 1);
+        m_CommonRootSig[kClusterRanges].InitAsBufferSRV(3, D3D12_SHADER_VISIBILITY_PIXEL, 1);
+        m_CommonRootSig[kClusterLightIndices].InitAsBufferSRV(4, D3D12_SHADER_VISIBILITY_PIXEL, 1);
+        m_CommonRootSig[kShadowMap].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1, D3D12_SHADER_VISIBILITY_PIXEL, 2);
         m_CommonRootSig.Finalize(L"Renderer::CommonRootSig", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
+        m_DrawIndirectSig[0].ShaderResourceView(kInstanceIndices);
+        m_DrawIndirectSig[1].DrawIndex();
+        m_DrawIndirectSig.Finalize(&m_CommonRootSig, IndirectDrawPacker::sm_RecordStride);
+
 		m_DefaultPSO.SetRootSignature(m_CommonRootSig);
         m_DefaultPSO.SetBlendState(Graphics::DefaultAlphaBlend);
         m_DefaultPSO.SetDepthStencilState(Graphics::ReadWriteDepthStencil);
         m_DefaultPSO.SetRasterizerState(Graphics::DefaultRasterizer);
-        m_DefaultPSO.SetRenderTargetFormat(m_ColorTex.GetFormat(), m_DepthTex.GetFormat());
+        m_DefaultPSO.SetRenderTargetFormat(swapChain.GetBackBuffer()->GetFormat(), sm_DepthFormat);
         m_DefaultPSO.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
 
         ShaderDesc vsDesc{};
@@ -52,21 +59,47 @@ namespace DSM {
         psDesc.m_Defines.AddDefine("USE_TANGENT", "1");
         m_PSUseTangent = std::make_unique<ShaderByteCode>(psDesc);
 
+        ShaderDesc shadowDesc{};
+        shadowDesc.m_Type = ShaderType::Vertex;
+        shadowDesc.m_Mode = ShaderMode::SM_6_1;
+        shadowDesc.m_FileName = "Shaders/DepthOnly.hlsl";
+        shadowDesc.m_EnterPoint = "DepthOnlyPassVS";
+        m_ShadowVS = std::make_unique<ShaderByteCode>(shadowDesc);
+        shadowDesc.m_Type = ShaderType::Pixel;
+        shadowDesc.m_EnterPoint = "DepthOnlyPassPS";
+        shadowDesc.m_Defines.AddDefine("ALPHA_TEST", "1");
+        m_ShadowAlphaTestPS = std::make_unique<ShaderByteCode>(shadowDesc);
+
+        // 阴影的深度反向，与 ShadowRasterizer 的负偏移以及阴影采样的比较方式一致
+        auto shadowDepthState = Graphics::ReadWriteDepthStencil;
+        shadowDepthState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER_EQUAL;
+        std::vector<D3D12_INPUT_ELEMENT_DESC> shadowInputElements;
+        shadowInputElements.emplace_back("POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT);
+        shadowInputElements.emplace_back("TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT);
+        auto initShadowPSO = [&](GraphicsPSO& pso, const D3D12_RASTERIZER_DESC& rasterizer) {
+            pso.SetRootSignature(m_CommonRootSig);
+            pso.SetBlendState(Graphics::NoColorWriteBlend);
+            pso.SetDepthStencilState(shadowDepthState);
+            pso.SetRasterizerState(rasterizer);
+            pso.SetRenderTargetFormats(0, nullptr, sm_ShadowDepthFormat);
+            pso.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+            pso.SetInputLayout(shadowInputElements);
+            pso.SetVertexShader(*m_ShadowVS);
+        };
+        initShadowPSO(m_ShadowPSO, Graphics::ShadowRasterizer);
+        m_ShadowPSO.Finalize();
+        // 透明度测试的网格通常为双面的植被
+        initShadowPSO(m_ShadowAlphaTestPSO, Graphics::ShadowBothSidedRasterizer);
+        m_ShadowAlphaTestPSO.SetPixelShader(*m_ShadowAlphaTestPS);
+        m_ShadowAlphaTestPSO.Finalize();
+
         m_Initialized = true;
     }
 
     void Renderer::Shutdown()
     {
-        // 释放描述符
-        g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, m_ColorTexRTV);
-        g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_ColorTexSRV);
-        g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, m_DepthTexDSV);
-        g_RenderContext.FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_DepthTexSRV);
-    }
-
-    void Renderer::OnResize(uint32_t width, uint32_t height)
-    {
-        CreateResource(width, height);
+        m_DrawIndirectSig.Destroy();
+        m_Initialized = false;
     }
 
 
@@ -101,38 +134,12 @@ namespace DSM {
         return m_PSOs.size() - 1;
     }
 
-    void Renderer::CreateResource(uint32_t width, uint32_t height)
-    {
-        auto& swapChain = g_RenderContext.GetSwapChain();
-
-        // 创建渲染相关的资源
-        TextureDesc colTexDesc{};
-        colTexDesc.m_Width = width;
-        colTexDesc.m_Height = height;
-        colTexDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-        colTexDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-        colTexDesc.m_Format = swapChain.GetBackBuffer()->GetDesc().m_Format;
-        m_ColorTex.Create(L"Renderer::ColorTexture", colTexDesc);
-
-        D3D12_CLEAR_VALUE clearValue{};
-        clearValue.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-        clearValue.DepthStencil = { .Depth = 1, .Stencil = 0 };
-        auto depthTexDesc = colTexDesc;
-        depthTexDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-        depthTexDesc.m_Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-        m_DepthTex.Create(L"Renderer::DepthTexture", depthTexDesc, {}, D3D12_RESOURCE_STATE_COMMON, &clearValue);
-
-        // 创建资源视图
-        m_ColorTex.CreateRenderTargetView(m_ColorTexRTV);
-        m_ColorTex.CreateShaderResourceView(m_ColorTexSRV);
-        m_DepthTex.CreateDepthStencilView(m_DepthTexDSV);
-        m_DepthTex.CreateShaderResourceView(m_DepthTexSRV);
-    }
-
     Renderer::Renderer()
-        :m_TextureHeap(L"Renderer::TextureHeap", D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096),
-        m_CommonRootSig(kNumRootBindings, 1),
-        m_DefaultPSO(L"Renderer::DefaultPSO") {}
+        :m_CommonRootSig(kNumRootBindings, 2),
+        m_DefaultPSO(L"Renderer::DefaultPSO"),
+        m_DrawIndirectSig(2),
+        m_ShadowPSO(L"Renderer::ShadowPSO"),
+        m_ShadowAlphaTestPSO(L"Renderer::ShadowAlphaTestPSO") {}
 
 
 
@@ -144,9 +151,13 @@ namespace DSM {
     
     void MeshRenderer::Render(GraphicsCommandList &cmdList, PassConstants &passConstants)
     {
+        PROFILE_SCOPE("MeshRenderer::Render");
         ASSERT(m_DepthTex != nullptr, "Depth texture is not set!");
 		ASSERT(m_RenderCamera != nullptr, "Render camera is not set!");
 
+        // Model::Render 写入的实例在绘制前上传
+        g_GpuScene.Update(cmdList);
+
         auto cameraPos = m_RenderCamera->GetPosition();
         passConstants.m_CameraPos[0] = cameraPos.GetX();
         passConstants.m_CameraPos[1] = cameraPos.GetY();
@@ -156,6 +167,9 @@ namespace DSM {
         passConstants.m_Proj = Math::Matrix4::Transpose(m_RenderCamera->GetProjMatrix());
         passConstants.m_ProjInv = Math::Matrix4::InverseTranspose(m_RenderCamera->GetProjMatrix());
 
+        cmdList.SetRootSignature(g_Renderer.m_CommonRootSig);
+        SetClusteredLights(cmdList, passConstants);
+
         cmdList.TransitionResource(*m_DepthTex, D3D12_RESOURCE_STATE_DEPTH_WRITE);
         cmdList.ClearDepth(m_DepthTexDSV);
         
@@ -169,23 +183,97 @@ namespace DSM {
         }
         cmdList.SetRenderTargets(rtvs, m_DepthTexDSV);
 
-        cmdList.SetRootSignature(g_Renderer.m_CommonRootSig);
-        cmdList.SetDescriptorHeap(g_Renderer.m_TextureHeap.GetHeap());
-
         cmdList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
         cmdList.SetDynamicConstantBuffer(Renderer::kPassConstants, sizeof(passConstants), &passConstants);
 
         cmdList.SetViewportAndScissor(m_RenderCamera->GetViewPort(), m_Scissor);
+        if (m_ShadowMapSRV.ptr != 0) {
+            cmdList.SetDynamicDescriptor(Renderer::kShadowMap, 0, m_ShadowMapSRV);
+        }
         
-        for(const auto& [key, obj] : m_SortObjects){
-            auto& mesh = *obj.m_Mesh;
+        m_Batcher.Build();
+        if (m_SortObjects.empty()) return;
+
+        // 实例的数据常驻 GPU 场景，每帧只按批次顺序上传实例所在的行
+        auto instanceOrder = m_Batcher.GetInstanceOrder();
+        auto instanceIndices = cmdList.GetUploadBuffer(instanceOrder.size() * sizeof(std::uint32_t));
+        auto indexData = reinterpret_cast<std::uint32_t*>(instanceIndices.m_MappedAddress);
+        for (std::size_t i = 0; i < instanceOrder.size(); ++i) {
+            indexData[i] = m_SortObjects[instanceOrder[i]].m_InstanceRow;
+        }
+        cmdList.SetShaderResource(Renderer::kSceneInstances, g_GpuScene.GetInstanceBuffer());
+
+        if (sm_EnableIndirectDraw) {
+            DrawIndirect(cmdList, instanceIndices);
+        }
+        else {
+            DrawBatches(cmdList, instanceIndices);
+        }
+    }
 
-            cmdList.SetPipelineState(g_Renderer.m_PSOs[mesh.m_PSOIndex]);
+    void MeshRenderer::DrawBatches(GraphicsCommandList& cmdList, const GpuResourceLocation& instanceIndices)
+    {
+        auto instanceOrder = m_Batcher.GetInstanceOrder();
+        const Mesh* currMesh = nullptr;
+        for (const auto& batch : m_Batcher.GetBatches()) {
+            const auto& obj = m_SortObjects[instanceOrder[batch.m_FirstInstance]];
+
+            cmdList.SetShaderResource(Renderer::kInstanceIndices, *instanceIndices.m_Resource,
+                instanceIndices.m_Offset + batch.m_FirstInstance * sizeof(std::uint32_t));
+            SetMeshState(cmdList, obj, currMesh);
+            cmdList.DrawIndexedInstanced(obj.m_SubMesh->m_IndexCount, batch.m_NumInstances,
+                obj.m_SubMesh->m_IndexOffset, obj.m_SubMesh->m_VertexOffset, 0);
+        }
+    }
+
+    void MeshRenderer::DrawIndirect(GraphicsCommandList& cmdList, const GpuResourceLocation& instanceIndices)
+    {
+        // 每个批次为一条记录，同一网格与材质的不同子网格在一次 ExecuteIndirect 中提交
+        auto instanceOrder = m_Batcher.GetInstanceOrder();
+        m_IndirectPacker.Clear();
+        for (const auto& batch : m_Batcher.GetBatches()) {
+            auto draw = instanceOrder[batch.m_FirstInstance];
+            const auto& obj = m_SortObjects[draw];
+
+            IndirectBucketKey key{};
+            key.m_PSOIndex = batch.m_PSOIndex;
+            key.m_Mesh = reinterpret_cast<std::uint64_t>(obj.m_Mesh);
+            key.m_Material = obj.m_MaterialRow;
+
+            IndirectDrawIndexedArgs args{};
+            args.m_IndexCountPerInstance = obj.m_SubMesh->m_IndexCount;
+            args.m_InstanceCount = batch.m_NumInstances;
+            args.m_StartIndexLocation = obj.m_SubMesh->m_IndexOffset;
+            args.m_BaseVertexLocation = obj.m_SubMesh->m_VertexOffset;
+
+            m_IndirectPacker.Add(draw, key,
+                instanceIndices.m_GpuAddress + batch.m_FirstInstance * sizeof(std::uint32_t), args,
+                !(obj.m_Mesh->m_PSOFlags & kAlphaBlend));
+        }
+        m_IndirectPacker.Build();
+
+        // 上传堆处于 GENERIC_READ 状态，可以直接作为参数缓冲
+        auto records = m_IndirectPacker.GetRecords();
+        auto argumentBuffer = cmdList.GetUploadBuffer(records.size_bytes(), IndirectDrawPacker::sm_RecordStride);
+        memcpy(argumentBuffer.m_MappedAddress, records.data(), records.size_bytes());
+
+        const Mesh* currMesh = nullptr;
+        for (const auto& bucket : m_IndirectPacker.GetBuckets()) {
+            SetMeshState(cmdList, m_SortObjects[bucket.m_Draw], currMesh);
+            cmdList.ExecuteIndirect(g_Renderer.m_DrawIndirectSig, *argumentBuffer.m_Resource,
+                argumentBuffer.m_Offset + bucket.m_FirstRecord * IndirectDrawPacker::sm_RecordStride,
+                bucket.m_NumRecords);
+        }
+    }
 
-            cmdList.SetConstantBuffer(Renderer::kMeshConstants, obj.m_MeshCBV);
-            cmdList.SetConstantBuffer(Renderer::kMaterialConstants, obj.m_MaterialCBV);
+    void MeshRenderer::SetMeshState(GraphicsCommandList& cmdList, const SortObject& obj, const Mesh*& currMesh)
+    {
+        auto& mesh = *obj.m_Mesh;
+        cmdList.SetPipelineState(g_Renderer.m_PSOs[mesh.m_PSOIndex]);
+        cmdList.SetConstantBuffer(Renderer::kMaterialConstants, g_GpuScene.GetMaterialCBV(obj.m_MaterialRow));
 
+        if (currMesh != &mesh) {
             std::vector<D3D12_VERTEX_BUFFER_VIEW> vertexData(3);
             vertexData[0] = mesh.m_PositionStream;
             vertexData[1] = mesh.m_UVStream;
@@ -195,15 +283,42 @@ namespace DSM {
             } 
             cmdList.SetVertexBuffers(0, vertexData);
             cmdList.SetIndexBuffer(mesh.m_IndexBufferViews);
+            currMesh = &mesh;
+        }
 
-            for(const auto& [name, submesh] : mesh.m_SubMeshes){
-                auto handle = g_Renderer.m_TextureHeap[submesh.m_SRVTableOffset];
+        auto materialSRVs = obj.m_MaterialSRVs;
+        cmdList.SetDynamicDescriptors(Renderer::kMaterialSRVs, 0, materialSRVs);
+    }
 
-                cmdList.SetDescriptorTable(Renderer::kMaterialSRVs, handle);
-                cmdList.DrawIndexed(submesh.m_IndexCount, 
-                    submesh.m_IndexOffset, submesh.m_VertexOffset);
-            }
+    void MeshRenderer::SetClusteredLights(GraphicsCommandList& cmdList, PassConstants& passConstants)
+    {
+        PROFILE_SCOPE("MeshRenderer::SetClusteredLights");
+        passConstants.m_Clusters = {};
+        if (m_LightCuller != nullptr) {
+            ClusterCameraDesc camera{};
+            DirectX::XMStoreFloat4x4(reinterpret_cast<DirectX::XMFLOAT4X4*>(camera.m_View), m_RenderCamera->GetViewMatrix());
+            camera.m_FovY = m_RenderCamera->GetFovY();
+            camera.m_Aspect = m_RenderCamera->GetAspectRatio();
+            camera.m_NearZ = m_RenderCamera->GetNearZ();
+            camera.m_FarZ = m_RenderCamera->GetFarZ();
+            camera.m_ReversedZ = m_RenderCamera->IsReversedZ();
+            camera.m_Width = m_RenderCamera->GetViewPort().Width;
+            camera.m_Height = m_RenderCamera->GetViewPort().Height;
+            m_LightCuller->SetCamera(camera);
+            m_LightCuller->AssignLights(m_LightBounds);
+            passConstants.m_Clusters = m_LightCuller->GetConstants();
         }
+
+        // 根描述符不能为空，没有数据时上传一个元素
+        auto setBuffer = [&cmdList](std::uint32_t rootIndex, const void* data, std::size_t size, std::size_t stride) {
+            static const std::uint8_t zeros[sizeof(SpotLight)]{};
+            cmdList.SetDynamicSRV(rootIndex, size != 0 ? size : stride, size != 0 ? data : zeros);
+        };
+        auto ranges = m_LightCuller != nullptr ? m_LightCuller->GetClusterRanges() : std::span<const ClusterLightRange>{};
+        auto indices = m_LightCuller != nullptr ? m_LightCuller->GetLightIndices() : std::span<const std::uint32_t>{};
+        setBuffer(Renderer::kLights, m_Lights.data(), m_LightCuller != nullptr ? m_Lights.size_bytes() : 0, sizeof(SpotLight));
+        setBuffer(Renderer::kClusterRanges, ranges.data(), ranges.size_bytes(), sizeof(ClusterLightRange));
+        setBuffer(Renderer::kClusterLightIndices, indices.data(), indices.size_bytes(), sizeof(std::uint32_t));
     }
 
     DirectX::BoundingFrustum MeshRenderer::GetViewFrustum() const
@@ -213,34 +328,246 @@ namespace DSM {
         return frustum;
     }
 
-    void MeshRenderer::AddRenderTarget(Texture &renderTarget, DescriptorHandle rtv)
+    void MeshRenderer::SetOcclusionCuller(OcclusionCuller* culler)
+    {
+        m_OcclusionCuller = sm_EnableOcclusionCulling ? culler : nullptr;
+        if (m_OcclusionCuller != nullptr) {
+            m_OcclusionCuller->BeginFrame();
+        }
+    }
+
+    void MeshRenderer::AddOccluder(const Mesh& mesh, const Math::Matrix4& localToWorld)
     {
-        ASSERT(rtv.IsValid());
+        if (m_OcclusionCuller == nullptr) return;
+
+        OccluderGeometry geometry{};
+        geometry.m_Positions = mesh.m_OccluderPositions.data();
+        geometry.m_PositionStride = sizeof(DirectX::XMFLOAT3);
+        geometry.m_NumVertices = static_cast<std::uint32_t>(mesh.m_OccluderPositions.size());
+        geometry.m_Indices = mesh.m_OccluderIndices.data();
+        geometry.m_NumIndices = static_cast<std::uint32_t>(mesh.m_OccluderIndices.size());
+        // 绘制时总是剔除背面
+        geometry.m_BothSides = false;
+
+        DirectX::XMFLOAT4X4 localToClip{};
+        DirectX::XMStoreFloat4x4(&localToClip, localToWorld * m_RenderCamera->GetViewProjMatrix());
+        m_OcclusionCuller->AddOccluder(geometry, &localToClip.m[0][0]);
+    }
+
+    void MeshRenderer::RasterizeOccluders()
+    {
+        PROFILE_SCOPE("MeshRenderer::RasterizeOccluders");
+        if (m_OcclusionCuller == nullptr) return;
+        m_OcclusionCuller->Rasterize();
+    }
+
+    bool MeshRenderer::IsOccluded(const DirectX::BoundingBox& box, const Math::Matrix4& localToClip) const
+    {
+        if (m_OcclusionCuller == nullptr) return false;
+
+        DirectX::XMFLOAT4X4 matrix{};
+        DirectX::XMStoreFloat4x4(&matrix, localToClip);
+        float boxMin[3] = {box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z};
+        float boxMax[3] = {box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z};
+        return !m_OcclusionCuller->IsVisible(boxMin, boxMax, &matrix.m[0][0]);
+    }
+
+    void MeshRenderer::SetLights(std::span<const SpotLight> lights, ClusteredLightCuller* culler)
+    {
+        m_LightCuller = sm_EnableClusteredLights ? culler : nullptr;
+        m_Lights = lights;
+        m_LightBounds.resize(lights.size());
+        for (std::size_t i = 0; i < lights.size(); ++i) {
+            const auto& light = lights[i];
+            auto& bounds = m_LightBounds[i];
+            bounds.m_Position[0] = light.m_Pos.x;
+            bounds.m_Position[1] = light.m_Pos.y;
+            bounds.m_Position[2] = light.m_Pos.z;
+            bounds.m_Range = light.m_EndAtten;
+            bounds.m_Direction[0] = light.m_Dir.x;
+            bounds.m_Direction[1] = light.m_Dir.y;
+            bounds.m_Direction[2] = light.m_Dir.z;
+            // pow(cos, SpotPower) 小于 1/256 的部分视为照不到
+            bounds.m_CosAngle = light.m_SpotPower > 0 ? std::exp(std::log(1.0f / 256) / light.m_SpotPower) : -1.0f;
+        }
+    }
+
+    void MeshRenderer::AddRenderTarget(Texture &renderTarget, D3D12_CPU_DESCRIPTOR_HANDLE rtv)
+    {
+        ASSERT(rtv.ptr != 0);
         m_RenderTarget[m_NumRenderTargets] = &renderTarget;
         m_RenderTargetRTV[m_NumRenderTargets++] = rtv;
     }
     
-    void MeshRenderer::SetDepthTexture(Texture &depthTex, DescriptorHandle dsv)
+    void MeshRenderer::SetDepthTexture(Texture &depthTex, D3D12_CPU_DESCRIPTOR_HANDLE dsv)
     {
-        ASSERT(dsv.IsValid());
+        ASSERT(dsv.ptr != 0);
         m_DepthTex = &depthTex;
         m_DepthTexDSV = dsv;
     }
 
-    void MeshRenderer::AddMesh(const Mesh &mesh, float distance, 
-        D3D12_GPU_VIRTUAL_ADDRESS meshCBV, 
-        D3D12_GPU_VIRTUAL_ADDRESS materialCBV)
+    void MeshRenderer::AddMesh(const Mesh &mesh, const Mesh::SubMesh& submesh, float distance, 
+        std::uint32_t instanceRow, 
+        std::uint32_t materialRow,
+        const std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures>& materialSRVs)
     {
         SortObject obj{};
         obj.m_Mesh = &mesh;
-        obj.m_MeshCBV = meshCBV;
-        obj.m_MaterialCBV = materialCBV;
-
-        SortKey key{};
-        key.m_ObjIndex = m_SortObjects.size();
+        obj.m_SubMesh = &submesh;
+        obj.m_MaterialRow = materialRow;
+        obj.m_MaterialSRVs = materialSRVs;
+        obj.m_InstanceRow = instanceRow;
+
+        InstanceKey key{};
+        key.m_Mesh = reinterpret_cast<std::uint64_t>(&mesh);
+        key.m_SubMesh = reinterpret_cast<std::uint64_t>(&submesh);
+        key.m_Material = materialRow;
         key.m_PSOIndex = mesh.m_PSOIndex;
-        key.m_Key = static_cast<uint64_t>(distance * 1000); 
+        // 半透明的物体不合并，保持各自的绘制顺序
+        m_Batcher.Add(static_cast<std::uint32_t>(m_SortObjects.size()), key, distance, !(mesh.m_PSOFlags & kAlphaBlend));
+
+        m_SortObjects.push_back(std::move(obj));
+    }
+
+
+    // ShadowRenderer implementation
+
+    void ShadowRenderer::SetShadowMap(Texture& shadowMap, D3D12_CPU_DESCRIPTOR_HANDLE dsv)
+    {
+        ASSERT(dsv.ptr != 0);
+        m_ShadowMap = &shadowMap;
+        m_ShadowMapDSV = dsv;
+    }
+
+    void ShadowRenderer::SetCascades(CascadedShadowMap& cascades, const Camera& camera, const Math::Vector3& lightDir)
+    {
+        m_Cascades = &cascades;
+
+        ShadowCameraDesc desc{};
+        DirectX::XMStoreFloat4x4(reinterpret_cast<DirectX::XMFLOAT4X4*>(desc.m_View), camera.GetViewMatrix());
+        desc.m_FovY = camera.GetFovY();
+        desc.m_Aspect = camera.GetAspectRatio();
+        desc.m_NearZ = camera.GetNearZ();
+        desc.m_FarZ = camera.GetFarZ();
+        float dir[3] = {lightDir.GetX(), lightDir.GetY(), lightDir.GetZ()};
+        m_Cascades->Update(desc, dir);
+    }
+
+    void ShadowRenderer::AddCaster(const Mesh& mesh, const Mesh::SubMesh& submesh, const DirectX::BoundingBox& worldBox,
+        std::uint32_t instanceRow,
+        std::uint32_t materialRow,
+        const std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures>& materialSRVs)
+    {
+        ShadowCaster caster{};
+        caster.m_Mesh = &mesh;
+        caster.m_SubMesh = &submesh;
+        caster.m_MaterialRow = materialRow;
+        caster.m_MaterialSRVs = materialSRVs;
+        caster.m_InstanceRow = instanceRow;
+        m_Casters.push_back(caster);
+
+        const auto& center = worldBox.Center;
+        const auto& extents = worldBox.Extents;
+        m_CasterBounds.push_back({
+            {center.x - extents.x, center.y - extents.y, center.z - extents.z},
+            {center.x + extents.x, center.y + extents.y, center.z + extents.z}});
+    }
 
-        m_SortObjects.insert({key, obj});
+    void ShadowRenderer::Render(GraphicsCommandList& cmdList, PassConstants& passConstants)
+    {
+        PROFILE_SCOPE("ShadowRenderer::Render");
+        ASSERT(m_ShadowMap != nullptr, "Shadow map is not set!");
+        ASSERT(m_Cascades != nullptr, "Shadow cascades are not set!");
+
+        if (sm_EnableShadows) {
+            m_Cascades->CullCasters(m_CasterBounds);
+        }
+        const auto& shadowTransform = *reinterpret_cast<const DirectX::XMFLOAT4X4*>(m_Cascades->GetCascade(0).m_ShadowTransform);
+        passConstants.m_ShadowTrans = Math::Matrix4::Transpose(Math::Matrix4{shadowTransform});
+        passConstants.m_Shadows = m_Cascades->GetConstants();
+        if (!sm_EnableShadows) {
+            passConstants.m_Shadows.m_NumCascades = 0;
+        }
+
+        // Model::RenderShadowCasters 写入的实例在绘制前上传
+        g_GpuScene.Update(cmdList);
+
+        cmdList.SetRootSignature(g_Renderer.m_CommonRootSig);
+        cmdList.TransitionResource(*m_ShadowMap, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+        // 深度反向，清除为最远处
+        cmdList.ClearDepth(m_ShadowMapDSV, 0);
+        if (!sm_EnableShadows || m_Casters.empty()) return;
+
+        cmdList.SetDepthStencilTarget(m_ShadowMapDSV);
+        cmdList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        cmdList.SetShaderResource(Renderer::kSceneInstances, g_GpuScene.GetInstanceBuffer());
+
+        // 深度绘制的着色器使用 View * Proj，把级联的变换放在 View 中
+        PassConstants cascadeConstants = passConstants;
+        cascadeConstants.m_Proj = Math::Matrix4::Identity;
+        auto resolution = static_cast<long>(m_Cascades->GetResolution());
+        for (std::uint32_t i = 0; i < m_Cascades->GetNumCascades(); ++i) {
+            const auto& viewProj = *reinterpret_cast<const DirectX::XMFLOAT4X4*>(m_Cascades->GetCascade(i).m_ViewProj);
+            cascadeConstants.m_View = Math::Matrix4::Transpose(Math::Matrix4{viewProj});
+            cmdList.SetDynamicConstantBuffer(Renderer::kPassConstants, sizeof(cascadeConstants), &cascadeConstants);
+            cmdList.SetViewportAndScissor(i * resolution, 0, resolution, resolution);
+            DrawCascade(cmdList, i);
+        }
+    }
+
+    void ShadowRenderer::DrawCascade(GraphicsCommandList& cmdList, std::uint32_t cascade)
+    {
+        auto casterIndices = m_Cascades->GetCasterIndices(cascade);
+        if (casterIndices.empty()) return;
+
+        // 由靠近光源到远排列，PSO 0 为不透明，1 为透明度测试
+        auto depths = m_Cascades->GetCasterDepths();
+        m_Batcher.Clear();
+        for (auto index : casterIndices) {
+            const auto& caster = m_Casters[index];
+            bool alphaTest = caster.m_Mesh->m_PSOFlags & (kAlphaTest | kAlphaBlend);
+
+            InstanceKey key{};
+            key.m_Mesh = reinterpret_cast<std::uint64_t>(caster.m_Mesh);
+            key.m_SubMesh = reinterpret_cast<std::uint64_t>(caster.m_SubMesh);
+            key.m_Material = alphaTest ? caster.m_MaterialRow : 0;
+            key.m_PSOIndex = alphaTest ? 1 : 0;
+            m_Batcher.Add(index, key, depths[index]);
+        }
+        m_Batcher.Build();
+
+        auto instanceOrder = m_Batcher.GetInstanceOrder();
+        auto instanceIndices = cmdList.GetUploadBuffer(instanceOrder.size() * sizeof(std::uint32_t));
+        auto indexData = reinterpret_cast<std::uint32_t*>(instanceIndices.m_MappedAddress);
+        for (std::size_t i = 0; i < instanceOrder.size(); ++i) {
+            indexData[i] = m_Casters[instanceOrder[i]].m_InstanceRow;
+        }
+
+        const Mesh* currMesh = nullptr;
+        for (const auto& batch : m_Batcher.GetBatches()) {
+            const auto& caster = m_Casters[instanceOrder[batch.m_FirstInstance]];
+            const auto& mesh = *caster.m_Mesh;
+
+            cmdList.SetShaderResource(Renderer::kInstanceIndices, *instanceIndices.m_Resource,
+                instanceIndices.m_Offset + batch.m_FirstInstance * sizeof(std::uint32_t));
+            if (batch.m_PSOIndex != 0) {
+                cmdList.SetPipelineState(g_Renderer.m_ShadowAlphaTestPSO);
+                cmdList.SetConstantBuffer(Renderer::kMaterialConstants, g_GpuScene.GetMaterialCBV(caster.m_MaterialRow));
+                auto materialSRVs = caster.m_MaterialSRVs;
+                cmdList.SetDynamicDescriptors(Renderer::kMaterialSRVs, 0, materialSRVs);
+            }
+            else {
+                cmdList.SetPipelineState(g_Renderer.m_ShadowPSO);
+            }
+
+            if (currMesh != &mesh) {
+                std::array<D3D12_VERTEX_BUFFER_VIEW, 2> vertexData{mesh.m_PositionStream, mesh.m_UVStream};
+                cmdList.SetVertexBuffers(0, vertexData);
+                cmdList.SetIndexBuffer(mesh.m_IndexBufferViews);
+                currMesh = &mesh;
+            }
+            cmdList.DrawIndexedInstanced(caster.m_SubMesh->m_IndexCount, batch.m_NumInstances,
+                caster.m_SubMesh->m_IndexOffset, caster.m_SubMesh->m_VertexOffset, 0);
+        }
     }
 }
\ No newline at end of file
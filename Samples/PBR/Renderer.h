@@ -8,13 +8,22 @@
 #include "Graphics/RootSignature.h"
 #include "Graphics/PipelineState.h"
 #include "Graphics/ShaderCompiler.h"
+#include "Graphics/CommandSignature.h"
 #include "ConstantData.h"
 #include "Core/Camera.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Light.h"
+#include "Renderer/InstanceBatcher.h"
+#include "Renderer/IndirectDrawPacker.h"
+#include "Renderer/OcclusionCuller.h"
+#include "Renderer/ClusteredLightCuller.h"
+#include "Renderer/CascadedShadowMap.h"
 
 
 namespace DSM {
     class GraphicsCommandList;
-    struct Mesh;
+    struct GpuResourceLocation;
     
     class Renderer : public Singleton<Renderer>
     {
@@ -22,10 +31,18 @@ namespace DSM {
         // 跟参数的绑定槽
         enum RootBindings
         {
-            kMeshConstants = 0,
+            // 当前批次的实例在 GPU 场景实例表中的行
+            kInstanceIndices = 0,
             kMaterialConstants,
             kPassConstants,
             kMaterialSRVs,
+            kSceneInstances,
+            // 分簇着色的光源、每个簇的范围与光源序号
+            kLights,
+            kClusterRanges,
+            kClusterLightIndices,
+            // 级联阴影的图集
+            kShadowMap,
             kNumRootBindings
         };
 
@@ -33,39 +50,37 @@ namespace DSM {
         void Create();
         void Shutdown();
 
-        void OnResize(uint32_t width, uint32_t height);
-
         uint16_t GetPSO(uint16_t psoFlags);
 
-    private:
-        void CreateResource(uint32_t width, uint32_t height);
-
     private:
         friend class Singleton<Renderer>;
         Renderer();
         virtual ~Renderer() { Shutdown(); }
 
     public:
-        bool m_Initialized = false;
+        // 深度缓冲由渲染图每帧创建
+        inline static constexpr DXGI_FORMAT sm_DepthFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+        // 阴影图集需要作为 SRV 读取，深度视图使用 D32_FLOAT
+        inline static constexpr DXGI_FORMAT sm_ShadowFormat = DXGI_FORMAT_R32_TYPELESS;
+        inline static constexpr DXGI_FORMAT sm_ShadowDepthFormat = DXGI_FORMAT_D32_FLOAT;
 
-        Texture m_DepthTex;
-        DescriptorHandle m_DepthTexDSV;
-        DescriptorHandle m_DepthTexSRV;
-
-        Texture m_ColorTex;
-        DescriptorHandle m_ColorTexRTV;
-        DescriptorHandle m_ColorTexSRV;
+        bool m_Initialized = false;
 
         RootSignature m_CommonRootSig;
         GraphicsPSO m_DefaultPSO;
         std::vector<GraphicsPSO> m_PSOs;
-
-        DescriptorHeap m_TextureHeap;
+        // 每条记录设置实例索引的根描述符并绘制，与 IndirectDrawRecord 的布局相同
+        CommandSignature m_DrawIndirectSig;
+        // 阴影只写入深度，透明度测试的网格需要采样基础颜色
+        GraphicsPSO m_ShadowPSO;
+        GraphicsPSO m_ShadowAlphaTestPSO;
 
         std::unique_ptr<ShaderByteCode> m_VS;
         std::unique_ptr<ShaderByteCode> m_VSUseTangent;
         std::unique_ptr<ShaderByteCode> m_PS;
         std::unique_ptr<ShaderByteCode> m_PSUseTangent;   
+        std::unique_ptr<ShaderByteCode> m_ShadowVS;
+        std::unique_ptr<ShaderByteCode> m_ShadowAlphaTestPS;
     };
 #define g_Renderer (Renderer::GetInstance())
 
@@ -75,56 +90,125 @@ namespace DSM {
         struct SortObject
         {
             const Mesh* m_Mesh;
-            D3D12_GPU_VIRTUAL_ADDRESS m_MeshCBV;
-            D3D12_GPU_VIRTUAL_ADDRESS m_MaterialCBV;
-        };
-
-        struct SortKey
-        {
-            union
-            {
-                uint64_t m_Value;
-                struct
-                {
-                    uint64_t m_ObjIndex : 16;
-                    uint64_t m_PSOIndex : 12;
-                    uint64_t m_Key : 36;
-                };
-            }; 
-            std::strong_ordering operator<=>(const SortKey& other) const
-            {
-                return m_Value <=> other.m_Value;
-            }
+            const Mesh::SubMesh* m_SubMesh;
+            std::uint32_t m_MaterialRow;
+            std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures> m_MaterialSRVs;
+            std::uint32_t m_InstanceRow;
         };
 
     public:
         void Render(GraphicsCommandList& cmdList, PassConstants& passConstants);
 
         Math::Matrix4 GetViewMatrix() const { return m_RenderCamera->GetViewMatrix(); }
+        Math::Matrix4 GetViewProjMatrix() const { return m_RenderCamera->GetViewProjMatrix(); }
         DirectX::BoundingFrustum GetViewFrustum() const;
-
-        void AddRenderTarget(Texture& renderTarget, DescriptorHandle rtv);
-        void SetDepthTexture(Texture& depthTex, DescriptorHandle dsv);
-
-        void AddMesh(const Mesh& mesh, float distance, 
-            D3D12_GPU_VIRTUAL_ADDRESS meshCBV, 
-            D3D12_GPU_VIRTUAL_ADDRESS materialCBV);
+        const D3D12_VIEWPORT& GetViewPort() const { return m_RenderCamera->GetViewPort(); }
+        float GetFovY() const { return m_RenderCamera->GetFovY(); }
+
+        void AddRenderTarget(Texture& renderTarget, D3D12_CPU_DESCRIPTOR_HANDLE rtv);
+        void SetDepthTexture(Texture& depthTex, D3D12_CPU_DESCRIPTOR_HANDLE dsv);
+
+        // 网格、子网格、PSO 与材质都相同的绘制会合并为一次实例化绘制
+        // 实例与材质为 GPU 场景中的行，绘制时才取得地址，表可能在本帧扩容
+        void AddMesh(const Mesh& mesh, const Mesh::SubMesh& submesh, float distance, 
+            std::uint32_t instanceRow, 
+            std::uint32_t materialRow,
+            const std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures>& materialSRVs);
+
+        // 开始本帧的遮挡剔除，需在 SetCamera 之后调用，为空时只做视锥剔除
+        void SetOcclusionCuller(OcclusionCuller* culler);
+        // 网格的遮挡体需保持有效直到 RasterizeOccluders
+        void AddOccluder(const Mesh& mesh, const Math::Matrix4& localToWorld);
+        void RasterizeOccluders();
+        // localToClip 为物体空间到裁剪空间的变换
+        bool IsOccluded(const DirectX::BoundingBox& box, const Math::Matrix4& localToClip) const;
+
+        // 本帧的点光源与聚光灯，在 Render 中按相机分配到簇，光源需保持有效直到 Render，culler 为空时不使用这些光源
+        void SetLights(std::span<const SpotLight> lights, ClusteredLightCuller* culler);
+        // ShadowRenderer 绘制的阴影图集，需在 Render 之前设置
+        void SetShadowMap(D3D12_CPU_DESCRIPTOR_HANDLE srv) { m_ShadowMapSRV = srv; }
 
         void SetCamera(const Camera& camera) { m_RenderCamera = &camera; }
         void SetScissor(const D3D12_RECT& scissor) { m_Scissor = scissor; }
 
+        // 开启时状态相同的批次打包为一次 ExecuteIndirect
+        inline static bool sm_EnableIndirectDraw = true;
+        inline static bool sm_EnableOcclusionCulling = true;
+        inline static bool sm_EnableClusteredLights = true;
+
+    private:
+        void DrawBatches(GraphicsCommandList& cmdList, const GpuResourceLocation& instanceIndices);
+        void DrawIndirect(GraphicsCommandList& cmdList, const GpuResourceLocation& instanceIndices);
+        // 设置网格与材质，网格与上一次相同时不再设置顶点与索引缓冲
+        void SetMeshState(GraphicsCommandList& cmdList, const SortObject& obj, const Mesh*& currMesh);
+        // 分配光源并上传光源与簇的数据，没有光源时也绑定一个元素，着色器中的数量为 0
+        void SetClusteredLights(GraphicsCommandList& cmdList, PassConstants& passConstants);
+
     private:
         uint32_t m_NumRenderTargets = 0;
         std::array<Texture*, 8> m_RenderTarget;
-        std::array<DescriptorHandle, 8> m_RenderTargetRTV;
+        std::array<D3D12_CPU_DESCRIPTOR_HANDLE, 8> m_RenderTargetRTV;
 
         Texture* m_DepthTex;
-        DescriptorHandle m_DepthTexDSV;
+        D3D12_CPU_DESCRIPTOR_HANDLE m_DepthTexDSV;
         
-        std::map<SortKey, SortObject> m_SortObjects;
+        std::vector<SortObject> m_SortObjects;
+        InstanceBatcher m_Batcher;
+        IndirectDrawPacker m_IndirectPacker;
 
         const Camera* m_RenderCamera;
         D3D12_RECT m_Scissor{};
+        OcclusionCuller* m_OcclusionCuller{};
+
+        std::span<const SpotLight> m_Lights{};
+        std::vector<ClusterLightBounds> m_LightBounds{};
+        ClusteredLightCuller* m_LightCuller{};
+        D3D12_CPU_DESCRIPTOR_HANDLE m_ShadowMapSRV{};
+    };
+
+    // 级联阴影的深度绘制，每个级联为图集中的一块
+    // 投射体在 Render 中按级联剔除，每个级联的绘制各自合并为实例化绘制，不透明的投射体不区分材质
+    class ShadowRenderer
+    {
+    private:
+        struct ShadowCaster
+        {
+            const Mesh* m_Mesh;
+            const Mesh::SubMesh* m_SubMesh;
+            std::uint32_t m_MaterialRow;
+            std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures> m_MaterialSRVs;
+            std::uint32_t m_InstanceRow;
+        };
+
+    public:
+        // 图集的宽为级联数量乘以分辨率，高为分辨率
+        void SetShadowMap(Texture& shadowMap, D3D12_CPU_DESCRIPTOR_HANDLE dsv);
+        // 立即划分相机的视锥并拟合每个级联，lightDir 为光线传播的方向
+        void SetCascades(CascadedShadowMap& cascades, const Camera& camera, const Math::Vector3& lightDir);
+
+        // 世界空间的包围盒用于按级联剔除
+        void AddCaster(const Mesh& mesh, const Mesh::SubMesh& submesh, const DirectX::BoundingBox& worldBox,
+            std::uint32_t instanceRow,
+            std::uint32_t materialRow,
+            const std::array<D3D12_CPU_DESCRIPTOR_HANDLE, kNumTextures>& materialSRVs);
+
+        // 绘制所有级联，并把阴影变换与级联的常量写入 passConstants 供之后的着色使用
+        void Render(GraphicsCommandList& cmdList, PassConstants& passConstants);
+
+        // 关闭时只清除图集，着色器中的级联数量为 0
+        inline static bool sm_EnableShadows = true;
+
+    private:
+        void DrawCascade(GraphicsCommandList& cmdList, std::uint32_t cascade);
+
+    private:
+        Texture* m_ShadowMap{};
+        D3D12_CPU_DESCRIPTOR_HANDLE m_ShadowMapDSV{};
+        CascadedShadowMap* m_Cascades{};
+
+        std::vector<ShadowCaster> m_Casters{};
+        std::vector<ShadowCasterBounds> m_CasterBounds{};
+        InstanceBatcher m_Batcher{};
     };
 
 } // namespace DSM 
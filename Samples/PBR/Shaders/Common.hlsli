@@ -2,5 +2,6 @@
 #define __COMMON_HLSLI__
 
 SamplerState defaultSampler : register(s0);
+SamplerComparisonState shadowSampler : register(s1);
 
 #endif
@@ -1,7 +1,7 @@
 #ifndef __CONSTANTBUFFERS_HLSLI__
 #define __CONSTANTBUFFERS_HLSLI__
 
-struct MeshConstants
+struct MeshInstanceData
 {
     float4x4 World;
     float4x4 WorldIT;
@@ -15,6 +15,41 @@ struct MaterialConstants
     float MetallicFactor;
     float RoughnessFactor;
 };
+struct ClusterGridConstants
+{
+    float SliceScale;
+    float SliceBias;
+    float TileScaleX;
+    float TileScaleY;
+    uint NumTilesX;
+    uint NumTilesY;
+    uint NumSlices;
+    uint NumLights;
+    float DepthToViewZA;
+    float DepthToViewZB;
+    float2 Pad;
+};
+
+struct ShadowCascadeConstants
+{
+    float4 Offsets[4];
+    float4 Scales[4];
+    float4 Splits;
+    float3 LightDir;
+    uint NumCascades;
+};
+
+// 点光源与聚光灯共用，与 Light.h 中的 SpotLight 布局相同，SpotPower 为 0 时为点光源
+struct LightData
+{
+    float3 Color;
+    float StartAtten;
+    float3 Position;
+    float EndAtten;
+    float3 Direction;
+    float SpotPower;
+};
+
 struct PassConstants
 {
     float4x4 View;
@@ -25,6 +60,8 @@ struct PassConstants
     float3 CameraPos;
     float TotalTime;
     float DeltaTime;
+    ClusterGridConstants Clusters;
+    ShadowCascadeConstants Shadows;
 };
 
 
@@ -2,9 +2,10 @@
 #include "ConstantBuffers.hlsli"
 
 
-ConstantBuffer<MeshConstants> _MeshConstants : register(b0);
 ConstantBuffer<MaterialConstants> _MaterialConstants : register(b1);
 ConstantBuffer<PassConstants> _PassConstants : register(b2);
+StructuredBuffer<uint> _InstanceIndices : register(t0, space1);
+StructuredBuffer<MeshInstanceData> _SceneInstances : register(t1, space1);
 
 Texture2D<float4> _DiffuseTex : register(t0);
 
@@ -20,11 +21,11 @@ struct Varyings
 	float2 uv : TEXCOORD0;
 };
 
-Varyings DepthOnlyPassVS(Attributes i)
+Varyings DepthOnlyPassVS(Attributes i, uint instanceID : SV_InstanceID)
 {
 	Varyings o;
 	float4x4 viewProj = mul(_PassConstants.View, _PassConstants.Proj);
-	float3 posWS = mul(float4(i.posOS, 1), _MeshConstants.World).xyz;
+	float3 posWS = mul(float4(i.posOS, 1), _SceneInstances[_InstanceIndices[instanceID]].World).xyz;
 	o.posCS = mul(float4(posWS, 1), viewProj);
 	o.uv = i.uv;
 	return o;
@@ -1,9 +1,17 @@
 #include "Common.hlsli"
 #include "ConstantBuffers.hlsli"
 
-ConstantBuffer<MeshConstants> _MeshConstants : register(b0);
 ConstantBuffer<MaterialConstants> _MaterialConstants : register(b1);
 ConstantBuffer<PassConstants> _PassConstants : register(b2);
+// 从当前批次的第一个实例开始，保存实例在 GPU 场景实例表中的行
+StructuredBuffer<uint> _InstanceIndices : register(t0, space1);
+StructuredBuffer<MeshInstanceData> _SceneInstances : register(t1, space1);
+// 分簇的光源，每个簇为光源序号列表中的 (偏移, 数量)
+StructuredBuffer<LightData> _Lights : register(t2, space1);
+StructuredBuffer<uint2> _ClusterRanges : register(t3, space1);
+StructuredBuffer<uint> _ClusterLightIndices : register(t4, space1);
+// 级联在图集中横向排列，深度反向
+Texture2D<float> _ShadowMap : register(t0, space2);
 
 // PBR相关纹理
 Texture2D<float4> _BaseColorTex : register(t0);
@@ -38,20 +46,21 @@ struct Varyings
 
 
 
-Varyings LitPassVS(Attributes i)
+Varyings LitPassVS(Attributes i, uint instanceID : SV_InstanceID)
 {
     Varyings o;
+    MeshInstanceData meshInstance = _SceneInstances[_InstanceIndices[instanceID]];
 
     float4x4 viewProj = mul(_PassConstants.View, _PassConstants.Proj);
 
-    float4 posWS = mul(float4(i.posOS, 1), _MeshConstants.World);
-    float3 normal = mul(i.normal, (float3x3)_MeshConstants.WorldIT);
+    float4 posWS = mul(float4(i.posOS, 1), meshInstance.World);
+    float3 normal = mul(i.normal, (float3x3)meshInstance.WorldIT);
     o.posWS = posWS.xyz;
     o.posCS = mul(posWS, viewProj);
     o.uv = i.uv;
     o.normal = normalize(normal);
 #if defined(USE_TANGENT)
-    o.tangent.xyz = mul(i.tangent.xyz, (float3x3)_MeshConstants.WorldIT).xyz;
+    o.tangent.xyz = mul(i.tangent.xyz, (float3x3)meshInstance.WorldIT).xyz;
 #endif
     o.posShadow = mul(float4(o.posWS, 1), _PassConstants.ShadowTrans).xyz;
 
@@ -60,6 +69,68 @@ Varyings LitPassVS(Attributes i)
 
 
 
+// 由像素坐标与深度缓冲中的深度找到所在的簇，累加簇中光源的漫反射
+float3 ShadeClusteredLights(float4 posCS, float3 posWS, float3 normal)
+{
+    ClusterGridConstants grid = _PassConstants.Clusters;
+    if (grid.NumLights == 0) return 0;
+
+    float viewZ = grid.DepthToViewZB / (posCS.z - grid.DepthToViewZA);
+    int slice = clamp((int)floor(log(viewZ) * grid.SliceScale + grid.SliceBias), 0, (int)grid.NumSlices - 1);
+    uint2 tile = min(uint2(posCS.xy * float2(grid.TileScaleX, grid.TileScaleY)), uint2(grid.NumTilesX, grid.NumTilesY) - 1);
+    uint2 range = _ClusterRanges[(slice * grid.NumTilesY + tile.y) * grid.NumTilesX + tile.x];
+
+    float3 result = 0;
+    for (uint i = 0; i < range.y; ++i) {
+        LightData light = _Lights[_ClusterLightIndices[range.x + i]];
+        float3 toLight = light.Position - posWS;
+        float dist = length(toLight);
+        if (dist >= light.EndAtten) continue;
+
+        float3 L = toLight / max(dist, 1e-4f);
+        float atten = saturate((light.EndAtten - dist) / max(light.EndAtten - light.StartAtten, 1e-4f));
+        if (light.SpotPower > 0) {
+            atten *= pow(saturate(dot(-L, light.Direction)), light.SpotPower);
+        }
+        result += light.Color * atten * saturate(dot(normal, L));
+    }
+    return result;
+}
+
+// 按观察空间的深度选择级联，3x3 PCF，超出阴影距离时没有阴影
+float SampleShadow(float3 posWS, float3 posShadow)
+{
+    ShadowCascadeConstants shadows = _PassConstants.Shadows;
+    if (shadows.NumCascades == 0) return 1;
+
+    float viewZ = mul(float4(posWS, 1), _PassConstants.View).z;
+    if (viewZ > shadows.Splits[shadows.NumCascades - 1]) return 1;
+    uint cascade = 0;
+    [unroll]
+    for (uint c = 0; c < 3; ++c) {
+        cascade += (c + 1 < shadows.NumCascades && viewZ > shadows.Splits[c]) ? 1 : 0;
+    }
+
+    float3 coord = (posShadow + shadows.Offsets[cascade].xyz) * shadows.Scales[cascade].xyz;
+    uint width, height;
+    _ShadowMap.GetDimensions(width, height);
+    // 每个级联的分辨率与图集的高相同，滤波不越过级联的边界
+    float texel = 1.0f / height;
+    coord.xy = clamp(coord.xy, texel, 1 - texel);
+    float2 uv = float2((coord.x + cascade) / shadows.NumCascades, coord.y);
+    float2 atlasTexel = float2(texel / shadows.NumCascades, texel);
+
+    float lit = 0;
+    [unroll]
+    for (int y = -1; y <= 1; ++y) {
+        [unroll]
+        for (int x = -1; x <= 1; ++x) {
+            lit += _ShadowMap.SampleCmpLevelZero(shadowSampler, uv + float2(x, y) * atlasTexel, coord.z);
+        }
+    }
+    return lit / 9;
+}
+
 float4 LitPassPS(Varyings i) : SV_TARGET0
 {
     float4 baseCol = _BaseColorTex.Sample(defaultSampler, i.uv);
@@ -67,12 +138,17 @@ float4 LitPassPS(Varyings i) : SV_TARGET0
     float metalness = _MetalnessTex.Sample(defaultSampler, i.uv);
     float occlusion = _OcclusionTex.Sample(defaultSampler, i.uv);
     float3 emissive = _EmissiveTex.Sample(defaultSampler, i.uv);
-    float3 normal = _NormalTex.Sample(defaultSampler, i.uv);
+    // 法线贴图以 BC5 保存，只有 xy，z 需要重建
+    float2 normalXY = _NormalTex.Sample(defaultSampler, i.uv).xy * 2 - 1;
+    float3 normal = float3(normalXY, sqrt(saturate(1 - dot(normalXY, normalXY))));
 
     baseCol.rgb += emissive;
     baseCol.rgb *= occlusion;
     baseCol.rgb *= metalness;
     baseCol.rgb *= diffuseRoughness.rgb;
 
-    return float4(dot(normalize(float3(1,1,1)), normalize(i.normal)) * baseCol.rgb, baseCol.a);
+    float3 normalWS = normalize(i.normal);
+    float shadow = SampleShadow(i.posWS, i.posShadow);
+    float3 lighting = saturate(dot(-_PassConstants.Shadows.LightDir, normalWS)) * shadow + ShadeClusteredLights(i.posCS, i.posWS, normalWS);
+    return float4(lighting * baseCol.rgb, baseCol.a);
 }
\ No newline at end of file
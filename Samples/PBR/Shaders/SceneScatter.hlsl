@@ -0,0 +1,24 @@
+// 将打包上传的行分散写入 GPU 场景的表中，每个线程写入 16 字节
+cbuffer ScatterConstants : register(b0)
+{
+    uint _NumRows;
+    // 每行包含的 uint4 数量
+    uint _RowVectors;
+};
+
+ByteAddressBuffer _ScatterData : register(t0);
+// 与上传的行一一对应的目标行
+StructuredBuffer<uint> _ScatterRows : register(t1);
+RWByteAddressBuffer _SceneTable : register(u0);
+
+
+[numthreads(64, 1, 1)]
+void ScatterCS(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint row = dispatchThreadID.x / _RowVectors;
+    if (row >= _NumRows) return;
+
+    uint vectorIndex = dispatchThreadID.x % _RowVectors;
+    uint destOffset = (_ScatterRows[row] * _RowVectors + vectorIndex) * 16;
+    _SceneTable.Store4(destOffset, _ScatterData.Load4(dispatchThreadID.x * 16));
+}
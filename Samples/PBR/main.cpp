@@ -10,6 +10,8 @@
 #include "Math/Random.h"
 #include "Math/Transform.h"
 #include "Utilities/Utility.h"
+#include "Renderer/TextureManager.h"
+#include "Graphics/RenderGraph/RenderGraph.h"
 #include "ModelLoader.h"
 #include "ConstantData.h"
 #include "Geometry.h"
@@ -17,6 +19,7 @@
 #include "CameraController.h"
 #include "ImguiManager.h"
 #include "Renderer.h"
+#include "GpuScene.h"
 
 using namespace DSM;
 using namespace DirectX;
@@ -29,6 +32,7 @@ public:
     virtual void Startup()override
     {
         g_Renderer.Create();
+        g_GpuScene.Create();
 
 		ASSERT(ImguiManager::GetInstance().InitImGui(
 			g_RenderContext.GetDevice(),
@@ -54,16 +58,19 @@ public:
         m_CameraController->InitCamera(m_Camera.get());
 
         m_SceneTrans.SetScale({ 0.05f, 0.05f, 0.05f });
-        MeshConstants meshConstants{};
-		meshConstants.m_World = Math::Matrix4::Transpose(m_SceneTrans.GetLocalToWorld());
-        meshConstants.m_WorldIT = Math::Matrix4::InverseTranspose(m_SceneTrans.GetLocalToWorld());
-		GpuBufferDesc meshConstantsDesc{};
-        meshConstantsDesc.m_Size = sizeof(MeshConstants);
-		meshConstantsDesc.m_Stride = sizeof(MeshConstants);
-		meshConstantsDesc.m_HeapType = D3D12_HEAP_TYPE_UPLOAD;
-		m_MeshConstants.Create(L"MeshConstants", meshConstantsDesc, &meshConstants);
+
+        // 纹理先只加载低精度的 mip，之后按屏幕上的大小流式加载
+        TextureResidencyDesc streamingDesc{};
+        streamingDesc.m_Budget = 1024ull << 20;
+        g_TexManager.EnableStreaming(streamingDesc);
+
+        // 相机在场景之外，阴影需要覆盖整个场景
+        CascadedShadowDesc shadowDesc{};
+        shadowDesc.m_MaxDistance = 300;
+        m_ShadowCascades.Create(shadowDesc);
 
         m_Model = LoadModel("Models//Sponza//sponza.gltf");
+        CreateLights(1024);
     }
     virtual void OnResize(std::uint32_t width, std::uint32_t height) override
     {
@@ -72,17 +79,12 @@ public:
         m_Camera->SetViewPort(0, 0, static_cast<float>(width), static_cast<float>(height));
         float aspect = float(width) / height;
         m_Camera->SetFrustum(DirectX::XM_PIDIV4, aspect == 0 ? 1 : aspect, 0.1f, 1000.0f);
-
-        g_Renderer.OnResize(width, height);
     }
     virtual void Update(float deltaTime) override
     {
-        deltaTime = 1.f / 60;
-
         ImguiManager::GetInstance().Update(deltaTime);
 
-        m_PassConstants.m_ShadowTrans = Math::Matrix4::Identity;
-		m_PassConstants.m_TotalTime = 0;
+		m_PassConstants.m_TotalTime = GameCore::GetTimer().TotalTime();
 		m_PassConstants.m_DeltaTime = deltaTime;
 
         m_CameraController->Update(deltaTime);
@@ -94,27 +96,129 @@ public:
 
         GraphicsCommandList cmdList{ L"Render Scene" };
 
-        MeshRenderer meshRenderer{};
-        meshRenderer.AddRenderTarget(*swapChain.GetBackBuffer(), swapChain.GetBackBufferRTV());
-        meshRenderer.SetDepthTexture(g_Renderer.m_DepthTex, g_Renderer.m_DepthTexDSV);
-		meshRenderer.SetCamera(*m_Camera);
-        meshRenderer.SetScissor(m_Scissor);
-        m_Model->Render(meshRenderer, m_MeshConstants, m_SceneTrans);
-        meshRenderer.Render(cmdList, m_PassConstants);
-
-        ImguiManager::GetInstance().RenderImGui(cmdList.GetCommandList());
-
-        cmdList.TransitionResource(*swapChain.GetBackBuffer(), D3D12_RESOURCE_STATE_PRESENT);
+        RGTextureViews backBufferViews{};
+        backBufferViews.m_RTV = swapChain.GetBackBufferRTV();
+        auto backBuffer = m_RenderGraph.ImportTexture(
+            L"BackBuffer", *swapChain.GetBackBuffer(), backBufferViews, D3D12_RESOURCE_STATE_PRESENT);
+
+        RGTextureHandle shadowMap{};
+        m_RenderGraph.AddPass("Shadow",
+            [&](RenderGraphBuilder& builder) {
+                TextureDesc shadowDesc{};
+                shadowDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+                shadowDesc.m_Width = m_ShadowCascades.GetNumCascades() * m_ShadowCascades.GetResolution();
+                shadowDesc.m_Height = m_ShadowCascades.GetResolution();
+                shadowDesc.m_Format = Renderer::sm_ShadowFormat;
+                shadowDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+                D3D12_CLEAR_VALUE clearValue{};
+                clearValue.Format = Renderer::sm_ShadowDepthFormat;
+                clearValue.DepthStencil = { .Depth = 0, .Stencil = 0 };
+                shadowMap = builder.Write(builder.CreateTexture(L"Renderer::ShadowMap", shadowDesc, &clearValue),
+                    D3D12_RESOURCE_STATE_DEPTH_WRITE);
+            },
+            [&](GraphicsCommandList& cmdList, RenderGraph& graph) {
+                PROFILE_GPU_SCOPE(cmdList, "Shadow");
+                ShadowRenderer shadowRenderer{};
+                shadowRenderer.SetShadowMap(graph.GetTexture(shadowMap), graph.GetDSV(shadowMap));
+                shadowRenderer.SetCascades(m_ShadowCascades, *m_Camera, m_LightDir);
+                m_Model->RenderShadowCasters(shadowRenderer, m_SceneTrans);
+                shadowRenderer.Render(cmdList, m_PassConstants);
+            });
+
+        RGTextureHandle depth{};
+        m_RenderGraph.AddPass("Scene",
+            [&](RenderGraphBuilder& builder) {
+                TextureDesc depthDesc{};
+                depthDesc.m_Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+                depthDesc.m_Width = swapChain.GetWidth();
+                depthDesc.m_Height = swapChain.GetHeight();
+                depthDesc.m_Format = Renderer::sm_DepthFormat;
+                depthDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+                D3D12_CLEAR_VALUE clearValue{};
+                clearValue.Format = Renderer::sm_DepthFormat;
+                clearValue.DepthStencil = { .Depth = 1, .Stencil = 0 };
+                depth = builder.Write(builder.CreateTexture(L"Renderer::DepthTexture", depthDesc, &clearValue),
+                    D3D12_RESOURCE_STATE_DEPTH_WRITE);
+                builder.Write(backBuffer);
+                builder.Read(shadowMap);
+            },
+            [&](GraphicsCommandList& cmdList, RenderGraph& graph) {
+                PROFILE_GPU_SCOPE(cmdList, "Scene");
+                MeshRenderer meshRenderer{};
+                meshRenderer.AddRenderTarget(graph.GetTexture(backBuffer), graph.GetRTV(backBuffer));
+                meshRenderer.SetDepthTexture(graph.GetTexture(depth), graph.GetDSV(depth));
+                meshRenderer.SetCamera(*m_Camera);
+                meshRenderer.SetScissor(m_Scissor);
+                meshRenderer.SetOcclusionCuller(&m_OcclusionCuller);
+                meshRenderer.SetLights(m_Lights, &m_LightCuller);
+                meshRenderer.SetShadowMap(graph.GetSRV(shadowMap));
+                m_Model->RenderOccluders(meshRenderer, m_SceneTrans);
+                meshRenderer.RasterizeOccluders();
+                m_Model->Render(meshRenderer, m_SceneTrans);
+                meshRenderer.Render(cmdList, m_PassConstants);
+            });
+
+        m_RenderGraph.AddPass("ImGui",
+            [&](RenderGraphBuilder& builder) {
+                builder.Write(backBuffer);
+            },
+            [](GraphicsCommandList& cmdList, RenderGraph&) {
+                PROFILE_GPU_SCOPE(cmdList, "ImGui");
+                ImguiManager::GetInstance().RenderImGui(cmdList.GetCommandList());
+            });
+
+        m_RenderGraph.Execute(cmdList);
 
         cmdList.ExecuteCommandList();
 
+        // 本帧的 mip 请求已经收集完毕
+        g_TexManager.UpdateStreaming();
+
         swapChain.Present();
     }
     virtual void Cleanup() override
     {
+        g_RenderContext.IdleGPU();
+        m_RenderGraph.Shutdown();
+        g_GpuScene.Shutdown();
         g_Renderer.Shutdown();
     };
 
+private:
+    // 在模型的包围盒内随机生成点光源与聚光灯
+    void CreateLights(std::uint32_t numLights)
+    {
+        DirectX::BoundingBox bounds{};
+        m_Model->m_BoundingBox.Transform(bounds, m_SceneTrans.GetLocalToWorld());
+
+        m_Lights.resize(numLights);
+        for (auto& light : m_Lights) {
+            light.m_Color = {
+                g_RandomGenerator.NextFloat(0.2f, 1.0f),
+                g_RandomGenerator.NextFloat(0.2f, 1.0f),
+                g_RandomGenerator.NextFloat(0.2f, 1.0f)};
+            light.m_Pos = {
+                bounds.Center.x + g_RandomGenerator.NextFloat(-1, 1) * bounds.Extents.x,
+                bounds.Center.y + g_RandomGenerator.NextFloat(-1, 1) * bounds.Extents.y,
+                bounds.Center.z + g_RandomGenerator.NextFloat(-1, 1) * bounds.Extents.z};
+            light.m_EndAtten = g_RandomGenerator.NextFloat(1.0f, 4.0f);
+            light.m_StartAtten = light.m_EndAtten * 0.25f;
+
+            // 一半为向下照射的聚光灯
+            if (g_RandomGenerator.NextInt(0, 1) == 0) {
+                Math::Vector3 dir{
+                    g_RandomGenerator.NextFloat(-0.5f, 0.5f), -1, g_RandomGenerator.NextFloat(-0.5f, 0.5f)};
+                DirectX::XMStoreFloat3(&light.m_Dir, dir.Normalized());
+                light.m_EndAtten *= 2;
+                light.m_SpotPower = g_RandomGenerator.NextFloat(4.0f, 32.0f);
+            }
+            else {
+                light.m_Dir = {0, 0, 1};
+                light.m_SpotPower = 0;
+            }
+        }
+    }
+
 private:
     std::unique_ptr<Camera> m_Camera{};
     std::unique_ptr<CameraController> m_CameraController{};
@@ -122,11 +226,19 @@ private:
     D3D12_RECT m_Scissor{};
 
     Transform m_SceneTrans{};
-    GpuBuffer m_MeshConstants{};
+    // 方向光的传播方向
+    Math::Vector3 m_LightDir{-1, -1, -1};
 
     PassConstants m_PassConstants{};
 
     std::shared_ptr<Model> m_Model{};
+    // 遮挡体的深度在 CPU 上光栅化，每帧重新生成
+    OcclusionCuller m_OcclusionCuller{};
+    ClusteredLightCuller m_LightCuller{};
+    std::vector<SpotLight> m_Lights{};
+    CascadedShadowMap m_ShadowCascades{};
+
+    RenderGraph m_RenderGraph{};
 
 };
 
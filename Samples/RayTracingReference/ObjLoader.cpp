@@ -0,0 +1,110 @@
+#include "ObjLoader.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+namespace DSM {
+    namespace {
+        // OBJ 的索引从 1 开始，负数表示从末尾开始
+        std::int64_t ResolveIndex(std::int64_t index, std::size_t count) noexcept
+        {
+            return index < 0 ? std::int64_t(count) + index : index - 1;
+        }
+    }
+
+    bool ObjMesh::Load(const std::filesystem::path& path)
+    {
+        std::ifstream file{path};
+        if (!file) return false;
+
+        m_Vertices.clear();
+        m_Indices.clear();
+
+        std::vector<float> positions{}, normals{};
+        // (位置, 法线) 到顶点的映射，没有法线时法线索引为 -1
+        std::unordered_map<std::uint64_t, std::uint32_t> vertexMap{};
+        std::vector<std::uint32_t> face{};
+        bool hasNormals = true;
+
+        std::string line{};
+        while (std::getline(file, line)) {
+            std::istringstream stream{line};
+            std::string type{};
+            stream >> type;
+            if (type == "v" || type == "vn") {
+                float x{}, y{}, z{};
+                stream >> x >> y >> z;
+                // 转为左手系
+                auto& target = type == "v" ? positions : normals;
+                target.insert(target.end(), {x, y, -z});
+            }
+            else if (type == "f") {
+                face.clear();
+                std::string token{};
+                while (stream >> token) {
+                    auto firstSlash = token.find('/');
+                    auto lastSlash = token.rfind('/');
+                    auto position = ResolveIndex(std::stoll(token.substr(0, firstSlash)), positions.size() / 3);
+                    std::int64_t normal = -1;
+                    if (firstSlash != std::string::npos && lastSlash != firstSlash && lastSlash + 1 < token.size()) {
+                        normal = ResolveIndex(std::stoll(token.substr(lastSlash + 1)), normals.size() / 3);
+                    }
+                    if (position < 0 || std::size_t(position) * 3 >= positions.size() ||
+                        normal >= std::int64_t(normals.size() / 3)) {
+                        return false;
+                    }
+                    hasNormals &= normal >= 0;
+
+                    auto key = (std::uint64_t(position) << 32) | std::uint32_t(normal);
+                    auto [it, inserted] = vertexMap.try_emplace(key, std::uint32_t(m_Vertices.size()));
+                    if (inserted) {
+                        ObjVertex vertex{};
+                        for (std::uint32_t i = 0; i < 3; ++i) {
+                            vertex.m_Position[i] = positions[position * 3 + i];
+                            vertex.m_Normal[i] = normal >= 0 ? normals[normal * 3 + i] : 0;
+                        }
+                        m_Vertices.push_back(vertex);
+                    }
+                    face.push_back(it->second);
+                }
+
+                // 扇形拆分多边形，同时翻转绕序
+                for (std::size_t i = 2; i < face.size(); ++i) {
+                    m_Indices.insert(m_Indices.end(), {face[0], face[i], face[i - 1]});
+                }
+            }
+        }
+
+        if (!hasNormals) {
+            for (auto& vertex : m_Vertices) {
+                std::fill_n(vertex.m_Normal, 3, 0.0f);
+            }
+            // 叉积的长度为面积的两倍，直接累加即为面积加权，左手系中顺时针的三角形叉积朝外
+            for (std::size_t i = 0; i < m_Indices.size(); i += 3) {
+                const auto& p0 = m_Vertices[m_Indices[i]].m_Position;
+                const auto& p1 = m_Vertices[m_Indices[i + 1]].m_Position;
+                const auto& p2 = m_Vertices[m_Indices[i + 2]].m_Position;
+                float e1[3]{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                float e2[3]{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                float n[3]{e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                for (std::size_t k = 0; k < 3; ++k) {
+                    for (std::uint32_t c = 0; c < 3; ++c) {
+                        m_Vertices[m_Indices[i + k]].m_Normal[c] += n[c];
+                    }
+                }
+            }
+            for (auto& vertex : m_Vertices) {
+                auto& n = vertex.m_Normal;
+                auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length > 0) {
+                    for (auto& c : n) c /= length;
+                }
+            }
+        }
+
+        return !m_Indices.empty();
+    }
+}
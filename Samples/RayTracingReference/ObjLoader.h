@@ -0,0 +1,27 @@
+#pragma once
+#ifndef __OBJLOADER_H__
+#define __OBJLOADER_H__
+
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+
+namespace DSM {
+    struct ObjVertex
+    {
+        float m_Position[3];
+        float m_Normal[3];
+    };
+
+    // 只读取位置、法线与面，与 ModelLoader 使用 aiProcess_ConvertToLeftHanded 导入的结果相同，
+    // 没有法线时按面积加权生成平滑法线
+    struct ObjMesh
+    {
+        std::vector<ObjVertex> m_Vertices{};
+        std::vector<std::uint32_t> m_Indices{};
+
+        bool Load(const std::filesystem::path& path);
+    };
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include "ReferenceTracer.h"
+#include "Utilities/ParallelFor.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "Utilities/stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "Utilities/stb_image_write.h"
+
+namespace DSM {
+    namespace {
+        // 每个射线包覆盖的像素块
+        constexpr std::uint32_t kPacketWidth = 4;
+        constexpr std::uint32_t kPacketHeight = BVH::sm_PacketWidth / kPacketWidth;
+
+        struct Float3
+        {
+            float x, y, z;
+        };
+
+        Float3 operator+(Float3 a, Float3 b) noexcept { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+        Float3 operator-(Float3 a, Float3 b) noexcept { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+        Float3 operator*(Float3 a, float s) noexcept { return {a.x * s, a.y * s, a.z * s}; }
+        Float3 operator/(Float3 a, float s) noexcept { return {a.x / s, a.y / s, a.z / s}; }
+        float Dot(Float3 a, Float3 b) noexcept { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        Float3 Cross(Float3 a, Float3 b) noexcept { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+        Float3 Normalize(Float3 v) noexcept { return v * (1 / std::sqrt(Dot(v, v))); }
+        Float3 ToFloat3(const float (&v)[4]) noexcept { return {v[0], v[1], v[2]}; }
+
+        Float3 LoadFloat3(const void* data, std::uint32_t stride, std::uint32_t index) noexcept
+        {
+            Float3 v{};
+            memcpy(&v, static_cast<const std::uint8_t*>(data) + std::size_t(index) * stride, sizeof(v));
+            return v;
+        }
+
+        // 与写入 UNORM 纹理时的转换相同，NaN 写为 0
+        std::uint8_t ToUNorm(float v) noexcept
+        {
+            v = v > 0 ? (std::min)(v, 1.0f) : 0.0f;
+            return static_cast<std::uint8_t>(v * 255 + 0.5f);
+        }
+    }
+
+    bool ReferenceImage::Save(const std::filesystem::path& path) const
+    {
+        if (m_Pixels.size() != std::size_t(m_Width) * m_Height * 4) return false;
+        return stbi_write_png(path.string().c_str(), int(m_Width), int(m_Height), 4, m_Pixels.data(), int(m_Width * 4)) != 0;
+    }
+
+    bool ReferenceImage::Load(const std::filesystem::path& path)
+    {
+        int width{}, height{}, channels{};
+        auto* pixels = stbi_load(path.string().c_str(), &width, &height, &channels, 4);
+        if (pixels == nullptr) return false;
+
+        m_Width = static_cast<std::uint32_t>(width);
+        m_Height = static_cast<std::uint32_t>(height);
+        m_Pixels.assign(pixels, pixels + std::size_t(width) * height * 4);
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    void ReferenceTracer::SetScene(std::span<const ReferenceMesh> meshes, const BVHBuildDesc& buildDesc)
+    {
+        m_Meshes.assign(meshes.begin(), meshes.end());
+
+        std::vector<BVHGeometry> geometries{};
+        geometries.reserve(meshes.size());
+        for (const auto& mesh : meshes) {
+            geometries.push_back(mesh.m_Geometry);
+        }
+        m_BVH.Build(geometries, buildDesc);
+    }
+
+    ReferenceTraceStats ReferenceTracer::Render(const ReferenceSceneConstants& sceneCB, const ReferenceTraceDesc& desc, ReferenceImage& image) const
+    {
+        image.m_Width = desc.m_Width;
+        image.m_Height = desc.m_Height;
+        image.m_Pixels.assign(std::size_t(desc.m_Width) * desc.m_Height * 4, 0);
+
+        auto tileSize = (std::max)(desc.m_TileSize, 1u);
+        auto numTilesX = (desc.m_Width + tileSize - 1) / tileSize;
+        auto numTilesY = (desc.m_Height + tileSize - 1) / tileSize;
+        auto numTiles = numTilesX * numTilesY;
+        auto numThreads = desc.m_NumThreads == 0 ? (std::max)(std::thread::hardware_concurrency(), 1u) : desc.m_NumThreads;
+
+        // 块的耗时差别很大，线程按顺序领取下一个块而不是预先平均分配
+        std::atomic<std::uint32_t> nextTile{0};
+        std::atomic<std::uint64_t> numRays{0}, numHits{0};
+        auto startTime = std::chrono::high_resolution_clock::now();
+        Utility::ParallelFor(numThreads, numThreads, [&](std::uint32_t, std::uint32_t) {
+            ReferenceTraceStats threadStats{};
+            for (auto tile = nextTile.fetch_add(1); tile < numTiles; tile = nextTile.fetch_add(1)) {
+                RenderTile(sceneCB, desc, tile % numTilesX, tile / numTilesX, image, threadStats);
+            }
+            numRays += threadStats.m_NumRays;
+            numHits += threadStats.m_NumHits;
+        });
+
+        ReferenceTraceStats stats{};
+        stats.m_NumRays = numRays;
+        stats.m_NumHits = numHits;
+        stats.m_TraceTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+        return stats;
+    }
+
+    ReferenceImageDiff ReferenceTracer::Compare(const ReferenceImage& image, const ReferenceImage& golden, std::uint32_t threshold)
+    {
+        ReferenceImageDiff diff{};
+        if (image.m_Width != golden.m_Width || image.m_Height != golden.m_Height ||
+            image.m_Pixels.size() != golden.m_Pixels.size()) {
+            diff.m_SizeMismatch = true;
+            return diff;
+        }
+
+        std::uint64_t totalError = 0;
+        for (std::size_t i = 0; i < image.m_Pixels.size(); i += 4) {
+            std::uint32_t pixelError = 0;
+            for (std::size_t c = 0; c < 4; ++c) {
+                auto error = static_cast<std::uint32_t>(std::abs(int(image.m_Pixels[i + c]) - int(golden.m_Pixels[i + c])));
+                pixelError = (std::max)(pixelError, error);
+                totalError += error;
+            }
+            diff.m_MaxError = (std::max)(diff.m_MaxError, pixelError);
+            if (pixelError > threshold) ++diff.m_NumDiffPixels;
+        }
+        diff.m_MeanError = image.m_Pixels.empty() ? 0 : double(totalError) / image.m_Pixels.size();
+        return diff;
+    }
+
+    void ReferenceTracer::RenderTile(const ReferenceSceneConstants& sceneCB, const ReferenceTraceDesc& desc,
+        std::uint32_t tileX, std::uint32_t tileY, ReferenceImage& image, ReferenceTraceStats& stats) const
+    {
+        auto tileSize = (std::max)(desc.m_TileSize, 1u);
+        auto beginX = tileX * tileSize, endX = (std::min)(beginX + tileSize, desc.m_Width);
+        auto beginY = tileY * tileSize, endY = (std::min)(beginY + tileSize, desc.m_Height);
+
+        auto writePixel = [&](std::uint32_t x, std::uint32_t y, const BVHHit& hit) {
+            // RaygenShader 中 payload 的初始值，也是 MissShader 的结果
+            float color[4]{0, 0, 0, 1};
+            if (hit.IsHit()) {
+                Shade(sceneCB, hit, color);
+                ++stats.m_NumHits;
+            }
+            auto* pixel = image.m_Pixels.data() + (std::size_t(y) * desc.m_Width + x) * 4;
+            for (std::uint32_t c = 0; c < 4; ++c) {
+                pixel[c] = ToUNorm(color[c]);
+            }
+        };
+
+        if (!desc.m_UsePackets) {
+            for (auto y = beginY; y < endY; ++y) {
+                for (auto x = beginX; x < endX; ++x) {
+                    BVHHit hit{};
+                    m_BVH.Intersect(GetRay(sceneCB, desc, x, y), hit);
+                    writePixel(x, y, hit);
+                }
+            }
+            stats.m_NumRays += std::uint64_t(endX - beginX) * (endY - beginY);
+            return;
+        }
+
+        BVHRay rays[BVH::sm_PacketWidth];
+        BVHHit hits[BVH::sm_PacketWidth];
+        std::uint32_t pixelX[BVH::sm_PacketWidth], pixelY[BVH::sm_PacketWidth];
+        for (auto y = beginY; y < endY; y += kPacketHeight) {
+            for (auto x = beginX; x < endX; x += kPacketWidth) {
+                std::uint32_t numRays = 0;
+                for (std::uint32_t py = y; py < (std::min)(y + kPacketHeight, endY); ++py) {
+                    for (std::uint32_t px = x; px < (std::min)(x + kPacketWidth, endX); ++px) {
+                        pixelX[numRays] = px;
+                        pixelY[numRays] = py;
+                        rays[numRays] = GetRay(sceneCB, desc, px, py);
+                        hits[numRays] = {};
+                        ++numRays;
+                    }
+                }
+                m_BVH.IntersectPacket({rays, numRays}, {hits, numRays});
+                for (std::uint32_t i = 0; i < numRays; ++i) {
+                    writePixel(pixelX[i], pixelY[i], hits[i]);
+                }
+                stats.m_NumRays += numRays;
+            }
+        }
+    }
+
+    // RayTracing.hlsl 中的 GetRay
+    BVHRay ReferenceTracer::GetRay(const ReferenceSceneConstants& sceneCB, const ReferenceTraceDesc& desc, std::uint32_t x, std::uint32_t y) const noexcept
+    {
+        auto viewportU = ToFloat3(sceneCB.m_ViewportU);
+        auto viewportV = ToFloat3(sceneCB.m_ViewportV);
+        auto front = Normalize(Cross(viewportV, viewportU));
+
+        auto pixelDeltaU = viewportU / float(desc.m_Width);
+        auto pixelDeltaV = viewportV / float(desc.m_Height);
+
+        auto cameraPos = ToFloat3(sceneCB.m_CameraPosAndFocusDist);
+        auto focusDist = sceneCB.m_CameraPosAndFocusDist[3];
+        auto startPixelCenter = cameraPos + front * focusDist - (viewportU + viewportV) * 0.5f;
+        startPixelCenter = startPixelCenter + (pixelDeltaU + pixelDeltaV) * 0.5f;
+
+        auto pixelSample = startPixelCenter + pixelDeltaU * float(x) + pixelDeltaV * float(y);
+        auto direction = Normalize(pixelSample - cameraPos);
+
+        BVHRay ray{};
+        ray.m_Origin = {cameraPos.x, cameraPos.y, cameraPos.z};
+        ray.m_Direction = {direction.x, direction.y, direction.z};
+        ray.m_TMin = 0.001f;
+        ray.m_TMax = 10000.0f;
+        // TraceRay 使用 RAY_FLAG_CULL_BACK_FACING_TRIANGLES
+        ray.m_CullMode = BVHCullMode::kBackFacing;
+        return ray;
+    }
+
+    // RayTracing.hlsl 中的 ClosestHitShader，法线插值后不做归一化
+    void ReferenceTracer::Shade(const ReferenceSceneConstants& sceneCB, const BVHHit& hit, float (&color)[4]) const noexcept
+    {
+        const auto& mesh = m_Meshes[hit.m_Geometry];
+        const auto& geometry = mesh.m_Geometry;
+        std::uint32_t indices[3];
+        for (std::uint32_t i = 0; i < 3; ++i) {
+            auto index = hit.m_Primitive * 3 + i;
+            indices[i] = (geometry.m_Indices != nullptr ? geometry.m_Indices[index] : index) + geometry.m_BaseVertex;
+        }
+
+        Float3 normals[3];
+        for (std::uint32_t i = 0; i < 3; ++i) {
+            normals[i] = LoadFloat3(mesh.m_Normals, mesh.m_NormalStride, indices[i]);
+        }
+        auto normal = normals[0] + (normals[1] - normals[0]) * hit.m_U + (normals[2] - normals[0]) * hit.m_V;
+
+        auto lightDir = Normalize(ToFloat3(sceneCB.m_LightDir)) * -1.0f;
+        auto intensity = (std::max)(0.0f, Dot(lightDir, normal));
+        for (std::uint32_t c = 0; c < 3; ++c) {
+            color[c] = sceneCB.m_LightColor[c] * mesh.m_Albedo[c] * intensity;
+        }
+        color[3] = mesh.m_Albedo[3];
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef __REFERENCETRACER_H__
+#define __REFERENCETRACER_H__
+
+#include "RayTracing/BVH.h"
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace DSM {
+    // 与 RayTracingSimpleLight/Shaders/RayTracingHLSLCompat.h 中的 SceneConstantBuffer 相同
+    struct ReferenceSceneConstants
+    {
+        float m_CameraPosAndFocusDist[4]{};
+        float m_ViewportU[4]{};
+        float m_ViewportV[4]{};
+        float m_LightDir[4]{};
+        float m_LightColor[4]{};
+    };
+
+    // 一个命中组，法线按字节步长读取，与位置使用相同的索引
+    struct ReferenceMesh
+    {
+        BVHGeometry m_Geometry{};
+        const void* m_Normals{};
+        std::uint32_t m_NormalStride = sizeof(float) * 3;
+        // CubeConstantBuffer::albedo
+        float m_Albedo[4]{1, 1, 1, 1};
+    };
+
+    // R8G8B8A8_UNORM
+    struct ReferenceImage
+    {
+        std::uint32_t m_Width = 0;
+        std::uint32_t m_Height = 0;
+        std::vector<std::uint8_t> m_Pixels{};
+
+        bool Save(const std::filesystem::path& path) const;
+        bool Load(const std::filesystem::path& path);
+    };
+
+    struct ReferenceTraceDesc
+    {
+        std::uint32_t m_Width = 1024;
+        std::uint32_t m_Height = 768;
+        std::uint32_t m_TileSize = 16;
+        // 0 表示使用所有硬件线程
+        std::uint32_t m_NumThreads = 0;
+        // 按 4x2 的像素块使用射线包遍历
+        bool m_UsePackets = true;
+    };
+
+    struct ReferenceTraceStats
+    {
+        std::uint64_t m_NumRays = 0;
+        std::uint64_t m_NumHits = 0;
+        // 毫秒
+        double m_TraceTime = 0;
+
+        double GetRaysPerSecond() const noexcept { return m_TraceTime > 0 ? m_NumRays * 1000.0 / m_TraceTime : 0; }
+    };
+
+    struct ReferenceImageDiff
+    {
+        std::uint32_t m_MaxError = 0;
+        double m_MeanError = 0;
+        // 任一通道的差大于阈值的像素数
+        std::uint32_t m_NumDiffPixels = 0;
+        bool m_SizeMismatch = false;
+    };
+
+    // RayTracingSimpleLight 的 CPU 参考实现，按 16x16 的块多线程渲染，
+    // 光线生成、最近命中与未命中的逻辑与 Shaders/RayTracing.hlsl 逐行对应，用于在没有 GPU 时验证结果与生成基准图像
+    class ReferenceTracer
+    {
+    public:
+        void SetScene(std::span<const ReferenceMesh> meshes, const BVHBuildDesc& buildDesc = {});
+
+        ReferenceTraceStats Render(const ReferenceSceneConstants& sceneCB, const ReferenceTraceDesc& desc, ReferenceImage& image) const;
+
+        static ReferenceImageDiff Compare(const ReferenceImage& image, const ReferenceImage& golden, std::uint32_t threshold);
+
+        const BVH& GetBVH() const noexcept { return m_BVH; }
+
+    private:
+        void RenderTile(const ReferenceSceneConstants& sceneCB, const ReferenceTraceDesc& desc,
+            std::uint32_t tileX, std::uint32_t tileY, ReferenceImage& image, ReferenceTraceStats& stats) const;
+        BVHRay GetRay(const ReferenceSceneConstants& sceneCB, const ReferenceTraceDesc& desc, std::uint32_t x, std::uint32_t y) const noexcept;
+        void Shade(const ReferenceSceneConstants& sceneCB, const BVHHit& hit, float (&color)[4]) const noexcept;
+
+    private:
+        std::vector<ReferenceMesh> m_Meshes{};
+        BVH m_BVH{};
+    };
+}
+
+#endif
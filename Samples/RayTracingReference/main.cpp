@@ -0,0 +1,227 @@
+// RayTracingSimpleLight 的无窗口 CPU 参考渲染，输出图像、每秒射线数以及与基准图像的差异
+// 用法: RayTracingReference [--model file.obj] [--width 1024] [--height 768] [--threads 0] [--single]
+//       [--bvh sah|lbvh] [--bvh-width 4|8] [--out dir] [--golden dir] [--threshold 1] [--update-goldens]
+// 与基准图像不一致时返回 1，参数错误时返回 2
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <numbers>
+#include "ReferenceTracer.h"
+#include "ObjLoader.h"
+
+using namespace DSM;
+
+namespace {
+    struct Vector3
+    {
+        float x, y, z;
+    };
+
+    Vector3 operator-(Vector3 a, Vector3 b) noexcept { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Vector3 operator*(Vector3 a, float s) noexcept { return {a.x * s, a.y * s, a.z * s}; }
+    Vector3 Cross(Vector3 a, Vector3 b) noexcept { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    Vector3 Normalize(Vector3 v) noexcept { return v * (1 / std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z)); }
+
+    // 与 Renderer.cpp 中 Geometry::GeometryGenerator::CreateBox(3, 3, 3, 0) 的位置、法线与索引相同
+    struct BoxMesh
+    {
+        ObjVertex m_Vertices[24];
+        std::uint32_t m_Indices[36];
+
+        BoxMesh(float width, float height, float depth) noexcept
+        {
+            float w2 = 0.5f * width, h2 = 0.5f * height, d2 = 0.5f * depth;
+            const float faces[6][4][3] = {
+                {{-w2, -h2, -d2}, {-w2, +h2, -d2}, {+w2, +h2, -d2}, {+w2, -h2, -d2}},
+                {{-w2, -h2, +d2}, {+w2, -h2, +d2}, {+w2, +h2, +d2}, {-w2, +h2, +d2}},
+                {{-w2, +h2, -d2}, {-w2, +h2, +d2}, {+w2, +h2, +d2}, {+w2, +h2, -d2}},
+                {{-w2, -h2, -d2}, {+w2, -h2, -d2}, {+w2, -h2, +d2}, {-w2, -h2, +d2}},
+                {{-w2, -h2, +d2}, {-w2, +h2, +d2}, {-w2, +h2, -d2}, {-w2, -h2, -d2}},
+                {{+w2, -h2, -d2}, {+w2, +h2, -d2}, {+w2, +h2, +d2}, {+w2, -h2, +d2}}};
+            const float normals[6][3] = {{0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, -1, 0}, {-1, 0, 0}, {1, 0, 0}};
+            for (std::uint32_t face = 0; face < 6; ++face) {
+                for (std::uint32_t i = 0; i < 4; ++i) {
+                    auto& vertex = m_Vertices[face * 4 + i];
+                    memcpy(vertex.m_Position, faces[face][i], sizeof(vertex.m_Position));
+                    memcpy(vertex.m_Normal, normals[face], sizeof(vertex.m_Normal));
+                }
+                const std::uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+                for (std::uint32_t i = 0; i < 6; ++i) {
+                    m_Indices[face * 6 + i] = face * 4 + quad[i];
+                }
+            }
+        }
+    };
+
+    struct View
+    {
+        const char* m_Name;
+        Vector3 m_Position;
+        Vector3 m_Target;
+    };
+
+    // 与 RayTracer::TraceRays 相同，相机朝向与 Transform::LookAt 使用的 XMMatrixLookAtLH 相同
+    ReferenceSceneConstants GetSceneConstants(const View& view, float aspect)
+    {
+        // main.cpp 中的 XM_PIDIV4 与 TraceRays 中的 focusDist
+        constexpr float fovY = std::numbers::pi_v<float> / 4;
+        constexpr float focusDist = 10;
+        auto front = Normalize(view.m_Target - view.m_Position);
+        auto right = Normalize(Cross({0, 1, 0}, front));
+        auto up = Cross(front, right);
+
+        auto h = std::tan(fovY * .5f);
+        auto viewportHeight = 2 * h * focusDist;
+        auto viewportWidth = viewportHeight * aspect;
+        auto viewportU = right * viewportWidth;
+        auto viewportV = up * -viewportHeight;
+
+        // ImguiManager 中的默认值
+        auto lightDir = Normalize({-0.5f, -1.0f, 0.7f});
+
+        ReferenceSceneConstants sceneCB{};
+        sceneCB.m_CameraPosAndFocusDist[0] = view.m_Position.x;
+        sceneCB.m_CameraPosAndFocusDist[1] = view.m_Position.y;
+        sceneCB.m_CameraPosAndFocusDist[2] = view.m_Position.z;
+        sceneCB.m_CameraPosAndFocusDist[3] = focusDist;
+        memcpy(sceneCB.m_ViewportU, &viewportU, sizeof(viewportU));
+        memcpy(sceneCB.m_ViewportV, &viewportV, sizeof(viewportV));
+        memcpy(sceneCB.m_LightDir, &lightDir, sizeof(lightDir));
+        sceneCB.m_LightColor[0] = sceneCB.m_LightColor[1] = sceneCB.m_LightColor[2] = 1;
+        return sceneCB;
+    }
+
+    ReferenceMesh GetReferenceMesh(const ObjVertex* vertices, std::uint32_t numVertices, const std::uint32_t* indices, std::uint32_t numIndices)
+    {
+        ReferenceMesh mesh{};
+        mesh.m_Geometry.m_Positions = vertices->m_Position;
+        mesh.m_Geometry.m_PositionStride = sizeof(ObjVertex);
+        mesh.m_Geometry.m_NumVertices = numVertices;
+        mesh.m_Geometry.m_Indices = indices;
+        mesh.m_Geometry.m_NumIndices = numIndices;
+        mesh.m_Normals = vertices->m_Normal;
+        mesh.m_NormalStride = sizeof(ObjVertex);
+        // ImguiManager 中 cubeAlbedo 的默认值，Vector4(Vector3) 的 w 为 1
+        const float albedo[4]{1, 0.8f, 0.8f, 1};
+        memcpy(mesh.m_Albedo, albedo, sizeof(albedo));
+        return mesh;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ReferenceTraceDesc traceDesc{};
+    BVHBuildDesc buildDesc{};
+    std::string modelPath{}, outDir{"."}, goldenDir{};
+    std::uint32_t threshold = 1;
+    bool updateGoldens = false;
+
+    // 需要参数值的选项，缺少值时报错而不是当作空字符串，避免 --golden 没有目录时静默跳过比较
+    constexpr const char* kValueArgs[] = {
+        "--model", "--width", "--height", "--threads", "--bvh", "--bvh-width", "--out", "--golden", "--threshold"};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool needsValue = std::any_of(std::begin(kValueArgs), std::end(kValueArgs), [&](const char* name) { return arg == name; });
+        if (needsValue && (i + 1 >= argc || argv[i + 1][0] == '\0' || std::strncmp(argv[i + 1], "--", 2) == 0)) {
+            std::printf("Missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        auto next = [&]() -> const char* { return argv[++i]; };
+        if (arg == "--model") modelPath = next();
+        else if (arg == "--width") traceDesc.m_Width = std::stoul(next());
+        else if (arg == "--height") traceDesc.m_Height = std::stoul(next());
+        else if (arg == "--threads") traceDesc.m_NumThreads = buildDesc.m_NumThreads = std::stoul(next());
+        else if (arg == "--single") traceDesc.m_UsePackets = false;
+        else if (arg == "--bvh") buildDesc.m_Method = std::strcmp(next(), "lbvh") == 0 ? BVHBuildMethod::kLBVH : BVHBuildMethod::kBinnedSAH;
+        else if (arg == "--bvh-width") buildDesc.m_Width = std::stoul(next());
+        else if (arg == "--out") outDir = next();
+        else if (arg == "--golden") goldenDir = next();
+        else if (arg == "--threshold") threshold = std::stoul(next());
+        else if (arg == "--update-goldens") updateGoldens = true;
+        else {
+            std::printf("Unknown argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (traceDesc.m_Width == 0 || traceDesc.m_Height == 0) {
+        std::printf("Invalid image size\n");
+        return 2;
+    }
+
+    BoxMesh box{3, 3, 3};
+    ObjMesh model{};
+    ReferenceTracer tracer{};
+    std::vector<View> views{};
+    if (modelPath.empty()) {
+        auto mesh = GetReferenceMesh(box.m_Vertices, 24, box.m_Indices, 36);
+        tracer.SetScene({&mesh, 1}, buildDesc);
+        // RayTracingSimpleLight 的初始相机，以及从左侧观察的相机用于覆盖其余的面
+        views.push_back({"box", {5, 5, -5}, {0, 0, 0}});
+        views.push_back({"box_left", {-7, 3, -4}, {0, 0, 0}});
+    }
+    else {
+        if (!model.Load(modelPath)) {
+            std::printf("Failed to load %s\n", modelPath.c_str());
+            return 2;
+        }
+        auto mesh = GetReferenceMesh(model.m_Vertices.data(), std::uint32_t(model.m_Vertices.size()),
+            model.m_Indices.data(), std::uint32_t(model.m_Indices.size()));
+        tracer.SetScene({&mesh, 1}, buildDesc);
+
+        // 与初始相机方向相同，距离按包围球调整使模型位于视野内
+        const auto& bounds = tracer.GetBVH().GetBounds();
+        Vector3 center{(bounds.m_Min.x + bounds.m_Max.x) * .5f, (bounds.m_Min.y + bounds.m_Max.y) * .5f, (bounds.m_Min.z + bounds.m_Max.z) * .5f};
+        Vector3 extent = Vector3{bounds.m_Max.x, bounds.m_Max.y, bounds.m_Max.z} - center;
+        auto radius = std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+        auto distance = radius / std::sin(std::numbers::pi_v<float> / 8) / std::sqrt(3.0f);
+        views.push_back({"model", {center.x + distance, center.y + distance, center.z - distance}, center});
+    }
+
+    const auto& bvhStats = tracer.GetBVH().GetStats();
+    std::printf("BVH: %u triangles, %u nodes, build %.2f ms\n", bvhStats.m_NumTriangles, bvhStats.m_NumNodes, bvhStats.m_BuildTime);
+
+    int result = 0;
+    for (const auto& view : views) {
+        auto sceneCB = GetSceneConstants(view, float(traceDesc.m_Width) / traceDesc.m_Height);
+
+        ReferenceImage image{};
+        auto stats = tracer.Render(sceneCB, traceDesc, image);
+        std::printf("%s: %ux%u, %.2f ms, %.2f Mrays/s, %.1f%% hit\n", view.m_Name, traceDesc.m_Width, traceDesc.m_Height,
+            stats.m_TraceTime, stats.GetRaysPerSecond() / 1e6, stats.m_NumRays > 0 ? 100.0 * stats.m_NumHits / stats.m_NumRays : 0.0);
+
+        auto outPath = std::filesystem::path{outDir} / (std::string{view.m_Name} + ".png");
+        if (!image.Save(outPath)) {
+            std::printf("Failed to write %s\n", outPath.string().c_str());
+            result = 2;
+        }
+        if (goldenDir.empty()) continue;
+
+        auto goldenPath = std::filesystem::path{goldenDir} / (std::string{view.m_Name} + ".png");
+        if (updateGoldens) {
+            if (!image.Save(goldenPath)) {
+                std::printf("Failed to write %s\n", goldenPath.string().c_str());
+                result = 2;
+            }
+            continue;
+        }
+
+        ReferenceImage golden{};
+        if (!golden.Load(goldenPath)) {
+            std::printf("  missing golden %s\n", goldenPath.string().c_str());
+            result = (std::max)(result, 1);
+            continue;
+        }
+        auto diff = ReferenceTracer::Compare(image, golden, threshold);
+        if (diff.m_SizeMismatch) {
+            std::printf("  golden size %ux%u does not match\n", golden.m_Width, golden.m_Height);
+            result = (std::max)(result, 1);
+            continue;
+        }
+        std::printf("  vs golden: max error %u, mean error %.4f, %u pixels over %u\n",
+            diff.m_MaxError, diff.m_MeanError, diff.m_NumDiffPixels, threshold);
+        if (diff.m_NumDiffPixels > 0) result = (std::max)(result, 1);
+    }
+    return result;
+}
@@ -0,0 +1,21 @@
+targetName = "RayTracingReference"
+target(targetName)
+    set_kind("binary")
+    set_targetdir(path.join(binDir, targetName))
+
+    -- 无窗口的命令行工具，只使用引擎中与平台无关的 BVH，不依赖 D3D12
+    add_includedirs("../../LearnMiniEngine")
+    add_files("../../LearnMiniEngine/RayTracing/BVH*.cpp")
+
+    add_files("**.cpp")
+    add_headerfiles("**.h")
+
+    after_build(
+        function(target)
+            os.cp(path.join(target:scriptdir(), "Goldens"), target:targetdir())
+        end)
+
+    -- xmake test 在输出目录中运行，渲染默认场景并与复制过来的基准图像比较，不一致时返回非零值
+    add_tests("golden", {runargs = {"--golden", "Goldens"}})
+
+target_end()
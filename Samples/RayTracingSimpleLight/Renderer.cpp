@@ -33,7 +33,9 @@ namespace DSM {
         
         // 创建根签名
         // 给 HitGroup 设置的资源
-        m_LocalRootSig[0].InitAsConstants(1, sizeof(CubeConstantBuffer) / sizeof(uint32_t) + 1);
+        auto numCubeConstants = static_cast<uint32_t>(sizeof(CubeConstantBuffer) / sizeof(uint32_t) + 1);
+        m_LocalRootSig[0].InitAsConstants(1, numCubeConstants);
+        m_HitGroupLayout = ShaderRecordLayout{{ShaderRecordArgumentType::kConstants, numCubeConstants}};
         m_LocalRootSig.Finalize(L"RayTracingLocalRootSignature", D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE);
         m_GlobalRootSig[RayTracingOutput].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 1);  // RayTracingOutput
         m_GlobalRootSig[AccelerationStructure].InitAsBufferSRV(0);  // 加速结构
@@ -53,6 +55,12 @@ namespace DSM {
 
     void Renderer::Shutdown()
     {
+        if (!m_Initialized) return;
+
+        m_ASManager.Shutdown();
+        m_ASBackend.Shutdown();
+        m_ShaderTableBuffer.Destroy();
+        m_Initialized = false;
     }
 
     void Renderer::OnResize(uint32_t width, uint32_t height)
@@ -183,115 +191,48 @@ namespace DSM {
 
     void Renderer::CreateAccelerationStructure()
     {
-        // 给底层加速结构的几何描述
-        D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC trianglesDesc{};
-        trianglesDesc.Transform3x4 = 0;
-        trianglesDesc.IndexFormat = DXGI_FORMAT_R32_UINT;
-        trianglesDesc.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-        trianglesDesc.IndexCount = m_IndexBuffer.GetCount();
-        trianglesDesc.VertexCount = m_VertexBuffer.GetCount();
-        trianglesDesc.IndexBuffer = m_IndexBuffer.GetGpuVirtualAddress();
-        trianglesDesc.VertexBuffer.StartAddress = m_VertexBuffer.GetGpuVirtualAddress();
-        trianglesDesc.VertexBuffer.StrideInBytes = m_VertexBuffer.GetStride();
-        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc{};
-        geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-        geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-        geometryDesc.Triangles = trianglesDesc;
-
-        // 底层加速结构的输入
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS bottomLevelASInputs{};
-        bottomLevelASInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
-        bottomLevelASInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-        bottomLevelASInputs.NumDescs = 1;
-        bottomLevelASInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-        bottomLevelASInputs.pGeometryDescs = &geometryDesc;
-        
-        // 获取加速结构的相关信息
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO bottomLevelASInfo{};
-        g_RenderContext.GetDevice()->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelASInputs, &bottomLevelASInfo);
-        ASSERT(bottomLevelASInfo.ResultDataMaxSizeInBytes > 0);
-
-        // 顶层加速结构的输入
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS topLevelASInputs = bottomLevelASInputs;
-        topLevelASInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
-
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO topLevelASInfo{};
-        g_RenderContext.GetDevice()->GetRaytracingAccelerationStructurePrebuildInfo(&topLevelASInputs, &topLevelASInfo);
-        ASSERT(topLevelASInfo.ResultDataMaxSizeInBytes > 0);
-
-        // 为加速结构分配显存
-        GpuBufferDesc bottomLevelASDesc{};
-        bottomLevelASDesc.m_Size = bottomLevelASInfo.ResultDataMaxSizeInBytes;
-        bottomLevelASDesc.m_Stride = bottomLevelASDesc.m_Size;
-        bottomLevelASDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
-        bottomLevelASDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-        m_BottomLevelAS.Create(L"BottomLevelAS", bottomLevelASDesc);
-        GpuBufferDesc topLevelASDesc = bottomLevelASDesc;
-        topLevelASDesc.m_Size = topLevelASInfo.ResultDataMaxSizeInBytes;
-        topLevelASDesc.m_Stride = topLevelASDesc.m_Size;
-        m_TopLevelAS.Create(L"TopLevelAS", topLevelASDesc);
-
-        // 顶层加速结构的输入，使用底层加速结构作为输入
-        D3D12_RAYTRACING_INSTANCE_DESC instanceDesc{};
-        instanceDesc.Transform[0][0] = instanceDesc.Transform[1][1] = instanceDesc.Transform[2][2] = 1.0f;
-        instanceDesc.InstanceMask = 1;
-        instanceDesc.AccelerationStructure = m_BottomLevelAS.GetGpuVirtualAddress();
-        GpuResourceLocation instanceBuffer = g_RenderContext.GetCpuBufferAllocator().Allocate(sizeof(instanceDesc), D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT);
-        memcpy(instanceBuffer.m_MappedAddress, &instanceDesc, sizeof(instanceDesc));
-        topLevelASInputs.InstanceDescs = instanceBuffer.m_GpuAddress;
-
-        // 分配加速结构生成需要的暂存空间
-        uint64_t scratchBufferSize = (std::max)(bottomLevelASInfo.ScratchDataSizeInBytes, topLevelASInfo.ScratchDataSizeInBytes);
-        GpuResourceLocation scratchBuffer = g_RenderContext.GetGpuBufferAllocator().Allocate(scratchBufferSize);
-
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildBottomLevelASDesc{};
-        buildBottomLevelASDesc.Inputs = bottomLevelASInputs;
-        buildBottomLevelASDesc.ScratchAccelerationStructureData = scratchBuffer.m_GpuAddress;
-        buildBottomLevelASDesc.DestAccelerationStructureData = m_BottomLevelAS.GetGpuVirtualAddress();
-
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildTopLevelASDesc{};
-        buildTopLevelASDesc.Inputs = topLevelASInputs;
-        buildTopLevelASDesc.ScratchAccelerationStructureData = scratchBuffer.m_GpuAddress;
-        buildTopLevelASDesc.DestAccelerationStructureData = m_TopLevelAS.GetGpuVirtualAddress();
-
-        // 构建加速结构
-        GraphicsCommandList cmdList{L"BuildAccelerationStructure"};
-        cmdList.GetDXRCommandList()->BuildRaytracingAccelerationStructure(&buildBottomLevelASDesc, 0, nullptr);
-        // 等待底层加速结构构建完毕
-        cmdList.InsertUAVBarrier(m_BottomLevelAS, true);
-        cmdList.GetDXRCommandList()->BuildRaytracingAccelerationStructure(&buildTopLevelASDesc, 0, nullptr);
-        cmdList.ExecuteCommandList(true);
+        // 每个帧槽位都需要独立的压缩查询
+        AccelerationStructureManagerDesc managerDesc{};
+        managerDesc.m_NumFramesInFlight = g_RenderContext.GetFrameScheduler().GetNumFramesInFlight();
+        m_ASBackend.Create(g_RenderContext.GetDevice(), managerDesc.m_NumFramesInFlight * managerDesc.m_MaxCompactionsPerFrame);
+        m_ASManager.Create(&m_ASBackend, managerDesc);
+
+        // 底层加速结构的几何，构建与压缩在之后的帧中完成
+        ASTriangleGeometry geometry{};
+        geometry.m_VertexAddress = m_VertexBuffer.GetGpuVirtualAddress();
+        geometry.m_VertexCount = m_VertexBuffer.GetCount();
+        geometry.m_VertexStride = m_VertexBuffer.GetStride();
+        geometry.m_IndexAddress = m_IndexBuffer.GetGpuVirtualAddress();
+        geometry.m_IndexCount = m_IndexBuffer.GetCount();
+        m_CubeBLAS = m_ASManager.CreateBLAS({&geometry, 1});
+
+        ASInstanceDesc instanceDesc{};
+        instanceDesc.m_Transform[0][0] = instanceDesc.m_Transform[1][1] = instanceDesc.m_Transform[2][2] = 1.0f;
+        instanceDesc.m_InstanceMask = 1;
+        m_CubeInstance = m_ASManager.AddInstance(instanceDesc, m_CubeBLAS);
+    }
+
+    void Renderer::UpdateAccelerationStructure(CommandList& cmdList)
+    {
+        m_ASBackend.SetCommandList(&cmdList);
+        m_ASManager.BeginFrame(g_RenderContext.GetFrameScheduler().GetFrameIndex());
+        m_ASManager.Update();
     }
 
     void Renderer::CreateShaderTable()
     {
-        // 创建着色器表
         // 获取 Shader 的标识符
         Microsoft::WRL::ComPtr<ID3D12StateObjectProperties> stateObjectProps{};
         ASSERT_SUCCEEDED(m_RayTracingStateObject.As(&stateObjectProps));
-        void* rayGenShaderIdentifier = stateObjectProps->GetShaderIdentifier(Renderer::s_RayGenShaderName);
-        void* missShaderIdentifier = stateObjectProps->GetShaderIdentifier(Renderer::s_MissShaderName);
-        void* hitGroupIdentifier = stateObjectProps->GetShaderIdentifier(Renderer::s_HitGroupName);
-
-        // RayGeneration 着色器表
-        GpuBufferDesc rayGenShaderTableDesc{};
-        rayGenShaderTableDesc.m_Size = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-        rayGenShaderTableDesc.m_Stride = rayGenShaderTableDesc.m_Size;
-        rayGenShaderTableDesc.m_HeapType = D3D12_HEAP_TYPE_UPLOAD;
-        m_RayGenShaderTable.Create(L"RayGenShaderTable", rayGenShaderTableDesc, rayGenShaderIdentifier);
-        // Miss 着色器表
-        GpuBufferDesc missShaderTableDesc = rayGenShaderTableDesc;
-        missShaderTableDesc.m_Size = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-        missShaderTableDesc.m_Stride = missShaderTableDesc.m_Size;
-        m_MissShaderTable.Create(L"MissShaderTable", missShaderTableDesc, missShaderIdentifier);
-        // Hit 着色器表
-        GpuBufferDesc hitShaderTableDesc = rayGenShaderTableDesc;
-        auto size = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + sizeof(CubeConstantBuffer);
-        hitShaderTableDesc.m_Size = Math::AlignUp(size, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
-        hitShaderTableDesc.m_Stride = hitShaderTableDesc.m_Size;
-        std::vector<uint8_t> hitShaderTableData(hitShaderTableDesc.m_Size);
-        memcpy(hitShaderTableData.data(), hitGroupIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
-        m_HitShaderTable.Create(L"HitShaderTable", hitShaderTableDesc, hitShaderTableData.data());
+
+        // 记录的大小由局部根签名的参数决定，内容在 GPU 上的缓冲创建时上传
+        m_ShaderTable.SetTable(ShaderTableType::kRayGen, 1, ShaderBindingTable::sm_IdentifierSize);
+        m_ShaderTable.SetTable(ShaderTableType::kMiss, 1, ShaderBindingTable::sm_IdentifierSize);
+        bool validRecord = m_ShaderTable.SetTable(ShaderTableType::kHitGroup, 1, m_HitGroupLayout.GetSize());
+        ASSERT(validRecord, "Hit group record exceeds D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE");
+        m_ShaderTable.SetIdentifier(ShaderTableType::kRayGen, 0, stateObjectProps->GetShaderIdentifier(Renderer::s_RayGenShaderName));
+        m_ShaderTable.SetIdentifier(ShaderTableType::kMiss, 0, stateObjectProps->GetShaderIdentifier(Renderer::s_MissShaderName));
+        m_ShaderTable.SetIdentifier(ShaderTableType::kHitGroup, 0, stateObjectProps->GetShaderIdentifier(Renderer::s_HitGroupName));
     }
 
     Renderer::Renderer()
@@ -326,26 +267,23 @@ namespace DSM {
 
         CubeConstantBuffer cubeCB{};
         cubeCB.albedo = Math::Vector4{ImguiManager::GetInstance().cubeAlbedo};
-        g_Renderer.m_HitShaderTable.Update(&cubeCB, sizeof(CubeConstantBuffer), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+        // 颜色没有改变时不需要拷贝
+        g_Renderer.m_ShaderTable.WriteArgument(ShaderTableType::kHitGroup, 0, g_Renderer.m_HitGroupLayout, 0, cubeCB);
+        g_Renderer.m_ShaderTableBuffer.Update(cmdList, g_Renderer.m_ShaderTable);
 
         cmdList.SetDescriptorTable(Renderer::RayTracingOutput, g_Renderer.m_OutputUAV);
-        cmdList.SetShaderResource(Renderer::AccelerationStructure, g_Renderer.m_TopLevelAS);
+        cmdList.GetCommandList()->SetComputeRootShaderResourceView(Renderer::AccelerationStructure, g_Renderer.m_ASManager.GetTLASAddress());
         cmdList.SetShaderResource(Renderer::VertexData, g_Renderer.m_VertexBuffer);
         cmdList.SetShaderResource(Renderer::IndexData, g_Renderer.m_IndexBuffer);
         cmdList.SetDynamicConstantBuffer(Renderer::SceneConstantBuffer, sizeof(SceneConstantBuffer), &sceneCB);
 
         D3D12_DISPATCH_RAYS_DESC dispatchDesc{};
-        dispatchDesc.HitGroupTable.StartAddress = g_Renderer.m_HitShaderTable->GetGPUVirtualAddress();
-        dispatchDesc.HitGroupTable.SizeInBytes = g_Renderer.m_HitShaderTable.GetSize();
-        dispatchDesc.HitGroupTable.StrideInBytes = dispatchDesc.HitGroupTable.SizeInBytes;
-        dispatchDesc.MissShaderTable.StartAddress = g_Renderer.m_MissShaderTable->GetGPUVirtualAddress();
-        dispatchDesc.MissShaderTable.SizeInBytes = g_Renderer.m_MissShaderTable.GetSize();
-        dispatchDesc.MissShaderTable.StrideInBytes = dispatchDesc.MissShaderTable.SizeInBytes;
-        dispatchDesc.RayGenerationShaderRecord.StartAddress = g_Renderer.m_RayGenShaderTable->GetGPUVirtualAddress();
-        dispatchDesc.RayGenerationShaderRecord.SizeInBytes = g_Renderer.m_RayGenShaderTable.GetSize();
+        g_Renderer.m_ShaderTableBuffer.GetDispatchRaysDesc(g_Renderer.m_ShaderTable, 0, dispatchDesc);
         dispatchDesc.Width = width;
         dispatchDesc.Height = height;
         dispatchDesc.Depth = 1;
+        // 直接调用 DispatchRays 时需要自己提交之前的屏障
+        cmdList.FlushResourceBarriers();
         cmdList.GetDXRCommandList()->SetPipelineState1(g_Renderer.m_RayTracingStateObject.Get());
         cmdList.GetDXRCommandList()->DispatchRays(&dispatchDesc);
     }
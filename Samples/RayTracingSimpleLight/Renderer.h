@@ -9,12 +9,16 @@
 #include "Graphics/RootSignature.h"
 #include "Graphics/PipelineState.h"
 #include "Graphics/ShaderCompiler.h"
+#include "RayTracing/AccelerationStructureManager.h"
+#include "RayTracing/D3D12AccelerationStructureBackend.h"
+#include "RayTracing/ShaderTableBuffer.h"
 #include "ConstantData.h"
 #include "Core/Camera.h"
 #include "Shaders/RayTracingHLSLCompat.h"
 
 
 namespace DSM {
+    class CommandList;
     class GraphicsCommandList;
     class ComputeCommandList;
     struct Mesh;
@@ -36,6 +40,8 @@ namespace DSM {
         void Shutdown();
 
         void OnResize(uint32_t width, uint32_t height);
+        // 录制本帧的加速结构构建，在光线追踪之前调用
+        void UpdateAccelerationStructure(CommandList& cmdList);
 
     private:
         void CreateResource(uint32_t width, uint32_t height);
@@ -70,13 +76,15 @@ namespace DSM {
         GpuBuffer m_IndexBuffer{};
 
         // 加速结构
-        GpuBuffer m_BottomLevelAS{};
-        GpuBuffer m_TopLevelAS{};
+        D3D12AccelerationStructureBackend m_ASBackend{};
+        AccelerationStructureManager m_ASManager{};
+        std::uint32_t m_CubeBLAS = AccelerationStructureManager::sm_InvalidHandle;
+        std::uint32_t m_CubeInstance = AccelerationStructureManager::sm_InvalidHandle;
 
         // 着色器表
-        GpuBuffer m_RayGenShaderTable{};
-        GpuBuffer m_MissShaderTable{};
-        GpuBuffer m_HitShaderTable{};
+        ShaderRecordLayout m_HitGroupLayout{};
+        ShaderBindingTable m_ShaderTable{};
+        ShaderTableBuffer m_ShaderTableBuffer{};
         
         DescriptorHeap m_TextureHeap;
     };
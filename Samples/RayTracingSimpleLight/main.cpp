@@ -64,8 +64,6 @@ public:
     }
     virtual void Update(float deltaTime) override
     {
-        deltaTime = 1.f / 60;
-
         ImguiManager::GetInstance().Update(deltaTime);
 
         m_CameraController->Update(deltaTime);
@@ -77,6 +75,8 @@ public:
 
         GraphicsCommandList cmdList{ L"Render Scene" };
 
+        g_Renderer.UpdateAccelerationStructure(cmdList);
+
         RayTracer rayTracer{};
         rayTracer.SetCamera(m_Camera.get());
         rayTracer.TraceRays(cmdList.GetComputeCommandList());
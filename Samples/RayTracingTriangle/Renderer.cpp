@@ -250,6 +250,7 @@ namespace DSM {
         bottomLevelASDesc.m_Stride = bottomLevelASDesc.m_Size;
         bottomLevelASDesc.m_HeapType = D3D12_HEAP_TYPE_DEFAULT;
         bottomLevelASDesc.m_Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        bottomLevelASDesc.m_Category = MemoryCategory::kRayTracing;
         m_BottomLevelAS.Create(L"BottomLevelAS", bottomLevelASDesc);
         GpuBufferDesc topLevelASDesc = bottomLevelASDesc;
         topLevelASDesc.m_Size = topLevelASInfo.ResultDataMaxSizeInBytes;
@@ -267,7 +268,7 @@ namespace DSM {
 
         // 分配加速结构生成需要的暂存空间
         uint64_t scratchBufferSize = (std::max)(bottomLevelASInfo.ScratchDataSizeInBytes, topLevelASInfo.ScratchDataSizeInBytes);
-        GpuResourceLocation scratchBuffer = g_RenderContext.GetGpuBufferAllocator().Allocate(scratchBufferSize);
+        GpuResourceLocation scratchBuffer = g_RenderContext.GetGpuBufferAllocator().Allocate(scratchBufferSize, 0, MemoryCategory::kRayTracing);
 
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildBottomLevelASDesc{};
         buildBottomLevelASDesc.Inputs = bottomLevelASInputs;
@@ -65,8 +65,6 @@ public:
     }
     virtual void Update(float deltaTime) override
     {
-        deltaTime = 1.f / 60;
-
         ImguiManager::GetInstance().Update(deltaTime);
         if(g_Renderer.m_RayGenCB.outSideColor != ImguiManager::GetInstance().cubeAlbedo){
             g_Renderer.m_RayGenCB.outSideColor = ImguiManager::GetInstance().cubeAlbedo;
@@ -0,0 +1,583 @@
+#include "TestFramework.h"
+#include "RayTracing/AccelerationStructureManager.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 模拟的后端，记录命令并检查缓冲的生命周期、暂存内存的重叠与构建的顺序
+    class MockBackend : public IAccelerationStructureBackend
+    {
+    public:
+        struct Buffer
+        {
+            std::uint64_t m_Address{};
+            std::uint64_t m_Size{};
+            bool m_Scratch = false;
+            bool m_Live = false;
+            bool m_Built = false;
+            bool m_AllowUpdate = false;
+        };
+
+        ASPrebuildInfo GetBLASPrebuildInfo(std::span<const ASTriangleGeometry> geometries, const ASBuildFlags& flags) override
+        {
+            std::uint64_t numTriangles = 0;
+            for (const auto& geometry : geometries) {
+                numTriangles += (geometry.m_IndexAddress != 0 ? geometry.m_IndexCount : geometry.m_VertexCount) / 3;
+            }
+            // 允许更新的结构更大
+            auto resultSize = 1024 + numTriangles * (flags.m_AllowUpdate ? 96 : 64);
+            return {resultSize, numTriangles * 32, numTriangles * 8};
+        }
+
+        ASPrebuildInfo GetTLASPrebuildInfo(std::uint32_t numInstances) override
+        {
+            return {256 + std::uint64_t(numInstances) * 128, std::uint64_t(numInstances) * 64, std::uint64_t(numInstances) * 16};
+        }
+
+        ASBuffer CreateBuffer(std::uint64_t size, bool scratch) override
+        {
+            auto handle = static_cast<std::uint32_t>(m_Buffers.size());
+            // 地址之间留出空隙，越界访问会落在空隙中
+            m_Buffers.push_back({m_NextAddress, size, scratch, true});
+            m_NextAddress += (size + 0xffff) / 0x10000 * 0x10000 + 0x10000;
+            if (scratch) ++m_NumScratchCreates;
+            return {handle, m_Buffers.back().m_Address, size};
+        }
+
+        void ReleaseBuffer(const ASBuffer& buffer) override
+        {
+            auto& state = Get(buffer, "release");
+            state.m_Live = false;
+        }
+
+        void BuildBLAS(const ASBLASBuild& build) override
+        {
+            auto& dest = Get(build.m_Dest, "BLAS build");
+            if (build.m_Flags.m_PerformUpdate && (!dest.m_Built || !dest.m_AllowUpdate)) Fail("refit of a BLAS without an updatable build");
+            dest.m_Built = true;
+            dest.m_AllowUpdate = build.m_Flags.m_AllowUpdate;
+            auto info = GetBLASPrebuildInfo(build.m_Geometries, build.m_Flags);
+            if (!build.m_Flags.m_PerformUpdate && dest.m_Size < info.m_ResultSize) Fail("BLAS buffer is too small");
+            UseScratch(build.m_ScratchAddress, build.m_Flags.m_PerformUpdate ? info.m_UpdateScratchSize : info.m_ScratchSize);
+
+            if (build.m_CompactionQuery != AccelerationStructureManager::sm_InvalidQuery) {
+                // 压缩后约为原大小的一半
+                m_QuerySizes[build.m_CompactionQuery] = dest.m_Size / 2;
+            }
+            m_BLASSinceBarrier = true;
+            ++m_NumBLASBuilds;
+            m_NumRefits += build.m_Flags.m_PerformUpdate;
+        }
+
+        void CopyCompacted(const ASBuffer& dest, const ASBuffer& src) override
+        {
+            auto& source = Get(src, "compaction source");
+            auto& target = Get(dest, "compaction dest");
+            if (!source.m_Built) Fail("compaction of an unbuilt BLAS");
+            target.m_Built = true;
+            m_BLASSinceBarrier = true;
+        }
+
+        void Barrier() override
+        {
+            m_BLASSinceBarrier = false;
+            m_ScratchRanges.clear();
+            ++m_NumBarriers;
+        }
+
+        void UploadInstances(const GpuSceneTable& instances) override
+        {
+            std::vector<std::byte> upload(instances.GetScatterDataSize());
+            instances.WriteScatterData(upload.data());
+            m_Instances.resize(instances.GetNumRows());
+            auto rows = instances.GetScatterRows();
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                std::memcpy(&m_Instances[rows[i]], upload.data() + i * sizeof(ASInstanceDesc), sizeof(ASInstanceDesc));
+            }
+            m_NumUploadedRows += rows.size();
+        }
+
+        void BuildTLAS(const ASTLASBuild& build) override
+        {
+            auto& dest = Get(build.m_Dest, "TLAS build");
+            if (m_BLASSinceBarrier) Fail("TLAS build without a barrier after BLAS builds");
+            if (build.m_NumInstances > m_Instances.size()) Fail("TLAS reads past the instance buffer");
+            if (dest.m_Size < GetTLASPrebuildInfo(build.m_NumInstances).m_ResultSize) Fail("TLAS buffer is too small");
+            UseScratch(build.m_ScratchAddress, GetTLASPrebuildInfo(build.m_NumInstances).m_ScratchSize);
+
+            // 实例引用的 BLAS 必须是已构建且存活的缓冲
+            for (std::uint32_t i = 0; i < build.m_NumInstances; ++i) {
+                auto address = m_Instances[i].m_AccelerationStructure;
+                if (address == 0) continue;
+                auto it = std::find_if(m_Buffers.begin(), m_Buffers.end(), [address](const Buffer& buffer) {
+                    return buffer.m_Address == address && buffer.m_Live && !buffer.m_Scratch;
+                });
+                if (it == m_Buffers.end() || !it->m_Built) Fail("instance references a dead or unbuilt BLAS");
+            }
+            ++m_NumTLASBuilds;
+        }
+
+        void ResolveCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries) override
+        {
+            for (auto i = firstQuery; i < firstQuery + numQueries; ++i) m_Resolved[i] = m_QuerySizes[i];
+        }
+
+        bool ReadCompactedSizes(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* sizes) override
+        {
+            for (std::uint32_t i = 0; i < numQueries; ++i) {
+                auto it = m_Resolved.find(firstQuery + i);
+                if (it == m_Resolved.end()) {
+                    Fail("reading an unresolved compaction query");
+                    return false;
+                }
+                sizes[i] = it->second;
+            }
+            return true;
+        }
+
+        std::uint32_t GetNumLiveBuffers() const
+        {
+            return static_cast<std::uint32_t>(std::count_if(m_Buffers.begin(), m_Buffers.end(), [](const Buffer& buffer) { return buffer.m_Live; }));
+        }
+
+        bool IsValid() const noexcept { return m_Errors.empty(); }
+        const std::vector<std::string>& GetErrors() const noexcept { return m_Errors; }
+
+        std::vector<ASInstanceDesc> m_Instances{};
+        std::uint32_t m_NumBLASBuilds = 0;
+        std::uint32_t m_NumRefits = 0;
+        std::uint32_t m_NumTLASBuilds = 0;
+        std::uint32_t m_NumBarriers = 0;
+        std::uint32_t m_NumScratchCreates = 0;
+        std::uint64_t m_NumUploadedRows = 0;
+
+    private:
+        Buffer& Get(const ASBuffer& buffer, const char* use)
+        {
+            if (buffer.m_Handle >= m_Buffers.size() || !m_Buffers[buffer.m_Handle].m_Live) {
+                Fail(std::string{use} + " uses a released buffer");
+                static Buffer dummy{};
+                return dummy;
+            }
+            return m_Buffers[buffer.m_Handle];
+        }
+
+        // 同一批构建(两次屏障之间)使用的暂存内存不能重叠
+        void UseScratch(std::uint64_t address, std::uint64_t size)
+        {
+            auto it = std::find_if(m_Buffers.begin(), m_Buffers.end(), [address](const Buffer& buffer) {
+                return buffer.m_Scratch && buffer.m_Live && address >= buffer.m_Address && address < buffer.m_Address + buffer.m_Size;
+            });
+            if (size == 0) return;
+            if (it == m_Buffers.end() || address + size > it->m_Address + it->m_Size) {
+                Fail("scratch range is outside of a live scratch buffer");
+                return;
+            }
+            if (address % 256 != 0) Fail("scratch address is misaligned");
+            for (const auto& [begin, end] : m_ScratchRanges) {
+                if (address < end && begin < address + size) Fail("scratch ranges overlap within a batch");
+            }
+            m_ScratchRanges.emplace_back(address, address + size);
+        }
+
+        void Fail(std::string error)
+        {
+            if (m_Errors.size() < 8) m_Errors.push_back(std::move(error));
+        }
+
+    private:
+        std::vector<Buffer> m_Buffers{};
+        std::uint64_t m_NextAddress = 0x100000;
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> m_ScratchRanges{};
+        std::unordered_map<std::uint32_t, std::uint64_t> m_QuerySizes{};
+        std::unordered_map<std::uint32_t, std::uint64_t> m_Resolved{};
+        bool m_BLASSinceBarrier = false;
+        std::vector<std::string> m_Errors{};
+    };
+
+    bool IsValidBackend(const MockBackend& backend)
+    {
+        for (const auto& error : backend.GetErrors()) std::printf("  %s\n", error.c_str());
+        return backend.IsValid();
+    }
+
+    ASTriangleGeometry MakeGeometry(std::uint32_t numTriangles, std::uint64_t address = 0x1000)
+    {
+        ASTriangleGeometry geometry{};
+        geometry.m_VertexAddress = address;
+        geometry.m_VertexCount = numTriangles * 3;
+        return geometry;
+    }
+
+    ASInstanceDesc MakeInstance(std::uint32_t id, float x = 0)
+    {
+        ASInstanceDesc desc{};
+        desc.m_Transform[0][0] = desc.m_Transform[1][1] = desc.m_Transform[2][2] = 1;
+        desc.m_Transform[0][3] = x;
+        desc.m_InstanceID = id;
+        desc.m_InstanceMask = 0xff;
+        return desc;
+    }
+
+    void RunFrame(AccelerationStructureManager& manager, std::uint32_t& frame)
+    {
+        manager.BeginFrame(frame++);
+        manager.Update();
+    }
+}
+
+TEST_CASE(AccelerationStructureManager_BuildsBLASAndTLAS)
+{
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    manager.Create(&backend);
+
+    auto geometry = MakeGeometry(1000);
+    auto a = manager.CreateBLAS({&geometry, 1});
+    auto b = manager.CreateBLAS({&geometry, 1});
+    CHECK(!manager.IsBLASBuilt(a));
+    CHECK(manager.GetNumPendingBuilds() == 2);
+
+    auto i0 = manager.AddInstance(MakeInstance(0), a);
+    auto i1 = manager.AddInstance(MakeInstance(1), b);
+    auto i2 = manager.AddInstance(MakeInstance(2), a);
+    CHECK(manager.GetTLASAddress() == 0);
+
+    std::uint32_t frame = 0;
+    RunFrame(manager, frame);
+    CHECK(manager.IsBLASBuilt(a));
+    CHECK(manager.IsBLASBuilt(b));
+    CHECK(manager.GetNumPendingBuilds() == 0);
+    CHECK(manager.GetStats().m_NumBuilds == 2);
+    CHECK(manager.GetStats().m_TLASRebuilt);
+    CHECK(manager.GetTLASAddress() != 0);
+    CHECK(backend.m_NumTLASBuilds == 1);
+
+    REQUIRE(backend.m_Instances.size() == 3);
+    CHECK(backend.m_Instances[i0].m_AccelerationStructure == manager.GetBLASAddress(a));
+    CHECK(backend.m_Instances[i1].m_AccelerationStructure == manager.GetBLASAddress(b));
+    CHECK(backend.m_Instances[i2].m_AccelerationStructure == manager.GetBLASAddress(a));
+    CHECK(backend.m_Instances[i1].m_InstanceID == 1);
+
+    // 没有改变时不录制任何命令
+    auto barriers = backend.m_NumBarriers;
+    RunFrame(manager, frame);
+    CHECK(!manager.GetStats().m_TLASRebuilt);
+    CHECK(backend.m_NumBarriers == barriers);
+    CHECK(IsValidBackend(backend));
+
+    manager.Shutdown();
+    CHECK(backend.GetNumLiveBuffers() == 0);
+}
+
+TEST_CASE(AccelerationStructureManager_ScratchBudgetBatchesBuilds)
+{
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    AccelerationStructureManagerDesc desc{};
+    // 每个 BLAS 需要 32000 * 32 字节约 1 MB 的暂存内存
+    desc.m_ScratchBudget = 3ull << 20;
+    manager.Create(&backend, desc);
+
+    auto geometry = MakeGeometry(32000);
+    std::vector<std::uint32_t> blas{};
+    for (int i = 0; i < 8; ++i) {
+        blas.push_back(manager.CreateBLAS({&geometry, 1}));
+        manager.AddInstance(MakeInstance(i), blas.back());
+    }
+
+    std::uint32_t frame = 0;
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumBuilds == 3);
+    CHECK(manager.GetStats().m_NumDeferred == 5);
+    CHECK(manager.GetStats().m_ScratchUsed <= desc.m_ScratchBudget);
+    // 按提交顺序构建
+    CHECK(manager.IsBLASBuilt(blas[2]));
+    CHECK(!manager.IsBLASBuilt(blas[3]));
+    // 尚未构建的 BLAS 的实例不参与求交
+    CHECK(backend.m_Instances[3].m_AccelerationStructure == 0);
+
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumBuilds == 3);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumBuilds == 2);
+    CHECK(manager.GetNumPendingBuilds() == 0);
+    CHECK(backend.m_Instances[7].m_AccelerationStructure == manager.GetBLASAddress(blas[7]));
+
+    // 超出预算的单个构建独占一帧
+    auto huge = MakeGeometry(200000);
+    manager.CreateBLAS({&huge, 1});
+    manager.CreateBLAS({&geometry, 1});
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumBuilds == 1);
+    CHECK(manager.GetStats().m_ScratchUsed > desc.m_ScratchBudget);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumBuilds == 1);
+    CHECK(IsValidBackend(backend));
+}
+
+TEST_CASE(AccelerationStructureManager_CompactsStaticBLAS)
+{
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    AccelerationStructureManagerDesc desc{};
+    desc.m_NumFramesInFlight = 2;
+    manager.Create(&backend, desc);
+
+    auto geometry = MakeGeometry(1000);
+    auto staticBLAS = manager.CreateBLAS({&geometry, 1});
+    auto dynamicBLAS = manager.CreateBLAS({&geometry, 1}, true);
+    auto rebuilt = manager.CreateBLAS({&geometry, 1});
+    auto instance = manager.AddInstance(MakeInstance(0), staticBLAS);
+
+    std::uint32_t frame = 0;
+    RunFrame(manager, frame);
+    auto originalSize = manager.GetBLASSize(staticBLAS);
+    auto originalAddress = manager.GetBLASAddress(staticBLAS);
+    auto memory = manager.GetStats().m_BLASMemory;
+
+    // 查询结果在同一槽位的下一帧读取，之前被重建的 BLAS 不压缩
+    manager.UpdateBLAS(rebuilt);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumCompactions == 0);
+    CHECK(manager.GetStats().m_NumBuilds == 1);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumCompactions == 1);
+    CHECK(manager.GetBLASSize(staticBLAS) == originalSize / 2);
+    CHECK(manager.GetBLASAddress(staticBLAS) != originalAddress);
+    CHECK(manager.GetBLASSize(dynamicBLAS) > manager.GetBLASSize(staticBLAS));
+    CHECK(manager.GetStats().m_CompactionSavings == originalSize - originalSize / 2);
+    CHECK(manager.GetStats().m_BLASMemory == memory - (originalSize - originalSize / 2));
+
+    // 实例改为引用压缩后的缓冲，TLAS 随之重建
+    CHECK(backend.m_Instances[instance].m_AccelerationStructure == manager.GetBLASAddress(staticBLAS));
+    CHECK(manager.GetStats().m_TLASRebuilt);
+
+    // 重建后的 BLAS 在自己的查询读取后压缩
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumCompactions == 1);
+    CHECK(manager.GetBLASSize(rebuilt) == originalSize / 2);
+    CHECK(IsValidBackend(backend));
+
+    manager.Shutdown();
+    CHECK(backend.GetNumLiveBuffers() == 0);
+}
+
+TEST_CASE(AccelerationStructureManager_RefitsDynamicBLAS)
+{
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    AccelerationStructureManagerDesc desc{};
+    desc.m_MaxRefits = 3;
+    manager.Create(&backend, desc);
+
+    auto geometry = MakeGeometry(500);
+    auto dynamicBLAS = manager.CreateBLAS({&geometry, 1}, true);
+    auto staticBLAS = manager.CreateBLAS({&geometry, 1});
+    manager.AddInstance(MakeInstance(0), dynamicBLAS);
+
+    std::uint32_t frame = 0;
+    RunFrame(manager, frame);
+    auto address = manager.GetBLASAddress(dynamicBLAS);
+
+    // 重新拟合不分配新的缓冲
+    for (int i = 0; i < 3; ++i) {
+        manager.UpdateBLAS(dynamicBLAS);
+        RunFrame(manager, frame);
+        CHECK(manager.GetStats().m_NumRefits == 1);
+        CHECK(manager.GetStats().m_NumBuilds == 0);
+        CHECK(manager.GetBLASAddress(dynamicBLAS) == address);
+        CHECK(manager.GetStats().m_TLASRebuilt);
+    }
+    // 达到次数上限后完整重建一次
+    manager.UpdateBLAS(dynamicBLAS);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumRefits == 0);
+    CHECK(manager.GetStats().m_NumBuilds == 1);
+    manager.UpdateBLAS(dynamicBLAS);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumRefits == 1);
+
+    // 静态 BLAS 与改变了几何的 BLAS 总是重建
+    manager.UpdateBLAS(staticBLAS);
+    auto moved = MakeGeometry(600, 0x2000);
+    manager.SetBLASGeometry(dynamicBLAS, {&moved, 1});
+    // 等待重建时重新拟合的请求被合并
+    manager.UpdateBLAS(dynamicBLAS);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumBuilds == 2);
+    CHECK(manager.GetStats().m_NumRefits == 0);
+    CHECK(backend.m_NumRefits == 4);
+    CHECK(IsValidBackend(backend));
+}
+
+TEST_CASE(AccelerationStructureManager_IncrementalInstances)
+{
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    manager.Create(&backend);
+
+    auto geometry = MakeGeometry(100);
+    auto blas = manager.CreateBLAS({&geometry, 1});
+    std::vector<std::uint32_t> instances{};
+    for (int i = 0; i < 100; ++i) instances.push_back(manager.AddInstance(MakeInstance(i, float(i)), blas));
+
+    std::uint32_t frame = 0;
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumUploadedInstances == 100);
+
+    // 只上传改变的行
+    float transform[3][4]{{1, 0, 0, 5}, {0, 1, 0, 6}, {0, 0, 1, 7}};
+    manager.SetInstanceTransform(instances[42], transform);
+    RunFrame(manager, frame);
+    CHECK(manager.GetStats().m_NumUploadedInstances == 1);
+    CHECK(manager.GetStats().m_TLASRebuilt);
+    CHECK(backend.m_Instances[42].m_Transform[1][3] == 6);
+    CHECK(backend.m_Instances[42].m_InstanceID == 42);
+
+    // 删除的实例留下空行，之后被复用
+    manager.RemoveInstance(instances[10]);
+    RunFrame(manager, frame);
+    CHECK(backend.m_Instances[10].m_AccelerationStructure == 0);
+    CHECK(manager.GetStats().m_NumInstances == 99);
+    auto reused = manager.AddInstance(MakeInstance(500), blas);
+    CHECK(reused == instances[10]);
+    RunFrame(manager, frame);
+    CHECK(backend.m_Instances[10].m_InstanceID == 500);
+    CHECK(backend.m_Instances[10].m_AccelerationStructure == manager.GetBLASAddress(blas));
+
+    // 销毁 BLAS 后引用它的实例不参与求交
+    auto other = manager.CreateBLAS({&geometry, 1});
+    manager.SetInstance(instances[0], MakeInstance(0), other);
+    manager.DestroyBLAS(blas);
+    RunFrame(manager, frame);
+    CHECK(backend.m_Instances[0].m_AccelerationStructure == manager.GetBLASAddress(other));
+    CHECK(backend.m_Instances[1].m_AccelerationStructure == 0);
+    CHECK(backend.m_Instances[99].m_AccelerationStructure == 0);
+    CHECK(IsValidBackend(backend));
+
+    for (auto instance : instances) manager.RemoveInstance(instance);
+    RunFrame(manager, frame);
+    CHECK(manager.GetTLASAddress() == 0);
+}
+
+TEST_CASE(AccelerationStructureManager_RandomOperations)
+{
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    AccelerationStructureManagerDesc desc{};
+    desc.m_NumFramesInFlight = 3;
+    desc.m_ScratchBudget = 1ull << 20;
+    desc.m_MaxCompactionsPerFrame = 4;
+    desc.m_MaxRefits = 5;
+    manager.Create(&backend, desc);
+
+    std::mt19937 rng{21};
+    std::vector<ASTriangleGeometry> geometries{};
+    for (int i = 0; i < 8; ++i) geometries.push_back(MakeGeometry(100 + i * 3000, 0x1000 * (i + 1)));
+    std::vector<std::uint32_t> blas{};
+    std::vector<std::uint32_t> instances{};
+
+    std::uint32_t frame = 0;
+    for (int step = 0; step < 300; ++step) {
+        for (int op = 0; op < 6; ++op) {
+            auto choice = rng() % 8;
+            if (choice == 0 || blas.empty()) {
+                blas.push_back(manager.CreateBLAS({&geometries[rng() % geometries.size()], 1}, rng() % 2 == 0));
+            }
+            else if (choice == 1 && blas.size() > 4) {
+                auto index = rng() % blas.size();
+                manager.DestroyBLAS(blas[index]);
+                blas.erase(blas.begin() + index);
+            }
+            else if (choice == 2) {
+                manager.UpdateBLAS(blas[rng() % blas.size()]);
+            }
+            else if (choice == 3) {
+                manager.SetBLASGeometry(blas[rng() % blas.size()], {&geometries[rng() % geometries.size()], 1});
+            }
+            else if (choice == 4 || instances.empty()) {
+                instances.push_back(manager.AddInstance(MakeInstance(step), blas[rng() % blas.size()]));
+            }
+            else if (choice == 5) {
+                auto index = rng() % instances.size();
+                manager.RemoveInstance(instances[index]);
+                instances.erase(instances.begin() + index);
+            }
+            else {
+                float transform[3][4]{{1, 0, 0, float(step)}, {0, 1, 0, 0}, {0, 0, 1, float(op)}};
+                manager.SetInstanceTransform(instances[rng() % instances.size()], transform);
+            }
+        }
+        RunFrame(manager, frame);
+        if (!backend.IsValid()) break;
+    }
+    CHECK(IsValidBackend(backend));
+
+    // 所有构建完成后实例引用当前的 BLAS 地址
+    for (int i = 0; i < 40 && manager.GetNumPendingBuilds() > 0; ++i) RunFrame(manager, frame);
+    CHECK(manager.GetNumPendingBuilds() == 0);
+    const auto& table = manager.GetInstanceTable();
+    for (auto instance : instances) {
+        ASInstanceDesc desc{};
+        std::memcpy(&desc, table.GetRow(instance), sizeof(desc));
+        CHECK(backend.m_Instances[instance].m_AccelerationStructure == desc.m_AccelerationStructure);
+    }
+
+    manager.Shutdown();
+    CHECK(backend.GetNumLiveBuffers() == 0);
+}
+
+BENCHMARK_CASE(AccelerationStructureManager_DynamicScene)
+{
+    constexpr std::uint32_t kNumBLAS = 2000;
+    constexpr std::uint32_t kNumInstances = 100000;
+
+    MockBackend backend{};
+    AccelerationStructureManager manager{};
+    AccelerationStructureManagerDesc desc{};
+    desc.m_ScratchBudget = 64ull << 20;
+    manager.Create(&backend, desc);
+
+    std::mt19937 rng{5};
+    std::vector<ASTriangleGeometry> geometries{};
+    for (std::uint32_t i = 0; i < kNumBLAS; ++i) geometries.push_back(MakeGeometry(500 + rng() % 5000, 0x1000 + i));
+    std::vector<std::uint32_t> blas{};
+    for (std::uint32_t i = 0; i < kNumBLAS; ++i) blas.push_back(manager.CreateBLAS({&geometries[i], 1}, i % 10 == 0));
+    std::vector<std::uint32_t> instances{};
+    for (std::uint32_t i = 0; i < kNumInstances; ++i) instances.push_back(manager.AddInstance(MakeInstance(i), blas[rng() % kNumBLAS]));
+
+    std::uint32_t frame = 0;
+    std::uint32_t framesToBuild = 0;
+    Test::BenchTimer timer{};
+    while (manager.GetNumPendingBuilds() > 0 || framesToBuild == 0) {
+        RunFrame(manager, frame);
+        ++framesToBuild;
+    }
+    Test::ReportMetric("Initial build, frames under 64 MB scratch", framesToBuild, "");
+    Test::ReportMetric("Initial build, CPU time", timer.ElapsedSeconds() * 1e3, "ms");
+    RunFrame(manager, frame);
+    RunFrame(manager, frame);
+    Test::ReportMetric("Memory saved by compaction", 100.0 * manager.GetStats().m_CompactionSavings /
+        (manager.GetStats().m_BLASMemory + manager.GetStats().m_CompactionSavings), "%");
+
+    // 每帧 1% 的实例移动，动态 BLAS 全部重新拟合
+    float transform[3][4]{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+    auto seconds = Test::MeasureSeconds([&]() {
+        transform[0][3] += 1;
+        for (std::uint32_t i = 0; i < kNumInstances / 100; ++i) manager.SetInstanceTransform(instances[rng() % kNumInstances], transform);
+        for (std::uint32_t i = 0; i < kNumBLAS; i += 10) manager.UpdateBLAS(blas[i]);
+        RunFrame(manager, frame);
+    });
+    Test::ReportMetric("Per-frame update, 1% instance churn", seconds * 1e3, "ms");
+    Test::ReportMetric("Uploaded instances per frame", manager.GetStats().m_NumUploadedInstances, "");
+    Test::ReportMetric("Refits per frame", manager.GetStats().m_NumRefits, "");
+    CHECK(IsValidBackend(backend));
+}
@@ -0,0 +1,296 @@
+#include "TestFramework.h"
+#include "Utilities/BCEncoder.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 按照 D3D 规范实现的解码器，用于检查编码结果
+    void Decode565(std::uint16_t color, std::uint8_t* rgb)
+    {
+        rgb[0] = static_cast<std::uint8_t>(((color >> 11) & 31) * 255 / 31);
+        rgb[1] = static_cast<std::uint8_t>(((color >> 5) & 63) * 255 / 63);
+        rgb[2] = static_cast<std::uint8_t>((color & 31) * 255 / 31);
+    }
+
+    void DecodeColorBlock(const std::uint8_t* src, std::uint8_t* block, bool forceFourColors)
+    {
+        std::uint16_t c0 = src[0] | (src[1] << 8);
+        std::uint16_t c1 = src[2] | (src[3] << 8);
+        std::uint8_t palette[4][4]{};
+        Decode565(c0, palette[0]);
+        Decode565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            if (c0 > c1 || forceFourColors) {
+                palette[2][c] = static_cast<std::uint8_t>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                palette[3][c] = static_cast<std::uint8_t>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+            }
+            else {
+                palette[2][c] = static_cast<std::uint8_t>((palette[0][c] + palette[1][c] + 1) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        std::uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | (std::uint32_t(src[7]) << 24);
+        for (int i = 0; i < 16; ++i) {
+            auto index = (indices >> (2 * i)) & 3;
+            std::memcpy(block + i * 4, palette[index], 3);
+            block[i * 4 + 3] = (c0 <= c1 && !forceFourColors && index == 3) ? 0 : 255;
+        }
+    }
+
+    void DecodeAlphaBlock(const std::uint8_t* src, std::uint8_t* block, std::uint32_t channel)
+    {
+        std::uint32_t palette[8]{src[0], src[1]};
+        for (int i = 1; i < 7; ++i) {
+            if (src[0] > src[1]) palette[i + 1] = ((7 - i) * src[0] + i * src[1] + 3) / 7;
+            else if (i < 5) palette[i + 1] = ((5 - i) * src[0] + i * src[1] + 2) / 5;
+        }
+        if (src[0] <= src[1]) {
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        std::uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i) indices |= std::uint64_t(src[2 + i]) << (8 * i);
+        for (int i = 0; i < 16; ++i) {
+            block[i * 4 + channel] = static_cast<std::uint8_t>(palette[(indices >> (3 * i)) & 7]);
+        }
+    }
+
+    // 只支持编码器使用的模式 6，其他模式返回 false
+    bool DecodeBC7Mode6(const std::uint8_t* src, std::uint8_t* block)
+    {
+        std::uint64_t lo{};
+        std::uint64_t hi{};
+        std::memcpy(&lo, src, 8);
+        std::memcpy(&hi, src + 8, 8);
+        std::uint32_t bit = 0;
+        auto read = [&](std::uint32_t count) {
+            std::uint64_t value = 0;
+            for (std::uint32_t i = 0; i < count; ++i, ++bit) {
+                auto b = bit < 64 ? (lo >> bit) & 1 : (hi >> (bit - 64)) & 1;
+                value |= b << i;
+            }
+            return static_cast<std::uint32_t>(value);
+        };
+
+        if (read(7) != 0x40) return false;
+        std::uint32_t endpoints[2][4]{};
+        for (int c = 0; c < 4; ++c) {
+            endpoints[0][c] = read(7);
+            endpoints[1][c] = read(7);
+        }
+        auto p0 = read(1);
+        auto p1 = read(1);
+        for (int c = 0; c < 4; ++c) {
+            endpoints[0][c] = (endpoints[0][c] << 1) | p0;
+            endpoints[1][c] = (endpoints[1][c] << 1) | p1;
+        }
+
+        constexpr std::uint32_t kWeights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+        for (int i = 0; i < 16; ++i) {
+            auto index = read(i == 0 ? 3 : 4);
+            auto weight = kWeights[index];
+            for (int c = 0; c < 4; ++c) {
+                block[i * 4 + c] = static_cast<std::uint8_t>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+        return true;
+    }
+
+    // 解码整张图片，未使用的通道保持为 0
+    bool DecodeImage(const std::uint8_t* src, std::uint32_t width, std::uint32_t height, BCFormat format, std::vector<std::uint8_t>& rgba)
+    {
+        rgba.assign(std::size_t(width) * height * 4, 0);
+        auto blockSize = BCEncoder::GetBlockSize(format);
+        auto blocksX = (width + 3) / 4;
+        auto blocksY = (height + 3) / 4;
+        std::uint8_t block[64]{};
+        for (std::uint32_t by = 0; by < blocksY; ++by) {
+            for (std::uint32_t bx = 0; bx < blocksX; ++bx) {
+                const auto* data = src + (std::size_t(by) * blocksX + bx) * blockSize;
+                std::memset(block, 0, sizeof(block));
+                switch (format) {
+                    case BCFormat::kBC1: DecodeColorBlock(data, block, false); break;
+                    case BCFormat::kBC3: DecodeColorBlock(data + 8, block, true); DecodeAlphaBlock(data, block, 3); break;
+                    case BCFormat::kBC4: DecodeAlphaBlock(data, block, 0); break;
+                    case BCFormat::kBC5: DecodeAlphaBlock(data, block, 0); DecodeAlphaBlock(data + 8, block, 1); break;
+                    case BCFormat::kBC7: if (!DecodeBC7Mode6(data, block)) return false; break;
+                }
+                for (std::uint32_t y = 0; y < 4 && by * 4 + y < height; ++y) {
+                    for (std::uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                        std::memcpy(&rgba[((by * 4 + y) * std::size_t(width) + bx * 4 + x) * 4], block + (y * 4 + x) * 4, 4);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // 带有渐变、边缘与细节的合成图片
+    std::vector<std::uint8_t> MakeTestImage(std::uint32_t width, std::uint32_t height)
+    {
+        std::mt19937 rng{7};
+        std::normal_distribution<float> noise{0.0f, 3.0f};
+        std::vector<std::uint8_t> rgba(std::size_t(width) * height * 4);
+        for (std::uint32_t y = 0; y < height; ++y) {
+            for (std::uint32_t x = 0; x < width; ++x) {
+                float u = float(x) / width;
+                float v = float(y) / height;
+                float base[4] = {
+                    200 * u + 30 * std::sin(v * 20),
+                    180 * v + 40 * std::cos(u * 13),
+                    128 + 100 * std::sin((u + v) * 9),
+                    ((x / 32 + y / 32) % 2 == 0) ? 255.0f : 96 + 120 * u,
+                };
+                for (int c = 0; c < 4; ++c) {
+                    rgba[(std::size_t(y) * width + x) * 4 + c] = static_cast<std::uint8_t>(std::clamp(base[c] + noise(rng), 0.0f, 255.0f));
+                }
+            }
+        }
+        return rgba;
+    }
+
+    double ComputePSNR(const std::vector<std::uint8_t>& a, const std::vector<std::uint8_t>& b, std::uint32_t channelMask)
+    {
+        double error = 0;
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (!(channelMask & (1u << (i % 4)))) continue;
+            double diff = double(a[i]) - b[i];
+            error += diff * diff;
+            ++count;
+        }
+        if (error == 0) return 99.0;
+        return 10.0 * std::log10(255.0 * 255.0 / (error / count));
+    }
+
+    constexpr std::uint32_t kRGB = 0x7;
+    constexpr std::uint32_t kRGBA = 0xf;
+}
+
+TEST_CASE(BCEncoder_SizesAndFormats)
+{
+    CHECK(BCEncoder::GetBlockSize(BCFormat::kBC1) == 8);
+    CHECK(BCEncoder::GetBlockSize(BCFormat::kBC4) == 8);
+    CHECK(BCEncoder::GetBlockSize(BCFormat::kBC3) == 16);
+    CHECK(BCEncoder::GetBlockSize(BCFormat::kBC5) == 16);
+    CHECK(BCEncoder::GetBlockSize(BCFormat::kBC7) == 16);
+    CHECK(BCEncoder::GetCompressedSize(1, 1, BCFormat::kBC1) == 8);
+    CHECK(BCEncoder::GetCompressedSize(5, 9, BCFormat::kBC7) == 2 * 3 * 16);
+    // DXGI_FORMAT_BC1_UNORM_SRGB、BC5_UNORM、BC7_UNORM
+    CHECK(BCEncoder::GetDXGIFormat(BCFormat::kBC1, true) == 72);
+    CHECK(BCEncoder::GetDXGIFormat(BCFormat::kBC5, true) == 83);
+    CHECK(BCEncoder::GetDXGIFormat(BCFormat::kBC7, false) == 98);
+}
+
+TEST_CASE(BCEncoder_ConstantBlocksAreNearExact)
+{
+    std::uint8_t block[64]{};
+    for (int i = 0; i < 16; ++i) {
+        block[i * 4 + 0] = 173;
+        block[i * 4 + 1] = 54;
+        block[i * 4 + 2] = 231;
+        block[i * 4 + 3] = 77;
+    }
+
+    struct Case { BCFormat m_Format; std::uint32_t m_Mask; int m_Tolerance; };
+    for (auto test : {Case{BCFormat::kBC1, kRGB, 4}, Case{BCFormat::kBC3, kRGBA, 4}, Case{BCFormat::kBC4, 0x1, 0},
+        Case{BCFormat::kBC5, 0x3, 0}, Case{BCFormat::kBC7, kRGBA, 1}}) {
+        std::uint8_t encoded[16]{};
+        BCEncoder::CompressImage(block, 4, 4, 0, test.m_Format, encoded, 1);
+        std::vector<std::uint8_t> decoded{};
+        REQUIRE(DecodeImage(encoded, 4, 4, test.m_Format, decoded));
+        int maxError = 0;
+        for (int i = 0; i < 64; ++i) {
+            if (test.m_Mask & (1u << (i % 4))) maxError = (std::max)(maxError, std::abs(decoded[i] - block[i]));
+        }
+        CHECK(maxError <= test.m_Tolerance);
+    }
+}
+
+TEST_CASE(BCEncoder_QualityOnSyntheticImage)
+{
+    constexpr std::uint32_t kWidth = 256;
+    constexpr std::uint32_t kHeight = 192;
+    auto image = MakeTestImage(kWidth, kHeight);
+
+    struct Case { BCFormat m_Format; std::uint32_t m_Mask; double m_MinPSNR; };
+    for (auto test : {Case{BCFormat::kBC1, kRGB, 38.0}, Case{BCFormat::kBC3, kRGBA, 39.0}, Case{BCFormat::kBC4, 0x1, 50.0},
+        Case{BCFormat::kBC5, 0x3, 50.0}, Case{BCFormat::kBC7, kRGBA, 40.0}}) {
+        std::vector<std::uint8_t> encoded(BCEncoder::GetCompressedSize(kWidth, kHeight, test.m_Format));
+        BCEncoder::CompressImage(image.data(), kWidth, kHeight, 0, test.m_Format, encoded.data(), 4);
+        std::vector<std::uint8_t> decoded{};
+        REQUIRE(DecodeImage(encoded.data(), kWidth, kHeight, test.m_Format, decoded));
+        CHECK(ComputePSNR(image, decoded, test.m_Mask) >= test.m_MinPSNR);
+    }
+}
+
+TEST_CASE(BCEncoder_PartialBlocksAndThreads)
+{
+    // 宽高不是 4 的倍数，行之间有填充
+    constexpr std::uint32_t kWidth = 37;
+    constexpr std::uint32_t kHeight = 18;
+    constexpr std::uint64_t kRowPitch = kWidth * 4 + 20;
+    auto image = MakeTestImage(kWidth, kHeight);
+    std::vector<std::uint8_t> padded(kRowPitch * kHeight, 0);
+    for (std::uint32_t y = 0; y < kHeight; ++y) {
+        std::memcpy(padded.data() + y * kRowPitch, image.data() + std::size_t(y) * kWidth * 4, kWidth * 4);
+    }
+
+    // 手动复制边缘像素补齐到整块，结果应与编码器内部的补齐一致
+    constexpr std::uint32_t kAlignedWidth = 40;
+    constexpr std::uint32_t kAlignedHeight = 20;
+    std::vector<std::uint8_t> aligned(std::size_t(kAlignedWidth) * kAlignedHeight * 4);
+    for (std::uint32_t y = 0; y < kAlignedHeight; ++y) {
+        for (std::uint32_t x = 0; x < kAlignedWidth; ++x) {
+            auto sx = (std::min)(x, kWidth - 1);
+            auto sy = (std::min)(y, kHeight - 1);
+            std::memcpy(&aligned[(std::size_t(y) * kAlignedWidth + x) * 4], &image[(std::size_t(sy) * kWidth + sx) * 4], 4);
+        }
+    }
+
+    for (auto format : {BCFormat::kBC1, BCFormat::kBC3, BCFormat::kBC4, BCFormat::kBC5, BCFormat::kBC7}) {
+        auto size = BCEncoder::GetCompressedSize(kWidth, kHeight, format);
+        REQUIRE(size == BCEncoder::GetCompressedSize(kAlignedWidth, kAlignedHeight, format));
+        std::vector<std::uint8_t> single(size);
+        std::vector<std::uint8_t> multi(size);
+        std::vector<std::uint8_t> expected(size);
+        BCEncoder::CompressImage(padded.data(), kWidth, kHeight, kRowPitch, format, single.data(), 1);
+        BCEncoder::CompressImage(padded.data(), kWidth, kHeight, kRowPitch, format, multi.data(), 3);
+        BCEncoder::CompressImage(aligned.data(), kAlignedWidth, kAlignedHeight, 0, format, expected.data(), 1);
+        CHECK(single == multi);
+        CHECK(single == expected);
+    }
+}
+
+BENCHMARK_CASE(BCEncoder_QualityAndSpeed)
+{
+    constexpr std::uint32_t kSize = 1024;
+    auto image = MakeTestImage(kSize, kSize);
+    auto megapixels = double(kSize) * kSize / 1e6;
+    std::vector<std::uint32_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+
+    struct Case { const char* m_Name; BCFormat m_Format; std::uint32_t m_Mask; };
+    for (auto test : {Case{"BC1", BCFormat::kBC1, kRGB}, Case{"BC3", BCFormat::kBC3, kRGBA}, Case{"BC4", BCFormat::kBC4, 0x1},
+        Case{"BC5", BCFormat::kBC5, 0x3}, Case{"BC7", BCFormat::kBC7, kRGBA}}) {
+        std::vector<std::uint8_t> encoded(BCEncoder::GetCompressedSize(kSize, kSize, test.m_Format));
+        for (auto threads : threadCounts) {
+            auto seconds = Test::MeasureSeconds([&]() {
+                BCEncoder::CompressImage(image.data(), kSize, kSize, 0, test.m_Format, encoded.data(), threads);
+            }, 0.5, 50);
+            Test::ReportMetric(std::string{test.m_Name} + " encode, " + std::to_string(threads) + " thread(s)", megapixels / seconds, "MP/s");
+        }
+
+        std::vector<std::uint8_t> decoded{};
+        CHECK(DecodeImage(encoded.data(), kSize, kSize, test.m_Format, decoded));
+        Test::ReportMetric(std::string{test.m_Name} + " PSNR", ComputePSNR(image, decoded, test.m_Mask), "dB");
+    }
+}
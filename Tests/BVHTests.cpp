@@ -0,0 +1,433 @@
+#include "TestFramework.h"
+#include "RayTracing/BVH.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 交错排列的顶点，位置之后还有法线与纹理坐标
+    struct Vertex
+    {
+        BVHFloat3 m_Position{};
+        BVHFloat3 m_Normal{};
+        float m_UV[2]{};
+    };
+
+    struct TestScene
+    {
+        std::vector<Vertex> m_Vertices{};
+        std::vector<std::uint32_t> m_Indices{};
+        std::vector<BVHFloat3> m_Soup{};
+        std::vector<BVHGeometry> m_Geometries{};
+    };
+
+    BVHFloat3 operator-(const BVHFloat3& a, const BVHFloat3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    BVHFloat3 operator+(const BVHFloat3& a, const BVHFloat3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    BVHFloat3 operator*(const BVHFloat3& a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+
+    // 索引网格为地面与一排排的立方体，类似室内场景；另一个几何体是不使用索引的随机三角形
+    void MakeScene(TestScene& scene, std::uint32_t gridSize, std::uint32_t numSoup, std::uint32_t seed)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+        // 索引从 m_BaseVertex 开始，前面的顶点属于其他子网格
+        constexpr std::uint32_t kBaseVertex = 5;
+        scene.m_Vertices.assign(kBaseVertex, Vertex{});
+        scene.m_Indices.clear();
+        auto addQuad = [&](BVHFloat3 origin, BVHFloat3 u, BVHFloat3 v) {
+            auto base = static_cast<std::uint32_t>(scene.m_Vertices.size()) - kBaseVertex;
+            for (auto p : {origin, origin + u, origin + u + v, origin + v}) {
+                scene.m_Vertices.push_back({p});
+            }
+            for (std::uint32_t index : {0u, 1u, 2u, 0u, 2u, 3u}) {
+                scene.m_Indices.push_back(base + index);
+            }
+        };
+
+        auto cell = 2.0f / gridSize;
+        for (std::uint32_t z = 0; z < gridSize; ++z) {
+            for (std::uint32_t x = 0; x < gridSize; ++x) {
+                BVHFloat3 origin{-1 + x * cell, 0, -1 + z * cell};
+                addQuad(origin, {0, 0, cell}, {cell, 0, 0});
+                if ((x + z) % 3 != 0) continue;
+
+                // 立方体的五个面
+                auto size = cell * 0.6f;
+                auto height = cell * (0.5f + 3 * unit(rng));
+                BVHFloat3 base = origin + BVHFloat3{cell * 0.2f, 0, cell * 0.2f};
+                addQuad(base, {size, 0, 0}, {0, height, 0});
+                addQuad(base + BVHFloat3{0, 0, size}, {0, height, 0}, {size, 0, 0});
+                addQuad(base, {0, height, 0}, {0, 0, size});
+                addQuad(base + BVHFloat3{size, 0, 0}, {0, 0, size}, {0, height, 0});
+                addQuad(base + BVHFloat3{0, height, 0}, {size, 0, 0}, {0, 0, size});
+            }
+        }
+
+        scene.m_Soup.clear();
+        for (std::uint32_t i = 0; i < numSoup; ++i) {
+            BVHFloat3 center{unit(rng) * 2 - 1, unit(rng) * 1.5f, unit(rng) * 2 - 1};
+            for (int v = 0; v < 3; ++v) {
+                scene.m_Soup.push_back(center + BVHFloat3{unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f} * 0.2f);
+            }
+        }
+
+        scene.m_Geometries.clear();
+        BVHGeometry indexed{};
+        indexed.m_Positions = &scene.m_Vertices[0].m_Position;
+        indexed.m_PositionStride = sizeof(Vertex);
+        indexed.m_NumVertices = static_cast<std::uint32_t>(scene.m_Vertices.size());
+        indexed.m_Indices = scene.m_Indices.data();
+        indexed.m_NumIndices = static_cast<std::uint32_t>(scene.m_Indices.size());
+        indexed.m_BaseVertex = kBaseVertex;
+        scene.m_Geometries.push_back(indexed);
+
+        BVHGeometry soup{};
+        soup.m_Positions = scene.m_Soup.data();
+        soup.m_NumVertices = static_cast<std::uint32_t>(scene.m_Soup.size());
+        scene.m_Geometries.push_back(soup);
+    }
+
+    // 射线从场景外射向场景内的随机点，或从场景内射向随机方向
+    std::vector<BVHRay> MakeRays(std::uint32_t count, std::uint32_t seed, bool coherent)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        std::vector<BVHRay> rays(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            auto& ray = rays[i];
+            if (coherent) {
+                // 从同一个相机发出的主射线，按 8x8 的块排列
+                auto tile = i / 64;
+                auto x = (tile % 16) * 8 + i % 8;
+                auto y = (tile / 16) * 8 + (i % 64) / 8;
+                ray.m_Origin = {0, 1.2f, 2.5f};
+                ray.m_Direction = {(x / 128.0f - 0.5f) * 1.5f, -0.3f - (y / 128.0f) * 0.6f, -1};
+                continue;
+            }
+
+            BVHFloat3 target{unit(rng) * 2 - 1, unit(rng) * 1.5f, unit(rng) * 2 - 1};
+            if (i % 2 == 0) {
+                auto theta = unit(rng) * 6.2831853f;
+                ray.m_Origin = {3 * std::cos(theta), 0.5f + 2 * unit(rng), 3 * std::sin(theta)};
+                ray.m_Direction = target - ray.m_Origin;
+            }
+            else {
+                ray.m_Origin = target;
+                ray.m_Direction = {unit(rng) * 2 - 1, unit(rng) * 2 - 1, unit(rng) * 2 - 1};
+                // 部分射线沿坐标轴，测试方向分量为 0 的情况
+                if (i % 16 == 1) ray.m_Direction = {0, -1, 0};
+            }
+            if (i % 5 == 0) ray.m_TMin = 0.3f * unit(rng);
+            if (i % 7 == 0) ray.m_TMax = 0.5f + unit(rng);
+            ray.m_CullMode = static_cast<BVHCullMode>(i % 3);
+        }
+        return rays;
+    }
+
+    // 与 BVH 相同的 Möller–Trumbore 求交，逐个测试所有三角形
+    class BruteForce
+    {
+    public:
+        explicit BruteForce(std::span<const BVHGeometry> geometries)
+        {
+            for (std::uint32_t g = 0; g < geometries.size(); ++g) {
+                const auto& geometry = geometries[g];
+                auto position = [&geometry](std::uint32_t index) {
+                    BVHFloat3 p{};
+                    std::memcpy(&p, static_cast<const std::byte*>(geometry.m_Positions) + std::size_t(index) * geometry.m_PositionStride, sizeof(p));
+                    return p;
+                };
+                auto numTriangles = (geometry.m_Indices ? geometry.m_NumIndices : geometry.m_NumVertices) / 3;
+                for (std::uint32_t t = 0; t < numTriangles; ++t) {
+                    Triangle triangle{};
+                    for (std::uint32_t v = 0; v < 3; ++v) {
+                        auto index = geometry.m_Indices ? geometry.m_Indices[t * 3 + v] + geometry.m_BaseVertex : t * 3 + v;
+                        triangle.m_V[v] = position(index);
+                    }
+                    triangle.m_Geometry = g;
+                    triangle.m_Primitive = t;
+                    m_Triangles.push_back(triangle);
+                }
+            }
+        }
+
+        BVHHit Intersect(const BVHRay& ray) const
+        {
+            BVHHit hit{};
+            hit.m_T = ray.m_TMax;
+            for (const auto& triangle : m_Triangles) {
+                float t, u, v;
+                if (IntersectTriangle(ray, triangle, hit.m_T, t, u, v)) {
+                    hit = {t, u, v, triangle.m_Geometry, triangle.m_Primitive};
+                }
+            }
+            return hit;
+        }
+
+        std::size_t GetNumTriangles() const noexcept { return m_Triangles.size(); }
+
+    private:
+        struct Triangle
+        {
+            BVHFloat3 m_V[3]{};
+            std::uint32_t m_Geometry{};
+            std::uint32_t m_Primitive{};
+        };
+
+        static bool IntersectTriangle(const BVHRay& ray, const Triangle& triangle, float tMax, float& t, float& u, float& v)
+        {
+            auto e1 = triangle.m_V[1] - triangle.m_V[0];
+            auto e2 = triangle.m_V[2] - triangle.m_V[0];
+            const auto& d = ray.m_Direction;
+            BVHFloat3 p{d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x};
+            auto det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+            if (det == 0) return false;
+            float faceSign = ray.m_CullMode == BVHCullMode::kBackFacing ? 1.0f : ray.m_CullMode == BVHCullMode::kFrontFacing ? -1.0f : 0.0f;
+            if (det * faceSign < 0) return false;
+
+            auto s = ray.m_Origin - triangle.m_V[0];
+            BVHFloat3 q{s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x};
+            auto invDet = 1 / det;
+            u = (s.x * p.x + s.y * p.y + s.z * p.z) * invDet;
+            v = (d.x * q.x + d.y * q.y + d.z * q.z) * invDet;
+            t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * invDet;
+            return u >= 0 && v >= 0 && u + v <= 1 && t > ray.m_TMin && t < tMax;
+        }
+
+    private:
+        std::vector<Triangle> m_Triangles{};
+    };
+
+    bool SameHit(const BVHHit& a, const BVHHit& b)
+    {
+        if (a.IsHit() != b.IsHit()) return false;
+        if (!a.IsHit()) return true;
+        // 距离相同的交点(如共享的边)可能是另一个三角形
+        if (std::abs(a.m_T - b.m_T) > 1e-5f * (std::max)(1.0f, a.m_T)) return false;
+        return (a.m_Geometry == b.m_Geometry && a.m_Primitive == b.m_Primitive) || a.m_T == b.m_T;
+    }
+
+    struct BuildCase
+    {
+        const char* m_Name;
+        BVHBuildMethod m_Method;
+        std::uint32_t m_Width;
+    };
+
+    constexpr BuildCase kBuildCases[] = {
+        {"SAH4", BVHBuildMethod::kBinnedSAH, 4},
+        {"SAH8", BVHBuildMethod::kBinnedSAH, 8},
+        {"LBVH4", BVHBuildMethod::kLBVH, 4},
+        {"LBVH8", BVHBuildMethod::kLBVH, 8},
+    };
+}
+
+TEST_CASE(BVH_EmptyAndSingleTriangle)
+{
+    BVH bvh{};
+    bvh.Build({});
+    CHECK(bvh.Empty());
+    BVHRay ray{{0, 0, -1}, 0, {0, 0, 1}};
+    BVHHit hit{};
+    CHECK(!bvh.Intersect(ray, hit));
+    CHECK(!bvh.Occluded(ray));
+
+    // 从 -z 看去为顺时针，是正面
+    BVHFloat3 triangle[3] = {{-1, -1, 0}, {0, 1, 0}, {1, -1, 0}};
+    BVHGeometry geometry{};
+    geometry.m_Positions = triangle;
+    geometry.m_NumVertices = 3;
+    bvh.Build({&geometry, 1});
+    CHECK(!bvh.Empty());
+    CHECK(bvh.GetStats().m_NumTriangles == 1);
+    CHECK(bvh.GetBounds().m_Min.x == -1);
+    CHECK(bvh.GetBounds().m_Max.y == 1);
+
+    REQUIRE(bvh.Intersect(ray, hit));
+    CHECK(std::abs(hit.m_T - 1) < 1e-6f);
+    CHECK(hit.m_Geometry == 0);
+    CHECK(hit.m_Primitive == 0);
+    CHECK(std::abs(1 - hit.m_U - hit.m_V - 0.25f) < 1e-6f);
+
+    // 已有更近的交点时不会被覆盖
+    BVHHit closer{};
+    closer.m_T = 0.5f;
+    closer.m_Primitive = 7;
+    CHECK(!bvh.Intersect(ray, closer));
+    CHECK(closer.m_Primitive == 7);
+
+    ray.m_CullMode = BVHCullMode::kFrontFacing;
+    CHECK(!bvh.Occluded(ray));
+    ray.m_CullMode = BVHCullMode::kBackFacing;
+    CHECK(bvh.Occluded(ray));
+    ray.m_TMax = 0.9f;
+    CHECK(!bvh.Occluded(ray));
+}
+
+TEST_CASE(BVH_MatchesBruteForce)
+{
+    TestScene scene{};
+    MakeScene(scene, 24, 600, 3);
+    BruteForce reference{scene.m_Geometries};
+    auto rays = MakeRays(12000, 17, false);
+
+    std::vector<BVHHit> expected(rays.size());
+    std::uint32_t numHits = 0;
+    for (std::size_t i = 0; i < rays.size(); ++i) {
+        expected[i] = reference.Intersect(rays[i]);
+        numHits += expected[i].IsHit();
+    }
+    // 确保既有命中也有未命中的射线
+    CHECK(numHits > rays.size() / 4);
+    CHECK(numHits < rays.size());
+
+    for (const auto& buildCase : kBuildCases) {
+        BVHBuildDesc desc{};
+        desc.m_Method = buildCase.m_Method;
+        desc.m_Width = buildCase.m_Width;
+        BVH bvh{};
+        bvh.Build(scene.m_Geometries, desc);
+        CHECK(bvh.GetStats().m_NumTriangles == reference.GetNumTriangles());
+
+        std::uint32_t numMismatches = 0;
+        for (std::size_t i = 0; i < rays.size(); ++i) {
+            BVHHit hit{};
+            bvh.Intersect(rays[i], hit);
+            if (!SameHit(hit, expected[i]) || bvh.Occluded(rays[i]) != expected[i].IsHit()) {
+                ++numMismatches;
+            }
+        }
+
+        std::vector<BVHHit> packetHits(rays.size());
+        std::vector<bool> packetOccluded(rays.size());
+        bvh.IntersectPacket(rays, packetHits);
+        // std::vector<bool> 不能转换为 span，按包大小逐批测试
+        for (std::size_t i = 0; i < rays.size(); i += BVH::sm_PacketWidth) {
+            bool occluded[BVH::sm_PacketWidth]{};
+            auto count = (std::min<std::size_t>)(BVH::sm_PacketWidth, rays.size() - i);
+            bvh.OccludedPacket({rays.data() + i, count}, {occluded, count});
+            for (std::size_t j = 0; j < count; ++j) packetOccluded[i + j] = occluded[j];
+        }
+        for (std::size_t i = 0; i < rays.size(); ++i) {
+            if (!SameHit(packetHits[i], expected[i]) || packetOccluded[i] != expected[i].IsHit()) {
+                ++numMismatches;
+            }
+        }
+
+        if (numMismatches != 0) std::printf("  %s: %u mismatches\n", buildCase.m_Name, numMismatches);
+        CHECK(numMismatches == 0);
+    }
+}
+
+TEST_CASE(BVH_ParallelBuildMatchesSerial)
+{
+    TestScene scene{};
+    MakeScene(scene, 32, 2000, 8);
+    auto rays = MakeRays(2000, 23, false);
+
+    for (const auto& buildCase : kBuildCases) {
+        BVHBuildDesc desc{};
+        desc.m_Method = buildCase.m_Method;
+        desc.m_Width = buildCase.m_Width;
+        desc.m_NumThreads = 1;
+        BVH serial{};
+        serial.Build(scene.m_Geometries, desc);
+        desc.m_NumThreads = 4;
+        BVH parallel{};
+        parallel.Build(scene.m_Geometries, desc);
+
+        CHECK(serial.GetStats().m_NumTriangles == parallel.GetStats().m_NumTriangles);
+        CHECK(std::abs(serial.GetStats().m_SAHCost - parallel.GetStats().m_SAHCost) <= 1e-3f * serial.GetStats().m_SAHCost);
+        for (const auto& ray : rays) {
+            BVHHit a{};
+            BVHHit b{};
+            serial.Intersect(ray, a);
+            parallel.Intersect(ray, b);
+            if (!SameHit(a, b)) {
+                std::printf("  %s differs between serial and parallel builds\n", buildCase.m_Name);
+                CHECK(false);
+                break;
+            }
+        }
+    }
+}
+
+TEST_CASE(BVH_TreeShape)
+{
+    TestScene scene{};
+    MakeScene(scene, 32, 2000, 5);
+
+    float sahCost[2]{};
+    for (const auto& buildCase : kBuildCases) {
+        BVHBuildDesc desc{};
+        desc.m_Method = buildCase.m_Method;
+        desc.m_Width = buildCase.m_Width;
+        BVH bvh{};
+        bvh.Build(scene.m_Geometries, desc);
+        const auto& stats = bvh.GetStats();
+        CHECK(stats.m_NumLeaves > 0);
+        CHECK(stats.m_NumNodes < stats.m_NumTriangles);
+        CHECK(stats.m_MaxDepth < 32);
+        if (buildCase.m_Width == 4) {
+            sahCost[buildCase.m_Method == BVHBuildMethod::kLBVH] = stats.m_SAHCost;
+        }
+    }
+    // SAH 构建的树遍历代价不高于 LBVH
+    CHECK(sahCost[0] <= sahCost[1]);
+}
+
+BENCHMARK_CASE(BVH_BuildAndTrace)
+{
+    TestScene scene{};
+    MakeScene(scene, 200, 20000, 1);
+    auto incoherent = MakeRays(1 << 16, 2, false);
+    auto coherent = MakeRays(1 << 14, 3, true);
+    std::vector<BVHHit> hits(incoherent.size());
+    std::uint32_t hardwareThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+    for (const auto& buildCase : kBuildCases) {
+        BVHBuildDesc desc{};
+        desc.m_Method = buildCase.m_Method;
+        desc.m_Width = buildCase.m_Width;
+        desc.m_NumThreads = hardwareThreads;
+        BVH bvh{};
+        auto buildSeconds = Test::MeasureSeconds([&]() { bvh.Build(scene.m_Geometries, desc); }, 0.5, 20);
+        auto numTriangles = bvh.GetStats().m_NumTriangles;
+        std::string name = buildCase.m_Name;
+        Test::ReportMetric(name + " build, " + std::to_string(numTriangles) + " triangles", buildSeconds * 1e3, "ms");
+        Test::ReportMetric(name + " SAH cost", bvh.GetStats().m_SAHCost, "");
+
+        auto closest = Test::MeasureSeconds([&]() {
+            for (std::size_t i = 0; i < incoherent.size(); ++i) {
+                hits[i] = {};
+                bvh.Intersect(incoherent[i], hits[i]);
+            }
+        });
+        auto anyHit = Test::MeasureSeconds([&]() {
+            for (const auto& ray : incoherent) bvh.Occluded(ray);
+        });
+        auto packet = Test::MeasureSeconds([&]() {
+            // 与单条射线相同，只接受比 hits 中更近的交点
+            std::fill(hits.begin(), hits.begin() + coherent.size(), BVHHit{});
+            bvh.IntersectPacket(coherent, {hits.data(), coherent.size()});
+        });
+        auto single = Test::MeasureSeconds([&]() {
+            for (std::size_t i = 0; i < coherent.size(); ++i) {
+                hits[i] = {};
+                bvh.Intersect(coherent[i], hits[i]);
+            }
+        });
+        Test::ReportMetric(name + " closest hit, incoherent", incoherent.size() / closest / 1e6, "Mrays/s");
+        Test::ReportMetric(name + " any hit, incoherent", incoherent.size() / anyHit / 1e6, "Mrays/s");
+        Test::ReportMetric(name + " closest hit, primary", coherent.size() / single / 1e6, "Mrays/s");
+        Test::ReportMetric(name + " closest hit, primary packets", coherent.size() / packet / 1e6, "Mrays/s");
+    }
+}
@@ -0,0 +1,494 @@
+#include "TestFramework.h"
+#include "Renderer/CascadedShadowMap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 operator+(const Float3& a, const Float3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    Float3 operator-(const Float3& a, const Float3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Float3 operator*(const Float3& a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+    Float3 Cross(const Float3& a, const Float3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Float3 Normalize(const Float3& v) { return v * (1 / std::sqrt(Dot(v, v))); }
+
+    // 左手系的相机，与 XMMatrixLookAtLH 相同
+    struct TestCamera
+    {
+        Float3 m_Eye{};
+        Float3 m_Right{}, m_Up{}, m_Forward{};
+        ShadowCameraDesc m_Desc{};
+
+        TestCamera(Float3 eye, Float3 target, float fovY = 1.0f, float aspect = 16.0f / 9)
+        {
+            m_Eye = eye;
+            m_Forward = Normalize(target - eye);
+            m_Right = Normalize(Cross({0, 1, 0}, m_Forward));
+            m_Up = Cross(m_Forward, m_Right);
+            float view[16] = {
+                m_Right.x, m_Up.x, m_Forward.x, 0,
+                m_Right.y, m_Up.y, m_Forward.y, 0,
+                m_Right.z, m_Up.z, m_Forward.z, 0,
+                -Dot(m_Right, eye), -Dot(m_Up, eye), -Dot(m_Forward, eye), 1};
+            std::copy_n(view, 16, m_Desc.m_View);
+            m_Desc.m_FovY = fovY;
+            m_Desc.m_Aspect = aspect;
+            m_Desc.m_NearZ = 0.1f;
+            m_Desc.m_FarZ = 500.0f;
+        }
+
+        // 归一化的屏幕坐标 [-1, 1] 与观察空间深度对应的世界空间位置
+        Float3 Unproject(float ndcX, float ndcY, float viewZ) const
+        {
+            float tanY = std::tan(m_Desc.m_FovY * 0.5f);
+            return m_Eye + m_Right * (ndcX * tanY * m_Desc.m_Aspect * viewZ) + m_Up * (ndcY * tanY * viewZ) + m_Forward * viewZ;
+        }
+
+        // 包围盒的 8 个角点都在视锥的同一个平面之外时不可见
+        bool Intersects(const ShadowCasterBounds& box, float farZ) const
+        {
+            float tanY = std::tan(m_Desc.m_FovY * 0.5f), tanX = tanY * m_Desc.m_Aspect;
+            int outside[6]{};
+            for (int corner = 0; corner < 8; ++corner) {
+                Float3 p{box.m_Min[0], box.m_Min[1], box.m_Min[2]};
+                if (corner & 1) p.x = box.m_Max[0];
+                if (corner & 2) p.y = box.m_Max[1];
+                if (corner & 4) p.z = box.m_Max[2];
+                auto v = p - m_Eye;
+                float x = Dot(v, m_Right), y = Dot(v, m_Up), z = Dot(v, m_Forward);
+                outside[0] += z < m_Desc.m_NearZ;
+                outside[1] += z > farZ;
+                outside[2] += x > tanX * z;
+                outside[3] += x < -tanX * z;
+                outside[4] += y > tanY * z;
+                outside[5] += y < -tanY * z;
+            }
+            return std::none_of(std::begin(outside), std::end(outside), [](int count) { return count == 8; });
+        }
+    };
+
+    // 行向量乘以矩阵，返回齐次坐标的 xyz，正交投影的 w 为 1
+    Float3 Transform(const float m[16], const Float3& p)
+    {
+        return {p.x * m[0] + p.y * m[4] + p.z * m[8] + m[12],
+            p.x * m[1] + p.y * m[5] + p.z * m[9] + m[13],
+            p.x * m[2] + p.y * m[6] + p.z * m[10] + m[14]};
+    }
+
+    // 从 p 射向光源的射线是否穿过包围盒
+    bool IsShadowedBy(const Float3& p, const Float3& lightDir, const ShadowCasterBounds& box)
+    {
+        float origin[3] = {p.x, p.y, p.z};
+        float direction[3] = {-lightDir.x, -lightDir.y, -lightDir.z};
+        float tMin = 0, tMax = std::numeric_limits<float>::max();
+        for (int k = 0; k < 3; ++k) {
+            if (std::abs(direction[k]) < 1e-8f) {
+                if (origin[k] < box.m_Min[k] || origin[k] > box.m_Max[k]) return false;
+                continue;
+            }
+            float t0 = (box.m_Min[k] - origin[k]) / direction[k];
+            float t1 = (box.m_Max[k] - origin[k]) / direction[k];
+            tMin = (std::max)(tMin, (std::min)(t0, t1));
+            tMax = (std::min)(tMax, (std::max)(t0, t1));
+        }
+        return tMin <= tMax;
+    }
+
+    ShadowCasterBounds MakeBox(Float3 min, Float3 max)
+    {
+        return {{min.x, min.y, min.z}, {max.x, max.y, max.z}};
+    }
+
+    // 地面上的建筑群，边长 size 的正方形区域中每行 count 个
+    std::vector<ShadowCasterBounds> MakeCity(std::uint32_t count, float size, float maxHeight, std::uint32_t seed)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        std::vector<ShadowCasterBounds> casters;
+        casters.reserve(count * count);
+        float cell = size / count;
+        for (std::uint32_t z = 0; z < count; ++z) {
+            for (std::uint32_t x = 0; x < count; ++x) {
+                float minX = -size * 0.5f + x * cell, minZ = -size * 0.5f + z * cell;
+                float width = cell * (0.3f + unit(rng) * 0.6f);
+                float height = 1 + unit(rng) * unit(rng) * maxHeight;
+                casters.push_back(MakeBox({minX, 0, minZ}, {minX + width, height, minZ + width}));
+            }
+        }
+        return casters;
+    }
+
+    // 纹素坐标的小数部分在两次之间的变化，按圆周距离计算
+    float GetPhaseDrift(float a, float b)
+    {
+        float d = std::abs((a - std::floor(a)) - (b - std::floor(b)));
+        return (std::min)(d, 1 - d);
+    }
+
+    bool Contains(std::span<const std::uint32_t> indices, std::uint32_t index)
+    {
+        return std::binary_search(indices.begin(), indices.end(), index);
+    }
+
+    // 在每个切片中随机取点，挡住该点的投射体都必须被绘制，且深度在级联的范围内
+    std::uint32_t CountMissedCasters(const CascadedShadowMap& shadow, const TestCamera& camera, const Float3& lightDir,
+        const std::vector<ShadowCasterBounds>& casters, std::uint32_t numSamples, std::uint32_t seed, std::uint32_t& numPairs)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        std::uint32_t numMissed = 0;
+        for (std::uint32_t i = 0; i < shadow.GetNumCascades(); ++i) {
+            const auto& cascade = shadow.GetCascade(i);
+            auto indices = shadow.GetCasterIndices(i);
+            float maxDistance = 0;
+            for (std::uint32_t s = 0; s < numSamples; ++s) {
+                // 前 8 个采样为切片的角点，包围球必须包含它们
+                float viewZ = cascade.m_SplitNear + (cascade.m_SplitFar - cascade.m_SplitNear) * unit(rng);
+                float ndcX = unit(rng) * 2 - 1, ndcY = unit(rng) * 2 - 1;
+                if (s < 8) {
+                    viewZ = s & 4 ? cascade.m_SplitFar : cascade.m_SplitNear;
+                    ndcX = s & 1 ? 1.0f : -1.0f;
+                    ndcY = s & 2 ? 1.0f : -1.0f;
+                }
+                auto p = camera.Unproject(ndcX, ndcY, viewZ);
+                auto receiver = Transform(cascade.m_ViewProj, p);
+                if (std::abs(receiver.x) > 1 || std::abs(receiver.y) > 1 || receiver.z < -1e-4f || receiver.z > 1 + 1e-4f) {
+                    std::printf("  cascade %u maps a receiver to (%f, %f, %f)\n", i, receiver.x, receiver.y, receiver.z);
+                    ++numMissed;
+                }
+                if (s < 8) {
+                    float dx = receiver.x * cascade.m_Radius, dy = receiver.y * cascade.m_Radius;
+                    float dz = Dot(p, lightDir) - cascade.m_Center[2];
+                    maxDistance = (std::max)(maxDistance, std::sqrt(dx * dx + dy * dy + dz * dz));
+                }
+
+                for (std::uint32_t c = 0; c < casters.size(); ++c) {
+                    if (!IsShadowedBy(p, lightDir, casters[c])) continue;
+                    ++numPairs;
+                    // 反向深度，投射体的每个角点都不能比近平面更靠近光源
+                    float maxDepth = std::numeric_limits<float>::lowest();
+                    for (int corner = 0; corner < 8; ++corner) {
+                        Float3 q{corner & 1 ? casters[c].m_Max[0] : casters[c].m_Min[0],
+                            corner & 2 ? casters[c].m_Max[1] : casters[c].m_Min[1],
+                            corner & 4 ? casters[c].m_Max[2] : casters[c].m_Min[2]};
+                        maxDepth = (std::max)(maxDepth, Transform(cascade.m_ViewProj, q).z);
+                    }
+                    if (!Contains(indices, c) || maxDepth > 1 + 1e-4f) {
+                        if (numMissed < 8) {
+                            std::printf("  cascade %u misses caster %u (depth %f) over (%f, %f, %f)\n", i, c, maxDepth, p.x, p.y, p.z);
+                        }
+                        ++numMissed;
+                    }
+                }
+            }
+            // 对齐纹素只让球心移动不到一个纹素，包围球紧贴最远的角点
+            if (std::abs(maxDistance - cascade.m_Radius) > cascade.m_TexelSize + cascade.m_Radius * 1e-4f) {
+                std::printf("  cascade %u has radius %f but its farthest corner is at %f\n", i, cascade.m_Radius, maxDistance);
+                ++numMissed;
+            }
+        }
+        return numMissed;
+    }
+}
+
+TEST_CASE(CascadedShadowMap_SplitsBlendLogAndUniform)
+{
+    TestCamera camera{{0, 2, 0}, {0, 2, 1}};
+    const float lightDir[3] = {0.4f, -1, 0.3f};
+
+    for (float lambda : {0.0f, 0.5f, 0.8f, 1.0f}) {
+        CascadedShadowDesc desc{};
+        desc.m_SplitLambda = lambda;
+        desc.m_MaxDistance = 100;
+        CascadedShadowMap shadow{desc};
+        shadow.Update(camera.m_Desc, lightDir);
+        REQUIRE(shadow.GetNumCascades() == 4);
+
+        float nearZ = 0.1f, farZ = 100;
+        for (std::uint32_t i = 0; i < 4; ++i) {
+            const auto& cascade = shadow.GetCascade(i);
+            float t = (i + 1) / 4.0f;
+            float expected = lambda * nearZ * std::pow(farZ / nearZ, t) + (1 - lambda) * (nearZ + (farZ - nearZ) * t);
+            CHECK(std::abs(cascade.m_SplitFar - expected) <= expected * 1e-4f);
+            CHECK(cascade.m_SplitNear == (i == 0 ? nearZ : shadow.GetCascade(i - 1).m_SplitFar));
+            CHECK(cascade.m_SplitFar > cascade.m_SplitNear);
+            CHECK(shadow.GetConstants().m_Splits[i] == cascade.m_SplitFar);
+            // 远处的级联覆盖更大的范围
+            CHECK(i == 0 || cascade.m_Radius > shadow.GetCascade(i - 1).m_Radius);
+            CHECK(std::abs(cascade.m_TexelSize * 2048 - 2 * cascade.m_Radius) <= cascade.m_Radius * 1e-5f);
+        }
+    }
+
+    // 级联数限制在 [1, 4]，相机的远平面更近时以远平面为准
+    CascadedShadowDesc desc{};
+    desc.m_NumCascades = 0;
+    CascadedShadowMap single{desc};
+    camera.m_Desc.m_FarZ = 40;
+    single.Update(camera.m_Desc, lightDir);
+    CHECK(single.GetNumCascades() == 1);
+    CHECK(single.GetCascade(0).m_SplitFar == 40);
+    const auto& constants = single.GetConstants();
+    CHECK(constants.m_NumCascades == 1);
+    for (std::uint32_t i = 1; i < 4; ++i) {
+        CHECK(constants.m_Splits[i] == 40);
+        CHECK(constants.m_Scales[i][0] == 1 && constants.m_Scales[i][1] == 1 && constants.m_Scales[i][2] == 1);
+    }
+    desc.m_NumCascades = 9;
+    CHECK(CascadedShadowMap{desc}.GetNumCascades() == 4);
+}
+
+TEST_CASE(CascadedShadowMap_ConstantsMatchCascadeTransforms)
+{
+    TestCamera camera{{5, 3, -2}, {20, 0, 40}};
+    const Float3 lightDir = Normalize({-0.3f, -1, 0.5f});
+    const float light[3] = {lightDir.x, lightDir.y, lightDir.z};
+    CascadedShadowMap shadow{};
+    shadow.Update(camera.m_Desc, light);
+    auto casters = MakeCity(40, 300, 30, 1);
+    shadow.CullCasters(casters);
+
+    const auto& constants = shadow.GetConstants();
+    CHECK(std::abs(constants.m_LightDir[0] - lightDir.x) < 1e-5f);
+    CHECK(std::abs(constants.m_LightDir[1] - lightDir.y) < 1e-5f);
+    CHECK(std::abs(constants.m_LightDir[2] - lightDir.z) < 1e-5f);
+    CHECK(constants.m_NumCascades == 4);
+
+    // 着色器由级联 0 的坐标换算其他级联，结果必须与各自的变换相同
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    std::uint32_t numMismatches = 0;
+    for (std::uint32_t s = 0; s < 1000; ++s) {
+        auto p = camera.Unproject(unit(rng) * 2 - 1, unit(rng) * 2 - 1, 0.1f + unit(rng) * 150);
+        auto coord0 = Transform(shadow.GetCascade(0).m_ShadowTransform, p);
+        for (std::uint32_t i = 0; i < 4; ++i) {
+            auto expected = Transform(shadow.GetCascade(i).m_ShadowTransform, p);
+            float coord[3] = {coord0.x, coord0.y, coord0.z};
+            float reference[3] = {expected.x, expected.y, expected.z};
+            for (int k = 0; k < 3; ++k) {
+                float value = (coord[k] + constants.m_Offsets[i][k]) * constants.m_Scales[i][k];
+                numMismatches += std::abs(value - reference[k]) > 1e-3f * (std::max)(1.0f, std::abs(reference[k]));
+            }
+        }
+
+        // 纹理坐标与裁剪空间一致，v 向下
+        const auto& cascade = shadow.GetCascade(3);
+        auto clip = Transform(cascade.m_ViewProj, p);
+        auto uv = Transform(cascade.m_ShadowTransform, p);
+        numMismatches += std::abs(uv.x - (clip.x * 0.5f + 0.5f)) > 1e-5f;
+        numMismatches += std::abs(uv.y - (0.5f - clip.y * 0.5f)) > 1e-5f;
+        numMismatches += uv.z != clip.z;
+    }
+    CHECK(numMismatches == 0);
+
+    // 深度排序的键为投射体在光源空间最靠近光源的深度
+    auto depths = shadow.GetCasterDepths();
+    REQUIRE(depths.size() == casters.size());
+    for (std::uint32_t c = 0; c < casters.size(); c += 97) {
+        float minDepth = std::numeric_limits<float>::max();
+        for (int corner = 0; corner < 8; ++corner) {
+            Float3 q{corner & 1 ? casters[c].m_Max[0] : casters[c].m_Min[0],
+                corner & 2 ? casters[c].m_Max[1] : casters[c].m_Min[1],
+                corner & 4 ? casters[c].m_Max[2] : casters[c].m_Min[2]};
+            minDepth = (std::min)(minDepth, Dot(q, lightDir));
+        }
+        CHECK(std::abs(depths[c] - minDepth) < 1e-3f);
+    }
+}
+
+TEST_CASE(CascadedShadowMap_StableUnderCameraMotion)
+{
+    const float lightDir[3] = {0.4f, -1, 0.3f};
+    CascadedShadowMap shadow{};
+    TestCamera start{{0, 2, 0}, {0, 2, 1}};
+    shadow.Update(start.m_Desc, lightDir);
+
+    float texelSizes[4]{};
+    float phases[4][2]{};
+    // 远离原点的固定点，放大浮点的误差
+    const Float3 probe{123.4f, 5.6f, 78.9f};
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        texelSizes[i] = shadow.GetCascade(i).m_TexelSize;
+        auto uv = Transform(shadow.GetCascade(i).m_ShadowTransform, probe);
+        phases[i][0] = uv.x * 2048;
+        phases[i][1] = uv.y * 2048;
+    }
+
+    // 相机平移与旋转时纹素的大小不变，固定点在阴影贴图中只整数纹素地移动
+    float maxDrift = 0;
+    std::uint32_t numSizeChanges = 0, numMoves = 0;
+    for (std::uint32_t frame = 1; frame <= 240; ++frame) {
+        float angle = frame * 0.037f;
+        Float3 eye{frame * 0.173f, 2 + std::sin(frame * 0.05f), frame * 0.291f};
+        TestCamera camera{eye, eye + Float3{std::sin(angle), -0.2f * std::cos(angle * 0.7f), std::cos(angle)}};
+        shadow.Update(camera.m_Desc, lightDir);
+        for (std::uint32_t i = 0; i < 4; ++i) {
+            const auto& cascade = shadow.GetCascade(i);
+            numSizeChanges += cascade.m_TexelSize != texelSizes[i];
+            auto uv = Transform(cascade.m_ShadowTransform, probe);
+            maxDrift = (std::max)(maxDrift, GetPhaseDrift(uv.x * 2048, phases[i][0]));
+            maxDrift = (std::max)(maxDrift, GetPhaseDrift(uv.y * 2048, phases[i][1]));
+            numMoves += std::abs(uv.x * 2048 - phases[i][0]) > 0.5f;
+        }
+    }
+    CHECK(numSizeChanges == 0);
+    CHECK(maxDrift < 0.01f);
+    // 级联确实跟随相机移动
+    CHECK(numMoves > 0);
+}
+
+TEST_CASE(CascadedShadowMap_CullsCastersThatCannotShadowTheSlices)
+{
+    TestCamera camera{{0, 2, 0}, {0, 2, 1}};
+    const Float3 lightDir = Normalize({0.4f, -1, 0.3f});
+    const float light[3] = {lightDir.x, lightDir.y, lightDir.z};
+    CascadedShadowMap shadow{};
+    shadow.Update(camera.m_Desc, light);
+
+    std::vector<ShadowCasterBounds> casters{
+        // 视锥中的箱子
+        MakeBox({-1, 0, 9}, {1, 2, 11}),
+        // 视锥侧面很远的地方
+        MakeBox({500, 0, 10}, {510, 10, 20}),
+        // 深埋在所有切片之后
+        MakeBox({-5, -400, 40}, {5, -390, 50}),
+        // 相机之后的高塔，影子落在视锥中
+        MakeBox({-40, 0, -15}, {-30, 80, -5}),
+    };
+    REQUIRE(!camera.Intersects(casters[3], 150));
+    // 塔顶中心投在地面上的点在视锥中，深度约为 14
+    const Float3 shadowed{-3, 0, 14};
+    REQUIRE(IsShadowedBy(shadowed, lightDir, casters[3]));
+
+    float nearZBefore[4]{};
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        nearZBefore[i] = shadow.GetCascade(i).m_NearZ;
+    }
+    shadow.CullCasters(casters);
+
+    bool drawsBox = false, drawsTower = false;
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        auto indices = shadow.GetCasterIndices(i);
+        CHECK(std::is_sorted(indices.begin(), indices.end()));
+        CHECK(!Contains(indices, 1));
+        CHECK(!Contains(indices, 2));
+        drawsBox |= Contains(indices, 0);
+        drawsTower |= Contains(indices, 3);
+
+        const auto& cascade = shadow.GetCascade(i);
+        CHECK(cascade.m_NearZ <= nearZBefore[i]);
+        if (Contains(indices, 3)) {
+            // 近平面延伸到塔顶
+            CHECK(Transform(cascade.m_ViewProj, {-40, 80, -15}).z <= 1 + 1e-4f);
+            CHECK(cascade.m_NearZ < nearZBefore[i]);
+        }
+        if (cascade.m_SplitNear <= 14 && 14 < cascade.m_SplitFar) {
+            CHECK(Contains(indices, 3));
+        }
+    }
+    CHECK(drawsBox);
+    CHECK(drawsTower);
+
+    // 没有投射体时每个级联都为空
+    shadow.CullCasters({});
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        CHECK(shadow.GetCasterIndices(i).empty());
+        CHECK(shadow.GetCascade(i).m_NearZ == nearZBefore[i]);
+    }
+    CHECK(shadow.GetCasterDepths().empty());
+}
+
+TEST_CASE(CascadedShadowMap_RandomScenesKeepEveryOccluder)
+{
+    for (std::uint32_t seed = 0; seed < 4; ++seed) {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        Float3 eye{unit(rng) * 40 - 20, 1 + unit(rng) * 20, unit(rng) * 40 - 20};
+        TestCamera camera{eye, eye + Float3{unit(rng) * 2 - 1, -unit(rng) * 0.5f, unit(rng) * 2 - 1}, 0.6f + unit(rng)};
+        // 包含接近竖直的光线，光源空间改用 x 轴作为上方向
+        Float3 lightDir = seed == 3 ? Normalize({0.01f, -1, 0.02f}) : Normalize({unit(rng) * 2 - 1, -0.2f - unit(rng), unit(rng) * 2 - 1});
+        const float light[3] = {lightDir.x, lightDir.y, lightDir.z};
+
+        CascadedShadowDesc desc{};
+        desc.m_NumCascades = 2 + seed % 3;
+        desc.m_MaxDistance = 80;
+        desc.m_SplitLambda = unit(rng);
+        CascadedShadowMap shadow{desc};
+        shadow.Update(camera.m_Desc, light);
+
+        // 地面上的建筑与漂浮的箱子
+        auto casters = MakeCity(30, 240, 40, seed);
+        for (std::uint32_t i = 0; i < 200; ++i) {
+            Float3 min{unit(rng) * 240 - 120, unit(rng) * 60, unit(rng) * 240 - 120};
+            casters.push_back(MakeBox(min, min + Float3{1 + unit(rng) * 6, 1 + unit(rng) * 6, 1 + unit(rng) * 6}));
+        }
+        shadow.CullCasters(casters);
+
+        std::uint32_t numPairs = 0;
+        CHECK(CountMissedCasters(shadow, camera, lightDir, casters, 400, seed + 100, numPairs) == 0);
+        CHECK(numPairs > 100);
+
+        // 剔除确实减少了绘制
+        std::size_t numDraws = 0;
+        for (std::uint32_t i = 0; i < shadow.GetNumCascades(); ++i) {
+            numDraws += shadow.GetCasterIndices(i).size();
+        }
+        CHECK(numDraws < casters.size() * shadow.GetNumCascades() / 2);
+    }
+}
+
+BENCHMARK_CASE(CascadedShadowMap_CityFlythrough)
+{
+    // 每行 126 个，约 16000 个建筑分布在 1 公里的范围内
+    auto casters = MakeCity(126, 1000, 40, 3);
+    const Float3 lightDir = Normalize({0.4f, -1, 0.3f});
+    const float light[3] = {lightDir.x, lightDir.y, lightDir.z};
+    CascadedShadowMap shadow{};
+
+    constexpr std::uint32_t kNumFrames = 64;
+    std::vector<TestCamera> cameras;
+    for (std::uint32_t frame = 0; frame < kNumFrames; ++frame) {
+        float angle = frame * 0.1f;
+        Float3 eye{std::sin(angle) * 200, 3, std::cos(angle) * 200};
+        cameras.emplace_back(eye, eye + Float3{std::cos(angle), -0.05f, -std::sin(angle)});
+    }
+
+    std::uint32_t frame = 0;
+    auto updateSeconds = Test::MeasureSeconds([&]() { shadow.Update(cameras[frame++ % kNumFrames].m_Desc, light); });
+    frame = 0;
+    auto cullSeconds = Test::MeasureSeconds([&]() {
+        shadow.Update(cameras[frame++ % kNumFrames].m_Desc, light);
+        shadow.CullCasters(casters);
+    });
+
+    // 每帧的绘制次数，与只做视锥剔除以及不剔除相比
+    double numDraws = 0, numFrustumDraws = 0;
+    for (const auto& camera : cameras) {
+        shadow.Update(camera.m_Desc, light);
+        shadow.CullCasters(casters);
+        for (std::uint32_t i = 0; i < shadow.GetNumCascades(); ++i) {
+            numDraws += shadow.GetCasterIndices(i).size();
+        }
+        auto numVisible = std::count_if(casters.begin(), casters.end(),
+            [&](const ShadowCasterBounds& caster) { return camera.Intersects(caster, shadow.GetCascade(3).m_SplitFar); });
+        numFrustumDraws += double(numVisible) * shadow.GetNumCascades();
+    }
+
+    std::printf("  %zu casters, %u cascades, %u frames\n", casters.size(), shadow.GetNumCascades(), kNumFrames);
+    Test::ReportMetric("Update", updateSeconds * 1e6, "us");
+    Test::ReportMetric("Update and cull", cullSeconds * 1e3, "ms");
+    Test::ReportMetric("Throughput", casters.size() / cullSeconds * 1e-6, "Mcasters/s");
+    Test::ReportMetric("Draws per frame", numDraws / kNumFrames, "");
+    Test::ReportMetric("Frustum culled draws per frame", numFrustumDraws / kNumFrames, "");
+    Test::ReportMetric("Unculled draws per frame", double(casters.size()) * shadow.GetNumCascades(), "");
+    Test::ReportMetric("Reduction", (1 - numDraws / kNumFrames / (double(casters.size()) * shadow.GetNumCascades())) * 100, "%");
+}
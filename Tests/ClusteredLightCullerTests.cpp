@@ -0,0 +1,376 @@
+#include "TestFramework.h"
+#include "Renderer/ClusteredLightCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 operator+(const Float3& a, const Float3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    Float3 operator-(const Float3& a, const Float3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Float3 operator*(const Float3& a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+    Float3 Cross(const Float3& a, const Float3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Float3 Normalize(const Float3& v) { return v * (1 / std::sqrt(Dot(v, v))); }
+
+    // 左手系的相机，与 XMMatrixLookAtLH 相同
+    struct TestCamera
+    {
+        Float3 m_Eye{};
+        Float3 m_Right{}, m_Up{}, m_Forward{};
+        ClusterCameraDesc m_Desc{};
+
+        TestCamera(Float3 eye, Float3 target, float width, float height, bool reversedZ = false)
+        {
+            m_Eye = eye;
+            m_Forward = Normalize(target - eye);
+            m_Right = Normalize(Cross({0, 1, 0}, m_Forward));
+            m_Up = Cross(m_Forward, m_Right);
+            float view[16] = {
+                m_Right.x, m_Up.x, m_Forward.x, 0,
+                m_Right.y, m_Up.y, m_Forward.y, 0,
+                m_Right.z, m_Up.z, m_Forward.z, 0,
+                -Dot(m_Right, eye), -Dot(m_Up, eye), -Dot(m_Forward, eye), 1};
+            std::copy_n(view, 16, m_Desc.m_View);
+            m_Desc.m_FovY = 1.0f;
+            m_Desc.m_Aspect = width / height;
+            m_Desc.m_NearZ = 0.1f;
+            m_Desc.m_FarZ = 500.0f;
+            m_Desc.m_ReversedZ = reversedZ;
+            m_Desc.m_Width = width;
+            m_Desc.m_Height = height;
+        }
+
+        // 像素与观察空间深度对应的世界空间位置
+        Float3 Unproject(float px, float py, float viewZ) const
+        {
+            float tanY = std::tan(m_Desc.m_FovY * 0.5f);
+            float ndcX = px / m_Desc.m_Width * 2 - 1;
+            float ndcY = 1 - py / m_Desc.m_Height * 2;
+            return m_Eye + m_Right * (ndcX * tanY * m_Desc.m_Aspect * viewZ) + m_Up * (ndcY * tanY * viewZ) + m_Forward * viewZ;
+        }
+
+        // 与 XMMatrixPerspectiveFovLH 相同的深度，反向深度交换近远平面
+        float GetDepth(float viewZ) const
+        {
+            float n = m_Desc.m_ReversedZ ? m_Desc.m_FarZ : m_Desc.m_NearZ;
+            float f = m_Desc.m_ReversedZ ? m_Desc.m_NearZ : m_Desc.m_FarZ;
+            return f / (f - n) - n * f / ((f - n) * viewZ);
+        }
+    };
+
+    bool AffectsPoint(const ClusterLightBounds& light, const Float3& p)
+    {
+        Float3 position{light.m_Position[0], light.m_Position[1], light.m_Position[2]};
+        auto d = p - position;
+        auto distanceSq = Dot(d, d);
+        if (distanceSq > light.m_Range * light.m_Range) return false;
+        if (light.m_CosAngle <= 0 || distanceSq == 0) return true;
+        Float3 direction{light.m_Direction[0], light.m_Direction[1], light.m_Direction[2]};
+        return Dot(d, direction) >= light.m_CosAngle * std::sqrt(distanceSq);
+    }
+
+    // 与着色器相同，由像素与深度缓冲的值找到所在的簇
+    std::uint32_t FindCluster(const ClusteredLightCuller& culler, float px, float py, float depth)
+    {
+        const auto& constants = culler.GetConstants();
+        float viewZ = constants.m_DepthToViewZB / (depth - constants.m_DepthToViewZA);
+        auto slice = static_cast<std::int32_t>(std::floor(std::log(viewZ) * constants.m_SliceScale + constants.m_SliceBias));
+        slice = std::clamp(slice, 0, static_cast<std::int32_t>(constants.m_NumSlices) - 1);
+        auto tileX = (std::min)(static_cast<std::uint32_t>(px * constants.m_TileScaleX), constants.m_NumTilesX - 1);
+        auto tileY = (std::min)(static_cast<std::uint32_t>(py * constants.m_TileScaleY), constants.m_NumTilesY - 1);
+        return culler.GetClusterIndex(tileX, tileY, static_cast<std::uint32_t>(slice));
+    }
+
+    std::vector<ClusterLightBounds> MakeLights(std::uint32_t count, std::uint32_t seed, const TestCamera& camera,
+        float spread, float maxRange, float spotRatio)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        std::vector<ClusterLightBounds> lights(count);
+        for (auto& light : lights) {
+            // 大部分在视锥附近，也有一些在相机之后
+            auto center = camera.m_Eye + camera.m_Forward * (unit(rng) * spread * 1.2f - spread * 0.2f);
+            light.m_Position[0] = center.x + (unit(rng) * 2 - 1) * spread * 0.6f;
+            light.m_Position[1] = center.y + (unit(rng) * 2 - 1) * spread * 0.3f;
+            light.m_Position[2] = center.z + (unit(rng) * 2 - 1) * spread * 0.6f;
+            light.m_Range = 0.2f + unit(rng) * unit(rng) * maxRange;
+            if (unit(rng) < spotRatio) {
+                auto direction = Normalize({unit(rng) * 2 - 1, unit(rng) * 2 - 1, unit(rng) * 2 - 1});
+                light.m_Direction[0] = direction.x;
+                light.m_Direction[1] = direction.y;
+                light.m_Direction[2] = direction.z;
+                // 包含大于 45 度的半角
+                light.m_CosAngle = std::cos(0.1f + unit(rng) * 1.3f);
+            }
+        }
+        return lights;
+    }
+
+    // 每个簇的序号连续存放，簇中的光源按输入的顺序排列且不重复
+    bool IsValidLayout(const ClusteredLightCuller& culler, std::uint32_t numLights)
+    {
+        auto ranges = culler.GetClusterRanges();
+        auto indices = culler.GetLightIndices();
+        if (ranges.size() != culler.GetNumClusters()) {
+            std::printf("  %zu ranges for %u clusters\n", ranges.size(), culler.GetNumClusters());
+            return false;
+        }
+        std::uint32_t offset = 0, maxCount = 0;
+        std::vector<std::uint8_t> visible(numLights, 0);
+        for (std::size_t c = 0; c < ranges.size(); ++c) {
+            if (ranges[c].m_Offset != offset) {
+                std::printf("  cluster %zu starts at %u instead of %u\n", c, ranges[c].m_Offset, offset);
+                return false;
+            }
+            for (auto i = offset; i < offset + ranges[c].m_Count; ++i) {
+                if (indices[i] >= numLights || (i > offset && indices[i] <= indices[i - 1])) {
+                    std::printf("  cluster %zu has an unordered or invalid light %u\n", c, indices[i]);
+                    return false;
+                }
+                visible[indices[i]] = 1;
+            }
+            offset += ranges[c].m_Count;
+            maxCount = (std::max)(maxCount, ranges[c].m_Count);
+        }
+        const auto& stats = culler.GetStats();
+        auto numVisible = static_cast<std::uint32_t>(std::count(visible.begin(), visible.end(), 1));
+        if (offset != indices.size() || stats.m_NumIndices != offset || stats.m_MaxLightsPerCluster != maxCount ||
+            stats.m_NumVisibleLights != numVisible || stats.m_NumLights != numLights || culler.GetConstants().m_NumLights != numLights) {
+            std::printf("  stats do not match the output\n");
+            return false;
+        }
+        return true;
+    }
+
+    bool ContainsLight(const ClusteredLightCuller& culler, std::uint32_t cluster, std::uint32_t light)
+    {
+        auto range = culler.GetClusterRanges()[cluster];
+        auto indices = culler.GetLightIndices().subspan(range.m_Offset, range.m_Count);
+        return std::binary_search(indices.begin(), indices.end(), light);
+    }
+
+    // 在视锥中随机取点，影响该点的光源都必须在所在的簇中
+    bool IsConservative(const ClusteredLightCuller& culler, const TestCamera& camera,
+        const std::vector<ClusterLightBounds>& lights, std::uint32_t numSamples, std::uint32_t seed)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        const auto& desc = camera.m_Desc;
+        for (std::uint32_t i = 0; i < numSamples; ++i) {
+            float px = unit(rng) * desc.m_Width, py = unit(rng) * desc.m_Height;
+            float viewZ = desc.m_NearZ * std::pow(desc.m_FarZ / desc.m_NearZ, unit(rng) * 0.6f);
+            auto p = camera.Unproject(px, py, viewZ);
+            auto cluster = FindCluster(culler, px, py, camera.GetDepth(viewZ));
+            for (std::uint32_t l = 0; l < lights.size(); ++l) {
+                if (AffectsPoint(lights[l], p) && !ContainsLight(culler, cluster, l)) {
+                    std::printf("  light %u affects (%f, %f, z %f) but is missing from cluster %u\n", l, px, py, viewZ, cluster);
+                    return false;
+                }
+            }
+        }
+
+        // 再在每个光源的范围内取点，圆锥的边缘附近也有足够的采样
+        float tanY = std::tan(desc.m_FovY * 0.5f), tanX = tanY * desc.m_Aspect;
+        for (std::uint32_t l = 0; l < lights.size(); ++l) {
+            const auto& light = lights[l];
+            Float3 position{light.m_Position[0], light.m_Position[1], light.m_Position[2]};
+            for (std::uint32_t i = 0; i < 64; ++i) {
+                Float3 offset{unit(rng) * 2 - 1, unit(rng) * 2 - 1, unit(rng) * 2 - 1};
+                if (Dot(offset, offset) > 1) continue;
+                auto p = position + offset * light.m_Range;
+                if (!AffectsPoint(light, p)) continue;
+
+                auto v = p - camera.m_Eye;
+                float x = Dot(v, camera.m_Right), y = Dot(v, camera.m_Up), z = Dot(v, camera.m_Forward);
+                if (z < desc.m_NearZ || z > desc.m_FarZ || std::abs(x) > tanX * z || std::abs(y) > tanY * z) continue;
+                float px = (x / (tanX * z) * 0.5f + 0.5f) * desc.m_Width;
+                float py = (0.5f - y / (tanY * z) * 0.5f) * desc.m_Height;
+                auto cluster = FindCluster(culler, px, py, camera.GetDepth(z));
+                if (!ContainsLight(culler, cluster, l)) {
+                    std::printf("  light %u affects (%f, %f, z %f) but is missing from cluster %u\n", l, px, py, z, cluster);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(ClusteredLightCuller_ReconstructsViewDepth)
+{
+    for (bool reversedZ : {false, true}) {
+        TestCamera camera{{0, 0, 0}, {0, 0, 1}, 1280, 720, reversedZ};
+        ClusteredLightCuller culler{};
+        culler.SetCamera(camera.m_Desc);
+        const auto& constants = culler.GetConstants();
+        CHECK(constants.m_NumTilesX == 16);
+        CHECK(constants.m_NumTilesY == 9);
+        CHECK(constants.m_NumSlices == 24);
+        CHECK(constants.m_NumLights == 0);
+
+        for (float viewZ : {0.1f, 0.5f, 3.0f, 42.0f, 499.0f}) {
+            float depth = camera.GetDepth(viewZ);
+            float reconstructed = constants.m_DepthToViewZB / (depth - constants.m_DepthToViewZA);
+            CHECK(std::abs(reconstructed - viewZ) <= viewZ * 1e-3f);
+        }
+        // 层按深度的对数均匀划分
+        CHECK(std::abs(std::log(0.1f) * constants.m_SliceScale + constants.m_SliceBias) < 1e-3f);
+        CHECK(std::abs(std::log(500.0f) * constants.m_SliceScale + constants.m_SliceBias - 24) < 1e-3f);
+        CHECK(std::abs(1279.5f * constants.m_TileScaleX - 15.99f) < 0.01f);
+    }
+
+    ClusteredLightCullerDesc desc{};
+    desc.m_NumTilesX = 100;
+    ClusteredLightCuller wide{desc};
+    CHECK(wide.GetNumClusters() == ClusteredLightCuller::sm_MaxTilesX * 9 * 24);
+}
+
+TEST_CASE(ClusteredLightCuller_AssignsSimpleLights)
+{
+    TestCamera camera{{0, 0, 0}, {0, 0, 1}, 1280, 720};
+    ClusteredLightCuller culler{};
+    culler.SetCamera(camera.m_Desc);
+
+    // 没有光源时所有的簇为空
+    culler.AssignLights({});
+    CHECK(IsValidLayout(culler, 0));
+    CHECK(culler.GetLightIndices().empty());
+
+    std::vector<ClusterLightBounds> lights(5);
+    // 屏幕中心的小点光源
+    lights[0].m_Position[2] = 10;
+    lights[0].m_Range = 0.05f;
+    // 在相机之后，在远平面之外，在视锥的左侧之外
+    lights[1].m_Position[2] = -5;
+    lights[1].m_Range = 2;
+    lights[2].m_Position[2] = 600;
+    lights[2].m_Range = 50;
+    lights[3].m_Position[0] = -30;
+    lights[3].m_Position[2] = 10;
+    lights[3].m_Range = 5;
+    // 包含相机的大光源覆盖所有的簇
+    lights[4].m_Range = 1000;
+    culler.AssignLights(lights);
+    REQUIRE(IsValidLayout(culler, 5));
+
+    const auto& stats = culler.GetStats();
+    CHECK(stats.m_NumVisibleLights == 2);
+    CHECK(stats.m_MaxLightsPerCluster == 2);
+    std::uint32_t numClustersWithSmall = 0;
+    for (std::uint32_t c = 0; c < culler.GetNumClusters(); ++c) {
+        numClustersWithSmall += ContainsLight(culler, c, 0);
+        CHECK(ContainsLight(culler, c, 4));
+    }
+    // 小光源最多跨越相邻的两列两行两层
+    CHECK(numClustersWithSmall >= 1 && numClustersWithSmall <= 8);
+    CHECK(ContainsLight(culler, FindCluster(culler, 640, 360, camera.GetDepth(10)), 0));
+    CHECK(stats.m_NumIndices == culler.GetNumClusters() + numClustersWithSmall);
+
+    // 朝向相机之外的聚光灯不影响它身后的簇
+    ClusterLightBounds spot{};
+    spot.m_Position[2] = 20;
+    spot.m_Range = 10;
+    spot.m_CosAngle = std::cos(0.3f);
+    culler.AssignLights({&spot, 1});
+    auto forward = culler.GetStats().m_NumIndices;
+    CHECK(ContainsLight(culler, FindCluster(culler, 640, 360, camera.GetDepth(25)), 0));
+    CHECK(!ContainsLight(culler, FindCluster(culler, 640, 360, camera.GetDepth(14)), 0));
+    spot.m_Direction[2] = -1;
+    culler.AssignLights({&spot, 1});
+    CHECK(ContainsLight(culler, FindCluster(culler, 640, 360, camera.GetDepth(14)), 0));
+    CHECK(!ContainsLight(culler, FindCluster(culler, 640, 360, camera.GetDepth(25)), 0));
+    // 点光源的簇更多
+    spot.m_CosAngle = -1;
+    culler.AssignLights({&spot, 1});
+    CHECK(culler.GetStats().m_NumIndices > forward);
+}
+
+TEST_CASE(ClusteredLightCuller_RandomLightsAreConservative)
+{
+    for (std::uint32_t seed = 0; seed < 4; ++seed) {
+        bool reversedZ = seed % 2 == 1;
+        TestCamera camera{{seed * 3.0f, 1, -2.0f * seed}, {10, seed * 0.5f, 30}, 1024, 768, reversedZ};
+        ClusteredLightCullerDesc desc{};
+        desc.m_NumTilesX = 13 + seed;
+        desc.m_NumTilesY = 7;
+        desc.m_NumSlices = 16;
+        ClusteredLightCuller culler{desc};
+        culler.SetCamera(camera.m_Desc);
+
+        auto lights = MakeLights(400, seed, camera, 60, 12, 0.5f);
+        culler.AssignLights(lights);
+        CHECK(IsValidLayout(culler, 400));
+        CHECK(IsConservative(culler, camera, lights, 3000, seed + 100));
+        // 相机之后的光源不可见
+        CHECK(culler.GetStats().m_NumVisibleLights < 400);
+        CHECK(culler.GetStats().m_NumVisibleLights > 100);
+
+        // 只移动相机时簇的包围盒不变
+        TestCamera moved{{seed * 3.0f + 5, 2, -2.0f * seed}, {-10, 0, 40}, 1024, 768, reversedZ};
+        culler.SetCamera(moved.m_Desc);
+        culler.AssignLights(lights);
+        CHECK(IsValidLayout(culler, 400));
+        CHECK(IsConservative(culler, moved, lights, 1000, seed + 200));
+    }
+}
+
+TEST_CASE(ClusteredLightCuller_ThreadCountDoesNotChangeOutput)
+{
+    TestCamera camera{{0, 2, 0}, {0, 1, 1}, 1920, 1080};
+    auto lights = MakeLights(5000, 9, camera, 80, 8, 0.5f);
+
+    ClusteredLightCullerDesc desc{};
+    desc.m_NumThreads = 1;
+    ClusteredLightCuller serial{desc};
+    desc.m_NumThreads = 5;
+    ClusteredLightCuller parallel{desc};
+    serial.SetCamera(camera.m_Desc);
+    parallel.SetCamera(camera.m_Desc);
+    serial.AssignLights(lights);
+    parallel.AssignLights(lights);
+
+    CHECK(IsValidLayout(parallel, 5000));
+    auto serialRanges = serial.GetClusterRanges(), parallelRanges = parallel.GetClusterRanges();
+    auto serialIndices = serial.GetLightIndices(), parallelIndices = parallel.GetLightIndices();
+    CHECK(std::equal(serialIndices.begin(), serialIndices.end(), parallelIndices.begin(), parallelIndices.end()));
+    CHECK(std::equal(serialRanges.begin(), serialRanges.end(), parallelRanges.begin(), parallelRanges.end(),
+        [](const ClusterLightRange& a, const ClusterLightRange& b) { return a.m_Offset == b.m_Offset && a.m_Count == b.m_Count; }));
+}
+
+BENCHMARK_CASE(ClusteredLightCuller_ManyLights)
+{
+    TestCamera camera{{0, 2, 0}, {0, 1.5f, 1}, 1920, 1080};
+    std::vector<std::uint32_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+
+    for (std::uint32_t numLights : {10000u, 20000u, 50000u}) {
+        // 光源散布在约 200 米的范围内，一半为聚光灯
+        auto lights = MakeLights(numLights, numLights, camera, 200, 10, 0.5f);
+        for (auto threads : threadCounts) {
+            ClusteredLightCullerDesc desc{};
+            desc.m_NumThreads = threads;
+            ClusteredLightCuller culler{desc};
+            culler.SetCamera(camera.m_Desc);
+            auto seconds = Test::MeasureSeconds([&]() { culler.AssignLights(lights); });
+
+            std::printf("  %u lights, %u threads, %ux%ux%u clusters\n", numLights, threads,
+                culler.GetConstants().m_NumTilesX, culler.GetConstants().m_NumTilesY, culler.GetConstants().m_NumSlices);
+            Test::ReportMetric("Assign", seconds * 1e3, "ms");
+            Test::ReportMetric("Throughput", numLights / seconds * 1e-6, "Mlights/s");
+            Test::ReportMetric("Visible lights", culler.GetStats().m_NumVisibleLights, "");
+            Test::ReportMetric("Light indices", culler.GetStats().m_NumIndices, "");
+            Test::ReportMetric("Upload size", (culler.GetStats().m_NumIndices * 4.0 + culler.GetNumClusters() * 8.0) / 1024, "KB");
+            Test::ReportMetric("Max lights per cluster", culler.GetStats().m_MaxLightsPerCluster, "");
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#include "TestFramework.h"
+#include "Core/CpuTimer.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    bool NearlyEqual(double a, double b)
+    {
+        return std::abs(a - b) < 1e-9;
+    }
+
+    // 最近秩法的参考实现
+    double ReferencePercentile(std::vector<double> samples, double percentile)
+    {
+        std::sort(samples.begin(), samples.end());
+        auto rank = static_cast<std::size_t>(std::ceil(percentile * samples.size()));
+        return samples[rank == 0 ? 0 : rank - 1];
+    }
+}
+
+TEST_CASE(FrameTimeStats_KnownWindow)
+{
+    FrameTimeStats stats{100};
+    CHECK(stats.GetNumSamples() == 0);
+    CHECK(stats.ComputePercentile(0.5) == 0);
+    CHECK(stats.GetFPS() == 0);
+
+    // 1..100 乱序加入，结果与顺序无关
+    std::vector<double> samples{};
+    for (std::uint32_t i = 1; i <= 100; ++i) samples.push_back(i);
+    std::shuffle(samples.begin(), samples.end(), std::mt19937{3});
+    for (auto sample : samples) stats.AddFrameTime(sample);
+
+    CHECK(stats.GetNumSamples() == 100);
+    CHECK(stats.GetMin() == 1);
+    CHECK(stats.GetMax() == 100);
+    CHECK(NearlyEqual(stats.GetAverage(), 50.5));
+    CHECK(NearlyEqual(stats.GetFPS(), 1000.0 / 50.5));
+    CHECK(stats.GetP95() == 95);
+    CHECK(stats.GetP99() == 99);
+    CHECK(stats.ComputePercentile(0) == 1);
+    CHECK(stats.ComputePercentile(0.5) == 50);
+    CHECK(stats.ComputePercentile(0.951) == 96);
+    CHECK(stats.ComputePercentile(1) == 100);
+    // 超出范围的百分位被截断
+    CHECK(stats.ComputePercentile(-1) == 1);
+    CHECK(stats.ComputePercentile(2) == 100);
+
+    // 一次卡顿只影响最大值与高百分位
+    FrameTimeStats spikes{20};
+    for (std::uint32_t i = 0; i < 19; ++i) spikes.AddFrameTime(16);
+    spikes.AddFrameTime(100);
+    CHECK(spikes.GetP95() == 16);
+    CHECK(spikes.GetP99() == 100);
+    CHECK(spikes.GetMax() == 100);
+    CHECK(NearlyEqual(spikes.GetAverage(), (19 * 16 + 100) / 20.0));
+}
+
+TEST_CASE(FrameTimeStats_WindowRollsOver)
+{
+    FrameTimeStats stats{4};
+    for (auto sample : {10.0, 20.0, 30.0, 40.0, 1.0, 2.0}) {
+        stats.AddFrameTime(sample);
+    }
+    // 最早的两帧被覆盖
+    CHECK(stats.GetNumSamples() == 4);
+    CHECK(stats.GetMin() == 1);
+    CHECK(stats.GetMax() == 40);
+    CHECK(NearlyEqual(stats.GetAverage(), 18.25));
+    CHECK(stats.GetP95() == 40);
+
+    // 整个窗口被替换后不再残留旧的最大值
+    for (auto sample : {5.0, 6.0, 7.0, 8.0}) {
+        stats.AddFrameTime(sample);
+    }
+    CHECK(stats.GetMin() == 5);
+    CHECK(stats.GetMax() == 8);
+    CHECK(NearlyEqual(stats.GetAverage(), 6.5));
+
+    stats.Clear();
+    CHECK(stats.GetNumSamples() == 0);
+    CHECK(stats.GetMax() == 0);
+    CHECK(stats.GetAverage() == 0);
+    stats.AddFrameTime(3);
+    CHECK(stats.GetMin() == 3);
+    CHECK(stats.GetP99() == 3);
+
+    // 窗口大小至少为 1
+    FrameTimeStats single{0};
+    single.AddFrameTime(7);
+    single.AddFrameTime(9);
+    CHECK(single.GetNumSamples() == 1);
+    CHECK(single.GetMin() == 9);
+
+    // 随机序列与滑动窗口的参考结果一致
+    std::mt19937 rng{11};
+    std::uniform_real_distribution<double> frameTime{4, 40};
+    for (std::uint32_t windowSize : {1u, 7u, 37u, 256u}) {
+        FrameTimeStats randomStats{windowSize};
+        std::deque<double> window{};
+        for (std::uint32_t i = 0; i < 1000; ++i) {
+            auto sample = frameTime(rng);
+            randomStats.AddFrameTime(sample);
+            window.push_back(sample);
+            if (window.size() > windowSize) window.pop_front();
+
+            std::vector<double> samples{window.begin(), window.end()};
+            double sum = 0;
+            for (auto s : samples) sum += s;
+            CHECK(randomStats.GetNumSamples() == samples.size());
+            CHECK(randomStats.GetMin() == *std::min_element(samples.begin(), samples.end()));
+            CHECK(randomStats.GetMax() == *std::max_element(samples.begin(), samples.end()));
+            CHECK(std::abs(randomStats.GetAverage() - sum / samples.size()) < 1e-9);
+            CHECK(randomStats.GetP95() == ReferencePercentile(samples, 0.95));
+            CHECK(randomStats.GetP99() == ReferencePercentile(samples, 0.99));
+        }
+    }
+}
+
+TEST_CASE(FixedTimestep_StepsAndAlpha)
+{
+    // 步长与帧时间均可被二进制精确表示
+    FixedTimestep timestep{0.25, 4};
+    CHECK(timestep.GetStep() == 0.25);
+    CHECK(timestep.GetAlpha() == 0);
+
+    CHECK(timestep.Advance(0.125) == 0);
+    CHECK(timestep.GetAlpha() == 0.5);
+    CHECK(timestep.Advance(0.125) == 1);
+    CHECK(timestep.GetAlpha() == 0);
+    CHECK(timestep.Advance(0.625) == 2);
+    CHECK(timestep.GetAlpha() == 0.5);
+    // 负的帧时间被忽略
+    CHECK(timestep.Advance(-1) == 0);
+    CHECK(timestep.GetAlpha() == 0.5);
+
+    // 卡顿后最多执行 maxSteps 步，其余整步被丢弃，只保留不足一步的余量
+    CHECK(timestep.Advance(10) == 4);
+    CHECK(timestep.GetAlpha() == 0.5);
+    CHECK(timestep.Advance(0) == 0);
+    CHECK(timestep.Advance(0.125) == 1);
+    CHECK(timestep.GetAlpha() == 0);
+
+    // 恰好达到上限时不丢弃余量
+    CHECK(timestep.Advance(1.125) == 4);
+    CHECK(timestep.GetAlpha() == 0.5);
+
+    timestep.Reset();
+    CHECK(timestep.GetAlpha() == 0);
+    timestep.SetStep(0.5);
+    CHECK(timestep.Advance(0.75) == 1);
+    CHECK(timestep.GetAlpha() == 0.5);
+
+    // 未触发上限时，累计步数等于总时间除以步长
+    FixedTimestep steady{1.0 / 64, 8};
+    std::mt19937 rng{5};
+    std::uint32_t numSteps = 0;
+    std::uint32_t totalTicks = 0;
+    for (std::uint32_t i = 0; i < 10000; ++i) {
+        auto ticks = rng() % 32;
+        totalTicks += ticks;
+        numSteps += steady.Advance(ticks / 256.0);
+        CHECK(steady.GetAlpha() >= 0 && steady.GetAlpha() < 1);
+    }
+    CHECK(numSteps == totalTicks / 4);
+    CHECK(steady.GetAlpha() == (totalTicks % 4) / 4.0);
+}
+
+TEST_CASE(CpuTimer_PauseExcludesStoppedTime)
+{
+    CpuTimer timer{};
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timer.Tick();
+    CHECK(timer.DeltaTimeInSeconds() > 0);
+    CHECK(!timer.IsStopped());
+
+    timer.Stop();
+    auto stoppedTime = timer.TotalTimeInSeconds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timer.Tick();
+    // 暂停期间没有帧时间，总时间也不增长
+    CHECK(timer.IsStopped());
+    CHECK(timer.DeltaTime() == 0);
+    CHECK(timer.TotalTimeInSeconds() == stoppedTime);
+
+    timer.Start();
+    timer.Tick();
+    CHECK(timer.DeltaTimeInSeconds() < 0.02);
+    CHECK(timer.TotalTimeInSeconds() >= stoppedTime);
+    CHECK(timer.TotalTimeInSeconds() < stoppedTime + 0.02);
+}
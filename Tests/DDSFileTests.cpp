@@ -0,0 +1,220 @@
+#include "TestFramework.h"
+#include "Utilities/DDSFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // DXGI_FORMAT_R8G8B8A8_UNORM
+    constexpr std::uint32_t kFormatRGBA8 = 28;
+    // 头部字段在文件中的偏移
+    constexpr std::size_t kMipCountOffset = 4 + 24;
+    constexpr std::size_t kArraySizeOffset = 4 + 124 + 12;
+
+    struct TestTexture
+    {
+        DDSTextureInfo m_Info{};
+        std::vector<std::vector<std::uint8_t>> m_Subresources{};
+    };
+
+    TestTexture MakeTexture(std::uint32_t width, std::uint32_t height, std::uint32_t mipLevels, std::uint32_t arraySize)
+    {
+        TestTexture texture{};
+        texture.m_Info.m_Width = width;
+        texture.m_Info.m_Height = height;
+        texture.m_Info.m_Depth = 1;
+        texture.m_Info.m_MipLevels = mipLevels;
+        texture.m_Info.m_ArraySize = arraySize;
+        texture.m_Info.m_Format = kFormatRGBA8;
+        texture.m_Info.m_Dimension = DDSDimension::kTexture2D;
+
+        std::uint8_t value = 1;
+        for (std::uint32_t slice = 0; slice < arraySize; ++slice) {
+            for (std::uint32_t mip = 0; mip < mipLevels; ++mip) {
+                auto size = std::size_t{4} * (std::max)(width >> mip, 1u) * (std::max)(height >> mip, 1u);
+                auto& data = texture.m_Subresources.emplace_back(size);
+                std::iota(data.begin(), data.end(), value++);
+            }
+        }
+        return texture;
+    }
+
+    // 写出到临时文件后读回字节
+    std::vector<std::uint8_t> SaveToBytes(const TestTexture& texture)
+    {
+        std::vector<std::span<const std::uint8_t>> subresources{};
+        for (const auto& data : texture.m_Subresources) {
+            subresources.emplace_back(data);
+        }
+
+        auto path = std::filesystem::temp_directory_path() / "DDSFileTests.dds";
+        if (!DDSFile::Save(path.string(), texture.m_Info, subresources)) return {};
+
+        std::ifstream file{path, std::ios::binary};
+        std::vector<std::uint8_t> bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        file.close();
+        std::filesystem::remove(path);
+        return bytes;
+    }
+
+    void PatchU32(std::vector<std::uint8_t>& bytes, std::size_t offset, std::uint32_t value)
+    {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+}
+
+TEST_CASE(DDSFile_RoundTripsArrayWithMips)
+{
+    auto texture = MakeTexture(16, 8, 5, 3);
+    auto bytes = SaveToBytes(texture);
+    REQUIRE(!bytes.empty());
+
+    DDSFile file{};
+    REQUIRE(file.Parse(bytes));
+    CHECK(file.GetInfo().m_Width == 16 && file.GetInfo().m_Height == 8);
+    CHECK(file.GetInfo().m_MipLevels == 5);
+    CHECK(file.GetInfo().m_ArraySize == 3);
+    REQUIRE(file.GetNumSubresources() == 15);
+    for (std::uint32_t i = 0; i < 15; ++i) {
+        auto data = file.GetSubresourceData(i);
+        CHECK(data.size() == texture.m_Subresources[i].size() &&
+            std::memcmp(data.data(), texture.m_Subresources[i].data(), data.size()) == 0);
+    }
+
+    // 上传布局的行距按 256 字节对齐
+    DDSUploadFootprint footprints[2]{};
+    auto uploadSize = file.ComputeUploadFootprints(0, footprints);
+    CHECK(footprints[0].m_RowPitch == 256 && footprints[0].m_NumRows == 8);
+    CHECK(footprints[1].m_Offset % DDSFile::sm_PlacementAlignment == 0);
+    CHECK(uploadSize >= footprints[1].m_Offset + footprints[1].m_RowPitch * 3 + footprints[1].m_RowSize);
+}
+
+TEST_CASE(DDSFile_RejectsMipCountBeyondFullChain)
+{
+    // 1x1 的纹理只能有一个 mip，多出的 mip 即使数据大小吻合也要拒绝
+    auto bytes = SaveToBytes(MakeTexture(1, 1, 1, 1));
+    REQUIRE(!bytes.empty());
+    PatchU32(bytes, kMipCountOffset, 2);
+    bytes.insert(bytes.end(), 4, 0);
+
+    DDSFile file{};
+    CHECK(!file.Parse(bytes));
+    CHECK(file.GetNumSubresources() == 0);
+
+    // 完整的 mip 链可以通过
+    auto fullChain = SaveToBytes(MakeTexture(5, 3, 3, 1));
+    CHECK(file.Parse(fullChain));
+    PatchU32(fullChain, kMipCountOffset, 4);
+    CHECK(!file.Parse(fullChain));
+}
+
+TEST_CASE(DDSFile_RejectsSizeInconsistentWithArraySize)
+{
+    auto bytes = SaveToBytes(MakeTexture(4, 4, 1, 2));
+    REQUIRE(bytes.size() == 4 + 124 + 20 + 2 * 64);
+    DDSFile file{};
+    CHECK(file.Parse(bytes));
+
+    // 数组大小少于数据中的数量
+    auto fewer = bytes;
+    PatchU32(fewer, kArraySizeOffset, 1);
+    CHECK(!file.Parse(fewer));
+
+    // 数组大小超过数据中的数量，包括伪造的最大数组
+    auto more = bytes;
+    PatchU32(more, kArraySizeOffset, 3);
+    CHECK(!file.Parse(more));
+    PatchU32(more, kArraySizeOffset, DDSFile::sm_MaxArraySize);
+    CHECK(!file.Parse(more));
+
+    // 截断或多出字节
+    auto truncated = bytes;
+    truncated.pop_back();
+    CHECK(!file.Parse(truncated));
+    auto padded = bytes;
+    padded.push_back(0);
+    CHECK(!file.Parse(padded));
+}
+
+TEST_CASE(DDSFile_RejectsBrokenHeaders)
+{
+    auto bytes = SaveToBytes(MakeTexture(8, 8, 1, 1));
+    REQUIRE(!bytes.empty());
+    DDSFile file{};
+
+    auto badMagic = bytes;
+    badMagic[0] = 'X';
+    CHECK(!file.Parse(badMagic));
+
+    auto zeroArray = bytes;
+    PatchU32(zeroArray, kArraySizeOffset, 0);
+    CHECK(!file.Parse(zeroArray));
+
+    auto headerOnly = std::vector<std::uint8_t>(bytes.begin(), bytes.begin() + 64);
+    CHECK(!file.Parse(headerOnly));
+}
+
+BENCHMARK_CASE(DDSFile_MappedUploadThroughput)
+{
+    // 2048 的立方体贴图，带完整的 mip 链
+    constexpr std::uint32_t kSize = 2048;
+    constexpr std::uint32_t kMipLevels = 12;
+    auto texture = MakeTexture(kSize, kSize, kMipLevels, 6);
+    texture.m_Info.m_IsCubeMap = true;
+    std::vector<std::span<const std::uint8_t>> subresources{};
+    for (const auto& data : texture.m_Subresources) {
+        subresources.emplace_back(data);
+    }
+    auto path = (std::filesystem::temp_directory_path() / "DDSFileBench.dds").string();
+    REQUIRE(DDSFile::Save(path, texture.m_Info, subresources));
+    auto fileSize = static_cast<double>(std::filesystem::file_size(path));
+
+    std::vector<DDSUploadFootprint> footprints{};
+    std::vector<std::uint8_t> uploadBuffer{};
+
+    // 之前的做法：整个文件读入堆内存，再逐行拷贝到上传缓冲
+    auto readSeconds = Test::MeasureSeconds([&]() {
+        std::ifstream file{path, std::ios::binary};
+        std::vector<std::uint8_t> bytes(static_cast<std::size_t>(fileSize));
+        file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        DDSFile ddsFile{};
+        ddsFile.Parse(bytes);
+        footprints.resize(ddsFile.GetNumSubresources());
+        uploadBuffer.resize(ddsFile.ComputeUploadFootprints(0, footprints));
+        for (std::uint32_t i = 0; i < ddsFile.GetNumSubresources(); ++i) {
+            ddsFile.WriteSubresource(i, footprints[i], uploadBuffer.data());
+        }
+    }, 1.0, 20);
+
+    // 映射文件，直接从映射的内存写入上传缓冲
+    bool parsed = true;
+    auto mappedSeconds = Test::MeasureSeconds([&]() {
+        DDSFile ddsFile{};
+        parsed &= ddsFile.Open(path);
+        footprints.resize(ddsFile.GetNumSubresources());
+        uploadBuffer.resize(ddsFile.ComputeUploadFootprints(0, footprints));
+        for (std::uint32_t i = 0; i < ddsFile.GetNumSubresources(); ++i) {
+            ddsFile.WriteSubresource(i, footprints[i], uploadBuffer.data());
+        }
+    }, 1.0, 20);
+    CHECK(parsed);
+    CHECK(footprints.size() == kMipLevels * 6);
+
+    // 只解析头部与计算布局
+    auto parseSeconds = Test::MeasureSeconds([&]() {
+        DDSFile ddsFile{};
+        parsed &= ddsFile.Open(path);
+        ddsFile.ComputeUploadFootprints(0, footprints);
+    }, 0.2, 10000);
+
+    std::filesystem::remove(path);
+    Test::ReportMetric("file size", fileSize / (1 << 20), "MB");
+    Test::ReportMetric("read into heap + copy rows", fileSize / readSeconds / (1 << 20), "MB/s");
+    Test::ReportMetric("mapped + copy rows", fileSize / mappedSeconds / (1 << 20), "MB/s");
+    Test::ReportMetric("open + parse + footprints", parseSeconds * 1e6, "us");
+}
@@ -0,0 +1,208 @@
+#include "TestFramework.h"
+#include "Graphics/FrameScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 模拟的栅栏时钟，等待时直接推进到目标值
+    class SimulatedFence : public IFence
+    {
+    public:
+        bool IsFenceComplete(std::uint64_t fenceValue) override { return fenceValue <= m_CompletedValue; }
+        void WaitForFence(std::uint64_t fenceValue) override
+        {
+            m_Waits.push_back(fenceValue);
+            m_Log.push_back("wait " + std::to_string(fenceValue));
+            m_CompletedValue = (std::max)(m_CompletedValue, fenceValue);
+        }
+
+        std::uint64_t Signal() noexcept { return ++m_NextValue; }
+
+        std::uint64_t m_CompletedValue = 0;
+        std::uint64_t m_NextValue = 0;
+        std::vector<std::uint64_t> m_Waits{};
+        std::vector<std::string> m_Log{};
+    };
+
+    FrameSchedulerDesc MakeDesc(std::uint32_t numFrames)
+    {
+        FrameSchedulerDesc desc{};
+        desc.m_NumFramesInFlight = numFrames;
+        desc.m_TransientBufferSize = 1024;
+        desc.m_NumTransientDescriptors = 16;
+        return desc;
+    }
+}
+
+TEST_CASE(FrameScheduler_BeginFrameWaitsForSlotFence)
+{
+    SimulatedFence fence{};
+    FrameScheduler scheduler{};
+    scheduler.Create(MakeDesc(3), &fence);
+
+    // 前三帧的槽位都是空的，不需要等待
+    for (std::uint32_t i = 0; i < 3; ++i) {
+        CHECK(scheduler.BeginFrame() == i);
+        scheduler.EndFrame(fence.Signal());
+    }
+    CHECK(fence.m_Waits.empty());
+    CHECK(scheduler.GetWaitStats().m_NumStalls == 0);
+
+    // GPU 只完成了第一帧，第四帧复用槽位 0 时等待栅栏值 1
+    fence.m_CompletedValue = 0;
+    CHECK(scheduler.BeginFrame() == 0);
+    REQUIRE(fence.m_Waits.size() == 1);
+    CHECK(fence.m_Waits[0] == 1);
+    CHECK(scheduler.GetWaitStats().m_NumStalls == 1);
+    scheduler.EndFrame(fence.Signal());
+
+    // 槽位 1 的栅栏已完成，只回收不计入阻塞
+    fence.m_CompletedValue = 2;
+    CHECK(scheduler.BeginFrame() == 1);
+    CHECK(scheduler.GetWaitStats().m_NumStalls == 1);
+    CHECK(scheduler.GetWaitStats().m_NumFrames == 5);
+    CHECK(scheduler.GetFrameFenceValue(0) == 4);
+    scheduler.EndFrame(fence.Signal());
+}
+
+TEST_CASE(FrameScheduler_DeferReleaseRunsAfterFenceInOrder)
+{
+    SimulatedFence fence{};
+    FrameScheduler scheduler{};
+    scheduler.Create(MakeDesc(2), &fence);
+
+    scheduler.BeginFrame();
+    scheduler.DeferRelease([&]() { fence.m_Log.push_back("release a"); });
+    scheduler.DeferRelease([&]() { fence.m_Log.push_back("release b"); });
+    scheduler.EndFrame(fence.Signal());
+
+    scheduler.BeginFrame();
+    scheduler.DeferRelease([&]() { fence.m_Log.push_back("release c"); });
+    scheduler.EndFrame(fence.Signal());
+    // 槽位尚未复用，延迟的资源不能释放
+    CHECK(fence.m_Log.empty());
+
+    // 复用槽位 0：先等待该帧的栅栏，再按提交顺序释放
+    scheduler.BeginFrame();
+    REQUIRE(fence.m_Log.size() == 3);
+    CHECK(fence.m_Log[0] == "wait 1");
+    CHECK(fence.m_Log[1] == "release a");
+    CHECK(fence.m_Log[2] == "release b");
+    scheduler.EndFrame(fence.Signal());
+
+    // Shutdown 等待剩余的帧并释放其资源
+    fence.m_Log.clear();
+    scheduler.Shutdown();
+    REQUIRE(fence.m_Log.size() == 3);
+    CHECK(fence.m_Log[0] == "wait 2");
+    CHECK(fence.m_Log[1] == "release c");
+    CHECK(fence.m_Log[2] == "wait 3");
+    CHECK(!scheduler.IsCreated());
+}
+
+TEST_CASE(FrameScheduler_TransientPoolsRecycledByFrameIndex)
+{
+    SimulatedFence fence{};
+    FrameScheduler scheduler{};
+    scheduler.Create(MakeDesc(2), &fence);
+
+    // 每帧占用互不重叠的一段
+    scheduler.BeginFrame();
+    CHECK(scheduler.AllocateTransient(100) == 0);
+    CHECK(scheduler.AllocateTransient(16, 256) == 256);
+    CHECK(scheduler.AllocateTransientDescriptors(4) == 0);
+    scheduler.EndFrame(fence.Signal());
+
+    scheduler.BeginFrame();
+    CHECK(scheduler.AllocateTransient(100) == 1024);
+    CHECK(scheduler.AllocateTransientDescriptors(16) == 16);
+    // 空间不足时返回无效值且不影响后续较小的分配
+    CHECK(scheduler.AllocateTransientDescriptors(1) == FrameScheduler::sm_InvalidTransientDescriptor);
+    CHECK(scheduler.AllocateTransient(2048) == FrameScheduler::sm_InvalidTransientOffset);
+    CHECK(scheduler.AllocateTransient(8) == 1124);
+    scheduler.EndFrame(fence.Signal());
+
+    // 复用槽位 0 后从头分配
+    scheduler.BeginFrame();
+    CHECK(scheduler.GetFrameIndex() == 0);
+    CHECK(scheduler.AllocateTransient(1024) == 0);
+    CHECK(scheduler.AllocateTransient(1) == FrameScheduler::sm_InvalidTransientOffset);
+    CHECK(scheduler.AllocateTransientDescriptors(16) == 0);
+    scheduler.EndFrame(fence.Signal());
+}
+
+TEST_CASE(FrameScheduler_LimitsFramesAheadOfGpu)
+{
+    SimulatedFence fence{};
+    FrameScheduler scheduler{};
+    scheduler.Create(MakeDesc(2), &fence);
+
+    // GPU 从不主动推进时，CPU 最多领先 2 帧
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        scheduler.BeginFrame();
+        if (i >= 2) {
+            REQUIRE(!fence.m_Waits.empty());
+            CHECK(fence.m_Waits.back() == i - 1);
+            CHECK(fence.m_NextValue - fence.m_CompletedValue <= 1);
+        }
+        scheduler.EndFrame(fence.Signal());
+    }
+    CHECK(scheduler.GetWaitStats().m_NumStalls == 14);
+    CHECK(scheduler.GetFrameCount() == 16);
+}
+
+TEST_CASE(FrameScheduler_AllocatesFromWorkerThreads)
+{
+    constexpr std::uint32_t kNumThreads = 8;
+    constexpr std::uint32_t kNumAllocations = 2000;
+
+    SimulatedFence fence{};
+    FrameScheduler scheduler{};
+    FrameSchedulerDesc desc{};
+    desc.m_NumFramesInFlight = 2;
+    desc.m_TransientBufferSize = kNumThreads * kNumAllocations * 64;
+    desc.m_NumTransientDescriptors = kNumThreads * kNumAllocations;
+    scheduler.Create(desc, &fence);
+
+    // 多个线程在同一帧内同时分配，得到的区间互不重叠
+    std::atomic<std::uint32_t> numReleased{};
+    std::vector<std::vector<std::uint64_t>> offsets(kNumThreads);
+    std::vector<std::vector<std::uint32_t>> descriptors(kNumThreads);
+    scheduler.BeginFrame();
+    std::vector<std::thread> workers{};
+    for (std::uint32_t i = 0; i < kNumThreads; ++i) {
+        workers.emplace_back([&, i]() {
+            for (std::uint32_t j = 0; j < kNumAllocations; ++j) {
+                offsets[i].push_back(scheduler.AllocateTransient(40, 64));
+                descriptors[i].push_back(scheduler.AllocateTransientDescriptors(1));
+                scheduler.DeferRelease([&numReleased]() { ++numReleased; });
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    scheduler.EndFrame(fence.Signal());
+
+    std::vector<std::uint64_t> allOffsets{};
+    std::vector<std::uint32_t> allDescriptors{};
+    for (std::uint32_t i = 0; i < kNumThreads; ++i) {
+        allOffsets.insert(allOffsets.end(), offsets[i].begin(), offsets[i].end());
+        allDescriptors.insert(allDescriptors.end(), descriptors[i].begin(), descriptors[i].end());
+    }
+    std::sort(allOffsets.begin(), allOffsets.end());
+    std::sort(allDescriptors.begin(), allDescriptors.end());
+    // 容量恰好够用，所有分配都成功且紧密排列
+    for (std::uint32_t i = 0; i < allOffsets.size(); ++i) {
+        CHECK(allOffsets[i] == i * 64);
+        CHECK(allDescriptors[i] == i);
+    }
+
+    scheduler.Shutdown();
+    CHECK(numReleased == kNumThreads * kNumAllocations);
+}
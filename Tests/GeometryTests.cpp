@@ -0,0 +1,220 @@
+#include "TestFramework.h"
+
+// Geometry 依赖 DirectXMath，只在 Windows 上编译
+#ifdef _WIN32
+#include "../Samples/PBR/Geometry.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace DSM;
+using namespace DSM::Geometry;
+using namespace DirectX;
+
+namespace {
+    // 与 GeometryGenerator::MidPoint 相同的插值
+    Vertex MidPoint(const Vertex& v0, const Vertex& v1)
+    {
+        Vertex ret{};
+        XMStoreFloat3(&ret.m_Position, (XMLoadFloat3(&v0.m_Position) + XMLoadFloat3(&v1.m_Position)) * .5f);
+        XMStoreFloat3(&ret.m_Normal, XMVector3Normalize(XMLoadFloat3(&v0.m_Normal) + XMLoadFloat3(&v1.m_Normal)));
+        XMStoreFloat4(&ret.m_Tangent, XMVector4Normalize(XMLoadFloat4(&v0.m_Tangent) + XMLoadFloat4(&v1.m_Tangent)));
+        XMStoreFloat2(&ret.m_TexCoord, (XMLoadFloat2(&v0.m_TexCoord) + XMLoadFloat2(&v1.m_TexCoord)) * .5f);
+        return ret;
+    }
+
+    // 共享中点之前的细分：每个三角形各自生成 6 个顶点
+    void SubdivideFlat(GeometryMesh& mesh)
+    {
+        GeometryMesh copyMesh = mesh;
+        mesh.m_Vertices.clear();
+        mesh.m_Indices32.clear();
+
+        auto numTriangles = static_cast<std::uint32_t>(copyMesh.m_Indices32.size() / 3);
+        for (std::uint32_t i = 0; i < numTriangles; ++i) {
+            Vertex vs[6]{};
+            for (std::uint32_t j = 0; j < 3; ++j) {
+                vs[j] = copyMesh.m_Vertices[copyMesh.m_Indices32[3 * i + j]];
+            }
+            for (std::uint32_t j = 3; j < 6; ++j) {
+                vs[j] = MidPoint(vs[j - 3], vs[(j - 2) % 3]);
+            }
+            mesh.m_Vertices.insert(mesh.m_Vertices.end(), std::begin(vs), std::end(vs));
+            for (auto index : {0u, 3u, 5u, 3u, 4u, 5u, 5u, 4u, 2u, 3u, 1u, 4u}) {
+                mesh.m_Indices32.push_back(i * 6 + index);
+            }
+        }
+    }
+
+    // 只含位置的正二十面体，与 CreateGeosphere 的初始网格相同
+    GeometryMesh MakeIcosahedron()
+    {
+        const float X = 0.525731f;
+        const float Z = 0.850651f;
+        const XMFLOAT3 positions[12] = {
+            {-X, 0.0f, Z}, {X, 0.0f, Z}, {-X, 0.0f, -Z}, {X, 0.0f, -Z},
+            {0.0f, Z, X}, {0.0f, Z, -X}, {0.0f, -Z, X}, {0.0f, -Z, -X},
+            {Z, X, 0.0f}, {-Z, X, 0.0f}, {Z, -X, 0.0f}, {-Z, -X, 0.0f}};
+        GeometryMesh mesh{};
+        for (const auto& position : positions) {
+            mesh.m_Vertices.emplace_back().m_Position = position;
+        }
+        mesh.m_Indices32 = {
+            1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+            1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+            3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+            10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7};
+        return mesh;
+    }
+
+    // 旧的 Geosphere：平坦细分后投影到球面，接缝处的纹理坐标对误差敏感，只比较位置与法线
+    GeometryMesh CreateFlatGeosphere(float radius, std::uint32_t subdivision)
+    {
+        auto mesh = MakeIcosahedron();
+        for (std::uint32_t i = 0; i < subdivision; ++i) {
+            SubdivideFlat(mesh);
+        }
+        for (auto& vertex : mesh.m_Vertices) {
+            XMVECTOR N = XMVector3Normalize(XMLoadFloat3(&vertex.m_Position));
+            XMStoreFloat3(&vertex.m_Position, radius * N);
+            XMStoreFloat3(&vertex.m_Normal, N);
+
+            float theta = atan2f(vertex.m_Position.z, vertex.m_Position.x);
+            float phi = acosf(vertex.m_Position.y / radius);
+            vertex.m_TexCoord = {theta / XM_2PI, phi / XM_PI};
+            vertex.m_Tangent = {radius * sinf(phi) * -sinf(theta), 0.0f, radius * sinf(phi) * cosf(theta), 1.0f};
+            XMStoreFloat4(&vertex.m_Tangent, XMVector3Normalize(XMLoadFloat4(&vertex.m_Tangent)));
+        }
+        return mesh;
+    }
+
+    GeometryMesh CreateFlatBox(float width, float height, float depth, std::uint32_t subdivision)
+    {
+        auto mesh = GeometryGenerator::CreateBox(width, height, depth, 0);
+        for (std::uint32_t i = 0; i < subdivision; ++i) {
+            SubdivideFlat(mesh);
+        }
+        return mesh;
+    }
+
+    float MaxDiff(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return (std::max)({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+    }
+
+    // 按三角形的顺序逐个比较顶点属性，返回最大的误差
+    float CompareTriangles(const GeometryMesh& mesh, const GeometryMesh& reference, bool compareAll)
+    {
+        if (mesh.m_Indices32.size() != reference.m_Indices32.size()) return INFINITY;
+
+        float maxDiff = 0;
+        for (std::size_t i = 0; i < mesh.m_Indices32.size(); ++i) {
+            const auto& v = mesh.m_Vertices[mesh.m_Indices32[i]];
+            const auto& r = reference.m_Vertices[reference.m_Indices32[i]];
+            maxDiff = (std::max)({maxDiff, MaxDiff(v.m_Position, r.m_Position), MaxDiff(v.m_Normal, r.m_Normal)});
+            if (compareAll) {
+                maxDiff = (std::max)({maxDiff,
+                    MaxDiff({v.m_Tangent.x, v.m_Tangent.y, v.m_Tangent.z}, {r.m_Tangent.x, r.m_Tangent.y, r.m_Tangent.z}),
+                    std::abs(v.m_Tangent.w - r.m_Tangent.w),
+                    MaxDiff({v.m_TexCoord.x, v.m_TexCoord.y, 0}, {r.m_TexCoord.x, r.m_TexCoord.y, 0})});
+            }
+        }
+        return maxDiff;
+    }
+
+    // 每条边恰好被两个三角形共享时网格是封闭的
+    bool IsClosed(const GeometryMesh& mesh)
+    {
+        std::vector<std::uint64_t> edges{};
+        for (std::size_t i = 0; i < mesh.m_Indices32.size(); i += 3) {
+            for (std::size_t j = 0; j < 3; ++j) {
+                std::uint64_t v0 = mesh.m_Indices32[i + j];
+                std::uint64_t v1 = mesh.m_Indices32[i + (j + 1) % 3];
+                edges.push_back((std::min)(v0, v1) << 32 | (std::max)(v0, v1));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (std::size_t i = 0; i < edges.size(); i += 2) {
+            if (i + 1 >= edges.size() || edges[i] != edges[i + 1]) return false;
+            if (i + 2 < edges.size() && edges[i + 2] == edges[i]) return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE(Geometry_SubdivideMatchesFlatTriangles)
+{
+    // 三角形的顺序与绕序不变，只是中点被相邻三角形共享
+    for (std::uint32_t level = 0; level <= 5; ++level) {
+        auto box = GeometryGenerator::CreateBox(1, 2, 3, level);
+        auto flatBox = CreateFlatBox(1, 2, 3, level);
+        CHECK(CompareTriangles(box, flatBox, true) == 0);
+        // 每个面独立细分，(2^L + 1)^2 个顶点
+        std::uint32_t edge = (1u << level) + 1;
+        CHECK(box.m_Vertices.size() == 6 * edge * edge);
+
+        auto sphere = GeometryGenerator::CreateGeosphere(1.5f, level);
+        auto flatSphere = CreateFlatGeosphere(1.5f, level);
+        CHECK(CompareTriangles(sphere, flatSphere, false) < 1e-6f);
+        CHECK(sphere.m_Vertices.size() == 10 * (1u << (2 * level)) + 2);
+        CHECK(IsClosed(sphere));
+        for (const auto& vertex : sphere.m_Vertices) {
+            auto length = std::sqrt(vertex.m_Position.x * vertex.m_Position.x +
+                vertex.m_Position.y * vertex.m_Position.y + vertex.m_Position.z * vertex.m_Position.z);
+            CHECK(std::abs(length - 1.5f) < 1e-5f);
+        }
+    }
+
+    // 细分等级的上限为 8
+    CHECK(GeometryGenerator::CreateGeosphere(1, 9).m_Indices32.size() == 20u * 3 * (1u << 16));
+}
+
+TEST_CASE(Geometry_MergeMeshOffsetsIndices)
+{
+    auto box = GeometryGenerator::CreateBox(1, 1, 1, 1);
+    auto sphere = GeometryGenerator::CreateGeosphere(1, 1);
+    auto merged = GeometryGenerator::MergeMesh(box, sphere);
+    REQUIRE(merged.m_Vertices.size() == box.m_Vertices.size() + sphere.m_Vertices.size());
+    REQUIRE(merged.m_Indices32.size() == box.m_Indices32.size() + sphere.m_Indices32.size());
+
+    auto baseVertex = static_cast<std::uint32_t>(box.m_Vertices.size());
+    for (std::size_t i = 0; i < box.m_Indices32.size(); ++i) {
+        CHECK(merged.m_Indices32[i] == box.m_Indices32[i]);
+    }
+    for (std::size_t i = 0; i < sphere.m_Indices32.size(); ++i) {
+        CHECK(merged.m_Indices32[box.m_Indices32.size() + i] == sphere.m_Indices32[i] + baseVertex);
+    }
+    CHECK(MaxDiff(merged.m_Vertices[baseVertex].m_Position, sphere.m_Vertices[0].m_Position) == 0);
+}
+
+BENCHMARK_CASE(Geometry_SubdivideLevels)
+{
+    for (std::uint32_t level = 6; level <= 8; ++level) {
+        auto label = "level " + std::to_string(level);
+        GeometryMesh mesh{};
+        GeometryMesh flat{};
+
+        // 旧的版本在 8 级时需要约半秒，只执行少量次数
+        auto seconds = Test::MeasureSeconds([&]() { mesh = GeometryGenerator::CreateGeosphere(1, level); }, 0.2, 10);
+        auto flatSeconds = Test::MeasureSeconds([&]() { flat = CreateFlatGeosphere(1, level); }, 0.2, 3);
+        Test::ReportMetric("Geosphere " + label + ", shared", seconds * 1e3, "ms");
+        Test::ReportMetric("Geosphere " + label + ", flat", flatSeconds * 1e3, "ms");
+        Test::ReportMetric("Geosphere " + label + ", vertices shared", double(mesh.m_Vertices.size()), "");
+        Test::ReportMetric("Geosphere " + label + ", vertices flat", double(flat.m_Vertices.size()), "");
+
+        seconds = Test::MeasureSeconds([&]() { mesh = GeometryGenerator::CreateBox(1, 2, 3, level); }, 0.2, 10);
+        flatSeconds = Test::MeasureSeconds([&]() { flat = CreateFlatBox(1, 2, 3, level); }, 0.2, 3);
+        Test::ReportMetric("Box " + label + ", shared", seconds * 1e3, "ms");
+        Test::ReportMetric("Box " + label + ", flat", flatSeconds * 1e3, "ms");
+        Test::ReportMetric("Box " + label + ", vertices shared", double(mesh.m_Vertices.size()), "");
+        Test::ReportMetric("Box " + label + ", vertices flat", double(flat.m_Vertices.size()), "");
+    }
+
+    // 合并两个 8 级的网格
+    auto sphere = GeometryGenerator::CreateGeosphere(1, 8);
+    auto box = GeometryGenerator::CreateBox(1, 2, 3, 8);
+    auto seconds = Test::MeasureSeconds([&]() { GeometryGenerator::MergeMesh(sphere, box); }, 0.2, 20);
+    Test::ReportMetric("MergeMesh, level 8 geosphere + box", seconds * 1e3, "ms");
+}
+#endif
@@ -0,0 +1,107 @@
+#include "TestFramework.h"
+#include "Graphics/GpuProfiler.h"
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 合成的时间戳，队列 0 以纳秒计数，队列 1 以微秒计数
+    class SyntheticTimestampSource : public IGpuTimestampSource
+    {
+    public:
+        GpuClockCalibration GetClockCalibration(std::uint32_t queue) override
+        {
+            m_CalibratedQueues.push_back(queue);
+            if (queue == 0) return {1000, 5000, 1000000000};
+            if (queue == 1) return {10, 5000, 1000000};
+            return {};
+        }
+        bool ReadTimestamps(std::uint32_t firstQuery, std::uint32_t numQueries, std::uint64_t* timestamps) override
+        {
+            if (firstQuery + numQueries > m_Timestamps.size()) return false;
+            for (std::uint32_t i = 0; i < numQueries; ++i) {
+                timestamps[i] = m_Timestamps[firstQuery + i];
+            }
+            return true;
+        }
+
+        std::vector<std::uint64_t> m_Timestamps{};
+        std::vector<std::uint32_t> m_CalibratedQueues{};
+    };
+}
+
+TEST_CASE(GpuProfiler_EndFrameSkipsUnwrittenQueries)
+{
+    SyntheticTimestampSource source{};
+    GpuProfiler profiler{};
+    profiler.Create(&source, 2, 16);
+
+    profiler.BeginFrame(1);
+    auto a = profiler.BeginRange("A", 0);
+    auto b = profiler.BeginRange("B", 1, 1);
+    profiler.EndRange(b);
+    // A 没有结束，其结束查询从未写入
+    auto c = profiler.BeginRange("C", 0);
+    profiler.EndRange(c);
+    CHECK(a == 16);
+    CHECK(b == 18);
+    CHECK(c == 20);
+
+    auto batches = profiler.EndFrame();
+    REQUIRE(batches.size() == 2);
+    CHECK(batches[0].m_FirstQuery == 16);
+    CHECK(batches[0].m_NumQueries == 1);
+    CHECK(batches[1].m_FirstQuery == 18);
+    CHECK(batches[1].m_NumQueries == 4);
+
+    // 帧外不记录区间，也没有需要解析的查询
+    CHECK(profiler.BeginRange("D", 0) == GpuProfiler::sm_InvalidQuery);
+    CHECK(profiler.EndFrame().empty());
+}
+
+TEST_CASE(GpuProfiler_ResolveUsesCalibrationOfOwningQueue)
+{
+    GpuClockCalibration calibrations[] = {{1000, 5000, 1000000000}, {10, 5000, 1000000}};
+    std::uint64_t timestamps[] = {2000, 3000, 11, 12, 7, 9};
+    GpuTimestampRange ranges[] = {
+        {"Graphics", 100, 101, 0, 0},
+        {"Compute", 102, 103, 0, 1},
+        // 没有对应校准的队列被跳过
+        {"Copy", 104, 105, 0, 2},
+    };
+
+    std::vector<ProfileEvent> events{};
+    GpuProfiler::ResolveRanges(timestamps, ranges, 100, calibrations, 3, events);
+    REQUIRE(events.size() == 2);
+    CHECK(events[0].m_BeginTime == 6000 && events[0].m_EndTime == 7000);
+    CHECK(events[1].m_BeginTime == 6000 && events[1].m_EndTime == 7000);
+    CHECK(events[1].m_ThreadIndex == 3);
+}
+
+TEST_CASE(GpuProfiler_ResolvesFrameWhenSlotIsReused)
+{
+    SyntheticTimestampSource source{};
+    source.m_Timestamps = {2000, 4000, 11, 14, 0, 0, 0, 0};
+    GpuProfiler profiler{};
+    profiler.Create(&source, 2, 4);
+
+    profiler.BeginFrame(0);
+    profiler.EndRange(profiler.BeginRange("Scene", 0));
+    profiler.EndRange(profiler.BeginRange("Culling", 0, 1));
+    // 查询用尽
+    CHECK(profiler.BeginRange("Overflow", 0) == GpuProfiler::sm_InvalidQuery);
+    profiler.EndFrame();
+    profiler.BeginFrame(1);
+    profiler.EndFrame();
+    CHECK(source.m_CalibratedQueues.empty());
+
+    // 复用槽位 0 时解析上一轮的结果，两个队列各校准一次，计算队列的区间换算后为 [6000, 9000]
+    profiler.BeginFrame(0);
+    const auto& stats = profiler.GetLastFrameStats();
+    CHECK(stats.m_NumRanges == 2);
+    CHECK(stats.m_GpuTime > 0.0029 && stats.m_GpuTime < 0.0031);
+    REQUIRE(source.m_CalibratedQueues.size() == 2);
+    CHECK(source.m_CalibratedQueues[0] == 0);
+    CHECK(source.m_CalibratedQueues[1] == 1);
+    profiler.EndFrame();
+}
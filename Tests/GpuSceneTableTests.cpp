@@ -0,0 +1,192 @@
+#include "TestFramework.h"
+#include "Renderer/GpuSceneTable.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    struct InstanceRow
+    {
+        float m_World[12]{};
+        std::uint32_t m_Material{};
+        std::uint32_t m_Mesh{};
+        std::uint32_t m_Padding[2]{};
+    };
+
+    InstanceRow MakeRow(std::uint32_t seed)
+    {
+        InstanceRow row{};
+        for (int i = 0; i < 12; ++i) row.m_World[i] = float(seed * 13 + i);
+        row.m_Material = seed % 7;
+        row.m_Mesh = seed % 5;
+        return row;
+    }
+
+    // 模拟 GPU 上的表，按分散列表写入打包的行
+    void ApplyScatter(const GpuSceneTable& table, std::vector<std::byte>& gpu)
+    {
+        std::vector<std::byte> upload(table.GetScatterDataSize());
+        table.WriteScatterData(upload.data());
+        gpu.resize(std::size_t(table.GetNumRows()) * table.GetRowSize());
+
+        auto rows = table.GetScatterRows();
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            std::memcpy(gpu.data() + std::size_t(rows[i]) * table.GetRowSize(), upload.data() + i * table.GetRowSize(), table.GetRowSize());
+        }
+    }
+
+    bool MatchesGpu(const GpuSceneTable& table, const std::vector<std::byte>& gpu)
+    {
+        return gpu.size() == std::size_t(table.GetNumRows()) * table.GetRowSize() &&
+            std::memcmp(gpu.data(), table.GetRow(0), gpu.size()) == 0;
+    }
+}
+
+TEST_CASE(GpuSceneTable_AllocateAndReuseRows)
+{
+    GpuSceneTable table{sizeof(InstanceRow)};
+    CHECK(table.Allocate() == 0);
+    CHECK(table.Allocate() == 1);
+    CHECK(table.Allocate() == 2);
+    table.Free(1);
+    CHECK(table.GetNumAllocated() == 2);
+    CHECK(table.Allocate() == 1);
+    CHECK(table.Allocate() == 3);
+    CHECK(table.GetNumRows() == 4);
+    CHECK(table.GetNumAllocated() == 4);
+}
+
+TEST_CASE(GpuSceneTable_OnlyChangedRowsAreDirty)
+{
+    GpuSceneTable table{sizeof(InstanceRow)};
+    for (int i = 0; i < 8; ++i) table.Allocate();
+
+    CHECK(table.Write(2, MakeRow(2)));
+    CHECK(table.Write(5, MakeRow(5)));
+    // 相同的数据不会标记为脏
+    CHECK(!table.Write(5, MakeRow(5)));
+    CHECK(table.GetNumDirty() == 2);
+    CHECK(table.GetStats().m_NumWrites == 3);
+    CHECK(table.GetStats().m_NumUnchanged == 1);
+
+    table.BuildScatterList();
+    auto ranges = table.GetScatterRanges();
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].m_DestRow == 2);
+    CHECK(ranges[0].m_SrcRow == 0);
+    CHECK(ranges[1].m_DestRow == 5);
+    CHECK(ranges[1].m_SrcRow == 1);
+    CHECK(table.GetScatterDataSize() == 2 * sizeof(InstanceRow));
+    CHECK(table.GetNumDirty() == 0);
+
+    std::vector<std::byte> upload(table.GetScatterDataSize());
+    table.WriteScatterData(upload.data());
+    auto row5 = MakeRow(5);
+    CHECK(std::memcmp(upload.data() + sizeof(InstanceRow), &row5, sizeof(row5)) == 0);
+
+    // 没有改变时列表为空
+    table.BuildScatterList();
+    CHECK(table.GetScatterRanges().empty());
+    CHECK(table.GetScatterDataSize() == 0);
+
+    table.MarkDirty(7);
+    table.MarkDirty(7);
+    CHECK(table.GetNumDirty() == 1);
+    table.BuildScatterList();
+    CHECK(table.GetScatterRows().size() == 1);
+    CHECK(table.GetStats().m_NumUploadedRows == 3);
+}
+
+TEST_CASE(GpuSceneTable_MergesRangesWithinGap)
+{
+    GpuSceneTable table{16};
+    for (int i = 0; i < 200; ++i) table.Allocate();
+    for (std::uint32_t row : {3u, 4u, 6u, 63u, 64u, 65u, 130u}) table.MarkDirty(row);
+
+    table.BuildScatterList(1);
+    auto ranges = table.GetScatterRanges();
+    REQUIRE(ranges.size() == 3);
+    CHECK(ranges[0].m_DestRow == 3);
+    CHECK(ranges[0].m_NumRows == 4);
+    // 跨越 64 位掩码的边界也能合并
+    CHECK(ranges[1].m_DestRow == 63);
+    CHECK(ranges[1].m_NumRows == 3);
+    CHECK(ranges[1].m_SrcRow == 4);
+    CHECK(ranges[2].m_DestRow == 130);
+    CHECK(table.GetScatterRows().size() == 8);
+}
+
+TEST_CASE(GpuSceneTable_GpuCopyStaysInSync)
+{
+    GpuSceneTable table{sizeof(InstanceRow)};
+    std::vector<std::byte> gpu{};
+    std::vector<std::uint32_t> live{};
+    std::mt19937 rng{11};
+
+    for (int frame = 0; frame < 50; ++frame) {
+        // 新增、删除与修改混合，新分配的行标记为脏
+        for (int i = 0; i < 20; ++i) {
+            auto row = table.Allocate();
+            table.MarkDirty(row);
+            table.Write(row, MakeRow(rng() % 1000));
+            live.push_back(row);
+        }
+        for (int i = 0; i < 5 && !live.empty(); ++i) {
+            auto index = rng() % live.size();
+            table.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        for (int i = 0; i < 30; ++i) {
+            table.Write(live[rng() % live.size()], MakeRow(rng() % 1000));
+        }
+
+        table.BuildScatterList(frame % 4);
+        ApplyScatter(table, gpu);
+        if (!MatchesGpu(table, gpu)) {
+            std::printf("  frame %d\n", frame);
+            CHECK(false);
+            break;
+        }
+    }
+}
+
+BENCHMARK_CASE(GpuSceneTable_DeltaUpload)
+{
+    constexpr std::uint32_t kNumInstances = 1000000;
+    constexpr std::uint32_t kChurn = kNumInstances / 100;
+
+    GpuSceneTable table{sizeof(InstanceRow)};
+    std::vector<std::byte> gpu{};
+    for (std::uint32_t i = 0; i < kNumInstances; ++i) {
+        table.Write(table.Allocate(), MakeRow(i));
+    }
+    table.BuildScatterList();
+    ApplyScatter(table, gpu);
+
+    std::mt19937 rng{1};
+    std::vector<std::uint32_t> changed(kChurn);
+    std::uint32_t frame = 0;
+    for (auto maxGap : {0u, 8u}) {
+        auto seconds = Test::MeasureSeconds([&]() {
+            ++frame;
+            for (auto& row : changed) row = rng() % kNumInstances;
+            for (auto row : changed) table.Write(row, MakeRow(row + frame * kNumInstances));
+            table.BuildScatterList(maxGap);
+            ApplyScatter(table, gpu);
+        });
+
+        auto label = "1M instances, 1% churn, max gap " + std::to_string(maxGap);
+        // 包含打包上传数据与模拟的分散写入
+        Test::ReportMetric(label + ", update", seconds * 1e3, "ms");
+        Test::ReportMetric(label + ", copy ranges", double(table.GetScatterRanges().size()), "");
+        Test::ReportMetric(label + ", upload", table.GetScatterDataSize() / 1e6, "MB");
+    }
+    Test::ReportMetric("Full table upload", double(table.GetNumRows()) * table.GetRowSize() / 1e6, "MB");
+
+    CHECK(MatchesGpu(table, gpu));
+}
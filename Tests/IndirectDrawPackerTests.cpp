@@ -0,0 +1,112 @@
+#include "TestFramework.h"
+#include "Renderer/IndirectDrawPacker.h"
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    IndirectDrawIndexedArgs MakeArgs(std::uint32_t draw)
+    {
+        return {36 + draw, 1, draw * 100, -static_cast<std::int32_t>(draw), draw};
+    }
+
+    bool SameRecord(const IndirectDrawRecord& record, std::uint64_t rootAddress, const IndirectDrawIndexedArgs& args)
+    {
+        return record.m_RootAddress == rootAddress &&
+            record.m_Args.m_IndexCountPerInstance == args.m_IndexCountPerInstance &&
+            record.m_Args.m_InstanceCount == args.m_InstanceCount &&
+            record.m_Args.m_StartIndexLocation == args.m_StartIndexLocation &&
+            record.m_Args.m_BaseVertexLocation == args.m_BaseVertexLocation &&
+            record.m_Args.m_StartInstanceLocation == args.m_StartInstanceLocation;
+    }
+}
+
+TEST_CASE(IndirectDrawPacker_RecordLayout)
+{
+    // 命令签名先是根 CBV 的 GPU 地址，之后紧跟 D3D12_DRAW_INDEXED_ARGUMENTS
+    CHECK(offsetof(IndirectDrawRecord, m_RootAddress) == 0);
+    CHECK(offsetof(IndirectDrawRecord, m_Args) == 8);
+    CHECK(sizeof(IndirectDrawIndexedArgs) == 20);
+    CHECK(IndirectDrawPacker::sm_RecordStride == 32);
+}
+
+TEST_CASE(IndirectDrawPacker_BucketsKeepAddOrder)
+{
+    IndirectDrawPacker packer{};
+    // PSO、网格、材质
+    IndirectBucketKey opaqueA{0, 1, 10};
+    IndirectBucketKey opaqueB{0, 2, 10};
+    IndirectBucketKey masked{1, 1, 11};
+
+    packer.Add(0, opaqueA, 0x1000, MakeArgs(0));
+    packer.Add(1, masked, 0x1100, MakeArgs(1));
+    packer.Add(2, opaqueA, 0x1200, MakeArgs(2));
+    packer.Add(3, opaqueB, 0x1300, MakeArgs(3));
+    // 不能合并的绘制即使状态相同也单独成为一个桶
+    packer.Add(4, opaqueA, 0x1400, MakeArgs(4), false);
+    packer.Add(5, masked, 0x1500, MakeArgs(5));
+    packer.Build();
+    CHECK(packer.GetNumDraws() == 6);
+
+    auto buckets = packer.GetBuckets();
+    auto records = packer.GetRecords();
+    REQUIRE(buckets.size() == 4);
+    REQUIRE(records.size() == 6);
+
+    CHECK(buckets[0].m_FirstRecord == 0);
+    CHECK(buckets[0].m_NumRecords == 2);
+    CHECK(buckets[0].m_Draw == 0);
+    CHECK(buckets[1].m_FirstRecord == 2);
+    CHECK(buckets[1].m_NumRecords == 2);
+    CHECK(buckets[1].m_PSOIndex == 1);
+    CHECK(buckets[1].m_Draw == 1);
+    CHECK(buckets[2].m_Draw == 3);
+    CHECK(buckets[3].m_Draw == 4);
+    CHECK(buckets[3].m_NumRecords == 1);
+
+    std::uint32_t expectedDraws[] = {0, 2, 1, 5, 3, 4};
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        auto draw = expectedDraws[i];
+        CHECK(SameRecord(records[i], 0x1000 + draw * 0x100, MakeArgs(draw)));
+    }
+
+    // 重复 Build 的结果相同
+    packer.Build();
+    CHECK(packer.GetBuckets()[1].m_FirstRecord == 2);
+    CHECK(SameRecord(packer.GetRecords()[3], 0x1500, MakeArgs(5)));
+
+    packer.Clear();
+    packer.Build();
+    CHECK(packer.GetBuckets().empty());
+    CHECK(packer.GetRecords().empty());
+}
+
+BENCHMARK_CASE(IndirectDrawPacker_PackThroughput)
+{
+    std::mt19937 rng{4};
+    IndirectDrawPacker packer{};
+    for (auto [numDraws, numMeshes] : {std::pair{10000u, 64u}, std::pair{200000u, 512u}}) {
+        std::vector<IndirectBucketKey> keys(numDraws);
+        for (auto& key : keys) {
+            auto mesh = static_cast<std::uint32_t>(rng() % numMeshes);
+            key = {mesh % 4, mesh, mesh % 32};
+        }
+
+        auto seconds = Test::MeasureSeconds([&]() {
+            packer.Clear();
+            for (std::uint32_t i = 0; i < numDraws; ++i) {
+                packer.Add(i, keys[i], 0x10000 + std::uint64_t(i) * 256, MakeArgs(i));
+            }
+            packer.Build();
+        });
+        CHECK(packer.GetRecords().size() == numDraws);
+
+        auto label = std::to_string(numDraws) + " draws";
+        Test::ReportMetric(label + ", ExecuteIndirect calls", double(packer.GetBuckets().size()), "");
+        Test::ReportMetric(label + ", packing", numDraws / seconds / 1e6, "M draws/s");
+        Test::ReportMetric(label + ", argument data", numDraws * double(IndirectDrawPacker::sm_RecordStride) / seconds / 1e6, "MB/s");
+    }
+}
@@ -0,0 +1,167 @@
+#include "TestFramework.h"
+#include "Renderer/InstanceBatcher.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    struct SceneDraw
+    {
+        InstanceKey m_Key{};
+        float m_Distance{};
+        bool m_Instancing = true;
+    };
+
+    // numModels 个模型各重复 numCopies 次，每个模型有若干子网格
+    std::vector<SceneDraw> MakeRepeatedScene(std::uint32_t numModels, std::uint32_t numCopies, std::uint32_t subMeshes, std::uint32_t seed)
+    {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> distance{1.0f, 500.0f};
+        std::vector<SceneDraw> draws{};
+        draws.reserve(std::size_t(numModels) * numCopies * subMeshes);
+        for (std::uint32_t copy = 0; copy < numCopies; ++copy) {
+            for (std::uint32_t model = 0; model < numModels; ++model) {
+                auto d = distance(rng);
+                for (std::uint32_t sub = 0; sub < subMeshes; ++sub) {
+                    InstanceKey key{model, sub, model * 4 + sub % 4, (model + sub) % 3};
+                    draws.push_back({key, d, true});
+                }
+            }
+        }
+        return draws;
+    }
+
+    // 检查批次覆盖了所有绘制、批次内的绘制可以合并且排序满足约定
+    bool IsValidBatching(const InstanceBatcher& batcher, const std::vector<SceneDraw>& draws)
+    {
+        auto batches = batcher.GetBatches();
+        auto order = batcher.GetInstanceOrder();
+        if (order.size() != draws.size()) return false;
+
+        std::vector<bool> seen(draws.size(), false);
+        std::uint32_t expectedFirst = 0;
+        for (std::size_t b = 0; b < batches.size(); ++b) {
+            const auto& batch = batches[b];
+            if (batch.m_FirstInstance != expectedFirst || batch.m_NumInstances == 0) return false;
+            expectedFirst += batch.m_NumInstances;
+            if (b > 0) {
+                const auto& prev = batches[b - 1];
+                if (prev.m_PSOIndex > batch.m_PSOIndex) return false;
+                if (prev.m_PSOIndex == batch.m_PSOIndex &&
+                    draws[order[prev.m_FirstInstance]].m_Distance > draws[order[batch.m_FirstInstance]].m_Distance) return false;
+            }
+
+            const auto& first = draws[order[batch.m_FirstInstance]];
+            if (first.m_Key.m_PSOIndex != batch.m_PSOIndex) return false;
+            if (!first.m_Instancing && batch.m_NumInstances != 1) return false;
+            for (auto i = batch.m_FirstInstance; i < batch.m_FirstInstance + batch.m_NumInstances; ++i) {
+                if (seen[order[i]]) return false;
+                seen[order[i]] = true;
+                const auto& draw = draws[order[i]];
+                if (!(draw.m_Key == first.m_Key) || !draw.m_Instancing) {
+                    if (batch.m_NumInstances != 1) return false;
+                }
+                if (i > batch.m_FirstInstance && draws[order[i - 1]].m_Distance > draw.m_Distance) return false;
+            }
+        }
+        return expectedFirst == draws.size();
+    }
+}
+
+TEST_CASE(InstanceBatcher_MergesIdenticalDraws)
+{
+    std::vector<SceneDraw> draws{
+        {{1, 0, 10, 0}, 30.0f},
+        {{2, 0, 20, 1}, 5.0f},
+        {{1, 0, 10, 0}, 10.0f},
+        // 材质不同不能合并
+        {{1, 0, 11, 0}, 20.0f},
+        {{1, 0, 10, 0}, 50.0f},
+        // 半透明单独绘制
+        {{2, 0, 20, 1}, 1.0f, false},
+        {{2, 0, 20, 1}, 7.0f},
+    };
+
+    InstanceBatcher batcher{};
+    for (std::uint32_t i = 0; i < draws.size(); ++i) {
+        batcher.Add(i, draws[i].m_Key, draws[i].m_Distance, draws[i].m_Instancing);
+    }
+    batcher.Build();
+    CHECK(batcher.GetNumDraws() == draws.size());
+    CHECK(IsValidBatching(batcher, draws));
+
+    auto batches = batcher.GetBatches();
+    REQUIRE(batches.size() == 4);
+    CHECK(batches[0].m_PSOIndex == 0);
+    CHECK(batches[0].m_NumInstances == 3);
+    CHECK(batches[1].m_NumInstances == 1);
+    CHECK(batches[2].m_PSOIndex == 1);
+    CHECK(batches[2].m_NumInstances == 1);
+    CHECK(batches[3].m_NumInstances == 2);
+
+    std::vector<std::uint32_t> order(batcher.GetInstanceOrder().begin(), batcher.GetInstanceOrder().end());
+    CHECK(order == std::vector<std::uint32_t>({2, 0, 4, 3, 5, 1, 6}));
+}
+
+TEST_CASE(InstanceBatcher_ClearAndReuse)
+{
+    InstanceBatcher batcher{};
+    batcher.Add(0, {1, 0, 0, 0}, 1.0f);
+    batcher.Add(1, {1, 0, 0, 0}, 2.0f);
+    batcher.Build();
+    CHECK(batcher.GetBatches().size() == 1);
+
+    batcher.Clear();
+    CHECK(batcher.GetNumDraws() == 0);
+    batcher.Build();
+    CHECK(batcher.GetBatches().empty());
+    CHECK(batcher.GetInstanceOrder().empty());
+
+    batcher.Add(7, {3, 1, 0, 2}, 4.0f);
+    batcher.Build();
+    REQUIRE(batcher.GetBatches().size() == 1);
+    CHECK(batcher.GetBatches()[0].m_PSOIndex == 2);
+    CHECK(batcher.GetInstanceOrder()[0] == 7);
+}
+
+TEST_CASE(InstanceBatcher_RepeatedScene)
+{
+    auto draws = MakeRepeatedScene(20, 50, 3, 5);
+    // 随机把一部分绘制标记为不能合并
+    std::mt19937 rng{9};
+    for (auto& draw : draws) draw.m_Instancing = rng() % 10 != 0;
+
+    InstanceBatcher batcher{};
+    for (std::uint32_t i = 0; i < draws.size(); ++i) {
+        batcher.Add(i, draws[i].m_Key, draws[i].m_Distance, draws[i].m_Instancing);
+    }
+    batcher.Build();
+    CHECK(IsValidBatching(batcher, draws));
+
+    auto numSingle = std::count_if(draws.begin(), draws.end(), [](const SceneDraw& draw) { return !draw.m_Instancing; });
+    CHECK(batcher.GetBatches().size() == 20 * 3 + std::size_t(numSingle));
+}
+
+BENCHMARK_CASE(InstanceBatcher_RepeatedObjects)
+{
+    InstanceBatcher batcher{};
+    for (auto [numModels, numCopies] : {std::pair{10u, 100u}, std::pair{100u, 1000u}}) {
+        auto draws = MakeRepeatedScene(numModels, numCopies, 4, 1);
+        auto seconds = Test::MeasureSeconds([&]() {
+            batcher.Clear();
+            for (std::uint32_t i = 0; i < draws.size(); ++i) {
+                batcher.Add(i, draws[i].m_Key, draws[i].m_Distance);
+            }
+            batcher.Build();
+        });
+        CHECK(IsValidBatching(batcher, draws));
+
+        auto label = std::to_string(numModels) + " models x " + std::to_string(numCopies);
+        Test::ReportMetric(label + ", draws", double(draws.size()), "");
+        Test::ReportMetric(label + ", instanced draws", double(batcher.GetBatches().size()), "");
+        Test::ReportMetric(label + ", batching", draws.size() / seconds / 1e6, "M draws/s");
+    }
+}
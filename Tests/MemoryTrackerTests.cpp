@@ -0,0 +1,203 @@
+#include "TestFramework.h"
+#include "Core/MemoryTracker.h"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 单例之外的独立实例，避免测试之间相互影响
+    class LocalMemoryTracker : public MemoryTracker
+    {
+    public:
+        LocalMemoryTracker() = default;
+    };
+
+    constexpr std::uint64_t kMiB = 1024 * 1024;
+}
+
+TEST_CASE(MemoryTracker_CurrentAndPeakPerCategory)
+{
+    LocalMemoryTracker tracker{};
+    CHECK(tracker.RecordAllocation(MemoryCategory::kTexture, 0) == MemoryTracker::sm_InvalidAllocation);
+
+    auto albedo = tracker.RecordAllocation(MemoryCategory::kTexture, 8 * kMiB, "Albedo");
+    auto normal = tracker.RecordAllocation(MemoryCategory::kTexture, 4 * kMiB, "Normal");
+    auto page = tracker.RecordAllocation(MemoryCategory::kUploadPage, 2 * kMiB, "UploadPage");
+    CHECK(tracker.GetTotalBytes() == 14 * kMiB);
+
+    tracker.RecordFree(albedo);
+    // 重复释放与无效 id 都会被忽略
+    tracker.RecordFree(albedo);
+    tracker.RecordFree(MemoryTracker::sm_InvalidAllocation);
+
+    auto textures = tracker.GetCategoryStats(MemoryCategory::kTexture);
+    CHECK(textures.m_CurrentBytes == 4 * kMiB);
+    CHECK(textures.m_PeakBytes == 12 * kMiB);
+    CHECK(textures.m_NumAllocations == 1);
+    CHECK(textures.m_TotalAllocations == 2);
+    CHECK(tracker.GetCategoryStats(MemoryCategory::kUploadPage).m_CurrentBytes == 2 * kMiB);
+    CHECK(tracker.GetCategoryStats(MemoryCategory::kMesh).m_PeakBytes == 0);
+    CHECK(tracker.GetTotalBytes() == 6 * kMiB);
+    CHECK(tracker.GetPeakTotalBytes() == 14 * kMiB);
+
+    auto allocations = tracker.GetAllocations();
+    REQUIRE(allocations.size() == 2);
+    CHECK(allocations[0].m_Id == normal);
+    CHECK(allocations[0].m_Name == "Normal");
+    CHECK(allocations[1].m_Id == page);
+
+    tracker.RecordFree(normal);
+    tracker.RecordFree(page);
+    CHECK(tracker.GetTotalBytes() == 0);
+    CHECK(tracker.GetPeakTotalBytes() == 14 * kMiB);
+}
+
+TEST_CASE(MemoryTracker_EvaluateBudget)
+{
+    auto none = MemoryTracker::EvaluateBudget(100, 0, 0.9f);
+    CHECK(none.m_Pressure == MemoryPressure::kNone);
+    CHECK(none.m_ExcessBytes == 0);
+
+    CHECK(MemoryTracker::EvaluateBudget(900, 1000, 0.9f).m_Pressure == MemoryPressure::kNone);
+
+    auto warning = MemoryTracker::EvaluateBudget(950, 1000, 0.9f);
+    CHECK(warning.m_Pressure == MemoryPressure::kWarning);
+    CHECK(warning.m_ExcessBytes == 50);
+
+    auto critical = MemoryTracker::EvaluateBudget(1200, 1000, 0.9f);
+    CHECK(critical.m_Pressure == MemoryPressure::kCritical);
+    CHECK(critical.m_ExcessBytes == 300);
+}
+
+TEST_CASE(MemoryTracker_BudgetTakesSmallerOfUserAndDevice)
+{
+    LocalMemoryTracker tracker{};
+    CHECK(tracker.GetBudget() == 0);
+    tracker.SetDeviceBudget(512 * kMiB);
+    CHECK(tracker.GetBudget() == 512 * kMiB);
+    tracker.SetBudget(256 * kMiB);
+    CHECK(tracker.GetBudget() == 256 * kMiB);
+    tracker.SetBudget(1024 * kMiB);
+    CHECK(tracker.GetBudget() == 512 * kMiB);
+}
+
+TEST_CASE(MemoryTracker_PressureCallbacks)
+{
+    LocalMemoryTracker tracker{};
+    tracker.SetBudget(100 * kMiB);
+    tracker.SetCategoryBudget(MemoryCategory::kTexture, 40 * kMiB);
+    // 0.75 能被浮点精确表示
+    tracker.SetWarningRatio(0.75f);
+
+    std::vector<MemoryBudgetStatus> received{};
+    auto handle = tracker.AddPressureCallback([&](const MemoryBudgetStatus& status) { received.push_back(status); });
+
+    auto mesh = tracker.RecordAllocation(MemoryCategory::kMesh, 30 * kMiB);
+    CHECK(tracker.Update().m_Pressure == MemoryPressure::kNone);
+    CHECK(received.empty());
+
+    // 纹理超过类别预算，总量进入警告
+    auto texture = tracker.RecordAllocation(MemoryCategory::kTexture, 62 * kMiB);
+    auto status = tracker.Update();
+    CHECK(status.m_Pressure == MemoryPressure::kWarning);
+    CHECK(status.m_ExcessBytes == 17 * kMiB);
+    REQUIRE(received.size() == 2);
+    CHECK(received[0].m_Category == MemoryCategory::kTexture);
+    CHECK(received[0].m_Pressure == MemoryPressure::kCritical);
+    CHECK(received[1].m_Category == MemoryCategory::kNumCategories);
+    CHECK(received[1].m_Pressure == MemoryPressure::kWarning);
+
+    // 压力持续时每次 Update 都会通知
+    received.clear();
+    tracker.Update();
+    CHECK(received.size() == 2);
+
+    // 解除时再通知一次，之后不再通知
+    received.clear();
+    tracker.RecordFree(texture);
+    tracker.Update();
+    REQUIRE(received.size() == 2);
+    CHECK(received[0].m_Pressure == MemoryPressure::kNone);
+    CHECK(received[1].m_Pressure == MemoryPressure::kNone);
+    received.clear();
+    tracker.Update();
+    CHECK(received.empty());
+
+    tracker.RemovePressureCallback(handle);
+    tracker.RecordAllocation(MemoryCategory::kTexture, 200 * kMiB);
+    CHECK(tracker.Update().m_Pressure == MemoryPressure::kCritical);
+    CHECK(received.empty());
+    CHECK(tracker.GetLastStatus().m_Pressure == MemoryPressure::kCritical);
+    tracker.RecordFree(mesh);
+}
+
+TEST_CASE(MemoryTracker_CallbackCanFreeMemory)
+{
+    LocalMemoryTracker tracker{};
+    tracker.SetBudget(10 * kMiB);
+
+    // 模拟分配器在压力下裁剪缓存的页
+    std::vector<std::uint64_t> cachedPages{};
+    for (int i = 0; i < 8; ++i) {
+        cachedPages.push_back(tracker.RecordAllocation(MemoryCategory::kUploadPage, 2 * kMiB, "Page"));
+    }
+    tracker.AddPressureCallback([&](const MemoryBudgetStatus& status) {
+        if (status.m_Category != MemoryCategory::kNumCategories) return;
+        std::uint64_t released = 0;
+        while (released < status.m_ExcessBytes && !cachedPages.empty()) {
+            tracker.RecordFree(cachedPages.back());
+            cachedPages.pop_back();
+            released += 2 * kMiB;
+        }
+    });
+
+    CHECK(tracker.Update().m_Pressure == MemoryPressure::kCritical);
+    CHECK(tracker.GetTotalBytes() <= 9 * kMiB);
+    CHECK(tracker.Update().m_Pressure == MemoryPressure::kNone);
+}
+
+TEST_CASE(MemoryTracker_Export)
+{
+    LocalMemoryTracker tracker{};
+    tracker.RecordAllocation(MemoryCategory::kRayTracing, 3 * kMiB, "BLAS \"Sponza\"");
+    tracker.RecordAllocation(MemoryCategory::kDescriptor, 64 * 1024, "CBV_SRV_UAV");
+
+    std::ostringstream json{};
+    tracker.ExportJson(json);
+    CHECK(json.str().find("\"totalBytes\":3211264") != std::string::npos);
+    CHECK(json.str().find("{\"name\":\"RayTracing\",\"currentBytes\":3145728") != std::string::npos);
+    CHECK(json.str().find("\"name\":\"BLAS \\\"Sponza\\\"\"") != std::string::npos);
+
+    std::ostringstream csv{};
+    tracker.ExportCsv(csv);
+    CHECK(csv.str() == "Name,Category,Size\n\"BLAS \"\"Sponza\"\"\",RayTracing,3145728\n\"CBV_SRV_UAV\",Descriptor,65536\n");
+}
+
+BENCHMARK_CASE(MemoryTracker_RecordThroughput)
+{
+    constexpr int kNumAllocations = 100000;
+    std::vector<std::uint32_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+
+    for (auto threads : threadCounts) {
+        LocalMemoryTracker tracker{};
+        auto seconds = Test::MeasureSeconds([&]() {
+            std::vector<std::thread> workers{};
+            for (std::uint32_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&tracker, threads]() {
+                    std::vector<std::uint64_t> ids(kNumAllocations / threads);
+                    for (std::size_t i = 0; i < ids.size(); ++i) {
+                        ids[i] = tracker.RecordAllocation(static_cast<MemoryCategory>(i % 8), 256 + i);
+                    }
+                    for (auto id : ids) tracker.RecordFree(id);
+                });
+            }
+            for (auto& worker : workers) worker.join();
+        });
+        Test::ReportMetric("Allocate + free, " + std::to_string(threads) + " thread(s)", kNumAllocations / seconds / 1e6, "M/s");
+        CHECK(tracker.GetTotalBytes() == 0);
+    }
+}
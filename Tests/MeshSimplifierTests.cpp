@@ -0,0 +1,521 @@
+#include "TestFramework.h"
+#include "Renderer/MeshSimplifier.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 交错排列的顶点，法线与纹理坐标作为属性
+    struct Vertex
+    {
+        float m_Position[3]{};
+        float m_Normal[3]{};
+        float m_UV[2]{};
+    };
+
+    struct TestMesh
+    {
+        std::vector<Vertex> m_Vertices{};
+        std::vector<std::uint32_t> m_Indices{};
+        std::vector<std::uint32_t> m_SubMeshIndexCounts{};
+
+        MeshSimplifierInput GetInput() const
+        {
+            MeshSimplifierInput input{};
+            input.m_Positions = m_Vertices.data();
+            input.m_PositionStride = sizeof(Vertex);
+            input.m_NumVertices = static_cast<std::uint32_t>(m_Vertices.size());
+            input.m_Attributes = m_Vertices.data()->m_Normal;
+            input.m_AttributeStride = sizeof(Vertex);
+            input.m_NumAttributes = 5;
+            input.m_Indices = m_Indices.data();
+            input.m_NumIndices = static_cast<std::uint32_t>(m_Indices.size());
+            input.m_SubMeshIndexCounts = m_SubMeshIndexCounts;
+            return input;
+        }
+
+        std::uint32_t GetNumTriangles() const { return static_cast<std::uint32_t>(m_Indices.size() / 3); }
+    };
+
+    // 经纬度球，u = 0 与 u = 1 的一列顶点位置相同，为 UV 接缝，两极每一段有单独的顶点
+    TestMesh MakeSphere(std::uint32_t rings, std::uint32_t segments, float radius)
+    {
+        TestMesh mesh{};
+        for (std::uint32_t r = 0; r <= rings; ++r) {
+            float theta = 3.14159265f * r / rings;
+            for (std::uint32_t s = 0; s <= segments; ++s) {
+                // 与 sin(2π) 的舍入无关，接缝两侧的位置完全相同
+                float phi = 6.2831853f * (s % segments) / segments;
+                Vertex vertex{};
+                float n[3] = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                // 两极的位置完全相同，sin(π) 不为 0，也不能有 -0
+                if (r == 0 || r == rings) n[0] = n[2] = 0, n[1] = r == 0 ? 1.0f : -1.0f;
+                for (int i = 0; i < 3; ++i) {
+                    vertex.m_Position[i] = n[i] * radius;
+                    vertex.m_Normal[i] = n[i];
+                }
+                vertex.m_UV[0] = float(s) / segments;
+                vertex.m_UV[1] = float(r) / rings;
+                mesh.m_Vertices.push_back(vertex);
+            }
+        }
+        for (std::uint32_t r = 0; r < rings; ++r) {
+            for (std::uint32_t s = 0; s < segments; ++s) {
+                auto a = r * (segments + 1) + s, b = a + 1, c = a + segments + 1, d = c + 1;
+                // 从外侧看为顺时针
+                if (r > 0) mesh.m_Indices.insert(mesh.m_Indices.end(), {a, c, b});
+                if (r + 1 < rings) mesh.m_Indices.insert(mesh.m_Indices.end(), {b, c, d});
+            }
+        }
+        return mesh;
+    }
+
+    // 起伏的地形，开放边界，左右两半为不同的子网格，分界线上的顶点各自复制一份
+    TestMesh MakeTerrain(std::uint32_t size, std::uint32_t seed)
+    {
+        TestMesh mesh{};
+        // 高频的小起伏使平坦的区域也有一点误差
+        auto height = [seed](float x, float z) {
+            return 0.1f * std::sin(x * 3 + seed) * std::cos(z * 2) + 0.002f * std::sin(x * 97 + z * 61 + seed);
+        };
+        auto half = size / 2;
+        for (std::uint32_t part = 0; part < 2; ++part) {
+            auto x0 = part * half, x1 = part == 0 ? half : size;
+            auto first = static_cast<std::uint32_t>(mesh.m_Vertices.size());
+            auto columns = x1 - x0 + 1;
+            for (std::uint32_t z = 0; z <= size; ++z) {
+                for (auto x = x0; x <= x1; ++x) {
+                    Vertex vertex{};
+                    vertex.m_Position[0] = float(x) / size;
+                    vertex.m_Position[2] = float(z) / size;
+                    vertex.m_Position[1] = 0;
+                    vertex.m_Normal[1] = 1;
+                    vertex.m_UV[0] = float(x) / size;
+                    vertex.m_UV[1] = float(z) / size;
+                    mesh.m_Vertices.push_back(vertex);
+                }
+            }
+            for (std::uint32_t z = 0; z < size; ++z) {
+                for (std::uint32_t x = 0; x + 1 < columns; ++x) {
+                    auto a = first + z * columns + x, b = a + 1, c = a + columns, d = c + 1;
+                    mesh.m_Indices.insert(mesh.m_Indices.end(), {a, c, b, b, c, d});
+                }
+            }
+            mesh.m_SubMeshIndexCounts.push_back(size * (columns - 1) * 6);
+        }
+        // 高度只由位置决定，分界线两侧相同
+        for (auto& vertex : mesh.m_Vertices) vertex.m_Position[1] = height(vertex.m_Position[0], vertex.m_Position[2]);
+        return mesh;
+    }
+
+    // 每个面细分为网格的立方体，面之间法线不同，为硬边
+    TestMesh MakeCube(std::uint32_t divisions)
+    {
+        TestMesh mesh{};
+        for (int axis = 0; axis < 3; ++axis) {
+            for (int sign = -1; sign <= 1; sign += 2) {
+                auto first = static_cast<std::uint32_t>(mesh.m_Vertices.size());
+                int u = (axis + 1) % 3, v = (axis + 2) % 3;
+                for (std::uint32_t j = 0; j <= divisions; ++j) {
+                    for (std::uint32_t i = 0; i <= divisions; ++i) {
+                        Vertex vertex{};
+                        vertex.m_Position[axis] = float(sign);
+                        vertex.m_Position[u] = -1 + 2.0f * i / divisions;
+                        vertex.m_Position[v] = -1 + 2.0f * j / divisions;
+                        vertex.m_Normal[axis] = float(sign);
+                        vertex.m_UV[0] = float(i) / divisions;
+                        vertex.m_UV[1] = float(j) / divisions;
+                        mesh.m_Vertices.push_back(vertex);
+                    }
+                }
+                for (std::uint32_t j = 0; j < divisions; ++j) {
+                    for (std::uint32_t i = 0; i < divisions; ++i) {
+                        auto a = first + j * (divisions + 1) + i, b = a + 1, c = a + divisions + 1, d = c + 1;
+                        // 两个方向的面顶点顺序相反，法线都朝外
+                        if (sign > 0) mesh.m_Indices.insert(mesh.m_Indices.end(), {a, c, b, b, c, d});
+                        else mesh.m_Indices.insert(mesh.m_Indices.end(), {a, b, c, b, d, c});
+                    }
+                }
+            }
+        }
+        return mesh;
+    }
+
+    using PositionKey = std::array<float, 3>;
+
+    PositionKey GetKey(const TestMesh& mesh, std::uint32_t vertex)
+    {
+        const auto& p = mesh.m_Vertices[vertex].m_Position;
+        return {p[0], p[1], p[2]};
+    }
+
+    // 在位置空间中没有反向边的边
+    std::vector<std::pair<PositionKey, PositionKey>> GetOpenEdges(const TestMesh& mesh, const std::vector<std::uint32_t>& indices)
+    {
+        std::multiset<std::pair<PositionKey, PositionKey>> edges{};
+        for (std::size_t i = 0; i < indices.size(); i += 3) {
+            for (std::size_t j = 0; j < 3; ++j) {
+                edges.insert({GetKey(mesh, indices[i + j]), GetKey(mesh, indices[i + (j + 1) % 3])});
+            }
+        }
+        std::vector<std::pair<PositionKey, PositionKey>> open{};
+        for (const auto& [a, b] : edges) {
+            if (edges.count({b, a}) == 0) open.emplace_back(a, b);
+        }
+        return open;
+    }
+
+    double GetVolume(const TestMesh& mesh, const std::vector<std::uint32_t>& indices)
+    {
+        double volume = 0;
+        for (std::size_t i = 0; i < indices.size(); i += 3) {
+            const auto& a = mesh.m_Vertices[indices[i]].m_Position;
+            const auto& b = mesh.m_Vertices[indices[i + 1]].m_Position;
+            const auto& c = mesh.m_Vertices[indices[i + 2]].m_Position;
+            volume += double(a[0]) * (double(b[1]) * c[2] - double(b[2]) * c[1]) -
+                double(a[1]) * (double(b[0]) * c[2] - double(b[2]) * c[0]) +
+                double(a[2]) * (double(b[0]) * c[1] - double(b[1]) * c[0]);
+        }
+        // 左手坐标系中顺时针为正面，体积为负
+        return -volume / 6;
+    }
+
+    // 点到三角形的最近距离，按 Ericson 的 Real-Time Collision Detection
+    float DistanceToTriangle(const float* p, const float* a, const float* b, const float* c)
+    {
+        auto sub = [](const float* x, const float* y) { return std::array<float, 3>{x[0] - y[0], x[1] - y[1], x[2] - y[2]}; };
+        auto dot = [](const std::array<float, 3>& x, const std::array<float, 3>& y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+        auto ab = sub(b, a), ac = sub(c, a), ap = sub(p, a);
+        std::array<float, 3> closest{};
+        auto at = [&](float v, float w) {
+            for (int i = 0; i < 3; ++i) closest[i] = a[i] + v * ab[i] + w * ac[i];
+        };
+        float d1 = dot(ab, ap), d2 = dot(ac, ap);
+        auto bp = sub(p, b);
+        float d3 = dot(ab, bp), d4 = dot(ac, bp);
+        auto cp = sub(p, c);
+        float d5 = dot(ab, cp), d6 = dot(ac, cp);
+        float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+        if (d1 <= 0 && d2 <= 0) at(0, 0);
+        else if (d3 >= 0 && d4 <= d3) at(1, 0);
+        else if (d6 >= 0 && d5 <= d6) at(0, 1);
+        else if (vc <= 0 && d1 >= 0 && d3 <= 0) at(d1 / (d1 - d3), 0);
+        else if (vb <= 0 && d2 >= 0 && d6 <= 0) at(0, d2 / (d2 - d6));
+        else if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+            float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            at(1 - w, w);
+        }
+        else {
+            float denom = 1 / (va + vb + vc);
+            at(vb * denom, vc * denom);
+        }
+        auto d = sub(p, closest.data());
+        return std::sqrt(dot(d, d));
+    }
+
+    // 原始顶点到简化网格的最大距离，step 用于在大网格上抽样
+    float GetHausdorffDistance(const TestMesh& mesh, const std::vector<std::uint32_t>& indices, std::uint32_t step = 1)
+    {
+        float maxDistance = 0;
+        for (std::size_t v = 0; v < mesh.m_Vertices.size(); v += step) {
+            float distance = std::numeric_limits<float>::max();
+            for (std::size_t i = 0; i < indices.size() && distance > maxDistance; i += 3) {
+                distance = (std::min)(distance, DistanceToTriangle(mesh.m_Vertices[v].m_Position,
+                    mesh.m_Vertices[indices[i]].m_Position, mesh.m_Vertices[indices[i + 1]].m_Position, mesh.m_Vertices[indices[i + 2]].m_Position));
+            }
+            maxDistance = (std::max)(maxDistance, distance);
+        }
+        return maxDistance;
+    }
+
+    // 索引在范围内且只引用所在子网格的顶点，没有退化的三角形
+    bool IsValidLevel(const TestMesh& mesh, const MeshLODLevel& level)
+    {
+        auto numSubMeshes = (std::max)(mesh.m_SubMeshIndexCounts.size(), std::size_t(1));
+        if (level.m_SubMeshIndexCounts.size() != numSubMeshes) {
+            std::printf("  level has %zu submeshes instead of %zu\n", level.m_SubMeshIndexCounts.size(), numSubMeshes);
+            return false;
+        }
+        std::vector<std::set<std::uint32_t>> subMeshVertices(numSubMeshes);
+        for (std::size_t s = 0, first = 0; s < numSubMeshes; ++s) {
+            auto count = mesh.m_SubMeshIndexCounts.empty() ? mesh.m_Indices.size() : mesh.m_SubMeshIndexCounts[s];
+            subMeshVertices[s].insert(mesh.m_Indices.begin() + first, mesh.m_Indices.begin() + first + count);
+            first += count;
+        }
+
+        std::size_t first = 0;
+        for (std::size_t s = 0; s < numSubMeshes; ++s) {
+            auto count = level.m_SubMeshIndexCounts[s];
+            if (count % 3 != 0 || first + count > level.m_Indices.size()) {
+                std::printf("  submesh %zu has an invalid index count %u\n", s, count);
+                return false;
+            }
+            for (auto i = first; i < first + count; i += 3) {
+                for (int j = 0; j < 3; ++j) {
+                    if (!subMeshVertices[s].contains(level.m_Indices[i + j])) {
+                        std::printf("  submesh %zu references vertex %u of another submesh\n", s, level.m_Indices[i + j]);
+                        return false;
+                    }
+                }
+                auto a = GetKey(mesh, level.m_Indices[i]), b = GetKey(mesh, level.m_Indices[i + 1]), c = GetKey(mesh, level.m_Indices[i + 2]);
+                if (a == b || b == c || a == c) {
+                    std::printf("  triangle %zu is degenerate\n", i / 3);
+                    return false;
+                }
+            }
+            first += count;
+        }
+        if (first != level.m_Indices.size()) {
+            std::printf("  submesh counts cover %zu of %zu indices\n", first, level.m_Indices.size());
+            return false;
+        }
+        return true;
+    }
+
+    MeshLODLevel SimplifyTo(const TestMesh& mesh, float ratio, float maxError)
+    {
+        MeshSimplifier simplifier{mesh.GetInput()};
+        simplifier.Simplify(static_cast<std::uint32_t>(mesh.GetNumTriangles() * ratio), maxError);
+        MeshLODLevel level{};
+        simplifier.GetLevel(level);
+        return level;
+    }
+}
+
+TEST_CASE(MeshSimplifier_SphereKeepsSeamsClosed)
+{
+    auto sphere = MakeSphere(32, 64, 2.0f);
+    CHECK(GetOpenEdges(sphere, sphere.m_Indices).empty());
+
+    MeshSimplifier simplifier{sphere.GetInput()};
+    CHECK(simplifier.GetNumTriangles() == sphere.GetNumTriangles());
+    CHECK(simplifier.GetError() == 0);
+
+    // 简化是渐进的
+    std::uint32_t previous = simplifier.GetNumTriangles();
+    for (float ratio : {0.5f, 0.3f, 0.2f}) {
+        auto target = static_cast<std::uint32_t>(sphere.GetNumTriangles() * ratio);
+        auto result = simplifier.Simplify(target, 1.0f);
+        CHECK(result <= target);
+        CHECK(result < previous);
+        previous = result;
+
+        MeshLODLevel level{};
+        simplifier.GetLevel(level);
+        CHECK(IsValidLevel(sphere, level));
+        CHECK(level.m_Indices.size() == result * 3);
+        // 接缝两侧一起折叠，网格保持封闭
+        CHECK(GetOpenEdges(sphere, level.m_Indices).empty());
+
+        // 没有三角形跨过接缝，否则纹理坐标会从 1 插值到 0
+        float maxSpan = 0;
+        for (std::size_t i = 0; i < level.m_Indices.size(); i += 3) {
+            float u[3] = {sphere.m_Vertices[level.m_Indices[i]].m_UV[0], sphere.m_Vertices[level.m_Indices[i + 1]].m_UV[0],
+                sphere.m_Vertices[level.m_Indices[i + 2]].m_UV[0]};
+            maxSpan = (std::max)(maxSpan, (std::max)({u[0], u[1], u[2]}) - (std::min)({u[0], u[1], u[2]}));
+        }
+        CHECK(maxSpan < 0.5f);
+
+        // 报告的误差为平均的平方距离，实际的最大距离与其同一量级
+        auto distance = GetHausdorffDistance(sphere, level.m_Indices);
+        CHECK(level.m_Error > 0);
+        CHECK(distance < 0.1f * 2 * 2.0f);
+        CHECK(distance < 4 * level.m_Error + 1e-3f);
+        // 体积只会减小一点
+        auto volume = GetVolume(sphere, level.m_Indices);
+        CHECK(volume > 0.8 * GetVolume(sphere, sphere.m_Indices));
+    }
+
+    // 误差上限为 0 时弯曲的表面不能折叠
+    CHECK(MeshSimplifier{sphere.GetInput()}.Simplify(10, 0) == sphere.GetNumTriangles());
+}
+
+TEST_CASE(MeshSimplifier_TerrainLocksBordersAndMaterials)
+{
+    auto terrain = MakeTerrain(32, 3);
+    auto originalOpen = GetOpenEdges(terrain, terrain.m_Indices);
+    std::set<PositionKey> border{};
+    for (const auto& [a, b] : originalOpen) {
+        border.insert(a);
+        border.insert(b);
+    }
+    CHECK(border.size() == 32 * 4);
+
+    auto level = SimplifyTo(terrain, 0.2f, 1.0f);
+    CHECK(IsValidLevel(terrain, level));
+    CHECK(level.m_Indices.size() <= terrain.m_Indices.size() / 2);
+    CHECK(level.m_SubMeshIndexCounts[0] > 0);
+    CHECK(level.m_SubMeshIndexCounts[1] > 0);
+
+    // 边界上的顶点都保留，材质的分界线两侧的三角形仍然相接
+    std::set<PositionKey> used{};
+    for (auto index : level.m_Indices) used.insert(GetKey(terrain, index));
+    CHECK(std::includes(used.begin(), used.end(), border.begin(), border.end()));
+    auto open = GetOpenEdges(terrain, level.m_Indices);
+    CHECK(open.size() == originalOpen.size());
+    for (const auto& [a, b] : open) {
+        CHECK(border.contains(a) && border.contains(b));
+    }
+    CHECK(GetHausdorffDistance(terrain, level.m_Indices) < 0.05f);
+}
+
+TEST_CASE(MeshSimplifier_CubeKeepsHardEdges)
+{
+    auto cube = MakeCube(8);
+    MeshSimplifier simplifier{cube.GetInput()};
+    auto result = simplifier.Simplify(12, 0.001f);
+    // 平面上的折叠没有误差，只剩下很少的三角形
+    CHECK(result < cube.GetNumTriangles() / 10);
+    CHECK(simplifier.GetError() < 1e-4f);
+
+    MeshLODLevel level{};
+    simplifier.GetLevel(level);
+    CHECK(IsValidLevel(cube, level));
+    CHECK(GetOpenEdges(cube, level.m_Indices).empty());
+    CHECK(std::abs(GetVolume(cube, level.m_Indices) - 8) < 1e-4);
+
+    // 每个三角形仍在一个面内，法线与顶点的法线相同
+    for (std::size_t i = 0; i < level.m_Indices.size(); i += 3) {
+        const auto& a = cube.m_Vertices[level.m_Indices[i]];
+        const auto& b = cube.m_Vertices[level.m_Indices[i + 1]];
+        const auto& c = cube.m_Vertices[level.m_Indices[i + 2]];
+        CHECK(std::equal(a.m_Normal, a.m_Normal + 3, b.m_Normal) && std::equal(a.m_Normal, a.m_Normal + 3, c.m_Normal));
+    }
+}
+
+TEST_CASE(MeshSimplifier_GeneratesLODChain)
+{
+    auto sphere = MakeSphere(32, 64, 1.0f);
+    MeshLODDesc desc{};
+    desc.m_MaxLevels = 4;
+    desc.m_MinTriangles = 100;
+    desc.m_MaxError = 1.0f;
+    auto chain = GenerateMeshLODs(sphere.GetInput(), desc);
+    CHECK(chain.m_NumSourceVertices == sphere.m_Vertices.size());
+    CHECK(chain.m_NumSourceIndices == sphere.m_Indices.size());
+    CHECK(chain.m_Levels.size() == 4);
+
+    auto previousTriangles = sphere.GetNumTriangles();
+    float previousError = 0;
+    for (const auto& level : chain.m_Levels) {
+        CHECK(IsValidLevel(sphere, level));
+        auto numTriangles = static_cast<std::uint32_t>(level.m_Indices.size() / 3);
+        CHECK(numTriangles <= previousTriangles * desc.m_MinReduction);
+        CHECK(numTriangles >= desc.m_MinTriangles / 2);
+        CHECK(level.m_Error >= previousError);
+        previousTriangles = numTriangles;
+        previousError = level.m_Error;
+    }
+
+    // 误差上限使粗糙的 LOD 提前停止
+    desc.m_MaxLevels = 10;
+    desc.m_MaxError = 0.01f;
+    auto limited = GenerateMeshLODs(sphere.GetInput(), desc);
+    CHECK(!limited.m_Levels.empty());
+    CHECK(limited.m_Levels.size() < chain.m_Levels.size());
+    // 误差上限相对于包围盒的最长边
+    CHECK(limited.m_Levels.back().m_Error <= 0.01f * 2.0f);
+
+    // 没有可以折叠的边
+    auto tiny = MakeCube(1);
+    CHECK(GenerateMeshLODs(tiny.GetInput(), {}).m_Levels.empty());
+}
+
+TEST_CASE(MeshSimplifier_LODCacheRoundTrip)
+{
+    auto sphere = MakeSphere(16, 32, 1.0f);
+    auto terrain = MakeTerrain(16, 1);
+    MeshLODDesc desc{};
+    desc.m_MinTriangles = 16;
+    std::vector<MeshLODChain> chains{GenerateMeshLODs(sphere.GetInput(), desc), GenerateMeshLODs(terrain.GetInput(), desc)};
+    REQUIRE(!chains[0].m_Levels.empty());
+    REQUIRE(!chains[1].m_Levels.empty());
+
+    auto path = std::filesystem::temp_directory_path() / "MeshSimplifierTests.lod";
+    REQUIRE(SaveMeshLODCache(path, 42, chains));
+    std::vector<MeshLODChain> loaded{};
+    REQUIRE(LoadMeshLODCache(path, 42, loaded));
+    REQUIRE(loaded.size() == 2);
+    for (std::size_t c = 0; c < 2; ++c) {
+        CHECK(loaded[c].m_NumSourceVertices == chains[c].m_NumSourceVertices);
+        CHECK(loaded[c].m_NumSourceIndices == chains[c].m_NumSourceIndices);
+        REQUIRE(loaded[c].m_Levels.size() == chains[c].m_Levels.size());
+        for (std::size_t i = 0; i < chains[c].m_Levels.size(); ++i) {
+            CHECK(loaded[c].m_Levels[i].m_Indices == chains[c].m_Levels[i].m_Indices);
+            CHECK(loaded[c].m_Levels[i].m_SubMeshIndexCounts == chains[c].m_Levels[i].m_SubMeshIndexCounts);
+            CHECK(loaded[c].m_Levels[i].m_Error == chains[c].m_Levels[i].m_Error);
+        }
+    }
+
+    // 参数不同或文件损坏时读取失败，之前的内容不变
+    CHECK(!LoadMeshLODCache(path, 43, loaded));
+    CHECK(loaded.size() == 2);
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 4);
+    CHECK(!LoadMeshLODCache(path, 42, loaded));
+    REQUIRE(SaveMeshLODCache(path, 42, chains));
+    {
+        // 把最后一个索引改为越界的顶点
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(size - 4);
+        std::uint32_t bad = chains[1].m_NumSourceVertices;
+        file.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+    }
+    CHECK(!LoadMeshLODCache(path, 42, loaded));
+    CHECK(!LoadMeshLODCache(path.string() + ".missing", 42, loaded));
+    std::filesystem::remove(path);
+}
+
+BENCHMARK_CASE(MeshSimplifier_LODChains)
+{
+    struct Case
+    {
+        const char* m_Name;
+        TestMesh m_Mesh;
+    };
+    Case cases[] = {
+        {"sphere", MakeSphere(128, 256, 1.0f)},
+        {"terrain", MakeTerrain(160, 2)},
+        {"cube", MakeCube(64)},
+    };
+
+    for (const auto& c : cases) {
+        // 误差按包围盒最长边的百分比报告
+        float minPos[3]{1e9f, 1e9f, 1e9f}, maxPos[3]{-1e9f, -1e9f, -1e9f};
+        for (const auto& vertex : c.m_Mesh.m_Vertices) {
+            for (int i = 0; i < 3; ++i) {
+                minPos[i] = (std::min)(minPos[i], vertex.m_Position[i]);
+                maxPos[i] = (std::max)(maxPos[i], vertex.m_Position[i]);
+            }
+        }
+        auto extent = (std::max)({maxPos[0] - minPos[0], maxPos[1] - minPos[1], maxPos[2] - minPos[2]});
+
+        MeshLODDesc desc{};
+        MeshLODChain chain{};
+        auto seconds = Test::MeasureSeconds([&]() { chain = GenerateMeshLODs(c.m_Mesh.GetInput(), desc); }, 0.5, 5);
+        std::printf("  %s, %u triangles, %zu levels\n", c.m_Name, c.m_Mesh.GetNumTriangles(), chain.m_Levels.size());
+        Test::ReportMetric("Generate chain", seconds * 1e3, "ms");
+        Test::ReportMetric("Throughput", c.m_Mesh.GetNumTriangles() / seconds * 1e-6, "Mtris/s");
+        for (std::size_t i = 0; i < (std::min)(chain.m_Levels.size(), std::size_t(3)); ++i) {
+            const auto& level = chain.m_Levels[i];
+            auto numTriangles = level.m_Indices.size() / 3;
+            std::printf("  LOD%zu\n", i + 1);
+            Test::ReportMetric("Triangle reduction", 100.0 * (1 - double(numTriangles) / c.m_Mesh.GetNumTriangles()), "%");
+            Test::ReportMetric("Reported error", 100 * level.m_Error / extent, "% of size");
+            // 抽样约 1000 个原始顶点
+            auto step = (std::max)(static_cast<std::uint32_t>(c.m_Mesh.m_Vertices.size() / 1000), 1u);
+            Test::ReportMetric("Measured max distance", 100 * GetHausdorffDistance(c.m_Mesh, level.m_Indices, step) / extent, "% of size");
+        }
+        const auto& last = chain.m_Levels.back();
+        Test::ReportMetric("Coarsest LOD reduction", 100.0 * (1 - double(last.m_Indices.size() / 3) / c.m_Mesh.GetNumTriangles()), "%");
+    }
+}
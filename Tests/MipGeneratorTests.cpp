@@ -0,0 +1,190 @@
+#include "TestFramework.h"
+#include "Utilities/MipGenerator.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    std::vector<std::uint8_t> MakeNoiseRGBA8(std::uint32_t width, std::uint32_t height, std::uint32_t seed)
+    {
+        std::mt19937 rng{seed};
+        std::vector<std::uint8_t> pixels(std::size_t(width) * height * 4);
+        for (auto& value : pixels) value = static_cast<std::uint8_t>(rng() & 0xff);
+        return pixels;
+    }
+
+    // 按面积加权的双精度参考实现
+    double ReferenceBox(const std::vector<std::uint8_t>& src, std::uint32_t srcWidth, std::uint32_t srcHeight,
+        std::uint32_t dstWidth, std::uint32_t dstHeight, std::uint32_t x, std::uint32_t y, std::uint32_t channel)
+    {
+        double scaleX = double(srcWidth) / dstWidth;
+        double scaleY = double(srcHeight) / dstHeight;
+        double sum = 0;
+        double area = 0;
+        for (std::uint32_t sy = 0; sy < srcHeight; ++sy) {
+            double overlapY = (std::min)((y + 1) * scaleY, sy + 1.0) - (std::max)(y * scaleY, double(sy));
+            if (overlapY <= 0) continue;
+            for (std::uint32_t sx = 0; sx < srcWidth; ++sx) {
+                double overlapX = (std::min)((x + 1) * scaleX, sx + 1.0) - (std::max)(x * scaleX, double(sx));
+                if (overlapX <= 0) continue;
+                sum += overlapX * overlapY * src[(std::size_t(sy) * srcWidth + sx) * 4 + channel];
+                area += overlapX * overlapY;
+            }
+        }
+        return sum / area;
+    }
+}
+
+TEST_CASE(MipGenerator_CountsFullChain)
+{
+    CHECK(MipChain::CountMipLevels(1, 1) == 1);
+    CHECK(MipChain::CountMipLevels(5, 3) == 3);
+    CHECK(MipChain::CountMipLevels(1024, 512) == 11);
+    CHECK(MipChain::CountMipLevels(1, 4096) == 13);
+
+    auto pixels = MakeNoiseRGBA8(37, 11, 1);
+    MipChain chain{};
+    REQUIRE(chain.Generate(pixels.data(), 37, 11, 0, MipPixelFormat::kRGBA8Unorm));
+    REQUIRE(chain.GetNumLevels() == 6);
+    CHECK(chain.GetLevel(1).m_Width == 18 && chain.GetLevel(1).m_Height == 5);
+    CHECK(chain.GetLevel(5).m_Width == 1 && chain.GetLevel(5).m_Height == 1);
+    // 第 0 级是原图的拷贝
+    CHECK(std::memcmp(chain.GetLevelData(0), pixels.data(), pixels.size()) == 0);
+
+    REQUIRE(chain.Generate(pixels.data(), 37, 11, 0, MipPixelFormat::kRGBA8Unorm, MipFilter::kBox, 2));
+    CHECK(chain.GetNumLevels() == 2);
+}
+
+TEST_CASE(MipGenerator_BoxMatchesAreaWeightedReference)
+{
+    // 奇数尺寸时一个目标像素覆盖部分源像素
+    constexpr std::uint32_t kWidth = 9;
+    constexpr std::uint32_t kHeight = 7;
+    auto pixels = MakeNoiseRGBA8(kWidth, kHeight, 2);
+    std::vector<std::uint8_t> dst(4 * 4 * 3);
+    MipChain::Downsample(pixels.data(), kWidth, kHeight, kWidth * 4, dst.data(), 4, 3, 4 * 4,
+        MipPixelFormat::kRGBA8Unorm, MipFilter::kBox, 1);
+
+    double maxError = 0;
+    for (std::uint32_t y = 0; y < 3; ++y) {
+        for (std::uint32_t x = 0; x < 4; ++x) {
+            for (std::uint32_t c = 0; c < 4; ++c) {
+                auto expected = ReferenceBox(pixels, kWidth, kHeight, 4, 3, x, y, c);
+                maxError = (std::max)(maxError, std::abs(dst[(y * 4 + x) * 4 + c] - expected));
+            }
+        }
+    }
+    CHECK(maxError <= 0.51);
+}
+
+TEST_CASE(MipGenerator_SRGBFiltersInLinearSpace)
+{
+    // 黑白相间的棋盘格，线性空间的平均为 0.5，编码回 sRGB 约为 188
+    std::vector<std::uint8_t> pixels(4 * 4 * 4);
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        std::uint8_t value = ((i % 4) + (i / 4)) % 2 == 0 ? 255 : 0;
+        pixels[i * 4 + 0] = pixels[i * 4 + 1] = pixels[i * 4 + 2] = value;
+        pixels[i * 4 + 3] = value;
+    }
+
+    MipChain srgb{};
+    REQUIRE(srgb.Generate(pixels.data(), 4, 4, 0, MipPixelFormat::kRGBA8UnormSRGB));
+    auto last = srgb.GetLevelData(srgb.GetNumLevels() - 1);
+    CHECK(std::abs(last[0] - 188) <= 1);
+    // alpha 保持线性
+    CHECK(std::abs(last[3] - 128) <= 1);
+
+    MipChain unorm{};
+    REQUIRE(unorm.Generate(pixels.data(), 4, 4, 0, MipPixelFormat::kRGBA8Unorm));
+    CHECK(std::abs(unorm.GetLevelData(unorm.GetNumLevels() - 1)[0] - 128) <= 1);
+}
+
+TEST_CASE(MipGenerator_KaiserPreservesConstantsAndFloats)
+{
+    constexpr std::uint32_t kSize = 32;
+    std::vector<float> pixels(kSize * kSize * 4);
+    for (std::uint32_t i = 0; i < kSize * kSize; ++i) {
+        pixels[i * 4 + 0] = 0.25f;
+        pixels[i * 4 + 1] = 4.0f;
+        pixels[i * 4 + 2] = -1.0f;
+        pixels[i * 4 + 3] = 1.0f;
+    }
+
+    MipChain chain{};
+    REQUIRE(chain.Generate(pixels.data(), kSize, kSize, 0, MipPixelFormat::kRGBA32Float, MipFilter::kKaiser));
+    REQUIRE(chain.GetNumLevels() == 6);
+    for (std::uint32_t level = 1; level < chain.GetNumLevels(); ++level) {
+        const auto* data = reinterpret_cast<const float*>(chain.GetLevelData(level));
+        CHECK(std::abs(data[0] - 0.25f) < 1e-4f);
+        CHECK(std::abs(data[1] - 4.0f) < 1e-4f);
+        CHECK(std::abs(data[2] + 1.0f) < 1e-4f);
+    }
+}
+
+TEST_CASE(MipGenerator_ThreadCountDoesNotChangeOutput)
+{
+    constexpr std::uint32_t kWidth = 513;
+    constexpr std::uint32_t kHeight = 301;
+    // 带有填充的行距
+    constexpr std::uint64_t kRowPitch = kWidth * 4 + 12;
+    auto noise = MakeNoiseRGBA8(kWidth, kHeight, 3);
+    std::vector<std::uint8_t> pixels(kRowPitch * kHeight, 0xcd);
+    for (std::uint32_t y = 0; y < kHeight; ++y) {
+        std::memcpy(pixels.data() + y * kRowPitch, noise.data() + std::size_t(y) * kWidth * 4, kWidth * 4);
+    }
+
+    for (auto filter : {MipFilter::kBox, MipFilter::kKaiser}) {
+        MipChain single{};
+        MipChain multi{};
+        REQUIRE(single.Generate(pixels.data(), kWidth, kHeight, kRowPitch, MipPixelFormat::kRGBA8UnormSRGB, filter, 0, 1));
+        REQUIRE(multi.Generate(pixels.data(), kWidth, kHeight, kRowPitch, MipPixelFormat::kRGBA8UnormSRGB, filter, 0, 8));
+        REQUIRE(single.GetDataSize() == multi.GetDataSize());
+        CHECK(std::memcmp(single.GetLevelData(0), multi.GetLevelData(0), single.GetDataSize()) == 0);
+        // 填充的字节不参与滤波
+        CHECK(std::memcmp(single.GetLevelData(0), noise.data(), kWidth * 4) == 0);
+    }
+}
+
+BENCHMARK_CASE(MipGenerator_Throughput)
+{
+    constexpr std::uint32_t kSize = 2048;
+    auto rgba8 = MakeNoiseRGBA8(kSize, kSize, 4);
+    std::vector<float> rgba32(std::size_t(kSize) * kSize * 4);
+    for (std::size_t i = 0; i < rgba32.size(); ++i) rgba32[i] = rgba8[i] / 255.0f;
+
+    auto megapixels = double(kSize) * kSize / 1e6;
+    std::vector<std::uint32_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+
+    struct Case
+    {
+        const char* m_Name;
+        const void* m_Data;
+        MipPixelFormat m_Format;
+        MipFilter m_Filter;
+    };
+    const Case cases[] = {
+        {"RGBA8 box", rgba8.data(), MipPixelFormat::kRGBA8Unorm, MipFilter::kBox},
+        {"RGBA8 sRGB box", rgba8.data(), MipPixelFormat::kRGBA8UnormSRGB, MipFilter::kBox},
+        {"RGBA8 Kaiser", rgba8.data(), MipPixelFormat::kRGBA8Unorm, MipFilter::kKaiser},
+        {"RGBA32F box", rgba32.data(), MipPixelFormat::kRGBA32Float, MipFilter::kBox},
+        {"RGBA32F Kaiser", rgba32.data(), MipPixelFormat::kRGBA32Float, MipFilter::kKaiser},
+    };
+
+    MipChain chain{};
+    for (const auto& test : cases) {
+        for (auto threads : threadCounts) {
+            auto seconds = Test::MeasureSeconds([&]() {
+                chain.Generate(test.m_Data, kSize, kSize, 0, test.m_Format, test.m_Filter, 0, threads);
+            }, 0.5, 50);
+            std::string name = std::string{test.m_Name} + ", " + std::to_string(threads) + " thread(s)";
+            Test::ReportMetric(name, megapixels / seconds, "MP/s");
+        }
+        CHECK(chain.GetNumLevels() == 12);
+    }
+}
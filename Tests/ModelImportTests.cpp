@@ -0,0 +1,358 @@
+#include "TestFramework.h"
+#include "Utilities/ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+// 重现 Samples/PBR/ModelLoader 中导入流程的 CPU 部分：纹理读取与网格转换并行，
+// 按网格并行拼接，最后在调用线程按节点的顺序上传，上传用 memcpy 到暂存区代替
+namespace {
+    struct Float2 { float x, y; };
+    struct Float3 { float x, y, z; };
+    struct Float4 { float x, y, z, w; };
+
+    // 与 aiMesh 相同的布局，每个面单独保存索引
+    struct SourceFace
+    {
+        std::uint32_t m_NumIndices{};
+        const std::uint32_t* m_Indices{};
+    };
+
+    struct SourceMesh
+    {
+        std::vector<Float3> m_Vertices{};
+        std::vector<Float3> m_Normals{};
+        std::vector<Float3> m_Tangents{};
+        std::vector<Float3> m_Bitangents{};
+        std::vector<Float3> m_TextureCoords{};
+        std::vector<std::uint32_t> m_IndexStorage{};
+        std::vector<SourceFace> m_Faces{};
+    };
+
+    struct MeshData
+    {
+        std::vector<Float3> m_Positions{};
+        std::vector<Float3> m_Normals{};
+        std::vector<Float2> m_Texcoords{};
+        std::vector<Float4> m_Tangents{};
+        std::vector<Float3> m_Bitangents{};
+        std::vector<std::uint32_t> m_Indices{};
+    };
+
+    struct MeshBuffers
+    {
+        std::vector<Float3> m_Positions{};
+        std::vector<Float3> m_Normals{};
+        std::vector<Float2> m_Texcoords{};
+        std::vector<Float4> m_Tangents{};
+        std::vector<std::uint32_t> m_Indices{};
+        std::vector<Float3> m_OccluderPositions{};
+        std::vector<std::uint32_t> m_OccluderIndices{};
+    };
+
+    struct SourceScene
+    {
+        // 每个节点引用的网格
+        std::vector<std::vector<SourceMesh>> m_Nodes{};
+        // 纹理文件的内容
+        std::vector<std::vector<std::byte>> m_Textures{};
+    };
+
+    // 模拟的上传堆，按顺序线性写入
+    class UploadSink
+    {
+    public:
+        void Reset(std::size_t size)
+        {
+            m_Data.resize(size);
+            m_Offset = 0;
+        }
+        void Write(const void* data, std::size_t size)
+        {
+            if (m_Offset + size > m_Data.size()) m_Offset = 0;
+            std::memcpy(m_Data.data() + m_Offset, data, size);
+            m_Offset += size;
+        }
+        template <typename T>
+        void Write(const std::vector<T>& data) { Write(data.data(), data.size() * sizeof(T)); }
+
+    private:
+        std::vector<std::byte> m_Data{};
+        std::size_t m_Offset{};
+    };
+
+    constexpr std::uint32_t kMaxOccluderTriangles = 4096;
+
+    // sponza.gltf 中网格顶点数的分位数(每 20 个取一个)，生成的网格数与总顶点数与其相同
+    constexpr std::uint32_t kSponzaVertexQuantiles[] = {
+        6, 48, 54, 54, 120, 132, 132, 222, 264, 336, 498, 576, 786, 900, 1368, 1368, 3660, 4086, 6888, 14592};
+    constexpr std::uint32_t kSponzaNumMeshes = 392;
+    constexpr std::uint32_t kSponzaNumNodes = 380;
+    constexpr std::uint32_t kSponzaMaxVertices = 41964;
+    constexpr std::uint32_t kSponzaNumVertices = 786747;
+    // Sponza 的 DDS 纹理大小
+    constexpr std::uint32_t kSponzaNumTextures = 22;
+    constexpr std::uint32_t kSponzaTextureSize = 1398256;
+
+    SourceMesh MakeSourceMesh(std::uint32_t numVertices, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist{-1, 1};
+        auto randomStream = [&]() {
+            std::vector<Float3> stream(numVertices);
+            for (auto& v : stream) v = {dist(rng), dist(rng), dist(rng)};
+            return stream;
+        };
+
+        SourceMesh mesh{};
+        mesh.m_Vertices = randomStream();
+        mesh.m_Normals = randomStream();
+        mesh.m_Tangents = randomStream();
+        mesh.m_Bitangents = randomStream();
+        mesh.m_TextureCoords = randomStream();
+        // Sponza 的网格没有共用顶点，索引数等于顶点数
+        auto numFaces = (std::max)(numVertices / 3, 1u);
+        mesh.m_IndexStorage.resize(numFaces * 3);
+        for (auto& index : mesh.m_IndexStorage) index = rng() % numVertices;
+        mesh.m_Faces.resize(numFaces);
+        for (std::uint32_t i = 0; i < numFaces; ++i) {
+            mesh.m_Faces[i] = {3, mesh.m_IndexStorage.data() + i * 3};
+        }
+        return mesh;
+    }
+
+    // 按 Sponza 的网格大小分布生成场景，scale 缩放网格与纹理的数量
+    SourceScene MakeSponzaScene(std::uint32_t scale, std::uint32_t seed)
+    {
+        std::mt19937 rng{seed};
+        std::vector<std::uint32_t> vertexCounts{};
+        for (std::uint32_t i = 0; i < kSponzaNumMeshes * scale; ++i) {
+            auto quantile = i % std::size(kSponzaVertexQuantiles);
+            auto next = quantile + 1 < std::size(kSponzaVertexQuantiles) ? kSponzaVertexQuantiles[quantile + 1] : kSponzaMaxVertices;
+            auto count = kSponzaVertexQuantiles[quantile];
+            vertexCounts.push_back(count + rng() % (next - count + 1));
+        }
+        // 在分位数之间均匀采样会偏大，按总顶点数缩放
+        double sum = 0;
+        for (auto count : vertexCounts) sum += count;
+        for (auto& count : vertexCounts) {
+            count = (std::max)(static_cast<std::uint32_t>(count * (double(kSponzaNumVertices) * scale / sum)), 3u);
+        }
+        std::shuffle(vertexCounts.begin(), vertexCounts.end(), rng);
+
+        SourceScene scene{};
+        std::uint32_t numNodes = kSponzaNumNodes * scale;
+        scene.m_Nodes.resize(numNodes);
+        for (std::uint32_t i = 0; i < vertexCounts.size(); ++i) {
+            // 多出来的网格放入前面的节点，每个节点最多两个子网格
+            scene.m_Nodes[i < numNodes ? i : i - numNodes].push_back(MakeSourceMesh(vertexCounts[i], rng));
+        }
+        scene.m_Textures.resize(kSponzaNumTextures * scale);
+        for (auto& texture : scene.m_Textures) {
+            texture.resize(kSponzaTextureSize);
+            std::memset(texture.data(), static_cast<int>(rng() & 0xff), texture.size());
+        }
+        return scene;
+    }
+
+    MeshData ProcessMesh(const SourceMesh& mesh)
+    {
+        auto numVertices = mesh.m_Vertices.size();
+        MeshData meshData{};
+        meshData.m_Positions.resize(numVertices);
+        meshData.m_Normals.resize(numVertices);
+        meshData.m_Texcoords.resize(numVertices);
+        meshData.m_Tangents.resize(numVertices);
+        meshData.m_Bitangents.resize(numVertices);
+        for (std::size_t i = 0; i < numVertices; ++i) {
+            meshData.m_Positions[i] = mesh.m_Vertices[i];
+            meshData.m_Normals[i] = mesh.m_Normals[i];
+            meshData.m_Texcoords[i] = {mesh.m_TextureCoords[i].x, mesh.m_TextureCoords[i].y};
+            meshData.m_Tangents[i] = {mesh.m_Tangents[i].x, mesh.m_Tangents[i].y, mesh.m_Tangents[i].z, 1.0f};
+            meshData.m_Bitangents[i] = mesh.m_Bitangents[i];
+        }
+
+        auto numIndex = mesh.m_Faces[0].m_NumIndices;
+        meshData.m_Indices.resize(mesh.m_Faces.size() * numIndex);
+        for (std::size_t i = 0; i < mesh.m_Faces.size(); ++i) {
+            std::memcpy(meshData.m_Indices.data() + i * numIndex, mesh.m_Faces[i].m_Indices, sizeof(std::uint32_t) * numIndex);
+        }
+        return meshData;
+    }
+
+    MeshBuffers AssembleMesh(std::span<const MeshData> meshDatas)
+    {
+        MeshBuffers buffers{};
+        std::size_t numVertices = 0, numIndices = 0;
+        for (const auto& meshData : meshDatas) {
+            numVertices += meshData.m_Positions.size();
+            numIndices += meshData.m_Indices.size();
+        }
+        buffers.m_Positions.reserve(numVertices);
+        buffers.m_Normals.reserve(numVertices);
+        buffers.m_Texcoords.reserve(numVertices);
+        buffers.m_Tangents.reserve(numVertices);
+        buffers.m_Indices.reserve(numIndices);
+
+        std::vector<std::uint32_t> vertexOffsets{};
+        for (const auto& meshData : meshDatas) {
+            vertexOffsets.push_back(static_cast<std::uint32_t>(buffers.m_Positions.size()));
+            buffers.m_Positions.insert(buffers.m_Positions.end(), meshData.m_Positions.begin(), meshData.m_Positions.end());
+            buffers.m_Normals.insert(buffers.m_Normals.end(), meshData.m_Normals.begin(), meshData.m_Normals.end());
+            buffers.m_Texcoords.insert(buffers.m_Texcoords.end(), meshData.m_Texcoords.begin(), meshData.m_Texcoords.end());
+            buffers.m_Tangents.insert(buffers.m_Tangents.end(), meshData.m_Tangents.begin(), meshData.m_Tangents.end());
+            buffers.m_Indices.insert(buffers.m_Indices.end(), meshData.m_Indices.begin(), meshData.m_Indices.end());
+        }
+
+        // 较小的网格保留一份 CPU 端的遮挡体
+        if (numIndices / 3 <= kMaxOccluderTriangles) {
+            buffers.m_OccluderPositions = buffers.m_Positions;
+            buffers.m_OccluderIndices.reserve(numIndices);
+            for (std::size_t i = 0; i < meshDatas.size(); ++i) {
+                for (auto index : meshDatas[i].m_Indices) {
+                    buffers.m_OccluderIndices.push_back(index + vertexOffsets[i]);
+                }
+            }
+        }
+        return buffers;
+    }
+
+    void UploadMesh(const MeshBuffers& buffers, UploadSink& sink)
+    {
+        sink.Write(buffers.m_Positions);
+        sink.Write(buffers.m_Normals);
+        sink.Write(buffers.m_Texcoords);
+        sink.Write(buffers.m_Tangents);
+        sink.Write(buffers.m_Indices);
+    }
+
+    // 与 ModelLoader 中的 ParallelForEachItem 相同，但线程数由参数指定
+    template <typename Func>
+    void ParallelForEachItem(std::uint32_t count, std::uint32_t numThreads, Func&& func)
+    {
+        numThreads = (std::min)((std::max)(numThreads, 1u), (std::max)(count, 1u));
+        std::atomic<std::uint32_t> nextItem{0};
+        Utility::ParallelFor(numThreads, numThreads, [&](std::uint32_t, std::uint32_t) {
+            for (auto i = nextItem++; i < count; i = nextItem++) {
+                func(i);
+            }
+        });
+    }
+
+    // 导入整个场景，返回拼接后的网格，上传按节点的顺序进行
+    std::vector<MeshBuffers> ImportScene(const SourceScene& scene, std::uint32_t numThreads, UploadSink& sink)
+    {
+        // 纹理排在最前，网格按顶点数从多到少排列
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> meshJobs{};
+        std::vector<std::vector<MeshData>> pendingMeshes(scene.m_Nodes.size());
+        for (std::uint32_t i = 0; i < scene.m_Nodes.size(); ++i) {
+            pendingMeshes[i].resize(scene.m_Nodes[i].size());
+            for (std::uint32_t j = 0; j < scene.m_Nodes[i].size(); ++j) {
+                meshJobs.emplace_back(i, j);
+            }
+        }
+        auto numVertices = [&](const auto& job) { return scene.m_Nodes[job.first][job.second].m_Vertices.size(); };
+        std::stable_sort(meshJobs.begin(), meshJobs.end(), [&](const auto& a, const auto& b) {
+            return numVertices(a) > numVertices(b);
+        });
+
+        // 纹理读入各自的暂存区，与 DDS 直接上传的流程相同
+        auto numTextures = static_cast<std::uint32_t>(scene.m_Textures.size());
+        std::vector<UploadSink> textureSinks(numTextures);
+        ParallelForEachItem(numTextures + static_cast<std::uint32_t>(meshJobs.size()), numThreads, [&](std::uint32_t i) {
+            if (i < numTextures) {
+                textureSinks[i].Reset(scene.m_Textures[i].size());
+                textureSinks[i].Write(scene.m_Textures[i]);
+            }
+            else {
+                auto [node, subMesh] = meshJobs[i - numTextures];
+                pendingMeshes[node][subMesh] = ProcessMesh(scene.m_Nodes[node][subMesh]);
+            }
+        });
+
+        std::vector<MeshBuffers> meshBuffers(pendingMeshes.size());
+        ParallelForEachItem(static_cast<std::uint32_t>(pendingMeshes.size()), numThreads, [&](std::uint32_t i) {
+            meshBuffers[i] = AssembleMesh(pendingMeshes[i]);
+            pendingMeshes[i] = {};
+        });
+        for (const auto& buffers : meshBuffers) {
+            UploadMesh(buffers, sink);
+        }
+        return meshBuffers;
+    }
+
+    template <typename T>
+    bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+    }
+}
+
+TEST_CASE(ModelImport_ParallelMatchesSerial)
+{
+    auto scene = MakeSponzaScene(1, 3);
+    UploadSink sink{};
+    sink.Reset(64 << 20);
+
+    // 无论线程数多少，每个节点的结果都与单线程相同
+    auto serial = ImportScene(scene, 1, sink);
+    REQUIRE(serial.size() == kSponzaNumNodes);
+    for (std::uint32_t numThreads : {2u, 8u}) {
+        auto parallel = ImportScene(scene, numThreads, sink);
+        REQUIRE(parallel.size() == serial.size());
+        for (std::size_t i = 0; i < serial.size(); ++i) {
+            CHECK(SameBytes(parallel[i].m_Positions, serial[i].m_Positions));
+            CHECK(SameBytes(parallel[i].m_Texcoords, serial[i].m_Texcoords));
+            CHECK(SameBytes(parallel[i].m_Tangents, serial[i].m_Tangents));
+            CHECK(parallel[i].m_Indices == serial[i].m_Indices);
+            CHECK(parallel[i].m_OccluderIndices == serial[i].m_OccluderIndices);
+        }
+    }
+
+    // 子网格按节点中的顺序拼接，遮挡体的索引加上子网格的顶点偏移
+    for (std::size_t i = 0; i < scene.m_Nodes.size(); ++i) {
+        const auto& node = scene.m_Nodes[i];
+        if (node.size() < 2 || serial[i].m_OccluderIndices.empty()) continue;
+        auto firstVertices = static_cast<std::uint32_t>(node[0].m_Vertices.size());
+        auto firstIndices = node[0].m_IndexStorage.size();
+        CHECK(serial[i].m_Positions.size() == firstVertices + node[1].m_Vertices.size());
+        CHECK(std::memcmp(&serial[i].m_Positions[firstVertices], node[1].m_Vertices.data(), sizeof(Float3)) == 0);
+        CHECK(serial[i].m_Indices[firstIndices] == node[1].m_IndexStorage[0]);
+        CHECK(serial[i].m_OccluderIndices[firstIndices] == node[1].m_IndexStorage[0] + firstVertices);
+    }
+}
+
+BENCHMARK_CASE(ModelImport_SponzaWorkers)
+{
+    auto hardwareThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    // 真实测得的墙钟时间，硬件线程数少于工作线程数时不会有加速
+    Test::ReportMetric("Hardware threads", hardwareThreads, "");
+
+    for (std::uint32_t scale : {1u, 4u}) {
+        auto scene = MakeSponzaScene(scale, 1);
+        std::size_t numVertices = 0;
+        for (const auto& node : scene.m_Nodes) {
+            for (const auto& mesh : node) numVertices += mesh.m_Vertices.size();
+        }
+        UploadSink sink{};
+        sink.Reset(numVertices * (sizeof(Float3) * 2 + sizeof(Float2) + sizeof(Float4) + sizeof(std::uint32_t)));
+
+        auto label = "Sponza x" + std::to_string(scale) + " (" + std::to_string(numVertices / 1000) + "k vertices, " +
+            std::to_string(scene.m_Textures.size()) + " textures)";
+        double serialTime = 0;
+        for (std::uint32_t numThreads : {1u, 2u, 4u, 8u}) {
+            auto seconds = Test::MeasureSeconds([&]() { ImportScene(scene, numThreads, sink); }, 0.5, 20);
+            if (numThreads == 1) serialTime = seconds;
+            Test::ReportMetric(label + ", " + std::to_string(numThreads) + " workers", seconds * 1e3, "ms");
+            if (numThreads > 1) {
+                Test::ReportMetric(label + ", " + std::to_string(numThreads) + " workers speedup", serialTime / seconds, "x");
+            }
+        }
+    }
+}
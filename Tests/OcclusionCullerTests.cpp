@@ -0,0 +1,517 @@
+#include "TestFramework.h"
+#include "Renderer/OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 operator-(const Float3& a, const Float3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Float3 Cross(const Float3& a, const Float3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Float3 Normalize(const Float3& v)
+    {
+        auto invLength = 1 / std::sqrt(Dot(v, v));
+        return {v.x * invLength, v.y * invLength, v.z * invLength};
+    }
+
+    // 与 XMFLOAT4X4 相同的布局，行向量约定
+    struct Matrix
+    {
+        float m[16]{};
+    };
+
+    Matrix Multiply(const Matrix& a, const Matrix& b)
+    {
+        Matrix result{};
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                for (int k = 0; k < 4; ++k) result.m[r * 4 + c] += a.m[r * 4 + k] * b.m[k * 4 + c];
+            }
+        }
+        return result;
+    }
+
+    // 与 XMMatrixLookAtLH 和 XMMatrixPerspectiveFovLH 相同
+    Matrix LookAt(Float3 eye, Float3 target)
+    {
+        auto z = Normalize(target - eye);
+        auto x = Normalize(Cross({0, 1, 0}, z));
+        auto y = Cross(z, x);
+        return {{
+            x.x, y.x, z.x, 0,
+            x.y, y.y, z.y, 0,
+            x.z, y.z, z.z, 0,
+            -Dot(x, eye), -Dot(y, eye), -Dot(z, eye), 1}};
+    }
+
+    Matrix Perspective(float fovY, float aspect, float nearZ, float farZ)
+    {
+        auto yScale = 1 / std::tan(fovY * 0.5f);
+        auto range = farZ / (farZ - nearZ);
+        return {{
+            yScale / aspect, 0, 0, 0,
+            0, yScale, 0, 0,
+            0, 0, range, 1,
+            0, 0, -range * nearZ, 0}};
+    }
+
+    void Transform(const Float3& p, const Matrix& m, float* clip)
+    {
+        for (int i = 0; i < 4; ++i) clip[i] = p.x * m.m[i] + p.y * m.m[4 + i] + p.z * m.m[8 + i] + m.m[12 + i];
+    }
+
+    // 遮挡体都在世界空间中，三角形的顶点顺序从外侧看为顺时针
+    struct Mesh
+    {
+        std::vector<Float3> m_Positions{};
+        std::vector<std::uint32_t> m_Indices{};
+        bool m_BothSides = false;
+
+        OccluderGeometry GetGeometry() const
+        {
+            OccluderGeometry geometry{};
+            geometry.m_Positions = m_Positions.data();
+            geometry.m_NumVertices = static_cast<std::uint32_t>(m_Positions.size());
+            geometry.m_Indices = m_Indices.data();
+            geometry.m_NumIndices = static_cast<std::uint32_t>(m_Indices.size());
+            geometry.m_BothSides = m_BothSides;
+            return geometry;
+        }
+    };
+
+    // 法线为 -z 的矩形
+    Mesh MakeWall(float minX, float minY, float maxX, float maxY, float z, bool bothSides = false)
+    {
+        return {{{minX, minY, z}, {minX, maxY, z}, {maxX, maxY, z}, {maxX, minY, z}}, {0, 1, 2, 0, 2, 3}, bothSides};
+    }
+
+    Mesh MakeBox(Float3 boxMin, Float3 boxMax)
+    {
+        Mesh mesh{};
+        for (std::uint32_t i = 0; i < 8; ++i) {
+            mesh.m_Positions.push_back({
+                (i & 1) ? boxMax.x : boxMin.x,
+                (i & 2) ? boxMax.y : boxMin.y,
+                (i & 4) ? boxMax.z : boxMin.z});
+        }
+        Float3 center{(boxMin.x + boxMax.x) / 2, (boxMin.y + boxMax.y) / 2, (boxMin.z + boxMax.z) / 2};
+        const std::uint32_t faces[6][4]{{0, 2, 6, 4}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 5, 7, 6}};
+        for (const auto& face : faces) {
+            for (std::uint32_t t = 1; t <= 2; ++t) {
+                std::uint32_t tri[3]{face[0], face[t], face[t + 1]};
+                const auto& p = mesh.m_Positions;
+                // 左手坐标系中顺时针的三角形 cross(e1, e2) 指向外侧
+                auto normal = Cross(p[tri[1]] - p[tri[0]], p[tri[2]] - p[tri[0]]);
+                if (Dot(normal, p[tri[0]] - center) < 0) std::swap(tri[1], tri[2]);
+                mesh.m_Indices.insert(mesh.m_Indices.end(), tri, tri + 3);
+            }
+        }
+        return mesh;
+    }
+
+    struct Box
+    {
+        Float3 m_Min, m_Max;
+    };
+
+    // 参考实现：在像素内的采样点上求遮挡体最近的深度，遮挡体都在近平面之前
+    class ReferenceDepth
+    {
+    public:
+        ReferenceDepth(const std::vector<Mesh>& meshes, const Matrix& viewProj, float width, float height)
+        {
+            for (const auto& mesh : meshes) {
+                for (std::size_t i = 0; i < mesh.m_Indices.size(); i += 3) {
+                    Triangle triangle{};
+                    for (int v = 0; v < 3; ++v) {
+                        float clip[4];
+                        Transform(mesh.m_Positions[mesh.m_Indices[i + v]], viewProj, clip);
+                        triangle.x[v] = (clip[0] / clip[3] * 0.5f + 0.5f) * width;
+                        triangle.y[v] = (0.5f - clip[1] / clip[3] * 0.5f) * height;
+                        triangle.z[v] = clip[2] / clip[3];
+                    }
+                    float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+                        (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+                    if (area == 0 || (area < 0 && !mesh.m_BothSides)) continue;
+                    triangle.area = area;
+                    m_Triangles.push_back(triangle);
+                }
+            }
+        }
+
+        float GetDepth(float x, float y) const
+        {
+            float depth = 1;
+            for (const auto& t : m_Triangles) {
+                float w[3];
+                for (int i = 0; i < 3; ++i) {
+                    int j = (i + 1) % 3, k = (i + 2) % 3;
+                    w[k] = ((t.x[j] - t.x[i]) * (y - t.y[i]) - (x - t.x[i]) * (t.y[j] - t.y[i])) / t.area;
+                }
+                if (w[0] < 0 || w[1] < 0 || w[2] < 0) continue;
+                depth = (std::min)(depth, w[0] * t.z[0] + w[1] * t.z[1] + w[2] * t.z[2]);
+            }
+            return depth;
+        }
+
+    private:
+        struct Triangle
+        {
+            float x[3], y[3], z[3];
+            float area;
+        };
+        std::vector<Triangle> m_Triangles{};
+    };
+
+    // 深度缓冲中的每个像素都不能比像素内任何一点的遮挡体更近，否则会错误地剔除
+    bool IsConservativeDepth(const OcclusionCuller& culler, const ReferenceDepth& reference)
+    {
+        std::uint32_t numWritten = 0;
+        for (std::uint32_t y = 0; y < culler.GetHeight(); ++y) {
+            for (std::uint32_t x = 0; x < culler.GetWidth(); ++x) {
+                auto depth = culler.GetDepth(x, y);
+                if (depth >= 1) continue;
+                ++numWritten;
+                for (float sy : {0.02f, 0.5f, 0.98f}) {
+                    for (float sx : {0.02f, 0.5f, 0.98f}) {
+                        auto expected = reference.GetDepth(x + sx, y + sy);
+                        if (depth < expected - 1e-5f) {
+                            std::printf("  pixel (%u, %u) depth %f is nearer than occluder depth %f\n", x, y, depth, expected);
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return numWritten > 0;
+    }
+
+    // 在包围盒表面取点，有一点在遮挡体之前就是可见的
+    bool IsSampledVisible(const Box& box, const Matrix& viewProj, const ReferenceDepth& reference, float width, float height)
+    {
+        constexpr int kSamples = 8;
+        for (int axis = 0; axis < 3; ++axis) {
+            for (int side = 0; side < 2; ++side) {
+                for (int i = 0; i <= kSamples; ++i) {
+                    for (int j = 0; j <= kSamples; ++j) {
+                        float s = float(i) / kSamples, t = float(j) / kSamples;
+                        float coords[3];
+                        const float* lo = &box.m_Min.x;
+                        const float* hi = &box.m_Max.x;
+                        coords[axis] = side ? hi[axis] : lo[axis];
+                        coords[(axis + 1) % 3] = lo[(axis + 1) % 3] + s * (hi[(axis + 1) % 3] - lo[(axis + 1) % 3]);
+                        coords[(axis + 2) % 3] = lo[(axis + 2) % 3] + t * (hi[(axis + 2) % 3] - lo[(axis + 2) % 3]);
+                        float clip[4];
+                        Transform({coords[0], coords[1], coords[2]}, viewProj, clip);
+                        if (clip[3] <= 0 || clip[2] < 0 || clip[2] > clip[3]) continue;
+                        float x = (clip[0] / clip[3] * 0.5f + 0.5f) * width;
+                        float y = (0.5f - clip[1] / clip[3] * 0.5f) * height;
+                        if (x < 0 || y < 0 || x >= width || y >= height) continue;
+                        if (clip[2] / clip[3] < reference.GetDepth(x, y) - 1e-5f) return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    Matrix MakeViewProj(Float3 eye, Float3 target, float aspect)
+    {
+        return Multiply(LookAt(eye, target), Perspective(1.0f, aspect, 0.1f, 200.0f));
+    }
+
+    Matrix Identity()
+    {
+        return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+    }
+
+    void RasterizeMeshes(OcclusionCuller& culler, const std::vector<Mesh>& meshes, const Matrix& viewProj)
+    {
+        culler.BeginFrame();
+        for (const auto& mesh : meshes) culler.AddOccluder(mesh.GetGeometry(), viewProj.m);
+        culler.Rasterize();
+    }
+
+    bool IsVisible(OcclusionCuller& culler, const Box& box, const Matrix& localToClip)
+    {
+        return culler.IsVisible(&box.m_Min.x, &box.m_Max.x, localToClip.m);
+    }
+
+    // 包围盒的八个角点都在同一个裁剪面之外
+    bool IsOutsideFrustum(const Box& box, const Matrix& viewProj)
+    {
+        std::uint32_t outside[6]{};
+        for (std::uint32_t i = 0; i < 8; ++i) {
+            float clip[4];
+            Transform({(i & 1) ? box.m_Max.x : box.m_Min.x, (i & 2) ? box.m_Max.y : box.m_Min.y, (i & 4) ? box.m_Max.z : box.m_Min.z}, viewProj, clip);
+            outside[0] += clip[0] > clip[3];
+            outside[1] += clip[0] < -clip[3];
+            outside[2] += clip[1] > clip[3];
+            outside[3] += clip[1] < -clip[3];
+            outside[4] += clip[2] > clip[3];
+            outside[5] += clip[2] < 0;
+        }
+        return std::find(std::begin(outside), std::end(outside), 8u) != std::end(outside);
+    }
+}
+
+TEST_CASE(OcclusionCuller_WallHidesBoxesBehindIt)
+{
+    OcclusionCuller culler{};
+    auto aspect = float(culler.GetWidth()) / culler.GetHeight();
+    auto viewProj = MakeViewProj({0, 0, 0}, {0, 0, 1}, aspect);
+    std::vector<Mesh> meshes{MakeWall(-4, -3, 4, 3, 10)};
+
+    // 没有遮挡体时都可见
+    culler.BeginFrame();
+    culler.Rasterize();
+    CHECK(!culler.HasDepth());
+    CHECK(IsVisible(culler, {{-1, -1, 20}, {1, 1, 22}}, viewProj));
+
+    RasterizeMeshes(culler, meshes, viewProj);
+    REQUIRE(culler.HasDepth());
+    CHECK(culler.GetStats().m_NumOccluders == 1);
+    CHECK(culler.GetStats().m_NumTriangles == 2);
+    CHECK(culler.GetStats().m_NumRasterized == 2);
+
+    // 墙的两个三角形都只写入完全覆盖的像素，对角线上的一行像素保持原来的深度，包围盒需避开对角线
+    CHECK(!IsVisible(culler, {{1, -2, 20}, {3, -1, 22}}, viewProj));
+    CHECK(!IsVisible(culler, {{-3.5f, 0, 11}, {-2, 2.5f, 12}}, viewProj));
+    CHECK(IsVisible(culler, {{-1, -1, 20}, {1, 1, 22}}, viewProj));
+    // 在墙之前，与墙相交，从墙的上方露出，或者在墙的旁边
+    CHECK(IsVisible(culler, {{1, -2, 5}, {3, -1, 6}}, viewProj));
+    CHECK(IsVisible(culler, {{1, -2, 9}, {3, -1, 11}}, viewProj));
+    CHECK(IsVisible(culler, {{-1, 2, 20}, {1, 8, 22}}, viewProj));
+    CHECK(IsVisible(culler, {{9, -1, 20}, {11, 1, 22}}, viewProj));
+    // 与近平面相交，或者有角点在相机之后时不做判断
+    CHECK(IsVisible(culler, {{-1, -1, -1}, {1, 1, 30}}, viewProj));
+    CHECK(IsVisible(culler, {{-1, -1, -5}, {1, 1, -3}}, viewProj));
+    // 在屏幕之外
+    CHECK(!IsVisible(culler, {{40, -1, 20}, {42, 1, 22}}, viewProj));
+    CHECK(culler.GetStats().m_NumTests == 10);
+    CHECK(culler.GetStats().m_NumOccluded == 3);
+
+    // 局部空间的包围盒使用自己的变换
+    auto local = Identity();
+    local.m[14] = 20;
+    CHECK(!IsVisible(culler, {{1, -2, 0}, {3, -1, 2}}, Multiply(local, viewProj)));
+    CHECK(IsVisible(culler, {{1, -2, -16}, {3, -1, -15}}, Multiply(local, viewProj)));
+}
+
+TEST_CASE(OcclusionCuller_BackFacesDoNotOcclude)
+{
+    OcclusionCuller culler{};
+    auto aspect = float(culler.GetWidth()) / culler.GetHeight();
+    // 从墙的背面看去
+    auto viewProj = MakeViewProj({0, 0, 20}, {0, 0, 0}, aspect);
+    Box box{{1, -2, -5}, {3, -1, -3}};
+
+    RasterizeMeshes(culler, {MakeWall(-4, -3, 4, 3, 0)}, viewProj);
+    CHECK(!culler.HasDepth());
+    CHECK(culler.GetStats().m_NumRasterized == 0);
+    CHECK(IsVisible(culler, box, viewProj));
+
+    RasterizeMeshes(culler, {MakeWall(-4, -3, 4, 3, 0, true)}, viewProj);
+    CHECK(culler.HasDepth());
+    CHECK(!IsVisible(culler, box, viewProj));
+
+    // 从立方体的两侧看去都只有朝向相机的面写入深度
+    for (float z : {20.0f, -20.0f}) {
+        auto boxViewProj = MakeViewProj({0, 0, z}, {0, 0, 0}, aspect);
+        RasterizeMeshes(culler, {MakeBox({-3, -3, -3}, {3, 3, 3})}, boxViewProj);
+        CHECK(culler.GetStats().m_NumRasterized == 2);
+        CHECK(!IsVisible(culler, {{0.2f, -2.2f, -1}, {0.6f, -1.6f, 1}}, boxViewProj));
+    }
+}
+
+TEST_CASE(OcclusionCuller_ClipsOccludersAtNearPlane)
+{
+    OcclusionCuller culler{};
+    auto aspect = float(culler.GetWidth()) / culler.GetHeight();
+    auto viewProj = MakeViewProj({0, 0, 0}, {0, 0, 1}, aspect);
+    // 地面从相机之后延伸到远处，与近平面相交
+    Mesh floor{{{-50, -1, -10}, {-50, -1, 100}, {50, -1, 100}, {50, -1, -10}}, {0, 1, 2, 0, 2, 3}};
+    // 从上往下看为顺时针
+    RasterizeMeshes(culler, {floor}, viewProj);
+    REQUIRE(culler.HasDepth());
+    CHECK(culler.GetStats().m_NumRasterized >= 2);
+    CHECK(!IsVisible(culler, {{-1, -4, 5}, {1, -2, 6}}, viewProj));
+    CHECK(IsVisible(culler, {{-1, -0.5f, 5}, {1, 0.5f, 6}}, viewProj));
+
+    // 下半部分的像素被地面完全覆盖，深度随距离增大
+    auto nearDepth = culler.GetDepth(culler.GetWidth() / 2, culler.GetHeight() - 1);
+    auto farDepth = culler.GetDepth(culler.GetWidth() / 2, culler.GetHeight() / 2 + 4);
+    CHECK(nearDepth < farDepth);
+    CHECK(farDepth < 1);
+    CHECK(culler.GetDepth(culler.GetWidth() / 2, culler.GetHeight() / 4) == 1);
+}
+
+TEST_CASE(OcclusionCuller_RandomScenesAreConservative)
+{
+    OcclusionCullerDesc desc{};
+    desc.m_Width = 200;
+    desc.m_Height = 120;
+    OcclusionCuller culler{desc};
+    CHECK(culler.GetWidth() == 256);
+    CHECK(culler.GetHeight() == 128);
+    auto width = float(culler.GetWidth()), height = float(culler.GetHeight());
+
+    std::uint32_t numOccluded = 0, numTested = 0;
+    for (std::uint32_t seed = 0; seed < 6; ++seed) {
+        std::mt19937 rng{seed};
+        std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+        std::vector<Mesh> meshes{};
+        for (int i = 0; i < 12; ++i) {
+            float x = unit(rng) * 16 - 8, y = unit(rng) * 10 - 5, z = 4 + unit(rng) * 20;
+            if (i % 3 == 0) {
+                meshes.push_back(MakeBox({x, y, z}, {x + 1 + unit(rng) * 3, y + 1 + unit(rng) * 3, z + 1 + unit(rng) * 3}));
+            }
+            else {
+                auto wall = MakeWall(x, y, x + 2 + unit(rng) * 6, y + 2 + unit(rng) * 4, z, i % 2 == 0);
+                // 倾斜的墙在屏幕上不是矩形，深度也不是常数
+                for (auto& p : wall.m_Positions) p.z += (p.x - x) * (unit(rng) - 0.5f) + (p.y - y) * (unit(rng) - 0.5f);
+                if (i % 4 == 1) std::swap(wall.m_Indices[1], wall.m_Indices[2]), std::swap(wall.m_Indices[4], wall.m_Indices[5]);
+                meshes.push_back(wall);
+            }
+        }
+
+        auto viewProj = MakeViewProj({unit(rng) - 0.5f, unit(rng) - 0.5f, 0}, {0, 0, 10}, width / height);
+        RasterizeMeshes(culler, meshes, viewProj);
+        ReferenceDepth reference{meshes, viewProj, width, height};
+        CHECK(IsConservativeDepth(culler, reference));
+
+        for (int i = 0; i < 150; ++i) {
+            float x = unit(rng) * 20 - 10, y = unit(rng) * 12 - 6, z = 2 + unit(rng) * 40;
+            float size = 0.1f + unit(rng) * unit(rng) * 4;
+            Box box{{x, y, z}, {x + size, y + size * unit(rng), z + size}};
+            if (IsOutsideFrustum(box, viewProj)) continue;
+            ++numTested;
+            if (IsVisible(culler, box, viewProj)) continue;
+            ++numOccluded;
+            if (IsSampledVisible(box, viewProj, reference, width, height)) {
+                std::printf("  seed %u: box at (%f, %f, %f) is visible but was culled\n", seed, x, y, z);
+                CHECK(false);
+            }
+        }
+    }
+    // 确实剔除了一部分
+    CHECK(numOccluded > numTested / 10);
+}
+
+TEST_CASE(OcclusionCuller_ThreadCountDoesNotChangeDepth)
+{
+    std::vector<Mesh> meshes{};
+    std::mt19937 rng{3};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    // 足够多的三角形使每个线程都分到几批
+    for (int i = 0; i < 400; ++i) {
+        float x = unit(rng) * 30 - 15, y = unit(rng) * 20 - 10, z = 5 + unit(rng) * 50;
+        meshes.push_back(MakeBox({x, y, z}, {x + unit(rng) * 2, y + unit(rng) * 2, z + unit(rng) * 2}));
+    }
+
+    OcclusionCullerDesc desc{};
+    desc.m_NumThreads = 1;
+    OcclusionCuller serial{desc};
+    desc.m_NumThreads = 5;
+    OcclusionCuller parallel{desc};
+    auto viewProj = MakeViewProj({0, 0, 0}, {0, 0, 1}, float(serial.GetWidth()) / serial.GetHeight());
+    RasterizeMeshes(serial, meshes, viewProj);
+    RasterizeMeshes(parallel, meshes, viewProj);
+    CHECK(serial.GetStats().m_NumRasterized == parallel.GetStats().m_NumRasterized);
+
+    std::uint32_t numDifferent = 0;
+    for (std::uint32_t y = 0; y < serial.GetHeight(); ++y) {
+        for (std::uint32_t x = 0; x < serial.GetWidth(); ++x) {
+            numDifferent += serial.GetDepth(x, y) != parallel.GetDepth(x, y);
+        }
+    }
+    CHECK(numDifferent == 0);
+
+    // 下一帧会清除之前的深度
+    RasterizeMeshes(parallel, {MakeWall(-1, -1, 1, 1, 5)}, viewProj);
+    CHECK(parallel.GetDepth(0, 0) == 1);
+    CHECK(parallel.GetDepth(parallel.GetWidth() / 2 + 15, parallel.GetHeight() / 2 + 15) < 1);
+}
+
+BENCHMARK_CASE(OcclusionCuller_Courtyard)
+{
+    // 与 Sponza 类似的庭院：一圈柱廊，柱廊之后是两层的墙与房间，物体散布在庭院与房间中
+    std::vector<Mesh> occluders{};
+    constexpr float kHalfSize = 20;
+    for (int side = 0; side < 4; ++side) {
+        for (int i = 0; i < 10; ++i) {
+            float t = -kHalfSize + 2 + i * 4;
+            Float3 center = side < 2 ? Float3{t, 0, side == 0 ? -kHalfSize : kHalfSize} : Float3{side == 2 ? -kHalfSize : kHalfSize, 0, t};
+            occluders.push_back(MakeBox({center.x - 0.5f, 0, center.z - 0.5f}, {center.x + 0.5f, 8, center.z + 0.5f}));
+        }
+        // 墙的下层有门洞，上层完整
+        float outer = kHalfSize + 4;
+        for (int i = 0; i < 8; ++i) {
+            float t0 = -outer + i * 6, t1 = t0 + 5;
+            occluders.push_back(side < 2
+                ? MakeBox({t0, 0, side == 0 ? -outer : outer - 0.5f}, {t1, 6, side == 0 ? -outer + 0.5f : outer})
+                : MakeBox({side == 2 ? -outer : outer - 0.5f, 0, t0}, {side == 2 ? -outer + 0.5f : outer, 6, t1}));
+        }
+        occluders.push_back(side < 2
+            ? MakeBox({-outer, 6, side == 0 ? -outer : outer - 0.5f}, {outer, 14, side == 0 ? -outer + 0.5f : outer})
+            : MakeBox({side == 2 ? -outer : outer - 0.5f, 6, -outer}, {side == 2 ? -outer + 0.5f : outer, 14, outer}));
+    }
+
+    std::vector<Box> objects{};
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    for (int i = 0; i < 20000; ++i) {
+        float x = (unit(rng) * 2 - 1) * 40, z = (unit(rng) * 2 - 1) * 40, y = unit(rng) * 10;
+        float size = 0.2f + unit(rng) * 0.8f;
+        objects.push_back({{x, y, z}, {x + size, y + size, z + size}});
+    }
+
+    std::vector<std::uint32_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+    for (auto threads : threadCounts) {
+        OcclusionCullerDesc desc{};
+        desc.m_NumThreads = threads;
+        OcclusionCuller culler{desc};
+        auto aspect = float(culler.GetWidth()) / culler.GetHeight();
+
+        // 相机绕庭院一周，朝向庭院中心之外
+        constexpr int kNumFrames = 32;
+        std::uint64_t numInFrustum = 0, numOccluded = 0;
+        double rasterizeSeconds = 0, testSeconds = 0;
+        for (int frame = 0; frame < kNumFrames; ++frame) {
+            float angle = frame * 6.2831853f / kNumFrames;
+            Float3 eye{std::cos(angle) * 8, 2, std::sin(angle) * 8};
+            Float3 target{std::cos(angle + 0.8f) * 30, 3, std::sin(angle + 0.8f) * 30};
+            auto viewProj = MakeViewProj(eye, target, aspect);
+
+            rasterizeSeconds += Test::MeasureSeconds([&]() { RasterizeMeshes(culler, occluders, viewProj); }, 0.01, 20);
+            std::vector<const Box*> candidates{};
+            for (const auto& object : objects) {
+                if (!IsOutsideFrustum(object, viewProj)) candidates.push_back(&object);
+            }
+            std::uint32_t occluded = 0;
+            testSeconds += Test::MeasureSeconds([&]() {
+                occluded = 0;
+                for (const auto* object : candidates) occluded += !IsVisible(culler, *object, viewProj);
+            }, 0.01, 20);
+            numInFrustum += candidates.size();
+            numOccluded += occluded;
+        }
+
+        std::printf("  %u threads\n", threads);
+        Test::ReportMetric("Rasterize occluders", rasterizeSeconds / kNumFrames * 1e3, "ms/frame");
+        Test::ReportMetric("Test frustum-visible boxes", testSeconds / kNumFrames * 1e3, "ms/frame");
+        Test::ReportMetric("Boxes in frustum", double(numInFrustum) / kNumFrames, "/frame");
+        Test::ReportMetric("Culled by occlusion", 100.0 * numOccluded / (std::max)(numInFrustum, std::uint64_t(1)), "%");
+    }
+}
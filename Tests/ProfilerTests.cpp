@@ -0,0 +1,548 @@
+#include "TestFramework.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    constexpr std::uint64_t kMs = 1000000;
+
+    ProfileEvent MakeEvent(const char* name, std::uint64_t beginMs, std::uint64_t endMs, std::uint32_t depth, std::uint32_t thread = 0)
+    {
+        return {name, beginMs * kMs, endMs * kMs, thread, depth};
+    }
+
+    bool NearlyEqual(double a, double b)
+    {
+        return std::abs(a - b) < 1e-9;
+    }
+
+    // 在 parent 下按名字查找子节点
+    const ProfileNode* FindChild(const ProfileFrame& frame, const ProfileNode& parent, const char* name)
+    {
+        for (auto child : parent.m_Children) {
+            const auto& node = frame.m_Nodes[child];
+            if (node.m_Name != nullptr && std::strcmp(node.m_Name, name) == 0) {
+                return &node;
+            }
+        }
+        return nullptr;
+    }
+
+    const ProfileNode* FindThread(const ProfileFrame& frame, std::uint32_t threadIndex)
+    {
+        for (auto child : frame.GetRoot().m_Children) {
+            const auto& node = frame.m_Nodes[child];
+            if (node.m_Name == nullptr && node.m_ThreadIndex == threadIndex) {
+                return &node;
+            }
+        }
+        return nullptr;
+    }
+
+    // 丢弃其它测试残留在分析器中的事件
+    void DrainProfiler()
+    {
+        g_Profiler.SetEnabled(true);
+        g_Profiler.BeginFrame();
+        g_Profiler.EndFrame();
+    }
+
+    // 最小的 JSON 解析器，只用于校验导出的 Trace
+    struct JsonValue
+    {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type m_Type = Type::Null;
+        bool m_Bool{};
+        double m_Number{};
+        std::string m_String{};
+        std::vector<JsonValue> m_Array{};
+        std::map<std::string, JsonValue> m_Object{};
+
+        const JsonValue* Find(const std::string& key) const
+        {
+            auto it = m_Object.find(key);
+            return it == m_Object.end() ? nullptr : &it->second;
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string& text) : m_Text(text) {}
+
+        bool Parse(JsonValue& value)
+        {
+            if (!ParseValue(value)) return false;
+            SkipSpace();
+            return m_Pos == m_Text.size();
+        }
+
+    private:
+        void SkipSpace()
+        {
+            while (m_Pos < m_Text.size() && std::isspace(static_cast<unsigned char>(m_Text[m_Pos]))) ++m_Pos;
+        }
+
+        bool Consume(char c)
+        {
+            SkipSpace();
+            if (m_Pos < m_Text.size() && m_Text[m_Pos] == c) {
+                ++m_Pos;
+                return true;
+            }
+            return false;
+        }
+
+        bool ConsumeWord(const char* word)
+        {
+            auto len = std::strlen(word);
+            if (m_Text.compare(m_Pos, len, word) != 0) return false;
+            m_Pos += len;
+            return true;
+        }
+
+        bool ParseString(std::string& str)
+        {
+            if (!Consume('"')) return false;
+            while (m_Pos < m_Text.size()) {
+                char c = m_Text[m_Pos++];
+                if (c == '"') return true;
+                // 字符串中不允许出现未转义的控制字符
+                if (static_cast<unsigned char>(c) < 0x20) return false;
+                if (c != '\\') {
+                    str += c;
+                    continue;
+                }
+                if (m_Pos >= m_Text.size()) return false;
+                switch (m_Text[m_Pos++]) {
+                    case '"': str += '"'; break;
+                    case '\\': str += '\\'; break;
+                    case '/': str += '/'; break;
+                    case 'n': str += '\n'; break;
+                    case 't': str += '\t'; break;
+                    case 'r': str += '\r'; break;
+                    case 'b': str += '\b'; break;
+                    case 'f': str += '\f'; break;
+                    default: return false;
+                }
+            }
+            return false;
+        }
+
+        bool ParseNumber(double& number)
+        {
+            auto begin = m_Pos;
+            if (m_Pos < m_Text.size() && m_Text[m_Pos] == '-') ++m_Pos;
+            auto digits = m_Pos;
+            while (m_Pos < m_Text.size() && std::isdigit(static_cast<unsigned char>(m_Text[m_Pos]))) ++m_Pos;
+            if (m_Pos == digits) return false;
+            if (m_Pos < m_Text.size() && m_Text[m_Pos] == '.') {
+                auto fraction = ++m_Pos;
+                while (m_Pos < m_Text.size() && std::isdigit(static_cast<unsigned char>(m_Text[m_Pos]))) ++m_Pos;
+                if (m_Pos == fraction) return false;
+            }
+            number = std::stod(m_Text.substr(begin, m_Pos - begin));
+            return true;
+        }
+
+        bool ParseValue(JsonValue& value)
+        {
+            SkipSpace();
+            if (m_Pos >= m_Text.size()) return false;
+            char c = m_Text[m_Pos];
+            if (c == '{') {
+                ++m_Pos;
+                value.m_Type = JsonValue::Type::Object;
+                if (Consume('}')) return true;
+                do {
+                    std::string key{};
+                    JsonValue member{};
+                    if (!ParseString(key) || !Consume(':') || !ParseValue(member)) return false;
+                    // 重复的键视为非法
+                    if (!value.m_Object.emplace(std::move(key), std::move(member)).second) return false;
+                } while (Consume(','));
+                return Consume('}');
+            }
+            if (c == '[') {
+                ++m_Pos;
+                value.m_Type = JsonValue::Type::Array;
+                if (Consume(']')) return true;
+                do {
+                    if (!ParseValue(value.m_Array.emplace_back())) return false;
+                } while (Consume(','));
+                return Consume(']');
+            }
+            if (c == '"') {
+                value.m_Type = JsonValue::Type::String;
+                return ParseString(value.m_String);
+            }
+            if (ConsumeWord("true")) {
+                value.m_Type = JsonValue::Type::Bool;
+                value.m_Bool = true;
+                return true;
+            }
+            if (ConsumeWord("false")) {
+                value.m_Type = JsonValue::Type::Bool;
+                return true;
+            }
+            if (ConsumeWord("null")) {
+                return true;
+            }
+            value.m_Type = JsonValue::Type::Number;
+            return ParseNumber(value.m_Number);
+        }
+
+    private:
+        const std::string& m_Text;
+        std::size_t m_Pos{};
+    };
+
+    bool HasMember(const JsonValue& object, const char* key, JsonValue::Type type)
+    {
+        auto member = object.Find(key);
+        return member != nullptr && member->m_Type == type;
+    }
+
+    // 在工作线程中记录 Outer > Inner x numInner > Leaf 的嵌套区间
+    void RecordNestedScopes(std::uint32_t numInner)
+    {
+        PROFILE_SCOPE("Profiler.Outer");
+        for (std::uint32_t i = 0; i < numInner; ++i) {
+            PROFILE_SCOPE("Profiler.Inner");
+            PROFILE_SCOPE("Profiler.Leaf");
+        }
+    }
+}
+
+TEST_CASE(Profiler_EventBufferWrapsAndDrops)
+{
+    // 容量会向上取整为 2 的幂
+    ProfileEventBuffer buffer{3, 6};
+    CHECK(buffer.GetThreadIndex() == 3);
+
+    std::vector<std::uint64_t> drained{};
+    auto drain = [&]() {
+        drained.clear();
+        buffer.Drain([&](const ProfileEvent& event) { drained.push_back(event.m_BeginTime); });
+    };
+
+    std::uint64_t next = 0;
+    for (std::uint32_t i = 0; i < 8; ++i) {
+        CHECK(buffer.Push(MakeEvent("E", next, next, 0)));
+        ++next;
+    }
+    // 满了以后丢弃新事件而不是覆盖旧事件
+    CHECK(!buffer.Push(MakeEvent("E", 100, 100, 0)));
+    CHECK(!buffer.Push(MakeEvent("E", 101, 101, 0)));
+    CHECK(buffer.GetNumDropped() == 2);
+
+    drain();
+    REQUIRE(drained.size() == 8);
+    for (std::uint32_t i = 0; i < 8; ++i) {
+        CHECK(drained[i] == i * kMs);
+    }
+
+    // 多次绕回后仍按提交顺序取出
+    for (std::uint32_t round = 0; round < 5; ++round) {
+        auto first = next;
+        for (std::uint32_t i = 0; i < 5; ++i) {
+            CHECK(buffer.Push(MakeEvent("E", next, next, 0)));
+            ++next;
+        }
+        drain();
+        REQUIRE(drained.size() == 5);
+        for (std::uint32_t i = 0; i < 5; ++i) {
+            CHECK(drained[i] == (first + i) * kMs);
+        }
+    }
+    drain();
+    CHECK(drained.empty());
+    CHECK(buffer.GetNumDropped() == 2);
+}
+
+TEST_CASE(Profiler_CountsDroppedEventsPerThread)
+{
+    DrainProfiler();
+    auto droppedBefore = g_Profiler.GetNumDroppedEvents();
+
+    // 新线程拥有空的缓冲区，超出容量的区间被计为丢弃
+    constexpr std::uint32_t kNumOverflow = 100;
+    std::thread worker{[]() {
+        for (std::uint32_t i = 0; i < Profiler::sm_EventBufferCapacity + kNumOverflow; ++i) {
+            PROFILE_SCOPE("Profiler.Flood");
+        }
+    }};
+    worker.join();
+    CHECK(g_Profiler.GetNumDroppedEvents() - droppedBefore == kNumOverflow);
+
+    // 线程退出后其事件仍能被收集
+    g_Profiler.BeginFrame();
+    g_Profiler.EndFrame();
+    std::uint32_t numFlood = 0;
+    const auto& frame = g_Profiler.GetLastFrame();
+    for (auto child : frame.GetRoot().m_Children) {
+        if (auto flood = FindChild(frame, frame.m_Nodes[child], "Profiler.Flood")) {
+            numFlood += flood->m_CallCount;
+        }
+    }
+    CHECK(numFlood == Profiler::sm_EventBufferCapacity);
+}
+
+TEST_CASE(Profiler_BuildFrameTreeNestsAndTotals)
+{
+    // 按结束顺序提交，线程 1 的事件混在其中
+    std::vector<ProfileEvent> events{
+        MakeEvent("B", 1, 3, 1),
+        MakeEvent("D", 0, 2, 0, 1),
+        MakeEvent("C", 5, 6, 2),
+        MakeEvent("B", 4, 8, 1),
+        MakeEvent("A", 0, 10, 0),
+        // 与父节点同时开始的子区间
+        MakeEvent("E", 20, 22, 1),
+        MakeEvent("F", 20, 25, 0),
+        MakeEvent("D", 3, 7, 0, 1),
+    };
+    std::shuffle(events.begin(), events.end(), std::mt19937{7});
+
+    ProfileFrame frame{};
+    frame.m_Nodes.resize(3);
+    Profiler::BuildFrameTree(events, frame);
+    REQUIRE(frame.m_Nodes.size() == 9);
+    CHECK(frame.GetRoot().m_Children.size() == 2);
+
+    auto thread0 = FindThread(frame, 0);
+    auto thread1 = FindThread(frame, 1);
+    REQUIRE(thread0 != nullptr && thread1 != nullptr);
+    // 线程节点的时间只累加顶层区间
+    CHECK(NearlyEqual(thread0->m_TotalTime, 15));
+    CHECK(NearlyEqual(thread1->m_TotalTime, 6));
+    CHECK(thread0->m_Children.size() == 2);
+
+    auto a = FindChild(frame, *thread0, "A");
+    auto f = FindChild(frame, *thread0, "F");
+    REQUIRE(a != nullptr && f != nullptr);
+    CHECK(a->m_CallCount == 1);
+    CHECK(NearlyEqual(a->m_TotalTime, 10));
+    CHECK(a->m_Children.size() == 1);
+    CHECK(NearlyEqual(f->m_TotalTime, 5));
+    CHECK(f->m_Children.size() == 1);
+
+    auto b = FindChild(frame, *a, "B");
+    auto e = FindChild(frame, *f, "E");
+    REQUIRE(b != nullptr && e != nullptr);
+    CHECK(b->m_CallCount == 2);
+    CHECK(NearlyEqual(b->m_TotalTime, 6));
+    CHECK(NearlyEqual(b->m_MaxTime, 4));
+    CHECK(e->m_CallCount == 1);
+    CHECK(NearlyEqual(e->m_TotalTime, 2));
+
+    auto c = FindChild(frame, *b, "C");
+    REQUIRE(c != nullptr);
+    CHECK(c->m_CallCount == 1);
+    CHECK(NearlyEqual(c->m_TotalTime, 1));
+    CHECK(c->m_Children.empty());
+    CHECK(&frame.m_Nodes[frame.m_Nodes[c->m_Parent].m_Parent] == a);
+
+    auto d = FindChild(frame, *thread1, "D");
+    REQUIRE(d != nullptr);
+    CHECK(d->m_CallCount == 2);
+    CHECK(NearlyEqual(d->m_MaxTime, 4));
+    CHECK(FindChild(frame, *thread1, "A") == nullptr);
+
+    // 每个子节点的时间之和不超过父节点
+    for (const auto& node : frame.m_Nodes) {
+        double childTime = 0;
+        for (auto child : node.m_Children) childTime += frame.m_Nodes[child].m_TotalTime;
+        if (&node != &frame.GetRoot()) {
+            CHECK(childTime <= node.m_TotalTime + 1e-9);
+        }
+    }
+}
+
+TEST_CASE(Profiler_CapturesNestedScopesOnThreads)
+{
+    DrainProfiler();
+
+    constexpr std::uint32_t kNumThreads = 4;
+    std::vector<std::thread> workers{};
+    for (std::uint32_t i = 0; i < kNumThreads; ++i) {
+        workers.emplace_back([i]() { RecordNestedScopes(i + 1); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    g_Profiler.BeginFrame();
+    g_Profiler.EndFrame();
+    const auto& frame = g_Profiler.GetLastFrame();
+
+    // 每个线程各有一棵 Outer > Inner > Leaf 的子树，调用次数与线程一一对应
+    std::vector<std::uint32_t> innerCounts{};
+    for (auto child : frame.GetRoot().m_Children) {
+        const auto& thread = frame.m_Nodes[child];
+        auto outer = FindChild(frame, thread, "Profiler.Outer");
+        if (outer == nullptr) continue;
+
+        CHECK(thread.m_Children.size() == 1);
+        CHECK(outer->m_CallCount == 1);
+        CHECK(NearlyEqual(thread.m_TotalTime, outer->m_TotalTime));
+        CHECK(outer->m_Children.size() == 1);
+        auto inner = FindChild(frame, *outer, "Profiler.Inner");
+        REQUIRE(inner != nullptr);
+        auto leaf = FindChild(frame, *inner, "Profiler.Leaf");
+        REQUIRE(leaf != nullptr);
+        CHECK(leaf->m_CallCount == inner->m_CallCount);
+        CHECK(leaf->m_TotalTime <= inner->m_TotalTime);
+        CHECK(inner->m_TotalTime <= outer->m_TotalTime);
+        innerCounts.push_back(inner->m_CallCount);
+    }
+    std::sort(innerCounts.begin(), innerCounts.end());
+    CHECK(innerCounts == std::vector<std::uint32_t>({1, 2, 3, 4}));
+    CHECK(Profiler::GetThreadDepth() == 0);
+
+    // 禁用后不再记录
+    g_Profiler.SetEnabled(false);
+    RecordNestedScopes(2);
+    g_Profiler.SetEnabled(true);
+    g_Profiler.BeginFrame();
+    g_Profiler.EndFrame();
+    CHECK(g_Profiler.GetLastFrame().GetRoot().m_Children.empty());
+}
+
+TEST_CASE(Profiler_ExportsValidChromeTrace)
+{
+    DrainProfiler();
+    g_Profiler.BeginCapture();
+
+    std::thread worker{[]() {
+        g_Profiler.SetThreadName("Profiler \"Worker\"\n\\");
+        RecordNestedScopes(2);
+    }};
+    worker.join();
+    {
+        PROFILE_SCOPE("Profiler.\"Quoted\"\tName\x01");
+    }
+    g_Profiler.BeginFrame();
+    g_Profiler.EndFrame();
+    g_Profiler.EndCapture();
+
+    const auto& captured = g_Profiler.GetCapturedEvents();
+    CHECK(captured.size() == 6);
+
+    std::ostringstream out{};
+    g_Profiler.ExportChromeTrace(out);
+    auto text = out.str();
+
+    JsonValue root{};
+    REQUIRE(JsonParser{text}.Parse(root));
+    REQUIRE(root.m_Type == JsonValue::Type::Object);
+    REQUIRE(HasMember(root, "traceEvents", JsonValue::Type::Array));
+    CHECK(HasMember(root, "displayTimeUnit", JsonValue::Type::String));
+
+    std::map<std::string, std::uint32_t> counts{};
+    std::map<double, std::string> threadNames{};
+    std::uint32_t numDurations = 0;
+    for (const auto& event : root.Find("traceEvents")->m_Array) {
+        REQUIRE(event.m_Type == JsonValue::Type::Object);
+        REQUIRE(HasMember(event, "name", JsonValue::Type::String));
+        REQUIRE(HasMember(event, "ph", JsonValue::Type::String));
+        CHECK(HasMember(event, "pid", JsonValue::Type::Number));
+        REQUIRE(HasMember(event, "tid", JsonValue::Type::Number));
+
+        auto tid = event.Find("tid")->m_Number;
+        const auto& phase = event.Find("ph")->m_String;
+        if (phase == "M") {
+            auto args = event.Find("args");
+            REQUIRE(args != nullptr && HasMember(*args, "name", JsonValue::Type::String));
+            CHECK(event.Find("name")->m_String == "thread_name");
+            threadNames[tid] = args->Find("name")->m_String;
+            continue;
+        }
+
+        // 完整事件需给出以微秒计的开始时间与时长
+        CHECK(phase == "X");
+        REQUIRE(HasMember(event, "ts", JsonValue::Type::Number));
+        REQUIRE(HasMember(event, "dur", JsonValue::Type::Number));
+        CHECK(event.Find("dur")->m_Number >= 0);
+        // 元数据事件先于区间事件输出
+        CHECK(threadNames.count(tid) == 1);
+        ++counts[event.Find("name")->m_String];
+        ++numDurations;
+    }
+    CHECK(numDurations == captured.size());
+    CHECK(counts["Profiler.Outer"] == 1);
+    CHECK(counts["Profiler.Inner"] == 2);
+    CHECK(counts["Profiler.Leaf"] == 2);
+    // 其余控制字符被替换为空格
+    CHECK(counts["Profiler.\"Quoted\"\tName "] == 1);
+
+    // 转义后的线程名能原样还原
+    bool foundWorker = false;
+    for (const auto& [tid, name] : threadNames) {
+        foundWorker |= name == "Profiler \"Worker\"\n\\";
+    }
+    CHECK(foundWorker);
+
+    // 时间戳与捕获的事件一致
+    for (const auto& event : captured) {
+        if (std::strcmp(event.m_Name, "Profiler.Outer") != 0) continue;
+        auto ts = std::to_string(event.m_BeginTime / 1000) + ".";
+        CHECK(text.find("\"ts\":" + ts) != std::string::npos);
+    }
+}
+
+BENCHMARK_CASE(Profiler_ScopeOverhead)
+{
+    constexpr std::uint32_t kNumScopes = 4096;
+    DrainProfiler();
+
+    // 简单的计算防止循环被优化掉
+    volatile std::uint32_t sink = 0;
+    auto run = [&](bool withScope) {
+        double seconds = 0;
+        std::uint32_t numRuns = 0;
+        while (seconds < 0.2 && numRuns < 1000) {
+            Test::BenchTimer timer{};
+            for (std::uint32_t i = 0; i < kNumScopes; ++i) {
+                if (withScope) {
+                    PROFILE_SCOPE("Profiler.Bench");
+                    sink = sink + i;
+                }
+                else {
+                    sink = sink + i;
+                }
+            }
+            seconds += timer.ElapsedSeconds();
+            ++numRuns;
+            // 取出事件以免缓冲区写满后走丢弃路径，不计入耗时
+            g_Profiler.BeginFrame();
+            g_Profiler.EndFrame();
+        }
+        return seconds / (double(numRuns) * kNumScopes) * 1e9;
+    };
+
+    auto droppedBefore = g_Profiler.GetNumDroppedEvents();
+    auto baseline = run(false);
+    auto enabled = run(true);
+    g_Profiler.SetEnabled(false);
+    auto disabled = run(true);
+    g_Profiler.SetEnabled(true);
+    CHECK(g_Profiler.GetNumDroppedEvents() == droppedBefore);
+
+    Test::ReportMetric("Loop without scope", baseline, "ns");
+    Test::ReportMetric("PROFILE_SCOPE, enabled", enabled, "ns");
+    Test::ReportMetric("PROFILE_SCOPE, runtime disabled", disabled, "ns");
+    Test::ReportMetric("Disabled overhead", (std::max)(disabled - baseline, 0.0), "ns");
+}
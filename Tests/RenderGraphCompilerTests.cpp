@@ -0,0 +1,627 @@
+#include "TestFramework.h"
+#include "Graphics/RenderGraph/RenderGraphCompiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 与 D3D12_RESOURCE_STATES 相同
+    constexpr std::uint32_t kPresent = 0;
+    constexpr std::uint32_t kRenderTarget = 0x4;
+    constexpr std::uint32_t kUnorderedAccess = 0x8;
+    constexpr std::uint32_t kDepthWrite = 0x10;
+    constexpr std::uint32_t kDepthRead = 0x20;
+    constexpr std::uint32_t kNonPixelShaderResource = 0x40;
+    constexpr std::uint32_t kPixelShaderResource = 0x80;
+    constexpr std::uint32_t kCopyDest = 0x400;
+    constexpr std::uint32_t kCopySource = 0x800;
+
+    constexpr std::uint64_t kMiB = 1024 * 1024;
+
+    RGResourceDesc MakeTransient(std::string name, std::uint64_t size, std::uint32_t heapGroup = 0)
+    {
+        RGResourceDesc desc{};
+        desc.m_Name = std::move(name);
+        desc.m_Size = size;
+        desc.m_Alignment = 64 * 1024;
+        desc.m_HeapGroup = heapGroup;
+        return desc;
+    }
+
+    RGResourceDesc MakeImported(std::string name, std::uint32_t initialState, std::uint32_t finalState)
+    {
+        RGResourceDesc desc{};
+        desc.m_Name = std::move(name);
+        desc.m_Imported = true;
+        desc.m_InitialState = initialState;
+        desc.m_HasFinalState = true;
+        desc.m_FinalState = finalState;
+        return desc;
+    }
+
+    std::uint32_t CountBarriers(const std::vector<RGBarrier>& barriers, RGBarrierType type, std::uint32_t resource)
+    {
+        return static_cast<std::uint32_t>(std::count_if(barriers.begin(), barriers.end(), [&](const RGBarrier& barrier) {
+            return barrier.m_Type == type && barrier.m_Resource == resource;
+        }));
+    }
+
+    // 按执行顺序回放屏障，检查每次访问时资源处于需要的状态、屏障的前后状态连续且内存复用没有冲突
+    bool IsValidPlan(std::span<const RGResourceDesc> resources, std::span<const RGPassDesc> passes, const RenderGraphPlan& plan)
+    {
+        auto fail = [](const std::string& error) {
+            std::printf("  %s\n", error.c_str());
+            return false;
+        };
+
+        std::vector<std::uint32_t> states(resources.size());
+        std::vector<bool> aliasingDone(resources.size(), false);
+        for (std::size_t i = 0; i < resources.size(); ++i) {
+            states[i] = resources[i].m_Imported ? resources[i].m_InitialState : RenderGraphCompiler::sm_UnknownState;
+        }
+        auto apply = [&](const RGBarrier& barrier, const std::string& where) {
+            if (barrier.m_Type == RGBarrierType::kAliasing) {
+                aliasingDone[barrier.m_Resource] = true;
+                return true;
+            }
+            if (states[barrier.m_Resource] != barrier.m_StateBefore) {
+                return fail(where + ": barrier of " + resources[barrier.m_Resource].m_Name + " starts from a wrong state");
+            }
+            if (barrier.m_Type == RGBarrierType::kUAV && barrier.m_StateBefore != kUnorderedAccess) {
+                return fail(where + ": UAV barrier outside of UNORDERED_ACCESS");
+            }
+            states[barrier.m_Resource] = barrier.m_StateAfter;
+            return true;
+        };
+
+        for (const auto& barrier : plan.m_InitialBarriers) {
+            if (!apply(barrier, "initial")) return false;
+        }
+        for (std::uint32_t order = 0; order < plan.m_PassOrder.size(); ++order) {
+            const auto& pass = passes[plan.m_PassOrder[order]];
+            for (const auto& barrier : plan.m_PassBarriers[order]) {
+                if (!apply(barrier, pass.m_Name)) return false;
+                if (pass.m_Queue == RGQueue::kCompute && barrier.m_Type == RGBarrierType::kTransition &&
+                    !(RenderGraphCompiler::IsComputeQueueState(barrier.m_StateBefore) && RenderGraphCompiler::IsComputeQueueState(barrier.m_StateAfter))) {
+                    return fail(pass.m_Name + ": compute queue transition uses graphics states");
+                }
+            }
+            for (const auto& access : pass.m_Accesses) {
+                auto state = states[access.m_Resource];
+                bool ready = access.m_Write ? state == access.m_State : (state != RenderGraphCompiler::sm_UnknownState && (state & access.m_State) == access.m_State);
+                if (!ready) return fail(pass.m_Name + ": " + resources[access.m_Resource].m_Name + " is in a wrong state");
+                if (plan.m_Placements[access.m_Resource].m_Aliased && !aliasingDone[access.m_Resource]) {
+                    return fail(pass.m_Name + ": " + resources[access.m_Resource].m_Name + " used before its aliasing barrier");
+                }
+            }
+            for (const auto& barrier : plan.m_Schedules[order].m_EndBarriers) {
+                if (!apply(barrier, pass.m_Name + " end")) return false;
+            }
+        }
+        for (const auto& barrier : plan.m_FinalBarriers) {
+            if (!apply(barrier, "final")) return false;
+        }
+        for (std::size_t i = 0; i < resources.size(); ++i) {
+            if (resources[i].m_Imported && resources[i].m_HasFinalState && states[i] != resources[i].m_FinalState) {
+                return fail(resources[i].m_Name + " does not end in its final state");
+            }
+        }
+
+        // 内存重叠的资源生命周期不能重叠
+        for (std::size_t a = 0; a < resources.size(); ++a) {
+            const auto& pa = plan.m_Placements[a];
+            if (pa.m_HeapGroup == RenderGraphCompiler::sm_InvalidIndex) continue;
+            if (pa.m_Offset % resources[a].m_Alignment != 0) return fail(resources[a].m_Name + " is misaligned");
+            if (pa.m_Offset + resources[a].m_Size > plan.m_Heaps[pa.m_HeapGroup].m_Size) return fail(resources[a].m_Name + " exceeds its heap");
+            for (std::size_t b = a + 1; b < resources.size(); ++b) {
+                const auto& pb = plan.m_Placements[b];
+                if (pb.m_HeapGroup != pa.m_HeapGroup) continue;
+                bool memoryOverlap = pa.m_Offset < pb.m_Offset + resources[b].m_Size && pb.m_Offset < pa.m_Offset + resources[a].m_Size;
+                bool lifetimeOverlap = pa.m_FirstPass <= pb.m_LastPass && pb.m_FirstPass <= pa.m_LastPass;
+                if (memoryOverlap && (lifetimeOverlap || pa.m_UsedByAsyncCompute || pb.m_UsedByAsyncCompute)) {
+                    return fail(resources[a].m_Name + " and " + resources[b].m_Name + " share memory while alive");
+                }
+                if (memoryOverlap && !(pa.m_Aliased && pb.m_Aliased)) {
+                    return fail(resources[a].m_Name + " and " + resources[b].m_Name + " share memory without aliasing barriers");
+                }
+            }
+        }
+        return true;
+    }
+
+    // 模拟图形与计算两个队列，按提交顺序执行并在等待处阻塞，返回整帧的时间
+    struct QueueSimulation
+    {
+        std::vector<double> m_PassStart{};
+        std::vector<double> m_PassEnd{};
+        // 每个 Pass 开始前一定已经执行完的 Pass
+        std::vector<std::vector<bool>> m_CompletedBefore{};
+        std::vector<bool> m_CompletedBeforeFinal{};
+        double m_FrameTime = 0;
+    };
+
+    bool SimulateQueues(const RenderGraphPlan& plan, std::span<const double> durations, QueueSimulation& simulation)
+    {
+        auto numPasses = plan.m_PassOrder.size();
+        simulation.m_PassStart.assign(numPasses, 0);
+        simulation.m_PassEnd.assign(numPasses, 0);
+        simulation.m_CompletedBefore.assign(numPasses, std::vector<bool>(numPasses, false));
+
+        double queueTime[2]{};
+        std::uint32_t lastPass[2]{RenderGraphCompiler::sm_InvalidIndex, RenderGraphCompiler::sm_InvalidIndex};
+        auto inherit = [&](std::vector<bool>& completed, std::uint32_t pass) {
+            completed[pass] = true;
+            for (std::size_t i = 0; i < numPasses; ++i) {
+                if (simulation.m_CompletedBefore[pass][i]) completed[i] = true;
+            }
+        };
+
+        for (std::uint32_t pass = 0; pass < numPasses; ++pass) {
+            const auto& schedule = plan.m_Schedules[pass];
+            auto queue = static_cast<std::size_t>(schedule.m_Queue);
+            auto& completed = simulation.m_CompletedBefore[pass];
+            auto start = queueTime[queue];
+            if (lastPass[queue] != RenderGraphCompiler::sm_InvalidIndex) inherit(completed, lastPass[queue]);
+
+            if (schedule.m_WaitPass != RenderGraphCompiler::sm_InvalidIndex) {
+                const auto& waited = plan.m_Schedules[schedule.m_WaitPass];
+                // 只能等待另一个队列上更早提交并发出信号的 Pass
+                if (schedule.m_WaitPass >= pass || waited.m_Queue == schedule.m_Queue || !waited.m_Signal) return false;
+                start = (std::max)(start, simulation.m_PassEnd[schedule.m_WaitPass]);
+                inherit(completed, schedule.m_WaitPass);
+            }
+            if (schedule.m_WaitInitial && !plan.m_SignalInitial) return false;
+
+            simulation.m_PassStart[pass] = start;
+            simulation.m_PassEnd[pass] = start + durations[pass];
+            queueTime[queue] = simulation.m_PassEnd[pass];
+            lastPass[queue] = pass;
+        }
+
+        simulation.m_CompletedBeforeFinal.assign(numPasses, false);
+        if (lastPass[0] != RenderGraphCompiler::sm_InvalidIndex) {
+            inherit(simulation.m_CompletedBeforeFinal, lastPass[0]);
+        }
+        simulation.m_FrameTime = queueTime[0];
+        if (plan.m_FinalWaitPass != RenderGraphCompiler::sm_InvalidIndex) {
+            if (!plan.m_Schedules[plan.m_FinalWaitPass].m_Signal) return false;
+            inherit(simulation.m_CompletedBeforeFinal, plan.m_FinalWaitPass);
+            simulation.m_FrameTime = (std::max)(queueTime[0], simulation.m_PassEnd[plan.m_FinalWaitPass]);
+        }
+        return true;
+    }
+
+    // 同一资源相邻的两次访问之间必须有先后关系，计算 Pass 在初始屏障之后执行，最终屏障之前所有 Pass 都已执行完
+    bool IsValidSchedule(std::span<const RGResourceDesc> resources, std::span<const RGPassDesc> passes, const RenderGraphPlan& plan)
+    {
+        std::vector<double> durations(plan.m_PassOrder.size(), 1.0);
+        QueueSimulation simulation{};
+        if (!SimulateQueues(plan, durations, simulation)) {
+            std::printf("  invalid queue wait\n");
+            return false;
+        }
+
+        std::vector<std::uint32_t> lastAccess(resources.size(), RenderGraphCompiler::sm_InvalidIndex);
+        for (std::uint32_t order = 0; order < plan.m_PassOrder.size(); ++order) {
+            const auto& pass = passes[plan.m_PassOrder[order]];
+            if (pass.m_Queue != plan.m_Schedules[order].m_Queue) {
+                std::printf("  %s runs on the wrong queue\n", pass.m_Name.c_str());
+                return false;
+            }
+            for (const auto& access : pass.m_Accesses) {
+                auto prev = lastAccess[access.m_Resource];
+                if (prev != RenderGraphCompiler::sm_InvalidIndex && !simulation.m_CompletedBefore[order][prev]) {
+                    std::printf("  %s may overlap %s on %s\n", pass.m_Name.c_str(), passes[plan.m_PassOrder[prev]].m_Name.c_str(),
+                        resources[access.m_Resource].m_Name.c_str());
+                    return false;
+                }
+                lastAccess[access.m_Resource] = order;
+            }
+        }
+
+        // 第一个计算 Pass 需要在初始屏障之后执行
+        for (std::uint32_t order = 0; order < plan.m_PassOrder.size(); ++order) {
+            const auto& schedule = plan.m_Schedules[order];
+            if (schedule.m_Queue != RGQueue::kCompute) continue;
+            if (!schedule.m_WaitInitial && schedule.m_WaitPass == RenderGraphCompiler::sm_InvalidIndex) {
+                std::printf("  first compute pass does not wait for the graphics queue\n");
+                return false;
+            }
+            break;
+        }
+        for (std::uint32_t order = 0; order < plan.m_PassOrder.size(); ++order) {
+            if (!simulation.m_CompletedBeforeFinal[order]) {
+                std::printf("  final barriers may overlap %s\n", passes[plan.m_PassOrder[order]].m_Name.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 随机生成的渲染图，计算 Pass 只使用计算队列支持的状态
+    void MakeRandomGraph(std::uint32_t seed, std::uint32_t numPasses, std::uint32_t numResources, bool asyncCompute,
+        std::vector<RGResourceDesc>& resources, std::vector<RGPassDesc>& passes)
+    {
+        constexpr std::uint32_t kGraphicsWrites[] = {kRenderTarget, kUnorderedAccess, kDepthWrite, kCopyDest};
+        constexpr std::uint32_t kGraphicsReads[] = {kPixelShaderResource, kNonPixelShaderResource, kDepthRead, kCopySource};
+        constexpr std::uint32_t kComputeWrites[] = {kUnorderedAccess, kCopyDest};
+        constexpr std::uint32_t kComputeReads[] = {kNonPixelShaderResource, kCopySource};
+
+        std::mt19937 rng{seed};
+        auto random = [&rng](std::uint32_t count) { return std::uniform_int_distribution<std::uint32_t>{0, count - 1}(rng); };
+
+        resources.clear();
+        passes.clear();
+        for (std::uint32_t i = 0; i < numResources; ++i) {
+            if (random(8) == 0) {
+                resources.push_back(MakeImported("Imported" + std::to_string(i), kPresent, random(2) ? kPresent : kPixelShaderResource));
+            }
+            else {
+                resources.push_back(MakeTransient("Transient" + std::to_string(i), (1 + random(16)) * kMiB, random(2)));
+            }
+        }
+
+        for (std::uint32_t i = 0; i < numPasses; ++i) {
+            RGPassDesc pass{};
+            pass.m_Name = "Pass" + std::to_string(i);
+            pass.m_Queue = asyncCompute && random(3) == 0 ? RGQueue::kCompute : RGQueue::kGraphics;
+            pass.m_HasSideEffects = random(16) == 0;
+            bool compute = pass.m_Queue == RGQueue::kCompute;
+
+            // 访问的资源集中在附近，使生命周期有长有短
+            auto numAccesses = 1 + random(4);
+            auto center = i * numResources / numPasses;
+            for (std::uint32_t a = 0; a < numAccesses; ++a) {
+                auto resource = (std::min)(center + random(16), numResources - 1);
+                if (std::any_of(pass.m_Accesses.begin(), pass.m_Accesses.end(), [resource](const RGAccess& access) {
+                    return access.m_Resource == resource;
+                })) continue;
+
+                bool write = random(2) == 0;
+                auto state = write
+                    ? (compute ? kComputeWrites[random(2)] : kGraphicsWrites[random(4)])
+                    : (compute ? kComputeReads[random(2)] : kGraphicsReads[random(4)]);
+                pass.m_Accesses.push_back({resource, state, write});
+            }
+            passes.push_back(std::move(pass));
+        }
+    }
+}
+
+TEST_CASE(RenderGraphCompiler_CullsUnusedPasses)
+{
+    std::vector<RGResourceDesc> resources{
+        MakeImported("BackBuffer", kPresent, kPresent),
+        MakeTransient("GBuffer", 16 * kMiB),
+        MakeTransient("Debug", 8 * kMiB),
+        MakeTransient("DebugBlur", 8 * kMiB),
+        MakeTransient("Readback", 1 * kMiB),
+    };
+    std::vector<RGPassDesc> passes{
+        {"GBuffer", RGQueue::kGraphics, {{1, kRenderTarget, true}}},
+        // 只被另一个无用的 Pass 读取
+        {"Debug", RGQueue::kGraphics, {{1, kPixelShaderResource, false}, {2, kRenderTarget, true}}},
+        {"DebugBlur", RGQueue::kGraphics, {{2, kPixelShaderResource, false}, {3, kRenderTarget, true}}},
+        {"Lighting", RGQueue::kGraphics, {{1, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+        {"Capture", RGQueue::kGraphics, {{1, kCopySource, false}, {4, kCopyDest, true}}, true},
+    };
+
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    compiler.Compile(resources, passes, plan);
+
+    CHECK(plan.m_PassOrder == std::vector<std::uint32_t>({0, 3, 4}));
+    CHECK(plan.m_Placements[2].m_HeapGroup == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(plan.m_Placements[3].m_HeapGroup == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(plan.m_Placements[0].m_HeapGroup == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(plan.m_Placements[1].m_FirstPass == 0);
+    CHECK(plan.m_Placements[1].m_LastPass == 2);
+    CHECK(IsValidPlan(resources, passes, plan));
+}
+
+TEST_CASE(RenderGraphCompiler_MinimalBarriers)
+{
+    std::vector<RGResourceDesc> resources{
+        MakeImported("BackBuffer", kPresent, kPresent),
+        MakeTransient("Color", 16 * kMiB),
+        // 放在另一个堆中，不与 Color 复用内存
+        MakeTransient("Particles", 4 * kMiB, 1),
+    };
+    std::vector<RGPassDesc> passes{
+        {"Scene", RGQueue::kGraphics, {{1, kRenderTarget, true}}},
+        // 连续的读取合并为一次转换到两个只读状态的组合，只读取的 Pass 需要有副作用才不会被剔除
+        {"Bloom", RGQueue::kGraphics, {{1, kNonPixelShaderResource, false}}, true},
+        {"Tonemap", RGQueue::kGraphics, {{1, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+        // 连续写入 UAV 只需要 UAV 屏障
+        {"Simulate", RGQueue::kGraphics, {{2, kUnorderedAccess, true}}},
+        {"Sort", RGQueue::kGraphics, {{2, kUnorderedAccess, true}}},
+        {"Draw", RGQueue::kGraphics, {{2, kNonPixelShaderResource, false}, {0, kRenderTarget, true}}},
+    };
+
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    compiler.Compile(resources, passes, plan);
+    REQUIRE(plan.m_PassOrder.size() == passes.size());
+    CHECK(IsValidPlan(resources, passes, plan));
+
+    const auto& bloom = plan.m_PassBarriers[1];
+    REQUIRE(CountBarriers(bloom, RGBarrierType::kTransition, 1) == 1);
+    CHECK(bloom[0].m_StateAfter == (kNonPixelShaderResource | kPixelShaderResource));
+    CHECK(CountBarriers(plan.m_PassBarriers[2], RGBarrierType::kTransition, 1) == 0);
+
+    CHECK(CountBarriers(plan.m_PassBarriers[4], RGBarrierType::kUAV, 2) == 1);
+    CHECK(CountBarriers(plan.m_PassBarriers[4], RGBarrierType::kTransition, 2) == 0);
+
+    // 后台缓冲只在第一次写入时转换，最后转回 PRESENT
+    CHECK(CountBarriers(plan.m_PassBarriers[2], RGBarrierType::kTransition, 0) == 1);
+    CHECK(CountBarriers(plan.m_PassBarriers[5], RGBarrierType::kTransition, 0) == 0);
+    REQUIRE(plan.m_FinalBarriers.size() == 1);
+    CHECK(plan.m_FinalBarriers[0].m_StateBefore == kRenderTarget);
+    CHECK(plan.m_FinalBarriers[0].m_StateAfter == kPresent);
+    CHECK(plan.m_NumBarriers == 7);
+}
+
+TEST_CASE(RenderGraphCompiler_AliasesDisjointLifetimes)
+{
+    std::vector<RGResourceDesc> resources{
+        MakeImported("BackBuffer", kPresent, kPresent),
+        MakeTransient("ShadowMap", 32 * kMiB),
+        MakeTransient("SSAO", 8 * kMiB),
+        MakeTransient("Bloom", 16 * kMiB),
+        MakeTransient("Buffer", 4 * kMiB, 1),
+    };
+    std::vector<RGPassDesc> passes{
+        {"Shadow", RGQueue::kGraphics, {{1, kDepthWrite, true}}},
+        {"SSAO", RGQueue::kGraphics, {{1, kPixelShaderResource, false}, {2, kRenderTarget, true}}},
+        {"Lighting", RGQueue::kGraphics, {{2, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+        {"Bloom", RGQueue::kGraphics, {{0, kCopySource, false}, {3, kCopyDest, true}, {4, kUnorderedAccess, true}}},
+        {"Composite", RGQueue::kGraphics, {{3, kPixelShaderResource, false}, {4, kNonPixelShaderResource, false}, {0, kRenderTarget, true}}},
+    };
+
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    compiler.Compile(resources, passes, plan);
+    CHECK(IsValidPlan(resources, passes, plan));
+
+    // Bloom 在 ShadowMap 与 SSAO 都结束后才开始，可以放在它们的内存上
+    const auto& shadow = plan.m_Placements[1];
+    const auto& ssao = plan.m_Placements[2];
+    const auto& bloom = plan.m_Placements[3];
+    CHECK(shadow.m_Offset == 0);
+    CHECK(ssao.m_Offset >= 32 * kMiB);
+    CHECK(bloom.m_Offset == 0);
+    CHECK(shadow.m_Aliased);
+    CHECK(bloom.m_Aliased);
+    CHECK(!ssao.m_Aliased);
+    CHECK(CountBarriers(plan.m_PassBarriers[3], RGBarrierType::kAliasing, 3) == 1);
+    CHECK(plan.m_PassBarriers[3].front().m_Type == RGBarrierType::kAliasing);
+
+    // 不同分组的资源放在不同的堆中
+    REQUIRE(plan.m_Heaps.size() == 2);
+    CHECK(plan.m_Heaps[0].m_Size == 40 * kMiB);
+    CHECK(plan.m_Heaps[1].m_Size == 4 * kMiB);
+    CHECK(plan.m_UnaliasedSize == 60 * kMiB);
+}
+
+TEST_CASE(RenderGraphCompiler_RandomGraphsAreValid)
+{
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    std::vector<RGResourceDesc> resources{};
+    std::vector<RGPassDesc> passes{};
+    for (std::uint32_t seed = 0; seed < 200; ++seed) {
+        MakeRandomGraph(seed, 40, 48, false, resources, passes);
+        compiler.Compile(resources, passes, plan);
+        if (!IsValidPlan(resources, passes, plan)) {
+            std::printf("  seed %u\n", seed);
+            CHECK(false);
+            break;
+        }
+
+        // 有副作用的 Pass 都会保留
+        for (std::uint32_t i = 0; i < passes.size(); ++i) {
+            if (passes[i].m_HasSideEffects) {
+                CHECK(std::find(plan.m_PassOrder.begin(), plan.m_PassOrder.end(), i) != plan.m_PassOrder.end());
+            }
+        }
+        std::uint64_t heapSize = 0;
+        for (const auto& heap : plan.m_Heaps) heapSize += heap.m_Size;
+        CHECK(heapSize <= plan.m_UnaliasedSize);
+    }
+}
+
+TEST_CASE(RenderGraphCompiler_AsyncComputeOverlapsGraphics)
+{
+    std::vector<RGResourceDesc> resources{
+        MakeImported("BackBuffer", kPresent, kPresent),
+        MakeTransient("Depth", 16 * kMiB),
+        MakeTransient("AO", 4 * kMiB),
+        MakeTransient("ShadowMap", 32 * kMiB),
+    };
+    std::vector<RGPassDesc> passes{
+        {"DepthPrepass", RGQueue::kGraphics, {{1, kDepthWrite, true}}},
+        {"SSAO", RGQueue::kCompute, {{1, kNonPixelShaderResource, false}, {2, kUnorderedAccess, true}}},
+        {"Shadow", RGQueue::kGraphics, {{3, kDepthWrite, true}}},
+        {"Lighting", RGQueue::kGraphics, {{1, kDepthRead, false}, {2, kPixelShaderResource, false}, {3, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+    };
+
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    compiler.Compile(resources, passes, plan);
+    REQUIRE(plan.m_PassOrder.size() == 4);
+    CHECK(IsValidPlan(resources, passes, plan));
+    CHECK(IsValidSchedule(resources, passes, plan));
+
+    // SSAO 等待深度，Shadow 与 SSAO 并行，Lighting 等待 SSAO
+    CHECK(plan.m_Schedules[0].m_Signal);
+    CHECK(plan.m_Schedules[1].m_WaitPass == 0);
+    CHECK(!plan.m_Schedules[1].m_WaitInitial);
+    CHECK(plan.m_Schedules[1].m_Signal);
+    CHECK(plan.m_Schedules[2].m_WaitPass == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(plan.m_Schedules[3].m_WaitPass == 1);
+    CHECK(plan.m_FinalWaitPass == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(plan.m_NumQueueWaits == 2);
+
+    // 计算队列上的资源在整帧内独占内存
+    CHECK(plan.m_Placements[1].m_UsedByAsyncCompute);
+    CHECK(plan.m_Placements[2].m_UsedByAsyncCompute);
+    CHECK(!plan.m_Placements[3].m_UsedByAsyncCompute);
+
+    std::vector<double> durations{1.0, 2.0, 2.0, 1.0};
+    QueueSimulation simulation{};
+    REQUIRE(SimulateQueues(plan, durations, simulation));
+    CHECK(simulation.m_PassStart[2] == 1.0);
+    CHECK(simulation.m_FrameTime == 4.0);
+}
+
+TEST_CASE(RenderGraphCompiler_GraphicsStatesAreHandedOffBeforeCompute)
+{
+    std::vector<RGResourceDesc> resources{
+        MakeImported("BackBuffer", kPresent, kPresent),
+        MakeTransient("Color", 16 * kMiB),
+        MakeImported("History", kPixelShaderResource, kPixelShaderResource),
+        MakeTransient("Luminance", 1 * kMiB),
+    };
+    std::vector<RGPassDesc> passes{
+        {"Scene", RGQueue::kGraphics, {{1, kRenderTarget, true}}},
+        // 计算队列无法从 RENDER_TARGET 或 PIXEL_SHADER_RESOURCE 转换
+        {"Exposure", RGQueue::kCompute, {{1, kNonPixelShaderResource, false}, {2, kNonPixelShaderResource, false}, {3, kUnorderedAccess, true}}},
+        {"Tonemap", RGQueue::kGraphics, {{1, kPixelShaderResource, false}, {3, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+    };
+
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    compiler.Compile(resources, passes, plan);
+    REQUIRE(plan.m_PassOrder.size() == 3);
+    CHECK(IsValidPlan(resources, passes, plan));
+    CHECK(IsValidSchedule(resources, passes, plan));
+
+    // Color 由 Scene 在发出信号前转换，History 与状态未知的 Luminance 之前没有使用过，在帧开始时转换
+    CHECK(plan.m_PassBarriers[1].empty());
+    CHECK(CountBarriers(plan.m_Schedules[0].m_EndBarriers, RGBarrierType::kTransition, 1) == 1);
+    CHECK(CountBarriers(plan.m_InitialBarriers, RGBarrierType::kTransition, 2) == 1);
+    CHECK(CountBarriers(plan.m_InitialBarriers, RGBarrierType::kTransition, 3) == 1);
+
+    // 等待 Scene 的信号时初始屏障已经执行，不需要单独发出信号
+    CHECK(plan.m_Schedules[1].m_WaitPass == 0);
+    CHECK(!plan.m_Schedules[1].m_WaitInitial);
+    CHECK(!plan.m_SignalInitial);
+
+    // History 在 Tonemap 等待 Exposure 之后由最终屏障转回
+    CHECK(plan.m_Schedules[2].m_WaitPass == 1);
+    CHECK(plan.m_FinalWaitPass == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(CountBarriers(plan.m_FinalBarriers, RGBarrierType::kTransition, 2) == 1);
+}
+
+TEST_CASE(RenderGraphCompiler_RedundantQueueWaitsAreSkipped)
+{
+    std::vector<RGResourceDesc> resources{
+        MakeImported("BackBuffer", kPresent, kPresent),
+        MakeTransient("A", 1 * kMiB),
+        MakeTransient("B", 1 * kMiB),
+        MakeImported("Particles", kUnorderedAccess, kUnorderedAccess),
+    };
+    std::vector<RGPassDesc> passes{
+        {"ProduceA", RGQueue::kCompute, {{1, kUnorderedAccess, true}}},
+        {"ProduceB", RGQueue::kCompute, {{2, kUnorderedAccess, true}}},
+        // 等待 ProduceB 已经包含了 ProduceA
+        {"UseB", RGQueue::kGraphics, {{2, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+        {"UseA", RGQueue::kGraphics, {{1, kPixelShaderResource, false}, {0, kRenderTarget, true}}},
+        // 帧末尾的计算 Pass 需要图形队列在最终屏障前等待
+        {"Simulate", RGQueue::kCompute, {{3, kUnorderedAccess, true}}},
+    };
+
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    compiler.Compile(resources, passes, plan);
+    REQUIRE(plan.m_PassOrder.size() == 5);
+    CHECK(IsValidPlan(resources, passes, plan));
+    CHECK(IsValidSchedule(resources, passes, plan));
+
+    CHECK(plan.m_Schedules[0].m_WaitInitial);
+    CHECK(plan.m_SignalInitial);
+    CHECK(plan.m_Schedules[2].m_WaitPass == 1);
+    CHECK(plan.m_Schedules[3].m_WaitPass == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(!plan.m_Schedules[0].m_Signal);
+    CHECK(plan.m_Schedules[4].m_WaitPass == RenderGraphCompiler::sm_InvalidIndex);
+    CHECK(plan.m_FinalWaitPass == 4);
+    CHECK(plan.m_Schedules[4].m_Signal);
+    CHECK(plan.m_NumQueueWaits == 3);
+}
+
+TEST_CASE(RenderGraphCompiler_RandomAsyncComputeGraphsAreValid)
+{
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    std::vector<RGResourceDesc> resources{};
+    std::vector<RGPassDesc> passes{};
+    for (std::uint32_t seed = 0; seed < 200; ++seed) {
+        MakeRandomGraph(seed, 40, 48, true, resources, passes);
+        compiler.Compile(resources, passes, plan);
+        if (!IsValidPlan(resources, passes, plan) || !IsValidSchedule(resources, passes, plan)) {
+            std::printf("  seed %u\n", seed);
+            CHECK(false);
+            break;
+        }
+    }
+}
+
+BENCHMARK_CASE(RenderGraphCompiler_CompileSpeed)
+{
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    std::vector<RGResourceDesc> resources{};
+    std::vector<RGPassDesc> passes{};
+
+    for (auto [numPasses, numResources] : {std::pair{64u, 96u}, std::pair{256u, 384u}, std::pair{1024u, 1536u}}) {
+        MakeRandomGraph(1, numPasses, numResources, false, resources, passes);
+        auto seconds = Test::MeasureSeconds([&]() { compiler.Compile(resources, passes, plan); });
+        CHECK(IsValidPlan(resources, passes, plan));
+
+        std::uint64_t heapSize = 0;
+        for (const auto& heap : plan.m_Heaps) heapSize += heap.m_Size;
+        auto label = std::to_string(numPasses) + " passes";
+        Test::ReportMetric(label + ", compile", seconds * 1e6, "us");
+        Test::ReportMetric(label + ", barriers", plan.m_NumBarriers, "");
+        Test::ReportMetric(label + ", memory saved by aliasing", 100.0 * (1.0 - double(heapSize) / plan.m_UnaliasedSize), "%");
+    }
+}
+
+BENCHMARK_CASE(RenderGraphCompiler_AsyncComputeOverlap)
+{
+    RenderGraphCompiler compiler{};
+    RenderGraphPlan plan{};
+    std::vector<RGResourceDesc> resources{};
+    std::vector<RGPassDesc> passes{};
+    std::mt19937 rng{3};
+    std::uniform_real_distribution<double> duration{0.1, 1.0};
+
+    // 模拟的 Pass 耗时，与同一张图只在图形队列上执行时比较
+    double serialTime = 0;
+    double asyncTime = 0;
+    std::uint64_t numWaits = 0;
+    std::uint64_t numPasses = 0;
+    double compileSeconds = 0;
+    for (std::uint32_t seed = 0; seed < 100; ++seed) {
+        MakeRandomGraph(seed, 128, 160, true, resources, passes);
+        compileSeconds += Test::MeasureSeconds([&]() { compiler.Compile(resources, passes, plan); }, 0.01, 100);
+
+        std::vector<double> durations(plan.m_PassOrder.size());
+        for (auto& d : durations) d = duration(rng);
+        QueueSimulation simulation{};
+        CHECK(SimulateQueues(plan, durations, simulation));
+        CHECK(IsValidSchedule(resources, passes, plan));
+        asyncTime += simulation.m_FrameTime;
+        for (auto d : durations) serialTime += d;
+        numWaits += plan.m_NumQueueWaits;
+        numPasses += plan.m_PassOrder.size();
+    }
+
+    Test::ReportMetric("128 passes, compile with async compute", compileSeconds / 100 * 1e6, "us");
+    Test::ReportMetric("Queue waits per 100 passes", 100.0 * numWaits / numPasses, "");
+    Test::ReportMetric("Simulated frame time saved by overlap", 100.0 * (1.0 - asyncTime / serialTime), "%");
+}
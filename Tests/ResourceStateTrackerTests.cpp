@@ -0,0 +1,381 @@
+#include "TestFramework.h"
+#include "Graphics/ResourceStateTracker.h"
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // 与 D3D12_RESOURCE_STATES 相同
+    constexpr std::uint32_t kCommon = 0;
+    constexpr std::uint32_t kDepthWrite = 0x10;
+    constexpr std::uint32_t kRenderTarget = 0x4;
+    constexpr std::uint32_t kUnorderedAccess = 0x8;
+    constexpr std::uint32_t kNonPixelShaderResource = 0x40;
+    constexpr std::uint32_t kPixelShaderResource = 0x80;
+    constexpr std::uint32_t kCopyDest = 0x400;
+    constexpr std::uint32_t kShaderResource = kNonPixelShaderResource | kPixelShaderResource;
+
+    bool IsValidBatch(const ResourceStateTracker& tracker)
+    {
+        std::string error{};
+        bool valid = ResourceStateTracker::Validate(tracker.GetBarriers(), &error);
+        if (!valid) std::printf("  %s\n", error.c_str());
+        return valid;
+    }
+
+    // 同时记录两种方式的屏障：逐子资源跟踪并合并的 ResourceStateTracker，
+    // 与原来 CommandList 的做法，每个资源一个状态，状态不同时转换整个资源
+    class PassRecorder
+    {
+    public:
+        struct Counts
+        {
+            std::uint64_t m_Barriers = 0;
+            // 屏障实际转换的子资源数，整个资源的转换计为所有子资源
+            std::uint64_t m_Subresources = 0;
+        };
+
+        std::uint32_t AddResource(std::uint32_t state, std::uint32_t numSubresources)
+        {
+            m_States.emplace_back(state, numSubresources);
+            m_NaiveStates.push_back(state);
+            return static_cast<std::uint32_t>(m_States.size() - 1);
+        }
+
+        void Use(std::uint32_t resource, std::uint32_t subresource, std::uint32_t state)
+        {
+            m_Tracker.Transition(resource + 1, m_States[resource], subresource, state);
+            RecordNaive(resource, state);
+        }
+        // 使用之前提前开始转换，原来的做法没有拆分屏障，在使用时才转换
+        void BeginUse(std::uint32_t resource, std::uint32_t subresource, std::uint32_t state)
+        {
+            m_Tracker.BeginTransition(resource + 1, m_States[resource], subresource, state);
+        }
+
+        // 提交一批屏障并执行 GPU 工作
+        void Execute()
+        {
+            m_Valid &= IsValidBatch(m_Tracker);
+            for (const auto& barrier : m_Tracker.GetBarriers()) {
+                ++m_Tracked.m_Barriers;
+                bool all = barrier.m_Type != TrackedBarrierType::kTransition || barrier.m_Subresource == SubresourceStates::sm_AllSubresources;
+                m_Tracked.m_Subresources += all ? m_States[barrier.m_Resource - 1].GetNumSubresources() : 1;
+            }
+            m_Tracker.Clear();
+        }
+
+        const Counts& GetTracked() const noexcept { return m_Tracked; }
+        const Counts& GetNaive() const noexcept { return m_Naive; }
+        const ResourceStateTrackerStats& GetStats() const noexcept { return m_Tracker.GetStats(); }
+        bool IsValid() const noexcept { return m_Valid; }
+
+    private:
+        void RecordNaive(std::uint32_t resource, std::uint32_t state)
+        {
+            auto& naiveState = m_NaiveStates[resource];
+            if (naiveState == state && state != kUnorderedAccess) return;
+            ++m_Naive.m_Barriers;
+            m_Naive.m_Subresources += m_States[resource].GetNumSubresources();
+            naiveState = state;
+        }
+
+    private:
+        ResourceStateTracker m_Tracker{};
+        std::vector<SubresourceStates> m_States{};
+        std::vector<std::uint32_t> m_NaiveStates{};
+        Counts m_Tracked{};
+        Counts m_Naive{};
+        bool m_Valid = true;
+    };
+
+    // 与 D3D12CalcSubresource 相同
+    std::uint32_t CalcSubresource(std::uint32_t mip, std::uint32_t slice, std::uint32_t mipLevels)
+    {
+        return mip + slice * mipLevels;
+    }
+
+    // 计算着色器逐级生成 mip：读取上一级，写入当前级
+    void RecordMipGeneration(PassRecorder& recorder, std::uint32_t numTextures, std::uint32_t mipLevels)
+    {
+        for (std::uint32_t t = 0; t < numTextures; ++t) {
+            auto texture = recorder.AddResource(kCopyDest, mipLevels);
+            for (std::uint32_t mip = 1; mip < mipLevels; ++mip) {
+                recorder.Use(texture, mip - 1, kNonPixelShaderResource);
+                recorder.Use(texture, mip, kUnorderedAccess);
+                recorder.Execute();
+            }
+            recorder.Use(texture, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Execute();
+        }
+    }
+
+    // 纹理数组在渲染时被采样，每帧向其中一层上传新的内容
+    void RecordArraySliceStreaming(PassRecorder& recorder, std::uint32_t numFrames, std::uint32_t arraySize, std::uint32_t mipLevels)
+    {
+        auto array = recorder.AddResource(kPixelShaderResource, arraySize * mipLevels);
+        auto staging = recorder.AddResource(kCommon, mipLevels);
+        for (std::uint32_t frame = 0; frame < numFrames; ++frame) {
+            auto slice = frame % arraySize;
+            recorder.Use(staging, SubresourceStates::sm_AllSubresources, 0x800);
+            for (std::uint32_t mip = 0; mip < mipLevels; ++mip) {
+                recorder.Use(array, CalcSubresource(mip, slice, mipLevels), kCopyDest);
+            }
+            recorder.Execute();
+            for (std::uint32_t mip = 0; mip < mipLevels; ++mip) {
+                recorder.Use(array, CalcSubresource(mip, slice, mipLevels), kPixelShaderResource);
+            }
+            recorder.Use(staging, SubresourceStates::sm_AllSubresources, kCommon);
+            recorder.Execute();
+            // 场景绘制采样整个数组，已处于可读状态时没有屏障
+            recorder.Use(array, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Execute();
+        }
+    }
+
+    // 延迟渲染的一帧：G-Buffer、阴影、光照、泛光的降采样与升采样链
+    void RecordDeferredFrames(PassRecorder& recorder, std::uint32_t numFrames, std::uint32_t bloomMips)
+    {
+        std::uint32_t gbuffer[3]{};
+        for (auto& target : gbuffer) target = recorder.AddResource(kPixelShaderResource, 1);
+        auto depth = recorder.AddResource(kDepthWrite, 1);
+        auto shadow = recorder.AddResource(kDepthWrite, 1);
+        auto hdr = recorder.AddResource(kRenderTarget, 1);
+        auto bloom = recorder.AddResource(kPixelShaderResource, bloomMips);
+        for (std::uint32_t frame = 0; frame < numFrames; ++frame) {
+            for (auto target : gbuffer) recorder.Use(target, SubresourceStates::sm_AllSubresources, kRenderTarget);
+            recorder.Use(depth, SubresourceStates::sm_AllSubresources, kDepthWrite);
+            recorder.Execute();
+            // G-Buffer 的转换与阴影的绘制重叠
+            for (auto target : gbuffer) recorder.BeginUse(target, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Use(shadow, SubresourceStates::sm_AllSubresources, kDepthWrite);
+            recorder.Execute();
+
+            for (auto target : gbuffer) recorder.Use(target, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Use(depth, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Use(shadow, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Use(hdr, SubresourceStates::sm_AllSubresources, kRenderTarget);
+            recorder.Execute();
+
+            // 降采样：读取上一级，写入当前级
+            recorder.Use(hdr, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            for (std::uint32_t mip = 0; mip < bloomMips; ++mip) {
+                if (mip > 0) recorder.Use(bloom, mip - 1, kPixelShaderResource);
+                recorder.Use(bloom, mip, kRenderTarget);
+                recorder.Execute();
+            }
+            // 升采样：读取下一级，叠加到当前级
+            for (std::uint32_t mip = bloomMips - 1; mip-- > 0;) {
+                recorder.Use(bloom, mip + 1, kPixelShaderResource);
+                recorder.Use(bloom, mip, kRenderTarget);
+                recorder.Execute();
+            }
+            // 合成时深度与泛光同时作为像素着色器与非像素着色器的输入
+            recorder.Use(bloom, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Use(depth, SubresourceStates::sm_AllSubresources, kShaderResource);
+            recorder.Use(depth, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+            recorder.Use(hdr, SubresourceStates::sm_AllSubresources, kRenderTarget);
+            recorder.Execute();
+        }
+    }
+}
+
+TEST_CASE(ResourceStateTracker_MergesTransitionsInBatch)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kCommon, 1};
+
+    tracker.Transition(1, states, SubresourceStates::sm_AllSubresources, kCopyDest);
+    tracker.Transition(1, states, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_StateBefore == kCommon);
+    CHECK(tracker.GetBarriers()[0].m_StateAfter == kPixelShaderResource);
+    CHECK(tracker.GetStats().m_NumMerged == 1);
+
+    // 转回原状态的转换整个消失
+    tracker.Transition(1, states, SubresourceStates::sm_AllSubresources, kCommon);
+    CHECK(tracker.Empty());
+    CHECK(IsValidBatch(tracker));
+}
+
+TEST_CASE(ResourceStateTracker_SkipsCompatibleReads)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kShaderResource, 1};
+
+    tracker.Transition(1, states, 0, kPixelShaderResource);
+    CHECK(tracker.Empty());
+    CHECK(tracker.GetStats().m_NumSkipped == 1);
+    CHECK(states.GetState() == kShaderResource);
+
+    // 计算队列不能保留包含图形状态的只读状态
+    tracker.SetAllowedStates(kNonPixelShaderResource | kUnorderedAccess | kCopyDest);
+    tracker.Transition(1, states, 0, kNonPixelShaderResource);
+    CHECK(tracker.GetBarriers().size() == 1);
+    CHECK(states.GetState() == kNonPixelShaderResource);
+}
+
+TEST_CASE(ResourceStateTracker_UAVBarriersBetweenWrites)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kUnorderedAccess, 1};
+
+    tracker.Transition(1, states, 0, kUnorderedAccess);
+    tracker.Transition(1, states, 0, kUnorderedAccess);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_Type == TrackedBarrierType::kUAV);
+    CHECK(tracker.GetStats().m_NumMerged == 1);
+}
+
+TEST_CASE(ResourceStateTracker_PerSubresourceTransitions)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kShaderResource, 4};
+
+    tracker.Transition(1, states, 2, kRenderTarget);
+    CHECK(!states.IsUniform());
+    CHECK(states.GetState(2) == kRenderTarget);
+    CHECK(states.GetState(1) == kShaderResource);
+    tracker.Clear();
+
+    // 转换整个资源时只为状态不同的子资源生成屏障
+    tracker.Transition(1, states, SubresourceStates::sm_AllSubresources, kShaderResource);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_Subresource == 2);
+    CHECK(states.IsUniform());
+    CHECK(IsValidBatch(tracker));
+}
+
+TEST_CASE(ResourceStateTracker_SplitBarrierAcrossFlush)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kRenderTarget, 1};
+
+    tracker.BeginTransition(1, states, 0, kPixelShaderResource);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_Flag == TrackedBarrierFlag::kBeginOnly);
+    CHECK(states.HasPendingSplit());
+    CHECK(IsValidBatch(tracker));
+    tracker.Clear();
+
+    // 提交之后再使用，先结束拆分屏障
+    tracker.Transition(1, states, 0, kPixelShaderResource);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_Flag == TrackedBarrierFlag::kEndOnly);
+    CHECK(tracker.GetBarriers()[0].m_StateBefore == kRenderTarget);
+    CHECK(tracker.GetBarriers()[0].m_StateAfter == kPixelShaderResource);
+    CHECK(!states.HasPendingSplit());
+    CHECK(IsValidBatch(tracker));
+}
+
+TEST_CASE(ResourceStateTracker_SplitBarrierCollapsesWithinBatch)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kRenderTarget, 1};
+
+    // 开始与结束之间没有提交，合并为一个完整的转换
+    tracker.BeginTransition(1, states, 0, kPixelShaderResource);
+    tracker.Transition(1, states, 0, kPixelShaderResource);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_Flag == TrackedBarrierFlag::kNone);
+    CHECK(tracker.GetBarriers()[0].m_StateBefore == kRenderTarget);
+    CHECK(tracker.GetBarriers()[0].m_StateAfter == kPixelShaderResource);
+    CHECK(!states.HasPendingSplit());
+    CHECK(IsValidBatch(tracker));
+    tracker.Clear();
+
+    // 结束后立即转换到其他状态时与合并后的转换继续合并
+    tracker.BeginTransition(1, states, 0, kCopyDest);
+    tracker.Transition(1, states, 0, kUnorderedAccess);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].m_Flag == TrackedBarrierFlag::kNone);
+    CHECK(tracker.GetBarriers()[0].m_StateBefore == kPixelShaderResource);
+    CHECK(tracker.GetBarriers()[0].m_StateAfter == kUnorderedAccess);
+    CHECK(IsValidBatch(tracker));
+}
+
+TEST_CASE(ResourceStateTracker_SplitBarrierCollapsesPerSubresource)
+{
+    ResourceStateTracker tracker{};
+    SubresourceStates states{kRenderTarget, 3};
+    tracker.Transition(1, states, 1, kCopyDest);
+    tracker.Clear();
+
+    // 子资源 0、2 与 1 分别开始拆分屏障，只有子资源 1 的在提交前结束
+    tracker.BeginTransition(1, states, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+    REQUIRE(tracker.GetBarriers().size() == 3);
+    tracker.Transition(1, states, 1, kPixelShaderResource);
+    auto barriers = tracker.GetBarriers();
+    REQUIRE(barriers.size() == 3);
+    CHECK(barriers[0].m_Flag == TrackedBarrierFlag::kBeginOnly);
+    CHECK(barriers[1].m_Flag == TrackedBarrierFlag::kNone && barriers[1].m_Subresource == 1);
+    CHECK(barriers[2].m_Flag == TrackedBarrierFlag::kBeginOnly);
+    CHECK(IsValidBatch(tracker));
+    tracker.Clear();
+
+    tracker.Transition(1, states, SubresourceStates::sm_AllSubresources, kPixelShaderResource);
+    barriers = tracker.GetBarriers();
+    REQUIRE(barriers.size() == 2);
+    CHECK(barriers[0].m_Flag == TrackedBarrierFlag::kEndOnly && barriers[0].m_Subresource == 0);
+    CHECK(barriers[1].m_Flag == TrackedBarrierFlag::kEndOnly && barriers[1].m_Subresource == 2);
+    CHECK(states.IsUniform());
+}
+
+TEST_CASE(ResourceStateTracker_ValidateRejectsBrokenBatches)
+{
+    TrackedBarrier writeCombined{TrackedBarrierType::kTransition, TrackedBarrierFlag::kNone, 1, 0, 0,
+        kCommon, kRenderTarget | kPixelShaderResource};
+    CHECK(!ResourceStateTracker::Validate(std::span{&writeCombined, 1}));
+
+    TrackedBarrier chain[] = {
+        {TrackedBarrierType::kTransition, TrackedBarrierFlag::kNone, 1, 0, 0, kCommon, kCopyDest},
+        {TrackedBarrierType::kTransition, TrackedBarrierFlag::kNone, 1, 0, 0, kRenderTarget, kPixelShaderResource},
+    };
+    CHECK(!ResourceStateTracker::Validate(chain));
+
+    TrackedBarrier split[] = {
+        {TrackedBarrierType::kTransition, TrackedBarrierFlag::kBeginOnly, 1, 0, 0, kRenderTarget, kPixelShaderResource},
+        {TrackedBarrierType::kTransition, TrackedBarrierFlag::kEndOnly, 1, 0, 0, kRenderTarget, kPixelShaderResource},
+    };
+    CHECK(!ResourceStateTracker::Validate(split));
+}
+
+BENCHMARK_CASE(ResourceStateTracker_SyntheticPassBarriers)
+{
+    struct Sequence
+    {
+        const char* m_Name;
+        std::function<void(PassRecorder&)> m_Record;
+    };
+    const Sequence sequences[] = {
+        {"Mip generation, 64 textures with 12 mips", [](PassRecorder& recorder) { RecordMipGeneration(recorder, 64, 12); }},
+        {"Array slice streaming, 64 slices with 10 mips, 256 frames", [](PassRecorder& recorder) { RecordArraySliceStreaming(recorder, 256, 64, 10); }},
+        {"Deferred frame with a 6-mip bloom chain, 256 frames", [](PassRecorder& recorder) { RecordDeferredFrames(recorder, 256, 6); }},
+    };
+
+    for (const auto& sequence : sequences) {
+        PassRecorder recorder{};
+        sequence.m_Record(recorder);
+        CHECK(recorder.IsValid());
+        // 逐子资源跟踪实际转换的子资源更少
+        CHECK(recorder.GetTracked().m_Subresources < recorder.GetNaive().m_Subresources);
+        auto seconds = Test::MeasureSeconds([&]() {
+            PassRecorder timed{};
+            sequence.m_Record(timed);
+        });
+
+        const auto& tracked = recorder.GetTracked();
+        const auto& naive = recorder.GetNaive();
+        std::printf("  %s\n", sequence.m_Name);
+        Test::ReportMetric("Transitions requested", double(recorder.GetStats().m_NumRequests), "");
+        Test::ReportMetric("Tracked barriers", double(tracked.m_Barriers), "");
+        Test::ReportMetric("Whole-resource barriers", double(naive.m_Barriers), "");
+        Test::ReportMetric("Tracked subresource transitions", double(tracked.m_Subresources), "");
+        Test::ReportMetric("Whole-resource subresource transitions", double(naive.m_Subresources), "");
+        Test::ReportMetric("Skipped reads", double(recorder.GetStats().m_NumSkipped), "");
+        Test::ReportMetric("Record time", seconds * 1e3, "ms");
+    }
+}
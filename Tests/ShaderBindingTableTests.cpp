@@ -0,0 +1,410 @@
+#include "TestFramework.h"
+#include "RayTracing/ShaderBindingTable.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    constexpr ShaderTableType kTableTypes[] = {
+        ShaderTableType::kRayGen, ShaderTableType::kMiss, ShaderTableType::kHitGroup, ShaderTableType::kCallable};
+
+    // 模拟 GPU 上的缓冲，与 ShaderTableBuffer 相同，变大时重新创建并整体上传
+    struct GpuMirror
+    {
+        std::vector<std::byte> m_Data{};
+
+        void Update(ShaderBindingTable& table, std::uint32_t maxGap)
+        {
+            if (m_Data.size() < table.GetSize()) {
+                // 新的缓冲没有初始化
+                m_Data.assign(table.GetSize(), std::byte{0xcd});
+                table.MarkAllDirty();
+            }
+            table.BuildPatchList(maxGap);
+            std::vector<std::byte> upload(table.GetPatchDataSize());
+            table.WritePatchData(upload.data());
+            for (const auto& patch : table.GetPatches()) {
+                std::memcpy(m_Data.data() + patch.m_DestOffset, upload.data() + patch.m_SrcOffset, patch.m_Size);
+            }
+        }
+    };
+
+    // 每个记录的有效字节与 CPU 上的副本相同，记录间的填充不影响结果
+    bool MatchesGpu(const ShaderBindingTable& table, const GpuMirror& gpu)
+    {
+        for (auto type : kTableTypes) {
+            const auto& range = table.GetRange(type);
+            for (std::uint32_t r = 0; r < range.m_NumRecords; ++r) {
+                auto offset = table.GetRecordOffset(type, r);
+                if (std::memcmp(gpu.m_Data.data() + offset, table.GetData() + offset, range.m_RecordSize) != 0) {
+                    std::printf("  table %u record %u differs from the GPU copy\n", unsigned(type), r);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    std::uint32_t GetPatchedBytes(const ShaderBindingTable& table)
+    {
+        std::uint32_t size = 0;
+        for (const auto& patch : table.GetPatches()) size += patch.m_Size;
+        return size;
+    }
+
+    // 所有补丁都落在 [begin, end) 之内
+    bool PatchesWithin(const ShaderBindingTable& table, std::uint32_t begin, std::uint32_t end)
+    {
+        for (const auto& patch : table.GetPatches()) {
+            if (patch.m_DestOffset < begin || patch.m_DestOffset + patch.m_Size > end) return false;
+        }
+        return true;
+    }
+
+    void FillIdentifier(std::uint8_t identifier[ShaderBindingTable::sm_IdentifierSize], std::uint32_t seed)
+    {
+        for (std::uint32_t i = 0; i < ShaderBindingTable::sm_IdentifierSize; ++i) {
+            identifier[i] = std::uint8_t(seed * 31 + i);
+        }
+    }
+}
+
+TEST_CASE(ShaderBindingTable_RecordLayoutAlignsArguments)
+{
+    // 标识符之后依次为 3 个常量，描述符表按 8 字节对齐，1 个常量，根视图按 8 字节对齐
+    ShaderRecordLayout layout{
+        {ShaderRecordArgumentType::kConstants, 3},
+        {ShaderRecordArgumentType::kDescriptorTable},
+        {ShaderRecordArgumentType::kConstants, 1},
+        {ShaderRecordArgumentType::kRootView}};
+    REQUIRE(layout.GetNumArguments() == 4);
+    CHECK(layout.GetOffset(0) == 32);
+    CHECK(layout.GetArgumentSize(0) == 12);
+    CHECK(layout.GetOffset(1) == 48);
+    CHECK(layout.GetArgumentSize(1) == 8);
+    CHECK(layout.GetOffset(2) == 56);
+    CHECK(layout.GetArgumentSize(2) == 4);
+    CHECK(layout.GetOffset(3) == 64);
+    CHECK(layout.GetArgumentSize(3) == 8);
+    CHECK(layout.GetSize() == 72);
+
+    // 常量之间不需要填充
+    ShaderRecordLayout constants{{ShaderRecordArgumentType::kConstants, 1}, {ShaderRecordArgumentType::kConstants, 2}};
+    CHECK(constants.GetOffset(1) == 36);
+    CHECK(constants.GetSize() == 44);
+
+    ShaderRecordLayout empty{};
+    CHECK(empty.GetNumArguments() == 0);
+    ShaderRecordLayout identifierOnly{std::span<const ShaderRecordArgument>{}};
+    CHECK(identifierOnly.GetSize() == 32);
+}
+
+TEST_CASE(ShaderBindingTable_AlignsStridesAndTables)
+{
+    ShaderBindingTable table{};
+    // 光线生成记录的步长按 64 字节对齐
+    CHECK(table.SetTable(ShaderTableType::kRayGen, 2, 40));
+    CHECK(table.SetTable(ShaderTableType::kMiss, 3, 32));
+    CHECK(table.SetTable(ShaderTableType::kHitGroup, 5, 72));
+    CHECK(table.SetTable(ShaderTableType::kCallable, 1, 10));
+
+    const auto& rayGen = table.GetRange(ShaderTableType::kRayGen);
+    const auto& miss = table.GetRange(ShaderTableType::kMiss);
+    const auto& hit = table.GetRange(ShaderTableType::kHitGroup);
+    const auto& callable = table.GetRange(ShaderTableType::kCallable);
+    CHECK(rayGen.m_Offset == 0);
+    CHECK(rayGen.m_Stride == 64);
+    CHECK(rayGen.m_RecordSize == 40);
+    CHECK(miss.m_Offset == 128);
+    CHECK(miss.m_Stride == 32);
+    // 96 字节的表结束后对齐到 64 字节
+    CHECK(hit.m_Offset == 256);
+    CHECK(hit.m_Stride == 96);
+    CHECK(callable.m_Offset == 768);
+    // 记录至少包含标识符
+    CHECK(callable.m_Stride == 32);
+    CHECK(callable.m_RecordSize == 32);
+    CHECK(table.GetSize() == 832);
+    CHECK(table.GetRecordOffset(ShaderTableType::kHitGroup, 3) == 256 + 3 * 96);
+
+    for (auto type : kTableTypes) {
+        const auto& range = table.GetRange(type);
+        CHECK(range.m_Offset % ShaderBindingTable::sm_TableAlignment == 0);
+        CHECK(range.m_Stride % ShaderBindingTable::sm_RecordAlignment == 0);
+        CHECK(range.m_Stride >= range.m_RecordSize);
+    }
+    CHECK(rayGen.m_Stride % ShaderBindingTable::sm_TableAlignment == 0);
+
+    // 空表不占空间，后面的表紧接在前面
+    CHECK(table.SetTable(ShaderTableType::kMiss, 0, 32));
+    CHECK(table.GetRange(ShaderTableType::kMiss).m_Stride == 0);
+    CHECK(table.GetRange(ShaderTableType::kHitGroup).m_Offset == 128);
+
+    // 最大步长为 4096，光线生成记录对齐后同样不能超过
+    CHECK(table.SetTable(ShaderTableType::kHitGroup, 2, 4096));
+    CHECK(table.GetRange(ShaderTableType::kHitGroup).m_Stride == 4096);
+    auto size = table.GetSize();
+    CHECK(!table.SetTable(ShaderTableType::kHitGroup, 2, 4097));
+    CHECK(!table.SetTable(ShaderTableType::kRayGen, 1, 4097));
+    CHECK(table.GetRange(ShaderTableType::kHitGroup).m_Stride == 4096);
+    CHECK(table.GetRange(ShaderTableType::kRayGen).m_NumRecords == 2);
+    CHECK(table.GetSize() == size);
+    // 没有记录时不检查大小
+    CHECK(table.SetTable(ShaderTableType::kCallable, 0, 10000));
+
+    table.Clear();
+    CHECK(table.GetSize() == 0);
+    CHECK(table.GetNumDirty() == 0);
+}
+
+TEST_CASE(ShaderBindingTable_PatchesOnlyChangedBytes)
+{
+    ShaderRecordLayout layout{{ShaderRecordArgumentType::kConstants, 4}, {ShaderRecordArgumentType::kRootView}};
+    ShaderBindingTable table{};
+    REQUIRE(table.SetTable(ShaderTableType::kRayGen, 1, 32));
+    REQUIRE(table.SetTable(ShaderTableType::kMiss, 1, 32));
+    REQUIRE(table.SetTable(ShaderTableType::kHitGroup, 16, layout.GetSize()));
+    GpuMirror gpu{};
+    std::uint8_t identifier[ShaderBindingTable::sm_IdentifierSize]{};
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        FillIdentifier(identifier, i);
+        table.SetIdentifier(ShaderTableType::kHitGroup, i, identifier);
+        table.WriteArgument(ShaderTableType::kHitGroup, i, layout, 0, float(i));
+    }
+    gpu.Update(table, 0);
+    CHECK(MatchesGpu(table, gpu));
+    CHECK(table.GetNumDirty() == 0);
+
+    // 没有写入时没有补丁，相同的值不会标记为脏
+    gpu.Update(table, 0);
+    CHECK(table.GetPatches().empty());
+    CHECK(!table.WriteArgument(ShaderTableType::kHitGroup, 3, layout, 0, 3.0f));
+    CHECK(table.GetNumDirty() == 0);
+    CHECK(table.GetStats().m_NumUnchanged >= 1);
+
+    // 一个浮点数只上传实际改变的字节，3.0 与 3.5 只有一个字节不同
+    float oldValue = 3.0f, newValue = 3.5f;
+    std::uint32_t begin = 0, end = 4;
+    auto* oldBytes = reinterpret_cast<const std::uint8_t*>(&oldValue);
+    auto* newBytes = reinterpret_cast<const std::uint8_t*>(&newValue);
+    while (oldBytes[begin] == newBytes[begin]) ++begin;
+    while (oldBytes[end - 1] == newBytes[end - 1]) --end;
+    CHECK(table.WriteArgument(ShaderTableType::kHitGroup, 3, layout, 0, newValue));
+    gpu.Update(table, 0);
+    auto patches = table.GetPatches();
+    REQUIRE(patches.size() == 1);
+    CHECK(patches[0].m_DestOffset == table.GetRecordOffset(ShaderTableType::kHitGroup, 3) + layout.GetOffset(0) + begin);
+    CHECK(patches[0].m_Size == end - begin);
+    CHECK(patches[0].m_SrcOffset == 0);
+    CHECK(table.GetPatchDataSize() == end - begin);
+    CHECK(MatchesGpu(table, gpu));
+
+    // 同一记录中的两次写入合并为覆盖两者的一段
+    std::uint64_t address = 0x1234'5678'0000ull;
+    table.WriteArgument(ShaderTableType::kHitGroup, 7, layout, 0, 100.0f);
+    table.WriteArgument(ShaderTableType::kHitGroup, 7, layout, 1, address);
+    gpu.Update(table, 0);
+    REQUIRE(table.GetPatches().size() == 1);
+    auto recordOffset = table.GetRecordOffset(ShaderTableType::kHitGroup, 7);
+    CHECK(PatchesWithin(table, recordOffset + layout.GetOffset(0), recordOffset + layout.GetSize()));
+    CHECK(MatchesGpu(table, gpu));
+
+    // 相邻的 10 个记录，间隔为 0 时各为一段，间隔不小于记录间的距离时合并为一段
+    // 每次写入的 4 个字节都与之前不同
+    auto writeRange = [&](std::uint32_t base) {
+        for (std::uint32_t i = 2; i < 12; ++i) {
+            table.WriteArgument(ShaderTableType::kHitGroup, i, layout, 0, 0x01010101u * (base + i));
+        }
+    };
+    writeRange(1);
+    gpu.Update(table, 0);
+    CHECK(table.GetPatches().size() == 10);
+    CHECK(GetPatchedBytes(table) == 10 * 4);
+    CHECK(MatchesGpu(table, gpu));
+
+    auto stride = table.GetRange(ShaderTableType::kHitGroup).m_Stride;
+    writeRange(2);
+    gpu.Update(table, stride);
+    REQUIRE(table.GetPatches().size() == 1);
+    CHECK(table.GetPatchDataSize() == 9 * stride + 4);
+    CHECK(MatchesGpu(table, gpu));
+
+    // 间隔刚好比距离小一个字节时不合并
+    writeRange(3);
+    auto gap = stride - 4;
+    table.BuildPatchList(gap - 1);
+    CHECK(table.GetPatches().size() == 10);
+    writeRange(4);
+    table.BuildPatchList(gap);
+    CHECK(table.GetPatches().size() == 1);
+
+    // 打包的数据按补丁的顺序连续存放
+    writeRange(5);
+    table.SetIdentifier(ShaderTableType::kMiss, 0, identifier);
+    table.BuildPatchList(0);
+    std::uint32_t srcOffset = 0, lastEnd = 0;
+    for (const auto& patch : table.GetPatches()) {
+        CHECK(patch.m_SrcOffset == srcOffset);
+        CHECK(patch.m_DestOffset >= lastEnd);
+        srcOffset += patch.m_Size;
+        lastEnd = patch.m_DestOffset + patch.m_Size;
+    }
+    CHECK(srcOffset == table.GetPatchDataSize());
+}
+
+TEST_CASE(ShaderBindingTable_ResizeKeepsContents)
+{
+    ShaderBindingTable table{};
+    REQUIRE(table.SetTable(ShaderTableType::kRayGen, 1, 32));
+    REQUIRE(table.SetTable(ShaderTableType::kMiss, 2, 40));
+    REQUIRE(table.SetTable(ShaderTableType::kHitGroup, 4, 40));
+    REQUIRE(table.SetTable(ShaderTableType::kCallable, 2, 32));
+    std::uint8_t identifier[ShaderBindingTable::sm_IdentifierSize]{};
+    for (auto type : kTableTypes) {
+        for (std::uint32_t r = 0; r < table.GetRange(type).m_NumRecords; ++r) {
+            FillIdentifier(identifier, unsigned(type) * 100 + r);
+            table.SetIdentifier(type, r, identifier);
+        }
+    }
+    GpuMirror gpu{};
+    gpu.Update(table, 0);
+    REQUIRE(MatchesGpu(table, gpu));
+
+    // 命中组变多时只有新增的记录和之后移动的可调用表需要上传
+    auto missRange = table.GetRange(ShaderTableType::kMiss);
+    auto hitRange = table.GetRange(ShaderTableType::kHitGroup);
+    auto oldCallableOffset = table.GetRange(ShaderTableType::kCallable).m_Offset;
+    REQUIRE(table.SetTable(ShaderTableType::kHitGroup, 6, 40));
+    CHECK(table.GetRange(ShaderTableType::kMiss).m_Offset == missRange.m_Offset);
+    CHECK(table.GetRange(ShaderTableType::kHitGroup).m_Offset == hitRange.m_Offset);
+    const auto& callable = table.GetRange(ShaderTableType::kCallable);
+    CHECK(callable.m_Offset != oldCallableOffset);
+    // 原有的记录保留内容
+    for (std::uint32_t r = 0; r < 4; ++r) {
+        FillIdentifier(identifier, unsigned(ShaderTableType::kHitGroup) * 100 + r);
+        CHECK(std::memcmp(table.GetData() + table.GetRecordOffset(ShaderTableType::kHitGroup, r), identifier, 32) == 0);
+    }
+    FillIdentifier(identifier, unsigned(ShaderTableType::kCallable) * 100 + 1);
+    CHECK(std::memcmp(table.GetData() + table.GetRecordOffset(ShaderTableType::kCallable, 1), identifier, 32) == 0);
+
+    CHECK(table.GetNumDirty() == 2 + 2);
+    // GPU 上的缓冲变大，这一次整体上传
+    gpu.Update(table, 0);
+    CHECK(MatchesGpu(table, gpu));
+
+    // 缓冲不需要变大时，只上传改变的部分
+    REQUIRE(table.SetTable(ShaderTableType::kHitGroup, 5, 40));
+    CHECK(table.GetNumDirty() == 2);
+    gpu.Update(table, 0);
+    CHECK(PatchesWithin(table, table.GetRange(ShaderTableType::kCallable).m_Offset,
+        table.GetRange(ShaderTableType::kCallable).m_Offset + table.GetRange(ShaderTableType::kCallable).GetSize()));
+    CHECK(GetPatchedBytes(table) == 2 * 32);
+    CHECK(MatchesGpu(table, gpu));
+
+    // 记录变大但步长不变时，每个记录只上传新增的字节
+    REQUIRE(table.SetTable(ShaderTableType::kMiss, 2, 56));
+    CHECK(table.GetRange(ShaderTableType::kMiss).m_Stride == missRange.m_Stride);
+    table.BuildPatchList(0);
+    auto patches = table.GetPatches();
+    REQUIRE(patches.size() == 2);
+    for (std::uint32_t r = 0; r < 2; ++r) {
+        CHECK(patches[r].m_DestOffset == table.GetRecordOffset(ShaderTableType::kMiss, r) + 40);
+        CHECK(patches[r].m_Size == 16);
+    }
+    table.MarkAllDirty();
+    gpu.Update(table, 0);
+    CHECK(MatchesGpu(table, gpu));
+
+    // 步长改变时整个表需要上传，后面的表跟着移动
+    REQUIRE(table.SetTable(ShaderTableType::kMiss, 2, 72));
+    CHECK(table.GetRange(ShaderTableType::kMiss).m_Stride == 96);
+    CHECK(table.GetNumDirty() == 2 + 5 + 2);
+    FillIdentifier(identifier, unsigned(ShaderTableType::kMiss) * 100 + 1);
+    CHECK(std::memcmp(table.GetData() + table.GetRecordOffset(ShaderTableType::kMiss, 1), identifier, 32) == 0);
+    gpu.Update(table, 0);
+    CHECK(MatchesGpu(table, gpu));
+
+    // 拒绝的修改不改变脏标记
+    CHECK(!table.SetTable(ShaderTableType::kMiss, 2, 5000));
+    CHECK(table.GetNumDirty() == 0);
+}
+
+TEST_CASE(ShaderBindingTable_RandomOperationsMatchGpu)
+{
+    std::mt19937 rng{11};
+    ShaderBindingTable table{};
+    GpuMirror gpu{};
+    std::uint32_t numResizes = 0;
+    for (std::uint32_t step = 0; step < 2000; ++step) {
+        auto type = kTableTypes[rng() % 4];
+        auto op = rng() % 16;
+        if (op == 0 || table.GetRange(type).m_NumRecords == 0) {
+            numResizes += table.SetTable(type, rng() % 20, 32 + rng() % 200);
+        }
+        else {
+            const auto& range = table.GetRange(type);
+            auto index = rng() % range.m_NumRecords;
+            auto size = 1 + rng() % range.m_RecordSize;
+            auto offset = rng() % (range.m_RecordSize - size + 1);
+            std::vector<std::uint8_t> data(size);
+            for (auto& value : data) value = std::uint8_t(rng() % 4);
+            table.Write(type, index, offset, data.data(), size);
+        }
+        if (rng() % 4 == 0) {
+            gpu.Update(table, rng() % 3 * 64);
+            if (!MatchesGpu(table, gpu)) {
+                std::printf("  mismatch after step %u\n", step);
+                CHECK(false);
+                return;
+            }
+        }
+    }
+    gpu.Update(table, 0);
+    CHECK(MatchesGpu(table, gpu));
+    CHECK(numResizes > 100);
+}
+
+BENCHMARK_CASE(ShaderBindingTable_MaterialUpdates)
+{
+    // 1 万个命中记录，每帧改变 1% 的材质常量，与每帧重建整个表相比
+    ShaderRecordLayout layout{
+        {ShaderRecordArgumentType::kConstants, 8},
+        {ShaderRecordArgumentType::kDescriptorTable},
+        {ShaderRecordArgumentType::kRootView}};
+    constexpr std::uint32_t kNumRecords = 10000;
+    ShaderBindingTable table{};
+    table.SetTable(ShaderTableType::kRayGen, 1, 32);
+    table.SetTable(ShaderTableType::kMiss, 2, 32);
+    table.SetTable(ShaderTableType::kHitGroup, kNumRecords, layout.GetSize());
+    std::uint8_t identifier[ShaderBindingTable::sm_IdentifierSize]{};
+    for (std::uint32_t i = 0; i < kNumRecords; ++i) {
+        FillIdentifier(identifier, i % 16);
+        table.SetIdentifier(ShaderTableType::kHitGroup, i, identifier);
+    }
+    GpuMirror gpu{};
+    gpu.Update(table, 0);
+
+    std::mt19937 rng{5};
+    std::vector<std::byte> upload{};
+    float frame = 0;
+    auto seconds = Test::MeasureSeconds([&]() {
+        frame += 1;
+        for (std::uint32_t i = 0; i < kNumRecords / 100; ++i) {
+            auto index = rng() % kNumRecords;
+            table.WriteArgument(ShaderTableType::kHitGroup, index, layout, 0, frame);
+            table.WriteArgument(ShaderTableType::kHitGroup, index, layout, 1, std::uint64_t(index) << 16);
+        }
+        table.BuildPatchList(64);
+        upload.resize(table.GetPatchDataSize());
+        table.WritePatchData(upload.data());
+    });
+
+    std::printf("  %u hit records of %u bytes, 1%% changed per frame\n", kNumRecords, table.GetRange(ShaderTableType::kHitGroup).m_Stride);
+    Test::ReportMetric("Write and patch", seconds * 1e6, "us");
+    Test::ReportMetric("Patches per frame", double(table.GetPatches().size()), "");
+    Test::ReportMetric("Uploaded per frame", table.GetPatchDataSize() / 1024.0, "KB");
+    Test::ReportMetric("Full table", table.GetSize() / 1024.0, "KB");
+}
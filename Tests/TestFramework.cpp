@@ -0,0 +1,79 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace DSM::Test {
+    namespace {
+        struct TestEntry
+        {
+            const char* m_Name;
+            TestFunc m_Func;
+            bool m_IsBenchmark;
+        };
+
+        std::vector<TestEntry>& GetRegistry()
+        {
+            static std::vector<TestEntry> registry{};
+            return registry;
+        }
+
+        std::uint32_t s_NumFailures = 0;
+    }
+
+    TestRegistrar::TestRegistrar(const char* name, TestFunc func, bool isBenchmark)
+    {
+        GetRegistry().push_back({name, func, isBenchmark});
+    }
+
+    bool ReportFailure(const char* file, int line, const char* expr)
+    {
+        std::printf("  FAILED %s(%d): %s\n", file, line, expr);
+        ++s_NumFailures;
+        return false;
+    }
+
+    void ReportMetric(std::string_view name, double value, std::string_view unit)
+    {
+        std::printf("  %-48.*s %12.3f %.*s\n",
+            static_cast<int>(name.size()), name.data(), value,
+            static_cast<int>(unit.size()), unit.data());
+    }
+}
+
+// 用法: EngineTests [--bench] [名称过滤]
+int main(int argc, char** argv)
+{
+    using namespace DSM::Test;
+
+    bool runBenchmarks = false;
+    std::string filter{};
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0) {
+            runBenchmarks = true;
+        }
+        else {
+            filter = argv[i];
+        }
+    }
+
+    std::uint32_t numRun = 0;
+    std::uint32_t numFailed = 0;
+    for (const auto& entry : GetRegistry()) {
+        if (entry.m_IsBenchmark != runBenchmarks) continue;
+        if (!filter.empty() && std::string_view{entry.m_Name}.find(filter) == std::string_view::npos) continue;
+
+        std::printf("[ RUN  ] %s\n", entry.m_Name);
+        std::fflush(stdout);
+        auto failuresBefore = s_NumFailures;
+        entry.m_Func();
+        bool passed = s_NumFailures == failuresBefore;
+        std::printf("[ %s ] %s\n", passed ? " OK " : "FAIL", entry.m_Name);
+        ++numRun;
+        numFailed += passed ? 0 : 1;
+    }
+
+    std::printf("\n%u %s run, %u failed\n", numRun, runBenchmarks ? "benchmarks" : "tests", numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef __TESTFRAMEWORK_H__
+#define __TESTFRAMEWORK_H__
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace DSM::Test {
+    using TestFunc = void(*)();
+
+    // 在静态初始化时注册测试或基准
+    struct TestRegistrar
+    {
+        TestRegistrar(const char* name, TestFunc func, bool isBenchmark);
+    };
+
+    // 记录断言失败，返回 false 便于 REQUIRE 提前退出
+    bool ReportFailure(const char* file, int line, const char* expr);
+    // 输出一项基准结果
+    void ReportMetric(std::string_view name, double value, std::string_view unit);
+
+    // 基准测试的计时器
+    class BenchTimer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        BenchTimer() : m_Start(Clock::now()) {}
+        void Reset() noexcept { m_Start = Clock::now(); }
+        double ElapsedSeconds() const noexcept
+        {
+            return std::chrono::duration<double>(Clock::now() - m_Start).count();
+        }
+
+    private:
+        Clock::time_point m_Start;
+    };
+
+    // 重复执行 func 直到累计时间超过 minSeconds，返回单次的平均耗时(秒)
+    template <typename Func>
+    double MeasureSeconds(Func&& func, double minSeconds = 0.2, std::uint32_t maxIterations = 1000)
+    {
+        func();     // 预热
+        BenchTimer timer{};
+        std::uint32_t iterations = 0;
+        do {
+            func();
+            ++iterations;
+        } while (timer.ElapsedSeconds() < minSeconds && iterations < maxIterations);
+        return timer.ElapsedSeconds() / iterations;
+    }
+}
+
+#define DSM_TEST_CONCAT_IMPL(a, b) a##b
+#define DSM_TEST_CONCAT(a, b) DSM_TEST_CONCAT_IMPL(a, b)
+
+#define DSM_REGISTER_TEST(name, isBenchmark) \
+    static void name(); \
+    static DSM::Test::TestRegistrar DSM_TEST_CONCAT(s_Registrar_, name){#name, &name, isBenchmark}; \
+    static void name()
+
+// 默认运行的单元测试
+#define TEST_CASE(name) DSM_REGISTER_TEST(name, false)
+// 只在传入 --bench 时运行的基准测试
+#define BENCHMARK_CASE(name) DSM_REGISTER_TEST(name, true)
+
+// 失败后继续执行
+#define CHECK(expr) \
+    ((bool)(expr) || DSM::Test::ReportFailure(__FILE__, __LINE__, #expr))
+// 失败后结束当前测试
+#define REQUIRE(expr) \
+    do { if (!CHECK(expr)) return; } while (false)
+
+#endif
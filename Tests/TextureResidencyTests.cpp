@@ -0,0 +1,461 @@
+#include "TestFramework.h"
+#include "Renderer/TextureResidency.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DSM;
+
+namespace {
+    // BC7 纹理每级 mip 的字节数，每个 4x4 的块 16 字节
+    std::vector<std::uint64_t> MakeMipSizes(std::uint32_t size)
+    {
+        std::vector<std::uint64_t> mipSizes{};
+        for (; size > 0; size >>= 1) {
+            auto blocks = std::uint64_t((std::max)(size / 4, 1u));
+            mipSizes.push_back(blocks * blocks * 16);
+        }
+        return mipSizes;
+    }
+
+    // 与 TextureManager 相同，边长不超过 64 的 mip 始终驻留
+    std::uint32_t GetPinnedMip(std::uint32_t size)
+    {
+        std::uint32_t pinnedMip = 0;
+        while ((size >> pinnedMip) > 64) ++pinnedMip;
+        return pinnedMip;
+    }
+
+    std::uint64_t SumMips(const std::vector<std::uint64_t>& mipSizes, std::uint32_t first, std::uint32_t last)
+    {
+        std::uint64_t size = 0;
+        for (auto i = first; i < last; ++i) size += mipSizes[i];
+        return size;
+    }
+
+    // 按请求执行加载与释放的模拟器，加载在下一帧开始时完成
+    // 每次 Update 后检查操作是否合法、是否超出预算，并与独立维护的驻留状态比较
+    class ResidencySimulator
+    {
+    public:
+        struct Texture
+        {
+            std::vector<std::uint64_t> m_MipSizes{};
+            std::uint32_t m_PinnedMip = 0;
+            std::uint32_t m_ResidentMip = 0;
+            std::uint32_t m_PendingMip = 0;
+        };
+
+        explicit ResidencySimulator(const TextureResidencyDesc& desc) : m_Residency(desc) {}
+
+        std::uint32_t Add(std::uint32_t size)
+        {
+            auto mipSizes = MakeMipSizes(size);
+            auto pinnedMip = GetPinnedMip(size);
+            auto handle = m_Residency.RegisterTexture(mipSizes, pinnedMip, pinnedMip);
+            if (handle >= m_Textures.size()) m_Textures.resize(handle + 1);
+            m_Textures[handle] = {mipSizes, pinnedMip, pinnedMip, pinnedMip};
+            return handle;
+        }
+
+        std::uint64_t GetUsedBytes() const
+        {
+            std::uint64_t used = 0;
+            for (const auto& texture : m_Textures) {
+                auto numMips = static_cast<std::uint32_t>(texture.m_MipSizes.size());
+                used += SumMips(texture.m_MipSizes, texture.m_PendingMip, numMips);
+            }
+            return used;
+        }
+
+        std::uint64_t GetPinnedBytes() const
+        {
+            std::uint64_t pinned = 0;
+            for (const auto& texture : m_Textures) {
+                pinned += SumMips(texture.m_MipSizes, texture.m_PinnedMip, static_cast<std::uint32_t>(texture.m_MipSizes.size()));
+            }
+            return pinned;
+        }
+
+        // 返回本帧是否一切正常
+        bool Step(std::uint64_t frame)
+        {
+            for (auto& texture : m_Textures) {
+                texture.m_ResidentMip = texture.m_PendingMip;
+            }
+            for (const auto& load : m_InFlight) {
+                m_Residency.CompleteLoad(load.m_Texture, load.m_Mip);
+            }
+            m_InFlight.clear();
+
+            Test::BenchTimer timer{};
+            const auto& requests = m_Residency.Update(frame);
+            m_UpdateSeconds += timer.ElapsedSeconds();
+            m_NumRequests = static_cast<std::uint32_t>(requests.size());
+            m_Evictions.clear();
+            bool seenLoad = false;
+            for (const auto& request : requests) {
+                auto& texture = m_Textures[request.m_Texture];
+                if (request.m_Action == ResidencyAction::kEvict) {
+                    if (seenLoad || request.m_Mip <= texture.m_ResidentMip || request.m_Mip > texture.m_PinnedMip) {
+                        std::printf("  frame %llu: invalid eviction of texture %u to mip %u (resident %u, pinned %u)\n",
+                            (unsigned long long)frame, request.m_Texture, request.m_Mip, texture.m_ResidentMip, texture.m_PinnedMip);
+                        return false;
+                    }
+                    texture.m_ResidentMip = texture.m_PendingMip = request.m_Mip;
+                    m_Evictions.push_back(request.m_Texture);
+                }
+                else {
+                    // 每次只加载下一级
+                    if (request.m_Mip + 1 != texture.m_ResidentMip) {
+                        std::printf("  frame %llu: texture %u loads mip %u while mip %u is resident\n",
+                            (unsigned long long)frame, request.m_Texture, request.m_Mip, texture.m_ResidentMip);
+                        return false;
+                    }
+                    texture.m_PendingMip = request.m_Mip;
+                    m_InFlight.push_back(request);
+                    seenLoad = true;
+                }
+            }
+
+            const auto& stats = m_Residency.GetStats();
+            auto used = GetUsedBytes();
+            if (stats.m_ResidentBytes + stats.m_PendingBytes != used) {
+                std::printf("  frame %llu: stats report %llu bytes but %llu are used\n", (unsigned long long)frame,
+                    (unsigned long long)(stats.m_ResidentBytes + stats.m_PendingBytes), (unsigned long long)used);
+                return false;
+            }
+            // 常驻的 mip 超出预算时无法满足，只要求不再加载
+            auto budget = m_Residency.GetDesc().m_Budget;
+            if (used > (std::max)(budget, GetPinnedBytes())) {
+                std::printf("  frame %llu: %llu bytes used over a budget of %llu\n", (unsigned long long)frame,
+                    (unsigned long long)used, (unsigned long long)budget);
+                return false;
+            }
+            m_PeakUsed = (std::max)(m_PeakUsed, used);
+            for (std::uint32_t i = 0; i < m_Textures.size(); ++i) {
+                if (m_Residency.GetResidentMip(i) != m_Textures[i].m_ResidentMip) {
+                    std::printf("  frame %llu: texture %u is at mip %u but the engine reports %u\n", (unsigned long long)frame,
+                        i, m_Textures[i].m_ResidentMip, m_Residency.GetResidentMip(i));
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 请求 mip 直到没有新的操作，返回经过的帧数
+        std::uint32_t Settle(std::uint64_t& frame, const std::vector<std::pair<std::uint32_t, float>>& requests, float priority = 1)
+        {
+            for (std::uint32_t i = 0; i < 64; ++i) {
+                for (auto [handle, mip] : requests) m_Residency.RequestMip(handle, mip, priority);
+                if (!Step(++frame)) return ~0u;
+                if (m_NumRequests == 0) return i;
+            }
+            return ~0u;
+        }
+
+        TextureResidency m_Residency;
+        std::vector<Texture> m_Textures{};
+        std::vector<ResidencyRequest> m_InFlight{};
+        std::vector<std::uint32_t> m_Evictions{};
+        std::uint32_t m_NumRequests = 0;
+        std::uint64_t m_PeakUsed = 0;
+        double m_UpdateSeconds = 0;
+    };
+}
+
+TEST_CASE(TextureResidency_RegisterAndRequest)
+{
+    TextureResidency residency{};
+    auto mipSizes = MakeMipSizes(1024);
+    REQUIRE(mipSizes.size() == 11);
+    CHECK(residency.RegisterTexture({}, 0, 0) == TextureResidency::sm_InvalidHandle);
+
+    auto a = residency.RegisterTexture(mipSizes, 4, 4);
+    auto b = residency.RegisterTexture(mipSizes, 4, 2);
+    // 常驻的 mip 不超过最粗的一级，初始驻留不粗于常驻
+    auto c = residency.RegisterTexture(mipSizes, 20, 30);
+    CHECK(residency.GetResidentMip(a) == 4);
+    CHECK(residency.GetResidentMip(b) == 2);
+    CHECK(residency.GetResidentMip(c) == 10);
+    CHECK(residency.GetRequestedMip(a) == 4);
+    CHECK(residency.GetStats().m_NumTextures == 3);
+    CHECK(residency.GetStats().m_ResidentBytes == SumMips(mipSizes, 4, 11) + SumMips(mipSizes, 2, 11) + mipSizes[10]);
+
+    // 同一帧的多次请求取最精细的 mip，超出范围的请求被限制
+    residency.RequestMip(a, 2.7f, 1);
+    residency.RequestMip(a, 3.1f, 5);
+    residency.RequestMip(b, -3, 1);
+    residency.RequestMip(c, 100, 1);
+    residency.Update(1);
+    CHECK(residency.GetRequestedMip(a) == 2);
+    CHECK(residency.GetRequestedMip(b) == 0);
+    CHECK(residency.GetRequestedMip(c) == 10);
+
+    residency.UnregisterTexture(b);
+    residency.UnregisterTexture(b);
+    CHECK(residency.GetStats().m_NumTextures == 2);
+    CHECK(residency.RegisterTexture(mipSizes, 4, 4) == b);
+
+    // 1024 的纹理覆盖 256 个像素时需要 mip 2，放大时为 mip 0
+    CHECK(std::abs(TextureResidency::ComputeMipFromFootprint(1024, 512, 256) - 2) < 1e-5f);
+    CHECK(TextureResidency::ComputeMipFromFootprint(1024, 1024, 4096) == 0);
+    CHECK(TextureResidency::ComputeMipFromFootprint(0, 0, 0) == 0);
+}
+
+TEST_CASE(TextureResidency_LoadsOneMipAtATime)
+{
+    TextureResidencyDesc desc{};
+    desc.m_Budget = 64ull << 20;
+    ResidencySimulator sim{desc};
+    auto handle = sim.Add(2048);
+    auto pinnedMip = sim.m_Textures[handle].m_PinnedMip;
+    REQUIRE(pinnedMip == 5);
+
+    std::uint64_t frame = 0;
+    for (std::uint32_t i = 0; i < pinnedMip; ++i) {
+        sim.m_Residency.RequestMip(handle, 0);
+        REQUIRE(sim.Step(++frame));
+        CHECK(sim.m_InFlight.size() == 1);
+        CHECK(sim.m_Residency.IsLoading(handle));
+        CHECK(sim.m_Residency.GetStats().m_PendingBytes == sim.m_Textures[handle].m_MipSizes[pinnedMip - 1 - i]);
+    }
+    // 最后一级加载完成后没有新的操作
+    CHECK(sim.m_Residency.GetResidentMip(handle) == 1);
+    sim.m_Residency.RequestMip(handle, 0);
+    REQUIRE(sim.Step(++frame));
+    CHECK(sim.m_InFlight.empty());
+    CHECK(sim.m_Residency.GetResidentMip(handle) == 0);
+
+    // 加载失败时保持原来的驻留
+    auto other = sim.Add(512);
+    sim.m_Residency.RequestMip(other, 0);
+    const auto& requests = sim.m_Residency.Update(++frame);
+    REQUIRE(requests.size() == 1);
+    auto residentMip = sim.m_Residency.GetResidentMip(other);
+    sim.m_Residency.CompleteLoad(other, residentMip);
+    CHECK(!sim.m_Residency.IsLoading(other));
+    CHECK(sim.m_Residency.GetResidentMip(other) == residentMip);
+    CHECK(sim.m_Residency.GetStats().m_PendingBytes == 0);
+
+    // 每次 Update 的加载量受限，但第一项总会开始
+    desc.m_MaxLoadBytesPerUpdate = 1;
+    ResidencySimulator limited{desc};
+    auto first = limited.Add(1024);
+    auto second = limited.Add(1024);
+    limited.m_Residency.RequestMip(first, 0, 1);
+    limited.m_Residency.RequestMip(second, 0, 3);
+    REQUIRE(limited.Step(1));
+    REQUIRE(limited.m_InFlight.size() == 1);
+    // 优先级高的先加载
+    CHECK(limited.m_InFlight[0].m_Texture == second);
+    CHECK(limited.m_Residency.GetStats().m_NumDeferred == 1);
+}
+
+TEST_CASE(TextureResidency_EvictsLeastRecentlyUsedFirst)
+{
+    // 预算可容纳 3 张完整的纹理与 2 张纹理的常驻 mip
+    auto mipSizes = MakeMipSizes(1024);
+    auto pinnedMip = GetPinnedMip(1024);
+    auto full = SumMips(mipSizes, 0, 11), pinned = SumMips(mipSizes, pinnedMip, 11);
+    TextureResidencyDesc desc{};
+    desc.m_Budget = 3 * full + 2 * pinned + 100;
+    desc.m_UnusedFrames = 5;
+    ResidencySimulator sim{desc};
+    std::uint32_t textures[5]{};
+    for (auto& handle : textures) handle = sim.Add(1024);
+    auto [a, b, c, d, e] = textures;
+
+    // A、B、C 最后一次使用的帧依次递增，之后都不再使用
+    std::uint64_t frame = 0;
+    REQUIRE(sim.Settle(frame, {{a, 0}, {b, 0}, {c, 0}}) != ~0u);
+    sim.m_Residency.RequestMip(b, 0);
+    sim.m_Residency.RequestMip(c, 0);
+    REQUIRE(sim.Step(++frame));
+    sim.m_Residency.RequestMip(c, 0);
+    REQUIRE(sim.Step(++frame));
+    frame += 10;
+    for (auto handle : {a, b, c}) CHECK(sim.m_Residency.GetResidentMip(handle) == 0);
+
+    // D 需要的空间由最久未使用的 A 提供
+    REQUIRE(sim.Settle(frame, {{d, 0}}) != ~0u);
+    CHECK(sim.m_Residency.GetResidentMip(d) == 0);
+    CHECK(sim.m_Residency.GetResidentMip(a) == pinnedMip);
+    CHECK(sim.m_Residency.GetResidentMip(b) == 0);
+    CHECK(sim.m_Residency.GetResidentMip(c) == 0);
+
+    // 接着是 B
+    REQUIRE(sim.Settle(frame, {{d, 0}, {e, 0}}) != ~0u);
+    CHECK(sim.m_Residency.GetResidentMip(e) == 0);
+    CHECK(sim.m_Residency.GetResidentMip(b) == pinnedMip);
+    CHECK(sim.m_Residency.GetResidentMip(c) == 0);
+    CHECK(sim.m_PeakUsed <= desc.m_Budget);
+
+    // 只请求较粗 mip 的纹理即使刚刚使用过也先于仍被需要的纹理释放，且只释放需要的部分
+    REQUIRE(sim.Settle(frame, {{c, 0}, {d, 2}, {e, 0}, {a, 1}}) != ~0u);
+    CHECK(sim.m_Residency.GetResidentMip(a) == 1);
+    CHECK(sim.m_Residency.GetResidentMip(d) == 1);
+    CHECK(sim.m_Residency.GetResidentMip(c) == 0);
+    CHECK(sim.m_Residency.GetResidentMip(e) == 0);
+    CHECK(sim.m_PeakUsed <= desc.m_Budget);
+}
+
+TEST_CASE(TextureResidency_PriorityLoadsWin)
+{
+    auto mipSizes = MakeMipSizes(1024);
+    auto pinnedMip = GetPinnedMip(1024);
+    TextureResidencyDesc desc{};
+    desc.m_Budget = SumMips(mipSizes, 0, 11) + SumMips(mipSizes, pinnedMip, 11) + 100;
+    ResidencySimulator sim{desc};
+    auto a = sim.Add(1024);
+    auto b = sim.Add(1024);
+
+    std::uint64_t frame = 0;
+    REQUIRE(sim.Settle(frame, {{a, 0}}) != ~0u);
+    REQUIRE(sim.m_Residency.GetResidentMip(a) == 0);
+
+    // 仍被需要的纹理不为优先级更低或相同的加载让路
+    for (float priority : {0.5f, 1.0f}) {
+        for (int i = 0; i < 4; ++i) {
+            sim.m_Residency.RequestMip(a, 0, 1);
+            sim.m_Residency.RequestMip(b, 0, priority);
+            REQUIRE(sim.Step(++frame));
+        }
+        CHECK(sim.m_Residency.GetStats().m_NumDeferred == 1);
+        CHECK(sim.m_Residency.GetResidentMip(a) == 0);
+        CHECK(sim.m_Residency.GetResidentMip(b) == pinnedMip);
+    }
+
+    // 优先级更高时释放 A，但不低于它的常驻 mip
+    for (int i = 0; i < 16; ++i) {
+        sim.m_Residency.RequestMip(a, 0, 1);
+        sim.m_Residency.RequestMip(b, 0, 4);
+        REQUIRE(sim.Step(++frame));
+    }
+    CHECK(sim.m_Residency.GetResidentMip(b) == 0);
+    CHECK(sim.m_Residency.GetResidentMip(a) == pinnedMip);
+    // 之后 A 无法再夺回空间
+    CHECK(sim.m_Residency.GetStats().m_NumDeferred == 1);
+    CHECK(sim.m_Residency.GetStats().m_NumEvictions == 0);
+}
+
+TEST_CASE(TextureResidency_FollowsLoweredBudget)
+{
+    TextureResidencyDesc desc{};
+    desc.m_Budget = 256ull << 20;
+    ResidencySimulator sim{desc};
+    std::vector<std::pair<std::uint32_t, float>> requests{};
+    for (std::uint32_t i = 0; i < 40; ++i) {
+        requests.push_back({sim.Add(256u << (i % 4)), 0.0f});
+    }
+    std::uint64_t frame = 0;
+    REQUIRE(sim.Settle(frame, requests) != ~0u);
+    auto used = sim.GetUsedBytes();
+    for (const auto& [handle, mip] : requests) CHECK(sim.m_Residency.GetResidentMip(handle) == 0);
+
+    // 预算降低后下一次 Update 就回到预算之内，仍被需要的纹理也会被释放
+    desc.m_Budget = used / 2;
+    sim.m_Residency.SetDesc(desc);
+    for (const auto& [handle, mip] : requests) sim.m_Residency.RequestMip(handle, mip);
+    REQUIRE(sim.Step(++frame));
+    CHECK(sim.GetUsedBytes() <= desc.m_Budget);
+    CHECK(sim.GetUsedBytes() > desc.m_Budget / 2);
+    CHECK(!sim.m_Evictions.empty());
+    CHECK(sim.m_InFlight.empty());
+
+    // 预算小于常驻的 mip 时全部退回常驻的 mip，不会更低，也不再加载
+    desc.m_Budget = 0;
+    sim.m_Residency.SetDesc(desc);
+    for (int i = 0; i < 4; ++i) {
+        for (const auto& [handle, mip] : requests) sim.m_Residency.RequestMip(handle, mip);
+        REQUIRE(sim.Step(++frame));
+        CHECK(sim.m_InFlight.empty());
+    }
+    CHECK(sim.GetUsedBytes() == sim.GetPinnedBytes());
+    for (std::uint32_t i = 0; i < sim.m_Textures.size(); ++i) {
+        CHECK(sim.m_Residency.GetResidentMip(i) == sim.m_Textures[i].m_PinnedMip);
+    }
+
+    // 预算恢复后重新加载
+    desc.m_Budget = 256ull << 20;
+    sim.m_Residency.SetDesc(desc);
+    REQUIRE(sim.Settle(frame, requests) != ~0u);
+    CHECK(sim.GetUsedBytes() == used);
+}
+
+TEST_CASE(TextureResidency_RandomScenesStayWithinBudget)
+{
+    for (std::uint32_t seed = 0; seed < 4; ++seed) {
+        std::mt19937 rng{seed};
+        TextureResidencyDesc desc{};
+        desc.m_Budget = (16ull + seed * 8) << 20;
+        desc.m_MaxLoadBytesPerUpdate = (1ull + seed) << 20;
+        desc.m_UnusedFrames = 10 + seed * 20;
+        ResidencySimulator sim{desc};
+        std::vector<std::uint32_t> handles{};
+        for (std::uint32_t i = 0; i < 200; ++i) handles.push_back(sim.Add(128u << (rng() % 5)));
+
+        std::uint64_t numLoads = 0, numEvictions = 0;
+        bool valid = true;
+        for (std::uint64_t frame = 1; frame <= 600 && valid; ++frame) {
+            // 相机扫过纹理，可见的部分请求由远近决定的 mip
+            auto first = (frame * 3) % handles.size();
+            for (std::uint32_t i = 0; i < 60; ++i) {
+                auto handle = handles[(first + i) % handles.size()];
+                float mip = float(rng() % 4) + (rng() % 100) * 0.01f;
+                sim.m_Residency.RequestMip(handle, mip, 0.5f + (rng() % 4));
+            }
+            // 偶尔改变预算
+            if (frame % 150 == 0) {
+                desc.m_Budget = (4ull + rng() % 32) << 20;
+                sim.m_Residency.SetDesc(desc);
+            }
+            valid = sim.Step(frame);
+            numLoads += sim.m_Residency.GetStats().m_NumLoads;
+            numEvictions += sim.m_Residency.GetStats().m_NumEvictions;
+        }
+        CHECK(valid);
+        CHECK(numLoads > 100);
+        CHECK(numEvictions > 10);
+    }
+}
+
+BENCHMARK_CASE(TextureResidency_StreamingScene)
+{
+    for (std::uint32_t numTextures : {4000u, 20000u}) {
+        TextureResidencyDesc desc{};
+        desc.m_Budget = 1ull << 30;
+        ResidencySimulator sim{desc};
+        std::mt19937 rng{numTextures};
+        for (std::uint32_t i = 0; i < numTextures; ++i) sim.Add(256u << (rng() % 5));
+
+        // 每帧约 1/8 的纹理可见，屏幕上的大小随相机移动
+        constexpr std::uint64_t kNumFrames = 2000;
+        std::uint64_t numLoads = 0, numEvictions = 0, numDeferred = 0;
+        bool valid = true;
+        for (std::uint64_t frame = 1; frame <= kNumFrames && valid; ++frame) {
+            auto first = (frame * numTextures / 400) % numTextures;
+            for (std::uint32_t i = 0; i < numTextures / 8; ++i) {
+                auto handle = static_cast<std::uint32_t>((first + i * 7) % numTextures);
+                auto size = 1u << (sim.m_Textures[handle].m_MipSizes.size() - 1);
+                float pixels = 2048.0f / (1 + (i + frame) % 64);
+                sim.m_Residency.RequestMip(handle, TextureResidency::ComputeMipFromFootprint(size, size, pixels), 1 + i % 3);
+            }
+            valid = sim.Step(frame);
+            numLoads += sim.m_Residency.GetStats().m_NumLoads;
+            numEvictions += sim.m_Residency.GetStats().m_NumEvictions;
+            numDeferred += sim.m_Residency.GetStats().m_NumDeferred;
+        }
+        CHECK(valid);
+
+        std::printf("  %u textures, %llu frames, %llu MB budget\n", numTextures, (unsigned long long)kNumFrames,
+            (unsigned long long)(desc.m_Budget >> 20));
+        Test::ReportMetric("Update", sim.m_UpdateSeconds / kNumFrames * 1e3, "ms");
+        Test::ReportMetric("Loads per frame", double(numLoads) / kNumFrames, "");
+        Test::ReportMetric("Evictions per frame", double(numEvictions) / kNumFrames, "");
+        Test::ReportMetric("Deferred per frame", double(numDeferred) / kNumFrames, "");
+        Test::ReportMetric("Peak usage", double(sim.m_PeakUsed) / double(1 << 20), "MB");
+    }
+}
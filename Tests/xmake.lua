@@ -0,0 +1,47 @@
+targetName = "EngineTests"
+target(targetName)
+    set_kind("binary")
+    set_targetdir(path.join(binDir, targetName))
+
+    -- 只编译引擎中与 D3D12 无关的源文件，可在任意平台上运行
+    add_includedirs("../LearnMiniEngine")
+    add_files("../LearnMiniEngine/Core/CpuTimer.cpp")
+    add_files("../LearnMiniEngine/Core/MemoryTracker.cpp")
+    add_files("../LearnMiniEngine/Core/Profiler.cpp")
+    add_files("../LearnMiniEngine/Graphics/FrameScheduler.cpp")
+    add_files("../LearnMiniEngine/Graphics/GpuProfiler.cpp")
+    add_files("../LearnMiniEngine/Graphics/RenderGraph/RenderGraphCompiler.cpp")
+    add_files("../LearnMiniEngine/Graphics/ResourceStateTracker.cpp")
+    add_files("../LearnMiniEngine/Utilities/DDSFile.cpp")
+    add_files("../LearnMiniEngine/Utilities/MappedFile.cpp")
+    add_files("../LearnMiniEngine/Renderer/IndirectDrawPacker.cpp")
+    add_files("../LearnMiniEngine/RayTracing/AccelerationStructureManager.cpp")
+    add_files("../LearnMiniEngine/RayTracing/BVH.cpp")
+    add_files("../LearnMiniEngine/RayTracing/BVHTraversal.cpp")
+    add_files("../LearnMiniEngine/RayTracing/ShaderBindingTable.cpp")
+    add_files("../LearnMiniEngine/Renderer/CascadedShadowMap.cpp")
+    add_files("../LearnMiniEngine/Renderer/ClusteredLightCuller.cpp")
+    add_files("../LearnMiniEngine/Renderer/GpuSceneTable.cpp")
+    add_files("../LearnMiniEngine/Renderer/InstanceBatcher.cpp")
+    add_files("../LearnMiniEngine/Renderer/MeshSimplifier.cpp")
+    add_files("../LearnMiniEngine/Renderer/OcclusionCuller.cpp")
+    add_files("../LearnMiniEngine/Renderer/TextureResidency.cpp")
+    add_files("../LearnMiniEngine/Utilities/BCEncoder.cpp")
+    add_files("../LearnMiniEngine/Utilities/MipGenerator.cpp")
+    -- 几何体生成依赖 DirectXMath，只在 Windows 上参与测试
+    if is_plat("windows") then
+        add_files("../Samples/PBR/Geometry.cpp")
+    end
+
+    add_files("**.cpp")
+    add_headerfiles("**.h")
+
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+
+    -- xmake test 运行单元测试，基准测试需传入 --bench
+    add_tests("unit")
+    add_tests("bench", {runargs = "--bench"})
+
+target_end()
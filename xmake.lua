@@ -7,7 +7,9 @@ end
 
 add_rules("mode.debug", "mode.release")
 set_languages("c99", "cxx20")
-set_toolchains("msvc")
+if is_os("windows") then
+    set_toolchains("msvc")
+end
 set_encodings("utf-8")
 set_defaultmode("debug")
 
@@ -17,25 +19,33 @@ else
     binDir = path.join(os.projectdir(), "bin/Release/")
 end 
 
--- 添加系统依赖库
-add_syslinks("d3d12", "dxgi", "d3dcompiler", "dxguid", "user32")
+includes("rules.lua")
 
--- 添加DXC
-add_includedirs("ThridParty/dxc/include")
-if is_arch("x64") then
-    add_linkdirs("ThridParty/dxc/lib")
-elseif is_arch("x86") then
-    add_linkdirs("ThridParty/dxc/lib")
-end
-add_links("dxcompiler")
+if is_os("windows") then
+    -- 添加系统依赖库
+    add_syslinks("d3d12", "dxgi", "d3dcompiler", "dxguid", "user32")
 
-includes("ThridParty/Imgui")
+    -- 添加DXC
+    add_includedirs("ThridParty/dxc/include")
+    if is_arch("x64") then
+        add_linkdirs("ThridParty/dxc/lib")
+    elseif is_arch("x86") then
+        add_linkdirs("ThridParty/dxc/lib")
+    end
+    add_links("dxcompiler")
 
--- 添加需要的依赖包,同时禁用系统包
-add_requires("assimp", {system = false})
-add_packages("assimp")
+    includes("ThridParty/Imgui")
 
-includes("rules.lua")
-includes("LearnMiniEngine")
+    -- 添加需要的依赖包,同时禁用系统包
+    add_requires("assimp", {system = false})
+    add_packages("assimp")
+
+    includes("LearnMiniEngine")
+
+    includes("Samples/**")
+else
+    -- 其他平台只构建与 D3D12 无关的命令行工具和测试
+    includes("Samples/RayTracingReference")
+end
 
-includes("Samples/**")
\ No newline at end of file
+includes("Tests")